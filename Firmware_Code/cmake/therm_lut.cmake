@@ -0,0 +1,25 @@
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# neck_therm_lut(<out_dir> [generator args...])
+#
+# Runs scripts/gen_therm_lut.py at build time and sets THERM_LUT_HEADER to
+# the generated <out_dir>/therm_lut.h. Add that header to the consuming
+# target's sources so it is (re)generated before thermistor.c compiles.
+#
+
+find_package(Python3 REQUIRED COMPONENTS Interpreter)
+
+set(NECK_THERM_LUT_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/../scripts/gen_therm_lut.py)
+
+function(neck_therm_lut out_dir)
+  set(header ${out_dir}/therm_lut.h)
+  add_custom_command(
+    OUTPUT ${header}
+    COMMAND ${CMAKE_COMMAND} -E make_directory ${out_dir}
+    COMMAND ${Python3_EXECUTABLE} ${NECK_THERM_LUT_SCRIPT} --output ${header} ${ARGN}
+    DEPENDS ${NECK_THERM_LUT_SCRIPT}
+    COMMENT "Generating thermistor lookup table"
+    VERBATIM)
+  set(THERM_LUT_HEADER ${header} PARENT_SCOPE)
+endfunction()
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Generate the thermistor lookup table (therm_lut.h) used by src/thermistor.c.
+#
+# The table is indexed by the raw SAADC code: entry i holds the temperature,
+# in centi-degrees C, at code (i << shift). The firmware interpolates
+# linearly between neighbouring entries, so the conversion on the device is
+# one shift, one multiply and no floating point. Entries follow the curve
+# past --t-min-c/--t-max-c (up to the int16 range) so the segments next to
+# the limits stay accurate; the firmware clamps the interpolated result.
+#
+# Divider (as wired on the patch): VREF -- R_fixed -- ADC -- NTC -- GND
+#
+#   r_ntc = r_fixed * v / (vref - v)
+#
+# NTC models:
+#   beta             1/T = 1/T0 + ln(R/R0) / B
+#   steinhart-hart   1/T = A + B ln(R) + C ln(R)^3
+#
+
+import argparse
+import math
+import sys
+
+
+def parse_args():
+    p = argparse.ArgumentParser(description=__doc__)
+    p.add_argument("--output", required=True, help="header to write")
+    p.add_argument("--model", choices=("beta", "steinhart-hart"), default="beta")
+    p.add_argument("--vref-mv", type=float, default=3000.0,
+                   help="divider supply voltage")
+    p.add_argument("--r-fixed", type=float, default=10000.0,
+                   help="fixed divider resistor (ohm)")
+    p.add_argument("--r0", type=float, default=10000.0,
+                   help="NTC resistance at T0 (beta model)")
+    p.add_argument("--t0-c", type=float, default=25.0,
+                   help="NTC reference temperature (beta model)")
+    p.add_argument("--beta", type=float, default=3950.0,
+                   help="NTC beta constant (beta model)")
+    p.add_argument("--sh", type=float, nargs=3, metavar=("A", "B", "C"),
+                   help="Steinhart-Hart coefficients")
+    p.add_argument("--adc-full-scale-mv", type=float, default=3600.0,
+                   help="input voltage at full-scale code (gain 1/6, 0.6 V ref)")
+    p.add_argument("--adc-bits", type=int, default=12)
+    p.add_argument("--shift", type=int, default=4,
+                   help="log2 of ADC codes per table step")
+    p.add_argument("--t-min-c", type=float, default=-40.0)
+    p.add_argument("--t-max-c", type=float, default=125.0)
+    args = p.parse_args()
+
+    if args.model == "steinhart-hart" and args.sh is None:
+        p.error("--model steinhart-hart needs --sh A B C")
+    if not 0 <= args.shift < args.adc_bits:
+        p.error("--shift must be below --adc-bits")
+    return args
+
+
+def temp_c(args, code):
+    """Analytic temperature at an ADC code, clamped like the firmware does."""
+    v = code * args.adc_full_scale_mv / (1 << args.adc_bits)
+    v = min(max(v, 1.0), args.vref_mv - 1.0)
+    r = args.r_fixed * v / (args.vref_mv - v)
+
+    if args.model == "beta":
+        inv_t = 1.0 / (args.t0_c + 273.15) + math.log(r / args.r0) / args.beta
+    else:
+        a, b, c = args.sh
+        ln_r = math.log(r)
+        inv_t = a + b * ln_r + c * ln_r ** 3
+
+    return 1.0 / inv_t - 273.15
+
+
+def main():
+    args = parse_args()
+    n = (1 << (args.adc_bits - args.shift)) + 1
+    table = [min(max(int(round(temp_c(args, i << args.shift) * 100.0)), -32768), 32767)
+             for i in range(n)]
+
+    out = []
+    out.append("/*")
+    out.append(" * Generated by scripts/gen_therm_lut.py, do not edit.")
+    out.append(" *")
+    out.append(" *   " + " ".join(sys.argv[1:]).replace(args.output, "<out>"))
+    out.append(" */")
+    out.append("")
+    out.append("#ifndef THERM_LUT_H_")
+    out.append("#define THERM_LUT_H_")
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append("")
+    if args.model == "beta":
+        out.append("#define THERM_LUT_MODEL_BETA          1")
+        out.append("#define THERM_LUT_R0_OHM              %.6g" % args.r0)
+        out.append("#define THERM_LUT_T0_K                %.6g" % (args.t0_c + 273.15))
+        out.append("#define THERM_LUT_BETA                %.6g" % args.beta)
+    else:
+        out.append("#define THERM_LUT_MODEL_STEINHART_HART 1")
+        out.append("#define THERM_LUT_SH_A                %.9e" % args.sh[0])
+        out.append("#define THERM_LUT_SH_B                %.9e" % args.sh[1])
+        out.append("#define THERM_LUT_SH_C                %.9e" % args.sh[2])
+    out.append("#define THERM_LUT_VREF_MV             %.6g" % args.vref_mv)
+    out.append("#define THERM_LUT_R_FIXED_OHM         %.6g" % args.r_fixed)
+    out.append("#define THERM_LUT_ADC_FULL_SCALE_MV   %.6g" % args.adc_full_scale_mv)
+    out.append("#define THERM_LUT_ADC_BITS            %d" % args.adc_bits)
+    out.append("#define THERM_LUT_SHIFT               %d" % args.shift)
+    out.append("#define THERM_LUT_LEN                 %d" % n)
+    out.append("#define THERM_LUT_CDEG_MIN            %d" % round(args.t_min_c * 100))
+    out.append("#define THERM_LUT_CDEG_MAX            %d" % round(args.t_max_c * 100))
+    out.append("")
+    out.append("static const int16_t therm_lut_cdeg[THERM_LUT_LEN] = {")
+    for i in range(0, n, 8):
+        row = ", ".join("%6d" % t for t in table[i:i + 8])
+        out.append("    " + row + ",")
+    out.append("};")
+    out.append("")
+    out.append("#endif /* THERM_LUT_H_ */")
+    out.append("")
+
+    with open(args.output, "w", encoding="ascii") as f:
+        f.write("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
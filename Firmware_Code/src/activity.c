@@ -0,0 +1,386 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "activity.h"
+
+#if defined(CONFIG_NECK_ACTIVITY_CMSIS_DSP)
+#include <arm_math.h>
+#endif
+
+#define SLOT_US         (1000000u / ACTIVITY_HZ)
+#define GAP_US          (ACTIVITY_GAP_MS * 1000u)
+#define HALF            (ACTIVITY_WINDOW / 2)
+
+/* Band edges in FFT bins of ACTIVITY_HZ / ACTIVITY_WINDOW (0.39 Hz) */
+#define LOW_FIRST       2
+#define MID_FIRST       8
+#define HIGH_FIRST      21
+
+#define TWO_PI          6.2831853f
+
+#include "activity_tree.h"
+
+/* Shared by every instance, filled by the first activity_init() */
+static float hann[ACTIVITY_WINDOW];
+static bool tables_ready;
+
+/* ===== Kernels ===== */
+#if defined(CONFIG_NECK_ACTIVITY_CMSIS_DSP)
+static arm_rfft_fast_instance_f32 rfft;
+
+static void tables_init(void)
+{
+    arm_rfft_fast_init_f32(&rfft, ACTIVITY_WINDOW);
+}
+
+static float k_sum(const float *x, size_t n)
+{
+    float mean;
+
+    arm_mean_f32(x, n, &mean);
+    return mean * (float)n;
+}
+
+static float k_power(const float *x, size_t n)
+{
+    float p;
+
+    arm_power_f32(x, n, &p);
+    return p;
+}
+
+static void k_sub(const float *a, const float *b, float *out, size_t n)
+{
+    arm_sub_f32(a, b, out, n);
+}
+
+static void k_offset(float *x, float c, size_t n)
+{
+    arm_offset_f32(x, c, x, n);
+}
+
+static void k_mult(float *x, const float *w, size_t n)
+{
+    arm_mult_f32(x, w, x, n);
+}
+
+static void k_mag_sq(const float *c, float *out, size_t n)
+{
+    arm_cmplx_mag_squared_f32(c, out, n);
+}
+
+void activity_rfft(float *in, float *out)
+{
+    arm_rfft_fast_f32(&rfft, in, out, 0);
+}
+#else
+/* exp(-2 pi i k / N), k < N/2 */
+static float twiddle[HALF][2];
+
+static void tables_init(void)
+{
+    for (int k = 0; k < HALF; k++) {
+        twiddle[k][0] = cosf(TWO_PI * k / ACTIVITY_WINDOW);
+        twiddle[k][1] = -sinf(TWO_PI * k / ACTIVITY_WINDOW);
+    }
+}
+
+static float k_sum(const float *x, size_t n)
+{
+    float s = 0.0f;
+
+    for (size_t i = 0; i < n; i++) {
+        s += x[i];
+    }
+    return s;
+}
+
+static float k_power(const float *x, size_t n)
+{
+    float p = 0.0f;
+
+    for (size_t i = 0; i < n; i++) {
+        p += x[i] * x[i];
+    }
+    return p;
+}
+
+static void k_sub(const float *a, const float *b, float *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+static void k_offset(float *x, float c, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        x[i] += c;
+    }
+}
+
+static void k_mult(float *x, const float *w, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        x[i] *= w[i];
+    }
+}
+
+static void k_mag_sq(const float *c, float *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        out[i] = c[2 * i] * c[2 * i] + c[2 * i + 1] * c[2 * i + 1];
+    }
+}
+
+/* In-place radix-2 FFT of n interleaved complex points, n dividing N/2 */
+static void cfft(float *z, int n)
+{
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            float r = z[2 * i], im = z[2 * i + 1];
+
+            z[2 * i] = z[2 * j];
+            z[2 * i + 1] = z[2 * j + 1];
+            z[2 * j] = r;
+            z[2 * j + 1] = im;
+        }
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        int step = ACTIVITY_WINDOW / len;
+
+        for (int i = 0; i < n; i += len) {
+            for (int k = 0; k < len / 2; k++) {
+                const float *w = twiddle[k * step];
+                float *u = &z[2 * (i + k)], *v = &z[2 * (i + k + len / 2)];
+                float vr = v[0] * w[0] - v[1] * w[1];
+                float vi = v[0] * w[1] + v[1] * w[0];
+
+                v[0] = u[0] - vr;
+                v[1] = u[1] - vi;
+                u[0] += vr;
+                u[1] += vi;
+            }
+        }
+    }
+}
+
+/* The N real points as N/2 complex ones, one complex FFT, then the split
+ * into the spectrum of the real sequence
+ */
+void activity_rfft(float *in, float *out)
+{
+    cfft(in, HALF);
+    out[0] = in[0] + in[1];
+    out[1] = in[0] - in[1];
+    for (int k = 1; k < HALF; k++) {
+        float ar = in[2 * k], ai = in[2 * k + 1];
+        float br = in[2 * (HALF - k)], bi = -in[2 * (HALF - k) + 1];
+        float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+        float tr = 0.5f * (ai - bi), ti = -0.5f * (ar - br);
+        const float *w = twiddle[k];
+
+        out[2 * k] = er + tr * w[0] - ti * w[1];
+        out[2 * k + 1] = ei + tr * w[1] + ti * w[0];
+    }
+}
+#endif
+
+/* ===== Decision ===== */
+enum activity_class activity_tree_eval(const struct activity_node *tree, const float *feat)
+{
+    const struct activity_node *nd = tree;
+
+    while (nd->feature >= 0) {
+        nd = &tree[feat[nd->feature] <= nd->threshold ? nd->left : nd->right];
+    }
+    return (enum activity_class)nd->leaf;
+}
+
+static void decide(struct activity *a)
+{
+    const float n = ACTIVITY_WINDOW;
+    float sum = 0.0f, sum_sq = 0.0f, jerk_sq = 0.0f, pitch_sq = 0.0f;
+
+    for (int b = 0; b < ACTIVITY_BLOCKS; b++) {
+        sum += a->blk[b].sum;
+        sum_sq += a->blk[b].sum_sq;
+        jerk_sq += a->blk[b].jerk_sq;
+        pitch_sq += a->blk[b].pitch_sq;
+    }
+
+    float mean = sum / n;
+    float var = sum_sq / n - mean * mean;
+
+    a->feat[ACT_F_ACC_VAR] = (var > 0.0f ? var : 0.0f) * 1e6f;
+    a->feat[ACT_F_JERK] = jerk_sq / n * (float)(ACTIVITY_HZ * ACTIVITY_HZ);
+    a->feat[ACT_F_PITCH_MS] = pitch_sq / n;
+
+    /* Window oldest first (pos is the oldest block's start), without its
+     * mean, tapered
+     */
+    memcpy(a->buf, &a->mag[a->pos], (ACTIVITY_WINDOW - a->pos) * sizeof(float));
+    memcpy(&a->buf[ACTIVITY_WINDOW - a->pos], a->mag, a->pos * sizeof(float));
+    k_offset(a->buf, -mean, ACTIVITY_WINDOW);
+    k_mult(a->buf, hann, ACTIVITY_WINDOW);
+    activity_rfft(a->buf, a->spec);
+
+    /* Power of bins 1..N/2-1 into buf[1..] */
+    k_mag_sq(&a->spec[2], &a->buf[1], HALF - 1);
+
+    float low = k_sum(&a->buf[LOW_FIRST], MID_FIRST - LOW_FIRST);
+    float mid = k_sum(&a->buf[MID_FIRST], HIGH_FIRST - MID_FIRST);
+    float high = k_sum(&a->buf[HIGH_FIRST], HALF - HIGH_FIRST);
+    float total = low + mid + high;
+
+    if (total > 0.0f) {
+        a->feat[ACT_F_LOW] = low / total;
+        a->feat[ACT_F_MID] = mid / total;
+        a->feat[ACT_F_HIGH] = high / total;
+    } else {
+        a->feat[ACT_F_LOW] = a->feat[ACT_F_MID] = a->feat[ACT_F_HIGH] = 0.0f;
+    }
+
+    enum activity_class c = activity_tree_eval(activity_tree, a->feat);
+
+    if (c == a->raw) {
+        a->cls = c;
+    }
+    a->raw = c;
+    a->decisions++;
+    a->per_class[a->cls]++;
+}
+
+/* ===== Blocks ===== */
+static void block_done(struct activity *a)
+{
+    int b = (a->pos ? a->pos : ACTIVITY_WINDOW) / ACTIVITY_BLOCK - 1;
+    const float *x = &a->mag[b * ACTIVITY_BLOCK];
+    struct activity_block *blk = &a->blk[b];
+    float *d = a->buf;
+
+    blk->sum = k_sum(x, ACTIVITY_BLOCK);
+    blk->sum_sq = k_power(x, ACTIVITY_BLOCK);
+
+    /* Differences, the first against the block before */
+    d[0] = a->fresh ? 0.0f : x[0] - a->mag_before;
+    k_sub(&x[1], x, &d[1], ACTIVITY_BLOCK - 1);
+    blk->jerk_sq = k_power(d, ACTIVITY_BLOCK);
+    blk->pitch_sq = k_power(a->pitch, ACTIVITY_BLOCK);
+    a->mag_before = x[ACTIVITY_BLOCK - 1];
+    a->fresh = false;
+
+    if (a->blocks < ACTIVITY_BLOCKS) {
+        a->blocks++;
+    }
+    if (a->blocks == ACTIVITY_BLOCKS) {
+        decide(a);
+    }
+}
+
+/* ===== Grid ===== */
+static void slot_close(struct activity *a)
+{
+    if (a->slot_n) {
+        float gx = a->acc_sum[0], gy = a->acc_sum[1], gz = a->acc_sum[2];
+
+        a->last_mag = sqrtf(gx * gx + gy * gy + gz * gz) /
+                      ((float)a->slot_n * IMU_ACC_LSB_PER_G) - 1.0f;
+        a->last_pitch = a->pitch_sum / ((float)a->slot_n * IMU_GYR_LSB_PER_DPS);
+    }
+    a->mag[a->pos] = a->last_mag;
+    a->pitch[a->pos % ACTIVITY_BLOCK] = a->last_pitch;
+    a->pos = (a->pos + 1) % ACTIVITY_WINDOW;
+    if (a->pos % ACTIVITY_BLOCK == 0) {
+        block_done(a);
+    }
+
+    memset(a->acc_sum, 0, sizeof(a->acc_sum));
+    a->pitch_sum = 0.0f;
+    a->slot_n = 0;
+    a->slot_us += SLOT_US;
+}
+
+static void restart(struct activity *a, uint32_t t_us)
+{
+    a->slot_us = t_us;
+    memset(a->acc_sum, 0, sizeof(a->acc_sum));
+    a->pitch_sum = 0.0f;
+    a->slot_n = 0;
+    a->pos = 0;
+    a->blocks = 0;
+    a->fresh = true;
+    a->started = true;
+}
+
+void activity_init(struct activity *a)
+{
+    if (!tables_ready) {
+        for (int i = 0; i < ACTIVITY_WINDOW; i++) {
+            hann[i] = 0.5f - 0.5f * cosf(TWO_PI * i / ACTIVITY_WINDOW);
+        }
+        tables_init();
+        tables_ready = true;
+    }
+    memset(a, 0, sizeof(*a));
+    a->raw = ACTIVITY_STILL;
+    a->cls = ACTIVITY_STILL;
+}
+
+void activity_update(struct activity *a, const struct imu_sample *s, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        /* Timestamps wrap; one out of order counts into the open slot */
+        int32_t d = (int32_t)(s[i].t_us - a->slot_us);
+
+        if (!a->started || d >= (int32_t)GAP_US) {
+            restart(a, s[i].t_us);
+        } else {
+            while (d >= (int32_t)SLOT_US) {
+                slot_close(a);
+                d -= SLOT_US;
+            }
+        }
+        for (int ax = 0; ax < 3; ax++) {
+            a->acc_sum[ax] += s[i].acc[ax];
+        }
+        a->pitch_sum += s[i].gyr[1];
+        a->slot_n++;
+    }
+}
+
+const char *activity_class_name(enum activity_class c)
+{
+    static const char *const names[ACTIVITY_COUNT] = {
+        [ACTIVITY_STILL] = "still",
+        [ACTIVITY_WALKING] = "walking",
+        [ACTIVITY_NODDING] = "nodding",
+        [ACTIVITY_VEHICLE] = "vehicle",
+    };
+
+    return (unsigned)c < ACTIVITY_COUNT ? names[c] : "?";
+}
+
+const char *activity_feature_name(enum activity_feature f)
+{
+    static const char *const names[ACT_F_COUNT] = {
+        [ACT_F_ACC_VAR] = "acc_var",
+        [ACT_F_JERK] = "jerk",
+        [ACT_F_PITCH_MS] = "pitch_ms",
+        [ACT_F_LOW] = "low",
+        [ACT_F_MID] = "mid",
+        [ACT_F_HIGH] = "high",
+    };
+
+    return (unsigned)f < ACT_F_COUNT ? names[f] : "?";
+}
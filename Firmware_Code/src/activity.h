@@ -0,0 +1,142 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ACTIVITY_H_
+#define ACTIVITY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "imu_sample.h"
+
+/* ===== Activity classifier =====
+ *
+ * Pure computation, no Zephyr dependencies; ctrl_logic.c feeds it every
+ * calibrated sample and holds the posture engine while the wearer is not
+ * still, so a forward head while walking, nodding or riding a bus is not
+ * taken for a slouch. tools/activity_check trains and checks it on
+ * labelled synthetic traces.
+ *
+ * The samples, at whatever rate the IMU runs (imu_odr.h), are averaged
+ * into a fixed ACTIVITY_HZ grid on their timestamps; a grid slot without a
+ * sample repeats the one before. Two signals per slot: the accel magnitude
+ * minus 1 g and the pitch rate (gyro y).
+ *
+ * One decision per block of ACTIVITY_BLOCK grid samples (0.64 s) over the
+ * last ACTIVITY_WINDOW (2.56 s). Each block's sums are taken once, when it
+ * completes, so variance, jerk and pitch rate power of the window are four
+ * block entries added up rather than a pass over the window:
+ *
+ *   ACT_F_ACC_VAR   variance of the magnitude (mg^2)
+ *   ACT_F_JERK      mean square rate of change of the magnitude ((g/s)^2)
+ *   ACT_F_PITCH_MS  mean square pitch rate (dps^2)
+ *   ACT_F_LOW/MID/HIGH  share of the magnitude's power in 0.8-2.7 Hz,
+ *                   3.1-7.8 Hz and 8.2-24.6 Hz (Hann window, real FFT of
+ *                   the window)
+ *
+ * A decision tree over the features (activity_tree.h, generated by
+ * activity_check --train) names the class, taken once two decisions in a
+ * row agree. The block and FFT kernels are CMSIS-DSP with
+ * CONFIG_NECK_ACTIVITY_CMSIS_DSP, plain C otherwise (host builds).
+ *
+ * A gap of ACTIVITY_GAP_MS in the samples restarts the windows; the class
+ * stays until the next decision.
+ */
+
+#define ACTIVITY_HZ         50
+#define ACTIVITY_BLOCK      32
+#define ACTIVITY_BLOCKS     4
+#define ACTIVITY_WINDOW     (ACTIVITY_BLOCK * ACTIVITY_BLOCKS)
+#define ACTIVITY_GAP_MS     500
+
+enum activity_class {
+    ACTIVITY_STILL,         /* sitting or standing, head turns included */
+    ACTIVITY_WALKING,
+    ACTIVITY_NODDING,
+    ACTIVITY_VEHICLE,       /* riding: vibration, braking, sway */
+    ACTIVITY_COUNT,
+};
+
+enum activity_feature {
+    ACT_F_ACC_VAR,
+    ACT_F_JERK,
+    ACT_F_PITCH_MS,
+    ACT_F_LOW,
+    ACT_F_MID,
+    ACT_F_HIGH,
+    ACT_F_COUNT,
+};
+
+/* Tree node: feature <= threshold goes left. A leaf has feature -1. */
+struct activity_node {
+    int8_t feature;
+    uint8_t leaf;               /* enum activity_class */
+    uint8_t left, right;        /* node indices */
+    float threshold;
+};
+
+/* Sums over one block of grid samples */
+struct activity_block {
+    float sum;                  /* magnitude */
+    float sum_sq;
+    float jerk_sq;              /* per-slot differences */
+    float pitch_sq;
+};
+
+struct activity {
+    /* Grid slot being filled */
+    uint32_t slot_us;
+    float acc_sum[3];
+    float pitch_sum;
+    uint16_t slot_n;
+    bool started;
+
+    /* Magnitude of the last window, block aligned; pitch rate of the block
+     * being filled
+     */
+    float mag[ACTIVITY_WINDOW];
+    float pitch[ACTIVITY_BLOCK];
+    uint16_t pos;               /* next grid sample in mag */
+    uint16_t blocks;            /* complete blocks, up to ACTIVITY_BLOCKS */
+    float last_mag, last_pitch; /* repeated into empty slots */
+    float mag_before;           /* last magnitude before the block */
+    bool fresh;                 /* no magnitude before the block */
+    struct activity_block blk[ACTIVITY_BLOCKS];
+
+    float feat[ACT_F_COUNT];
+    enum activity_class raw;    /* last decision */
+    enum activity_class cls;    /* two decisions in a row */
+    uint32_t decisions;
+    uint32_t per_class[ACTIVITY_COUNT];
+
+    /* FFT input and spectrum */
+    float buf[ACTIVITY_WINDOW];
+    float spec[ACTIVITY_WINDOW];
+};
+
+void activity_init(struct activity *a);
+
+/* n calibrated samples, oldest first */
+void activity_update(struct activity *a, const struct imu_sample *s, size_t n);
+
+/* Whether the posture cues are held */
+static inline bool activity_moving(const struct activity *a)
+{
+    return a->cls != ACTIVITY_STILL;
+}
+
+enum activity_class activity_tree_eval(const struct activity_node *tree, const float *feat);
+
+const char *activity_class_name(enum activity_class c);
+
+const char *activity_feature_name(enum activity_feature f);
+
+/* Real FFT of ACTIVITY_WINDOW points in CMSIS-DSP's packed layout: out[0]
+ * bin 0, out[1] bin N/2, then re, im of bins 1..N/2-1. Scrambles in[].
+ * Exposed for activity_check's kernel check.
+ */
+void activity_rfft(float *in, float *out);
+
+#endif /* ACTIVITY_H_ */
@@ -0,0 +1,22 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Generated by tools/activity_check --train; included by activity.c only.
+ * 14091 labelled windows of 8 synthetic subjects at 100 Hz.
+ */
+
+static const struct activity_node activity_tree[] = {
+    { ACT_F_JERK, 0, 1, 8, 0.416109f },
+    { ACT_F_HIGH, 0, 2, 7, 0.297598f },
+    { ACT_F_HIGH, 0, 3, 4, 0.103868f },
+    { -1, ACTIVITY_NODDING, 0, 0, 0.0f },
+    { ACT_F_PITCH_MS, 0, 5, 6, 855.0f },
+    { -1, ACTIVITY_STILL, 0, 0, 0.0f },
+    { -1, ACTIVITY_NODDING, 0, 0, 0.0f },
+    { -1, ACTIVITY_STILL, 0, 0, 0.0f },
+    { ACT_F_ACC_VAR, 0, 9, 10, 2601.92f },
+    { -1, ACTIVITY_VEHICLE, 0, 0, 0.0f },
+    { ACT_F_PITCH_MS, 0, 11, 12, 336.57f },
+    { -1, ACTIVITY_WALKING, 0, 0, 0.0f },
+    { -1, ACTIVITY_NODDING, 0, 0, 0.0f },
+};
@@ -0,0 +1,211 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/pwm.h>
+#include <zephyr/logging/log.h>
+#include <errno.h>
+
+#include "actuators.h"
+
+LOG_MODULE_REGISTER(actuators, LOG_LEVEL_INF);
+
+#define USER_NODE   DT_PATH(zephyr_user)
+
+/* ===== Build-time overlay checks =====
+ * Every PWM channel driven through a pwm-leds node gets one enumerator named
+ * after its controller and channel. Two nodes on the same channel (e.g. the
+ * old pwm_led1/pwm_led2 both on pwm0 channel 1) fail the build with a
+ * "redeclaration of enumerator 'pwm_slot_<ctlr_ord>_ch<ch>'" error.
+ */
+#define PWM_SLOT(child) \
+    UTIL_CAT(UTIL_CAT(UTIL_CAT(pwm_slot_, DT_DEP_ORD(DT_PWMS_CTLR(child))), _ch), \
+             DT_PWMS_CHANNEL(child)),
+#define PWM_SLOTS(node) DT_FOREACH_CHILD(node, PWM_SLOT)
+
+enum pwm_channel_claims {
+    DT_FOREACH_STATUS_OKAY(pwm_leds, PWM_SLOTS)
+    PWM_CHANNEL_CLAIMS_END
+};
+
+BUILD_ASSERT(DT_NODE_HAS_PROP(USER_NODE, peltiers), "zephyr,user needs a peltiers list");
+BUILD_ASSERT(DT_NODE_HAS_PROP(USER_NODE, cue_leds), "zephyr,user needs a cue-leds list");
+
+/* ===== Channel tables ===== */
+#define PWM_SPEC_ELEM(node, prop, idx) PWM_DT_SPEC_GET(DT_PHANDLE_BY_IDX(node, prop, idx))
+#define GPIO_SPEC_ELEM(node, prop, idx) GPIO_DT_SPEC_GET(DT_PHANDLE_BY_IDX(node, prop, idx), gpios)
+
+static const struct pwm_dt_spec peltier_specs[] = {
+    DT_FOREACH_PROP_ELEM_SEP(USER_NODE, peltiers, PWM_SPEC_ELEM, (,))
+};
+static const struct gpio_dt_spec led_specs[] = {
+    DT_FOREACH_PROP_ELEM_SEP(USER_NODE, cue_leds, GPIO_SPEC_ELEM, (,))
+};
+
+static struct act_channel_stats peltier_state[ARRAY_SIZE(peltier_specs)];
+static struct act_channel_stats led_state[ARRAY_SIZE(led_specs)];
+
+struct act_group_desc {
+    const char *name;
+    const struct pwm_dt_spec *pwm;      /* NULL for GPIO groups */
+    const struct gpio_dt_spec *gpio;
+    struct act_channel_stats *state;
+    size_t count;
+};
+
+static const struct act_group_desc groups[ACT_GROUP_COUNT] = {
+    [ACT_PELTIER] = { "peltier", peltier_specs, NULL, peltier_state, ARRAY_SIZE(peltier_specs) },
+    [ACT_LED] = { "led", NULL, led_specs, led_state, ARRAY_SIZE(led_specs) },
+};
+
+/* Serialises a group's owner thread against the thermal supervisor */
+static struct k_mutex group_lock[ACT_GROUP_COUNT];
+static atomic_t inhibited;              /* BIT(group) */
+
+/* ===== Hardware write ===== */
+static int write_channel(const struct act_group_desc *g, size_t idx, uint16_t duty)
+{
+    struct act_channel_stats *st = &g->state[idx];
+    uint32_t c0 = k_cycle_get_32();
+    int err;
+
+    if (g->pwm) {
+        const struct pwm_dt_spec *spec = &g->pwm[idx];
+
+        err = pwm_set_dt(spec, spec->period, (uint32_t)((uint64_t)spec->period * duty / ACT_DUTY_FULL));
+    } else {
+        err = gpio_pin_set_dt(&g->gpio[idx], duty != ACT_DUTY_OFF);
+    }
+
+    st->last_write_us = k_cyc_to_us_floor32(k_cycle_get_32() - c0);
+    if (st->last_write_us > st->max_write_us) {
+        st->max_write_us = st->last_write_us;
+    }
+    if (err < 0) {
+        /* Cached duty stays stale, so the next set retries the write */
+        st->faults++;
+        st->last_err = err;
+        return err;
+    }
+    st->writes++;
+    st->duty_permille = duty;
+    return 0;
+}
+
+/* ===== Public API ===== */
+int actuators_set_channel(enum act_group g, size_t idx, uint16_t duty_permille)
+{
+    const struct act_group_desc *d = &groups[g];
+    int rc = 0;
+
+    if (idx >= d->count) {
+        return -EINVAL;
+    }
+    duty_permille = MIN(duty_permille, ACT_DUTY_FULL);
+
+    k_mutex_lock(&group_lock[g], K_FOREVER);
+    if (atomic_test_bit(&inhibited, g)) {
+        duty_permille = ACT_DUTY_OFF;
+    }
+    /* Fault-free channels at the requested duty need no bus/register access */
+    if (d->state[idx].duty_permille == duty_permille && d->state[idx].writes > 0) {
+        d->state[idx].skipped++;
+    } else {
+        rc = write_channel(d, idx, duty_permille);
+    }
+    k_mutex_unlock(&group_lock[g]);
+    return rc;
+}
+
+int actuators_inhibit(enum act_group g, bool on)
+{
+    const struct act_group_desc *d = &groups[g];
+    int rc = 0;
+
+    k_mutex_lock(&group_lock[g], K_FOREVER);
+    if (!on) {
+        atomic_clear_bit(&inhibited, g);
+        k_mutex_unlock(&group_lock[g]);
+        return 0;
+    }
+    atomic_set_bit(&inhibited, g);
+    for (size_t i = 0; i < d->count; i++) {
+        /* A failed write left the cached duty as it was: retried here */
+        if (d->state[i].duty_permille != ACT_DUTY_OFF || d->state[i].writes == 0) {
+            int err = write_channel(d, i, ACT_DUTY_OFF);
+
+            if (err < 0 && rc == 0) {
+                rc = err;
+            }
+        }
+    }
+    k_mutex_unlock(&group_lock[g]);
+    return rc;
+}
+
+bool actuators_inhibited(enum act_group g)
+{
+    return atomic_test_bit(&inhibited, g);
+}
+
+int actuators_set(enum act_group g, uint16_t duty_permille)
+{
+    int rc = 0;
+
+    for (size_t i = 0; i < groups[g].count; i++) {
+        int err = actuators_set_channel(g, i, duty_permille);
+
+        if (err < 0 && rc == 0) {
+            rc = err;
+        }
+    }
+    return rc;
+}
+
+size_t actuators_count(enum act_group g)
+{
+    return groups[g].count;
+}
+
+int actuators_stats_get(enum act_group g, size_t idx, struct act_channel_stats *out)
+{
+    if (idx >= groups[g].count) {
+        return -EINVAL;
+    }
+    *out = groups[g].state[idx];
+    return 0;
+}
+
+int actuators_init(void)
+{
+    for (int g = 0; g < ACT_GROUP_COUNT; g++) {
+        const struct act_group_desc *d = &groups[g];
+
+        k_mutex_init(&group_lock[g]);
+        for (size_t i = 0; i < d->count; i++) {
+            bool ready = d->pwm ? pwm_is_ready_dt(&d->pwm[i]) : gpio_is_ready_dt(&d->gpio[i]);
+
+            if (!ready) {
+                LOG_ERR("%s%d device not ready", d->name, (int)i + 1);
+                return -ENODEV;
+            }
+            if (!d->pwm) {
+                int err = gpio_pin_configure_dt(&d->gpio[i], GPIO_OUTPUT_INACTIVE);
+
+                if (err < 0) {
+                    LOG_ERR("%s%d configure failed (%d)", d->name, (int)i + 1, err);
+                    return err;
+                }
+            }
+            /* Start from a known off state with one real write */
+            write_channel(d, i, ACT_DUTY_OFF);
+        }
+        LOG_INF("%d %s channel(s)", (int)d->count, d->name);
+    }
+    return 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ACTUATORS_H_
+#define ACTUATORS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ===== Actuator layer =====
+ *
+ * Every output channel comes from the devicetree: the zephyr,user node
+ * lists the members of each group as phandles (see app.overlay),
+ *
+ *   peltiers = <&pwm_led0 &pwm_led2>;    pwm-leds children
+ *   cue-leds = <&led1 &led2>;            gpio-leds children
+ *
+ * The specs are resolved once at build time. A write only reaches the
+ * driver when the commanded duty of that channel changes, and every
+ * channel keeps its own duty, write/fault counters and write latency.
+ *
+ * Each group must only be commanded from one thread (Peltiers: the thermal
+ * work queue, LEDs: the control thread). The one exception is the thermal
+ * supervisor's actuators_inhibit(); a per-group mutex orders it against the
+ * owner's writes. The LRAs are not here: they play sequences on PWM1
+ * through haptic.h.
+ */
+
+enum act_group {
+    ACT_PELTIER,
+    ACT_LED,
+    ACT_GROUP_COUNT,
+};
+
+#define ACT_DUTY_OFF    0
+#define ACT_DUTY_FULL   1000    /* duties are in permille */
+
+struct act_channel_stats {
+    uint16_t duty_permille;     /* last duty successfully written */
+    uint32_t writes;            /* driver calls that succeeded */
+    uint32_t skipped;           /* set calls that needed no write */
+    uint32_t faults;            /* driver calls that failed */
+    int last_err;
+    uint32_t last_write_us;     /* time spent in the driver call */
+    uint32_t max_write_us;
+};
+
+/* Check every device is ready and drive all channels off */
+int actuators_init(void);
+
+size_t actuators_count(enum act_group g);
+
+/* Same duty on every channel of a group. GPIO channels are on for any
+ * non-zero duty. Returns the first driver error, 0 otherwise.
+ */
+int actuators_set(enum act_group g, uint16_t duty_permille);
+
+int actuators_set_channel(enum act_group g, size_t idx, uint16_t duty_permille);
+
+/* Safety interlock: on, every channel of the group is written off at once
+ * and later sets write zero whatever they ask for, until it is released.
+ * Returns the first driver error of the off writes.
+ */
+int actuators_inhibit(enum act_group g, bool on);
+
+bool actuators_inhibited(enum act_group g);
+
+int actuators_stats_get(enum act_group g, size_t idx, struct act_channel_stats *out);
+
+#endif /* ACTUATORS_H_ */
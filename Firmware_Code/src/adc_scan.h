@@ -0,0 +1,37 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ADC_SCAN_H_
+#define ADC_SCAN_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== Continuous ADC scan backend =====
+ *
+ * Timer-triggered scans of both ADC channels into a pair of DMA buffers.
+ * src/hw/adc_scan_saadc.c drives the nRF SAADC through nrfx (EasyDMA double
+ * buffering, burst oversampling, TIMER -> SAMPLE over (D)PPI, no CPU per
+ * sample); src/emul/adc_scan_emul.c models it in software for native_sim.
+ */
+
+#define ADC_SCAN_CHANNELS   2
+
+/* Called once per filled buffer of CONFIG_NECK_ADC_SCANS_PER_BUFFER scans,
+ * interleaved as ch0, ch1, ch0, ch1, ... The buffer has already been swapped
+ * out and stays valid until the callback returns. May run in ISR context.
+ */
+typedef void (*adc_scan_done_cb_t)(const int16_t *buf, uint16_t scans);
+
+/* Start scanning both channels rate_hz times per second, each result the
+ * average of 2^oversample_log2 conversions
+ */
+int adc_scan_start(uint32_t rate_hz, uint8_t oversample_log2, adc_scan_done_cb_t cb);
+
+/* Stop (or resume) the scan trigger; a partly filled buffer is kept and
+ * completes after resuming
+ */
+void adc_scan_pause(bool paused);
+
+#endif /* ADC_SCAN_H_ */
@@ -0,0 +1,90 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log.h>
+#include <errno.h>
+
+#include "adc_stream.h"
+#include "adc_scan.h"
+#include "prof.h"
+
+LOG_MODULE_REGISTER(adc_stream, LOG_LEVEL_INF);
+
+BUILD_ASSERT(ADC_CH_COUNT == ADC_SCAN_CHANNELS, "scan layout does not match channels");
+
+#define NO_VALUE    INT32_MIN
+
+/* ===== Global Variables =====
+ * One atomic per channel: the producer is the scan-done callback (ISR),
+ * readers only ever load, so no lock is needed on either side.
+ */
+static atomic_t latest[ADC_CH_COUNT] = { ATOMIC_INIT(NO_VALUE), ATOMIC_INIT(NO_VALUE) };
+static atomic_t buffers;
+static atomic_t scans_total;
+
+/* Runs once per DMA buffer: average the scans in it per channel. Together
+ * with the SAADC oversampling this gives
+ * 2^CONFIG_NECK_ADC_OVERSAMPLE_LOG2 * CONFIG_NECK_ADC_SCANS_PER_BUFFER
+ * conversions behind every published value.
+ */
+static void scan_done(const int16_t *buf, uint16_t scans)
+{
+    int32_t sum[ADC_CH_COUNT] = { 0 };
+
+    if (scans == 0) {
+        return;
+    }
+
+    PROF_START(PROF_ADC_AVG);
+    for (uint16_t s = 0; s < scans; s++) {
+        for (int ch = 0; ch < ADC_CH_COUNT; ch++) {
+            sum[ch] += buf[s * ADC_CH_COUNT + ch];
+        }
+    }
+    for (int ch = 0; ch < ADC_CH_COUNT; ch++) {
+        atomic_set(&latest[ch], (sum[ch] + scans / 2) / scans);
+    }
+    atomic_inc(&buffers);
+    atomic_add(&scans_total, scans);
+    PROF_STOP(PROF_ADC_AVG);
+}
+
+int adc_stream_init(void)
+{
+    int rc = adc_scan_start(CONFIG_NECK_ADC_SCAN_RATE_HZ, CONFIG_NECK_ADC_OVERSAMPLE_LOG2,
+                            scan_done);
+    if (rc) {
+        LOG_ERR("ADC scan start failed (%d)", rc);
+        return rc;
+    }
+
+    LOG_INF("ADC: %d scans/s, %dx oversampling, %d scans per buffer",
+            CONFIG_NECK_ADC_SCAN_RATE_HZ, 1 << CONFIG_NECK_ADC_OVERSAMPLE_LOG2,
+            CONFIG_NECK_ADC_SCANS_PER_BUFFER);
+    return 0;
+}
+
+int adc_stream_latest(enum adc_stream_ch ch, int16_t *code)
+{
+    atomic_val_t v = atomic_get(&latest[ch]);
+
+    if (v == NO_VALUE) {
+        return -EAGAIN;
+    }
+    *code = (int16_t)v;
+    return 0;
+}
+
+void adc_stream_stats_get(struct adc_stream_stats *out)
+{
+    out->buffers = atomic_get(&buffers);
+    out->scans = atomic_get(&scans_total);
+}
+
+void adc_stream_pause(bool paused)
+{
+    adc_scan_pause(paused);
+}
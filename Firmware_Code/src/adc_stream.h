@@ -0,0 +1,46 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ADC_STREAM_H_
+#define ADC_STREAM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== Filtered ADC readings =====
+ *
+ * Both SAADC channels are sampled continuously in the background
+ * (adc_scan.h); every finished buffer is averaged and published. Readers
+ * get the latest value without touching the ADC or waiting on it.
+ */
+
+enum adc_stream_ch {
+    ADC_CH_THERM,   /* AIN0 / P0.04: thermistor divider */
+    ADC_CH_AUX,     /* AIN4 / P0.05: Peltier current sense or battery divider */
+    ADC_CH_COUNT,
+};
+
+struct adc_stream_stats {
+    uint32_t buffers;       /* buffers averaged and published */
+    uint32_t scans;         /* scans (one result per channel) consumed */
+};
+
+/* Start background sampling */
+int adc_stream_init(void);
+
+/* Latest averaged raw code of a channel; -EAGAIN until the first buffer */
+int adc_stream_latest(enum adc_stream_ch ch, int16_t *code);
+
+void adc_stream_stats_get(struct adc_stream_stats *out);
+
+/* Pause background sampling (IMU low power); the latest values are kept */
+void adc_stream_pause(bool paused);
+
+/* Raw 12-bit code -> mV at the pin (gain 1/6, 0.6 V internal reference) */
+static inline int adc_stream_code_to_mv(int32_t code)
+{
+    return (int)((code * CONFIG_NECK_ADC_FULL_SCALE_MV) >> 12);
+}
+
+#endif /* ADC_STREAM_H_ */
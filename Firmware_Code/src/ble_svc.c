@@ -0,0 +1,739 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ble_svc.h"
+
+#if defined(CONFIG_NECK_BLE)
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/bluetooth/uuid.h>
+
+#include "cmd_proto.h"
+#include "control.h"
+#include "haptic.h"
+#include "journal.h"
+#include "peltier_ctrl.h"
+#include "prof.h"
+#endif
+
+LOG_MODULE_REGISTER(ble_svc, LOG_LEVEL_INF);
+
+#if defined(CONFIG_NECK_BLE)
+
+/* ===== Link parameters per mode =====
+ * Units of 1.25 ms for the interval, 10 ms for the supervision timeout.
+ * The timeout must exceed (1 + latency) * interval_max * 2.
+ */
+struct link_params {
+    uint16_t interval_min;
+    uint16_t interval_max;
+    uint16_t latency;
+    uint16_t timeout;
+};
+
+static const struct link_params link_params[BLE_LINK_MODE_COUNT] = {
+    [BLE_LINK_STREAM] = { 12, 24, 0, 400 },        /* 15-30 ms */
+    [BLE_LINK_IDLE] = { 80, 120, 4, 600 },         /* 100-150 ms, skip 4 */
+    [BLE_LINK_SLEEP] = { 320, 400, 4, 600 },       /* 400-500 ms, skip 4 */
+};
+
+#define STREAM_CAP      CONFIG_NECK_BLE_STREAM_BATCH_MAX
+#define PROTO_FRAME_MAX (CONFIG_BT_L2CAP_TX_MTU - 3)
+
+struct proto_frame {
+    uint16_t len;
+    uint8_t buf[PROTO_FRAME_MAX];
+};
+
+/* ===== Global Variables ===== */
+static struct bt_conn *cur_conn;
+static struct ble_svc_stats stats = { .mtu = 23, .mode = BLE_LINK_IDLE };
+static struct k_spinlock lock;
+static bool low_power;
+static bool stream_on;
+static bool posture_on;
+
+static struct ble_posture_wire posture_val;
+static bool posture_dirty;
+
+static struct telem_wire stream_buf[STREAM_CAP];
+static size_t stream_n;
+
+static struct cmdp_rx proto_rx;
+static bool proto_on;
+K_MSGQ_DEFINE(proto_q, sizeof(struct proto_frame), CONFIG_NECK_BLE_PROTO_RX_FRAMES, 4);
+
+static bool journal_on;
+static bool syncing;
+
+static void posture_work_fn(struct k_work *work);
+static void stream_work_fn(struct k_work *work);
+static void link_work_fn(struct k_work *work);
+static void adv_work_fn(struct k_work *work);
+static void proto_work_fn(struct k_work *work);
+static K_WORK_DEFINE(posture_work, posture_work_fn);
+static K_WORK_DELAYABLE_DEFINE(stream_work, stream_work_fn);
+static K_WORK_DEFINE(link_work, link_work_fn);
+static K_WORK_DEFINE(adv_work, adv_work_fn);
+static K_WORK_DEFINE(proto_work, proto_work_fn);
+
+static const struct bt_data ad[] = {
+    BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
+    BT_DATA_BYTES(BT_DATA_UUID16_ALL, BT_UUID_16_ENCODE(BLE_UUID_SVC)),
+};
+
+static const struct bt_data sd[] = {
+    BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME, sizeof(CONFIG_BT_DEVICE_NAME) - 1),
+};
+
+/* ===== Characteristics ===== */
+static ssize_t cmd_write(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                         const void *buf, uint16_t len, uint16_t offset, uint8_t flags)
+{
+    const uint8_t *c = buf;
+
+    if (offset != 0 || len != 1) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+    }
+    switch (c[0]) {
+    case BLE_CMD_LED_ON:
+        control_led_force(true);
+        break;
+    case BLE_CMD_LED_OFF:
+        control_led_force(false);
+        break;
+    case BLE_CMD_LED_TOGGLE:
+        control_led_force(!control_led_forced());
+        break;
+    default:
+        return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+    }
+    return len;
+}
+
+static ssize_t posture_read(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                            void *buf, uint16_t len, uint16_t offset)
+{
+    struct ble_posture_wire v;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    v = posture_val;
+    k_spin_unlock(&lock, key);
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, &v, sizeof(v));
+}
+
+static ssize_t params_read(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                           void *buf, uint16_t len, uint16_t offset)
+{
+    struct posture_params pp;
+    struct ble_params_wire w;
+
+    control_posture_params_get(&pp);
+    w.version = BLE_PARAMS_VERSION;
+    w.enter_cdeg = (uint16_t)(pp.enter_deg * 100.0f + 0.5f);
+    w.exit_cdeg = (uint16_t)(pp.exit_deg * 100.0f + 0.5f);
+    w.enter_dwell_ms = (uint16_t)MIN(pp.enter_dwell_ms, UINT16_MAX);
+    w.exit_dwell_ms = (uint16_t)MIN(pp.exit_dwell_ms, UINT16_MAX);
+    w.alert_s = (uint16_t)MIN(pp.alert_ms / 1000, UINT16_MAX);
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, &w, sizeof(w));
+}
+
+/* Shared by the params characteristic and the command protocol */
+static int posture_params_apply(const struct cmdp_posture *w)
+{
+    struct posture_params pp;
+    int err;
+
+    control_posture_params_get(&pp);
+    pp.enter_deg = w->enter_cdeg / 100.0f;
+    pp.exit_deg = w->exit_cdeg / 100.0f;
+    pp.enter_dwell_ms = w->enter_dwell_ms;
+    pp.exit_dwell_ms = w->exit_dwell_ms;
+    pp.alert_ms = (uint32_t)w->alert_s * 1000;
+    err = control_posture_params_set(&pp);
+    if (err == 0) {
+        LOG_INF("Posture params: enter %u exit %u cdeg, dwell %u/%u ms, alert %u s",
+                w->enter_cdeg, w->exit_cdeg, w->enter_dwell_ms, w->exit_dwell_ms, w->alert_s);
+    }
+    return err;
+}
+
+static ssize_t params_write(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                            const void *buf, uint16_t len, uint16_t offset, uint8_t flags)
+{
+    struct ble_params_wire w;
+
+    if (offset != 0 || len != sizeof(w)) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+    }
+    memcpy(&w, buf, sizeof(w));
+    if (w.version != BLE_PARAMS_VERSION) {
+        return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+    }
+
+    const struct cmdp_posture pw = {
+        .enter_cdeg = w.enter_cdeg,
+        .exit_cdeg = w.exit_cdeg,
+        .enter_dwell_ms = w.enter_dwell_ms,
+        .exit_dwell_ms = w.exit_dwell_ms,
+        .alert_s = w.alert_s,
+    };
+
+    if (posture_params_apply(&pw) < 0) {
+        return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+    }
+    return len;
+}
+
+/* Frames are only queued here, in the Bluetooth RX thread; commands are
+ * applied and acknowledged from the system work queue
+ */
+static ssize_t proto_write(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                           const void *buf, uint16_t len, uint16_t offset, uint8_t flags)
+{
+    static struct proto_frame f;
+
+    if (offset != 0 || len > sizeof(f.buf)) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+    }
+    f.len = len;
+    memcpy(f.buf, buf, len);
+    if (k_msgq_put(&proto_q, &f, K_NO_WAIT)) {
+        /* The next frame shows a sequence gap and the gateway resends */
+        stats.cmd_drops++;
+        return len;
+    }
+    k_work_submit(&proto_work);
+    return len;
+}
+
+/* The journal thread does the transfer; see journal_send() */
+static ssize_t journal_write(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                             const void *buf, uint16_t len, uint16_t offset, uint8_t flags);
+
+/* Long read: the client continues with offsets until it has every probe */
+static ssize_t prof_read(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                         void *buf, uint16_t len, uint16_t offset)
+{
+#if defined(CONFIG_NECK_PROF)
+    struct ble_prof_wire w[PROF_COUNT];
+
+    for (int p = 0; p < PROF_COUNT; p++) {
+        struct prof_summary s;
+
+        prof_summary_get(p, &s);
+        w[p] = (struct ble_prof_wire){
+            .probe = (uint8_t)p,
+            .count = s.count,
+            .min_ns = s.min_ns,
+            .p50_ns = s.p50_ns,
+            .p99_ns = s.p99_ns,
+            .max_ns = s.max_ns,
+        };
+    }
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, w, sizeof(w));
+#else
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, NULL, 0);
+#endif
+}
+
+static void link_mode_update(void);
+
+static void posture_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value)
+{
+    posture_on = (value == BT_GATT_CCC_NOTIFY);
+}
+
+static void stream_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value)
+{
+    stream_on = (value == BT_GATT_CCC_NOTIFY);
+    link_mode_update();
+}
+
+static void proto_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value)
+{
+    proto_on = (value == BT_GATT_CCC_NOTIFY);
+}
+
+static void journal_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value)
+{
+    journal_on = (value == BT_GATT_CCC_NOTIFY);
+}
+
+BT_GATT_SERVICE_DEFINE(neck_svc,
+    BT_GATT_PRIMARY_SERVICE(BT_UUID_DECLARE_16(BLE_UUID_SVC)),
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_16(BLE_UUID_CMD),
+                           BT_GATT_CHRC_WRITE | BT_GATT_CHRC_WRITE_WITHOUT_RESP,
+                           BT_GATT_PERM_WRITE, NULL, cmd_write, NULL),
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_16(BLE_UUID_POSTURE),
+                           BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+                           BT_GATT_PERM_READ, posture_read, NULL, NULL),
+    BT_GATT_CCC(posture_ccc_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_16(BLE_UUID_STREAM), BT_GATT_CHRC_NOTIFY,
+                           BT_GATT_PERM_NONE, NULL, NULL, NULL),
+    BT_GATT_CCC(stream_ccc_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_16(BLE_UUID_PARAMS),
+                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,
+                           BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,
+                           params_read, params_write, NULL),
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_16(BLE_UUID_PROF), BT_GATT_CHRC_READ,
+                           BT_GATT_PERM_READ, prof_read, NULL, NULL),
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_16(BLE_UUID_PROTO),
+                           BT_GATT_CHRC_WRITE_WITHOUT_RESP | BT_GATT_CHRC_NOTIFY,
+                           BT_GATT_PERM_WRITE, NULL, proto_write, NULL),
+    BT_GATT_CCC(proto_ccc_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_16(BLE_UUID_JOURNAL),
+                           BT_GATT_CHRC_WRITE | BT_GATT_CHRC_WRITE_WITHOUT_RESP |
+                           BT_GATT_CHRC_NOTIFY,
+                           BT_GATT_PERM_WRITE, NULL, journal_write, NULL),
+    BT_GATT_CCC(journal_ccc_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+);
+
+/* Value attributes: declaration + 1 */
+#define ATTR_POSTURE    (&neck_svc.attrs[4])
+#define ATTR_STREAM     (&neck_svc.attrs[7])
+#define ATTR_PROTO      (&neck_svc.attrs[14])
+#define ATTR_JOURNAL    (&neck_svc.attrs[17])
+
+/* ===== Notifications (system work queue) =====
+ * From the system work queue the ATT layer does not wait for buffers, so a
+ * busy link costs dropped records rather than a stalled queue.
+ */
+
+/* A reference to the connection if the peer subscribed, else NULL; taken
+ * under the lock, so disconnected() cannot free it before bt_conn_unref()
+ */
+static struct bt_conn *conn_get(bool subscribed)
+{
+    struct bt_conn *conn = NULL;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    if (cur_conn && subscribed) {
+        conn = bt_conn_ref(cur_conn);
+    }
+    k_spin_unlock(&lock, key);
+    return conn;
+}
+
+static void posture_work_fn(struct k_work *work)
+{
+    struct ble_posture_wire v;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    v = posture_val;
+    posture_dirty = false;
+    k_spin_unlock(&lock, key);
+
+    struct bt_conn *conn = conn_get(posture_on);
+
+    if (conn) {
+        bt_gatt_notify(conn, ATTR_POSTURE, &v, sizeof(v));
+        bt_conn_unref(conn);
+    }
+}
+
+static void stream_work_fn(struct k_work *work)
+{
+    static struct telem_wire out[STREAM_CAP];
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    size_t n = stream_n;
+
+    memcpy(out, stream_buf, n * sizeof(out[0]));
+    stream_n = 0;
+    k_spin_unlock(&lock, key);
+
+    struct bt_conn *conn = n ? conn_get(true) : NULL;
+
+    if (!conn) {
+        return;
+    }
+
+    /* Records pile up to STREAM_CAP before this runs: one ATT MTU each */
+    size_t batch = MIN(ble_stream_batch(stats.mtu), STREAM_CAP);
+
+    for (size_t i = 0; i < n; i += batch) {
+        size_t m = MIN(batch, n - i);
+
+        if (batch == 0 || bt_gatt_notify(conn, ATTR_STREAM, &out[i], m * sizeof(out[0]))) {
+            /* A busy link will not take the rest either */
+            stats.drops += n - i;
+            break;
+        }
+        stats.notifications++;
+        stats.records += m;
+    }
+    bt_conn_unref(conn);
+}
+
+/* ===== Command protocol (system work queue) ===== */
+static int proto_apply(uint8_t type, const uint8_t *val, uint8_t len, void *ctx)
+{
+    struct cmdp_posture pw;
+
+    ARG_UNUSED(len);
+    ARG_UNUSED(ctx);
+
+    switch (type) {
+    case CMDP_T_LED:
+        switch (val[0]) {
+        case CMDP_LED_RELEASE:
+            control_led_force(false);
+            return 0;
+        case CMDP_LED_ON:
+            control_led_force(true);
+            return 0;
+        case CMDP_LED_TOGGLE:
+            control_led_force(!control_led_forced());
+            return 0;
+        default:
+            return -EINVAL;
+        }
+    case CMDP_T_POSTURE:
+        cmdp_posture_decode(&pw, val);
+        return posture_params_apply(&pw);
+    case CMDP_T_HAPTIC_PLAY:
+        return haptic_play((enum haptic_pattern)val[0], val[1] != 0);
+    case CMDP_T_HAPTIC_STOP:
+        haptic_stop();
+        return 0;
+    case CMDP_T_HAPTIC_CUE:
+        return haptic_cue_select((enum haptic_pattern)val[0]);
+    case CMDP_T_SETPOINT:
+        return peltier_ctrl_setpoint_set((int16_t)cmdp_get_u16(val));
+    default:
+        return -ENOTSUP;
+    }
+}
+
+/* Everything queued since the last run is acknowledged in one notification */
+static void proto_work_fn(struct k_work *work)
+{
+    static struct proto_frame f;
+    uint8_t ack[32];
+    size_t n;
+
+    while (k_msgq_get(&proto_q, &f, K_NO_WAIT) == 0) {
+        cmdp_rx_frame(&proto_rx, f.buf, f.len, proto_apply, NULL);
+    }
+    stats.cmds = proto_rx.applied;
+    stats.cmd_gaps = proto_rx.gaps;
+
+    n = cmdp_rx_ack(&proto_rx, ack, MIN(sizeof(ack), (size_t)stats.mtu - 3));
+
+    struct bt_conn *conn = n ? conn_get(proto_on) : NULL;
+
+    if (conn) {
+        bt_gatt_notify(conn, ATTR_PROTO, ack, n);
+        bt_conn_unref(conn);
+    }
+}
+
+/* ===== Journal sync (journal thread) =====
+ * Unlike the work queue, the journal thread may wait for TX buffers: a
+ * sync is bulk data and should go as fast as the link takes it. It runs on
+ * the stream parameters until its END chunk, or until a notification fails.
+ */
+static int journal_send(const void *buf, size_t len)
+{
+    struct jrnl_chunk c;
+    struct bt_conn *conn = conn_get(journal_on);
+    int err = -ENOTCONN;
+
+    if (conn) {
+        err = bt_gatt_notify(conn, ATTR_JOURNAL, buf, len);
+        bt_conn_unref(conn);
+    }
+    memcpy(&c, buf, sizeof(c));
+    if (err || c.len == JRNL_LEN_END) {
+        syncing = false;
+        link_mode_update();
+    }
+    return err;
+}
+
+static ssize_t journal_write(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                             const void *buf, uint16_t len, uint16_t offset, uint8_t flags)
+{
+    struct jrnl_req r;
+    int err;
+
+    if (offset != 0 || len != sizeof(r)) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+    }
+    memcpy(&r, buf, sizeof(r));
+
+    switch (r.op) {
+    case JRNL_OP_SYNC:
+        if (!journal_on) {
+            return BT_GATT_ERR(BT_ATT_ERR_CCC_IMPROPER_CONF);
+        }
+        syncing = true;
+        link_mode_update();
+        err = journal_sync(r.seq, r.off, r.epoch_ms, (size_t)stats.mtu - 3, journal_send);
+        if (err) {
+            syncing = false;
+            link_mode_update();
+        }
+        break;
+    case JRNL_OP_ACK:
+        err = journal_ack(r.seq);
+        break;
+    default:
+        return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+    }
+    return err ? BT_GATT_ERR(BT_ATT_ERR_INSUFFICIENT_RESOURCES) : len;
+}
+
+/* ===== Link management ===== */
+static void link_work_fn(struct k_work *work)
+{
+    const struct link_params *lp = &link_params[stats.mode];
+    struct bt_le_conn_param param = {
+        .interval_min = lp->interval_min,
+        .interval_max = lp->interval_max,
+        .latency = lp->latency,
+        .timeout = lp->timeout,
+    };
+
+    struct bt_conn *conn = conn_get(true);
+
+    if (!conn) {
+        return;
+    }
+    int err = bt_conn_le_param_update(conn, &param);
+
+    bt_conn_unref(conn);
+    if (err && err != -EALREADY) {
+        LOG_WRN("Connection parameter update failed (%d)", err);
+    }
+}
+
+static void link_mode_update(void)
+{
+    uint8_t mode = low_power ? BLE_LINK_SLEEP
+                 : (stream_on || syncing) ? BLE_LINK_STREAM : BLE_LINK_IDLE;
+
+    if (mode != stats.mode) {
+        stats.mode = mode;
+        k_work_submit(&link_work);
+    }
+}
+
+static void mtu_exchanged(struct bt_conn *conn, uint8_t err,
+                          struct bt_gatt_exchange_params *params)
+{
+    stats.mtu = bt_gatt_get_mtu(conn);
+    LOG_INF("ATT MTU %u: %u telemetry records per notification", stats.mtu,
+            (unsigned int)MIN(ble_stream_batch(stats.mtu), STREAM_CAP));
+}
+
+static struct bt_gatt_exchange_params mtu_params = { .func = mtu_exchanged };
+
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+    if (err) {
+        LOG_WRN("Connection failed (0x%02x)", err);
+        k_work_submit(&adv_work);
+        return;
+    }
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    cur_conn = bt_conn_ref(conn);
+    k_spin_unlock(&lock, key);
+    stats.mtu = bt_gatt_get_mtu(conn);
+    LOG_INF("Connected");
+
+    /* The gateway numbers its commands from 0 again */
+    k_msgq_purge(&proto_q);
+    cmdp_rx_init(&proto_rx);
+
+    /* Fewer, fuller radio events: 2M PHY, 251-byte PDUs, one ATT MTU per
+     * notification. Each request is optional for the central.
+     */
+    if (bt_conn_le_phy_update(conn, BT_CONN_LE_PHY_PARAM_2M)) {
+        LOG_WRN("PHY update request failed");
+    }
+    if (bt_conn_le_data_len_update(conn, BT_LE_DATA_LEN_PARAM_MAX)) {
+        LOG_WRN("Data length update request failed");
+    }
+    if (bt_gatt_exchange_mtu(conn, &mtu_params)) {
+        LOG_WRN("MTU exchange request failed");
+    }
+    k_work_submit(&link_work);
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    struct bt_conn *old;
+
+    LOG_INF("Disconnected (0x%02x)", reason);
+
+    /* Notifiers take their own reference under the lock (conn_get()) */
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    old = cur_conn;
+    cur_conn = NULL;
+    k_spin_unlock(&lock, key);
+    if (old) {
+        bt_conn_unref(old);
+    }
+    stream_on = false;
+    posture_on = false;
+    proto_on = false;
+    journal_on = false;
+    syncing = false;
+    stats.mtu = 23;
+}
+
+static void recycled(void)
+{
+    k_work_submit(&adv_work);
+}
+
+static void phy_updated(struct bt_conn *conn, struct bt_conn_le_phy_info *info)
+{
+    stats.tx_phy = info->tx_phy;
+}
+
+static void data_len_updated(struct bt_conn *conn, struct bt_conn_le_data_len_info *info)
+{
+    stats.tx_octets = info->tx_max_len;
+}
+
+BT_CONN_CB_DEFINE(conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+    .recycled = recycled,
+    .le_phy_updated = phy_updated,
+    .le_data_len_updated = data_len_updated,
+};
+
+static void adv_work_fn(struct k_work *work)
+{
+    int err = bt_le_adv_start(BT_LE_ADV_PARAM(BT_LE_ADV_OPT_CONNECTABLE,
+                                              BT_GAP_ADV_SLOW_INT_MIN, BT_GAP_ADV_SLOW_INT_MAX,
+                                              NULL),
+                              ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
+
+    if (err && err != -EALREADY) {
+        LOG_ERR("Advertising failed to start (%d)", err);
+    }
+}
+
+#endif /* CONFIG_NECK_BLE */
+
+/* ===== Public API ===== */
+int ble_svc_init(void)
+{
+#if defined(CONFIG_NECK_BLE)
+    int err = bt_enable(NULL);
+
+    if (err) {
+        LOG_ERR("Bluetooth init failed (%d)", err);
+        return err;
+    }
+    k_work_submit(&adv_work);
+    LOG_INF("Advertising as \"%s\"", CONFIG_BT_DEVICE_NAME);
+#endif
+    return 0;
+}
+
+void ble_svc_posture_update(const struct ble_posture_wire *p)
+{
+#if defined(CONFIG_NECK_BLE)
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    /* Pitch alone only notifies once it moved far enough; state, event and
+     * flag changes always do
+     */
+    bool changed = p->state != posture_val.state || p->event != posture_val.event ||
+                   p->flags != posture_val.flags ||
+                   abs(p->pitch_cdeg - posture_val.pitch_cdeg) >= CONFIG_NECK_BLE_POSTURE_DELTA_CDEG;
+
+    if (changed) {
+        posture_val = *p;
+    }
+    bool notify = changed && !posture_dirty && posture_on;
+
+    posture_dirty |= notify;
+    k_spin_unlock(&lock, key);
+
+    if (notify) {
+        k_work_submit(&posture_work);
+    }
+#else
+    ARG_UNUSED(p);
+#endif
+}
+
+void ble_svc_stream_push(const struct telem_wire *w)
+{
+#if defined(CONFIG_NECK_BLE)
+    size_t batch = MIN(ble_stream_batch(stats.mtu), STREAM_CAP);
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    if (!cur_conn || !stream_on) {
+        k_spin_unlock(&lock, key);
+        return;
+    }
+    if (batch == 0 || stream_n >= STREAM_CAP) {
+        stats.drops++;
+        k_spin_unlock(&lock, key);
+        return;
+    }
+    stream_buf[stream_n++] = *w;
+
+    size_t n = stream_n;
+
+    k_spin_unlock(&lock, key);
+
+    if (n >= batch) {
+        k_work_reschedule(&stream_work, K_NO_WAIT);
+    } else if (n == 1) {
+        /* Bounds the age of a partly filled batch */
+        k_work_schedule(&stream_work, K_MSEC(CONFIG_NECK_BLE_STREAM_FLUSH_MS));
+    }
+#else
+    ARG_UNUSED(w);
+#endif
+}
+
+void ble_svc_set_low_power(bool lp)
+{
+#if defined(CONFIG_NECK_BLE)
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    /* The control thread stops with the IMU, so flag the value as stale */
+    if (lp) {
+        posture_val.flags |= BLE_POSTURE_F_IMU_LP;
+    } else {
+        posture_val.flags &= ~BLE_POSTURE_F_IMU_LP;
+    }
+    k_spin_unlock(&lock, key);
+
+    if (posture_on) {
+        k_work_submit(&posture_work);
+    }
+    low_power = lp;
+    link_mode_update();
+#else
+    ARG_UNUSED(lp);
+#endif
+}
+
+void ble_svc_stats_get(struct ble_svc_stats *out)
+{
+#if defined(CONFIG_NECK_BLE)
+    *out = stats;
+#else
+    memset(out, 0, sizeof(*out));
+#endif
+}
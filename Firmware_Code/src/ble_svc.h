@@ -0,0 +1,66 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BLE_SVC_H_
+#define BLE_SVC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble_wire.h"
+
+/* ===== Posture GATT service =====
+ *
+ * Peripheral side of the layout in ble_wire.h. Connectable advertising
+ * with the 0xFFFF service UUID; on connect it asks for the 2M PHY, the
+ * largest data length and ATT MTU, and then keeps the connection
+ * parameters matched to what is going on:
+ *
+ *   stream   telemetry notifications enabled, or a journal sync running
+ *            (journal.h): short interval, no latency
+ *   idle     posture notifications only: long interval, peripheral latency
+ *   sleep    IMU in low power: longer still
+ *
+ * The update calls never notify from the caller's thread: values are
+ * latched and sent from the system work queue, so the control thread never
+ * waits on the radio. Compiled to no-ops without CONFIG_NECK_BLE.
+ */
+
+enum ble_link_mode {
+    BLE_LINK_STREAM,
+    BLE_LINK_IDLE,
+    BLE_LINK_SLEEP,
+    BLE_LINK_MODE_COUNT,
+};
+
+struct ble_svc_stats {
+    uint16_t mtu;
+    uint8_t tx_phy;             /* BT_GAP_LE_PHY_* */
+    uint16_t tx_octets;         /* negotiated LL payload */
+    uint8_t mode;               /* enum ble_link_mode */
+    uint32_t notifications;     /* stream notifications sent */
+    uint32_t records;           /* telemetry records sent */
+    uint32_t drops;             /* records not sent (no room, MTU too small) */
+    uint32_t cmds;              /* protocol commands applied */
+    uint32_t cmd_gaps;          /* protocol frames cut short by a sequence gap */
+    uint32_t cmd_drops;         /* protocol frames dropped, queue full */
+};
+
+int ble_svc_init(void);
+
+/* New posture value; notified if a client subscribed and it changed */
+void ble_svc_posture_update(const struct ble_posture_wire *p);
+
+/* Queue one sealed telemetry record for the stream characteristic; sent in
+ * batches of as many records as the MTU allows, or after
+ * CONFIG_NECK_BLE_STREAM_FLUSH_MS
+ */
+void ble_svc_stream_push(const struct telem_wire *w);
+
+/* IMU power mode changed; moves the link to/from the sleep parameters */
+void ble_svc_set_low_power(bool low_power);
+
+void ble_svc_stats_get(struct ble_svc_stats *out);
+
+#endif /* BLE_SVC_H_ */
@@ -0,0 +1,245 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "calib.h"
+
+/* Fewer samples than this in a window (a gap, a rate change) say nothing */
+#define WINDOW_MIN_SAMPLES  10
+
+/* Largest tilt of the vertical axis in a 6-position capture: cos(20 deg) */
+#define POS_COS_MIN         0.94f
+
+/* Accepted calibration results */
+#define ACC_OFF_MAX_MG      150.0f
+#define ACC_GAIN_MIN        0.9f
+#define ACC_GAIN_MAX        1.1f
+#define GYR_BIAS_MAX_DPS    10.0f
+
+#define COUNTS_PER_MG       (IMU_ACC_LSB_PER_G / 1000.0f)
+
+static int16_t sat16(float v)
+{
+    v += v >= 0.0f ? 0.5f : -0.5f;
+    return v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : (int16_t)v);
+}
+
+void calib_init(struct calib *c, const struct calib_params *params)
+{
+    memset(c, 0, sizeof(*c));
+    c->p = *params;
+    for (int ax = 0; ax < 3; ax++) {
+        c->acc_gain[ax] = 1.0f;
+    }
+}
+
+void calib_accel_start(struct calib *c)
+{
+    c->accel_state = CALIB_ACCEL_RUNNING;
+    c->accel_mask = 0;
+}
+
+/* ===== 6-position accel calibration ===== */
+static void accel_finish(struct calib *c)
+{
+    float off[3], gain[3];
+
+    for (int ax = 0; ax < 3; ax++) {
+        float up = c->accel_pos[2 * ax];
+        float down = c->accel_pos[2 * ax + 1];
+
+        off[ax] = (up + down) / 2.0f;
+        gain[ax] = 2.0f * IMU_ACC_LSB_PER_G / (up - down);
+        if (fabsf(off[ax]) > ACC_OFF_MAX_MG * COUNTS_PER_MG ||
+            !(gain[ax] >= ACC_GAIN_MIN && gain[ax] <= ACC_GAIN_MAX)) {
+            c->accel_state = CALIB_ACCEL_FAILED;
+            return;
+        }
+    }
+    memcpy(c->acc_off, off, sizeof(off));
+    memcpy(c->acc_gain, gain, sizeof(gain));
+    c->flags |= CALIB_F_ACCEL;
+    c->accel_state = CALIB_ACCEL_DONE;
+}
+
+/* A still window's mean accel; true when it completed the calibration */
+static bool accel_capture(struct calib *c, const float acc[3])
+{
+    float norm = sqrtf(acc[0] * acc[0] + acc[1] * acc[1] + acc[2] * acc[2]);
+    int ax = 0;
+
+    for (int i = 1; i < 3; i++) {
+        if (fabsf(acc[i]) > fabsf(acc[ax])) {
+            ax = i;
+        }
+    }
+    if (fabsf(acc[ax]) < POS_COS_MIN * norm) {
+        return false;
+    }
+
+    int pos = 2 * ax + (acc[ax] < 0.0f);
+
+    if (c->accel_mask & (1u << pos)) {
+        return false;
+    }
+    c->accel_pos[pos] = acc[ax];
+    c->accel_mask |= 1u << pos;
+    if (c->accel_mask != (1u << CALIB_POSITIONS) - 1) {
+        return false;
+    }
+    accel_finish(c);
+    return true;
+}
+
+/* ===== Still windows ===== */
+static void window_add(struct calib_window *w, const struct imu_sample *s)
+{
+    const int16_t v[6] = { s->gyr[0], s->gyr[1], s->gyr[2], s->acc[0], s->acc[1], s->acc[2] };
+
+    if (w->n == 0) {
+        memcpy(w->ref, v, sizeof(w->ref));
+        w->t0_us = s->t_us;
+    }
+    for (int k = 0; k < 6; k++) {
+        int32_t d = v[k] - w->ref[k];
+
+        w->sum[k] += d;
+        w->sum_sq[k] += (int64_t)d * d;
+    }
+    w->n++;
+}
+
+static bool window_close(struct calib *c)
+{
+    struct calib_window *w = &c->w;
+    const float gyr_lim = c->p.gyr_still_dps * IMU_GYR_LSB_PER_DPS;
+    const float acc_lim = c->p.acc_still_mg * COUNTS_PER_MG;
+    const float bias_lim = c->p.bias_max_dps * IMU_GYR_LSB_PER_DPS;
+    float mean[6];
+    bool still = w->n >= WINDOW_MIN_SAMPLES;
+
+    for (int k = 0; k < 6 && still; k++) {
+        float m = (float)w->sum[k] / (float)w->n;
+        float var = (float)w->sum_sq[k] / (float)w->n - m * m;
+        float sd = var > 0.0f ? sqrtf(var) : 0.0f;
+
+        mean[k] = w->ref[k] + m;
+        still = k < 3 ? (sd < gyr_lim && fabsf(mean[k]) < bias_lim) : sd < acc_lim;
+    }
+    memset(w, 0, sizeof(*w));
+    c->windows++;
+    if (!still) {
+        return false;
+    }
+    c->still_windows++;
+
+    bool changed = false;
+
+    if (c->p.bias_windows) {
+        uint32_t n = c->bias_n < c->p.bias_windows ? c->bias_n + 1 : c->p.bias_windows;
+
+        for (int ax = 0; ax < 3; ax++) {
+            c->gyr_bias[ax] += (mean[ax] - c->gyr_bias[ax]) / (float)n;
+        }
+        c->bias_n++;
+        c->flags |= CALIB_F_GYRO;
+        changed = true;
+    }
+    if (c->accel_state == CALIB_ACCEL_RUNNING && accel_capture(c, &mean[3])) {
+        changed = true;
+    }
+    return changed;
+}
+
+bool calib_observe(struct calib *c, const struct imu_sample *s, size_t n)
+{
+    bool changed = false;
+
+    for (size_t i = 0; i < n; i++) {
+        if (c->w.n && s[i].t_us - c->w.t0_us >= c->p.window_ms * 1000u) {
+            changed |= window_close(c);
+        }
+        window_add(&c->w, &s[i]);
+    }
+    return changed;
+}
+
+void calib_apply(const struct calib *c, const struct imu_sample *in, struct imu_sample *out,
+                 size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        out[i].t_us = in[i].t_us;
+        for (int ax = 0; ax < 3; ax++) {
+            out[i].gyr[ax] = sat16(in[i].gyr[ax] - c->gyr_bias[ax]);
+            out[i].acc[ax] = sat16((in[i].acc[ax] - c->acc_off[ax]) * c->acc_gain[ax]);
+        }
+    }
+}
+
+/* ===== Snapshot ===== */
+static bool in_range(float v, float lo, float hi)
+{
+    /* False for NaN as well */
+    return v >= lo && v <= hi;
+}
+
+bool calib_snapshot_valid(const struct calib_snapshot *s)
+{
+    const float bias_max = GYR_BIAS_MAX_DPS * IMU_GYR_LSB_PER_DPS;
+    const float off_max = ACC_OFF_MAX_MG * COUNTS_PER_MG;
+    float qn = 0.0f;
+
+    if (s->version != CALIB_SNAPSHOT_VERSION ||
+        (s->flags & ~(CALIB_F_GYRO | CALIB_F_ACCEL | CALIB_F_BASELINE | CALIB_F_ATTITUDE))) {
+        return false;
+    }
+    for (int ax = 0; ax < 3; ax++) {
+        if (!in_range(s->gyr_bias[ax], -bias_max, bias_max) ||
+            !in_range(s->acc_off[ax], -off_max, off_max) ||
+            !in_range(s->acc_gain[ax], ACC_GAIN_MIN, ACC_GAIN_MAX)) {
+            return false;
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        qn += s->q[i] * s->q[i];
+    }
+    return in_range(s->baseline_deg, -90.0f, 90.0f) &&
+           (!(s->flags & CALIB_F_ATTITUDE) || in_range(qn, 0.98f, 1.02f));
+}
+
+bool calib_snapshot_differs(const struct calib_snapshot *a, const struct calib_snapshot *b)
+{
+    float dot = 0.0f;
+
+    if (a->flags != b->flags) {
+        return true;
+    }
+    for (int ax = 0; ax < 3; ax++) {
+        if (fabsf(a->gyr_bias[ax] - b->gyr_bias[ax]) > 0.05f * IMU_GYR_LSB_PER_DPS ||
+            fabsf(a->acc_off[ax] - b->acc_off[ax]) > 5.0f * COUNTS_PER_MG ||
+            fabsf(a->acc_gain[ax] - b->acc_gain[ax]) > 0.002f) {
+            return true;
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        dot += a->q[i] * b->q[i];
+    }
+
+    /* Rotation angle 2 acos|dot| over 2 deg */
+    return fabsf(a->baseline_deg - b->baseline_deg) > 0.5f || fabsf(dot) < 0.99985f;
+}
+
+bool calib_save_due(const struct calib_snapshot *saved, const struct calib_snapshot *now,
+                    uint32_t since_ms, uint32_t interval_ms)
+{
+    if (!saved) {
+        return now->flags != 0;
+    }
+    if (now->flags & ~saved->flags) {
+        return true;
+    }
+    return since_ms >= interval_ms && calib_snapshot_differs(saved, now);
+}
@@ -0,0 +1,136 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CALIB_H_
+#define CALIB_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "imu_sample.h"
+
+/* ===== IMU calibration =====
+ *
+ * Pure computation, no Zephyr dependencies; run by ctrl_logic.c on every
+ * raw sample before fusion and checked on the host by tools/calib_check.
+ *
+ * The samples are cut into windows of window_ms. A window is still when
+ * every gyro axis varies by less than gyr_still_dps and every accel axis
+ * by less than acc_still_mg (standard deviations) and no gyro mean reaches
+ * bias_max_dps (a slow, steady turn is not a bias).
+ *
+ * Gyro bias: the mean gyro of each still window. The estimate averages the
+ * first windows and then follows an exponential average over bias_windows
+ * of them, so temperature drift is tracked. bias_windows 0 turns it off.
+ *
+ * Accel, optional: 6-position calibration. Once started, the patch is laid
+ * still with each axis up and down in turn, in any order; a still window
+ * with one axis within 20 deg of vertical captures that position. With all
+ * six, per axis offset = (up + down) / 2 and gain = 1 g / ((up - down) / 2).
+ * Offsets over 150 mg or gains off by more than 10 % fail the calibration.
+ *
+ * Corrected samples: gyr - bias, (acc - offset) * gain, in raw counts.
+ */
+
+#define CALIB_F_GYRO        0x01    /* gyro bias estimated */
+#define CALIB_F_ACCEL       0x02    /* 6-position accel calibration */
+#define CALIB_F_BASELINE    0x04    /* neutral posture pitch (snapshot) */
+#define CALIB_F_ATTITUDE    0x08    /* fusion quaternion (snapshot) */
+
+#define CALIB_POSITIONS     6       /* +X, -X, +Y, -Y, +Z, -Z up */
+
+enum calib_accel_state {
+    CALIB_ACCEL_IDLE,
+    CALIB_ACCEL_RUNNING,
+    CALIB_ACCEL_DONE,
+    CALIB_ACCEL_FAILED,
+};
+
+struct calib_params {
+    uint32_t window_ms;
+    float gyr_still_dps;
+    float acc_still_mg;
+    float bias_max_dps;
+    uint16_t bias_windows;
+};
+
+/* Statistics of the running window, relative to its first sample so the
+ * integer sums stay exact
+ */
+struct calib_window {
+    int16_t ref[6];             /* gyr, acc of the first sample */
+    int32_t sum[6];
+    int64_t sum_sq[6];
+    uint32_t n;
+    uint32_t t0_us;
+};
+
+struct calib {
+    struct calib_params p;
+    float gyr_bias[3];          /* raw counts */
+    float acc_off[3];           /* raw counts */
+    float acc_gain[3];
+    uint8_t flags;              /* CALIB_F_GYRO, CALIB_F_ACCEL */
+    uint32_t bias_n;            /* still windows averaged */
+    uint32_t windows;
+    uint32_t still_windows;
+
+    struct calib_window w;
+
+    enum calib_accel_state accel_state;
+    uint8_t accel_mask;         /* positions captured, bit per position */
+    float accel_pos[CALIB_POSITIONS];   /* mean of the vertical axis */
+};
+
+void calib_init(struct calib *c, const struct calib_params *params);
+
+/* n raw samples, oldest first. Returns true when the calibration changed
+ * (a bias update, or the accel calibration finished either way).
+ */
+bool calib_observe(struct calib *c, const struct imu_sample *s, size_t n);
+
+/* Corrected copies of n samples, timestamps unchanged */
+void calib_apply(const struct calib *c, const struct imu_sample *in, struct imu_sample *out,
+                 size_t n);
+
+/* Start (or restart) the 6-position accel calibration; the previous result
+ * stays in use until it completes
+ */
+void calib_accel_start(struct calib *c);
+
+/* ===== Snapshot =====
+ * Everything a warm start needs, stored as one settings value. The layout
+ * is versioned; a snapshot of another version is not restored.
+ */
+#define CALIB_SNAPSHOT_VERSION  1
+
+struct calib_snapshot {
+    uint8_t version;
+    uint8_t flags;              /* CALIB_F_* present */
+    uint16_t reserved;
+    float gyr_bias[3];
+    float acc_off[3];
+    float acc_gain[3];
+    float baseline_deg;
+    float q[4];
+};
+
+/* Version, flags and every present value within range */
+bool calib_snapshot_valid(const struct calib_snapshot *s);
+
+/* Whether b differs from a enough to be worth a flash write: a flag, the
+ * bias by 0.05 dps, an accel offset by 5 mg or gain by 0.2 %, the baseline
+ * by 0.5 deg or the attitude by 2 deg
+ */
+bool calib_snapshot_differs(const struct calib_snapshot *a, const struct calib_snapshot *b);
+
+/* Write policy: the first snapshot with anything in it, and new flags, at
+ * once; otherwise at most every interval_ms and only when it differs from
+ * the saved one (NULL if none was saved since boot and none loaded)
+ */
+bool calib_save_due(const struct calib_snapshot *saved, const struct calib_snapshot *now,
+                    uint32_t since_ms, uint32_t interval_ms);
+
+#endif /* CALIB_H_ */
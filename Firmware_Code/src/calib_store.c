@@ -0,0 +1,244 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <errno.h>
+#include <string.h>
+
+#include "calib_store.h"
+#include "control.h"
+
+#if defined(CONFIG_NECK_CALIB_STORE)
+#include <zephyr/settings/settings.h>
+#endif
+
+LOG_MODULE_REGISTER(calib_store, LOG_LEVEL_INF);
+
+#if defined(CONFIG_NECK_CALIB_STORE)
+
+/* ===== Store Configuration ===== */
+#define CALIB_KEY       "neck/cal"
+#define INTERVAL_MS     (CONFIG_NECK_CALIB_SAVE_INTERVAL_S * 1000u)
+
+/* ===== Global Variables ===== */
+static struct calib_snapshot offered;
+static bool offered_any;
+static bool save_now;
+static struct calib_store_stats stats;
+static struct k_spinlock lock;
+
+/* Store thread only */
+static struct calib_snapshot saved;
+static bool have_saved;
+static uint32_t saved_ms;
+
+static K_SEM_DEFINE(wake_sem, 0, 1);
+
+static void store_thread(void *p1, void *p2, void *p3);
+K_THREAD_DEFINE(calib_store_tid, CONFIG_NECK_CALIB_STACK_SIZE, store_thread, NULL, NULL, NULL,
+                CONFIG_NECK_CALIB_THREAD_PRIO, 0, K_TICKS_FOREVER);
+
+/* A value of another size is an older layout: left alone, not restored */
+static int load_cb(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg,
+                   void *param)
+{
+    struct calib_snapshot *s = param;
+
+    if (len == sizeof(*s) && read_cb(cb_arg, s, sizeof(*s)) == sizeof(*s)) {
+        have_saved = true;
+    }
+    return 0;
+}
+
+static void store_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    while (1) {
+        struct calib_snapshot s;
+        bool now, any;
+
+        k_sem_take(&wake_sem, K_FOREVER);
+
+        k_spinlock_key_t key = k_spin_lock(&lock);
+
+        s = offered;
+        any = offered_any;
+        now = save_now;
+        save_now = false;
+        k_spin_unlock(&lock, key);
+
+        uint32_t t = k_uptime_get_32();
+
+        if (!any || !(now || calib_save_due(have_saved ? &saved : NULL, &s, t - saved_ms,
+                                            INTERVAL_MS))) {
+            continue;
+        }
+
+        int rc = settings_save_one(CALIB_KEY, &s, sizeof(s));
+
+        /* Also after a failure, so a broken flash is not retried every second */
+        saved = s;
+        have_saved = true;
+        saved_ms = t;
+
+        key = k_spin_lock(&lock);
+        if (rc) {
+            stats.errors++;
+        } else {
+            stats.saves++;
+            stats.last_save_ms = t;
+        }
+        k_spin_unlock(&lock, key);
+
+        if (rc) {
+            LOG_ERR("Calibration snapshot not saved (%d)", rc);
+        } else {
+            LOG_DBG("Calibration snapshot saved, flags 0x%02x", s.flags);
+        }
+    }
+}
+
+#endif /* CONFIG_NECK_CALIB_STORE */
+
+/* ===== Public API ===== */
+int calib_store_init(struct calib_snapshot *out)
+{
+#if defined(CONFIG_NECK_CALIB_STORE)
+    int rc = settings_subsys_init();
+
+    if (rc == 0) {
+        rc = settings_load_subtree_direct(CALIB_KEY, load_cb, &saved);
+    }
+    if (rc) {
+        LOG_ERR("Settings unavailable (%d), calibration not kept", rc);
+        return rc;
+    }
+    k_thread_name_set(calib_store_tid, "calib_store");
+    k_thread_start(calib_store_tid);
+    if (!have_saved) {
+        return -ENOENT;
+    }
+    *out = saved;
+    stats.restored = true;
+    return 0;
+#else
+    ARG_UNUSED(out);
+    return -ENOENT;
+#endif
+}
+
+void calib_store_offer(const struct calib_snapshot *s, bool now)
+{
+#if defined(CONFIG_NECK_CALIB_STORE)
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    offered = *s;
+    offered_any = true;
+    save_now |= now;
+    stats.offers++;
+    k_spin_unlock(&lock, key);
+    k_sem_give(&wake_sem);
+#else
+    ARG_UNUSED(s);
+    ARG_UNUSED(now);
+#endif
+}
+
+void calib_store_save(void)
+{
+#if defined(CONFIG_NECK_CALIB_STORE)
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    save_now = true;
+    k_spin_unlock(&lock, key);
+    k_sem_give(&wake_sem);
+#endif
+}
+
+void calib_store_stats_get(struct calib_store_stats *out)
+{
+#if defined(CONFIG_NECK_CALIB_STORE)
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    *out = stats;
+    k_spin_unlock(&lock, key);
+#else
+    memset(out, 0, sizeof(*out));
+#endif
+}
+
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+
+/* ===== calib shell command ===== */
+static const char *const accel_state_names[] = {
+    [CALIB_ACCEL_IDLE] = "idle",
+    [CALIB_ACCEL_RUNNING] = "running",
+    [CALIB_ACCEL_DONE] = "done",
+    [CALIB_ACCEL_FAILED] = "failed",
+};
+
+static int cmd_calib(const struct shell *sh, size_t argc, char **argv)
+{
+    struct control_calib_status cs;
+    struct calib_store_stats st;
+    const struct calib_snapshot *s = &cs.snap;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    control_calib_status_get(&cs);
+    calib_store_stats_get(&st);
+    shell_print(sh, "%s start, posture valid %s (%u ms after the first batch)",
+                cs.warm ? "warm" : "cold", cs.valid ? "yes" : "no", cs.valid_ms);
+    shell_print(sh, "flags 0x%02x, gyro bias %d %d %d mdps", s->flags,
+                (int)(s->gyr_bias[0] * 1000.0f / IMU_GYR_LSB_PER_DPS),
+                (int)(s->gyr_bias[1] * 1000.0f / IMU_GYR_LSB_PER_DPS),
+                (int)(s->gyr_bias[2] * 1000.0f / IMU_GYR_LSB_PER_DPS));
+    shell_print(sh, "accel offset %d %d %d mg, gain %d %d %d ppm off",
+                (int)(s->acc_off[0] * 1000.0f / IMU_ACC_LSB_PER_G),
+                (int)(s->acc_off[1] * 1000.0f / IMU_ACC_LSB_PER_G),
+                (int)(s->acc_off[2] * 1000.0f / IMU_ACC_LSB_PER_G),
+                (int)((s->acc_gain[0] - 1.0f) * 1e6f), (int)((s->acc_gain[1] - 1.0f) * 1e6f),
+                (int)((s->acc_gain[2] - 1.0f) * 1e6f));
+    shell_print(sh, "6-position %s, positions 0x%02x", accel_state_names[cs.accel_state],
+                cs.accel_mask);
+    shell_print(sh, "store: %s, %u offers, %u saves, %u errors, last at %u ms",
+                st.restored ? "restored" : "nothing restored", st.offers, st.saves, st.errors,
+                st.last_save_ms);
+    return 0;
+}
+
+static int cmd_calib_accel(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    control_calib_accel_start();
+    shell_print(sh, "Lay the patch still with each axis up, then down, ~2 s each");
+    return 0;
+}
+
+static int cmd_calib_save(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    calib_store_save();
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(calib_cmds,
+    SHELL_CMD(accel, NULL, "Start the 6-position accel calibration", cmd_calib_accel),
+    SHELL_CMD(save, NULL, "Write the calibration snapshot now", cmd_calib_save),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(calib, &calib_cmds, "IMU calibration and warm start", cmd_calib);
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CALIB_STORE_H_
+#define CALIB_STORE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "calib.h"
+
+/* ===== Calibration snapshot store =====
+ *
+ * Keeps the latest calibration snapshot (calib.h) as the settings value
+ * "neck/cal" (NVS on storage_partition), so the next boot starts warm.
+ *
+ * The control thread offers the snapshot about once a second; it only
+ * copies it. The store thread, below the journal, writes it when
+ * calib_save_due() says so: new flags at once, other changes at most every
+ * CONFIG_NECK_CALIB_SAVE_INTERVAL_S and only past the thresholds of
+ * calib_snapshot_differs(). A worn patch writes a few times an hour at
+ * most; a patch on the desk is in IMU low power and offers nothing.
+ *
+ * Compiled to no-ops (nothing restored, nothing written) without
+ * CONFIG_NECK_CALIB_STORE.
+ */
+
+struct calib_store_stats {
+    uint32_t offers;
+    uint32_t saves;
+    uint32_t errors;
+    uint32_t last_save_ms;      /* uptime, 0 before the first */
+    bool restored;              /* a snapshot was loaded at boot */
+};
+
+/* Load the snapshot of the last run into *out and start the store thread.
+ * 0 if there was one, -ENOENT if not, or a settings error.
+ */
+int calib_store_init(struct calib_snapshot *out);
+
+/* Latest state; written subject to the policy above, or as soon as the
+ * store thread runs with now (the end of an explicit calibration)
+ */
+void calib_store_offer(const struct calib_snapshot *s, bool now);
+
+/* Write the last offered snapshot regardless of the policy */
+void calib_store_save(void);
+
+void calib_store_stats_get(struct calib_store_stats *out);
+
+#endif /* CALIB_STORE_H_ */
@@ -0,0 +1,561 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include "control.h"
+#include "imu_acq.h"
+#include "pipeline.h"
+#include "telemetry.h"
+#include "adc_stream.h"
+#include "peltier_ctrl.h"
+#include "therm_sup.h"
+#include "actuators.h"
+#include "haptic.h"
+#include "ctrl_logic.h"
+#include "trace_rec.h"
+#include "prof.h"
+#include "ble_svc.h"
+#include "journal.h"
+#include "calib_store.h"
+
+LOG_MODULE_REGISTER(control, LOG_LEVEL_INF);
+
+/* ===== IMU / Fusion Configuration ===== */
+#define IMU_DT_S        (1.0f / CONFIG_NECK_IMU_ODR_HZ)
+#define IMU_BATCH_MAX   (2 * CONFIG_NECK_IMU_FIFO_WATERMARK)
+
+/* Calibration offered to the store, once the posture is valid */
+#define CALIB_OFFER_MS  1000
+
+/* ===== Global Variables ===== */
+static struct imu_sample batch[IMU_BATCH_MAX];
+static struct ctrl_logic logic;
+static atomic_t led_forced;
+static enum posture_event last_ev;
+
+/* What the journal last recorded, so that it only sees transitions */
+static struct {
+    uint32_t slouch_ms;
+    bool led;
+    int lra;                    /* pattern + 1, 0 off */
+    bool peltier;
+} jrnl;
+
+/* Written by BLE, picked up by the control thread before the next batch */
+static struct posture_params params_pending;
+static struct posture_params params_cur;
+static bool params_new;
+static struct k_spinlock params_lock;
+
+static atomic_t cal_accel_req;
+static struct control_calib_status cal_status;
+static struct k_spinlock cal_lock;
+
+static struct control_activity_status act_status;
+static struct k_spinlock act_lock;
+
+/* ===== Function Declarations ===== */
+static void control_thread(void *p1, void *p2, void *p3);
+
+K_THREAD_DEFINE(control_tid, CONFIG_NECK_CONTROL_STACK_SIZE,
+                control_thread, NULL, NULL, NULL,
+                CONFIG_NECK_CONTROL_THREAD_PRIO, 0, K_TICKS_FOREVER);
+
+/* ===== IMU power modes =====
+ * Runs on the acquisition thread. Low power is only entered while no cue
+ * is running, so the periodic ADC scan and Peltier tick can stop with the
+ * IMU and leave nothing waking the kernel but the motion interrupt.
+ */
+static void imu_mode_changed(enum imu_pm_mode mode)
+{
+    bool low_power = (mode == IMU_PM_LOW_POWER);
+
+    /* The supervisor stops after the Peltiers are off and is back, with
+     * fresh baselines, before they can run again
+     */
+    adc_stream_pause(low_power);
+    if (low_power) {
+        peltier_ctrl_suspend(true);
+        therm_sup_pause(true);
+    } else {
+        therm_sup_pause(false);
+        peltier_ctrl_suspend(false);
+    }
+    ble_svc_set_low_power(low_power);
+}
+
+static void params_apply(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&params_lock);
+
+    if (params_new) {
+        logic.posture.p = params_pending;
+        params_new = false;
+    }
+    k_spin_unlock(&params_lock, key);
+}
+
+/* ===== Event journal =====
+ * Posture events, the slouch dwell and actuator transitions; journal_add()
+ * only queues, the flash writes happen on the journal thread.
+ */
+static void journal_step(const struct ctrl_decision *d, int lra, bool led,
+                         const struct peltier_status *thermal)
+{
+    if (d->ev != POSTURE_EV_NONE) {
+        journal_add(JRNL_POSTURE, d->ev, (int32_t)(logic.posture.dev_deg * 100.0f));
+    }
+    if (d->ev == POSTURE_EV_SLOUCH_START) {
+        jrnl.slouch_ms = logic.t_ms;
+    } else if (d->ev == POSTURE_EV_RECOVERED) {
+        journal_add(JRNL_DWELL, logic.t_ms - jrnl.slouch_ms, 0);
+    }
+
+    if (led != jrnl.led) {
+        jrnl.led = led;
+        journal_add(JRNL_ACTUATOR, JRNL_ACT_LED, led);
+    }
+    /* A pattern started by this step, else the last one until it ends */
+    if (lra == 0 && haptic_busy()) {
+        lra = jrnl.lra;
+    }
+    if (lra != jrnl.lra) {
+        jrnl.lra = lra;
+        journal_add(JRNL_ACTUATOR, JRNL_ACT_LRA, lra);
+    }
+    if ((thermal->duty_permille != 0) != jrnl.peltier) {
+        jrnl.peltier = thermal->duty_permille != 0;
+        journal_add(JRNL_ACTUATOR, JRNL_ACT_PELTIER, thermal->duty_permille);
+    }
+}
+
+/* ===== Calibration =====
+ * The snapshot goes to the store once a second (the store decides what
+ * reaches flash) and at once when a 6-position calibration completes.
+ */
+static void calib_step(bool changed)
+{
+    static uint32_t offer_ms;
+    static enum calib_accel_state accel_was;
+    static bool logged;
+    struct calib *c = &logic.cal;
+
+    if (atomic_clear(&cal_accel_req)) {
+        calib_accel_start(c);
+    }
+
+    bool done = false;
+
+    if (c->accel_state != accel_was) {
+        accel_was = c->accel_state;
+        done = accel_was == CALIB_ACCEL_DONE;
+        if (accel_was == CALIB_ACCEL_FAILED) {
+            LOG_WRN("6-position accel calibration out of range, not used");
+        } else if (done) {
+            LOG_INF("6-position accel calibration done");
+        }
+    }
+
+    if (!logic.valid) {
+        return;
+    }
+    if (!logged) {
+        logged = true;
+        LOG_INF("Posture valid %u ms after the first batch (%s start)", logic.valid_ms,
+                logic.warm_start ? "warm" : "cold");
+    }
+    if (!done && !changed && logic.t_ms - offer_ms < CALIB_OFFER_MS) {
+        return;
+    }
+    offer_ms = logic.t_ms;
+
+    struct control_calib_status cs = {
+        .accel_state = c->accel_state,
+        .accel_mask = c->accel_mask,
+        .warm = logic.warm_start,
+        .valid = true,
+        .valid_ms = logic.valid_ms,
+    };
+
+    ctrl_logic_snapshot(&logic, &cs.snap);
+    calib_store_offer(&cs.snap, done);
+
+    k_spinlock_key_t key = k_spin_lock(&cal_lock);
+
+    cal_status = cs;
+    k_spin_unlock(&cal_lock, key);
+}
+
+/* Publish each new activity decision; with profiling, also the classifier's
+ * cost per second of samples against its budget
+ */
+static void activity_step(void)
+{
+    static uint32_t decisions;
+    static uint32_t cost_us, over_budget;
+#if defined(CONFIG_NECK_PROF)
+    static uint64_t sum_cycles;
+    static uint32_t since_ms;
+    static bool started;
+
+    if (!started || logic.t_ms - since_ms >= 1000u) {
+        struct prof_hist h;
+
+        prof_hist_get(PROF_ACTIVITY, &h);
+        if (started && h.sum >= sum_cycles) {
+            cost_us = (uint32_t)((h.sum - sum_cycles) * 1000000u / prof_cycles_hz() * 1000u /
+                                 (logic.t_ms - since_ms));
+            if (cost_us > CONFIG_NECK_ACTIVITY_BUDGET_US && over_budget++ == 0) {
+                LOG_WRN("Activity classifier over budget: %u us/s", cost_us);
+            }
+        }
+        started = true;
+        sum_cycles = h.sum;
+        since_ms = logic.t_ms;
+    }
+#endif
+    if (logic.act.decisions == decisions) {
+        return;
+    }
+    decisions = logic.act.decisions;
+
+    struct control_activity_status as = {
+        .cls = (uint8_t)logic.act.cls,
+        .gate = logic.gate,
+        .decisions = decisions,
+        .cost_us = cost_us,
+        .over_budget = over_budget,
+    };
+
+    memcpy(as.per_class, logic.act.per_class, sizeof(as.per_class));
+    memcpy(as.feat, logic.act.feat, sizeof(as.feat));
+
+    k_spinlock_key_t key = k_spin_lock(&act_lock);
+
+    act_status = as;
+    k_spin_unlock(&act_lock, key);
+}
+
+/* ===== Control Step =====
+ * Runs once per FIFO batch. Nothing in here logs or formats text on the
+ * normal path; the decision is handed to telemetry as a binary record.
+ */
+static void control_step(size_t n)
+{
+    struct ctrl_decision d;
+    struct ctrl_record rec;
+
+    params_apply();
+
+    /* Calibration and fusion over the whole batch, posture on its newest
+     * sample
+     */
+    bool cal_changed = ctrl_logic_step(&logic, batch, n, &d);
+
+    calib_step(cal_changed);
+    activity_step();
+
+    const struct imu_sample *sample = &batch[n - 1];
+    bool led_on = d.cue;
+    int lra = 0;
+
+#if defined(CONFIG_NECK_TRACE_RECORD)
+    /* Raw inputs of this decision, for tools/replay */
+    int16_t therm = -1, aux = -1;
+
+    adc_stream_latest(ADC_CH_THERM, &therm);
+    adc_stream_latest(ADC_CH_AUX, &aux);
+    trace_rec_batch(batch, n, therm, aux);
+#endif
+
+    PROF_START(PROF_ACTUATE);
+
+    /* No-op unless the state changed since the last batch */
+    actuators_set(ACT_LED, (led_on || atomic_get(&led_forced)) ? ACT_DUTY_FULL : ACT_DUTY_OFF);
+
+    /* The LRA patterns loop on PWM1 by themselves; only events and the
+     * hold change them
+     */
+    switch (d.lra) {
+    case CTRL_LRA_CUE:
+        haptic_play(haptic_cue_pattern(), true);
+        lra = haptic_cue_pattern() + 1;
+        break;
+    case CTRL_LRA_ALERT:
+        haptic_play(HAPTIC_PULSE_TRAIN, true);
+        lra = HAPTIC_PULSE_TRAIN + 1;
+        break;
+    case CTRL_LRA_CONFIRM:
+        /* One short confirmation, then the LRA stops by itself */
+        haptic_play(HAPTIC_DOUBLE_TAP, false);
+        lra = HAPTIC_DOUBLE_TAP + 1;
+        break;
+    case CTRL_LRA_STOP:
+        haptic_stop();
+        break;
+    default:
+        break;
+    }
+    PROF_STOP(PROF_ACTUATE);
+
+    /* The Peltier loop regulates on its own tick; it only needs the cue */
+    struct peltier_status thermal;
+
+    peltier_ctrl_request(led_on);
+    peltier_ctrl_status_get(&thermal);
+
+    /* A running cue keeps the IMU out of low power */
+    imu_acq_hold_active(led_on);
+
+    if (d.ev != POSTURE_EV_NONE) {
+        last_ev = d.ev;
+    }
+    journal_step(&d, lra, led_on || atomic_get(&led_forced), &thermal);
+
+    const struct ble_posture_wire pw = {
+        .state = (uint8_t)logic.posture.state,
+        .event = (uint8_t)last_ev,
+        .flags = (led_on ? BLE_POSTURE_F_CUE : 0) |
+                 (haptic_busy() ? BLE_POSTURE_F_LRA : 0) |
+                 (thermal.duty_permille ? BLE_POSTURE_F_PELTIER : 0),
+        .pitch_cdeg = (int16_t)(d.angles.pitch_deg * 100.0f),
+        .dev_cdeg = (int16_t)(logic.posture.dev_deg * 100.0f),
+        .t_ms = logic.t_ms,
+    };
+
+    /* Latched only; the notification goes out from the work queue */
+    ble_svc_posture_update(&pw);
+
+    uint32_t latency = pipeline_now_us() - sample->t_us;
+
+    pipeline_stage_record(STAGE_CONTROL, latency);
+
+    rec.t_us = sample->t_us;
+    for (int i = 0; i < 3; i++) {
+        rec.acc[i] = sample->acc[i];
+        rec.gyr[i] = sample->gyr[i];
+    }
+    rec.pitch_cdeg = (int16_t)(d.angles.pitch_deg * 100.0f);
+    rec.roll_cdeg = (int16_t)(d.angles.roll_deg * 100.0f);
+    rec.therm_mv = thermal.therm_mv;
+    rec.temp_cdeg = thermal.temp_cdeg;
+    rec.led_on = led_on;
+    rec.peltier_permille = thermal.duty_permille;
+    rec.lra_on = haptic_busy();
+    rec.latency_us = latency;
+
+    /* Never waits: a full ring only costs a telemetry record */
+    telemetry_push(&rec);
+}
+
+static void control_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    while (1) {
+        /* One pass per FIFO batch (watermark / ODR); none arrive while
+         * the IMU is in low power
+         */
+        bool low_power = imu_acq_mode() == IMU_PM_LOW_POWER;
+        int rc = imu_acq_wait(low_power ? K_FOREVER : K_MSEC(1000));
+        if (rc) {
+            if (imu_acq_mode() == IMU_PM_ACTIVE) {
+                LOG_ERR("No IMU batch received (%d)", rc);
+            }
+            continue;
+        }
+
+        /* Gives merge: step through everything queued since the last
+         * pass, so nothing is left waiting for the next batch
+         */
+        size_t n;
+
+        do {
+            n = imu_acq_read(batch, IMU_BATCH_MAX);
+            if (n > 0) {
+                PROF_START(PROF_CONTROL_STEP);
+                control_step(n);
+                PROF_STOP(PROF_CONTROL_STEP);
+            }
+        } while (n == IMU_BATCH_MAX);
+    }
+}
+
+int control_init(void)
+{
+    /* LEDs (P0.22/P0.23) and Peltiers (P1.09/P1.12), all driven off */
+    int ret = actuators_init();
+    if (ret < 0) {
+        return ret;
+    }
+
+    /* LRAs (P1.05/P1.07) on PWM1 sequence playback */
+    ret = haptic_init();
+    if (ret < 0) {
+        return ret;
+    }
+
+    /* Start background sampling of the thermistor (P0.04) and aux (P0.05)
+     * channels; the Peltier loop only reads the latest averages
+     */
+    ret = adc_stream_init();
+    if (ret < 0) {
+        return ret;
+    }
+
+    /* Watches the thermistor itself and can cut the Peltiers under the loop */
+    ret = therm_sup_init();
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = peltier_ctrl_init();
+    if (ret < 0) {
+        return ret;
+    }
+
+    const struct posture_params pp = {
+        .enter_deg = CONFIG_NECK_POSTURE_ENTER_DEG,
+        .exit_deg = CONFIG_NECK_POSTURE_EXIT_DEG,
+        .enter_dwell_ms = CONFIG_NECK_POSTURE_ENTER_DWELL_MS,
+        .exit_dwell_ms = CONFIG_NECK_POSTURE_EXIT_DWELL_MS,
+        .alert_ms = CONFIG_NECK_POSTURE_ALERT_MS,
+        .baseline_tau_s = CONFIG_NECK_POSTURE_BASELINE_TAU_S,
+        .warmup_ms = CONFIG_NECK_POSTURE_WARMUP_MS,
+        .baseline_limit_deg = CONFIG_NECK_POSTURE_BASELINE_LIMIT_DEG,
+    };
+
+    BUILD_ASSERT(CONFIG_NECK_POSTURE_EXIT_DEG < CONFIG_NECK_POSTURE_ENTER_DEG,
+                 "posture exit threshold must be below the enter threshold");
+    const struct calib_params cp = {
+        .window_ms = CONFIG_NECK_CALIB_WINDOW_MS,
+        .gyr_still_dps = CONFIG_NECK_CALIB_STILL_MDPS / 1000.0f,
+        .acc_still_mg = CONFIG_NECK_CALIB_STILL_MG,
+        .bias_max_dps = CONFIG_NECK_CALIB_BIAS_MAX_MDPS / 1000.0f,
+        .bias_windows = CONFIG_NECK_CALIB_BIAS_WINDOWS,
+    };
+    struct calib_snapshot snap;
+
+    ctrl_logic_init(&logic, CONFIG_NECK_FUSION_BETA_MILLI / 1000.0f, IMU_DT_S, &pp, &cp);
+    logic.gate = IS_ENABLED(CONFIG_NECK_ACTIVITY);
+
+    /* Last run's calibration and neutral pitch; the first batch decides
+     * whether the pitch still applies
+     */
+    ret = calib_store_init(&snap);
+    if (ret == 0 && ctrl_logic_restore(&logic, &snap)) {
+        LOG_INF("Calibration restored (flags 0x%02x)", snap.flags);
+    } else if (ret == 0) {
+        LOG_WRN("Stored calibration rejected");
+    }
+    params_cur = pp;
+    trace_rec_start();
+    imu_acq_set_mode_cb(imu_mode_changed);
+    pipeline_stage_init(STAGE_CONTROL, CONFIG_NECK_CONTROL_DEADLINE_US);
+    return 0;
+}
+
+void control_start(void)
+{
+    k_thread_start(control_tid);
+}
+
+void control_led_force(bool on)
+{
+    atomic_set(&led_forced, on);
+}
+
+bool control_led_forced(void)
+{
+    return atomic_get(&led_forced) != 0;
+}
+
+int control_posture_params_set(const struct posture_params *pp)
+{
+    if (!(pp->exit_deg > 0.0f && pp->exit_deg < pp->enter_deg)) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&params_lock);
+
+    params_pending = *pp;
+    params_cur = *pp;
+    params_new = true;
+    k_spin_unlock(&params_lock, key);
+    return 0;
+}
+
+void control_posture_params_get(struct posture_params *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&params_lock);
+
+    *out = params_cur;
+    k_spin_unlock(&params_lock, key);
+}
+
+void control_calib_accel_start(void)
+{
+    atomic_set(&cal_accel_req, 1);
+}
+
+void control_calib_status_get(struct control_calib_status *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&cal_lock);
+
+    *out = cal_status;
+    k_spin_unlock(&cal_lock, key);
+}
+
+void control_activity_status_get(struct control_activity_status *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&act_lock);
+
+    *out = act_status;
+    k_spin_unlock(&act_lock, key);
+}
+
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+
+/* ===== activity shell command ===== */
+static int cmd_activity(const struct shell *sh, size_t argc, char **argv)
+{
+    struct control_activity_status as;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    control_activity_status_get(&as);
+    shell_print(sh, "%s, posture cues %s, %u decisions", activity_class_name(as.cls),
+                !as.gate ? "not gated" : as.cls == ACTIVITY_STILL ? "live" : "held",
+                as.decisions);
+    for (int c = 0; c < ACTIVITY_COUNT; c++) {
+        shell_print(sh, "  %-8s %u", activity_class_name(c), as.per_class[c]);
+    }
+    for (int f = 0; f < ACT_F_COUNT; f++) {
+        /* No %f in the shell: sign, then the whole and milli parts */
+        uint32_t milli = (uint32_t)(fabsf(as.feat[f]) * 1000.0f + 0.5f);
+
+        shell_print(sh, "  %-9s %s%u.%03u", activity_feature_name(f),
+                    (as.feat[f] < 0.0f && milli) ? "-" : "", milli / 1000, milli % 1000);
+    }
+    if (IS_ENABLED(CONFIG_NECK_PROF)) {
+        shell_print(sh, "cost %u us/s of %u, over budget %u s", as.cost_us,
+                    CONFIG_NECK_ACTIVITY_BUDGET_US, as.over_budget);
+    }
+    return 0;
+}
+
+SHELL_CMD_REGISTER(activity, NULL, "Activity classifier and posture gate", cmd_activity);
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CONTROL_H_
+#define CONTROL_H_
+
+#include <stdbool.h>
+
+#include "activity.h"
+#include "calib.h"
+#include "posture.h"
+
+/* Bring up the actuators (all off), the ADC scan and the Peltier loop */
+int control_init(void);
+
+/* Start the control thread (consumes IMU batches, drives actuators) */
+void control_start(void);
+
+/* Force the cue LEDs on regardless of posture (BLE command), or release
+ * them to follow the posture again
+ */
+void control_led_force(bool on);
+bool control_led_forced(void);
+
+/* Replace the posture parameters; applied before the next batch without
+ * resetting the baseline. -EINVAL unless 0 < exit < enter.
+ */
+int control_posture_params_set(const struct posture_params *pp);
+void control_posture_params_get(struct posture_params *out);
+
+/* Calibration as the control thread last published it (about once a
+ * second)
+ */
+struct control_calib_status {
+    struct calib_snapshot snap;
+    uint8_t accel_state;        /* enum calib_accel_state */
+    uint8_t accel_mask;         /* 6-position captures so far */
+    bool warm;                  /* neutral pitch restored at boot */
+    bool valid;                 /* posture out of warm-up */
+    uint32_t valid_ms;          /* first batch to valid */
+};
+
+/* Start the 6-position accel calibration with the next batch; the result
+ * is saved as soon as it completes
+ */
+void control_calib_accel_start(void);
+void control_calib_status_get(struct control_calib_status *out);
+
+/* Activity classifier as of its last decision */
+struct control_activity_status {
+    uint8_t cls;                /* enum activity_class */
+    bool gate;                  /* holds the posture cues */
+    uint32_t decisions;
+    uint32_t per_class[ACTIVITY_COUNT];
+    float feat[ACT_F_COUNT];
+    uint32_t cost_us;           /* per second of samples; 0 without CONFIG_NECK_PROF */
+    uint32_t over_budget;       /* seconds above CONFIG_NECK_ACTIVITY_BUDGET_US */
+};
+
+void control_activity_status_get(struct control_activity_status *out);
+
+#endif /* CONTROL_H_ */
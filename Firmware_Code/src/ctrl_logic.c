@@ -0,0 +1,192 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "ctrl_logic.h"
+#include "prof.h"
+
+/* Samples calibrated per fusion call */
+#define CAL_CHUNK       16
+
+#define DEG_TO_RAD      0.017453293f
+
+static enum ctrl_lra lra_action(bool was_cue, const struct ctrl_decision *d)
+{
+    switch (d->ev) {
+    case POSTURE_EV_SLOUCH_START:
+        return CTRL_LRA_CUE;
+    case POSTURE_EV_DWELL_EXCEEDED:
+        return CTRL_LRA_ALERT;
+    case POSTURE_EV_RECOVERED:
+        return CTRL_LRA_CONFIRM;
+    default:
+        break;
+    }
+    /* No event: the cue only changes with the hold, still slouched */
+    if (d->cue == was_cue) {
+        return CTRL_LRA_KEEP;
+    }
+    return d->cue ? CTRL_LRA_CUE : CTRL_LRA_STOP;
+}
+
+void ctrl_logic_init(struct ctrl_logic *cl, float beta, float dt_s,
+                     const struct posture_params *pp, const struct calib_params *cp)
+{
+    memset(cl, 0, sizeof(*cl));
+    fusion_init(&cl->fusion, beta, FUSION_GYR_RAD_PER_LSB);
+    posture_init(&cl->posture, pp);
+    calib_init(&cl->cal, cp);
+    activity_init(&cl->act);
+    cl->gate = true;
+    cl->dt_s = dt_s;
+}
+
+bool ctrl_logic_restore(struct ctrl_logic *cl, const struct calib_snapshot *s)
+{
+    struct calib *c = &cl->cal;
+
+    if (cl->started || !calib_snapshot_valid(s)) {
+        return false;
+    }
+    if (s->flags & CALIB_F_GYRO) {
+        memcpy(c->gyr_bias, s->gyr_bias, sizeof(c->gyr_bias));
+        c->bias_n = CTRL_WARM_BIAS_WINDOWS;
+        c->flags |= CALIB_F_GYRO;
+    }
+    if (s->flags & CALIB_F_ACCEL) {
+        memcpy(c->acc_off, s->acc_off, sizeof(c->acc_off));
+        memcpy(c->acc_gain, s->acc_gain, sizeof(c->acc_gain));
+        c->flags |= CALIB_F_ACCEL;
+    }
+    cl->warm = *s;
+    return true;
+}
+
+void ctrl_logic_snapshot(const struct ctrl_logic *cl, struct calib_snapshot *out)
+{
+    const struct calib *c = &cl->cal;
+
+    memset(out, 0, sizeof(*out));
+    out->version = CALIB_SNAPSHOT_VERSION;
+    out->flags = c->flags;
+    memcpy(out->gyr_bias, c->gyr_bias, sizeof(out->gyr_bias));
+    memcpy(out->acc_off, c->acc_off, sizeof(out->acc_off));
+    memcpy(out->acc_gain, c->acc_gain, sizeof(out->acc_gain));
+    if (cl->posture.state != POSTURE_WARMUP) {
+        out->flags |= CALIB_F_BASELINE;
+        out->baseline_deg = cl->posture.baseline_deg;
+    }
+    if (cl->started) {
+        out->flags |= CALIB_F_ATTITUDE;
+        memcpy(out->q, cl->fusion.q, sizeof(out->q));
+    }
+}
+
+/* First batch: fusion from its mean (corrected) accel reading, or the
+ * restored attitude when that agrees with it
+ */
+static void start(struct ctrl_logic *cl, const struct imu_sample *batch, size_t n)
+{
+    int32_t sum[3] = { 0 };
+    struct imu_sample mean = batch[0];
+
+    for (size_t i = 0; i < n; i++) {
+        for (int ax = 0; ax < 3; ax++) {
+            sum[ax] += batch[i].acc[ax];
+        }
+    }
+    for (int ax = 0; ax < 3; ax++) {
+        mean.acc[ax] = (int16_t)(sum[ax] / (int32_t)n);
+    }
+    calib_apply(&cl->cal, &mean, &mean, 1);
+    fusion_seed(&cl->fusion, mean.acc);
+
+    if (cl->warm.flags & CALIB_F_ATTITUDE) {
+        const float *q = cl->warm.q;
+        float g[3] = {
+            2.0f * (q[1] * q[3] - q[0] * q[2]),
+            2.0f * (q[0] * q[1] + q[2] * q[3]),
+            q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3],
+        };
+        float dot = 0.0f, an = 0.0f;
+
+        for (int ax = 0; ax < 3; ax++) {
+            dot += g[ax] * mean.acc[ax];
+            an += (float)mean.acc[ax] * mean.acc[ax];
+        }
+        if (an > 0.0f && dot >= cosf(CTRL_WARM_TILT_DEG * DEG_TO_RAD) * sqrtf(an)) {
+            memcpy(cl->fusion.q, q, sizeof(cl->fusion.q));
+        }
+    }
+    cl->sample_us = batch[0].t_us - (uint32_t)(cl->dt_s * 1e6f);
+    cl->started = true;
+}
+
+bool ctrl_logic_step(struct ctrl_logic *cl, const struct imu_sample *batch, size_t n,
+                     struct ctrl_decision *out)
+{
+    struct imu_sample cal[CAL_CHUNK];
+    bool first = !cl->started;
+    bool changed = false;
+
+    /* Every sample is calibrated and goes through fusion, whatever rate it
+     * came at
+     */
+    PROF_START(PROF_FUSION);
+    if (first) {
+        start(cl, batch, n);
+    }
+    for (size_t i = 0; i < n;) {
+        size_t m = n - i < CAL_CHUNK ? n - i : CAL_CHUNK;
+
+        changed |= calib_observe(&cl->cal, batch + i, m);
+        calib_apply(&cl->cal, batch + i, cal, m);
+        fusion_update_batch(&cl->fusion, cal, m, cl->sample_us, CTRL_DT_MAX_S);
+        cl->sample_us = cal[m - 1].t_us;
+        if (cl->gate) {
+            PROF_START(PROF_ACTIVITY);
+            activity_update(&cl->act, cal, m);
+            PROF_STOP(PROF_ACTIVITY);
+        }
+        i += m;
+    }
+    fusion_get_angles(&cl->fusion, &out->angles);
+    PROF_STOP(PROF_FUSION);
+
+    /* Millisecond time base from the newest sample timestamp; t_us wraps
+     * every ~71 min, the deltas do not
+     */
+    uint32_t dt_us = batch[n - 1].t_us - cl->last_us;
+
+    cl->t_ms += dt_us / 1000;
+    cl->last_us += dt_us - dt_us % 1000;
+
+    if (first) {
+        cl->t_first_ms = cl->t_ms;
+        if ((cl->warm.flags & CALIB_F_BASELINE) &&
+            fabsf(out->angles.pitch_deg - cl->warm.baseline_deg) < cl->posture.p.exit_deg) {
+            posture_restore(&cl->posture, cl->warm.baseline_deg);
+            cl->warm_start = true;
+        }
+    }
+
+    bool moving = cl->gate && activity_moving(&cl->act);
+
+    PROF_START(PROF_POSTURE);
+    posture_hold(&cl->posture, moving);
+    out->ev = posture_step(&cl->posture, out->angles.pitch_deg, cl->t_ms);
+    out->cue = posture_slouched(&cl->posture) && !moving;
+    out->lra = lra_action(cl->cue, out);
+    cl->cue = out->cue;
+    PROF_STOP(PROF_POSTURE);
+    out->activity = cl->act.cls;
+
+    if (!cl->valid && cl->posture.state != POSTURE_WARMUP) {
+        cl->valid = true;
+        cl->valid_ms = cl->t_ms - cl->t_first_ms;
+    }
+    return changed;
+}
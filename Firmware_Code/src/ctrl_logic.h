@@ -0,0 +1,98 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CTRL_LOGIC_H_
+#define CTRL_LOGIC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "activity.h"
+#include "calib.h"
+#include "fusion.h"
+#include "imu_sample.h"
+#include "posture.h"
+
+/* ===== Control decision logic =====
+ *
+ * Everything control.c decides per FIFO batch, without touching a driver:
+ * calibration (calib.h) on the raw samples, fusion and the activity
+ * classifier (activity.h) over the corrected batch on the samples' own
+ * timestamps (the IMU rate adapts to motion, imu_odr.h), then the posture
+ * engine on the newest sample, held while the wearer is not still.
+ * control.c applies the decision to the actuators; tools/replay runs the
+ * same code over recorded traces on the host, always from a cold start.
+ *
+ * The first batch seeds the fusion from its mean accel reading. A snapshot
+ * restored before it (ctrl_logic_restore()) brings back the calibration at
+ * once; its attitude is used if within CTRL_WARM_TILT_DEG of that reading,
+ * its neutral pitch if the first fused pitch is inside the recovery band
+ * (exit_deg) around it. Otherwise the posture warms up as on a cold start
+ * (the patch was re-applied differently).
+ */
+
+/* Longest fusion step: over 2 periods at the lowest IMU rate (25 Hz) */
+#define CTRL_DT_MAX_S   0.1f
+
+#define CTRL_WARM_TILT_DEG      10.0f
+
+/* Weight of a restored gyro bias, in still windows */
+#define CTRL_WARM_BIAS_WINDOWS  4
+
+struct ctrl_logic {
+    struct fusion fusion;
+    struct posture posture;
+    struct calib cal;
+    struct activity act;
+    bool gate;                  /* activity holds the posture; default on */
+    float dt_s;                 /* nominal IMU period, for the first sample */
+    uint32_t t_ms;              /* posture time base */
+    uint32_t last_us;
+    uint32_t sample_us;         /* newest sample fused */
+    bool started;
+    bool cue;                   /* last decision's */
+
+    struct calib_snapshot warm; /* restored, checked on the first batch */
+    bool warm_start;            /* neutral pitch taken from the snapshot */
+    bool valid;                 /* posture out of warm-up */
+    uint32_t t_first_ms;
+    uint32_t valid_ms;          /* first batch to valid */
+};
+
+/* What the LRA does after a decision. The looping patterns run exactly
+ * while the cue is on: a hold stops them, its release restarts the cue.
+ */
+enum ctrl_lra {
+    CTRL_LRA_KEEP,
+    CTRL_LRA_CUE,               /* the cue pattern, looped */
+    CTRL_LRA_ALERT,             /* the dwell alert, looped */
+    CTRL_LRA_CONFIRM,           /* recovered: once */
+    CTRL_LRA_STOP,
+};
+
+struct ctrl_decision {
+    struct fusion_angles angles;
+    enum posture_event ev;
+    bool cue;                   /* slouched and still: LEDs, LRA and Peltier cue on */
+    enum ctrl_lra lra;
+    enum activity_class activity;
+};
+
+void ctrl_logic_init(struct ctrl_logic *cl, float beta, float dt_s,
+                     const struct posture_params *pp, const struct calib_params *cp);
+
+/* Before the first batch only. False, and nothing restored, for an
+ * invalid snapshot.
+ */
+bool ctrl_logic_restore(struct ctrl_logic *cl, const struct calib_snapshot *s);
+
+/* Calibration, neutral pitch (once out of warm-up) and attitude now */
+void ctrl_logic_snapshot(const struct ctrl_logic *cl, struct calib_snapshot *out);
+
+/* n >= 1 samples, oldest first. Returns true when the calibration changed. */
+bool ctrl_logic_step(struct ctrl_logic *cl, const struct imu_sample *batch, size_t n,
+                     struct ctrl_decision *out);
+
+#endif /* CTRL_LOGIC_H_ */
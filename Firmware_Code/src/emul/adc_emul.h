@@ -0,0 +1,35 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ADC_EMUL_H_
+#define ADC_EMUL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== Emulated SAADC scan (native_sim) =====
+ * Software model of the double-buffered, oversampled scan behind adc_scan.h.
+ * A k_timer runs one scan per period; tests can stop it and push scans by
+ * hand to check buffer swaps and averaging deterministically.
+ */
+
+/* Pin voltage seen by every following conversion on a channel */
+void adc_emul_set_input_mv(int ch, int mv);
+
+/* Uniform noise of +-amplitude codes added to each conversion (before
+ * oversampling), 0 to disable
+ */
+void adc_emul_set_noise(uint16_t amplitude);
+
+/* Start/stop the scan timer */
+void adc_emul_set_running(bool running);
+
+/* Run n scans immediately, as if n trigger periods had elapsed */
+void adc_emul_push_scans(uint32_t n);
+
+/* Buffers completed so far, and the index (0/1) of the one being filled */
+uint32_t adc_emul_buffers_done(void);
+int adc_emul_active_buffer(void);
+
+#endif /* ADC_EMUL_H_ */
@@ -0,0 +1,137 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <errno.h>
+
+#include "../adc_scan.h"
+#include "adc_emul.h"
+
+LOG_MODULE_REGISTER(adc_scan_emul, LOG_LEVEL_INF);
+
+/* ===== Scan model =====
+ * Mirrors the SAADC setup in hw/adc_scan_saadc.c: each scan converts every
+ * channel 2^oversample times and stores the average, scans fill one of two
+ * buffers, and a full buffer is handed to the callback while the other one
+ * takes the next scans.
+ */
+#define BUF_SAMPLES     (CONFIG_NECK_ADC_SCANS_PER_BUFFER * ADC_SCAN_CHANNELS)
+#define CODE_MAX        4095
+
+static int16_t bufs[2][BUF_SAMPLES];
+static int active;
+static uint16_t fill;
+static uint32_t buffers_done;
+static int input_code[ADC_SCAN_CHANNELS];
+static uint16_t noise;
+static uint32_t rng = 0x2545F491;
+static uint8_t oversample;
+static adc_scan_done_cb_t done_cb;
+static struct k_spinlock lock;
+
+static void scan_timer_fn(struct k_timer *timer);
+static K_TIMER_DEFINE(scan_timer, scan_timer_fn, NULL);
+static k_timeout_t scan_period;
+
+static int convert(int ch)
+{
+    int code = input_code[ch];
+
+    if (noise) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        code += (int)(rng % (2u * noise + 1)) - noise;
+    }
+    return CLAMP(code, 0, CODE_MAX);
+}
+
+void adc_emul_push_scans(uint32_t n)
+{
+    while (n--) {
+        const int16_t *done = NULL;
+        k_spinlock_key_t key = k_spin_lock(&lock);
+
+        for (int ch = 0; ch < ADC_SCAN_CHANNELS; ch++) {
+            int32_t sum = 0;
+
+            for (int i = 0; i < (1 << oversample); i++) {
+                sum += convert(ch);
+            }
+            bufs[active][fill * ADC_SCAN_CHANNELS + ch] = (int16_t)(sum >> oversample);
+        }
+        if (++fill == CONFIG_NECK_ADC_SCANS_PER_BUFFER) {
+            done = bufs[active];
+            active ^= 1;
+            fill = 0;
+            buffers_done++;
+        }
+        k_spin_unlock(&lock, key);
+
+        if (done && done_cb) {
+            done_cb(done, CONFIG_NECK_ADC_SCANS_PER_BUFFER);
+        }
+    }
+}
+
+static void scan_timer_fn(struct k_timer *timer)
+{
+    ARG_UNUSED(timer);
+    adc_emul_push_scans(1);
+}
+
+void adc_emul_set_input_mv(int ch, int mv)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    input_code[ch] = (int)(((int64_t)mv << 12) / CONFIG_NECK_ADC_FULL_SCALE_MV);
+    k_spin_unlock(&lock, key);
+}
+
+void adc_emul_set_noise(uint16_t amplitude)
+{
+    noise = amplitude;
+}
+
+void adc_emul_set_running(bool running)
+{
+    if (running) {
+        k_timer_start(&scan_timer, scan_period, scan_period);
+    } else {
+        k_timer_stop(&scan_timer);
+    }
+}
+
+void adc_scan_pause(bool paused)
+{
+    adc_emul_set_running(!paused);
+}
+
+uint32_t adc_emul_buffers_done(void)
+{
+    return buffers_done;
+}
+
+int adc_emul_active_buffer(void)
+{
+    return active;
+}
+
+/* ===== adc_scan.h backend ===== */
+int adc_scan_start(uint32_t rate_hz, uint8_t oversample_log2, adc_scan_done_cb_t cb)
+{
+    if (rate_hz == 0) {
+        return -EINVAL;
+    }
+    oversample = oversample_log2;
+    done_cb = cb;
+    scan_period = K_USEC(1000000 / rate_hz);
+
+    /* Thermistor divider at R0 (25 C with the default NTC) */
+    adc_emul_set_input_mv(0, CONFIG_NECK_THERM_VREF_MV / 2);
+    adc_emul_set_running(true);
+    LOG_INF("Emulated SAADC scan at %d Hz", rate_hz);
+    return 0;
+}
@@ -0,0 +1,25 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HAPTIC_EMUL_H_
+#define HAPTIC_EMUL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== Emulated PWM1 sequence playback (native_sim) =====
+ * Records what would have been handed to EasyDMA and times the playback
+ * with a k_timer (len * countertop microseconds), so the haptic module sees
+ * the same start/finish behaviour as on hardware.
+ */
+
+/* Sequence of the current or last playback; NULL before the first one */
+const uint16_t *haptic_emul_last_seq(uint16_t *len, uint16_t *countertop);
+
+/* Playbacks started so far */
+uint32_t haptic_emul_play_count(void);
+
+bool haptic_emul_playing(void);
+
+#endif /* HAPTIC_EMUL_H_ */
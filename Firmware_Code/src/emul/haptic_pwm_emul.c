@@ -0,0 +1,84 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <errno.h>
+
+#include "../haptic_pwm.h"
+#include "../haptic_wave.h"
+#include "haptic_emul.h"
+
+LOG_MODULE_REGISTER(haptic_pwm_emul, LOG_LEVEL_INF);
+
+static const uint16_t *last_seq;
+static uint16_t last_len;
+static uint16_t last_top;
+static uint32_t play_count;
+static bool playing;
+static haptic_pwm_done_cb_t done_cb;
+
+static void seq_timer_fn(struct k_timer *timer);
+static K_TIMER_DEFINE(seq_timer, seq_timer_fn, NULL);
+
+static void seq_timer_fn(struct k_timer *timer)
+{
+    ARG_UNUSED(timer);
+    playing = false;
+    if (done_cb) {
+        done_cb();
+    }
+}
+
+const uint16_t *haptic_emul_last_seq(uint16_t *len, uint16_t *countertop)
+{
+    *len = last_len;
+    *countertop = last_top;
+    return last_seq;
+}
+
+uint32_t haptic_emul_play_count(void)
+{
+    return play_count;
+}
+
+bool haptic_emul_playing(void)
+{
+    return playing;
+}
+
+/* ===== haptic_pwm.h backend ===== */
+int haptic_pwm_init(haptic_pwm_done_cb_t cb)
+{
+    done_cb = cb;
+    return 0;
+}
+
+int haptic_pwm_play(const uint16_t *seq, uint16_t len, uint16_t countertop, bool repeat)
+{
+    if (len == 0) {
+        return -EINVAL;
+    }
+    haptic_pwm_stop();
+
+    last_seq = seq;
+    last_len = len;
+    last_top = countertop;
+    play_count++;
+    playing = true;
+
+    /* A looping sequence runs until stopped, like NRFX_PWM_FLAG_LOOP */
+    if (!repeat) {
+        uint64_t us = (uint64_t)len * countertop * 1000000 / HAPTIC_PWM_CLOCK_HZ;
+
+        k_timer_start(&seq_timer, K_USEC(us), K_NO_WAIT);
+    }
+    return 0;
+}
+
+void haptic_pwm_stop(void)
+{
+    k_timer_stop(&seq_timer);
+    playing = false;
+}
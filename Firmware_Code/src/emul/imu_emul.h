@@ -0,0 +1,41 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef IMU_EMUL_H_
+#define IMU_EMUL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== Emulated BMI270 FIFO (native_sim) =====
+ * Software model of the header-mode FIFO behind imu_fifo.h. A k_timer pushes
+ * one frame per ODR period; tests can stop the timer and push frames by hand
+ * to exercise batch draining and overrun handling deterministically. The
+ * any/no-motion features and low-power mode are modelled as well; in low
+ * power frames are still produced for the motion model but not queued.
+ */
+
+/* Raw counts returned by every following frame */
+void imu_emul_set_sample(const int16_t acc[3], const int16_t gyr[3]);
+
+/* Start/stop the ODR timer */
+void imu_emul_set_running(bool running);
+
+/* Push n frames immediately, as if n ODR periods had elapsed */
+void imu_emul_push_frames(uint32_t n);
+
+/* Frames discarded by the model because the FIFO was full */
+uint32_t imu_emul_overrun_frames(void);
+
+/* The motion features compare every frame with the previous one, also in
+ * low-power mode: any-motion fires on a jump over the threshold, no-motion
+ * after the stillness time without one. Change the sample (or set it again
+ * with an offset) to script motion.
+ */
+bool imu_emul_low_power(void);
+
+/* Interrupt causes raised so far, per IMU_INT_* bit index */
+uint32_t imu_emul_int_count(uint8_t cause);
+
+#endif /* IMU_EMUL_H_ */
@@ -0,0 +1,298 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "../imu_fifo.h"
+#include "imu_emul.h"
+
+LOG_MODULE_REGISTER(imu_fifo_emul, LOG_LEVEL_INF);
+
+/* ===== FIFO model =====
+ * Frames are kept as samples and serialised to header-mode bytes on read.
+ * When full, the oldest frame is discarded and reported through a skip frame
+ * on the next read, like the BMI270 does with fifo_stop_on_full = 0.
+ */
+#define EMUL_FIFO_FRAMES    (IMU_FIFO_SIZE_BYTES / IMU_FIFO_FRAME_BYTES)
+
+struct emul_frame {
+    int16_t gyr[3];
+    int16_t acc[3];
+};
+
+static struct emul_frame fifo[EMUL_FIFO_FRAMES];
+static uint32_t fifo_head;
+static uint32_t fifo_count;
+static uint32_t skipped;
+static uint32_t overrun_total;
+static struct emul_frame cur = { .acc = { 0, 0, 16384 } };
+static uint16_t watermark;
+static imu_fifo_irq_cb_t irq_cb;
+static struct k_spinlock lock;
+
+/* Motion feature model */
+static struct emul_frame prev;
+static int32_t motion_thr;          /* accel counts */
+static uint32_t still_frames;       /* frames without motion before no-motion */
+static uint16_t still_secs;
+static uint32_t quiet_frames;
+static bool motion_enabled;
+static bool low_power;
+static uint8_t int_latched;
+static uint32_t int_counts[3];
+static uint16_t active_odr_hz;
+static bool running;
+
+static void odr_timer_fn(struct k_timer *timer);
+static K_TIMER_DEFINE(odr_timer, odr_timer_fn, NULL);
+static k_timeout_t odr_period;
+
+static uint16_t level_locked(void)
+{
+    return fifo_count * IMU_FIFO_FRAME_BYTES + (skipped ? 2 : 0);
+}
+
+static void push_locked(void)
+{
+    if (fifo_count == EMUL_FIFO_FRAMES) {
+        fifo_head = (fifo_head + 1) % EMUL_FIFO_FRAMES;
+        fifo_count--;
+        skipped++;
+        overrun_total++;
+    }
+    fifo[(fifo_head + fifo_count) % EMUL_FIFO_FRAMES] = cur;
+    fifo_count++;
+}
+
+static void raise_locked(uint8_t cause)
+{
+    int_latched |= cause;
+    for (int b = 0; b < 3; b++) {
+        if (cause & BIT(b)) {
+            int_counts[b]++;
+        }
+    }
+}
+
+/* Returns the feature interrupt raised by this frame, if any */
+static uint8_t motion_locked(void)
+{
+    bool moved = false;
+
+    if (!motion_enabled) {
+        return 0;
+    }
+    for (int ax = 0; ax < 3; ax++) {
+        if (abs(cur.acc[ax] - prev.acc[ax]) > motion_thr) {
+            moved = true;
+        }
+    }
+    prev = cur;
+    if (moved) {
+        quiet_frames = 0;
+        return IMU_INT_ANY_MOTION;
+    }
+    if (++quiet_frames == still_frames) {
+        return IMU_INT_NO_MOTION;
+    }
+    return 0;
+}
+
+void imu_emul_push_frames(uint32_t n)
+{
+    bool fire = false;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    uint16_t before = level_locked();
+
+    while (n--) {
+        uint8_t cause = motion_locked();
+
+        if (cause) {
+            raise_locked(cause);
+            fire = true;
+        }
+        if (!low_power) {
+            push_locked();
+        }
+    }
+    if (!low_power && before < watermark && level_locked() >= watermark) {
+        raise_locked(IMU_INT_FIFO);
+        fire = true;
+    }
+    k_spin_unlock(&lock, key);
+
+    if (fire && irq_cb) {
+        irq_cb();
+    }
+}
+
+static void odr_timer_fn(struct k_timer *timer)
+{
+    ARG_UNUSED(timer);
+    imu_emul_push_frames(1);
+}
+
+void imu_emul_set_sample(const int16_t acc[3], const int16_t gyr[3])
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    memcpy(cur.acc, acc, sizeof(cur.acc));
+    memcpy(cur.gyr, gyr, sizeof(cur.gyr));
+    k_spin_unlock(&lock, key);
+}
+
+void imu_emul_set_running(bool run)
+{
+    running = run;
+    if (run) {
+        k_timer_start(&odr_timer, odr_period, odr_period);
+    } else {
+        k_timer_stop(&odr_timer);
+    }
+}
+
+uint32_t imu_emul_overrun_frames(void)
+{
+    return overrun_total;
+}
+
+bool imu_emul_low_power(void)
+{
+    return low_power;
+}
+
+uint32_t imu_emul_int_count(uint8_t cause)
+{
+    return cause < ARRAY_SIZE(int_counts) ? int_counts[cause] : 0;
+}
+
+/* ===== imu_fifo.h backend ===== */
+int imu_fifo_init(uint16_t odr_hz, uint16_t wm_bytes, imu_fifo_irq_cb_t cb)
+{
+    if (odr_hz == 0) {
+        return -EINVAL;
+    }
+    watermark = wm_bytes;
+    irq_cb = cb;
+    active_odr_hz = odr_hz;
+    odr_period = K_USEC(1000000 / odr_hz);
+    imu_fifo_flush();
+    imu_emul_set_running(true);
+    LOG_INF("Emulated BMI270 FIFO at %d Hz", odr_hz);
+    return 0;
+}
+
+int imu_fifo_level(uint16_t *bytes)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    *bytes = level_locked();
+    k_spin_unlock(&lock, key);
+    return 0;
+}
+
+int imu_fifo_read(uint8_t *buf, uint16_t len)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    uint16_t i = 0;
+
+    if (skipped && len >= 2) {
+        buf[i++] = IMU_FIFO_HDR_SKIP;
+        buf[i++] = MIN(skipped, UINT8_MAX);
+        skipped = 0;
+    }
+    /* Only whole frames are handed out; a cut frame stays in the FIFO, which
+     * matches the part re-sending partially read frames.
+     */
+    while (fifo_count && i + IMU_FIFO_FRAME_BYTES <= len) {
+        const struct emul_frame *f = &fifo[fifo_head];
+
+        buf[i++] = IMU_FIFO_HDR_ACC_GYR;
+        for (int ax = 0; ax < 3; ax++) {
+            sys_put_le16(f->gyr[ax], &buf[i + 2 * ax]);
+            sys_put_le16(f->acc[ax], &buf[i + 6 + 2 * ax]);
+        }
+        i += 12;
+        fifo_head = (fifo_head + 1) % EMUL_FIFO_FRAMES;
+        fifo_count--;
+    }
+    k_spin_unlock(&lock, key);
+
+    memset(&buf[i], IMU_FIFO_HDR_EMPTY, len - i);
+    return 0;
+}
+
+int imu_fifo_flush(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    fifo_head = 0;
+    fifo_count = 0;
+    skipped = 0;
+    k_spin_unlock(&lock, key);
+    return 0;
+}
+
+int imu_fifo_set_odr(uint16_t odr_hz, uint16_t wm_bytes)
+{
+    if (odr_hz == 0) {
+        return -EINVAL;
+    }
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    /* The part's feature engine runs on its own 50 Hz clock: the rate
+     * change must not restart the stillness count
+     */
+    quiet_frames = quiet_frames * odr_hz / active_odr_hz;
+    still_frames = MAX((uint32_t)still_secs * odr_hz, 1);
+    watermark = wm_bytes;
+    active_odr_hz = odr_hz;
+    k_spin_unlock(&lock, key);
+
+    odr_period = K_USEC(1000000 / odr_hz);
+    imu_fifo_flush();
+    if (running) {
+        k_timer_start(&odr_timer, odr_period, odr_period);
+    }
+    return 0;
+}
+
+int imu_fifo_motion_init(uint16_t thresh_mg, uint16_t still_s)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    motion_thr = (int32_t)thresh_mg * 16384 / 1000;
+    /* Counted in frames at the active ODR, rescaled when it changes */
+    still_secs = still_s;
+    still_frames = MAX((uint32_t)still_s * active_odr_hz, 1);
+    quiet_frames = 0;
+    prev = cur;
+    motion_enabled = true;
+    k_spin_unlock(&lock, key);
+    return 0;
+}
+
+int imu_fifo_int_status(uint8_t *causes)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    *causes = int_latched;
+    int_latched = 0;
+    k_spin_unlock(&lock, key);
+    return 0;
+}
+
+int imu_fifo_set_low_power(bool lp)
+{
+    low_power = lp;
+    if (!lp) {
+        return imu_fifo_flush();
+    }
+    return 0;
+}
@@ -0,0 +1,311 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "fusion.h"
+
+#if defined(CONFIG_NECK_FUSION_CMSIS_DSP)
+#include <arm_math.h>
+#endif
+
+#define RAD_TO_DEG      57.29578f
+
+/* Samples converted per chunk in fusion_update_batch() */
+#define BATCH_CHUNK     32
+
+void fusion_init(struct fusion *f, float beta, float gyr_scale)
+{
+    /* Start with +X along gravity, the neutral wearing position */
+    f->q[0] = 0.70710678f;
+    f->q[1] = 0.0f;
+    f->q[2] = -0.70710678f;
+    f->q[3] = 0.0f;
+    f->beta = beta;
+    f->gyr_scale = gyr_scale;
+}
+
+/* Shortest rotation taking the accel direction onto earth Z:
+ * q = (1 + az, ay, -ax, 0), normalised. Upside down (az = -1) any
+ * half turn about a horizontal axis does.
+ */
+bool fusion_seed(struct fusion *f, const int16_t acc[3])
+{
+    float ax = acc[0], ay = acc[1], az = acc[2];
+    float an = ax * ax + ay * ay + az * az;
+
+    if (an <= 0.0f) {
+        return false;
+    }
+
+    float r = 1.0f / sqrtf(an);
+    float q0 = 1.0f + az * r, q1 = ay * r, q2 = -ax * r;
+    float qn = q0 * q0 + q1 * q1 + q2 * q2;
+
+    if (qn < 1e-6f) {
+        q0 = 0.0f;
+        q1 = 1.0f;
+        q2 = 0.0f;
+        qn = 1.0f;
+    }
+    r = 1.0f / sqrtf(qn);
+    f->q[0] = q0 * r;
+    f->q[1] = q1 * r;
+    f->q[2] = q2 * r;
+    f->q[3] = 0.0f;
+    return true;
+}
+
+/* ===== Madgwick step on SI-scaled inputs =====
+ * gx..gz in rad/s, ax..az in any unit (normalised here), dt in seconds.
+ */
+static void madgwick_step(struct fusion *f, float gx, float gy, float gz,
+                          float ax, float ay, float az, float dt)
+{
+    float q0 = f->q[0], q1 = f->q[1], q2 = f->q[2], q3 = f->q[3];
+
+    /* Rate of change of quaternion from gyroscope */
+    float qd0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qd1 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float qd2 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float qd3 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    float an = ax * ax + ay * ay + az * az;
+
+    /* Gradient descent correction, skipped in free fall (no accel reference) */
+    if (an > 0.0f) {
+        float r = 1.0f / sqrtf(an);
+
+        ax *= r;
+        ay *= r;
+        az *= r;
+
+        float _2q0 = 2.0f * q0, _2q1 = 2.0f * q1, _2q2 = 2.0f * q2, _2q3 = 2.0f * q3;
+        float _4q0 = 4.0f * q0, _4q1 = 4.0f * q1, _4q2 = 4.0f * q2;
+        float _8q1 = 8.0f * q1, _8q2 = 8.0f * q2;
+        float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+
+        float s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+        float s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 +
+                   _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+        float s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 +
+                   _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+        float s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+        float sn = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+
+        if (sn > 0.0f) {
+            r = f->beta / sqrtf(sn);
+            qd0 -= r * s0;
+            qd1 -= r * s1;
+            qd2 -= r * s2;
+            qd3 -= r * s3;
+        }
+    }
+
+    q0 += qd0 * dt;
+    q1 += qd1 * dt;
+    q2 += qd2 * dt;
+    q3 += qd3 * dt;
+
+    float r = 1.0f / sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+
+    f->q[0] = q0 * r;
+    f->q[1] = q1 * r;
+    f->q[2] = q2 * r;
+    f->q[3] = q3 * r;
+}
+
+void fusion_update(struct fusion *f, const int16_t gyr[3], const int16_t acc[3], float dt)
+{
+    madgwick_step(f,
+                  (float)gyr[0] * f->gyr_scale,
+                  (float)gyr[1] * f->gyr_scale,
+                  (float)gyr[2] * f->gyr_scale,
+                  (float)acc[0], (float)acc[1], (float)acc[2], dt);
+}
+
+/* ===== Batch update =====
+ * Deinterleave the chunk into per-axis arrays, scale them in one pass each,
+ * then run the recursion over the converted samples, each over the time
+ * since the one before it.
+ */
+void fusion_update_batch(struct fusion *f, const struct imu_sample *s, size_t n,
+                         uint32_t prev_us, float max_dt)
+{
+    int16_t raw[6][BATCH_CHUNK];
+    float val[6][BATCH_CHUNK];
+    float dt[BATCH_CHUNK];
+
+    while (n > 0) {
+        size_t m = n < BATCH_CHUNK ? n : BATCH_CHUNK;
+
+        for (size_t i = 0; i < m; i++) {
+            for (int ax = 0; ax < 3; ax++) {
+                raw[ax][i] = s[i].gyr[ax];
+                raw[3 + ax][i] = s[i].acc[ax];
+            }
+            /* Timestamps wrap; out of order counts as no time at all */
+            int32_t d_us = (int32_t)(s[i].t_us - prev_us);
+
+            dt[i] = d_us > 0 ? (float)d_us * 1e-6f : 0.0f;
+            if (dt[i] > max_dt) {
+                dt[i] = max_dt;
+            }
+            prev_us = s[i].t_us;
+        }
+
+#if defined(CONFIG_NECK_FUSION_CMSIS_DSP)
+        /* q15 -> float divides by 32768; fold that back into the scale */
+        for (int ax = 0; ax < 6; ax++) {
+            arm_q15_to_float(raw[ax], val[ax], m);
+        }
+        for (int ax = 0; ax < 3; ax++) {
+            arm_scale_f32(val[ax], f->gyr_scale * 32768.0f, val[ax], m);
+        }
+#else
+        for (int ax = 0; ax < 3; ax++) {
+            for (size_t i = 0; i < m; i++) {
+                val[ax][i] = (float)raw[ax][i] * f->gyr_scale;
+                val[3 + ax][i] = (float)raw[3 + ax][i];
+            }
+        }
+#endif
+
+        for (size_t i = 0; i < m; i++) {
+            madgwick_step(f, val[0][i], val[1][i], val[2][i],
+                          val[3][i], val[4][i], val[5][i], dt[i]);
+        }
+
+        s += m;
+        n -= m;
+    }
+}
+
+/* Gravity ("up") direction in the sensor frame from the quaternion */
+static void angles_from_quat(float q0, float q1, float q2, float q3,
+                             struct fusion_angles *out)
+{
+    float gx = 2.0f * (q1 * q3 - q0 * q2);
+    float gy = 2.0f * (q0 * q1 + q2 * q3);
+    float gz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+
+    out->pitch_deg = atan2f(gz, gx) * RAD_TO_DEG;
+    out->roll_deg = atan2f(gy, sqrtf(gx * gx + gz * gz)) * RAD_TO_DEG;
+}
+
+void fusion_get_angles(const struct fusion *f, struct fusion_angles *out)
+{
+    angles_from_quat(f->q[0], f->q[1], f->q[2], f->q[3], out);
+}
+
+/* ===== Fixed-point variant (Q8.24) =====
+ * Same equations as madgwick_step(). Products are formed in 64 bits and
+ * shifted back; vector norms use an integer square root, so no FPU or
+ * soft-float call is needed on the update path.
+ */
+#define QMUL(a, b)      ((int32_t)(((int64_t)(a) * (b)) >> FUSION_Q_FRAC))
+
+static uint32_t isqrt64(uint64_t x)
+{
+    uint64_t res = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > x) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (x >= res + bit) {
+            x -= res + bit;
+            res = (res >> 1) + bit;
+        } else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)res;
+}
+
+/* Scale v[0..n-1] (any common Q format) to unit length in Q8.24 */
+static int normalize_q(int32_t *v, int n, int32_t *out)
+{
+    uint64_t ss = 0;
+
+    for (int i = 0; i < n; i++) {
+        ss += (uint64_t)((int64_t)v[i] * v[i]);
+    }
+    uint32_t norm = isqrt64(ss);
+
+    if (norm == 0) {
+        return -1;
+    }
+    for (int i = 0; i < n; i++) {
+        out[i] = (int32_t)(((int64_t)v[i] << FUSION_Q_FRAC) / norm);
+    }
+    return 0;
+}
+
+void fusion_q_init(struct fusion_q *f, int32_t beta, int32_t gyr_scale)
+{
+    f->q[0] = 11863283;     /* 0.70710678 */
+    f->q[1] = 0;
+    f->q[2] = -11863283;
+    f->q[3] = 0;
+    f->beta = beta;
+    f->gyr_scale = gyr_scale;
+}
+
+void fusion_q_update(struct fusion_q *f, const int16_t gyr[3], const int16_t acc[3], int32_t dt)
+{
+    int32_t q0 = f->q[0], q1 = f->q[1], q2 = f->q[2], q3 = f->q[3];
+    int32_t gx = gyr[0] * f->gyr_scale;
+    int32_t gy = gyr[1] * f->gyr_scale;
+    int32_t gz = gyr[2] * f->gyr_scale;
+
+    int32_t qd[4] = {
+        (-QMUL(q1, gx) - QMUL(q2, gy) - QMUL(q3, gz)) / 2,
+        (QMUL(q0, gx) + QMUL(q2, gz) - QMUL(q3, gy)) / 2,
+        (QMUL(q0, gy) - QMUL(q1, gz) + QMUL(q3, gx)) / 2,
+        (QMUL(q0, gz) + QMUL(q1, gy) - QMUL(q2, gx)) / 2,
+    };
+
+    int32_t a_raw[3] = { acc[0], acc[1], acc[2] };
+    int32_t a[3];
+
+    if (normalize_q(a_raw, 3, a) == 0) {
+        int32_t ax = a[0], ay = a[1], az = a[2];
+        int32_t q0q0 = QMUL(q0, q0), q1q1 = QMUL(q1, q1);
+        int32_t q2q2 = QMUL(q2, q2), q3q3 = QMUL(q3, q3);
+        int32_t s[4], sn[4];
+
+        s[0] = 4 * QMUL(q0, q2q2) + 2 * QMUL(q2, ax) + 4 * QMUL(q0, q1q1) - 2 * QMUL(q1, ay);
+        s[1] = 4 * QMUL(q1, q3q3) - 2 * QMUL(q3, ax) + 4 * QMUL(q0q0, q1) - 2 * QMUL(q0, ay) -
+               4 * q1 + 8 * QMUL(q1, q1q1) + 8 * QMUL(q1, q2q2) + 4 * QMUL(q1, az);
+        s[2] = 4 * QMUL(q0q0, q2) + 2 * QMUL(q0, ax) + 4 * QMUL(q2, q3q3) - 2 * QMUL(q3, ay) -
+               4 * q2 + 8 * QMUL(q2, q1q1) + 8 * QMUL(q2, q2q2) + 4 * QMUL(q2, az);
+        s[3] = 4 * QMUL(q1q1, q3) - 2 * QMUL(q1, ax) + 4 * QMUL(q2q2, q3) - 2 * QMUL(q2, ay);
+
+        if (normalize_q(s, 4, sn) == 0) {
+            for (int i = 0; i < 4; i++) {
+                qd[i] -= QMUL(f->beta, sn[i]);
+            }
+        }
+    }
+
+    int32_t qn[4] = {
+        q0 + QMUL(qd[0], dt),
+        q1 + QMUL(qd[1], dt),
+        q2 + QMUL(qd[2], dt),
+        q3 + QMUL(qd[3], dt),
+    };
+
+    normalize_q(qn, 4, f->q);
+}
+
+void fusion_q_get_angles(const struct fusion_q *f, struct fusion_angles *out)
+{
+    const float k = 1.0f / (float)FUSION_Q_ONE;
+
+    angles_from_quat(f->q[0] * k, f->q[1] * k, f->q[2] * k, f->q[3] * k, out);
+}
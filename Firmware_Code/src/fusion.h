@@ -0,0 +1,85 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef FUSION_H_
+#define FUSION_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "imu_sample.h"
+
+/* ===== Madgwick IMU fusion =====
+ *
+ * Orientation from raw BMI270 gyro/accel counts, single precision only (the
+ * M33 FPU has no double support). A Q8.24 fixed-point variant with the same
+ * update equations is provided for bit-exact, FPU-free runs.
+ *
+ * Angles assume the patch is worn with +X pointing up the neck:
+ *   pitch - forward/back tilt of X towards +Z (flexion positive)
+ *   roll  - sideways tilt of X towards +Y
+ * Both are 0 when X is aligned with gravity, so the neutral posture is far
+ * from the Euler singularity.
+ */
+
+#define FUSION_BETA_DEFAULT     0.1f
+
+/* rad/s per gyro count at +-500 dps */
+#define FUSION_GYR_RAD_PER_LSB  (0.017453293f / IMU_GYR_LSB_PER_DPS)
+
+struct fusion {
+    float q[4];             /* w, x, y, z */
+    float beta;
+    float gyr_scale;        /* rad/s per raw count */
+};
+
+struct fusion_angles {
+    float pitch_deg;
+    float roll_deg;
+};
+
+void fusion_init(struct fusion *f, float beta, float gyr_scale);
+
+/* Orientation straight from one accel reading (raw counts), heading zero,
+ * instead of converging on it from the neutral position at beta. False,
+ * and q untouched, for a zero vector.
+ */
+bool fusion_seed(struct fusion *f, const int16_t acc[3]);
+
+/* One step with raw counts; dt in seconds */
+void fusion_update(struct fusion *f, const int16_t gyr[3], const int16_t acc[3], float dt);
+
+/* A whole FIFO batch, every sample integrated over the time since the one
+ * before it (t_us; prev_us is the sample before s[0]), so the rate may
+ * change between or within batches. Steps longer than max_dt (samples
+ * flushed at a rate change, a burst lost) are cut to max_dt rather than
+ * extrapolating the gyro across the gap. The raw-to-float conversion is
+ * vectorised with CMSIS-DSP when CONFIG_NECK_FUSION_CMSIS_DSP is set; the
+ * filter recursion itself is inherently sequential.
+ */
+void fusion_update_batch(struct fusion *f, const struct imu_sample *s, size_t n,
+                         uint32_t prev_us, float max_dt);
+
+void fusion_get_angles(const struct fusion *f, struct fusion_angles *out);
+
+/* ===== Fixed-point variant (Q8.24) ===== */
+#define FUSION_Q_FRAC           24
+#define FUSION_Q_ONE            (1 << FUSION_Q_FRAC)
+
+struct fusion_q {
+    int32_t q[4];           /* w, x, y, z in Q8.24 */
+    int32_t beta;           /* Q8.24 */
+    int32_t gyr_scale;      /* rad/s per raw count, Q8.24 */
+};
+
+void fusion_q_init(struct fusion_q *f, int32_t beta, int32_t gyr_scale);
+
+/* dt in Q8.24 seconds */
+void fusion_q_update(struct fusion_q *f, const int16_t gyr[3], const int16_t acc[3], int32_t dt);
+
+/* Converted to float degrees for reporting only, not on the update path */
+void fusion_q_get_angles(const struct fusion_q *f, struct fusion_angles *out);
+
+#endif /* FUSION_H_ */
@@ -0,0 +1,107 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <errno.h>
+
+#include "haptic.h"
+#include "haptic_pwm.h"
+
+LOG_MODULE_REGISTER(haptic, LOG_LEVEL_INF);
+
+/* ===== Global Variables =====
+ * One sequence buffer: haptic_play() stops the PWM before recompiling, so
+ * EasyDMA never reads a buffer that is being rewritten.
+ */
+static uint16_t seq_buf[CONFIG_NECK_HAPTIC_SEQ_MAX];
+static atomic_t busy;
+static atomic_t cue_pattern;
+
+static void playback_done(void)
+{
+    atomic_set(&busy, 0);
+}
+
+int haptic_play(enum haptic_pattern p, bool repeat)
+{
+    struct haptic_seq seq = { .buf = seq_buf, .cap = ARRAY_SIZE(seq_buf) };
+    int err;
+
+    if ((unsigned int)p >= HAPTIC_PATTERN_COUNT) {
+        return -EINVAL;
+    }
+    haptic_stop();
+
+    err = haptic_compile(&haptic_waves[p], CONFIG_NECK_LRA_RESONANT_HZ, &seq);
+    if (err == -ENOSPC) {
+        /* Still playable, just cut short; raise CONFIG_NECK_HAPTIC_SEQ_MAX */
+        LOG_WRN("%s truncated to %u periods", haptic_waves[p].name, seq.len);
+    } else if (err) {
+        return err;
+    }
+
+    atomic_set(&busy, 1);
+    err = haptic_pwm_play(seq.buf, seq.len, seq.countertop, repeat);
+    if (err) {
+        atomic_set(&busy, 0);
+        LOG_ERR("%s playback failed (%d)", haptic_waves[p].name, err);
+    }
+    return err;
+}
+
+int haptic_play_by_name(const char *name, bool repeat)
+{
+    int p = haptic_pattern_by_name(name);
+
+    if (p < 0) {
+        return -ENOENT;
+    }
+    return haptic_play((enum haptic_pattern)p, repeat);
+}
+
+void haptic_stop(void)
+{
+    haptic_pwm_stop();
+    atomic_set(&busy, 0);
+}
+
+bool haptic_busy(void)
+{
+    return atomic_get(&busy) != 0;
+}
+
+int haptic_cue_select(enum haptic_pattern p)
+{
+    if ((unsigned int)p >= HAPTIC_PATTERN_COUNT) {
+        return -EINVAL;
+    }
+    atomic_set(&cue_pattern, p);
+    return 0;
+}
+
+enum haptic_pattern haptic_cue_pattern(void)
+{
+    return (enum haptic_pattern)atomic_get(&cue_pattern);
+}
+
+int haptic_init(void)
+{
+    int p = haptic_pattern_by_name(CONFIG_NECK_HAPTIC_CUE_PATTERN);
+    int err;
+
+    if (p < 0) {
+        LOG_ERR("Unknown cue pattern \"%s\"", CONFIG_NECK_HAPTIC_CUE_PATTERN);
+        return -EINVAL;
+    }
+    atomic_set(&cue_pattern, p);
+
+    err = haptic_pwm_init(playback_done);
+    if (err) {
+        return err;
+    }
+    LOG_INF("LRA at %d Hz, cue \"%s\"", CONFIG_NECK_LRA_RESONANT_HZ,
+            CONFIG_NECK_HAPTIC_CUE_PATTERN);
+    return 0;
+}
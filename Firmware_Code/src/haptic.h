@@ -0,0 +1,40 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HAPTIC_H_
+#define HAPTIC_H_
+
+#include <stdbool.h>
+
+#include "haptic_wave.h"
+
+/* ===== LRA haptic engine =====
+ *
+ * Starts named waveforms (haptic_wave.h) on the LRAs. A pattern is compiled
+ * once into a RAM sequence for CONFIG_NECK_LRA_RESONANT_HZ and then played
+ * entirely by PWM1 EasyDMA (haptic_pwm.h); the CPU is not involved again
+ * until the pattern ends or is stopped.
+ */
+
+int haptic_init(void);
+
+/* Stop whatever is playing and start pattern p; with repeat set it loops
+ * until haptic_stop()
+ */
+int haptic_play(enum haptic_pattern p, bool repeat);
+
+/* -ENOENT for an unknown name */
+int haptic_play_by_name(const char *name, bool repeat);
+
+void haptic_stop(void);
+
+bool haptic_busy(void);
+
+/* Pattern played for the posture cue; defaults to
+ * CONFIG_NECK_HAPTIC_CUE_PATTERN and can be changed at runtime
+ */
+int haptic_cue_select(enum haptic_pattern p);
+enum haptic_pattern haptic_cue_pattern(void);
+
+#endif /* HAPTIC_H_ */
@@ -0,0 +1,33 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HAPTIC_PWM_H_
+#define HAPTIC_PWM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== LRA sequence playback backend =====
+ *
+ * Plays a compiled haptic_seq (haptic_wave.h) on both LRA channels.
+ * src/hw/haptic_pwm_nrfx.c hands it to PWM1's EasyDMA, so no CPU is needed
+ * until the sequence ends; src/emul/haptic_pwm_emul.c models the timing on
+ * native_sim.
+ */
+
+/* Called from ISR context when a non-repeating playback has finished */
+typedef void (*haptic_pwm_done_cb_t)(void);
+
+int haptic_pwm_init(haptic_pwm_done_cb_t cb);
+
+/* Start playing len common-mode values with the given PWM countertop. With
+ * repeat set the sequence loops until haptic_pwm_stop(). seq must stay
+ * untouched until playback has stopped.
+ */
+int haptic_pwm_play(const uint16_t *seq, uint16_t len, uint16_t countertop, bool repeat);
+
+/* Stop playback and wait until the outputs are idle (driven off) */
+void haptic_pwm_stop(void);
+
+#endif /* HAPTIC_PWM_H_ */
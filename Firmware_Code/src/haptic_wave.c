@@ -0,0 +1,136 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "haptic_wave.h"
+
+/* ===== Waveform library ===== */
+#define SEG(ms, a, b)   { (ms), (a), (b) }
+#define WAVE(n, s)      { (n), (s), sizeof(s) / sizeof((s)[0]) }
+
+static const struct haptic_seg level_low[] = { SEG(300, 300, 300) };
+static const struct haptic_seg level_med[] = { SEG(300, 600, 600) };
+static const struct haptic_seg level_high[] = { SEG(300, 1000, 1000) };
+static const struct haptic_seg ramp_up[] = { SEG(600, 0, 1000) };
+static const struct haptic_seg ramp_down[] = { SEG(600, 1000, 0) };
+static const struct haptic_seg pulse_train[] = {
+    SEG(80, 1000, 1000), SEG(80, 0, 0),
+    SEG(80, 1000, 1000), SEG(80, 0, 0),
+    SEG(80, 1000, 1000), SEG(200, 0, 0),
+};
+static const struct haptic_seg double_tap[] = {
+    SEG(40, 1000, 1000), SEG(80, 0, 0), SEG(40, 1000, 1000), SEG(240, 0, 0),
+};
+/* Full-drive kick to get the mass moving in a couple of cycles, then a
+ * sustained level and a short ramp out to avoid a ringing stop
+ */
+static const struct haptic_seg resonant_burst[] = {
+    SEG(15, 1000, 1000), SEG(120, 700, 700), SEG(30, 700, 0),
+};
+
+const struct haptic_wave haptic_waves[HAPTIC_PATTERN_COUNT] = {
+    [HAPTIC_LEVEL_LOW] = WAVE("level_low", level_low),
+    [HAPTIC_LEVEL_MED] = WAVE("level_med", level_med),
+    [HAPTIC_LEVEL_HIGH] = WAVE("level_high", level_high),
+    [HAPTIC_RAMP_UP] = WAVE("ramp_up", ramp_up),
+    [HAPTIC_RAMP_DOWN] = WAVE("ramp_down", ramp_down),
+    [HAPTIC_PULSE_TRAIN] = WAVE("pulse_train", pulse_train),
+    [HAPTIC_DOUBLE_TAP] = WAVE("double_tap", double_tap),
+    [HAPTIC_RESONANT_BURST] = WAVE("resonant_burst", resonant_burst),
+};
+
+int haptic_pattern_by_name(const char *name)
+{
+    for (int i = 0; i < HAPTIC_PATTERN_COUNT; i++) {
+        if (strcmp(haptic_waves[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint32_t haptic_wave_duration_ms(const struct haptic_wave *w)
+{
+    uint32_t ms = 0;
+
+    for (int i = 0; i < w->nseg; i++) {
+        ms += w->seg[i].dur_ms;
+    }
+    return ms;
+}
+
+uint16_t haptic_wave_amp_at(const struct haptic_wave *w, uint32_t t_us)
+{
+    for (int i = 0; i < w->nseg; i++) {
+        const struct haptic_seg *s = &w->seg[i];
+        uint32_t dur_us = s->dur_ms * 1000U;
+
+        if (t_us < dur_us) {
+            int32_t span = (int32_t)s->to - (int32_t)s->from;
+
+            return (uint16_t)(s->from + (int32_t)((int64_t)span * t_us / dur_us));
+        }
+        t_us -= dur_us;
+    }
+    return 0;
+}
+
+/* ===== Amplitude linearisation =====
+ * duty (1/10000 of the period) = asin(amp) / pi, tabulated at amp = k/32
+ */
+#define ASIN_STEPS      32
+#define DUTY_SCALE      10000
+
+static const uint16_t asin_duty[ASIN_STEPS + 1] = {
+    0, 99, 199, 299, 399, 499, 600, 702, 804, 907, 1012,
+    1117, 1224, 1332, 1441, 1553, 1667, 1783, 1902, 2024, 2149, 2279,
+    2413, 2553, 2699, 2854, 3019, 3197, 3391, 3611, 3869, 4202, 5000,
+};
+
+uint16_t haptic_amp_to_compare(uint16_t amp, uint16_t countertop)
+{
+    if (amp >= HAPTIC_AMP_FULL) {
+        return countertop / 2;
+    }
+
+    /* Table index with a 1/HAPTIC_AMP_FULL remainder for interpolation */
+    uint32_t pos = (uint32_t)amp * ASIN_STEPS;
+    uint32_t k = pos / HAPTIC_AMP_FULL;
+    uint32_t frac = pos % HAPTIC_AMP_FULL;
+    uint64_t duty = (uint64_t)asin_duty[k] * HAPTIC_AMP_FULL +
+                    (uint64_t)(asin_duty[k + 1] - asin_duty[k]) * frac;
+    uint64_t scale = (uint64_t)DUTY_SCALE * HAPTIC_AMP_FULL;
+
+    return (uint16_t)((duty * countertop + scale / 2) / scale);
+}
+
+/* ===== Compiler ===== */
+int haptic_compile(const struct haptic_wave *w, uint16_t resonant_hz, struct haptic_seq *out)
+{
+    uint32_t n;
+
+    out->len = 0;
+    if (resonant_hz == 0 || HAPTIC_PWM_CLOCK_HZ / resonant_hz > 0x7FFF) {
+        return -EINVAL;
+    }
+    out->countertop = (uint16_t)(HAPTIC_PWM_CLOCK_HZ / resonant_hz);
+
+    /* Whole carrier periods that fit in the envelope */
+    n = haptic_wave_duration_ms(w) * resonant_hz / 1000U;
+
+    for (uint32_t i = 0; i < n; i++) {
+        if (i == out->cap) {
+            return -ENOSPC;
+        }
+        /* Envelope sampled at the middle of each carrier period */
+        uint32_t t_us = (uint32_t)((2ULL * i + 1) * 500000U / resonant_hz);
+        uint16_t amp = haptic_wave_amp_at(w, t_us);
+
+        out->buf[i] = HAPTIC_SEQ_POLARITY | haptic_amp_to_compare(amp, out->countertop);
+        out->len++;
+    }
+    return 0;
+}
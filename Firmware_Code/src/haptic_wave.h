@@ -0,0 +1,84 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HAPTIC_WAVE_H_
+#define HAPTIC_WAVE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== LRA waveform library and sequence compiler =====
+ *
+ * Waveforms are piecewise-linear amplitude envelopes on a carrier at the
+ * LRA's resonant frequency. haptic_compile() turns one into an nRF PWM
+ * sequence in common load mode: one 16-bit compare value per carrier
+ * period, played back by the PWM's EasyDMA without the CPU. Pure C, no
+ * Zephyr dependencies, so the same code is checked on the host by
+ * tools/haptic_check.
+ *
+ * The H-bridge is driven with a unipolar square wave at the carrier; its
+ * fundamental scales with sin(pi * duty), so amplitudes are mapped through
+ * asin() to make the envelope linear in vibration strength. Full amplitude
+ * is 50 % duty.
+ */
+
+#define HAPTIC_PWM_CLOCK_HZ     1000000     /* NRF_PWM_CLK_1MHz */
+#define HAPTIC_SEQ_POLARITY     0x8000      /* falling edge first: duty = high time */
+#define HAPTIC_AMP_FULL         1000        /* envelope amplitude, permille */
+
+enum haptic_pattern {
+    HAPTIC_LEVEL_LOW,
+    HAPTIC_LEVEL_MED,
+    HAPTIC_LEVEL_HIGH,
+    HAPTIC_RAMP_UP,
+    HAPTIC_RAMP_DOWN,
+    HAPTIC_PULSE_TRAIN,
+    HAPTIC_DOUBLE_TAP,
+    HAPTIC_RESONANT_BURST,
+    HAPTIC_PATTERN_COUNT,
+};
+
+/* Linear ramp from `from` to `to` (permille) over dur_ms */
+struct haptic_seg {
+    uint16_t dur_ms;
+    uint16_t from;
+    uint16_t to;
+};
+
+struct haptic_wave {
+    const char *name;
+    const struct haptic_seg *seg;
+    uint8_t nseg;
+};
+
+extern const struct haptic_wave haptic_waves[HAPTIC_PATTERN_COUNT];
+
+struct haptic_seq {
+    uint16_t *buf;          /* must be in RAM for EasyDMA */
+    uint16_t cap;
+    uint16_t len;           /* values written (= carrier periods) */
+    uint16_t countertop;    /* PWM period in HAPTIC_PWM_CLOCK_HZ ticks */
+};
+
+/* -1 if no waveform has that name */
+int haptic_pattern_by_name(const char *name);
+
+/* Total envelope length of a waveform */
+uint32_t haptic_wave_duration_ms(const struct haptic_wave *w);
+
+/* Envelope amplitude (permille) at t_us into the waveform */
+uint16_t haptic_wave_amp_at(const struct haptic_wave *w, uint32_t t_us);
+
+/* Amplitude (permille of full strength) -> PWM compare value, without the
+ * polarity bit
+ */
+uint16_t haptic_amp_to_compare(uint16_t amp, uint16_t countertop);
+
+/* Compile w for a carrier at resonant_hz into out->buf. Returns 0, -EINVAL
+ * for a bad carrier, or -ENOSPC if the sequence does not fit (out->len is
+ * then the truncated length).
+ */
+int haptic_compile(const struct haptic_wave *w, uint16_t resonant_hz, struct haptic_seq *out);
+
+#endif /* HAPTIC_WAVE_H_ */
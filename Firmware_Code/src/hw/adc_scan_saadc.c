@@ -0,0 +1,160 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/irq.h>
+#include <zephyr/logging/log.h>
+#include <nrfx_saadc.h>
+#include <nrfx_timer.h>
+#include <helpers/nrfx_gppi.h>
+#include <errno.h>
+
+#include "../adc_scan.h"
+
+LOG_MODULE_REGISTER(adc_scan, LOG_LEVEL_INF);
+
+/* ===== SAADC continuous scan =====
+ * The Zephyr ADC driver only does one-shot sequences, so the SAADC is driven
+ * through nrfx directly (CONFIG_ADC is off). TIMER2 compare triggers the
+ * SAMPLE task over DPPI; with burst enabled each SAMPLE runs the full
+ * oversampling on every channel, and EasyDMA writes one result per channel.
+ * start_on_end re-arms the second buffer in hardware, so the CPU only sees
+ * one interrupt per filled buffer.
+ *
+ * Channel inputs come from the &adc channel nodes in app.overlay.
+ */
+#define ADC_NODE        DT_NODELABEL(adc)
+#define CH_INPUT(n)     DT_PROP(DT_CHILD(ADC_NODE, channel_##n), zephyr_input_positive)
+#define BUF_SAMPLES     (CONFIG_NECK_ADC_SCANS_PER_BUFFER * ADC_SCAN_CHANNELS)
+
+static nrf_saadc_value_t bufs[2][BUF_SAMPLES];
+static const nrfx_timer_t timer = NRFX_TIMER_INSTANCE(2);
+static uint8_t next_buf;
+static adc_scan_done_cb_t done_cb;
+
+static void saadc_handler(const nrfx_saadc_evt_t *evt)
+{
+    switch (evt->type) {
+    case NRFX_SAADC_EVT_DONE:
+        if (done_cb) {
+            done_cb(evt->data.done.p_buffer, evt->data.done.size / ADC_SCAN_CHANNELS);
+        }
+        break;
+    case NRFX_SAADC_EVT_BUF_REQ:
+        /* Follows the DONE of the buffer being handed back; the other one
+         * is already filling
+         */
+        nrfx_saadc_buffer_set(bufs[next_buf], BUF_SAMPLES);
+        next_buf ^= 1;
+        break;
+    default:
+        break;
+    }
+}
+
+static void timer_handler(nrf_timer_event_t event, void *ctx)
+{
+    ARG_UNUSED(event);
+    ARG_UNUSED(ctx);
+}
+
+static int setup_timer(uint32_t rate_hz)
+{
+    nrfx_timer_config_t cfg = NRFX_TIMER_DEFAULT_CONFIG(1000000);
+    uint32_t eep, tep;
+    uint8_t ppi;
+
+    cfg.bit_width = NRF_TIMER_BIT_WIDTH_32;
+    if (nrfx_timer_init(&timer, &cfg, timer_handler) != NRFX_SUCCESS) {
+        return -EIO;
+    }
+    nrfx_timer_extended_compare(&timer, NRF_TIMER_CC_CHANNEL0,
+                                nrfx_timer_us_to_ticks(&timer, 1000000 / rate_hz),
+                                NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK, false);
+
+    if (nrfx_gppi_channel_alloc(&ppi) != NRFX_SUCCESS) {
+        return -EBUSY;
+    }
+    eep = nrfx_timer_compare_event_address_get(&timer, NRF_TIMER_CC_CHANNEL0);
+    tep = nrf_saadc_task_address_get(NRF_SAADC, NRF_SAADC_TASK_SAMPLE);
+    nrfx_gppi_channel_endpoints_setup(ppi, eep, tep);
+    nrfx_gppi_channels_enable(BIT(ppi));
+    return 0;
+}
+
+/* ===== adc_scan.h backend ===== */
+int adc_scan_start(uint32_t rate_hz, uint8_t oversample_log2, adc_scan_done_cb_t cb)
+{
+    nrfx_saadc_channel_t channels[ADC_SCAN_CHANNELS] = {
+        NRFX_SAADC_DEFAULT_CHANNEL_SE(CH_INPUT(0), 0),
+        NRFX_SAADC_DEFAULT_CHANNEL_SE(CH_INPUT(1), 1),
+    };
+    nrfx_saadc_adv_config_t adv = NRFX_SAADC_DEFAULT_ADV_CONFIG;
+    int rc;
+
+    if (rate_hz == 0) {
+        return -EINVAL;
+    }
+    done_cb = cb;
+
+    IRQ_CONNECT(DT_IRQN(ADC_NODE), DT_IRQ(ADC_NODE, priority),
+                nrfx_isr, nrfx_saadc_irq_handler, 0);
+
+    if (nrfx_saadc_init(DT_IRQ(ADC_NODE, priority)) != NRFX_SUCCESS) {
+        LOG_ERR("SAADC init failed");
+        return -EIO;
+    }
+    if (nrfx_saadc_offset_calibrate(NULL) != NRFX_SUCCESS) {
+        LOG_WRN("SAADC offset calibration failed");
+    }
+
+    /* Same front end as the devicetree channels: gain 1/6, 0.6 V reference */
+    for (int i = 0; i < ADC_SCAN_CHANNELS; i++) {
+        channels[i].channel_config.gain = NRF_SAADC_GAIN1_6;
+        channels[i].channel_config.reference = NRF_SAADC_REFERENCE_INTERNAL;
+        channels[i].channel_config.burst = oversample_log2 ? NRF_SAADC_BURST_ENABLED
+                                                           : NRF_SAADC_BURST_DISABLED;
+    }
+    if (nrfx_saadc_channels_config(channels, ADC_SCAN_CHANNELS) != NRFX_SUCCESS) {
+        LOG_ERR("SAADC channel config failed");
+        return -EINVAL;
+    }
+
+    adv.oversampling = (nrf_saadc_oversample_t)oversample_log2;
+    adv.internal_timer_cc = 0;      /* sampled by TIMER2 over DPPI */
+    adv.start_on_end = true;
+    if (nrfx_saadc_advanced_mode_set(BIT(0) | BIT(1), NRF_SAADC_RESOLUTION_12BIT,
+                                     &adv, saadc_handler) != NRFX_SUCCESS) {
+        LOG_ERR("SAADC advanced mode failed");
+        return -EINVAL;
+    }
+
+    nrfx_saadc_buffer_set(bufs[0], BUF_SAMPLES);
+    nrfx_saadc_buffer_set(bufs[1], BUF_SAMPLES);
+    next_buf = 0;
+
+    rc = setup_timer(rate_hz);
+    if (rc) {
+        LOG_ERR("SAADC trigger timer setup failed (%d)", rc);
+        return rc;
+    }
+
+    if (nrfx_saadc_mode_trigger() != NRFX_SUCCESS) {
+        LOG_ERR("SAADC start failed");
+        return -EIO;
+    }
+    nrfx_timer_enable(&timer);
+    return 0;
+}
+
+void adc_scan_pause(bool paused)
+{
+    /* Without the trigger the SAADC stays idle; no CPU or DMA activity */
+    if (paused) {
+        nrfx_timer_disable(&timer);
+    } else {
+        nrfx_timer_enable(&timer);
+    }
+}
@@ -0,0 +1,125 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/pinctrl.h>
+#include <zephyr/irq.h>
+#include <zephyr/logging/log.h>
+#include <nrfx_pwm.h>
+#include <errno.h>
+
+#include "../haptic_pwm.h"
+
+LOG_MODULE_REGISTER(haptic_pwm, LOG_LEVEL_INF);
+
+/* ===== PWM1 sequence playback =====
+ * The Zephyr PWM driver only sets a fixed duty, so PWM1 is disabled in the
+ * devicetree and driven through nrfx here. Its pinctrl (P1.05/P1.07,
+ * inverted) is still taken from app.overlay. Sequences are played in common
+ * load mode, one compare value per PWM period for both LRA outputs; the
+ * peripheral fetches them with EasyDMA.
+ */
+#define PWM1_NODE   DT_NODELABEL(pwm1)
+
+PINCTRL_DT_DEFINE(PWM1_NODE);
+
+static const nrfx_pwm_t pwm = NRFX_PWM_INSTANCE(1);
+static haptic_pwm_done_cb_t done_cb;
+static bool initialised;
+static uint16_t cur_countertop;
+
+static void pwm_handler(nrfx_pwm_evt_type_t event, void *ctx)
+{
+    ARG_UNUSED(ctx);
+
+    if (event == NRFX_PWM_EVT_STOPPED && done_cb) {
+        done_cb();
+    }
+}
+
+static int configure(uint16_t countertop)
+{
+    nrfx_pwm_config_t cfg = {
+        .output_pins = {
+            NRF_PWM_PIN_NOT_CONNECTED, NRF_PWM_PIN_NOT_CONNECTED,
+            NRF_PWM_PIN_NOT_CONNECTED, NRF_PWM_PIN_NOT_CONNECTED,
+        },
+        .irq_priority = DT_IRQ(PWM1_NODE, priority),
+        .base_clock = NRF_PWM_CLK_1MHz,
+        .count_mode = NRF_PWM_MODE_UP,
+        .top_value = countertop,
+        .load_mode = NRF_PWM_LOAD_COMMON,
+        .step_mode = NRF_PWM_STEP_AUTO,
+        .skip_gpio_cfg = true,
+        .skip_psel_cfg = true,
+    };
+
+    if (initialised) {
+        nrfx_pwm_uninit(&pwm);
+        initialised = false;
+    }
+    if (nrfx_pwm_init(&pwm, &cfg, pwm_handler, NULL) != NRFX_SUCCESS) {
+        return -EIO;
+    }
+    initialised = true;
+    cur_countertop = countertop;
+    return 0;
+}
+
+/* ===== haptic_pwm.h backend ===== */
+int haptic_pwm_init(haptic_pwm_done_cb_t cb)
+{
+    int err;
+
+    done_cb = cb;
+    IRQ_CONNECT(DT_IRQN(PWM1_NODE), DT_IRQ(PWM1_NODE, priority),
+                nrfx_isr, nrfx_pwm_1_irq_handler, 0);
+
+    err = pinctrl_apply_state(PINCTRL_DT_DEV_CONFIG_GET(PWM1_NODE), PINCTRL_STATE_DEFAULT);
+    if (err < 0) {
+        LOG_ERR("PWM1 pinctrl failed (%d)", err);
+        return err;
+    }
+    return 0;
+}
+
+int haptic_pwm_play(const uint16_t *seq, uint16_t len, uint16_t countertop, bool repeat)
+{
+    static nrf_pwm_sequence_t pwm_seq;
+    int err;
+
+    if (len == 0) {
+        return -EINVAL;
+    }
+    haptic_pwm_stop();
+
+    /* COUNTERTOP is fixed at init in nrfx; re-init when the carrier moves */
+    if (!initialised || cur_countertop != countertop) {
+        err = configure(countertop);
+        if (err) {
+            LOG_ERR("PWM1 init failed (%d)", err);
+            return err;
+        }
+    }
+
+    pwm_seq = (nrf_pwm_sequence_t){
+        .values.p_common = seq,
+        .length = len,
+        .repeats = 0,
+        .end_delay = 0,
+    };
+    if (nrfx_pwm_simple_playback(&pwm, &pwm_seq, 1,
+                                 repeat ? NRFX_PWM_FLAG_LOOP : NRFX_PWM_FLAG_STOP) != NRFX_SUCCESS) {
+        return -EIO;
+    }
+    return 0;
+}
+
+void haptic_pwm_stop(void)
+{
+    if (initialised) {
+        nrfx_pwm_stop(&pwm, true);
+    }
+}
@@ -0,0 +1,359 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <errno.h>
+
+#include "../imu_fifo.h"
+
+LOG_MODULE_REGISTER(imu_fifo, LOG_LEVEL_INF);
+
+/* ===== BMI270 Registers used for the FIFO path =====
+ * The Zephyr driver still owns the init sequence (config file upload) and
+ * the ODR/range attributes; the FIFO and interrupt routing are not exposed
+ * by the sensor API, so they are programmed directly here.
+ */
+#define BMI270_REG_INT_STATUS_0     0x1C
+#define BMI270_REG_INT_STATUS_1     0x1D
+#define BMI270_REG_FIFO_LENGTH_0    0x24
+#define BMI270_REG_FIFO_DATA        0x26
+#define BMI270_REG_FEAT_PAGE        0x2F
+#define BMI270_REG_FEATURES         0x30
+#define BMI270_REG_ACC_CONF         0x40
+#define BMI270_REG_FIFO_WTM_0       0x46
+#define BMI270_REG_FIFO_CONFIG_0    0x48
+#define BMI270_REG_FIFO_CONFIG_1    0x49
+#define BMI270_REG_INT1_IO_CTRL     0x53
+#define BMI270_REG_INT1_MAP_FEAT    0x56
+#define BMI270_REG_INT_MAP_DATA     0x58
+#define BMI270_REG_PWR_CONF         0x7C
+#define BMI270_REG_PWR_CTRL         0x7D
+#define BMI270_REG_CMD              0x7E
+
+#define BMI270_FIFO_TIME_EN         BIT(1)
+#define BMI270_FIFO_HEADER_EN       BIT(4)
+#define BMI270_FIFO_ACC_EN          BIT(6)
+#define BMI270_FIFO_GYR_EN          BIT(7)
+#define BMI270_INT_OUTPUT_EN        BIT(3)
+#define BMI270_INT_ACTIVE_HIGH      BIT(1)
+#define BMI270_INT_FFULL_INT1       BIT(0)
+#define BMI270_INT_FWM_INT1         BIT(1)
+#define BMI270_CMD_FIFO_FLUSH       0xB0
+#define BMI270_FIFO_LENGTH_MASK     0x3FFF
+
+/* Feature interrupts: same bit in INT1_MAP_FEAT and INT_STATUS_0 */
+#define BMI270_FEAT_NO_MOTION       BIT(5)
+#define BMI270_FEAT_ANY_MOTION      BIT(6)
+#define BMI270_STATUS1_FWM          BIT(1)
+#define BMI270_STATUS1_FFULL        BIT(0)
+
+/* Feature configuration (config file features, 16-bit little-endian words):
+ * any-motion at page 1 offset 0x0C, no-motion at page 2 offset 0x00, each
+ *   word 0: duration [12:0] in 20 ms steps, select x/y/z [15:13]
+ *   word 1: threshold [10:0] in 1/2048 g, enable [15]
+ */
+#define BMI270_ANY_MOTION_PAGE      1
+#define BMI270_ANY_MOTION_OFFSET    0x0C
+#define BMI270_NO_MOTION_PAGE       2
+#define BMI270_NO_MOTION_OFFSET     0x00
+#define BMI270_MOTION_XYZ           (BIT(13) | BIT(14) | BIT(15))
+#define BMI270_MOTION_EN            BIT(15)
+#define BMI270_MOTION_DUR_MAX       0x1FFF
+#define BMI270_MOTION_THR_MAX       0x7FF
+
+/* Low power: 50 Hz, 4-sample averaging, power-optimised filter */
+#define BMI270_ACC_CONF_LP          (0x07 | (0x02 << 4))
+#define BMI270_PWR_CONF_APS         BIT(0)
+#define BMI270_PWR_CTRL_ACC_EN      BIT(2)
+#define BMI270_APS_WRITE_DELAY_US   450
+
+#define BMI270_NODE DT_NODELABEL(bmi270)
+
+static const struct device *const bmi270 = DEVICE_DT_GET(BMI270_NODE);
+static const struct i2c_dt_spec bus = I2C_DT_SPEC_GET(BMI270_NODE);
+static const struct gpio_dt_spec int1 = GPIO_DT_SPEC_GET(BMI270_NODE, irq_gpios);
+
+static struct gpio_callback int1_cb_data;
+static imu_fifo_irq_cb_t irq_cb;
+static uint16_t active_odr_hz;
+
+static void int1_isr(const struct device *port, struct gpio_callback *cb,
+                     gpio_port_pins_t pins)
+{
+    ARG_UNUSED(port);
+    ARG_UNUSED(cb);
+    ARG_UNUSED(pins);
+
+    if (irq_cb) {
+        irq_cb();
+    }
+}
+
+/* ===== Sensor attributes (same settings the polling loop used) ===== */
+static int set_odr(uint16_t odr_hz)
+{
+    struct sensor_value full_scale, sampling_freq, oversampling;
+    int rc;
+
+    /* Setting scale in G, due to loss of precision if the SI unit m/s^2
+     * is used
+     */
+    full_scale.val1 = 2;            /* G */
+    full_scale.val2 = 0;
+    sampling_freq.val1 = odr_hz;    /* Hz. Performance mode */
+    sampling_freq.val2 = 0;
+    oversampling.val1 = 1;          /* Normal mode */
+    oversampling.val2 = 0;
+
+    rc = sensor_attr_set(bmi270, SENSOR_CHAN_ACCEL_XYZ, SENSOR_ATTR_FULL_SCALE, &full_scale);
+    if (rc) { LOG_ERR("Accel FULL_SCALE set failed (%d)", rc); return rc; }
+    rc = sensor_attr_set(bmi270, SENSOR_CHAN_ACCEL_XYZ, SENSOR_ATTR_OVERSAMPLING, &oversampling);
+    if (rc) { LOG_ERR("Accel OVERSAMPLING set failed (%d)", rc); return rc; }
+    /* Set sampling frequency last as this also sets the appropriate
+     * power mode.
+     */
+    rc = sensor_attr_set(bmi270, SENSOR_CHAN_ACCEL_XYZ, SENSOR_ATTR_SAMPLING_FREQUENCY, &sampling_freq);
+    if (rc) { LOG_ERR("Accel SAMPLING_FREQUENCY set failed (%d)", rc); return rc; }
+
+    /* Setting scale in degrees/s to match the sensor scale */
+    full_scale.val1 = 500;          /* dps */
+    full_scale.val2 = 0;
+
+    rc = sensor_attr_set(bmi270, SENSOR_CHAN_GYRO_XYZ, SENSOR_ATTR_FULL_SCALE, &full_scale);
+    if (rc) { LOG_ERR("Gyro FULL_SCALE set failed (%d)", rc); return rc; }
+    rc = sensor_attr_set(bmi270, SENSOR_CHAN_GYRO_XYZ, SENSOR_ATTR_OVERSAMPLING, &oversampling);
+    if (rc) { LOG_ERR("Gyro OVERSAMPLING set failed (%d)", rc); return rc; }
+    rc = sensor_attr_set(bmi270, SENSOR_CHAN_GYRO_XYZ, SENSOR_ATTR_SAMPLING_FREQUENCY, &sampling_freq);
+    if (rc) { LOG_ERR("Gyro SAMPLING_FREQUENCY set failed (%d)", rc); return rc; }
+
+    return 0;
+}
+
+int imu_fifo_init(uint16_t odr_hz, uint16_t wm_bytes, imu_fifo_irq_cb_t cb)
+{
+    uint8_t wtm[2];
+    int err;
+
+    if (!device_is_ready(bmi270)) {
+        LOG_ERR("Device %s is not ready", bmi270->name);
+        return -ENODEV;
+    }
+    if (!gpio_is_ready_dt(&int1)) {
+        LOG_ERR("BMI270 INT1 GPIO not ready");
+        return -ENODEV;
+    }
+
+    err = set_odr(odr_hz);
+    if (err < 0) {
+        return err;
+    }
+    active_odr_hz = odr_hz;
+
+    sys_put_le16(wm_bytes, wtm);
+    err = i2c_burst_write_dt(&bus, BMI270_REG_FIFO_WTM_0, wtm, sizeof(wtm));
+    if (err == 0) {
+        err = i2c_reg_write_byte_dt(&bus, BMI270_REG_FIFO_CONFIG_0, BMI270_FIFO_TIME_EN);
+    }
+    if (err == 0) {
+        err = i2c_reg_write_byte_dt(&bus, BMI270_REG_FIFO_CONFIG_1,
+                                    BMI270_FIFO_HEADER_EN | BMI270_FIFO_ACC_EN |
+                                    BMI270_FIFO_GYR_EN);
+    }
+    if (err == 0) {
+        err = i2c_reg_write_byte_dt(&bus, BMI270_REG_INT1_IO_CTRL,
+                                    BMI270_INT_OUTPUT_EN | BMI270_INT_ACTIVE_HIGH);
+    }
+    if (err == 0) {
+        err = i2c_reg_write_byte_dt(&bus, BMI270_REG_INT_MAP_DATA,
+                                    BMI270_INT_FWM_INT1 | BMI270_INT_FFULL_INT1);
+    }
+    if (err < 0) {
+        LOG_ERR("BMI270 FIFO configuration failed (%d)", err);
+        return err;
+    }
+
+    irq_cb = cb;
+    err = gpio_pin_configure_dt(&int1, GPIO_INPUT);
+    if (err == 0) {
+        gpio_init_callback(&int1_cb_data, int1_isr, BIT(int1.pin));
+        err = gpio_add_callback(int1.port, &int1_cb_data);
+    }
+    if (err == 0) {
+        err = gpio_pin_interrupt_configure_dt(&int1, GPIO_INT_EDGE_TO_ACTIVE);
+    }
+    if (err < 0) {
+        LOG_ERR("BMI270 INT1 setup failed (%d)", err);
+        return err;
+    }
+
+    return imu_fifo_flush();
+}
+
+int imu_fifo_level(uint16_t *bytes)
+{
+    uint8_t raw[2];
+    int err = i2c_burst_read_dt(&bus, BMI270_REG_FIFO_LENGTH_0, raw, sizeof(raw));
+
+    if (err < 0) {
+        return err;
+    }
+    *bytes = sys_get_le16(raw) & BMI270_FIFO_LENGTH_MASK;
+    return 0;
+}
+
+int imu_fifo_read(uint8_t *buf, uint16_t len)
+{
+    return i2c_burst_read_dt(&bus, BMI270_REG_FIFO_DATA, buf, len);
+}
+
+int imu_fifo_flush(void)
+{
+    return i2c_reg_write_byte_dt(&bus, BMI270_REG_CMD, BMI270_CMD_FIFO_FLUSH);
+}
+
+int imu_fifo_set_odr(uint16_t odr_hz, uint16_t wm_bytes)
+{
+    uint8_t wtm[2];
+    int err;
+
+    /* No watermark edge while accel and gyro briefly run at different
+     * rates (single-sensor frames) or the watermark is stale
+     */
+    err = i2c_reg_write_byte_dt(&bus, BMI270_REG_INT_MAP_DATA, 0);
+    if (err == 0) {
+        err = set_odr(odr_hz);
+    }
+    if (err == 0) {
+        active_odr_hz = odr_hz;
+        sys_put_le16(wm_bytes, wtm);
+        err = i2c_burst_write_dt(&bus, BMI270_REG_FIFO_WTM_0, wtm, sizeof(wtm));
+    }
+    if (err == 0) {
+        err = imu_fifo_flush();
+    }
+    /* Unmasked even after a failure, so acquisition does not stall */
+    int rc = i2c_reg_write_byte_dt(&bus, BMI270_REG_INT_MAP_DATA,
+                                   BMI270_INT_FWM_INT1 | BMI270_INT_FFULL_INT1);
+
+    if (err == 0) {
+        err = rc;
+    }
+    if (err < 0) {
+        LOG_ERR("BMI270 rate change to %d Hz failed (%d)", odr_hz, err);
+    }
+    return err;
+}
+
+/* ===== Motion features and power modes ===== */
+static int write_feature(uint8_t page, uint8_t offset, uint16_t w0, uint16_t w1)
+{
+    uint8_t buf[4];
+    int err;
+
+    sys_put_le16(w0, &buf[0]);
+    sys_put_le16(w1, &buf[2]);
+    err = i2c_reg_write_byte_dt(&bus, BMI270_REG_FEAT_PAGE, page);
+    if (err == 0) {
+        err = i2c_burst_write_dt(&bus, BMI270_REG_FEATURES + offset, buf, sizeof(buf));
+    }
+    return err;
+}
+
+int imu_fifo_motion_init(uint16_t thresh_mg, uint16_t still_s)
+{
+    uint16_t thr = MIN((uint32_t)thresh_mg * 2048 / 1000, BMI270_MOTION_THR_MAX);
+    uint16_t dur = MIN((uint32_t)still_s * 50, BMI270_MOTION_DUR_MAX);
+    int err;
+
+    /* Any-motion reacts to the first slope over the threshold (one 20 ms
+     * step); no-motion needs the full stillness time
+     */
+    err = write_feature(BMI270_ANY_MOTION_PAGE, BMI270_ANY_MOTION_OFFSET,
+                        BMI270_MOTION_XYZ | 1, BMI270_MOTION_EN | thr);
+    if (err == 0) {
+        err = write_feature(BMI270_NO_MOTION_PAGE, BMI270_NO_MOTION_OFFSET,
+                            BMI270_MOTION_XYZ | dur, BMI270_MOTION_EN | thr);
+    }
+    if (err == 0) {
+        err = i2c_reg_write_byte_dt(&bus, BMI270_REG_INT1_MAP_FEAT,
+                                    BMI270_FEAT_ANY_MOTION | BMI270_FEAT_NO_MOTION);
+    }
+    if (err < 0) {
+        LOG_ERR("BMI270 motion feature setup failed (%d)", err);
+    }
+    return err;
+}
+
+int imu_fifo_int_status(uint8_t *causes)
+{
+    uint8_t st[2];
+    int err = i2c_burst_read_dt(&bus, BMI270_REG_INT_STATUS_0, st, sizeof(st));
+
+    if (err < 0) {
+        return err;
+    }
+    *causes = ((st[1] & (BMI270_STATUS1_FWM | BMI270_STATUS1_FFULL)) ? IMU_INT_FIFO : 0) |
+              ((st[0] & BMI270_FEAT_ANY_MOTION) ? IMU_INT_ANY_MOTION : 0) |
+              ((st[0] & BMI270_FEAT_NO_MOTION) ? IMU_INT_NO_MOTION : 0);
+    return 0;
+}
+
+int imu_fifo_set_low_power(bool low_power)
+{
+    int err;
+
+    if (low_power) {
+        /* FIFO off first so no watermark edge races the mode change */
+        err = i2c_reg_write_byte_dt(&bus, BMI270_REG_INT_MAP_DATA, 0);
+        if (err == 0) {
+            err = i2c_reg_write_byte_dt(&bus, BMI270_REG_FIFO_CONFIG_1, 0);
+        }
+        if (err == 0) {
+            err = i2c_reg_write_byte_dt(&bus, BMI270_REG_PWR_CTRL, BMI270_PWR_CTRL_ACC_EN);
+        }
+        if (err == 0) {
+            err = i2c_reg_write_byte_dt(&bus, BMI270_REG_ACC_CONF, BMI270_ACC_CONF_LP);
+        }
+        if (err == 0) {
+            err = i2c_reg_write_byte_dt(&bus, BMI270_REG_PWR_CONF, BMI270_PWR_CONF_APS);
+        }
+        if (err < 0) {
+            LOG_ERR("BMI270 low-power entry failed (%d)", err);
+        }
+        return err;
+    }
+
+    /* With advanced power save on, the part needs time after a write
+     * before it takes the next one
+     */
+    err = i2c_reg_write_byte_dt(&bus, BMI270_REG_PWR_CONF, 0);
+    k_busy_wait(BMI270_APS_WRITE_DELAY_US);
+    if (err == 0) {
+        /* Through the driver, which also restores PWR_CTRL */
+        err = set_odr(active_odr_hz);
+    }
+    if (err == 0) {
+        err = i2c_reg_write_byte_dt(&bus, BMI270_REG_FIFO_CONFIG_1,
+                                    BMI270_FIFO_HEADER_EN | BMI270_FIFO_ACC_EN |
+                                    BMI270_FIFO_GYR_EN);
+    }
+    if (err == 0) {
+        err = imu_fifo_flush();
+    }
+    if (err == 0) {
+        err = i2c_reg_write_byte_dt(&bus, BMI270_REG_INT_MAP_DATA,
+                                    BMI270_INT_FWM_INT1 | BMI270_INT_FFULL_INT1);
+    }
+    if (err < 0) {
+        LOG_ERR("BMI270 low-power exit failed (%d)", err);
+    }
+    return err;
+}
@@ -0,0 +1,469 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <errno.h>
+#include <string.h>
+
+#include "imu_acq.h"
+#include "imu_fifo.h"
+#include "imu_odr.h"
+#include "spsc_ring.h"
+#include "pipeline.h"
+#include "prof.h"
+
+LOG_MODULE_REGISTER(imu_acq, LOG_LEVEL_INF);
+
+/* ===== Acquisition Configuration ===== */
+#define WM_FRAMES       CONFIG_NECK_IMU_FIFO_WATERMARK
+#define WM_BYTES        (WM_FRAMES * IMU_FIFO_FRAME_BYTES)
+#define PERIOD_US       (1000000U / CONFIG_NECK_IMU_ODR_HZ)
+
+/* The watermark follows the rate, so a batch spans the same time (and the
+ * control latency stays put) at every rate
+ */
+#define WM_FOR(hz)      MAX((WM_FRAMES * (hz) + CONFIG_NECK_IMU_ODR_HZ / 2) / \
+                            CONFIG_NECK_IMU_ODR_HZ, 1)
+
+#if defined(CONFIG_NECK_IMU_ODR_ADAPTIVE)
+#define WM_FRAMES_MAX   MAX(WM_FOR(CONFIG_NECK_IMU_ODR_HIGH_HZ), WM_FRAMES)
+#else
+#define WM_FRAMES_MAX   WM_FRAMES
+#endif
+
+/* Room for two watermarks of frames plus the trailing sensortime frame, so a
+ * late wakeup still drains in a single burst.
+ */
+#define BURST_MAX       MIN(2 * WM_FRAMES_MAX * IMU_FIFO_FRAME_BYTES + 4, IMU_FIFO_SIZE_BYTES)
+
+/* ===== Global Variables ===== */
+SPSC_RING_DEFINE(sample_ring, struct imu_sample, CONFIG_NECK_IMU_RING_SIZE);
+
+static K_SEM_DEFINE(fifo_irq_sem, 0, 1);
+static K_SEM_DEFINE(batch_sem, 0, 1);
+static uint8_t burst_buf[BURST_MAX];
+static struct imu_acq_stats stats;
+
+/* Current rate; acquisition thread only */
+static uint32_t period_us = PERIOD_US;
+static uint32_t wm_frames = WM_FRAMES;
+
+static struct imu_clock clock;
+static uint32_t burst_energy;       /* largest since the last rate decision */
+
+#if defined(CONFIG_NECK_IMU_ODR_ADAPTIVE)
+static struct imu_odr odr;
+static struct k_spinlock odr_lock;
+#endif
+
+static struct imu_pm pm;
+static struct k_spinlock pm_lock;
+static atomic_t cur_mode = ATOMIC_INIT(IMU_PM_ACTIVE);
+static atomic_t hold_req;
+static imu_acq_mode_cb_t mode_cb;
+
+static void imu_acq_thread(void *p1, void *p2, void *p3);
+
+K_THREAD_DEFINE(imu_acq_tid, CONFIG_NECK_IMU_ACQ_STACK_SIZE,
+                imu_acq_thread, NULL, NULL, NULL,
+                CONFIG_NECK_IMU_ACQ_THREAD_PRIO, 0, K_TICKS_FOREVER);
+
+static void fifo_irq_handler(void)
+{
+    k_sem_give(&fifo_irq_sem);
+}
+
+/* ===== FIFO Parsing ===== */
+/* Total length of the frame starting with hdr, or 0 if hdr ends the data */
+static size_t frame_len(uint8_t hdr)
+{
+    switch (hdr) {
+    case IMU_FIFO_HDR_ACC_GYR:
+        return IMU_FIFO_FRAME_BYTES;
+    case IMU_FIFO_HDR_ACC:
+    case IMU_FIFO_HDR_GYR:
+        return 7;
+    case IMU_FIFO_HDR_SKIP:
+    case IMU_FIFO_HDR_DROP:
+        return 2;
+    case IMU_FIFO_HDR_SENSORTIME:
+        return 4;
+    case IMU_FIFO_HDR_CONFIG:
+        return 5;
+    default:
+        return 0;
+    }
+}
+
+/* Walk a header-mode burst and push every accel+gyro frame into the ring,
+ * one period of the current rate apart. level is the FIFO level the burst
+ * was read at: frames still queued behind the burst are newer than it.
+ */
+static void parse_burst(const uint8_t *buf, size_t len, size_t level, uint32_t t_drain_us)
+{
+    size_t n_frames = 0;
+    size_t used = 0;
+    size_t i = 0;
+    size_t flen;
+    bool lost = false;
+
+    for (i = 0; i < len && (flen = frame_len(buf[i])) != 0; i += flen) {
+        if (i + flen > len) {
+            break;
+        }
+        used = i + flen;
+        if (buf[i] == IMU_FIFO_HDR_ACC_GYR) {
+            n_frames++;
+        } else if (buf[i] == IMU_FIFO_HDR_SKIP) {
+            lost = true;
+        }
+    }
+    if (n_frames == 0) {
+        return;
+    }
+
+    uint32_t behind = level > used ? (level - used) / IMU_FIFO_FRAME_BYTES : 0;
+    uint32_t newest = imu_clock_newest(&clock, n_frames, period_us,
+                                       t_drain_us - behind * period_us, lost);
+    size_t k = 0;
+
+    for (i = 0; i < len; i += flen) {
+        uint8_t hdr = buf[i];
+
+        flen = frame_len(hdr);
+        if (flen == 0) {
+            if (hdr != IMU_FIFO_HDR_EMPTY) {
+                stats.parse_errors++;
+            }
+            break;
+        }
+        if (i + flen > len) {
+            /* Frame cut by the end of the burst; re-read next time */
+            break;
+        }
+
+        if (hdr == IMU_FIFO_HDR_ACC_GYR) {
+            const uint8_t *p = &buf[i + 1];
+            struct imu_sample s;
+
+            s.t_us = newest - (uint32_t)(n_frames - 1 - k) * period_us;
+            for (int ax = 0; ax < 3; ax++) {
+                s.gyr[ax] = (int16_t)sys_get_le16(&p[2 * ax]);
+                s.acc[ax] = (int16_t)sys_get_le16(&p[6 + 2 * ax]);
+            }
+            burst_energy = MAX(burst_energy, imu_odr_energy(&s, 1));
+            spsc_ring_put(&sample_ring, &s);
+            stats.frames++;
+            k++;
+        } else if (hdr == IMU_FIFO_HDR_SKIP) {
+            stats.fifo_overruns += buf[i + 1];
+        }
+        /* Single-sensor, drop, config and sensortime frames carry nothing
+         * the pipeline needs: a rate change flushes the FIFO.
+         */
+    }
+}
+
+/* ===== FIFO Drain: one level read + one burst ===== */
+static int drain_fifo(void)
+{
+    uint16_t level;
+    int err = imu_fifo_level(&level);
+
+    if (err < 0) {
+        stats.bus_errors++;
+        return err;
+    }
+    if (level == 0) {
+        return 0;
+    }
+
+    /* +4 picks up the sensortime frame appended once the FIFO runs empty */
+    uint16_t len = MIN((size_t)level + 4, sizeof(burst_buf));
+    uint32_t t_drain = pipeline_now_us();
+    uint32_t lost = stats.fifo_overruns + stats.ring_drops;
+
+    PROF_START(PROF_IMU_DRAIN);
+    err = imu_fifo_read(burst_buf, len);
+    if (err < 0) {
+        stats.bus_errors++;
+        LOG_ERR("FIFO burst read failed (%d)", err);
+        return err;
+    }
+    stats.bursts++;
+
+    parse_burst(burst_buf, len, level, t_drain);
+    PROF_STOP(PROF_IMU_DRAIN);
+    stats.ring_drops = spsc_ring_drops(&sample_ring);
+    k_sem_give(&batch_sem);
+
+    pipeline_stage_record(STAGE_ACQ, pipeline_now_us() - t_drain);
+    pipeline_stage_overrun(STAGE_ACQ, stats.fifo_overruns + stats.ring_drops - lost);
+
+    return level > len ? 1 : 0;
+}
+
+/* ===== Power modes ===== */
+#if defined(CONFIG_NECK_IMU_PM)
+static void apply_mode(enum imu_pm_mode mode)
+{
+    if (mode == IMU_PM_LOW_POWER) {
+        /* Hand the last frames to control before the FIFO is switched off */
+        while (drain_fifo() > 0) {
+        }
+    }
+    if (imu_fifo_set_low_power(mode == IMU_PM_LOW_POWER) < 0) {
+        stats.bus_errors++;
+    }
+    /* Back from low power with an empty FIFO: the sample clock restarts */
+    imu_clock_restart(&clock);
+    atomic_set(&cur_mode, mode);
+    if (mode_cb) {
+        mode_cb(mode);
+    }
+}
+
+/* Feed the latched motion causes and the hold request to the mode machine */
+static void pm_update(uint8_t causes)
+{
+    uint32_t now = k_uptime_get_32();
+    bool hold = atomic_get(&hold_req) != 0;
+    enum imu_pm_mode prev = atomic_get(&cur_mode);
+    enum imu_pm_mode mode = prev;
+    k_spinlock_key_t key = k_spin_lock(&pm_lock);
+
+    if (hold != pm.held) {
+        mode = imu_pm_event(&pm, hold ? IMU_PM_EV_HOLD : IMU_PM_EV_RELEASE, now);
+    }
+    /* No-motion first: if both are latched the wearer moved last */
+    if (causes & IMU_INT_NO_MOTION) {
+        mode = imu_pm_event(&pm, IMU_PM_EV_NO_MOTION, now);
+    }
+    if (causes & IMU_INT_ANY_MOTION) {
+        mode = imu_pm_event(&pm, IMU_PM_EV_ANY_MOTION, now);
+    }
+    k_spin_unlock(&pm_lock, key);
+
+    if (mode != prev) {
+        apply_mode(mode);
+    }
+}
+#endif
+
+/* ===== Adaptive rate ===== */
+#if defined(CONFIG_NECK_IMU_ODR_ADAPTIVE)
+static int apply_rate(enum imu_odr_level level)
+{
+    uint16_t hz = odr.p.hz[level];
+    uint32_t wm = WM_FOR(hz);
+
+    /* Frames already in the FIFO keep the old period: hand them over
+     * first, the switch flushes whatever comes in meanwhile
+     */
+    while (drain_fifo() > 0) {
+    }
+    int err = imu_fifo_set_odr(hz, wm * IMU_FIFO_FRAME_BYTES);
+
+    imu_clock_restart(&clock);
+    if (err < 0) {
+        stats.bus_errors++;
+        return err;
+    }
+    period_us = 1000000U / hz;
+    wm_frames = wm;
+    stats.odr_hz = hz;
+    LOG_DBG("%d Hz, watermark %d", hz, (int)wm);
+    return 0;
+}
+
+/* Once per wakeup that drained something, on the largest motion seen */
+static void odr_update(void)
+{
+    uint32_t now = k_uptime_get_32();
+    k_spinlock_key_t key = k_spin_lock(&odr_lock);
+    enum imu_odr_level prev = odr.level;
+    enum imu_odr_level level = imu_odr_step(&odr, burst_energy, now);
+
+    k_spin_unlock(&odr_lock, key);
+    burst_energy = 0;
+
+    /* A failed switch leaves the machine where the IMU is believed to be;
+     * the next burst asks again
+     */
+    if (level != prev && apply_rate(level) < 0) {
+        key = k_spin_lock(&odr_lock);
+        imu_odr_set(&odr, prev, now);
+        k_spin_unlock(&odr_lock, key);
+    }
+}
+#endif
+
+static void imu_acq_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    while (1) {
+        bool low_power = atomic_get(&cur_mode) == IMU_PM_LOW_POWER;
+
+        /* In low power only a motion edge wakes the thread, so the kernel
+         * can stay in tickless idle
+         */
+        /* Fallback poll in case an edge is missed: two batch periods */
+        int rc = k_sem_take(&fifo_irq_sem,
+                            low_power ? K_FOREVER : K_USEC(2 * wm_frames * period_us));
+
+        stats.wakeups++;
+
+#if defined(CONFIG_NECK_IMU_PM)
+        uint8_t causes = 0;
+
+        /* INT1 is shared, so an edge needs the status read to tell why */
+        if (rc == 0 && imu_fifo_int_status(&causes) < 0) {
+            stats.bus_errors++;
+        }
+        pm_update(causes);
+#else
+        ARG_UNUSED(rc);
+#endif
+
+        /* Keep draining while more than one burst is pending */
+        if (atomic_get(&cur_mode) == IMU_PM_ACTIVE) {
+            uint32_t bursts = stats.bursts;
+
+            while (drain_fifo() > 0) {
+            }
+#if defined(CONFIG_NECK_IMU_ODR_ADAPTIVE)
+            if (stats.bursts != bursts) {
+                odr_update();
+            }
+#else
+            ARG_UNUSED(bursts);
+#endif
+        }
+    }
+}
+
+int imu_acq_init(void)
+{
+    int err = imu_fifo_init(CONFIG_NECK_IMU_ODR_HZ, WM_BYTES, fifo_irq_handler);
+
+    if (err < 0) {
+        LOG_ERR("imu_fifo_init failed (%d)", err);
+        return err;
+    }
+
+#if defined(CONFIG_NECK_IMU_PM)
+    const struct imu_pm_params pm_params = {
+        .mode_ua = {
+            [IMU_PM_ACTIVE] = CONFIG_NECK_IMU_PM_ACTIVE_UA,
+            [IMU_PM_LOW_POWER] = CONFIG_NECK_IMU_PM_LOW_POWER_UA,
+        },
+    };
+
+    imu_pm_init(&pm, &pm_params, k_uptime_get_32());
+    err = imu_fifo_motion_init(CONFIG_NECK_IMU_PM_MOTION_MG, CONFIG_NECK_IMU_PM_STILL_S);
+    if (err < 0) {
+        LOG_ERR("imu_fifo_motion_init failed (%d)", err);
+        return err;
+    }
+#endif
+
+#if defined(CONFIG_NECK_IMU_ODR_ADAPTIVE)
+    BUILD_ASSERT(CONFIG_NECK_IMU_ODR_LOW_HZ < CONFIG_NECK_IMU_ODR_HZ &&
+                 CONFIG_NECK_IMU_ODR_HZ < CONFIG_NECK_IMU_ODR_HIGH_HZ,
+                 "adaptive IMU rates must be LOW < NECK_IMU_ODR_HZ < HIGH");
+    const struct imu_odr_params odr_params = {
+        .hz = {
+            [IMU_ODR_LOW] = CONFIG_NECK_IMU_ODR_LOW_HZ,
+            [IMU_ODR_MID] = CONFIG_NECK_IMU_ODR_HZ,
+            [IMU_ODR_HIGH] = CONFIG_NECK_IMU_ODR_HIGH_HZ,
+        },
+        .up_dps = {
+            [IMU_ODR_MID] = CONFIG_NECK_IMU_ODR_MID_DPS,
+            [IMU_ODR_HIGH] = CONFIG_NECK_IMU_ODR_HIGH_DPS,
+        },
+        .hold_ms = CONFIG_NECK_IMU_ODR_HOLD_MS,
+    };
+
+    imu_odr_init(&odr, &odr_params, k_uptime_get_32());
+#endif
+    stats.odr_hz = CONFIG_NECK_IMU_ODR_HZ;
+
+    /* A drain must finish before the next batch is due */
+    pipeline_stage_init(STAGE_ACQ, WM_FRAMES * PERIOD_US);
+    k_thread_start(imu_acq_tid);
+    LOG_INF("IMU FIFO acquisition: %d Hz, watermark %d frames (%d bytes)",
+            CONFIG_NECK_IMU_ODR_HZ, WM_FRAMES, WM_BYTES);
+#if defined(CONFIG_NECK_IMU_ODR_ADAPTIVE)
+    LOG_INF("Adaptive rate %d/%d/%d Hz", CONFIG_NECK_IMU_ODR_LOW_HZ, CONFIG_NECK_IMU_ODR_HZ,
+            CONFIG_NECK_IMU_ODR_HIGH_HZ);
+#endif
+    return 0;
+}
+
+int imu_acq_wait(k_timeout_t timeout)
+{
+    return k_sem_take(&batch_sem, timeout);
+}
+
+bool imu_acq_get(struct imu_sample *out)
+{
+    return spsc_ring_get(&sample_ring, out);
+}
+
+size_t imu_acq_read(struct imu_sample *out, size_t max)
+{
+    size_t n = 0;
+
+    while (n < max && spsc_ring_get(&sample_ring, &out[n])) {
+        n++;
+    }
+    return n;
+}
+
+void imu_acq_stats_get(struct imu_acq_stats *out)
+{
+    *out = stats;
+}
+
+void imu_acq_odr_stats_get(struct imu_odr_stats *out)
+{
+#if defined(CONFIG_NECK_IMU_ODR_ADAPTIVE)
+    k_spinlock_key_t key = k_spin_lock(&odr_lock);
+
+    imu_odr_stats(&odr, k_uptime_get_32(), out);
+    k_spin_unlock(&odr_lock, key);
+#else
+    memset(out, 0, sizeof(*out));
+    out->level_ms[IMU_ODR_MID] = k_uptime_get();
+    out->avg_hz = CONFIG_NECK_IMU_ODR_HZ;
+#endif
+}
+
+void imu_acq_set_mode_cb(imu_acq_mode_cb_t cb)
+{
+    mode_cb = cb;
+}
+
+void imu_acq_hold_active(bool hold)
+{
+    atomic_set(&hold_req, hold);
+}
+
+enum imu_pm_mode imu_acq_mode(void)
+{
+    return (enum imu_pm_mode)atomic_get(&cur_mode);
+}
+
+void imu_acq_pm_stats_get(struct imu_pm_stats *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&pm_lock);
+
+    imu_pm_stats(&pm, k_uptime_get_32(), out);
+    k_spin_unlock(&pm_lock, key);
+}
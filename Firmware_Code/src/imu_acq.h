@@ -0,0 +1,97 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef IMU_ACQ_H_
+#define IMU_ACQ_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/sensor.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "imu_sample.h"
+#include "imu_pm.h"
+#include "imu_odr.h"
+
+struct imu_acq_stats {
+    uint32_t wakeups;       /* acquisition thread wakeups */
+    uint32_t bursts;        /* FIFO burst reads issued */
+    uint32_t frames;        /* accel+gyro frames parsed */
+    uint32_t fifo_overruns; /* frames lost inside the BMI270 (skip frames) */
+    uint32_t ring_drops;    /* frames lost because the sample ring was full */
+    uint32_t bus_errors;
+    uint32_t parse_errors;
+    uint16_t odr_hz;        /* accel/gyro rate now */
+};
+
+/* Configure the FIFO and start the acquisition thread */
+int imu_acq_init(void);
+
+/* Block until at least one new batch has been pushed, or timeout */
+int imu_acq_wait(k_timeout_t timeout);
+
+/* Pop the oldest sample from the ring (single consumer) */
+bool imu_acq_get(struct imu_sample *out);
+
+/* Pop up to max samples, oldest first; returns how many. One wait can
+ * stand for several drains, and a late drain pushes up to two watermarks
+ * at the highest rate: read until this returns less than max.
+ */
+size_t imu_acq_read(struct imu_sample *out, size_t max);
+
+void imu_acq_stats_get(struct imu_acq_stats *out);
+
+/* Time at each rate (CONFIG_NECK_IMU_ODR_ADAPTIVE; fixed-rate builds report
+ * all of it at CONFIG_NECK_IMU_ODR_HZ). Low power counts towards the rate
+ * the IMU returns to.
+ */
+void imu_acq_odr_stats_get(struct imu_odr_stats *out);
+
+/* ===== Power modes (CONFIG_NECK_IMU_PM) =====
+ * After CONFIG_NECK_IMU_PM_STILL_S without motion the BMI270 drops to
+ * low power and no batches arrive until it moves again.
+ */
+typedef void (*imu_acq_mode_cb_t)(enum imu_pm_mode mode);
+
+/* Called on the acquisition thread after every mode change; set before
+ * imu_acq_init()
+ */
+void imu_acq_set_mode_cb(imu_acq_mode_cb_t cb);
+
+/* Keep the IMU active regardless of motion (e.g. while a cue runs) */
+void imu_acq_hold_active(bool hold);
+
+enum imu_pm_mode imu_acq_mode(void);
+
+void imu_acq_pm_stats_get(struct imu_pm_stats *out);
+
+static inline float imu_acc_to_ms2(int16_t raw)
+{
+    return (float)raw * (9.80665f / (float)IMU_ACC_LSB_PER_G);
+}
+
+static inline float imu_gyr_to_rads(int16_t raw)
+{
+    return (float)raw * (0.017453293f / IMU_GYR_LSB_PER_DPS);
+}
+
+/* Integer-only conversion to the sensor_value format used for logging */
+static inline void imu_acc_to_sensor_value(int16_t raw, struct sensor_value *val)
+{
+    int64_t micro = (int64_t)raw * 9806650LL / IMU_ACC_LSB_PER_G;
+
+    val->val1 = (int32_t)(micro / 1000000);
+    val->val2 = (int32_t)(micro % 1000000);
+}
+
+static inline void imu_gyr_to_sensor_value(int16_t raw, struct sensor_value *val)
+{
+    /* 500 dps full scale -> 8726646 urad/s over 32768 counts */
+    int64_t micro = (int64_t)raw * 8726646LL / 32768;
+
+    val->val1 = (int32_t)(micro / 1000000);
+    val->val2 = (int32_t)(micro % 1000000);
+}
+
+#endif /* IMU_ACQ_H_ */
@@ -0,0 +1,79 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef IMU_FIFO_H_
+#define IMU_FIFO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== BMI270 FIFO backend =====
+ *
+ * Low-level access to the BMI270 FIFO in header mode, plus the any-motion /
+ * no-motion features and the low-power switch used when the wearer is still.
+ * FIFO and motion interrupts share INT1. There is one
+ * implementation per build: src/hw/imu_fifo_bmi270.c talks to the real part
+ * over I2C, src/emul/imu_fifo_emul.c models it in software for native_sim.
+ */
+
+/* FIFO frame headers (header mode) */
+#define IMU_FIFO_HDR_ACC_GYR    0x8C
+#define IMU_FIFO_HDR_GYR        0x88
+#define IMU_FIFO_HDR_ACC        0x84
+#define IMU_FIFO_HDR_SKIP       0x40
+#define IMU_FIFO_HDR_SENSORTIME 0x44
+#define IMU_FIFO_HDR_CONFIG     0x48
+#define IMU_FIFO_HDR_DROP       0x50
+#define IMU_FIFO_HDR_EMPTY      0x80
+
+#define IMU_FIFO_FRAME_BYTES    13      /* header + gyr xyz + acc xyz */
+#define IMU_FIFO_SIZE_BYTES     6144
+
+/* Interrupt causes, see imu_fifo_int_status() */
+#define IMU_INT_FIFO            0x01    /* watermark or full */
+#define IMU_INT_ANY_MOTION      0x02
+#define IMU_INT_NO_MOTION       0x04
+
+/* Accel rate in low-power mode; the motion features run at 50 Hz */
+#define IMU_LP_ODR_HZ           50
+
+typedef void (*imu_fifo_irq_cb_t)(void);
+
+/* Configure the sensor for odr_hz, enable accel+gyro FIFO in header mode,
+ * program the watermark and route the watermark/full interrupt to cb.
+ * cb may be called from ISR context.
+ */
+int imu_fifo_init(uint16_t odr_hz, uint16_t wm_bytes, imu_fifo_irq_cb_t cb);
+
+/* Current FIFO fill level in bytes */
+int imu_fifo_level(uint16_t *bytes);
+
+/* Burst read len bytes from the FIFO data register */
+int imu_fifo_read(uint8_t *buf, uint16_t len);
+
+/* Discard everything in the FIFO */
+int imu_fifo_flush(void);
+
+/* Enable any-motion (slope over thresh_mg on any axis) and no-motion (below
+ * thresh_mg for still_s seconds) on INT1, in both power modes
+ */
+int imu_fifo_motion_init(uint16_t thresh_mg, uint16_t still_s);
+
+/* Read and clear the latched interrupt causes (IMU_INT_*) */
+int imu_fifo_int_status(uint8_t *causes);
+
+/* Change the accel+gyro rate and the watermark while running. The FIFO
+ * interrupt is masked meanwhile and the FIFO flushed afterwards, so every
+ * frame read later was sampled at odr_hz; drain it first. Low power exits
+ * to this rate from then on.
+ */
+int imu_fifo_set_odr(uint16_t odr_hz, uint16_t wm_bytes);
+
+/* low_power: gyro off, accel at IMU_LP_ODR_HZ with averaging and advanced
+ * power save, FIFO and its interrupt off. Otherwise back to the
+ * imu_fifo_init() configuration with an empty FIFO.
+ */
+int imu_fifo_set_low_power(bool low_power);
+
+#endif /* IMU_FIFO_H_ */
@@ -0,0 +1,104 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "imu_odr.h"
+
+void imu_odr_init(struct imu_odr *o, const struct imu_odr_params *params, uint32_t t_ms)
+{
+    memset(o, 0, sizeof(*o));
+    o->p = *params;
+    for (int l = 0; l < IMU_ODR_LEVEL_COUNT; l++) {
+        o->up_counts[l] = (uint32_t)(params->up_dps[l] * IMU_GYR_LSB_PER_DPS);
+    }
+    o->level = IMU_ODR_MID;
+    o->t_level_ms = t_ms;
+}
+
+uint32_t imu_odr_energy(const struct imu_sample *s, size_t n)
+{
+    uint32_t max = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        uint32_t e = (uint32_t)abs(s[i].gyr[0]) + (uint32_t)abs(s[i].gyr[1]) +
+                     (uint32_t)abs(s[i].gyr[2]);
+
+        if (e > max) {
+            max = e;
+        }
+    }
+    return max;
+}
+
+void imu_odr_set(struct imu_odr *o, enum imu_odr_level level, uint32_t t_ms)
+{
+    o->calm = false;
+    if (level == o->level) {
+        return;
+    }
+    o->st.level_ms[o->level] += t_ms - o->t_level_ms;
+    o->t_level_ms = t_ms;
+    o->st.changes++;
+    o->level = level;
+}
+
+enum imu_odr_level imu_odr_step(struct imu_odr *o, uint32_t energy, uint32_t t_ms)
+{
+    enum imu_odr_level want = o->level;
+
+    /* Up: straight to the highest level the burst reaches */
+    for (int l = IMU_ODR_LEVEL_COUNT - 1; l > (int)o->level; l--) {
+        if (energy >= o->up_counts[l]) {
+            want = (enum imu_odr_level)l;
+            break;
+        }
+    }
+    if (want != o->level) {
+        imu_odr_set(o, want, t_ms);
+        return o->level;
+    }
+
+    /* Down: one level after hold_ms of calm bursts */
+    if (o->level == IMU_ODR_LOW || energy >= o->up_counts[o->level] / 2) {
+        o->calm = false;
+    } else if (!o->calm) {
+        o->calm = true;
+        o->calm_ms = t_ms;
+    } else if (t_ms - o->calm_ms >= o->p.hold_ms) {
+        imu_odr_set(o, (enum imu_odr_level)(o->level - 1), t_ms);
+    }
+    return o->level;
+}
+
+void imu_odr_stats(const struct imu_odr *o, uint32_t t_ms, struct imu_odr_stats *out)
+{
+    uint64_t total = 0, hz_ms = 0;
+
+    *out = o->st;
+    out->level_ms[o->level] += t_ms - o->t_level_ms;
+    for (int l = 0; l < IMU_ODR_LEVEL_COUNT; l++) {
+        total += out->level_ms[l];
+        hz_ms += out->level_ms[l] * o->p.hz[l];
+    }
+    out->avg_hz = total ? (uint32_t)(hz_ms / total) : o->p.hz[o->level];
+}
+
+uint32_t imu_clock_newest(struct imu_clock *c, size_t n, uint32_t period_us,
+                          uint32_t t_drain_us, bool lost)
+{
+    uint32_t newest = c->last_us + (uint32_t)n * period_us;
+    int32_t err = (int32_t)(t_drain_us - newest);
+
+    if (!c->synced || lost || err > 2 * (int32_t)period_us || err < -2 * (int32_t)period_us) {
+        newest = t_drain_us;
+    } else {
+        newest += err / 8;
+    }
+    c->last_us = newest;
+    c->synced = true;
+    return newest;
+}
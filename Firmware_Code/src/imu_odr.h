@@ -0,0 +1,102 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef IMU_ODR_H_
+#define IMU_ODR_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "imu_sample.h"
+
+/* ===== Adaptive IMU output data rate =====
+ *
+ * Pure computation, no Zephyr dependencies; driven by imu_acq.c once per
+ * FIFO burst and checked on the host by tools/odr_check.
+ *
+ * Motion energy is the largest gyro L1 norm (|x| + |y| + |z|) of a burst:
+ * a held posture stays near the gyro noise floor, turning or nodding the
+ * head is tens to hundreds of dps. Three rates,
+ *
+ *   LOW   holding a posture
+ *   MID   small movements, the fixed-rate configuration
+ *   HIGH  head movement
+ *
+ * A burst whose energy reaches up_dps of a higher level switches to it at
+ * once. Going down is one level at a time, after hold_ms with every burst
+ * below half the current level's up_dps. Accel and gyro always share the
+ * rate.
+ */
+
+enum imu_odr_level {
+    IMU_ODR_LOW,
+    IMU_ODR_MID,
+    IMU_ODR_HIGH,
+    IMU_ODR_LEVEL_COUNT,
+};
+
+struct imu_odr_params {
+    uint16_t hz[IMU_ODR_LEVEL_COUNT];
+    uint16_t up_dps[IMU_ODR_LEVEL_COUNT];   /* up_dps[IMU_ODR_LOW] unused */
+    uint32_t hold_ms;
+};
+
+struct imu_odr_stats {
+    uint64_t level_ms[IMU_ODR_LEVEL_COUNT];
+    uint32_t changes;
+    uint32_t avg_hz;            /* time-weighted since init */
+};
+
+struct imu_odr {
+    struct imu_odr_params p;
+    uint32_t up_counts[IMU_ODR_LEVEL_COUNT];    /* up_dps in raw L1 counts */
+    enum imu_odr_level level;
+    bool calm;                  /* below the down threshold since calm_ms */
+    uint32_t calm_ms;
+    uint32_t t_level_ms;
+    struct imu_odr_stats st;
+};
+
+void imu_odr_init(struct imu_odr *o, const struct imu_odr_params *params, uint32_t t_ms);
+
+/* Motion energy of a burst, in raw gyro counts */
+uint32_t imu_odr_energy(const struct imu_sample *s, size_t n);
+
+/* One burst at t_ms (timestamps may wrap). Returns the level the IMU must
+ * run at afterwards.
+ */
+enum imu_odr_level imu_odr_step(struct imu_odr *o, uint32_t energy, uint32_t t_ms);
+
+/* Force a level (the rate could not be changed, or the IMU restarts) */
+void imu_odr_set(struct imu_odr *o, enum imu_odr_level level, uint32_t t_ms);
+
+/* Counters including the time spent at the current level up to t_ms */
+void imu_odr_stats(const struct imu_odr *o, uint32_t t_ms, struct imu_odr_stats *out);
+
+/* ===== Sample clock =====
+ * Timestamps for FIFO frames, which carry none: the frames of a burst are
+ * one period apart and continue the previous burst. The drain time only
+ * steers that clock slowly (wakeup latency varies from burst to burst, the
+ * sensor's period does not). After a restart (flush, rate change, low
+ * power), frames lost or a jump of more than two periods it starts over
+ * from the drain time.
+ */
+struct imu_clock {
+    uint32_t last_us;           /* newest frame stamped */
+    bool synced;
+};
+
+static inline void imu_clock_restart(struct imu_clock *c)
+{
+    c->synced = false;
+}
+
+/* Timestamp of the newest of n >= 1 frames drained at t_drain_us; frame
+ * k of the burst is at the result - (n - 1 - k) * period_us
+ */
+uint32_t imu_clock_newest(struct imu_clock *c, size_t n, uint32_t period_us,
+                          uint32_t t_drain_us, bool lost);
+
+#endif /* IMU_ODR_H_ */
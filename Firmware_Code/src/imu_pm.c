@@ -0,0 +1,67 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include "imu_pm.h"
+
+void imu_pm_init(struct imu_pm *pm, const struct imu_pm_params *params, uint32_t t_ms)
+{
+    memset(pm, 0, sizeof(*pm));
+    pm->p = *params;
+    pm->mode = IMU_PM_ACTIVE;
+    pm->t_mode_ms = t_ms;
+    pm->t_init_ms = t_ms;
+}
+
+static void enter(struct imu_pm *pm, enum imu_pm_mode mode, uint32_t t_ms)
+{
+    pm->st.mode_ms[pm->mode] += t_ms - pm->t_mode_ms;
+    pm->t_mode_ms = t_ms;
+    if (mode == IMU_PM_LOW_POWER) {
+        pm->st.sleeps++;
+    } else {
+        pm->st.wakeups++;
+    }
+    pm->mode = mode;
+}
+
+enum imu_pm_mode imu_pm_event(struct imu_pm *pm, enum imu_pm_event ev, uint32_t t_ms)
+{
+    switch (ev) {
+    case IMU_PM_EV_NO_MOTION:
+        pm->still = true;
+        break;
+    case IMU_PM_EV_ANY_MOTION:
+        pm->still = false;
+        break;
+    case IMU_PM_EV_HOLD:
+        pm->held = true;
+        break;
+    case IMU_PM_EV_RELEASE:
+        pm->held = false;
+        break;
+    }
+
+    if (pm->mode == IMU_PM_ACTIVE && pm->still && !pm->held) {
+        enter(pm, IMU_PM_LOW_POWER, t_ms);
+    } else if (pm->mode == IMU_PM_LOW_POWER && (!pm->still || pm->held)) {
+        enter(pm, IMU_PM_ACTIVE, t_ms);
+    }
+    return pm->mode;
+}
+
+void imu_pm_stats(const struct imu_pm *pm, uint32_t t_ms, struct imu_pm_stats *out)
+{
+    uint64_t total = 0, ua_ms = 0;
+
+    *out = pm->st;
+    out->mode_ms[pm->mode] += t_ms - pm->t_mode_ms;
+    for (int m = 0; m < IMU_PM_MODE_COUNT; m++) {
+        total += out->mode_ms[m];
+        ua_ms += out->mode_ms[m] * pm->p.mode_ua[m];
+    }
+    out->avg_ua = total ? (uint32_t)(ua_ms / total) : pm->p.mode_ua[pm->mode];
+    out->charge_uah = ua_ms / 3600000u;
+}
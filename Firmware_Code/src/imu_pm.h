@@ -0,0 +1,69 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef IMU_PM_H_
+#define IMU_PM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== IMU power mode state machine =====
+ *
+ * Pure computation, no Zephyr dependencies; driven by imu_acq.c from the
+ * BMI270 motion interrupts and checked on the host by tools/pm_check.
+ *
+ *   ACTIVE --no-motion (still for N s), not held--> LOW_POWER
+ *   LOW_POWER --any-motion--> ACTIVE (counted as a wakeup)
+ *
+ * A hold (the posture cue is running) keeps the IMU active; releasing it
+ * while the wearer is still drops to low power at once. The time spent in
+ * each mode is integrated into an estimated average current.
+ */
+
+enum imu_pm_mode {
+    IMU_PM_ACTIVE,          /* accel + gyro at the full ODR, FIFO batching */
+    IMU_PM_LOW_POWER,       /* accel only, low-power ODR, motion IRQ only */
+    IMU_PM_MODE_COUNT,
+};
+
+enum imu_pm_event {
+    IMU_PM_EV_NO_MOTION,
+    IMU_PM_EV_ANY_MOTION,
+    IMU_PM_EV_HOLD,
+    IMU_PM_EV_RELEASE,
+};
+
+struct imu_pm_params {
+    uint32_t mode_ua[IMU_PM_MODE_COUNT];    /* estimated system current */
+};
+
+struct imu_pm_stats {
+    uint64_t mode_ms[IMU_PM_MODE_COUNT];
+    uint32_t wakeups;       /* LOW_POWER -> ACTIVE */
+    uint32_t sleeps;        /* ACTIVE -> LOW_POWER */
+    uint32_t avg_ua;        /* estimated average current since init */
+    uint64_t charge_uah;    /* estimated charge since init */
+};
+
+struct imu_pm {
+    struct imu_pm_params p;
+    enum imu_pm_mode mode;
+    bool still;             /* no-motion seen, no motion since */
+    bool held;
+    uint32_t t_mode_ms;     /* when the current mode was entered */
+    uint32_t t_init_ms;
+    struct imu_pm_stats st;
+};
+
+void imu_pm_init(struct imu_pm *pm, const struct imu_pm_params *params, uint32_t t_ms);
+
+/* Feed one event at t_ms (timestamps may wrap). Returns the mode the IMU
+ * must be in afterwards.
+ */
+enum imu_pm_mode imu_pm_event(struct imu_pm *pm, enum imu_pm_event ev, uint32_t t_ms);
+
+/* Counters including the time spent in the current mode up to t_ms */
+void imu_pm_stats(const struct imu_pm *pm, uint32_t t_ms, struct imu_pm_stats *out);
+
+#endif /* IMU_PM_H_ */
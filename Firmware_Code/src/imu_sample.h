@@ -0,0 +1,23 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef IMU_SAMPLE_H_
+#define IMU_SAMPLE_H_
+
+#include <stdint.h>
+
+/* ===== Scale of the raw counts (+-2 g, +-500 dps) ===== */
+#define IMU_ACC_LSB_PER_G       16384
+#define IMU_GYR_LSB_PER_DPS     65.536f
+
+/* One accel+gyro frame as drained from the BMI270 FIFO. Kept free of Zephyr
+ * headers so the processing modules also build on the host.
+ */
+struct imu_sample {
+    uint32_t t_us;          /* uptime at which the frame was sampled */
+    int16_t acc[3];         /* raw counts, IMU_ACC_LSB_PER_G */
+    int16_t gyr[3];         /* raw counts, IMU_GYR_LSB_PER_DPS */
+};
+
+#endif /* IMU_SAMPLE_H_ */
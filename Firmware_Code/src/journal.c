@@ -0,0 +1,571 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <errno.h>
+#include <string.h>
+
+#include "journal.h"
+
+#if defined(CONFIG_NECK_JOURNAL)
+#include <zephyr/fs/fcb.h>
+#include <zephyr/storage/flash_map.h>
+#endif
+
+LOG_MODULE_REGISTER(journal, LOG_LEVEL_INF);
+
+#if defined(CONFIG_NECK_JOURNAL)
+
+/* ===== Journal Configuration ===== */
+#define JOURNAL_AREA    FIXED_PARTITION_ID(journal_partition)
+#define JOURNAL_MAGIC   0x4e4a524eu     /* "NRJN" */
+#define SECTORS_MAX     16
+#define ENTRY_MAX       CONFIG_NECK_JOURNAL_ENTRY_MAX
+#define ENTRY_BUF       ROUND_UP(ENTRY_MAX, 8)          /* padded to the write block */
+#define CHUNK_HDR       sizeof(struct jrnl_chunk)
+#define ANCHORS_MAX     16
+#define COMMIT_MS       (CONFIG_NECK_JOURNAL_COMMIT_S * 1000)
+
+struct journal_msg {
+    enum { MSG_REC, MSG_SYNC, MSG_ACK } kind;
+    union {
+        struct jrnl_rec rec;
+        struct {
+            uint32_t seq;
+            uint16_t off;
+            uint16_t chunk;
+            uint32_t t_ms;
+            uint64_t epoch_ms;
+            journal_send_fn send;
+        } sync;
+    };
+};
+
+/* ===== Global Variables ===== */
+static struct fcb fcb;
+static struct flash_sector sectors[SECTORS_MAX];
+static bool ready;
+static struct jrnl_state state;
+static struct journal_stats stats;
+static struct k_spinlock stats_lock;
+
+/* Entry being filled; journal thread only */
+static uint8_t entry[ENTRY_BUF];
+static size_t entry_len;
+static uint32_t entry_prev_ms;
+static int64_t entry_deadline;
+
+/* Entries read back for recovery and sync */
+static uint8_t rd_buf[ENTRY_BUF];
+static uint8_t chunk_buf[CHUNK_HDR + ENTRY_MAX];
+
+K_MSGQ_DEFINE(journal_q, sizeof(struct journal_msg), CONFIG_NECK_JOURNAL_QUEUE, 8);
+
+static void journal_thread(void *p1, void *p2, void *p3);
+
+K_THREAD_DEFINE(journal_tid, CONFIG_NECK_JOURNAL_STACK_SIZE,
+                journal_thread, NULL, NULL, NULL,
+                CONFIG_NECK_JOURNAL_THREAD_PRIO, 0, K_TICKS_FOREVER);
+
+/* ===== Flash ===== */
+
+/* fcb_init() refuses a sector whose header is neither ours nor erased: an
+ * erase or a header write cut short by a power loss. Such a sector holds
+ * no committed element, so it is erased on its own and the rest kept.
+ */
+static int erase_foreign(const struct flash_area *fa, uint32_t cnt)
+{
+    int rc = 0;
+
+    for (uint32_t i = 0; i < cnt && rc == 0; i++) {
+        uint32_t magic;
+
+        rc = flash_area_read(fa, sectors[i].fs_off, &magic, sizeof(magic));
+        if (rc == 0 && magic != JOURNAL_MAGIC && magic != UINT32_MAX) {
+            LOG_WRN("Journal sector %u damaged, erasing", i);
+            rc = flash_area_erase(fa, sectors[i].fs_off, sectors[i].fs_size);
+        }
+    }
+    return rc;
+}
+
+static int open_fcb(void)
+{
+    const struct flash_area *fa;
+    uint32_t cnt = ARRAY_SIZE(sectors);
+    int rc = flash_area_get_sectors(JOURNAL_AREA, &cnt, sectors);
+
+    if (rc) {
+        LOG_ERR("Journal partition unusable (%d)", rc);
+        return rc;
+    }
+    fcb.f_magic = JOURNAL_MAGIC;
+    fcb.f_version = JRNL_VERSION;
+    fcb.f_sector_cnt = (uint8_t)cnt;
+    fcb.f_scratch_cnt = 0;
+    fcb.f_sectors = sectors;
+
+    rc = fcb_init(JOURNAL_AREA, &fcb);
+    if (rc == 0) {
+        return 0;
+    }
+    rc = flash_area_open(JOURNAL_AREA, &fa);
+    if (rc) {
+        return rc;
+    }
+    if (erase_foreign(fa, cnt) == 0 && fcb_init(JOURNAL_AREA, &fcb) == 0) {
+        flash_area_close(fa);
+        return 0;
+    }
+
+    /* Not an FCB of ours at all (first boot after a layout change) */
+    LOG_WRN("Journal unreadable, erasing");
+    rc = flash_area_erase(fa, 0, fa->fa_size);
+    flash_area_close(fa);
+    return rc ? rc : fcb_init(JOURNAL_AREA, &fcb);
+}
+
+/* A length field cut short by a power loss can read as the end of the
+ * data, and the next element would be programmed over it. Appends go on
+ * in the next sector then; the rest of this one stays unused.
+ */
+static void skip_torn_tail(void)
+{
+    const struct flash_sector *s = fcb.f_active.fe_sector;
+    uint32_t off = fcb.f_active.fe_elem_off;
+    uint8_t b[8];
+    size_t n = MIN(sizeof(b), s->fs_size - off);
+
+    if (off >= s->fs_size || flash_area_read(fcb.fap, s->fs_off + off, b, n)) {
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (b[i] != 0xff) {
+            LOG_WRN("Journal tail damaged at 0x%x", s->fs_off + off);
+            fcb.f_active.fe_elem_off = s->fs_size;
+            return;
+        }
+    }
+}
+
+static int read_entry(const struct fcb_entry *loc, uint8_t *buf)
+{
+    struct jrnl_state tmp;
+    int rc;
+
+    if (loc->fe_data_len > ENTRY_MAX) {
+        return -EMSGSIZE;
+    }
+    rc = flash_area_read(fcb.fap, FCB_ENTRY_FA_DATA_OFF(*loc), buf, loc->fe_data_len);
+    if (rc) {
+        return rc;
+    }
+
+    /* CRC-8 passes one torn element in 256; the decoder catches those */
+    jrnl_state_init(&tmp);
+    return jrnl_scan_entry(&tmp, buf, loc->fe_data_len) < 0 ? -EBADMSG : 0;
+}
+
+/* Seq, boot and sync mark from what survived the last run. fcb_getnext()
+ * skips elements failing their CRC: the one a power cut interrupted.
+ */
+static void recover(void)
+{
+    struct fcb_entry loc = { 0 };
+
+    jrnl_state_init(&state);
+    while (fcb_getnext(&fcb, &loc) == 0) {
+        if (read_entry(&loc, rd_buf) == 0) {
+            jrnl_scan_entry(&state, rd_buf, loc.fe_data_len);
+        } else {
+            state.bad++;
+        }
+    }
+    if (state.entries) {
+        state.boot++;
+    }
+    stats.next_seq = state.next_seq;
+    stats.synced = state.synced;
+    stats.boot = state.boot;
+}
+
+/* The RAM entry as one FCB element */
+static int commit(void)
+{
+    struct jrnl_entry_hdr h;
+    struct fcb_entry loc;
+    size_t len = entry_len;
+    int rc;
+
+    if (len == 0) {
+        return 0;
+    }
+    entry_len = 0;
+    if (!ready) {
+        return -ENODEV;
+    }
+
+    rc = fcb_append(&fcb, len, &loc);
+    if (rc == -ENOSPC) {
+        /* Full: the oldest sector goes, whether the gateway has it or not */
+        rc = fcb_rotate(&fcb);
+        stats.rotations++;
+        if (rc == 0) {
+            rc = fcb_append(&fcb, len, &loc);
+        }
+    }
+    if (rc == 0) {
+        /* Whole write blocks; the CRC only covers len bytes */
+        size_t padded = ROUND_UP(len, fcb.f_align);
+
+        memset(entry + len, 0, padded - len);
+        rc = flash_area_write(fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc), entry, padded);
+    }
+    if (rc == 0) {
+        rc = fcb_append_finish(&fcb, &loc);
+    }
+
+    /* A seq is never reused, even for an entry that did not make it */
+    memcpy(&h, entry, sizeof(h));
+    state.next_seq = h.seq + 1;
+
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+    stats.next_seq = state.next_seq;
+    if (rc) {
+        stats.write_errors++;
+    } else {
+        stats.entries++;
+    }
+    k_spin_unlock(&stats_lock, key);
+
+    if (rc) {
+        LOG_ERR("Journal entry %u lost (%d)", h.seq, rc);
+    }
+    return rc;
+}
+
+static void append(struct jrnl_rec *r)
+{
+    uint8_t buf[JRNL_REC_MAX];
+    size_t n;
+
+    /* Stamped by the callers before queueing, so slightly out of order */
+    if (entry_len && r->t_ms < entry_prev_ms) {
+        r->t_ms = entry_prev_ms;
+    }
+    n = entry_len ? jrnl_rec_encode(buf, r, entry_prev_ms) : 0;
+    if (entry_len + n > ENTRY_MAX) {
+        commit();
+    }
+    if (entry_len == 0) {
+        const struct jrnl_entry_hdr h = {
+            .version = JRNL_VERSION,
+            .boot = state.boot,
+            .seq = state.next_seq,
+            .t0_ms = r->t_ms,
+        };
+
+        memcpy(entry, &h, sizeof(h));
+        entry_len = sizeof(h);
+        entry_prev_ms = r->t_ms;
+        entry_deadline = k_uptime_get() + COMMIT_MS;
+        n = jrnl_rec_encode(buf, r, entry_prev_ms);
+    }
+    memcpy(entry + entry_len, buf, n);
+    entry_len += n;
+    entry_prev_ms = r->t_ms;
+}
+
+/* ===== Sync transfer ===== */
+static int send_chunk(journal_send_fn send, uint32_t seq, uint16_t off, uint16_t len,
+                      const void *data, size_t n)
+{
+    const struct jrnl_chunk c = { .seq = seq, .off = off, .len = len };
+
+    memcpy(chunk_buf, &c, sizeof(c));
+    memcpy(chunk_buf + sizeof(c), data, n);
+    return send(chunk_buf, sizeof(c) + n);
+}
+
+/* Wall time of the boots from first_boot on, from their JRNL_CLOCK records
+ * anywhere in the journal
+ */
+static int send_anchors(journal_send_fn send, size_t room, uint32_t first)
+{
+    struct jrnl_anchor a[ANCHORS_MAX];
+    struct fcb_entry loc = { 0 };
+    size_t n = 0;
+    uint16_t first_boot = state.boot;
+    int rc = 0;
+
+    while (fcb_getnext(&fcb, &loc) == 0) {
+        struct jrnl_entry_hdr h;
+        struct jrnl_rec r;
+        size_t pos = sizeof(h);
+        uint32_t t;
+
+        if (read_entry(&loc, rd_buf) || loc.fe_data_len < sizeof(h)) {
+            continue;
+        }
+        memcpy(&h, rd_buf, sizeof(h));
+        if (h.seq >= first && h.boot < first_boot) {
+            first_boot = h.boot;
+        }
+        t = h.t0_ms;
+        while (jrnl_rec_decode(rd_buf, loc.fe_data_len, &pos, &t, &r) > 0) {
+            if (r.type != JRNL_CLOCK || (n && a[n - 1].boot == h.boot)) {
+                continue;
+            }
+            if (n == ANCHORS_MAX) {
+                memmove(a, a + 1, sizeof(a) - sizeof(a[0]));
+                n--;
+            }
+            a[n].boot = h.boot;
+            a[n].offset_ms = r.a - r.t_ms;
+            n++;
+        }
+    }
+
+    size_t i = 0;
+    size_t per = room / sizeof(a[0]);
+
+    while (i < n && a[i].boot < first_boot) {
+        i++;
+    }
+    while (i < n && per && rc == 0) {
+        size_t k = MIN(n - i, per);
+
+        rc = send_chunk(send, 0, 0, JRNL_LEN_ANCHORS, &a[i], k * sizeof(a[0]));
+        i += k;
+    }
+    return rc;
+}
+
+static void sync_run(const struct journal_msg *m)
+{
+    size_t room = MIN((size_t)m->sync.chunk, sizeof(chunk_buf));
+    uint32_t first = m->sync.seq;
+    uint16_t off = m->sync.off;
+    struct fcb_entry loc = { 0 };
+    int rc;
+
+    /* This boot's wall time goes in first, and everything in RAM with it */
+    if (m->sync.epoch_ms) {
+        struct jrnl_rec r = {
+            .type = JRNL_CLOCK,
+            .t_ms = m->sync.t_ms,
+            .a = (int64_t)m->sync.epoch_ms,
+        };
+
+        append(&r);
+    }
+    commit();
+    if (!ready || room <= CHUNK_HDR) {
+        return;
+    }
+    room -= CHUNK_HDR;
+    if (first == JRNL_SEQ_UNSYNCED) {
+        first = state.synced;
+        off = 0;
+    }
+
+    rc = send_anchors(m->sync.send, room, first);
+    while (rc == 0 && fcb_getnext(&fcb, &loc) == 0) {
+        struct jrnl_entry_hdr h;
+
+        if (read_entry(&loc, rd_buf) || loc.fe_data_len < sizeof(h)) {
+            continue;
+        }
+        memcpy(&h, rd_buf, sizeof(h));
+        if (h.seq < first) {
+            continue;
+        }
+
+        size_t o = (h.seq == first && off < loc.fe_data_len) ? off : 0;
+
+        while (rc == 0 && o < loc.fe_data_len) {
+            size_t n = MIN(loc.fe_data_len - o, room);
+
+            rc = send_chunk(m->sync.send, h.seq, (uint16_t)o, loc.fe_data_len, rd_buf + o, n);
+            o += n;
+        }
+    }
+    if (rc == 0) {
+        rc = send_chunk(m->sync.send, state.next_seq, 0, JRNL_LEN_END, NULL, 0);
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+    if (rc) {
+        stats.sync_aborts++;
+    } else {
+        stats.syncs++;
+    }
+    k_spin_unlock(&stats_lock, key);
+}
+
+/* The gateway has everything before seq: one mark, committed at once */
+static void ack(uint32_t seq)
+{
+    if (seq <= state.synced || seq > state.next_seq) {
+        return;
+    }
+    struct jrnl_rec r = {
+        .type = JRNL_SYNCED,
+        .t_ms = k_uptime_get_32(),
+        .a = seq,
+    };
+
+    state.synced = seq;
+    append(&r);
+    commit();
+
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+    stats.synced = seq;
+    k_spin_unlock(&stats_lock, key);
+}
+
+/* ===== Journal thread ===== */
+
+/* Seq, boot and sync mark from flash, where the last run left them */
+static void journal_open(void)
+{
+    ready = open_fcb() == 0;
+    if (ready) {
+        skip_torn_tail();
+        recover();
+        LOG_INF("Journal: boot %u, %u entries up to seq %u, synced to %u%s", state.boot,
+                state.entries, state.next_seq, state.synced,
+                state.bad ? ", some unreadable" : "");
+    }
+}
+
+static void handle(struct journal_msg *m)
+{
+    switch (m->kind) {
+    case MSG_REC:
+        append(&m->rec);
+        break;
+    case MSG_SYNC:
+        sync_run(m);
+        break;
+    case MSG_ACK:
+        ack(m->sync.seq);
+        break;
+    }
+}
+
+static void journal_thread(void *p1, void *p2, void *p3)
+{
+    struct journal_msg m;
+
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    journal_open();
+    while (1) {
+        k_timeout_t wait = entry_len ? K_TIMEOUT_ABS_MS(entry_deadline) : K_FOREVER;
+
+        if (k_msgq_get(&journal_q, &m, wait) != 0) {
+            commit();
+            continue;
+        }
+        handle(&m);
+    }
+}
+
+#endif /* CONFIG_NECK_JOURNAL */
+
+/* ===== Public API ===== */
+int journal_init(void)
+{
+#if defined(CONFIG_NECK_JOURNAL)
+    k_thread_name_set(journal_tid, "journal");
+    k_thread_start(journal_tid);
+#endif
+    return 0;
+}
+
+void journal_add(uint8_t type, int64_t a, int32_t b)
+{
+#if defined(CONFIG_NECK_JOURNAL)
+    struct journal_msg m = {
+        .kind = MSG_REC,
+        .rec = {
+            .type = type,
+            .t_ms = k_uptime_get_32(),
+            .a = a,
+            .b = b,
+        },
+    };
+    bool ok = k_msgq_put(&journal_q, &m, K_NO_WAIT) == 0;
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+    if (ok) {
+        stats.records++;
+    } else {
+        stats.drops++;
+    }
+    k_spin_unlock(&stats_lock, key);
+#else
+    ARG_UNUSED(type);
+    ARG_UNUSED(a);
+    ARG_UNUSED(b);
+#endif
+}
+
+int journal_sync(uint32_t seq, uint16_t off, uint64_t epoch_ms, size_t chunk,
+                 journal_send_fn send)
+{
+#if defined(CONFIG_NECK_JOURNAL)
+    struct journal_msg m = {
+        .kind = MSG_SYNC,
+        .sync = {
+            .seq = seq,
+            .off = off,
+            .chunk = (uint16_t)MIN(chunk, UINT16_MAX),
+            .t_ms = k_uptime_get_32(),
+            .epoch_ms = epoch_ms,
+            .send = send,
+        },
+    };
+
+    return k_msgq_put(&journal_q, &m, K_NO_WAIT);
+#else
+    ARG_UNUSED(seq);
+    ARG_UNUSED(off);
+    ARG_UNUSED(epoch_ms);
+    ARG_UNUSED(chunk);
+    ARG_UNUSED(send);
+    return -ENOTSUP;
+#endif
+}
+
+int journal_ack(uint32_t seq)
+{
+#if defined(CONFIG_NECK_JOURNAL)
+    struct journal_msg m = { .kind = MSG_ACK, .sync = { .seq = seq } };
+
+    return k_msgq_put(&journal_q, &m, K_NO_WAIT);
+#else
+    ARG_UNUSED(seq);
+    return -ENOTSUP;
+#endif
+}
+
+void journal_stats_get(struct journal_stats *out)
+{
+#if defined(CONFIG_NECK_JOURNAL)
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+    *out = stats;
+    k_spin_unlock(&stats_lock, key);
+#else
+    memset(out, 0, sizeof(*out));
+#endif
+}
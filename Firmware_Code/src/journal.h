@@ -0,0 +1,66 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "journal_wire.h"
+
+/* ===== Event journal =====
+ *
+ * What happened while no gateway was listening, kept in a flash circular
+ * buffer (Zephyr FCB) on journal_partition and handed to the gateway after
+ * every connection. Entry and record format, and the sync transfer, in
+ * shared/journal_wire.h.
+ *
+ * journal_add() only queues the record; the journal thread (lowest of the
+ * application) packs records into an entry in RAM and commits it as one
+ * FCB element when the next record would not fit or its first record is
+ * CONFIG_NECK_JOURNAL_COMMIT_S old. FCB writes the element's CRC last, so
+ * an element cut short by a power loss fails its CRC and is skipped on the
+ * next boot; everything committed before it stays. When the buffer is full
+ * the oldest sector is erased for the next one, so the sectors wear evenly.
+ *
+ * Compiled to no-ops without CONFIG_NECK_JOURNAL.
+ */
+
+struct journal_stats {
+    uint32_t records;           /* queued */
+    uint32_t drops;             /* queue full */
+    uint32_t entries;           /* committed since boot */
+    uint32_t write_errors;
+    uint32_t rotations;         /* sectors erased to make room */
+    uint32_t syncs;             /* transfers completed */
+    uint32_t sync_aborts;       /* cut short (disconnect, no buffers) */
+    uint32_t next_seq;
+    uint32_t synced;            /* first entry the gateway has not acknowledged */
+    uint16_t boot;
+};
+
+/* Sends one sync notification; may block for a buffer. A negative errno
+ * ends the transfer.
+ */
+typedef int (*journal_send_fn)(const void *buf, size_t len);
+
+/* Start the journal thread, which opens the flash buffer */
+int journal_init(void);
+
+/* One record (types and a/b in journal_wire.h), stamped now. Any thread,
+ * never waits; dropped and counted when the queue is full.
+ */
+void journal_add(uint8_t type, int64_t a, int32_t b);
+
+/* Gateway requests (journal_wire.h), handed to the journal thread. chunk
+ * is the notification size (ATT MTU - 3).
+ */
+int journal_sync(uint32_t seq, uint16_t off, uint64_t epoch_ms, size_t chunk,
+                 journal_send_fn send);
+int journal_ack(uint32_t seq);
+
+void journal_stats_get(struct journal_stats *out);
+
+#endif /* JOURNAL_H_ */
@@ -0,0 +1,215 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log.h>
+#include <errno.h>
+
+#include "peltier_ctrl.h"
+#include "peltier_pi.h"
+#include "actuators.h"
+#include "adc_stream.h"
+#include "thermistor.h"
+#include "journal.h"
+#include "pipeline.h"
+#include "prof.h"
+#include "therm_sup.h"
+
+LOG_MODULE_REGISTER(peltier_ctrl, LOG_LEVEL_INF);
+
+/* ===== Loop Configuration ===== */
+#define TICK_PERIOD     K_USEC(1000000 / CONFIG_NECK_PELTIER_TICK_HZ)
+
+/* ===== Global Variables ===== */
+static struct peltier_pi pi;
+static struct peltier_status status = {
+    .temp_cdeg = INT16_MIN,
+    .therm_mv = -1,
+    .current_ma = -1,
+};
+static struct k_spinlock status_lock;
+static uint8_t faults;          /* JRNL_TF_* last journalled */
+static atomic_t cue_requested;
+static atomic_t cue_t_ms;       /* uptime of the last request */
+static atomic_t setpoint_cdeg = ATOMIC_INIT(CONFIG_NECK_PELTIER_SETPOINT_CDEG);
+
+static struct k_work_q peltier_wq;
+static K_THREAD_STACK_DEFINE(peltier_wq_stack, CONFIG_NECK_PELTIER_STACK_SIZE);
+
+static void tick_work_fn(struct k_work *work);
+static K_WORK_DEFINE(tick_work, tick_work_fn);
+
+static void tick_timer_fn(struct k_timer *timer);
+static K_TIMER_DEFINE(tick_timer, tick_timer_fn, NULL);
+
+/* ===== Sensor inputs ===== */
+static void read_inputs(struct peltier_status *st)
+{
+    int16_t code;
+
+    st->temp_cdeg = INT16_MIN;
+    st->therm_mv = -1;
+    if (adc_stream_latest(ADC_CH_THERM, &code) == 0) {
+        st->therm_mv = (int16_t)adc_stream_code_to_mv(code);
+        PROF_START(PROF_THERMISTOR);
+        st->temp_cdeg = thermistor_cdeg_from_code(code);
+        PROF_STOP(PROF_THERMISTOR);
+    }
+
+    st->current_ma = -1;
+#if defined(CONFIG_NECK_PELTIER_CURRENT_SENSE)
+    if (adc_stream_latest(ADC_CH_AUX, &code) == 0) {
+        int32_t mv = MAX(adc_stream_code_to_mv(code), 0);
+
+        st->current_ma = (int16_t)MIN(mv * CONFIG_NECK_PELTIER_SENSE_MA_PER_V / 1000,
+                                      INT16_MAX);
+    }
+#endif
+}
+
+/* ===== Controller tick ===== */
+static void tick_work_fn(struct k_work *work)
+{
+    struct peltier_status st;
+    uint32_t t0 = pipeline_now_us();
+    float duty;
+
+    ARG_UNUSED(work);
+
+    PROF_START(PROF_PELTIER_TICK);
+    read_inputs(&st);
+    st.cue = atomic_get(&cue_requested);
+    st.tripped = therm_sup_tripped() != THERM_TRIP_NONE;
+    st.over_temp = st.temp_cdeg != INT16_MIN &&
+                   st.temp_cdeg > CONFIG_NECK_PELTIER_TEMP_CUTOFF_CDEG;
+
+    /* Fail safe: no cue, no temperature, over the cut-off or a supervisor
+     * trip -> off, and the integrator starts from zero next time
+     */
+    duty = peltier_pi_tick(&pi, st.cue && !st.tripped, (int16_t)atomic_get(&setpoint_cdeg),
+                           CONFIG_NECK_PELTIER_TEMP_CUTOFF_CDEG, st.temp_cdeg, st.current_ma);
+    st.folded_back = pi.folded_back;
+    st.duty_permille = (uint16_t)(duty * 1000.0f + 0.5f);
+
+    /* Fault set changes go to the journal; a missing or implausible
+     * reading only counts while a cue wants heat, the ADC is paused
+     * otherwise
+     */
+    uint8_t f = (st.over_temp ? JRNL_TF_OVER_TEMP : 0) |
+                (st.cue && !peltier_pi_plausible(&pi, st.temp_cdeg) ? JRNL_TF_NO_SENSOR : 0) |
+                (st.folded_back ? JRNL_TF_FOLDBACK : 0);
+
+    if (f != faults) {
+        faults = f;
+        journal_add(JRNL_THERMAL, f, st.temp_cdeg);
+    }
+
+    /* Only reaches the PWM driver when the duty actually changed */
+    actuators_set(ACT_PELTIER, st.duty_permille);
+
+    k_spinlock_key_t key = k_spin_lock(&status_lock);
+
+    status = st;
+    k_spin_unlock(&status_lock, key);
+
+    PROF_STOP(PROF_PELTIER_TICK);
+    pipeline_stage_record(STAGE_THERMAL, pipeline_now_us() - t0);
+}
+
+static void tick_timer_fn(struct k_timer *timer)
+{
+    ARG_UNUSED(timer);
+
+    /* 0 means the previous tick has not run yet */
+    if (k_work_submit_to_queue(&peltier_wq, &tick_work) == 0) {
+        pipeline_stage_overrun(STAGE_THERMAL, 1);
+    }
+}
+
+void peltier_ctrl_request(bool cue)
+{
+    atomic_set(&cue_t_ms, (atomic_val_t)k_uptime_get_32());
+    atomic_set(&cue_requested, cue);
+}
+
+bool peltier_ctrl_request_get(uint32_t *t_ms)
+{
+    *t_ms = (uint32_t)atomic_get(&cue_t_ms);
+    return atomic_get(&cue_requested);
+}
+
+int peltier_ctrl_setpoint_set(int16_t cdeg)
+{
+    if (cdeg <= 0 || cdeg >= CONFIG_NECK_PELTIER_TEMP_CUTOFF_CDEG) {
+        return -EINVAL;
+    }
+    atomic_set(&setpoint_cdeg, cdeg);
+    LOG_INF("Setpoint %d.%02d C", cdeg / 100, cdeg % 100);
+    return 0;
+}
+
+int16_t peltier_ctrl_setpoint_get(void)
+{
+    return (int16_t)atomic_get(&setpoint_cdeg);
+}
+
+void peltier_ctrl_status_get(struct peltier_status *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&status_lock);
+
+    *out = status;
+    k_spin_unlock(&status_lock, key);
+}
+
+void peltier_ctrl_suspend(bool suspend)
+{
+    struct k_work_sync sync;
+
+    if (!suspend) {
+        k_timer_start(&tick_timer, TICK_PERIOD, TICK_PERIOD);
+        return;
+    }
+
+    k_timer_stop(&tick_timer);
+    k_work_cancel_sync(&tick_work, &sync);
+
+    /* Nothing else touches the loop until the timer restarts */
+    peltier_pi_reset(&pi);
+    actuators_set(ACT_PELTIER, 0);
+
+    k_spinlock_key_t key = k_spin_lock(&status_lock);
+
+    status.duty_permille = 0;
+    k_spin_unlock(&status_lock, key);
+}
+
+int peltier_ctrl_init(void)
+{
+    const struct peltier_pi_params params = {
+        .kp = CONFIG_NECK_PELTIER_KP_MILLI / 1000.0f,
+        .ki = CONFIG_NECK_PELTIER_KI_MILLI / 1000.0f,
+        .dt_s = 1.0f / CONFIG_NECK_PELTIER_TICK_HZ,
+        .out_max = CONFIG_NECK_PELTIER_MAX_DUTY_PCT / 100.0f,
+        .slew_per_s = CONFIG_NECK_PELTIER_SLEW_PCT_PER_S / 100.0f,
+        .min_cdeg = CONFIG_NECK_PELTIER_TEMP_MIN_CDEG,
+        .max_cdeg = CONFIG_NECK_PELTIER_TEMP_MAX_CDEG,
+#if defined(CONFIG_NECK_PELTIER_CURRENT_SENSE)
+        .current_limit_a = CONFIG_NECK_PELTIER_CURRENT_LIMIT_MA / 1000.0f,
+#endif
+    };
+
+    peltier_pi_init(&pi, &params);
+    pipeline_stage_init(STAGE_THERMAL, 1000000 / CONFIG_NECK_PELTIER_TICK_HZ);
+
+    k_work_queue_start(&peltier_wq, peltier_wq_stack,
+                       K_THREAD_STACK_SIZEOF(peltier_wq_stack),
+                       CONFIG_NECK_PELTIER_THREAD_PRIO, NULL);
+    k_thread_name_set(&peltier_wq.thread, "peltier");
+    k_timer_start(&tick_timer, TICK_PERIOD, TICK_PERIOD);
+
+    LOG_INF("Peltier PI at %d Hz, setpoint %d.%02d C", CONFIG_NECK_PELTIER_TICK_HZ,
+            CONFIG_NECK_PELTIER_SETPOINT_CDEG / 100, CONFIG_NECK_PELTIER_SETPOINT_CDEG % 100);
+    return 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef PELTIER_CTRL_H_
+#define PELTIER_CTRL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== Peltier thermal loop =====
+ *
+ * Closed-loop PI (peltier_pi.c) on its own fixed-rate tick: a k_timer
+ * submits one work item per period to a dedicated work queue, independent
+ * of the IMU batch rate. Temperature and supply current come from the
+ * background ADC scan (adc_stream.h), so a tick never waits on hardware
+ * other than the PWM write.
+ *
+ * The control thread only says whether the thermal cue is wanted; the loop
+ * regulates to the setpoint (CONFIG_NECK_PELTIER_SETPOINT_CDEG unless
+ * changed at runtime) while it is, and drives the
+ * Peltiers to zero when it is not, when the temperature is unknown or when
+ * it exceeds CONFIG_NECK_PELTIER_TEMP_CUTOFF_CDEG. The thermal supervisor
+ * (therm_sup.h) checks all of this again from its own thread and can hold
+ * the Peltiers off underneath the loop.
+ */
+
+struct peltier_status {
+    int16_t temp_cdeg;      /* INT16_MIN when unknown */
+    int16_t therm_mv;       /* -1 when no reading */
+    int16_t current_ma;     /* -1 when not measured */
+    uint16_t duty_permille;
+    bool cue;               /* thermal cue requested */
+    bool folded_back;       /* duty limited by the current fold-back */
+    bool over_temp;         /* above the hard cut-off */
+    bool tripped;           /* held off by the thermal supervisor */
+};
+
+/* Start the tick; the Peltier channels were driven off by actuators_init() */
+int peltier_ctrl_init(void);
+
+/* Request (or drop) the thermal cue; cheap, callable every control step */
+void peltier_ctrl_request(bool cue);
+
+/* Last request, and the uptime it was made at (for the supervisor) */
+bool peltier_ctrl_request_get(uint32_t *t_ms);
+
+/* Change the setpoint, from the next tick on. -EINVAL unless it lies
+ * between 0 and CONFIG_NECK_PELTIER_TEMP_CUTOFF_CDEG.
+ */
+int peltier_ctrl_setpoint_set(int16_t cdeg);
+int16_t peltier_ctrl_setpoint_get(void);
+
+/* Snapshot of the last tick */
+void peltier_ctrl_status_get(struct peltier_status *out);
+
+/* Stop the tick with the Peltiers off (IMU low power, no cue possible), or
+ * restart it
+ */
+void peltier_ctrl_suspend(bool suspend);
+
+#endif /* PELTIER_CTRL_H_ */
@@ -0,0 +1,83 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include "peltier_pi.h"
+
+static float clampf(float v, float lo, float hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+void peltier_pi_init(struct peltier_pi *pi, const struct peltier_pi_params *params)
+{
+    memset(pi, 0, sizeof(*pi));
+    pi->p = *params;
+}
+
+void peltier_pi_reset(struct peltier_pi *pi)
+{
+    pi->integ = 0.0f;
+    pi->out = 0.0f;
+    pi->folded_back = false;
+}
+
+float peltier_pi_step(struct peltier_pi *pi, float setpoint_c, float temp_c, float current_a)
+{
+    const struct peltier_pi_params *p = &pi->p;
+    float hi = p->out_max;
+
+    /* Current fold-back: scale the ceiling against the duty that produced
+     * the measurement, so the draw settles at the limit
+     */
+    pi->folded_back = false;
+    if (p->current_limit_a > 0.0f && current_a > p->current_limit_a) {
+        hi = clampf(pi->out * (p->current_limit_a / current_a), 0.0f, hi);
+        pi->folded_back = true;
+    }
+
+    float err = setpoint_c - temp_c;
+    float prop = p->kp * err;
+    float integ = pi->integ + p->ki * err * p->dt_s;
+    float u = prop + integ;
+
+    /* Anti-windup: only keep the new integrator value if it does not push
+     * further into a saturated output
+     */
+    if ((u > hi && err > 0.0f) || (u < 0.0f && err < 0.0f)) {
+        integ = pi->integ;
+        u = prop + integ;
+    }
+    pi->integ = clampf(integ, 0.0f, hi);
+    u = clampf(u, 0.0f, hi);
+
+    /* Slew limit on the way up; fold-back and cut-off act immediately */
+    float step = p->slew_per_s * p->dt_s;
+
+    if (u > pi->out + step) {
+        u = pi->out + step;
+    }
+    pi->out = u;
+    return u;
+}
+
+bool peltier_pi_plausible(const struct peltier_pi *pi, int16_t temp_cdeg)
+{
+    return temp_cdeg != INT16_MIN && temp_cdeg >= pi->p.min_cdeg && temp_cdeg <= pi->p.max_cdeg;
+}
+
+float peltier_pi_tick(struct peltier_pi *pi, bool cue, int16_t setpoint_cdeg,
+                      int16_t cutoff_cdeg, int16_t temp_cdeg, int16_t current_ma)
+{
+    /* An open NTC reads as the cold end of the table: the PI would go to
+     * full duty against it
+     */
+    if (!cue || !peltier_pi_plausible(pi, temp_cdeg) || temp_cdeg > cutoff_cdeg) {
+        peltier_pi_reset(pi);
+        return 0.0f;
+    }
+    return peltier_pi_step(pi, setpoint_cdeg / 100.0f, temp_cdeg / 100.0f,
+                           current_ma >= 0 ? current_ma / 1000.0f : -1.0f);
+}
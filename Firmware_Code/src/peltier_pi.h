@@ -0,0 +1,65 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef PELTIER_PI_H_
+#define PELTIER_PI_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== Peltier PI temperature controller =====
+ *
+ * Pure computation, no Zephyr dependencies, so the same code runs in the
+ * firmware tick (peltier_ctrl.c) and against the plant model in
+ * tools/peltier_sim. Output is a duty cycle in 0..1.
+ *
+ * Per tick:
+ *   1. current fold-back: above current_limit_a the duty ceiling drops to
+ *      last_duty * limit / measured, so the draw settles at the limit
+ *   2. PI on (setpoint - temperature), integrator clamped to the ceiling
+ *      and frozen while the output is saturated in the same direction
+ *      (conditional integration anti-windup)
+ *   3. slew limit on rising duty; reductions are applied at once
+ */
+
+struct peltier_pi_params {
+    float kp;               /* duty per degC */
+    float ki;               /* duty per degC*s */
+    float dt_s;             /* tick period */
+    float out_max;          /* duty ceiling, 0..1 */
+    float slew_per_s;       /* max duty change per second */
+    float current_limit_a;  /* fold-back threshold, 0 = no current sense */
+    int16_t min_cdeg;       /* plausible readings (therm_guard's sensor check) */
+    int16_t max_cdeg;
+};
+
+struct peltier_pi {
+    struct peltier_pi_params p;
+    float integ;            /* integrator contribution, in duty */
+    float out;              /* last duty written */
+    bool folded_back;       /* last tick was current limited */
+};
+
+void peltier_pi_init(struct peltier_pi *pi, const struct peltier_pi_params *params);
+
+/* Drop the integrator and slew the output from zero (cue off / fault) */
+void peltier_pi_reset(struct peltier_pi *pi);
+
+/* One controller tick; current_a < 0 when not measured. Returns the duty. */
+float peltier_pi_step(struct peltier_pi *pi, float setpoint_c, float temp_c, float current_a);
+
+/* A reading inside min_cdeg..max_cdeg. An open or shorted thermistor reads
+ * as an end of the table (-40 or 125 degC); INT16_MIN is no reading.
+ */
+bool peltier_pi_plausible(const struct peltier_pi *pi, int16_t temp_cdeg);
+
+/* Tick with the fail-safe applied, shared by peltier_ctrl.c and
+ * tools/replay: without a cue, without a plausible temperature or above
+ * cutoff_cdeg the output is off and the controller is reset. current_ma < 0
+ * when not measured.
+ */
+float peltier_pi_tick(struct peltier_pi *pi, bool cue, int16_t setpoint_cdeg,
+                      int16_t cutoff_cdeg, int16_t temp_cdeg, int16_t current_ma);
+
+#endif /* PELTIER_PI_H_ */
@@ -0,0 +1,41 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+
+#include "pipeline.h"
+
+/* Each stage's counters are written only by that stage's thread; readers
+ * may see a torn snapshot, which is fine for diagnostics.
+ */
+static struct stage_stats stats[STAGE_COUNT];
+
+void pipeline_stage_init(enum pipeline_stage st, uint32_t deadline_us)
+{
+    stats[st] = (struct stage_stats){ .deadline_us = deadline_us };
+}
+
+void pipeline_stage_record(enum pipeline_stage st, uint32_t elapsed_us)
+{
+    struct stage_stats *s = &stats[st];
+
+    s->runs++;
+    s->last_us = elapsed_us;
+    if (elapsed_us > s->max_us) {
+        s->max_us = elapsed_us;
+    }
+    if (s->deadline_us && elapsed_us > s->deadline_us) {
+        s->deadline_misses++;
+    }
+}
+
+void pipeline_stage_overrun(enum pipeline_stage st, uint32_t n)
+{
+    stats[st].overruns += n;
+}
+
+void pipeline_stats_get(enum pipeline_stage st, struct stage_stats *out)
+{
+    *out = stats[st];
+}
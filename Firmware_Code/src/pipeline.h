@@ -0,0 +1,73 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== Processing pipeline =====
+ *
+ *   acquisition (imu_acq.c, high prio)
+ *        | sample ring (SPSC)
+ *   control (control.c): fusion, posture, Peltier/LRA
+ *        | record ring (SPSC)
+ *   telemetry (telemetry.c, low prio)
+ *
+ * The Peltier loop (peltier_ctrl.c) runs beside it on its own fixed-rate
+ * work queue; control only hands it the cue request.
+ *
+ * Each stage only ever pushes into the next ring without blocking, so a slow
+ * console can make telemetry drop records but cannot delay the actuators.
+ */
+
+enum pipeline_stage {
+    STAGE_ACQ,
+    STAGE_CONTROL,
+    STAGE_TELEMETRY,
+    STAGE_THERMAL,
+    STAGE_COUNT,
+};
+
+struct stage_stats {
+    uint32_t runs;
+    uint32_t last_us;           /* duration (control: sample-to-actuator) */
+    uint32_t max_us;
+    uint32_t deadline_us;
+    uint32_t deadline_misses;
+    uint32_t overruns;          /* items dropped at this stage's output */
+};
+
+/* One control decision, handed from control to telemetry */
+struct ctrl_record {
+    uint32_t t_us;              /* timestamp of the newest IMU sample */
+    int16_t acc[3];             /* raw counts */
+    int16_t gyr[3];
+    int16_t pitch_cdeg;
+    int16_t roll_cdeg;
+    int16_t therm_mv;           /* -1 when the ADC read failed */
+    int16_t temp_cdeg;          /* INT16_MIN when unknown */
+    uint16_t peltier_permille;  /* duty, 0 off */
+    uint8_t led_on;
+    uint8_t lra_on;
+    uint32_t latency_us;        /* newest sample -> actuators written */
+};
+
+void pipeline_stage_init(enum pipeline_stage st, uint32_t deadline_us);
+
+/* Record one run of a stage; counts a miss when elapsed exceeds the deadline */
+void pipeline_stage_record(enum pipeline_stage st, uint32_t elapsed_us);
+
+void pipeline_stage_overrun(enum pipeline_stage st, uint32_t n);
+
+void pipeline_stats_get(enum pipeline_stage st, struct stage_stats *out);
+
+static inline uint32_t pipeline_now_us(void)
+{
+    return (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+#endif /* PIPELINE_H_ */
@@ -0,0 +1,155 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include "posture.h"
+
+static float clampf(float v, float lo, float hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+void posture_init(struct posture *ps, const struct posture_params *params)
+{
+    memset(ps, 0, sizeof(*ps));
+    ps->p = *params;
+    posture_reset(ps);
+}
+
+void posture_reset(struct posture *ps)
+{
+    ps->state = POSTURE_WARMUP;
+    ps->baseline_deg = 0.0f;
+    ps->dev_deg = 0.0f;
+    ps->exiting = false;
+    ps->alerted = false;
+    ps->started = false;
+}
+
+void posture_restore(struct posture *ps, float baseline_deg)
+{
+    posture_reset(ps);
+    ps->state = POSTURE_NEUTRAL;
+    ps->baseline_deg = clampf(baseline_deg, -ps->p.baseline_limit_deg,
+                              ps->p.baseline_limit_deg);
+}
+
+/* Exponential average with a per-sample weight from the real sample gap,
+ * so the time constant holds at any (or a varying) sample rate
+ */
+static void track_baseline(struct posture *ps, float pitch_deg, uint32_t dt_ms)
+{
+    float a = (float)dt_ms / (ps->p.baseline_tau_s * 1000.0f + (float)dt_ms);
+
+    ps->baseline_deg += a * (pitch_deg - ps->baseline_deg);
+    ps->baseline_deg = clampf(ps->baseline_deg, -ps->p.baseline_limit_deg,
+                              ps->p.baseline_limit_deg);
+}
+
+enum posture_event posture_step(struct posture *ps, float pitch_deg, uint32_t t_ms)
+{
+    const struct posture_params *p = &ps->p;
+
+    if (!ps->started) {
+        ps->started = true;
+        ps->t_start_ms = t_ms;
+        ps->t_last_ms = t_ms;
+        if (ps->state == POSTURE_WARMUP) {
+            ps->baseline_deg = clampf(pitch_deg, -p->baseline_limit_deg,
+                                      p->baseline_limit_deg);
+        }
+    }
+
+    uint32_t dt = t_ms - ps->t_last_ms;
+
+    ps->t_last_ms = t_ms;
+
+    if (ps->state == POSTURE_WARMUP) {
+        uint32_t elapsed = t_ms - ps->t_start_ms;
+
+        /* Running mean: weight of this sample is dt over the time so far */
+        if (elapsed > 0) {
+            ps->baseline_deg += (float)dt / (float)elapsed * (pitch_deg - ps->baseline_deg);
+            ps->baseline_deg = clampf(ps->baseline_deg, -p->baseline_limit_deg,
+                                      p->baseline_limit_deg);
+        }
+        ps->dev_deg = pitch_deg - ps->baseline_deg;
+        if (elapsed >= p->warmup_ms) {
+            ps->state = POSTURE_NEUTRAL;
+        }
+        return POSTURE_EV_NONE;
+    }
+
+    float dev = pitch_deg - ps->baseline_deg;
+
+    ps->dev_deg = dev;
+
+    switch (ps->state) {
+    case POSTURE_NEUTRAL:
+        if (ps->held) {
+            break;
+        }
+        if (dev > p->enter_deg) {
+            ps->state = POSTURE_PENDING;
+            ps->t_mark_ms = t_ms;
+        } else if (dev < p->exit_deg && dev > -p->exit_deg) {
+            /* Only learn from samples that already look neutral */
+            track_baseline(ps, pitch_deg, dt);
+        }
+        break;
+
+    case POSTURE_PENDING:
+        if (dev < p->exit_deg || ps->held) {
+            /* A glance down that did not last, or the wearer started
+             * moving: no event
+             */
+            ps->state = POSTURE_NEUTRAL;
+        } else if (t_ms - ps->t_mark_ms >= p->enter_dwell_ms) {
+            ps->state = POSTURE_SLOUCHED;
+            ps->t_mark_ms = t_ms;
+            ps->exiting = false;
+            ps->alerted = false;
+            return POSTURE_EV_SLOUCH_START;
+        }
+        break;
+
+    case POSTURE_SLOUCHED:
+        if (dev < p->exit_deg) {
+            if (!ps->exiting) {
+                ps->exiting = true;
+                ps->t_exit_ms = t_ms;
+            }
+            if (t_ms - ps->t_exit_ms >= p->exit_dwell_ms) {
+                ps->state = POSTURE_NEUTRAL;
+                return POSTURE_EV_RECOVERED;
+            }
+        } else {
+            ps->exiting = false;
+        }
+        if (!ps->alerted && !ps->held && t_ms - ps->t_mark_ms >= p->alert_ms) {
+            ps->alerted = true;
+            return POSTURE_EV_DWELL_EXCEEDED;
+        }
+        break;
+
+    default:
+        break;
+    }
+    return POSTURE_EV_NONE;
+}
+
+const char *posture_event_name(enum posture_event ev)
+{
+    switch (ev) {
+    case POSTURE_EV_SLOUCH_START:
+        return "SLOUCH_START";
+    case POSTURE_EV_DWELL_EXCEEDED:
+        return "DWELL_EXCEEDED";
+    case POSTURE_EV_RECOVERED:
+        return "RECOVERED";
+    default:
+        return "NONE";
+    }
+}
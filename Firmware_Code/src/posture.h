@@ -0,0 +1,104 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef POSTURE_H_
+#define POSTURE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== Posture state machine =====
+ *
+ * Pure computation, no Zephyr dependencies, so the same code runs in the
+ * control thread and against scripted pitch traces in tools/posture_check.
+ * Constant time and memory per sample.
+ *
+ * Deviation is measured against an adaptive neutral baseline: an
+ * exponential average of the pitch that only moves while the posture is
+ * neutral and close to it, so neither a slouch nor a glance down is learned
+ * as the new neutral. For the first warmup_ms the baseline is the running
+ * mean of the pitch and no events are raised.
+ *
+ *   NEUTRAL --dev > enter--> PENDING --held enter_dwell_ms--> SLOUCHED
+ *      ^                        |                                 |
+ *      +------dev < exit--------+        dev < exit for exit_dwell_ms
+ *      +----------------------------------------------------------+
+ *
+ * While SLOUCHED for alert_ms, DWELL_EXCEEDED is raised once.
+ *
+ * While held (posture_hold(), the wearer walks or nods, activity.h) no
+ * slouch starts and the baseline does not learn: NEUTRAL stays, PENDING
+ * falls back to NEUTRAL. A slouch in progress can still recover; its
+ * DWELL_EXCEEDED waits for the release.
+ */
+
+enum posture_state {
+    POSTURE_WARMUP,
+    POSTURE_NEUTRAL,
+    POSTURE_PENDING,        /* over the enter band, dwell running */
+    POSTURE_SLOUCHED,
+};
+
+enum posture_event {
+    POSTURE_EV_NONE,
+    POSTURE_EV_SLOUCH_START,
+    POSTURE_EV_DWELL_EXCEEDED,
+    POSTURE_EV_RECOVERED,
+};
+
+struct posture_params {
+    float enter_deg;            /* deviation that starts a slouch */
+    float exit_deg;             /* deviation that ends it, < enter_deg */
+    uint32_t enter_dwell_ms;    /* time over enter_deg before SLOUCH_START */
+    uint32_t exit_dwell_ms;     /* time under exit_deg before RECOVERED */
+    uint32_t alert_ms;          /* slouch time before DWELL_EXCEEDED */
+    float baseline_tau_s;       /* baseline time constant */
+    uint32_t warmup_ms;         /* initial baseline averaging */
+    float baseline_limit_deg;   /* |baseline| is kept below this */
+};
+
+struct posture {
+    struct posture_params p;
+    enum posture_state state;
+    float baseline_deg;
+    float dev_deg;              /* last pitch - baseline */
+    uint32_t t_start_ms;        /* first sample */
+    uint32_t t_last_ms;
+    uint32_t t_mark_ms;         /* entered PENDING / SLOUCHED */
+    uint32_t t_exit_ms;         /* went under exit_deg while SLOUCHED */
+    bool exiting;
+    bool alerted;
+    bool started;
+    bool held;
+};
+
+void posture_init(struct posture *ps, const struct posture_params *params);
+
+/* Forget the baseline and start a new warm-up (e.g. patch re-applied) */
+void posture_reset(struct posture *ps);
+
+/* Skip the warm-up with a neutral pitch known from before (a stored
+ * snapshot): NEUTRAL from the first sample on
+ */
+void posture_restore(struct posture *ps, float baseline_deg);
+
+/* Hold or release from the next sample on; kept across posture_reset() */
+static inline void posture_hold(struct posture *ps, bool hold)
+{
+    ps->held = hold;
+}
+
+/* One pitch sample (degrees, flexion positive) at t_ms; timestamps may wrap.
+ * Returns at most one event.
+ */
+enum posture_event posture_step(struct posture *ps, float pitch_deg, uint32_t t_ms);
+
+static inline bool posture_slouched(const struct posture *ps)
+{
+    return ps->state == POSTURE_SLOUCHED;
+}
+
+const char *posture_event_name(enum posture_event ev);
+
+#endif /* POSTURE_H_ */
@@ -0,0 +1,124 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include "prof.h"
+
+#if defined(CONFIG_NECK_PROF)
+
+static struct prof_hist hist[PROF_COUNT];
+
+static const char *const probe_names[PROF_COUNT] = {
+    [PROF_IMU_DRAIN] = "imu_drain",
+    [PROF_CONTROL_STEP] = "control",
+    [PROF_FUSION] = "fusion",
+    [PROF_POSTURE] = "posture",
+    [PROF_ACTUATE] = "actuate",
+    [PROF_ADC_AVG] = "adc_avg",
+    [PROF_THERMISTOR] = "thermistor",
+    [PROF_PELTIER_TICK] = "peltier",
+    [PROF_TELEM_SINK] = "telem_sink",
+    [PROF_ACTIVITY] = "activity",
+};
+
+void prof_reset(void)
+{
+    memset(hist, 0, sizeof(hist));
+    for (int p = 0; p < PROF_COUNT; p++) {
+        hist[p].min = UINT32_MAX;
+    }
+}
+
+void prof_init(void)
+{
+    prof_cycles_init();
+    prof_reset();
+}
+
+void prof_record(enum prof_probe p, uint32_t cycles)
+{
+    struct prof_hist *h = &hist[p];
+    int b = cycles ? 31 - __builtin_clz(cycles) : 0;
+
+    h->count++;
+    h->sum += cycles;
+    h->bucket[b]++;
+    if (cycles < h->min) {
+        h->min = cycles;
+    }
+    if (cycles > h->max) {
+        h->max = cycles;
+    }
+}
+
+const char *prof_probe_name(enum prof_probe p)
+{
+    return (unsigned int)p < PROF_COUNT ? probe_names[p] : "?";
+}
+
+int prof_probe_find(const char *name)
+{
+    for (int p = 0; p < PROF_COUNT; p++) {
+        if (!strcmp(name, probe_names[p])) {
+            return p;
+        }
+    }
+    return -1;
+}
+
+void prof_hist_get(enum prof_probe p, struct prof_hist *out)
+{
+    *out = hist[p];
+}
+
+/* Cycles at which permille of the samples are done, interpolated linearly
+ * inside the bucket and clamped to the observed min/max
+ */
+static uint32_t percentile(const struct prof_hist *h, uint32_t permille)
+{
+    uint64_t rank = ((uint64_t)h->count * permille + 999) / 1000;
+    uint64_t seen = 0;
+
+    for (int b = 0; b < PROF_BUCKETS; b++) {
+        if (h->bucket[b] == 0 || seen + h->bucket[b] < rank) {
+            seen += h->bucket[b];
+            continue;
+        }
+        uint64_t lo = b ? 1ull << b : 0, hi = 1ull << (b + 1);
+        uint64_t v = lo + (hi - lo) * (rank - seen) / h->bucket[b];
+
+        if (v < h->min) {
+            v = h->min;
+        }
+        return v > h->max ? h->max : (uint32_t)v;
+    }
+    return h->max;
+}
+
+static uint32_t to_ns(uint64_t cycles)
+{
+    uint64_t ns = cycles * 1000000000u / prof_cycles_hz();
+
+    return ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns;
+}
+
+void prof_summary_get(enum prof_probe p, struct prof_summary *out)
+{
+    struct prof_hist h = hist[p];
+
+    memset(out, 0, sizeof(*out));
+    out->count = h.count;
+    if (h.count == 0) {
+        return;
+    }
+    out->min_ns = to_ns(h.min);
+    out->mean_ns = to_ns(h.sum / h.count);
+    out->p50_ns = to_ns(percentile(&h, 500));
+    out->p90_ns = to_ns(percentile(&h, 900));
+    out->p99_ns = to_ns(percentile(&h, 990));
+    out->max_ns = to_ns(h.max);
+}
+
+#endif /* CONFIG_NECK_PROF */
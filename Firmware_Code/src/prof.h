@@ -0,0 +1,153 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef PROF_H_
+#define PROF_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== Cycle-count probes =====
+ *
+ * Named probes around the pipeline stages, each feeding a log2-bucketed
+ * latency histogram. Compiled out entirely unless CONFIG_NECK_PROF is set:
+ * PROF_START/PROF_STOP expand to nothing and prof.c is empty.
+ *
+ * Time source:
+ *   - Cortex-M with DWT: the CYCCNT register (one load per probe edge)
+ *   - other Zephyr targets (native_sim): k_cycle_get_32()
+ *   - host builds (tools/replay): clock_gettime(CLOCK_MONOTONIC) in ns
+ *
+ * Every probe has a single writer (the thread or ISR running that stage);
+ * readers may see a torn snapshot, which is fine for diagnostics.
+ *
+ *   PROF_START(PROF_FUSION);
+ *   fusion_update_batch(...);
+ *   PROF_STOP(PROF_FUSION);
+ */
+
+enum prof_probe {
+    PROF_IMU_DRAIN,         /* FIFO level read + I2C burst + parse */
+    PROF_CONTROL_STEP,      /* whole control step, batch to telemetry record */
+    PROF_FUSION,            /* calibration, Madgwick and activity over one batch */
+    PROF_POSTURE,           /* posture state machine, one step */
+    PROF_ACTUATE,           /* LED/LRA writes of one control step */
+    PROF_ADC_AVG,           /* averaging one ADC DMA buffer */
+    PROF_THERMISTOR,        /* code -> temperature conversion */
+    PROF_PELTIER_TICK,      /* one PI tick including the PWM write */
+    PROF_TELEM_SINK,        /* one record through the telemetry sink */
+    PROF_ACTIVITY,          /* activity classifier, one chunk (within fusion) */
+    PROF_COUNT,
+};
+
+/* Bucket b counts durations in [2^b, 2^(b+1)) cycles; bucket 0 also holds 0 */
+#define PROF_BUCKETS    32
+
+struct prof_hist {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t bucket[PROF_BUCKETS];
+};
+
+/* Derived figures, in nanoseconds */
+struct prof_summary {
+    uint32_t count;
+    uint32_t min_ns;
+    uint32_t mean_ns;
+    uint32_t p50_ns;
+    uint32_t p90_ns;
+    uint32_t p99_ns;
+    uint32_t max_ns;
+};
+
+/* ===== Time source ===== */
+#if defined(__ZEPHYR__)
+#include <zephyr/kernel.h>
+#if defined(CONFIG_CPU_CORTEX_M_HAS_DWT)
+#include <cmsis_core.h>
+
+static inline void prof_cycles_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t prof_cycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+static inline uint32_t prof_cycles_hz(void)
+{
+    return SystemCoreClock;
+}
+#else
+static inline void prof_cycles_init(void)
+{
+}
+
+static inline uint32_t prof_cycles(void)
+{
+    return k_cycle_get_32();
+}
+
+static inline uint32_t prof_cycles_hz(void)
+{
+    return sys_clock_hw_cycles_per_sec();
+}
+#endif
+#else
+#include <time.h>
+
+static inline void prof_cycles_init(void)
+{
+}
+
+/* One "cycle" per nanosecond; wraps every ~4.3 s, probes are much shorter */
+static inline uint32_t prof_cycles(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+static inline uint32_t prof_cycles_hz(void)
+{
+    return 1000000000u;
+}
+#endif
+
+/* ===== Probes ===== */
+#if defined(CONFIG_NECK_PROF)
+#define PROF_START(p)   uint32_t prof_t0_##p = prof_cycles()
+#define PROF_STOP(p)    prof_record((p), prof_cycles() - prof_t0_##p)
+#else
+#define PROF_START(p)   do { } while (0)
+#define PROF_STOP(p)    do { } while (0)
+#endif
+
+/* Enable the cycle counter and clear all histograms */
+void prof_init(void);
+
+void prof_reset(void);
+
+void prof_record(enum prof_probe p, uint32_t cycles);
+
+const char *prof_probe_name(enum prof_probe p);
+
+/* Probe by name; -1 when unknown */
+int prof_probe_find(const char *name);
+
+void prof_hist_get(enum prof_probe p, struct prof_hist *out);
+
+/* Percentiles are interpolated inside the log2 bucket, so they are only
+ * good to a factor of two at worst; min, max and mean are exact.
+ */
+void prof_summary_get(enum prof_probe p, struct prof_summary *out);
+
+#endif /* PROF_H_ */
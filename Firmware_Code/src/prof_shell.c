@@ -0,0 +1,83 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <errno.h>
+
+#include "prof.h"
+
+#if defined(CONFIG_NECK_PROF_SHELL)
+#include <zephyr/shell/shell.h>
+
+/* ===== prof shell command =====
+ *   prof show           one line per probe, times in us
+ *   prof hist <probe>   the log2 buckets of one probe
+ *   prof reset          clear all histograms
+ */
+static int cmd_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "%-11s %8s %8s %8s %8s %8s %8s %8s", "probe", "count", "min",
+                "mean", "p50", "p90", "p99", "max");
+    for (int p = 0; p < PROF_COUNT; p++) {
+        struct prof_summary s;
+
+        prof_summary_get(p, &s);
+        shell_print(sh, "%-11s %8u %6u.%u %6u.%u %6u.%u %6u.%u %6u.%u %6u.%u",
+                    prof_probe_name(p), s.count,
+                    s.min_ns / 1000, s.min_ns / 100 % 10,
+                    s.mean_ns / 1000, s.mean_ns / 100 % 10,
+                    s.p50_ns / 1000, s.p50_ns / 100 % 10,
+                    s.p90_ns / 1000, s.p90_ns / 100 % 10,
+                    s.p99_ns / 1000, s.p99_ns / 100 % 10,
+                    s.max_ns / 1000, s.max_ns / 100 % 10);
+    }
+    shell_print(sh, "times in us, cycle counter at %u Hz", prof_cycles_hz());
+    return 0;
+}
+
+static int cmd_hist(const struct shell *sh, size_t argc, char **argv)
+{
+    struct prof_hist h;
+    int p = prof_probe_find(argv[1]);
+
+    ARG_UNUSED(argc);
+
+    if (p < 0) {
+        shell_error(sh, "unknown probe %s", argv[1]);
+        return -ENOENT;
+    }
+    prof_hist_get(p, &h);
+    shell_print(sh, "%s: %u samples, cycles per bucket", prof_probe_name(p), h.count);
+    for (int b = 0; b < PROF_BUCKETS; b++) {
+        if (h.bucket[b]) {
+            shell_print(sh, "  [%10u, %10u) %u", b ? 1u << b : 0u,
+                        b < 31 ? 1u << (b + 1) : UINT32_MAX, h.bucket[b]);
+        }
+    }
+    return 0;
+}
+
+static int cmd_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    prof_reset();
+    shell_print(sh, "histograms cleared");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(prof_cmds,
+    SHELL_CMD(show, NULL, "Latency summary of every probe", cmd_show),
+    SHELL_CMD_ARG(hist, NULL, "Histogram of one probe: hist <probe>", cmd_hist, 2, 0),
+    SHELL_CMD(reset, NULL, "Clear all histograms", cmd_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(prof, &prof_cmds, "Pipeline cycle-count probes", NULL);
+
+#endif /* CONFIG_NECK_PROF_SHELL */
@@ -0,0 +1,78 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SPSC_RING_H_
+#define SPSC_RING_H_
+
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* ===== Lock-free single-producer / single-consumer ring =====
+ *
+ * head is written only by the producer and tail only by the consumer, so no
+ * lock is needed as long as each side stays on one thread (or ISR). Indexes
+ * are free-running and wrap naturally; capacity must be a power of two.
+ * A full ring rejects the new element and counts it in drops.
+ */
+struct spsc_ring {
+    uint8_t *buf;
+    uint32_t elem_size;
+    uint32_t mask;
+    atomic_t head;
+    atomic_t tail;
+    atomic_t drops;
+};
+
+#define SPSC_RING_DEFINE(name, type, capacity)                                  \
+    BUILD_ASSERT(IS_POWER_OF_TWO(capacity), #name " must be a power of two"); \
+    static type name##_storage[capacity];                                      \
+    static struct spsc_ring name = {                                           \
+        .buf = (uint8_t *)name##_storage,                                      \
+        .elem_size = sizeof(type),                                             \
+        .mask = (capacity) - 1,                                                \
+    }
+
+static inline uint32_t spsc_ring_count(struct spsc_ring *r)
+{
+    return (uint32_t)atomic_get(&r->head) - (uint32_t)atomic_get(&r->tail);
+}
+
+static inline uint32_t spsc_ring_drops(struct spsc_ring *r)
+{
+    return (uint32_t)atomic_get(&r->drops);
+}
+
+/* Producer side */
+static inline bool spsc_ring_put(struct spsc_ring *r, const void *elem)
+{
+    uint32_t head = (uint32_t)atomic_get(&r->head);
+    uint32_t tail = (uint32_t)atomic_get(&r->tail);
+
+    if (head - tail > r->mask) {
+        atomic_inc(&r->drops);
+        return false;
+    }
+    memcpy(&r->buf[(head & r->mask) * r->elem_size], elem, r->elem_size);
+    atomic_set(&r->head, (atomic_val_t)(head + 1));
+    return true;
+}
+
+/* Consumer side */
+static inline bool spsc_ring_get(struct spsc_ring *r, void *elem)
+{
+    uint32_t tail = (uint32_t)atomic_get(&r->tail);
+    uint32_t head = (uint32_t)atomic_get(&r->head);
+
+    if (head == tail) {
+        return false;
+    }
+    memcpy(elem, &r->buf[(tail & r->mask) * r->elem_size], r->elem_size);
+    atomic_set(&r->tail, (atomic_val_t)(tail + 1));
+    return true;
+}
+
+#endif /* SPSC_RING_H_ */
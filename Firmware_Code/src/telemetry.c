@@ -0,0 +1,210 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/logging/log.h>
+#include <stdio.h>
+
+#include "telemetry.h"
+#include "telem_wire.h"
+#include "imu_acq.h"
+#include "spsc_ring.h"
+#include "prof.h"
+#include "ble_svc.h"
+
+#if defined(CONFIG_NECK_TELEMETRY_BINARY)
+#if defined(CONFIG_USE_SEGGER_RTT)
+#include <SEGGER_RTT.h>
+#else
+#include <zephyr/sys/ring_buffer.h>
+#endif
+#endif
+
+LOG_MODULE_REGISTER(telemetry, LOG_LEVEL_INF);
+
+/* ===== Global Variables ===== */
+SPSC_RING_DEFINE(record_ring, struct ctrl_record, CONFIG_NECK_TELEMETRY_RING_SIZE);
+
+static K_SEM_DEFINE(record_sem, 0, CONFIG_NECK_TELEMETRY_RING_SIZE);
+
+#if defined(CONFIG_NECK_TELEMETRY_BINARY)
+#define DEFAULT_SINK    telemetry_sink_binary
+#else
+#define DEFAULT_SINK    telemetry_sink_console
+#endif
+
+static telemetry_sink_t sink = DEFAULT_SINK;
+static uint32_t binary_drops;
+
+static void telemetry_thread(void *p1, void *p2, void *p3);
+
+K_THREAD_DEFINE(telemetry_tid, CONFIG_NECK_TELEMETRY_STACK_SIZE,
+                telemetry_thread, NULL, NULL, NULL,
+                CONFIG_NECK_TELEMETRY_THREAD_PRIO, 0, K_TICKS_FOREVER);
+
+/* ===== Console sink: the original per-loop printf ===== */
+void telemetry_sink_console(const struct ctrl_record *rec)
+{
+    struct sensor_value acc[3], gyr[3];
+
+    for (int i = 0; i < 3; i++) {
+        imu_acc_to_sensor_value(rec->acc[i], &acc[i]);
+        imu_gyr_to_sensor_value(rec->gyr[i], &gyr[i]);
+    }
+
+    printf("AX: %d.%06d AY: %d.%06d AZ: %d.%06d  "
+           "GX: %d.%06d GY: %d.%06d GZ: %d.%06d  ",
+           acc[0].val1, acc[0].val2, acc[1].val1, acc[1].val2, acc[2].val1, acc[2].val2,
+           gyr[0].val1, gyr[0].val2, gyr[1].val1, gyr[1].val2, gyr[2].val1, gyr[2].val2);
+
+    printf("[Pitch=%.1f Roll=%.1f] ", rec->pitch_cdeg / 100.0, rec->roll_cdeg / 100.0);
+    if (rec->therm_mv >= 0) {
+        if (rec->temp_cdeg != INT16_MIN) {
+            printf("[Therm=%dmV, %.1fC] ", rec->therm_mv, rec->temp_cdeg / 100.0);
+        } else {
+            printf("[Therm=%dmV, N/A] ", rec->therm_mv);
+        }
+    }
+    printf("[LED=%s, ", rec->led_on ? "ON" : "OFF");
+    if (rec->peltier_permille) {
+        printf("Peltier=ON(%u.%u%%), ", rec->peltier_permille / 10, rec->peltier_permille % 10);
+    } else {
+        printf("Peltier=OFF, ");
+    }
+    printf("LRA=%s] [lat=%uus]\n", rec->lra_on ? "ON" : "OFF", rec->latency_us);
+}
+
+/* ===== Binary sink: packed records, no formatting =====
+ * Goes to RTT up-buffer CONFIG_NECK_TELEMETRY_RTT_CHANNEL when RTT is
+ * available (read on the host with JLinkRTTLogger + tools/telem_decode),
+ * otherwise into a deferred byte ring drained by telemetry_binary_read().
+ */
+#if defined(CONFIG_NECK_TELEMETRY_BINARY)
+#if defined(CONFIG_USE_SEGGER_RTT)
+static uint8_t rtt_buf[CONFIG_NECK_TELEMETRY_BUFFER_SIZE];
+#else
+RING_BUF_DECLARE(wire_ring, CONFIG_NECK_TELEMETRY_BUFFER_SIZE);
+#endif
+#endif
+
+#if defined(CONFIG_NECK_TELEMETRY_BINARY) || defined(CONFIG_NECK_BLE)
+/* Shared by the binary sink and the BLE stream, each with its own seq */
+static void record_to_wire(const struct ctrl_record *rec, uint16_t seq, struct telem_wire *w)
+{
+    w->seq = seq;
+    w->t_us = rec->t_us;
+    for (int i = 0; i < 3; i++) {
+        w->acc[i] = rec->acc[i];
+        w->gyr[i] = rec->gyr[i];
+    }
+    w->pitch_cdeg = rec->pitch_cdeg;
+    w->roll_cdeg = rec->roll_cdeg;
+    w->therm_mv = rec->therm_mv;
+    w->temp_cdeg = rec->temp_cdeg;
+    w->flags = (rec->led_on ? TELEM_F_LED : 0) |
+               (rec->peltier_permille ? TELEM_F_PELTIER : 0) |
+               (rec->lra_on ? TELEM_F_LRA : 0);
+    telem_wire_seal(w);
+}
+#endif
+
+void telemetry_sink_binary(const struct ctrl_record *rec)
+{
+#if defined(CONFIG_NECK_TELEMETRY_BINARY)
+    static uint16_t seq;
+    struct telem_wire w;
+
+    record_to_wire(rec, seq++, &w);
+
+#if defined(CONFIG_USE_SEGGER_RTT)
+    /* NO_BLOCK_SKIP: a record either fits whole or is dropped */
+    if (SEGGER_RTT_Write(CONFIG_NECK_TELEMETRY_RTT_CHANNEL, &w, sizeof(w)) == 0) {
+        binary_drops++;
+    }
+#else
+    if (ring_buf_space_get(&wire_ring) < sizeof(w)) {
+        binary_drops++;
+        return;
+    }
+    ring_buf_put(&wire_ring, (const uint8_t *)&w, sizeof(w));
+#endif
+#else
+    ARG_UNUSED(rec);
+#endif
+}
+
+static void telemetry_thread(void *p1, void *p2, void *p3)
+{
+    struct ctrl_record rec;
+#if defined(CONFIG_NECK_BLE)
+    uint16_t ble_seq = 0;
+#endif
+
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    while (1) {
+        k_sem_take(&record_sem, K_FOREVER);
+
+        while (spsc_ring_get(&record_ring, &rec)) {
+            uint32_t t0 = pipeline_now_us();
+
+            PROF_START(PROF_TELEM_SINK);
+            sink(&rec);
+            PROF_STOP(PROF_TELEM_SINK);
+
+#if defined(CONFIG_NECK_BLE)
+            /* Batched into notifications by ble_svc; never waits here */
+            struct telem_wire w;
+
+            record_to_wire(&rec, ble_seq++, &w);
+            ble_svc_stream_push(&w);
+#endif
+            pipeline_stage_record(STAGE_TELEMETRY, pipeline_now_us() - t0);
+        }
+    }
+}
+
+void telemetry_start(void)
+{
+#if defined(CONFIG_NECK_TELEMETRY_BINARY) && defined(CONFIG_USE_SEGGER_RTT)
+    SEGGER_RTT_ConfigUpBuffer(CONFIG_NECK_TELEMETRY_RTT_CHANNEL, "telemetry",
+                              rtt_buf, sizeof(rtt_buf), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+#endif
+    pipeline_stage_init(STAGE_TELEMETRY, 0);
+    k_thread_start(telemetry_tid);
+}
+
+void telemetry_set_sink(telemetry_sink_t new_sink)
+{
+    sink = new_sink ? new_sink : DEFAULT_SINK;
+}
+
+size_t telemetry_binary_read(uint8_t *buf, size_t len)
+{
+#if defined(CONFIG_NECK_TELEMETRY_BINARY) && !defined(CONFIG_USE_SEGGER_RTT)
+    return ring_buf_get(&wire_ring, buf, len);
+#else
+    ARG_UNUSED(buf);
+    ARG_UNUSED(len);
+    return 0;
+#endif
+}
+
+uint32_t telemetry_binary_drops(void)
+{
+    return binary_drops;
+}
+
+bool telemetry_push(const struct ctrl_record *rec)
+{
+    if (!spsc_ring_put(&record_ring, rec)) {
+        pipeline_stage_overrun(STAGE_CONTROL, 1);
+        return false;
+    }
+    k_sem_give(&record_sem);
+    return true;
+}
@@ -0,0 +1,38 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pipeline.h"
+
+/* Output for one record; runs on the low-priority telemetry thread */
+typedef void (*telemetry_sink_t)(const struct ctrl_record *rec);
+
+/* Built-in sinks: the original text line, or packed telem_wire records */
+void telemetry_sink_console(const struct ctrl_record *rec);
+void telemetry_sink_binary(const struct ctrl_record *rec);
+
+/* Start the telemetry thread with the sink chosen in Kconfig */
+void telemetry_start(void);
+
+/* Replace the sink (e.g. a deliberately slow one in tests); NULL restores
+ * the default
+ */
+void telemetry_set_sink(telemetry_sink_t sink);
+
+/* Drain packed records from the deferred ring (builds without RTT only) */
+size_t telemetry_binary_read(uint8_t *buf, size_t len);
+
+/* Records the binary sink could not fit into RTT / the deferred ring */
+uint32_t telemetry_binary_drops(void);
+
+/* Non-blocking hand-off from the control thread; false if the ring is full */
+bool telemetry_push(const struct ctrl_record *rec);
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,157 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include "therm_guard.h"
+
+static const char *const names[THERM_TRIP_COUNT] = {
+    [THERM_TRIP_NONE] = "none",
+    [THERM_TRIP_SENSOR] = "sensor",
+    [THERM_TRIP_OVER_TEMP] = "over_temp",
+    [THERM_TRIP_RISE] = "rise",
+    [THERM_TRIP_RUNAWAY] = "runaway",
+    [THERM_TRIP_ADC_STALE] = "adc_stale",
+    [THERM_TRIP_CTRL_STALE] = "ctrl_stale",
+    [THERM_TRIP_LOOP_STALE] = "loop_stale",
+};
+
+/* Wrap-safe "a is at least ms after b" */
+static bool elapsed(uint32_t a, uint32_t b, uint32_t ms)
+{
+    return (int32_t)(a - b) >= 0 && a - b >= ms;
+}
+
+void therm_guard_init(struct therm_guard *g, const struct therm_guard_params *p)
+{
+    memset(g, 0, sizeof(*g));
+    g->p = *p;
+}
+
+void therm_guard_resume(struct therm_guard *g, uint32_t t_ms)
+{
+    g->slots = 0;
+    g->active = false;
+    g->follow_ms = t_ms;
+    g->clear = false;
+}
+
+const char *therm_trip_name(enum therm_trip t)
+{
+    return t < THERM_TRIP_COUNT ? names[t] : "?";
+}
+
+/* Temperature slope in 0.01 degC/s against the oldest reading kept, over
+ * at least half the window; false until there is one
+ */
+static bool slope(struct therm_guard *g, const struct therm_guard_in *in, int32_t *out,
+                  uint32_t *from_ms)
+{
+    uint32_t every = g->p.rise_window_ms / THERM_GUARD_SLOTS;
+    uint8_t newest = (uint8_t)((g->head + THERM_GUARD_SLOTS - 1) % THERM_GUARD_SLOTS);
+
+    if (g->slots == 0 || elapsed(in->t_ms, g->slot_ms[newest], every ? every : 1)) {
+        g->slot_ms[g->head] = in->t_ms;
+        g->slot_cdeg[g->head] = in->temp_cdeg;
+        g->head = (uint8_t)((g->head + 1) % THERM_GUARD_SLOTS);
+        if (g->slots < THERM_GUARD_SLOTS) {
+            g->slots++;
+        }
+    }
+
+    uint8_t oldest = (uint8_t)((g->head + THERM_GUARD_SLOTS - g->slots) % THERM_GUARD_SLOTS);
+    uint32_t span = in->t_ms - g->slot_ms[oldest];
+
+    if (span < g->p.rise_window_ms / 2u || span == 0) {
+        return false;
+    }
+    *out = ((int32_t)in->temp_cdeg - g->slot_cdeg[oldest]) * 1000 / (int32_t)span;
+    *from_ms = g->slot_ms[oldest];
+    return true;
+}
+
+static enum therm_trip check(struct therm_guard *g, const struct therm_guard_in *in)
+{
+    const struct therm_guard_params *p = &g->p;
+    bool active = in->cue || in->heating;
+    int32_t rise;
+    uint32_t from;
+
+    if (active && !g->active) {
+        g->active_ms = in->t_ms;
+    }
+    g->active = active;
+    if (in->heating) {
+        g->heat_ms = in->t_ms;
+    }
+    if (in->cue || !in->heating) {
+        g->follow_ms = in->t_ms;
+    }
+
+    if (in->temp_cdeg == INT16_MIN || in->temp_cdeg < p->min_cdeg || in->temp_cdeg > p->max_cdeg) {
+        g->slots = 0;
+        if (active) {
+            return THERM_TRIP_SENSOR;
+        }
+    } else if (in->temp_cdeg > p->cutoff_cdeg) {
+        return THERM_TRIP_OVER_TEMP;
+    } else if (slope(g, in, &rise, &from)) {
+        if (rise > p->rise_cdeg_per_s) {
+            return THERM_TRIP_RISE;
+        }
+        /* Off since before the window, and a sensor lag more: heat still
+         * on its way from the Peltier to the NTC is not a runaway
+         */
+        if (rise > p->runaway_cdeg_per_s && in->temp_cdeg > p->runaway_min_cdeg && !in->heating &&
+            elapsed(from, g->heat_ms, p->rise_window_ms)) {
+            return THERM_TRIP_RUNAWAY;
+        }
+    }
+
+    /* Staleness counts from when the Peltiers were first wanted */
+    if (active) {
+        uint32_t adc = elapsed(in->adc_ms, g->active_ms, 0) ? in->adc_ms : g->active_ms;
+
+        if (elapsed(in->t_ms, adc, p->stale_ms + 1u)) {
+            return THERM_TRIP_ADC_STALE;
+        }
+    }
+    if (in->cue && elapsed(in->t_ms, in->ctrl_ms, p->ctrl_stale_ms + 1u)) {
+        return THERM_TRIP_CTRL_STALE;
+    }
+    if (elapsed(in->t_ms, g->follow_ms, p->ctrl_stale_ms + 1u)) {
+        return THERM_TRIP_LOOP_STALE;
+    }
+    return THERM_TRIP_NONE;
+}
+
+enum therm_trip therm_guard_step(struct therm_guard *g, const struct therm_guard_in *in)
+{
+    enum therm_trip seen = check(g, in);
+
+    g->seen = (uint8_t)seen;
+    if (g->trip == THERM_TRIP_NONE) {
+        if (seen != THERM_TRIP_NONE) {
+            g->trip = (uint8_t)seen;
+            g->trip_ms = in->t_ms;
+            g->trips[seen]++;
+            g->clear = false;
+        }
+        return (enum therm_trip)g->trip;
+    }
+
+    /* Re-arm: a cool, plausible reading and nothing wrong, for hold_ms */
+    bool ok = seen == THERM_TRIP_NONE && !in->heating && in->temp_cdeg != INT16_MIN &&
+              in->temp_cdeg >= g->p.min_cdeg && in->temp_cdeg <= g->p.rearm_cdeg;
+
+    if (!ok) {
+        g->clear = false;
+    } else if (!g->clear) {
+        g->clear = true;
+        g->clear_ms = in->t_ms;
+    } else if (elapsed(in->t_ms, g->clear_ms, g->p.hold_ms)) {
+        g->trip = THERM_TRIP_NONE;
+    }
+    return (enum therm_trip)g->trip;
+}
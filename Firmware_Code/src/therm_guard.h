@@ -0,0 +1,107 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef THERM_GUARD_H_
+#define THERM_GUARD_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== Thermal safety checks =====
+ *
+ * Pure computation, no Zephyr dependencies, so the same code runs in the
+ * supervisor thread (therm_sup.c) and against the plant model with
+ * injected faults in tools/therm_sup_check. One observation per period;
+ * trips on
+ *
+ *   SENSOR      reading missing or outside min_cdeg..max_cdeg (open or
+ *               shorted thermistor read as the ends of the table)
+ *   OVER_TEMP   reading above cutoff_cdeg
+ *   RISE        rising faster than rise_cdeg_per_s over rise_window_ms
+ *   RUNAWAY     above runaway_min_cdeg and rising faster than
+ *               runaway_cdeg_per_s over the window with the Peltiers off
+ *               all along: heat nobody asked for (warming up to skin
+ *               temperature after the patch is put on stays below)
+ *   ADC_STALE   no new ADC reading for stale_ms
+ *   CTRL_STALE  cue on, but not renewed by the control thread for
+ *               ctrl_stale_ms (IMU bus failure, control thread stuck)
+ *   LOOP_STALE  Peltiers still driven ctrl_stale_ms after the cue went
+ *               off (Peltier loop stuck)
+ *
+ * SENSOR and ADC_STALE only count while the cue is on or the Peltiers are
+ * driven; the ADC pauses with the IMU otherwise. A trip
+ * latches. It re-arms after hold_ms in a row without any fault, with the
+ * Peltiers off and the reading at or below rearm_cdeg.
+ */
+
+enum therm_trip {
+    THERM_TRIP_NONE,
+    THERM_TRIP_SENSOR,
+    THERM_TRIP_OVER_TEMP,
+    THERM_TRIP_RISE,
+    THERM_TRIP_RUNAWAY,
+    THERM_TRIP_ADC_STALE,
+    THERM_TRIP_CTRL_STALE,
+    THERM_TRIP_LOOP_STALE,
+    THERM_TRIP_COUNT,
+};
+
+struct therm_guard_params {
+    int16_t cutoff_cdeg;
+    int16_t rearm_cdeg;
+    int16_t min_cdeg;           /* plausible readings */
+    int16_t max_cdeg;
+    int16_t runaway_min_cdeg;
+    uint16_t rise_cdeg_per_s;
+    uint16_t runaway_cdeg_per_s;
+    uint16_t rise_window_ms;
+    uint16_t stale_ms;
+    uint16_t ctrl_stale_ms;
+    uint32_t hold_ms;
+};
+
+struct therm_guard_in {
+    uint32_t t_ms;
+    int16_t temp_cdeg;          /* INT16_MIN when no reading */
+    uint32_t adc_ms;            /* when the newest ADC reading came in */
+    uint32_t ctrl_ms;           /* when the control thread last set the cue */
+    bool cue;
+    bool heating;               /* some Peltier duty commanded */
+};
+
+#define THERM_GUARD_SLOTS   8   /* rise window samples */
+
+struct therm_guard {
+    struct therm_guard_params p;
+    uint8_t trip;               /* enum therm_trip latched, NONE when armed */
+    uint8_t seen;               /* what the last step found */
+    bool active;
+    bool clear;                 /* tripped, fault-free since clear_ms */
+    uint32_t active_ms;         /* cue or heating since */
+    uint32_t heat_ms;           /* last step with the Peltiers driven */
+    uint32_t follow_ms;         /* last step with the cue on or nothing driven */
+    uint32_t clear_ms;
+    uint32_t trip_ms;
+    /* One reading every rise_window_ms / THERM_GUARD_SLOTS */
+    uint32_t slot_ms[THERM_GUARD_SLOTS];
+    int16_t slot_cdeg[THERM_GUARD_SLOTS];
+    uint8_t slots;
+    uint8_t head;
+    uint32_t trips[THERM_TRIP_COUNT];
+};
+
+void therm_guard_init(struct therm_guard *g, const struct therm_guard_params *p);
+
+/* After a gap in the observations (supervisor paused): drop the rise
+ * window and date the staleness baselines from t_ms. A latched trip stays,
+ * and its hold_ms starts over.
+ */
+void therm_guard_resume(struct therm_guard *g, uint32_t t_ms);
+
+/* One observation; returns the latched trip, THERM_TRIP_NONE when armed */
+enum therm_trip therm_guard_step(struct therm_guard *g, const struct therm_guard_in *in);
+
+const char *therm_trip_name(enum therm_trip t);
+
+#endif /* THERM_GUARD_H_ */
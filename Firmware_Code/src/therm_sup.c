@@ -0,0 +1,254 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+#include "therm_sup.h"
+#include "actuators.h"
+#include "adc_stream.h"
+#include "journal.h"
+#include "peltier_ctrl.h"
+#include "thermistor.h"
+
+LOG_MODULE_REGISTER(therm_sup, LOG_LEVEL_INF);
+
+#if defined(CONFIG_NECK_THERM_SUP)
+
+/* ===== Global Variables ===== */
+static struct therm_guard guard;        /* supervisor thread only */
+static struct therm_sup_stats stats;
+static struct k_spinlock stats_lock;
+static atomic_t tripped;
+static atomic_t stopped;            /* by therm_sup_pause() */
+
+/* Newest ADC buffer seen, and when; supervisor thread only */
+static uint32_t adc_buffers;
+static uint32_t adc_ms;
+
+static K_TIMER_DEFINE(period_timer, NULL, NULL);
+static K_SEM_DEFINE(resume_sem, 0, 1);
+
+static void sup_thread(void *p1, void *p2, void *p3);
+K_THREAD_DEFINE(therm_sup_tid, CONFIG_NECK_THERM_SUP_STACK_SIZE, sup_thread, NULL, NULL, NULL,
+                CONFIG_NECK_THERM_SUP_THREAD_PRIO, 0, K_TICKS_FOREVER);
+
+/* ===== Observation ===== */
+static bool peltiers_driven(void)
+{
+    for (size_t i = 0; i < actuators_count(ACT_PELTIER); i++) {
+        struct act_channel_stats s;
+
+        if (actuators_stats_get(ACT_PELTIER, i, &s) == 0 && s.duty_permille) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* New ADC buffers since the last period date the reading */
+static void observe(struct therm_guard_in *in)
+{
+    struct adc_stream_stats as;
+    int16_t code;
+
+    in->t_ms = k_uptime_get_32();
+    adc_stream_stats_get(&as);
+    if (as.buffers != adc_buffers) {
+        adc_buffers = as.buffers;
+        adc_ms = in->t_ms;
+    }
+    in->adc_ms = adc_ms;
+    in->temp_cdeg = INT16_MIN;
+    if (adc_stream_latest(ADC_CH_THERM, &code) == 0) {
+        in->temp_cdeg = thermistor_cdeg_from_code(code);
+    }
+    in->cue = peltier_ctrl_request_get(&in->ctrl_ms);
+    in->heating = peltiers_driven();
+}
+
+/* ===== Supervisor thread ===== */
+static void sup_thread(void *p1, void *p2, void *p3)
+{
+    const struct therm_guard_params params = {
+        .cutoff_cdeg = CONFIG_NECK_PELTIER_TEMP_CUTOFF_CDEG,
+        .rearm_cdeg = CONFIG_NECK_PELTIER_TEMP_CUTOFF_CDEG - CONFIG_NECK_THERM_SUP_REARM_CDEG,
+        .min_cdeg = CONFIG_NECK_THERM_SUP_MIN_CDEG,
+        .max_cdeg = CONFIG_NECK_THERM_SUP_MAX_CDEG,
+        .runaway_min_cdeg = CONFIG_NECK_THERM_SUP_RUNAWAY_MIN_CDEG,
+        .rise_cdeg_per_s = CONFIG_NECK_THERM_SUP_RISE_CDEG_PER_S,
+        .runaway_cdeg_per_s = CONFIG_NECK_THERM_SUP_RUNAWAY_CDEG_PER_S,
+        .rise_window_ms = CONFIG_NECK_THERM_SUP_RISE_WINDOW_MS,
+        .stale_ms = CONFIG_NECK_THERM_SUP_ADC_STALE_MS,
+        .ctrl_stale_ms = CONFIG_NECK_THERM_SUP_CTRL_STALE_MS,
+        .hold_ms = CONFIG_NECK_THERM_SUP_HOLD_S * 1000u,
+    };
+
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    therm_guard_init(&guard, &params);
+    if (!atomic_get(&stopped)) {
+        k_timer_start(&period_timer, K_MSEC(CONFIG_NECK_THERM_SUP_PERIOD_MS),
+                      K_MSEC(CONFIG_NECK_THERM_SUP_PERIOD_MS));
+    }
+
+    while (1) {
+        uint32_t periods = k_timer_status_sync(&period_timer);
+
+        /* Stopped by therm_sup_pause(): sleep until it resumes, then
+         * restart the staleness checks from now
+         */
+        if (periods == 0) {
+            struct adc_stream_stats as;
+
+            k_sem_take(&resume_sem, K_FOREVER);
+            if (atomic_get(&stopped)) {
+                continue;   /* paused again before this thread ran */
+            }
+            adc_stream_stats_get(&as);
+            adc_buffers = as.buffers;
+            adc_ms = k_uptime_get_32();
+            therm_guard_resume(&guard, adc_ms);
+            k_timer_start(&period_timer, K_MSEC(CONFIG_NECK_THERM_SUP_PERIOD_MS),
+                          K_MSEC(CONFIG_NECK_THERM_SUP_PERIOD_MS));
+            continue;
+        }
+
+        uint32_t c0 = k_cycle_get_32();
+        struct therm_guard_in in;
+        enum therm_trip was = (enum therm_trip)atomic_get(&tripped);
+        uint32_t cut_us = 0;
+
+        observe(&in);
+
+        enum therm_trip t = therm_guard_step(&guard, &in);
+
+        /* Every period while tripped, so that a failed write is retried */
+        if (t != THERM_TRIP_NONE) {
+            actuators_inhibit(ACT_PELTIER, true);
+            cut_us = k_cyc_to_us_floor32(k_cycle_get_32() - c0);
+        } else if (was != THERM_TRIP_NONE) {
+            actuators_inhibit(ACT_PELTIER, false);
+        }
+        atomic_set(&tripped, t);
+
+        uint32_t check_us = k_cyc_to_us_floor32(k_cycle_get_32() - c0);
+        k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+        stats.checks++;
+        stats.missed += periods > 1 ? periods - 1 : 0;
+        stats.tripped = (uint8_t)t;
+        stats.check_us_max = MAX(stats.check_us_max, check_us);
+        if (t != THERM_TRIP_NONE && was == THERM_TRIP_NONE) {
+            stats.trips[t]++;
+            stats.last_trip = (uint8_t)t;
+            stats.last_trip_cdeg = in.temp_cdeg;
+            stats.last_trip_ms = in.t_ms;
+            stats.cut_us_last = cut_us;
+            stats.cut_us_max = MAX(stats.cut_us_max, cut_us);
+        }
+        k_spin_unlock(&stats_lock, key);
+
+        if (t != was) {
+            journal_add(JRNL_TRIP, t, in.temp_cdeg);
+            if (t != THERM_TRIP_NONE) {
+                LOG_WRN("Peltiers cut: %s at %d cdeg, off in %u us", therm_trip_name(t),
+                        in.temp_cdeg, cut_us);
+            } else {
+                LOG_INF("Peltiers re-armed after %s", therm_trip_name(was));
+            }
+        }
+    }
+}
+
+#endif /* CONFIG_NECK_THERM_SUP */
+
+/* ===== Public API ===== */
+int therm_sup_init(void)
+{
+#if defined(CONFIG_NECK_THERM_SUP)
+    k_thread_name_set(therm_sup_tid, "therm_sup");
+    k_thread_start(therm_sup_tid);
+    LOG_INF("Thermal supervisor every %d ms, cut-off %d cdeg", CONFIG_NECK_THERM_SUP_PERIOD_MS,
+            CONFIG_NECK_PELTIER_TEMP_CUTOFF_CDEG);
+#endif
+    return 0;
+}
+
+enum therm_trip therm_sup_tripped(void)
+{
+#if defined(CONFIG_NECK_THERM_SUP)
+    return (enum therm_trip)atomic_get(&tripped);
+#else
+    return THERM_TRIP_NONE;
+#endif
+}
+
+void therm_sup_pause(bool paused)
+{
+#if defined(CONFIG_NECK_THERM_SUP)
+    if (!paused) {
+        /* The supervisor runs above the caller: re-armed before this returns */
+        if (atomic_cas(&stopped, 1, 0)) {
+            k_sem_give(&resume_sem);
+        }
+        return;
+    }
+    if (atomic_cas(&stopped, 0, 1)) {
+        k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+        stats.pauses++;
+        k_spin_unlock(&stats_lock, key);
+        k_timer_stop(&period_timer);
+    }
+#else
+    ARG_UNUSED(paused);
+#endif
+}
+
+void therm_sup_stats_get(struct therm_sup_stats *out)
+{
+#if defined(CONFIG_NECK_THERM_SUP)
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+    *out = stats;
+    k_spin_unlock(&stats_lock, key);
+#else
+    memset(out, 0, sizeof(*out));
+#endif
+}
+
+#if defined(CONFIG_NECK_THERM_SUP) && defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+
+/* ===== therm shell command ===== */
+static int cmd_therm(const struct shell *sh, size_t argc, char **argv)
+{
+    struct therm_sup_stats s;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    therm_sup_stats_get(&s);
+    shell_print(sh, "state %s, %u checks, %u periods missed, %u pauses",
+                therm_trip_name(s.tripped), s.checks, s.missed, s.pauses);
+    for (int t = THERM_TRIP_NONE + 1; t < THERM_TRIP_COUNT; t++) {
+        shell_print(sh, "  %-10s %u", therm_trip_name(t), s.trips[t]);
+    }
+    if (s.last_trip != THERM_TRIP_NONE) {
+        shell_print(sh, "last trip %s at %d cdeg, uptime %u ms", therm_trip_name(s.last_trip),
+                    s.last_trip_cdeg, s.last_trip_ms);
+    }
+    shell_print(sh, "cut-off %u us last, %u us max; check %u us max; bound %u ms + check",
+                s.cut_us_last, s.cut_us_max, s.check_us_max, CONFIG_NECK_THERM_SUP_PERIOD_MS);
+    return 0;
+}
+
+SHELL_CMD_REGISTER(therm, NULL, "Thermal supervisor trips and cut-off latency", cmd_therm);
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef THERM_SUP_H_
+#define THERM_SUP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "therm_guard.h"
+
+/* ===== Thermal safety supervisor =====
+ *
+ * Watches the Peltiers independently of the IMU path and of the PI loop:
+ * its own thread, above every other application thread, wakes on a
+ * k_timer every CONFIG_NECK_THERM_SUP_PERIOD_MS, reads the thermistor's
+ * latest ADC average itself and runs the checks of therm_guard.h. On a
+ * trip it inhibits the Peltier group in the actuator layer
+ * (actuators_inhibit()), which writes zero duty at once and holds every
+ * later write at zero until the supervisor re-arms; the PI loop sees the
+ * trip and resets.
+ *
+ * A fault is acted on within one period of becoming visible: the cut-off
+ * latency is bounded by the period, plus the check and one PWM write, both
+ * timed here. The staleness limits add their own delay by design.
+ *
+ * While the IMU is in low power the Peltier loop is suspended with the
+ * outputs off and the ADC paused; therm_sup_pause() stops the period timer
+ * as well, so the supervisor does not wake the SoC for nothing. Resuming
+ * dates the staleness checks from then on, before the Peltiers may run.
+ *
+ * Compiled to no-ops (never tripped) without CONFIG_NECK_THERM_SUP.
+ */
+
+struct therm_sup_stats {
+    uint32_t checks;
+    uint32_t missed;            /* periods the thread woke too late for */
+    uint32_t pauses;            /* therm_sup_pause() stops */
+    uint32_t trips[THERM_TRIP_COUNT];
+    uint8_t tripped;            /* enum therm_trip now, NONE when armed */
+    uint8_t last_trip;
+    int16_t last_trip_cdeg;
+    uint32_t last_trip_ms;      /* uptime */
+    uint32_t cut_us_last;       /* trip found -> Peltiers written off */
+    uint32_t cut_us_max;
+    uint32_t check_us_max;      /* one whole period's work */
+};
+
+/* Start the supervisor; after actuators_init() and adc_stream_init(),
+ * before the Peltier loop
+ */
+int therm_sup_init(void);
+
+/* Latched trip, THERM_TRIP_NONE when the Peltiers may run */
+enum therm_trip therm_sup_tripped(void);
+
+/* Stop the checks (after peltier_ctrl_suspend(true)) or restart them with
+ * fresh baselines (before peltier_ctrl_suspend(false))
+ */
+void therm_sup_pause(bool paused);
+
+void therm_sup_stats_get(struct therm_sup_stats *out);
+
+#endif /* THERM_SUP_H_ */
@@ -0,0 +1,34 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "thermistor.h"
+#include "therm_lut.h"
+
+#define CODE_MAX    ((1 << THERM_LUT_ADC_BITS) - 1)
+#define FRAC_MASK   ((1 << THERM_LUT_SHIFT) - 1)
+
+int16_t thermistor_cdeg_from_code(int32_t code)
+{
+    if (code < 0) {
+        code = 0;
+    } else if (code > CODE_MAX) {
+        code = CODE_MAX;
+    }
+
+    /* The table has one entry past the last code, so i + 1 is always valid */
+    uint32_t i = (uint32_t)code >> THERM_LUT_SHIFT;
+    int32_t frac = code & FRAC_MASK;
+    int32_t t0 = therm_lut_cdeg[i];
+    int32_t t1 = therm_lut_cdeg[i + 1];
+
+    int32_t t = t0 + (((t1 - t0) * frac + (1 << THERM_LUT_SHIFT) / 2) >> THERM_LUT_SHIFT);
+
+    if (t < THERM_LUT_CDEG_MIN) {
+        return THERM_LUT_CDEG_MIN;
+    }
+    if (t > THERM_LUT_CDEG_MAX) {
+        return THERM_LUT_CDEG_MAX;
+    }
+    return (int16_t)t;
+}
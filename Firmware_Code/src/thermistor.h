@@ -0,0 +1,23 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef THERMISTOR_H_
+#define THERMISTOR_H_
+
+#include <stdint.h>
+
+/* ===== Thermistor conversion =====
+ *
+ * Raw SAADC code -> temperature through a table generated at build time
+ * (scripts/gen_therm_lut.py, parameters in Kconfig "Thermistor"). Integer
+ * only, no libm; safe to build on the host as well.
+ */
+
+/* Temperature in centi-degrees C, clamped to the table range (-40..125 C).
+ * Codes outside 0..4095 (the SAADC can report small negative values) are
+ * clamped to the ends of the table.
+ */
+int16_t thermistor_cdeg_from_code(int32_t code);
+
+#endif /* THERMISTOR_H_ */
@@ -0,0 +1,116 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "trace_rec.h"
+#include "trace_wire.h"
+
+#if defined(CONFIG_NECK_TRACE_RECORD)
+#if defined(CONFIG_USE_SEGGER_RTT)
+#include <SEGGER_RTT.h>
+#else
+#include <zephyr/sys/ring_buffer.h>
+#endif
+#endif
+
+LOG_MODULE_REGISTER(trace_rec, LOG_LEVEL_INF);
+
+/* ===== Output =====
+ * Same transport as the binary telemetry: an RTT up-buffer
+ * (JLinkRTTLogger -RTTChannel CONFIG_NECK_TRACE_RTT_CHANNEL), or a deferred
+ * byte ring drained by trace_rec_read(). A chunk is written whole or not at
+ * all; after a dropped chunk the next one starts with an absolute timestamp.
+ */
+#if defined(CONFIG_NECK_TRACE_RECORD)
+#if defined(CONFIG_USE_SEGGER_RTT)
+static uint8_t rtt_buf[CONFIG_NECK_TRACE_BUFFER_SIZE];
+#else
+RING_BUF_DECLARE(trace_ring, CONFIG_NECK_TRACE_BUFFER_SIZE);
+#endif
+
+/* Encoded records of one batch, written with a single call */
+#define CHUNK_SIZE      (2 * CONFIG_NECK_IMU_FIFO_WATERMARK * TRACE_REC_MAX + TRACE_REC_MAX)
+
+static uint8_t chunk[CHUNK_SIZE];
+static struct trace_enc enc;
+
+static bool write_chunk(const uint8_t *buf, size_t len)
+{
+#if defined(CONFIG_USE_SEGGER_RTT)
+    /* NO_BLOCK_SKIP: the chunk either fits whole or is dropped */
+    return SEGGER_RTT_Write(CONFIG_NECK_TRACE_RTT_CHANNEL, buf, len) != 0;
+#else
+    if (ring_buf_space_get(&trace_ring) < len) {
+        return false;
+    }
+    ring_buf_put(&trace_ring, buf, len);
+    return true;
+#endif
+}
+#endif
+
+static uint32_t drops;
+
+void trace_rec_start(void)
+{
+#if defined(CONFIG_NECK_TRACE_RECORD)
+    const struct trace_hdr hdr = {
+        .magic = TRACE_MAGIC,
+        .version = TRACE_VERSION,
+        .odr_hz = CONFIG_NECK_IMU_ODR_HZ,
+        .watermark = CONFIG_NECK_IMU_FIFO_WATERMARK,
+        .adc_full_scale_mv = CONFIG_NECK_ADC_FULL_SCALE_MV,
+    };
+
+#if defined(CONFIG_USE_SEGGER_RTT)
+    SEGGER_RTT_ConfigUpBuffer(CONFIG_NECK_TRACE_RTT_CHANNEL, "trace",
+                              rtt_buf, sizeof(rtt_buf), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+#endif
+    trace_enc_resync(&enc);
+    if (!write_chunk((const uint8_t *)&hdr, sizeof(hdr))) {
+        drops++;
+    }
+    LOG_INF("Recording sensor trace");
+#endif
+}
+
+void trace_rec_batch(const struct imu_sample *batch, size_t n, int16_t therm, int16_t aux)
+{
+#if defined(CONFIG_NECK_TRACE_RECORD)
+    size_t len = 0;
+
+    for (size_t i = 0; i < n && len + 2 * TRACE_REC_MAX <= sizeof(chunk); i++) {
+        len += trace_enc_imu(&enc, &batch[i], chunk + len);
+    }
+    len += trace_enc_adc(&enc, batch[n - 1].t_us, therm, aux, chunk + len);
+
+    if (!write_chunk(chunk, len)) {
+        drops++;
+        trace_enc_resync(&enc);
+    }
+#else
+    ARG_UNUSED(batch);
+    ARG_UNUSED(n);
+    ARG_UNUSED(therm);
+    ARG_UNUSED(aux);
+#endif
+}
+
+size_t trace_rec_read(uint8_t *buf, size_t len)
+{
+#if defined(CONFIG_NECK_TRACE_RECORD) && !defined(CONFIG_USE_SEGGER_RTT)
+    return ring_buf_get(&trace_ring, buf, len);
+#else
+    ARG_UNUSED(buf);
+    ARG_UNUSED(len);
+    return 0;
+#endif
+}
+
+uint32_t trace_rec_drops(void)
+{
+    return drops;
+}
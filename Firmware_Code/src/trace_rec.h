@@ -0,0 +1,32 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TRACE_REC_H_
+#define TRACE_REC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "imu_sample.h"
+
+/* ===== Sensor trace recorder =====
+ *
+ * Streams the raw inputs of the control path (trace_wire.h) so a wear
+ * session can be replayed on the host with tools/replay. Called from the
+ * control thread only. Compiled to no-ops without CONFIG_NECK_TRACE_RECORD.
+ */
+
+/* Write the trace header; call once before the first batch */
+void trace_rec_start(void);
+
+/* One FIFO batch plus the ADC values the decision was made with */
+void trace_rec_batch(const struct imu_sample *batch, size_t n, int16_t therm, int16_t aux);
+
+/* Drain the trace from the deferred ring (builds without RTT only) */
+size_t trace_rec_read(uint8_t *buf, size_t len);
+
+/* Chunks that did not fit into RTT / the deferred ring */
+uint32_t trace_rec_drops(void);
+
+#endif /* TRACE_REC_H_ */
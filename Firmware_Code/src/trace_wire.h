@@ -0,0 +1,209 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TRACE_WIRE_H_
+#define TRACE_WIRE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "imu_sample.h"
+
+/* ===== Sensor trace format =====
+ *
+ * Raw inputs of the control path as recorded by trace_rec.c and replayed by
+ * tools/replay. Little-endian, shared with the host, so keep it free of
+ * Zephyr headers.
+ *
+ * A trace is one trace_hdr followed by tagged records. Timestamps are
+ * deltas from the previous record; a TIME record carries an absolute
+ * timestamp at the start, after any gap longer than 65 ms, and after
+ * records were dropped, so a reader never accumulates a wrong time.
+ *
+ *   TIME   5 bytes   absolute t_us
+ *   IMU   15 bytes   raw accel + gyro counts, as drained from the FIFO
+ *   ADC    7 bytes   averaged thermistor and aux codes, once per batch
+ *
+ * A 100 Hz IMU with a 10-frame watermark records ~1.6 kB/s, about
+ * 5.6 MB per hour of wear.
+ */
+#define TRACE_MAGIC         "NKTR"
+#define TRACE_VERSION       1
+
+enum trace_tag {
+    TRACE_TAG_TIME = 0x54,      /* 'T' */
+    TRACE_TAG_IMU = 0x49,       /* 'I' */
+    TRACE_TAG_ADC = 0x41,       /* 'A' */
+};
+
+struct trace_hdr {
+    char magic[4];
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t odr_hz;            /* nominal IMU rate; records carry real timestamps */
+    uint16_t watermark;         /* frames per FIFO batch */
+    uint16_t adc_full_scale_mv;
+} __attribute__((packed));
+
+struct trace_rec_time {
+    uint8_t tag;
+    uint32_t t_us;
+} __attribute__((packed));
+
+struct trace_rec_imu {
+    uint8_t tag;
+    uint16_t dt_us;
+    int16_t acc[3];
+    int16_t gyr[3];
+} __attribute__((packed));
+
+struct trace_rec_adc {
+    uint8_t tag;
+    uint16_t dt_us;
+    int16_t therm;              /* -1 when no conversion was available */
+    int16_t aux;
+} __attribute__((packed));
+
+_Static_assert(sizeof(struct trace_hdr) == 12, "trace header size changed");
+_Static_assert(sizeof(struct trace_rec_imu) == 15, "trace IMU record size changed");
+_Static_assert(sizeof(struct trace_rec_adc) == 7, "trace ADC record size changed");
+
+/* Longest encoding of one sample: TIME + IMU */
+#define TRACE_REC_MAX       (sizeof(struct trace_rec_time) + sizeof(struct trace_rec_imu))
+
+/* ===== Encoder ===== */
+struct trace_enc {
+    uint32_t last_us;
+    bool synced;
+};
+
+/* Next record needs an absolute timestamp (start, or records were lost) */
+static inline void trace_enc_resync(struct trace_enc *e)
+{
+    e->synced = false;
+}
+
+static inline size_t trace_enc_time(struct trace_enc *e, uint32_t t_us, uint8_t *out,
+                                    uint16_t *dt_us)
+{
+    uint32_t dt = t_us - e->last_us;
+
+    e->last_us = t_us;
+    if (e->synced && dt <= UINT16_MAX) {
+        *dt_us = (uint16_t)dt;
+        return 0;
+    }
+
+    struct trace_rec_time rec = { .tag = TRACE_TAG_TIME, .t_us = t_us };
+
+    memcpy(out, &rec, sizeof(rec));
+    e->synced = true;
+    *dt_us = 0;
+    return sizeof(rec);
+}
+
+static inline size_t trace_enc_imu(struct trace_enc *e, const struct imu_sample *s, uint8_t *out)
+{
+    struct trace_rec_imu rec = { .tag = TRACE_TAG_IMU };
+    uint16_t dt_us;
+    size_t n = trace_enc_time(e, s->t_us, out, &dt_us);
+
+    rec.dt_us = dt_us;
+
+    memcpy(rec.acc, s->acc, sizeof(rec.acc));
+    memcpy(rec.gyr, s->gyr, sizeof(rec.gyr));
+    memcpy(out + n, &rec, sizeof(rec));
+    return n + sizeof(rec);
+}
+
+static inline size_t trace_enc_adc(struct trace_enc *e, uint32_t t_us, int16_t therm,
+                                   int16_t aux, uint8_t *out)
+{
+    struct trace_rec_adc rec = { .tag = TRACE_TAG_ADC, .therm = therm, .aux = aux };
+    uint16_t dt_us;
+    size_t n = trace_enc_time(e, t_us, out, &dt_us);
+
+    rec.dt_us = dt_us;
+
+    memcpy(out + n, &rec, sizeof(rec));
+    return n + sizeof(rec);
+}
+
+/* ===== Decoder ===== */
+struct trace_item {
+    enum trace_tag tag;         /* TRACE_TAG_IMU or TRACE_TAG_ADC */
+    uint32_t t_us;
+    struct imu_sample imu;
+    int16_t therm;
+    int16_t aux;
+};
+
+struct trace_dec {
+    uint32_t t_us;
+    bool synced;                /* a TIME record has been seen */
+};
+
+/* Decode the next IMU/ADC item from p. Returns the bytes consumed (TIME
+ * records are folded in), 0 if len does not hold a whole record, or -1 on an
+ * unknown tag. Records before the first TIME record are skipped.
+ */
+static inline int trace_dec_next(struct trace_dec *d, const uint8_t *p, size_t len,
+                                 struct trace_item *out, bool *have_item)
+{
+    *have_item = false;
+    if (len == 0) {
+        return 0;
+    }
+
+    switch (p[0]) {
+    case TRACE_TAG_TIME: {
+        struct trace_rec_time rec;
+
+        if (len < sizeof(rec)) {
+            return 0;
+        }
+        memcpy(&rec, p, sizeof(rec));
+        d->t_us = rec.t_us;
+        d->synced = true;
+        return sizeof(rec);
+    }
+    case TRACE_TAG_IMU: {
+        struct trace_rec_imu rec;
+
+        if (len < sizeof(rec)) {
+            return 0;
+        }
+        memcpy(&rec, p, sizeof(rec));
+        d->t_us += rec.dt_us;
+        out->tag = TRACE_TAG_IMU;
+        out->t_us = d->t_us;
+        out->imu.t_us = d->t_us;
+        memcpy(out->imu.acc, rec.acc, sizeof(rec.acc));
+        memcpy(out->imu.gyr, rec.gyr, sizeof(rec.gyr));
+        *have_item = d->synced;
+        return sizeof(rec);
+    }
+    case TRACE_TAG_ADC: {
+        struct trace_rec_adc rec;
+
+        if (len < sizeof(rec)) {
+            return 0;
+        }
+        memcpy(&rec, p, sizeof(rec));
+        d->t_us += rec.dt_us;
+        out->tag = TRACE_TAG_ADC;
+        out->t_us = d->t_us;
+        out->therm = rec.therm;
+        out->aux = rec.aux;
+        *have_item = d->synced;
+        return sizeof(rec);
+    }
+    default:
+        return -1;
+    }
+}
+
+#endif /* TRACE_WIRE_H_ */
@@ -0,0 +1,880 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Train and check the activity classifier (src/activity.c) on labelled
+ * synthetic traces, and check that it keeps walking, nodding and riding
+ * from raising posture cues in the firmware's decision code
+ * (src/ctrl_logic.c).
+ *
+ *   activity_check [--train FILE] [-v]
+ *
+ * The wearer alternates segments of one activity each:
+ *   still    seated or standing with sway, glances down, head turns,
+ *            shifts into a slouch and out of it
+ *   walking  1.3-2.3 Hz steps, vertical (0.05-0.35 g) and lateral bounce,
+ *            head bob, head 5-25 deg forward
+ *   nodding  3-15 deg nods at 0.6-2.2 Hz around 0-20 deg
+ *   vehicle  head 15-35 deg down at a phone, 8-20 Hz vibration, road
+ *            bumps, braking and sway
+ * sampled at 100 Hz (and 25 and 200 Hz, the adaptive IMU rates) with the
+ * sensor noise of odr_check. A decision is labelled when its whole window
+ * lies in one segment.
+ *
+ * --train fits a decision tree (CART, Gini with the classes weighted to
+ * equal totals, depth 4) on subjects 1-8 and
+ * writes it as the header activity.c includes (src/activity_tree.h). The
+ * checks always run the compiled-in tree on subjects 101-106:
+ *   - every class recognised in at least 90 % of its windows at 100 and
+ *     200 Hz, still windows taken for another class below 5 %
+ *   - the plain C FFT against a direct DFT
+ *   - host time per second of 100 Hz data within the budget
+ *     (CONFIG_NECK_ACTIVITY_BUDGET_US); the M33 is some 10-30 times slower
+ *     than the host, so on the device check the "activity" prof probe
+ *   - through ctrl_logic: a slouch at the desk still raises its events, a
+ *     forward head while walking, nodding or on the bus does not; the LRA
+ *     loops exactly while the cue is on, so a walk in the middle of a
+ *     slouch stops it and standing still again, slouched, restarts it
+ *
+ * Exit status is 1 if a check fails.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ctrl_logic.h"
+
+/* ===== Kconfig defaults ===== */
+#define FUSION_BETA         0.1f
+#define BUDGET_US           1000
+#define WM_FRAMES           10
+
+static const struct posture_params posture_defaults = {
+    .enter_deg = 15.0f,
+    .exit_deg = 8.0f,
+    .enter_dwell_ms = 3000,
+    .exit_dwell_ms = 1500,
+    .alert_ms = 30000,
+    .baseline_tau_s = 300.0f,
+    .warmup_ms = 5000,
+    .baseline_limit_deg = 30.0f,
+};
+
+static const struct calib_params calib_defaults = {
+    .window_ms = 1000,
+    .gyr_still_dps = 0.3f,
+    .acc_still_mg = 8.0f,
+    .bias_max_dps = 3.0f,
+    .bias_windows = 32,
+};
+
+#define RAD_TO_DEG          57.29577951
+#define G_MS2               9.80665
+#define NECK_R_M            0.08        /* pivot to patch */
+#define WINDOW_S            ((double)ACTIVITY_WINDOW / ACTIVITY_HZ)
+#define SUBJECT_S           1200.0
+
+static int verbose;
+static int failures;
+
+#define EXPECT(cond, ...)                                           \
+    do {                                                            \
+        if (!(cond)) {                                              \
+            printf("FAIL: ");                                       \
+            printf(__VA_ARGS__);                                    \
+            printf("\n");                                           \
+            failures++;                                             \
+        }                                                           \
+    } while (0)
+
+static uint64_t rng;
+
+static double urand(void)
+{
+    rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (rng >> 40) / 16777216.0;
+}
+
+static double uniform(double lo, double hi)
+{
+    return lo + (hi - lo) * urand();
+}
+
+static double noise(double amp)
+{
+    return (urand() * 2.0 - 1.0) * amp;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* ===== Wearer =====
+ * A segment's parameters are drawn when it starts. Head moves (glances,
+ * turns) are raised-cosine bumps placed at random in still and vehicle
+ * segments.
+ */
+struct segment {
+    enum activity_class cls;
+    double t0, d;
+    double base_deg;            /* head pitch */
+    double f, a1, a2, lat, bob_deg, ph[4];
+    double vib_f[3], vib_a[3];
+    double brake_f, brake_a;
+    double ev_t, ev_d, ev_amp;  /* current head move */
+    int ev_kind;
+    bool shifts;                /* pitch not fixed by a story */
+    double shift_deg;           /* settled posture shifts */
+    double bump_t;
+};
+
+#define SEG_MAX     256
+
+struct scene {
+    struct segment seg[SEG_MAX];
+    size_t n;
+    double len_s;
+};
+
+static void segment_draw(struct segment *s, enum activity_class cls, double t0,
+                         double forward_deg)
+{
+    memset(s, 0, sizeof(*s));
+    s->cls = cls;
+    s->t0 = t0;
+    for (int i = 0; i < 4; i++) {
+        s->ph[i] = uniform(0.0, 2.0 * M_PI);
+    }
+    s->ev_t = t0 + uniform(2.0, 8.0);
+    s->shifts = forward_deg < 0.0;
+    s->bump_t = t0 + uniform(1.0, 6.0);
+    switch (cls) {
+    case ACTIVITY_STILL:
+        s->d = uniform(20.0, 60.0);
+        s->base_deg = forward_deg >= 0.0 ? forward_deg : uniform(0.0, 12.0);
+        s->f = uniform(0.2, 0.4);
+        s->bob_deg = uniform(0.1, 0.3);
+        break;
+    case ACTIVITY_WALKING:
+        s->d = uniform(15.0, 45.0);
+        s->base_deg = forward_deg >= 0.0 ? forward_deg : uniform(5.0, 25.0);
+        s->f = uniform(1.3, 2.3);
+        s->a1 = uniform(0.05, 0.35);
+        s->a2 = uniform(0.02, 0.15);
+        s->lat = uniform(0.03, 0.08);
+        s->bob_deg = uniform(0.5, 2.0);
+        break;
+    case ACTIVITY_NODDING:
+        s->d = uniform(6.0, 15.0);
+        s->base_deg = forward_deg >= 0.0 ? forward_deg : uniform(0.0, 20.0);
+        s->f = uniform(0.6, 2.2);
+        s->bob_deg = uniform(3.0, 15.0);
+        break;
+    default:
+        s->d = uniform(30.0, 60.0);
+        s->base_deg = forward_deg >= 0.0 ? forward_deg : uniform(15.0, 35.0);
+        for (int i = 0; i < 3; i++) {
+            s->vib_f[i] = uniform(8.0, 20.0);
+            s->vib_a[i] = uniform(0.005, 0.04);
+        }
+        s->brake_f = uniform(0.05, 0.3);
+        s->brake_a = uniform(0.05, 0.15);
+        s->f = uniform(0.3, 1.0);
+        s->bob_deg = uniform(0.3, 1.0);
+        break;
+    }
+}
+
+/* forward_deg and len_s < 0: drawn */
+static void scene_add(struct scene *sc, enum activity_class cls, double forward_deg,
+                      double len_s)
+{
+    struct segment *s = &sc->seg[sc->n++];
+
+    segment_draw(s, cls, sc->len_s, forward_deg);
+    if (len_s >= 0.0) {
+        s->d = len_s;
+    }
+    sc->len_s += s->d;
+}
+
+/* Still twice as often as any other activity */
+static void scene_random(struct scene *sc, double len_s)
+{
+    static const enum activity_class mix[] = {
+        ACTIVITY_STILL, ACTIVITY_STILL, ACTIVITY_WALKING, ACTIVITY_NODDING, ACTIVITY_VEHICLE,
+    };
+
+    sc->n = 0;
+    sc->len_s = 0.0;
+    while (sc->len_s < len_s && sc->n < SEG_MAX) {
+        scene_add(sc, mix[(size_t)(urand() * 5)], -1.0, -1.0);
+    }
+}
+
+static struct segment *scene_at(struct scene *sc, double t)
+{
+    for (size_t i = 0; i < sc->n; i++) {
+        if (t < sc->seg[i].t0 + sc->seg[i].d) {
+            return &sc->seg[i];
+        }
+    }
+    return &sc->seg[sc->n - 1];
+}
+
+/* Head moves in still and vehicle segments every 3-12 s: a turn (yaw), a
+ * glance down and back (pitch) or a shift into a slouch or out of it
+ */
+enum { MOVE_TURN, MOVE_GLANCE, MOVE_SHIFT };
+
+static void head_move(struct segment *s, double t, double *pitch, double *pitch_dps,
+                      double *yaw_dps)
+{
+    if (t >= s->ev_t + s->ev_d) {
+        s->ev_t = t + uniform(3.0, 12.0);
+        if (s->ev_kind == MOVE_SHIFT) {
+            s->shift_deg += s->ev_amp;
+        }
+
+        double u = urand();
+
+        s->ev_t = t + uniform(3.0, 12.0);
+        s->ev_kind = u < 0.5 ? MOVE_TURN : u < 0.8 || !s->shifts ? MOVE_GLANCE : MOVE_SHIFT;
+        switch (s->ev_kind) {
+        case MOVE_TURN:
+            s->ev_d = uniform(1.0, 3.0);
+            s->ev_amp = uniform(40.0, 150.0) * (urand() < 0.5 ? -1 : 1);
+            break;
+        case MOVE_GLANCE:
+            s->ev_d = uniform(0.8, 3.0);
+            s->ev_amp = uniform(10.0, 35.0);
+            break;
+        default:
+            s->ev_d = uniform(0.4, 1.5);
+            s->ev_amp = s->shift_deg != 0.0 ? -s->shift_deg : uniform(10.0, 30.0);
+            break;
+        }
+    }
+    *pitch += s->shift_deg;
+    if (t < s->ev_t) {
+        return;
+    }
+
+    double x = (t - s->ev_t) / s->ev_d;
+
+    switch (s->ev_kind) {
+    case MOVE_TURN:
+        *yaw_dps += s->ev_amp * 0.5 * (1.0 - cos(2.0 * M_PI * x));
+        break;
+    case MOVE_GLANCE:
+        *pitch += s->ev_amp * 0.5 * (1.0 - cos(2.0 * M_PI * x));
+        *pitch_dps += s->ev_amp * 0.5 * 2.0 * M_PI / s->ev_d * sin(2.0 * M_PI * x);
+        break;
+    default:
+        *pitch += s->ev_amp * 0.5 * (1.0 - cos(M_PI * x));
+        *pitch_dps += s->ev_amp * 0.5 * M_PI / s->ev_d * sin(M_PI * x);
+        break;
+    }
+}
+
+/* Specific force (g) and rate (dps) in the patch frame: x up the neck at
+ * zero pitch, pitch about y towards +z
+ */
+static void wearer_at(struct segment *s, double t, double acc[3], double gyr[3])
+{
+    double tt = t - s->t0;
+    double pitch = s->base_deg, pitch_dps = 0.0, pitch_dds = 0.0, yaw = 0.0;
+    double up = 1.0, fwd = 0.0, lat = 0.0;
+    double w = 2.0 * M_PI * s->f;
+
+    switch (s->cls) {
+    case ACTIVITY_STILL:
+        pitch += s->bob_deg * sin(w * tt + s->ph[0]);
+        pitch_dps += s->bob_deg * w * cos(w * tt + s->ph[0]);
+        head_move(s, t, &pitch, &pitch_dps, &yaw);
+        break;
+    case ACTIVITY_WALKING:
+        up += s->a1 * sin(w * tt + s->ph[0]) + s->a2 * sin(2.0 * w * tt + s->ph[1]);
+        lat = s->lat * sin(0.5 * w * tt + s->ph[2]);
+        fwd = 0.3 * s->a2 * sin(2.0 * w * tt + s->ph[3]);
+        pitch += s->bob_deg * sin(w * tt + s->ph[1]);
+        pitch_dps += s->bob_deg * w * cos(w * tt + s->ph[1]);
+        break;
+    case ACTIVITY_NODDING:
+        pitch += s->bob_deg * sin(w * tt + s->ph[0]);
+        pitch_dps = s->bob_deg * w * cos(w * tt + s->ph[0]);
+        pitch_dds = -s->bob_deg * w * w * sin(w * tt + s->ph[0]);
+        break;
+    default:
+        for (int i = 0; i < 3; i++) {
+            up += s->vib_a[i] * sin(2.0 * M_PI * s->vib_f[i] * tt + s->ph[i]);
+        }
+        up += noise(0.01);
+        if (t >= s->bump_t) {
+            double x = t - s->bump_t;
+
+            up += 0.2 * exp(-x * 8.0) * sin(2.0 * M_PI * 6.0 * x);
+            if (x > 1.0) {
+                s->bump_t = t + uniform(2.0, 10.0);
+            }
+        }
+        fwd = s->brake_a * sin(2.0 * M_PI * s->brake_f * tt + s->ph[3]);
+        lat = 0.5 * s->brake_a * sin(2.0 * M_PI * s->brake_f * 0.7 * tt + s->ph[2]);
+        pitch += s->bob_deg * sin(w * tt + s->ph[0]);
+        pitch_dps += s->bob_deg * w * cos(w * tt + s->ph[0]);
+        head_move(s, t, &pitch, &pitch_dps, &yaw);
+        break;
+    }
+
+    double th = pitch / RAD_TO_DEG;
+    double om = pitch_dps / RAD_TO_DEG, al = pitch_dds / RAD_TO_DEG;
+
+    /* Up along the neck and forward, then the head's own rotation about
+     * the pivot: centripetal towards it, tangential along z
+     */
+    acc[0] = up * cos(th) - fwd * sin(th) - om * om * NECK_R_M / G_MS2;
+    acc[1] = lat;
+    acc[2] = up * sin(th) + fwd * cos(th) + al * NECK_R_M / G_MS2;
+    gyr[0] = yaw * cos(th);
+    gyr[1] = pitch_dps;
+    gyr[2] = yaw * sin(th);
+}
+
+static int16_t sat(double v)
+{
+    return v > 32767.0 ? 32767 : (v < -32768.0 ? -32768 : (int16_t)lround(v));
+}
+
+/* Calibrated samples: the residual after calib.c is noise */
+static void sample_at(struct scene *sc, double t, struct imu_sample *s)
+{
+    double acc[3], gyr[3];
+
+    wearer_at(scene_at(sc, t), t, acc, gyr);
+    for (int ax = 0; ax < 3; ax++) {
+        s->acc[ax] = sat(acc[ax] * IMU_ACC_LSB_PER_G + noise(40));
+        s->gyr[ax] = sat(gyr[ax] * IMU_GYR_LSB_PER_DPS + noise(8));
+    }
+    s->t_us = (uint32_t)llround(t * 1e6);
+}
+
+/* ===== Labelled decisions ===== */
+struct example {
+    float feat[ACT_F_COUNT];
+    uint8_t label;
+    uint8_t raw, cls;
+};
+
+#define EX_MAX      200000
+
+static struct example ex[EX_MAX];
+static size_t n_ex;
+
+/* The whole window in one segment; it ended within a batch before t */
+static int label_at(struct scene *sc, double t)
+{
+    const struct segment *a = scene_at(sc, t - WINDOW_S - 0.15);
+    const struct segment *b = scene_at(sc, t);
+
+    return a == b ? (int)a->cls : -1;
+}
+
+/* One subject at hz; appends the labelled decisions, returns the time spent
+ * in activity_update()
+ */
+static double run_subject(uint64_t seed, uint16_t hz)
+{
+    static struct scene sc;
+    static struct activity a;
+    struct imu_sample batch[4 * WM_FRAMES];
+    const size_t wm = (size_t)(WM_FRAMES * hz / 100) ? (size_t)(WM_FRAMES * hz / 100) : 1;
+    double spent = 0.0;
+    size_t n = 0;
+
+    rng = seed * 0x9E3779B97F4A7C15ULL + 1;
+    scene_random(&sc, SUBJECT_S);
+    activity_init(&a);
+    for (uint64_t k = 0;; k++) {
+        double t = (double)k / hz;
+
+        if (t >= sc.len_s) {
+            break;
+        }
+        sample_at(&sc, t, &batch[n++]);
+        if (n < wm) {
+            continue;
+        }
+
+        uint32_t before = a.decisions;
+        double t0 = now_ns();
+
+        activity_update(&a, batch, n);
+        spent += now_ns() - t0;
+        n = 0;
+        if (a.decisions == before || n_ex >= EX_MAX) {
+            continue;
+        }
+
+        int label = label_at(&sc, t);
+
+        if (label < 0) {
+            continue;
+        }
+        memcpy(ex[n_ex].feat, a.feat, sizeof(a.feat));
+        ex[n_ex].label = (uint8_t)label;
+        ex[n_ex].raw = (uint8_t)a.raw;
+        ex[n_ex].cls = (uint8_t)a.cls;
+        n_ex++;
+    }
+    return spent;
+}
+
+/* ===== Training (CART) ===== */
+#define TREE_DEPTH  4
+#define LEAF_MIN    40
+#define NODES_MAX   64
+
+static struct activity_node tree[NODES_MAX];
+static size_t n_nodes;
+static size_t idx[EX_MAX];
+static int sort_feature;
+
+/* Classes weighted to equal totals, so nodding's few windows count */
+static double weight[ACTIVITY_COUNT];
+
+static int cmp_feat(const void *a, const void *b)
+{
+    float fa = ex[*(const size_t *)a].feat[sort_feature];
+    float fb = ex[*(const size_t *)b].feat[sort_feature];
+
+    return fa < fb ? -1 : (fa > fb);
+}
+
+/* Impurity of weighted class totals, times their sum */
+static double gini(const double *w)
+{
+    double sum = 0.0, sq = 0.0;
+
+    for (int c = 0; c < ACTIVITY_COUNT; c++) {
+        sum += w[c];
+        sq += w[c] * w[c];
+    }
+    return sum > 0.0 ? sum - sq / sum : 0.0;
+}
+
+static size_t grow(size_t *set, size_t n, int depth)
+{
+    size_t node = n_nodes++;
+    double cnt[ACTIVITY_COUNT] = { 0 };
+    int major = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        cnt[ex[set[i]].label] += weight[ex[set[i]].label];
+    }
+    for (int c = 1; c < ACTIVITY_COUNT; c++) {
+        major = cnt[c] > cnt[major] ? c : major;
+    }
+    tree[node] = (struct activity_node){ .feature = -1, .leaf = (uint8_t)major };
+
+    double best = gini(cnt);
+    int best_f = -1;
+    float best_thr = 0.0f;
+
+    if (depth >= TREE_DEPTH || best < 1e-9 || n < 2 * LEAF_MIN || n_nodes + 2 > NODES_MAX) {
+        return node;
+    }
+    for (int f = 0; f < ACT_F_COUNT; f++) {
+        double left[ACTIVITY_COUNT] = { 0 };
+
+        sort_feature = f;
+        qsort(set, n, sizeof(*set), cmp_feat);
+        for (size_t i = 0; i + 1 < n; i++) {
+            left[ex[set[i]].label] += weight[ex[set[i]].label];
+
+            float a = ex[set[i]].feat[f], b = ex[set[i + 1]].feat[f];
+
+            if (i + 1 < LEAF_MIN || n - i - 1 < LEAF_MIN || a == b) {
+                continue;
+            }
+
+            double right[ACTIVITY_COUNT];
+
+            for (int c = 0; c < ACTIVITY_COUNT; c++) {
+                right[c] = cnt[c] - left[c];
+            }
+
+            double g = gini(left) + gini(right);
+
+            if (g < best - 1e-9) {
+                best = g;
+                best_f = f;
+                best_thr = 0.5f * (a + b);
+            }
+        }
+    }
+    if (best_f < 0) {
+        return node;
+    }
+
+    /* Partition in place: at or below the threshold first */
+    size_t k = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        if (ex[set[i]].feat[best_f] <= best_thr) {
+            size_t tmp = set[k];
+
+            set[k++] = set[i];
+            set[i] = tmp;
+        }
+    }
+
+    size_t l = grow(set, k, depth + 1);
+    size_t r = grow(set + k, n - k, depth + 1);
+
+    /* Both sides the same class: one leaf */
+    if (tree[l].feature < 0 && tree[r].feature < 0 && tree[l].leaf == tree[r].leaf) {
+        n_nodes = node + 1;
+        return node;
+    }
+    tree[node] = (struct activity_node){
+        .feature = (int8_t)best_f, .left = (uint8_t)l, .right = (uint8_t)r, .threshold = best_thr,
+    };
+    return node;
+}
+
+static const char *const feature_ids[ACT_F_COUNT] = {
+    "ACT_F_ACC_VAR", "ACT_F_JERK", "ACT_F_PITCH_MS", "ACT_F_LOW", "ACT_F_MID", "ACT_F_HIGH",
+};
+
+static const char *const class_ids[ACTIVITY_COUNT] = {
+    "ACTIVITY_STILL", "ACTIVITY_WALKING", "ACTIVITY_NODDING", "ACTIVITY_VEHICLE",
+};
+
+static int train(const char *path)
+{
+    n_ex = 0;
+    for (uint64_t s = 1; s <= 8; s++) {
+        run_subject(s, 100);
+    }
+    size_t per_class[ACTIVITY_COUNT] = { 0 };
+
+    for (size_t i = 0; i < n_ex; i++) {
+        idx[i] = i;
+        per_class[ex[i].label]++;
+    }
+    for (int c = 0; c < ACTIVITY_COUNT; c++) {
+        weight[c] = per_class[c] ? (double)n_ex / per_class[c] : 0.0;
+    }
+    n_nodes = 0;
+    grow(idx, n_ex, 0);
+
+    FILE *f = fopen(path, "w");
+
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    fprintf(f, "/*\n * SPDX-License-Identifier: Apache-2.0\n *\n"
+               " * Generated by tools/activity_check --train; included by activity.c only.\n"
+               " * %zu labelled windows of 8 synthetic subjects at 100 Hz.\n */\n\n"
+               "static const struct activity_node activity_tree[] = {\n", n_ex);
+    for (size_t i = 0; i < n_nodes; i++) {
+        const struct activity_node *nd = &tree[i];
+
+        if (nd->feature < 0) {
+            fprintf(f, "    { -1, %s, 0, 0, 0.0f },\n", class_ids[nd->leaf]);
+        } else {
+            char thr[32];
+
+            /* A float literal needs its point: 855 would not take the f */
+            snprintf(thr, sizeof(thr), "%.6g", nd->threshold);
+            if (!strpbrk(thr, ".e")) {
+                strcat(thr, ".0");
+            }
+            fprintf(f, "    { %s, 0, %u, %u, %sf },\n", feature_ids[nd->feature], nd->left,
+                    nd->right, thr);
+        }
+    }
+    fprintf(f, "};\n");
+    fclose(f);
+    printf("%zu nodes from %zu windows written to %s\n", n_nodes, n_ex, path);
+    return 0;
+}
+
+/* ===== Checks ===== */
+static void check_accuracy(void)
+{
+    static const uint16_t rates[] = { 100, 200, 25 };
+
+    printf("%-6s %-8s %8s %8s %8s %8s %8s %9s\n", "rate", "class", "windows", "still",
+           "walking", "nodding", "vehicle", "debounced");
+    for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        size_t conf[ACTIVITY_COUNT][ACTIVITY_COUNT] = { { 0 } };
+        size_t deb[ACTIVITY_COUNT] = { 0 }, tot[ACTIVITY_COUNT] = { 0 };
+
+        n_ex = 0;
+        for (uint64_t s = 101; s <= 106; s++) {
+            run_subject(s, rates[r]);
+        }
+        for (size_t i = 0; i < n_ex; i++) {
+            conf[ex[i].label][ex[i].raw]++;
+            deb[ex[i].label] += ex[i].cls == ex[i].label;
+            tot[ex[i].label]++;
+        }
+        for (int c = 0; c < ACTIVITY_COUNT; c++) {
+            double ok = tot[c] ? (double)conf[c][c] / tot[c] : 0.0;
+
+            printf("%3u Hz %-8s %8zu", rates[r], activity_class_name(c), tot[c]);
+            for (int k = 0; k < ACTIVITY_COUNT; k++) {
+                printf(" %7.1f%%", tot[c] ? 100.0 * conf[c][k] / tot[c] : 0.0);
+            }
+            printf(" %8.1f%%\n", tot[c] ? 100.0 * deb[c] / tot[c] : 0.0);
+
+            /* 25 Hz only runs while the wearer is still; reported only */
+            if (rates[r] == 25) {
+                continue;
+            }
+            EXPECT(tot[c] > 0 && ok >= 0.9, "%u Hz: %s recognised in %.1f %% of %zu windows",
+                   rates[r], activity_class_name(c), 100.0 * ok, tot[c]);
+        }
+        if (rates[r] != 25) {
+            double false_gate = tot[0] ? 1.0 - (double)conf[0][0] / tot[0] : 1.0;
+
+            EXPECT(false_gate < 0.05, "%u Hz: %.1f %% of still windows gated", rates[r],
+                   100.0 * false_gate);
+        }
+    }
+}
+
+static void check_fft(void)
+{
+    float in[ACTIVITY_WINDOW], x[ACTIVITY_WINDOW], out[ACTIVITY_WINDOW];
+    double err = 0.0, mag = 0.0;
+
+    rng = 42;
+    for (int i = 0; i < ACTIVITY_WINDOW; i++) {
+        x[i] = in[i] = (float)noise(1.0);
+    }
+    activity_rfft(in, out);
+    for (int k = 0; k <= ACTIVITY_WINDOW / 2; k++) {
+        double re = 0.0, im = 0.0;
+
+        for (int i = 0; i < ACTIVITY_WINDOW; i++) {
+            re += x[i] * cos(2.0 * M_PI * k * i / ACTIVITY_WINDOW);
+            im -= x[i] * sin(2.0 * M_PI * k * i / ACTIVITY_WINDOW);
+        }
+
+        double gr = k == 0 ? out[0] : (k == ACTIVITY_WINDOW / 2 ? out[1] : out[2 * k]);
+        double gi = k == 0 || k == ACTIVITY_WINDOW / 2 ? 0.0 : out[2 * k + 1];
+
+        err = fmax(err, hypot(gr - re, gi - im));
+        mag = fmax(mag, hypot(re, im));
+    }
+    printf("\nrfft %d points against a direct DFT: max error %.2g of %.3g\n", ACTIVITY_WINDOW,
+           err, mag);
+    EXPECT(err < 1e-4 * mag, "rfft off by %.3g", err);
+}
+
+static void check_cost(void)
+{
+    double spent = 0.0;
+
+    n_ex = 0;
+    for (uint64_t s = 101; s <= 103; s++) {
+        spent += run_subject(s, 100);
+    }
+
+    /* Decisions per second of data are fixed by the grid */
+    double data_s = 3 * SUBJECT_S;
+    double decisions = data_s * ACTIVITY_HZ / ACTIVITY_BLOCK;
+    double per_s_us = spent / data_s / 1000.0;
+
+    printf("cost at 100 Hz: %.1f us per second of data, %.2f us per window "
+           "(%u samples and one decision), budget %u us\n",
+           per_s_us, spent / decisions / 1000.0, 100 * ACTIVITY_BLOCK / ACTIVITY_HZ, BUDGET_US);
+    EXPECT(per_s_us < BUDGET_US, "%.1f us per second of data", per_s_us);
+}
+
+/* ===== Through ctrl_logic ===== */
+struct story {
+    const char *name;
+    struct {
+        enum activity_class cls;
+        double forward_deg;
+        double len_s;
+    } part[4];
+    int slouches;               /* with the gate, -1: at least one */
+    bool held_cue;              /* the cue is held and released, still slouched */
+};
+
+static const struct story stories[] = {
+    {
+        .name = "desk slouch",
+        .part = { { ACTIVITY_STILL, 5, 60 }, { ACTIVITY_STILL, 30, 60 },
+                  { ACTIVITY_STILL, 5, 40 } },
+        .slouches = -1,
+    },
+    {
+        .name = "walk",
+        .part = { { ACTIVITY_STILL, 5, 40 }, { ACTIVITY_WALKING, 25, 60 },
+                  { ACTIVITY_STILL, 5, 30 } },
+        .slouches = 0,
+    },
+    {
+        .name = "bus phone",
+        .part = { { ACTIVITY_STILL, 5, 40 }, { ACTIVITY_VEHICLE, 28, 120 },
+                  { ACTIVITY_STILL, 5, 30 } },
+        .slouches = 0,
+    },
+    {
+        .name = "nodding",
+        .part = { { ACTIVITY_STILL, 5, 40 }, { ACTIVITY_NODDING, 30, 20 },
+                  { ACTIVITY_STILL, 5, 30 } },
+        .slouches = 0,
+    },
+    {
+        .name = "slouch walk",
+        .part = { { ACTIVITY_STILL, 5, 40 }, { ACTIVITY_STILL, 30, 50 },
+                  { ACTIVITY_WALKING, 25, 40 }, { ACTIVITY_STILL, 30, 30 } },
+        .slouches = -1,
+        .held_cue = true,
+    },
+};
+
+/* The LRA as control.c drives it from the decisions: a looped pattern
+ * runs until replaced or stopped
+ */
+struct lra_model {
+    bool looping;
+    uint32_t stops;             /* by the hold */
+    uint32_t restarts;          /* by its release */
+    uint32_t wrong_ms;          /* looping with the cue off, or the reverse */
+};
+
+static void lra_apply(struct lra_model *m, const struct ctrl_decision *d)
+{
+    switch (d->lra) {
+    case CTRL_LRA_CUE:
+        m->restarts += d->ev == POSTURE_EV_NONE;
+        m->looping = true;
+        break;
+    case CTRL_LRA_ALERT:
+        m->looping = true;
+        break;
+    case CTRL_LRA_CONFIRM:
+        m->looping = false;
+        break;
+    case CTRL_LRA_STOP:
+        m->stops++;
+        m->looping = false;
+        break;
+    default:
+        break;
+    }
+    m->wrong_ms += m->looping != d->cue ? 1000 * WM_FRAMES / 100 : 0;
+}
+
+static void run_story(const struct story *st, uint64_t seed, bool gate, uint32_t *slouches,
+                      uint32_t *cue_ms, struct lra_model *lra)
+{
+    static struct scene sc;
+    static struct ctrl_logic cl;
+    struct imu_sample batch[WM_FRAMES];
+    struct ctrl_decision d;
+    size_t n = 0;
+
+    rng = seed;
+    sc.n = 0;
+    sc.len_s = 0.0;
+    for (int i = 0; i < 4 && st->part[i].len_s > 0; i++) {
+        scene_add(&sc, st->part[i].cls, st->part[i].forward_deg, st->part[i].len_s);
+    }
+
+    ctrl_logic_init(&cl, FUSION_BETA, 0.01f, &posture_defaults, &calib_defaults);
+    cl.gate = gate;
+    *slouches = 0;
+    *cue_ms = 0;
+    memset(lra, 0, sizeof(*lra));
+    for (uint64_t k = 0; (double)k / 100 < sc.len_s; k++) {
+        sample_at(&sc, (double)k / 100, &batch[n++]);
+        if (n < WM_FRAMES) {
+            continue;
+        }
+        ctrl_logic_step(&cl, batch, n, &d);
+        n = 0;
+        *slouches += d.ev == POSTURE_EV_SLOUCH_START;
+        *cue_ms += d.cue ? 1000 * WM_FRAMES / 100 : 0;
+        lra_apply(lra, &d);
+        if (verbose && d.lra == CTRL_LRA_STOP) {
+            printf("  %-12s %s %7.1f s %-15s %s\n", st->name, gate ? "gated" : "plain",
+                   k / 100.0, "LRA stopped", activity_class_name(d.activity));
+        }
+        if (verbose && d.ev != POSTURE_EV_NONE) {
+            printf("  %-12s %s %7.1f s %-15s %s\n", st->name, gate ? "gated" : "plain",
+                   k / 100.0, posture_event_name(d.ev), activity_class_name(d.activity));
+        }
+    }
+}
+
+static void check_gate(void)
+{
+    printf("\n%-12s %17s %17s\n", "story", "slouches/cue s", "gated");
+    for (size_t i = 0; i < sizeof(stories) / sizeof(stories[0]); i++) {
+        const struct story *st = &stories[i];
+        uint32_t s_plain, s_gate, c_plain, c_gate;
+        struct lra_model l_plain, l_gate;
+
+        run_story(st, 7 + i, false, &s_plain, &c_plain, &l_plain);
+        run_story(st, 7 + i, true, &s_gate, &c_gate, &l_gate);
+        printf("%-12s %8u %7.1f s %8u %7.1f s\n", st->name, s_plain, c_plain / 1000.0, s_gate,
+               c_gate / 1000.0);
+        if (st->slouches < 0) {
+            EXPECT(s_gate == s_plain && s_gate > 0, "%s: %u slouches gated, %u plain", st->name,
+                   s_gate, s_plain);
+        } else {
+            EXPECT(s_plain > 0, "%s: the story raises no cue to suppress", st->name);
+            EXPECT(s_gate == (uint32_t)st->slouches, "%s: %u slouches gated", st->name, s_gate);
+        }
+        EXPECT(l_plain.wrong_ms == 0 && l_gate.wrong_ms == 0,
+               "%s: LRA and cue disagree for %u ms plain, %u ms gated", st->name,
+               l_plain.wrong_ms, l_gate.wrong_ms);
+        if (st->held_cue) {
+            EXPECT(l_gate.stops > 0 && l_gate.restarts > 0,
+                   "%s: LRA stopped %u times, restarted %u", st->name, l_gate.stops,
+                   l_gate.restarts);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *train_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--train") && i + 1 < argc) {
+            train_path = argv[++i];
+        } else if (!strcmp(argv[i], "-v")) {
+            verbose = 1;
+        } else {
+            fprintf(stderr, "usage: %s [--train FILE] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (train_path) {
+        return train(train_path);
+    }
+
+    check_accuracy();
+    check_fft();
+    check_cost();
+    check_gate();
+
+    printf("\n%s\n", failures ? "FAILED" : "all checks passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,346 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Replay a posture session through the firmware's decision code
+ * (src/ctrl_logic.c) into src/actuators.c, on the host kernel in
+ * tools/zephyr_host, with the PWM and GPIO drivers counting every call.
+ *
+ *   actuator_check [-v]
+ *
+ * The wearer sits upright, slouches twice and recovers each time; the
+ * samples arrive in FIFO batches at the default ODR and watermark. Every
+ * batch sets the cue LEDs as control_step() does, and the Peltiers at a
+ * fixed duty while the cue runs, as peltier_ctrl.c does on its tick when
+ * the PI output has settled. The checks:
+ *   session   every channel reaches the driver once at init and once per
+ *             cue edge; all other sets are counted as skipped and leave
+ *             the driver alone; the outputs follow the cue
+ *   inhibit   inhibiting the Peltiers in the middle of a slouch writes
+ *             them off at once; while inhibited, sets asking for a duty
+ *             write nothing and the output stays off; after the release
+ *             the next set restores the duty with one write
+ *   fault     a failed LED write is counted, and the next identical set
+ *             retries it instead of being skipped
+ * Exit status is 1 if a check fails.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/pwm.h>
+
+#include "zephyr_host.h"
+#include "actuators.h"
+#include "ctrl_logic.h"
+
+/* ===== Kconfig defaults ===== */
+#define FUSION_BETA         0.1f
+#define ODR_HZ              100
+#define WM_FRAMES           10
+#define PELTIER_DUTY        600
+
+#define CHANNELS            2
+#define RAD_TO_DEG          57.29577951
+
+static const struct posture_params posture_defaults = {
+    .enter_deg = 15.0f,
+    .exit_deg = 8.0f,
+    .enter_dwell_ms = 3000,
+    .exit_dwell_ms = 1500,
+    .alert_ms = 30000,
+    .baseline_tau_s = 300.0f,
+    .warmup_ms = 5000,
+    .baseline_limit_deg = 30.0f,
+};
+
+static const struct calib_params calib_defaults = {
+    .window_ms = 1000,
+    .gyr_still_dps = 0.3f,
+    .acc_still_mg = 8.0f,
+    .bias_max_dps = 3.0f,
+    .bias_windows = 32,
+};
+
+static int verbose;
+static int failures;
+
+#define EXPECT(cond, ...)                                           \
+    do {                                                            \
+        if (!(cond)) {                                              \
+            printf("FAIL: ");                                       \
+            printf(__VA_ARGS__);                                    \
+            printf("\n");                                           \
+            failures++;                                             \
+        }                                                           \
+    } while (0)
+
+/* ===== Drivers ===== */
+const struct device DT_N_pwm0_DEVICE = { "pwm0" };
+const struct device DT_N_gpio0_DEVICE = { "gpio0" };
+
+static struct {
+    uint32_t pwm_calls[CHANNELS];
+    uint32_t pulse_ns[CHANNELS];
+    uint32_t gpio_calls[CHANNELS];
+    int level[CHANNELS];
+    int gpio_fail;              /* next gpio_pin_set_dt() calls to fail */
+} drv;
+
+static int led_index(const struct gpio_dt_spec *spec)
+{
+    return spec->pin == 22 ? 0 : 1;
+}
+
+int pwm_set_dt(const struct pwm_dt_spec *spec, uint32_t period, uint32_t pulse)
+{
+    if (spec->dev != &DT_N_pwm0_DEVICE || spec->channel >= CHANNELS || period != spec->period) {
+        return -EINVAL;
+    }
+    drv.pwm_calls[spec->channel]++;
+    drv.pulse_ns[spec->channel] = pulse;
+    return 0;
+}
+
+bool pwm_is_ready_dt(const struct pwm_dt_spec *spec)
+{
+    return spec->dev == &DT_N_pwm0_DEVICE;
+}
+
+int gpio_pin_set_dt(const struct gpio_dt_spec *spec, int value)
+{
+    int i = led_index(spec);
+
+    drv.gpio_calls[i]++;
+    if (drv.gpio_fail > 0) {
+        drv.gpio_fail--;
+        return -EIO;
+    }
+    drv.level[i] = value;
+    return 0;
+}
+
+int gpio_pin_configure_dt(const struct gpio_dt_spec *spec, gpio_flags_t extra_flags)
+{
+    drv.level[led_index(spec)] = 0;
+    return extra_flags == GPIO_OUTPUT_INACTIVE ? 0 : -ENOTSUP;
+}
+
+bool gpio_is_ready_dt(const struct gpio_dt_spec *spec)
+{
+    return spec->port == &DT_N_gpio0_DEVICE;
+}
+
+/* ===== Session ===== */
+struct knot {
+    double t_s;
+    double pitch_deg;
+};
+
+/* Warm-up upright, then two slouches with recoveries */
+static const struct knot session[] = {
+    { 0, 0 }, { 40, 0 }, { 42, 30 }, { 100, 30 }, { 102, 0 },
+    { 150, 0 }, { 152, 28 }, { 220, 28 }, { 222, 0 }, { 260, 0 },
+};
+
+#define SESSION_S       260.0
+#define INHIBIT_FROM_S  180.0
+#define INHIBIT_TO_S    195.0
+#define FAULT_AT_S      60.0
+
+static void pitch_at(double t, double *deg, double *dps)
+{
+    for (size_t i = 1; i < ARRAY_SIZE(session); i++) {
+        if (t <= session[i].t_s) {
+            double span = session[i].t_s - session[i - 1].t_s;
+
+            *dps = (session[i].pitch_deg - session[i - 1].pitch_deg) / span;
+            *deg = session[i - 1].pitch_deg + *dps * (t - session[i - 1].t_s);
+            return;
+        }
+    }
+    *deg = session[ARRAY_SIZE(session) - 1].pitch_deg;
+    *dps = 0.0;
+}
+
+static uint64_t rng = 0x9E3779B97F4A7C15ull;
+
+static double noise(double amp)
+{
+    rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+    return amp * ((double)(rng >> 11) / (double)(1ull << 53) * 2.0 - 1.0);
+}
+
+static int16_t sat(double v)
+{
+    return v > 32767.0 ? 32767 : (v < -32768.0 ? -32768 : (int16_t)lround(v));
+}
+
+/* Calibrated samples of a still wearer at the scripted pitch */
+static void sample_at(double t, struct imu_sample *s)
+{
+    double deg, dps;
+
+    pitch_at(t, &deg, &dps);
+    double th = deg / RAD_TO_DEG;
+
+    s->acc[0] = sat(cos(th) * IMU_ACC_LSB_PER_G + noise(40));
+    s->acc[1] = sat(noise(40));
+    s->acc[2] = sat(sin(th) * IMU_ACC_LSB_PER_G + noise(40));
+    s->gyr[0] = sat(noise(8));
+    s->gyr[1] = sat(dps * IMU_GYR_LSB_PER_DPS + noise(8));
+    s->gyr[2] = sat(noise(8));
+    s->t_us = (uint32_t)llround(t * 1e6);
+}
+
+static struct act_channel_stats stats(enum act_group g, size_t i)
+{
+    struct act_channel_stats st;
+
+    actuators_stats_get(g, i, &st);
+    return st;
+}
+
+static void run_session(void)
+{
+    static struct ctrl_logic cl;
+    struct imu_sample batch[WM_FRAMES];
+    struct ctrl_decision d;
+    bool cue = false, inhibited = false, faulted = false;
+    uint32_t batches = 0, edges = 0, slouches = 0;
+    uint32_t pwm_inhibit[CHANNELS] = { 0 };
+    uint32_t gpio_fault[CHANNELS] = { 0 };
+    uint32_t inhibited_sets = 0, inhibit_leaks = 0;
+    size_t n = 0;
+
+    ctrl_logic_init(&cl, FUSION_BETA, 1.0f / ODR_HZ, &posture_defaults, &calib_defaults);
+
+    for (uint64_t k = 0; (double)k / ODR_HZ < SESSION_S; k++) {
+        double t = (double)k / ODR_HZ;
+
+        sample_at(t, &batch[n++]);
+        if (n < WM_FRAMES) {
+            continue;
+        }
+        ctrl_logic_step(&cl, batch, n, &d);
+        n = 0;
+        batches++;
+        slouches += d.ev == POSTURE_EV_SLOUCH_START;
+        if (d.cue != cue) {
+            edges++;
+            cue = d.cue;
+            if (verbose) {
+                printf("  %7.1f s cue %d\n", t, cue);
+            }
+        }
+
+        /* A write the LED driver refuses, in the first slouch */
+        if (!faulted && t >= FAULT_AT_S) {
+            faulted = true;
+            EXPECT(cue, "no cue at %.0f s", t);
+            actuators_set(ACT_LED, ACT_DUTY_OFF);
+            drv.gpio_fail = 1;
+            memcpy(gpio_fault, drv.gpio_calls, sizeof(gpio_fault));
+            actuators_set(ACT_LED, ACT_DUTY_FULL);
+            EXPECT(stats(ACT_LED, 0).faults == 1 && drv.level[0] == 0,
+                   "failed LED write not counted");
+            EXPECT(drv.gpio_calls[1] == gpio_fault[1] + 1 && drv.level[1] == 1,
+                   "second LED not written past the fault");
+        }
+
+        /* Thermal supervisor trips in the second slouch */
+        if (!inhibited && t >= INHIBIT_FROM_S && t < INHIBIT_TO_S) {
+            inhibited = true;
+            EXPECT(cue, "no cue at %.0f s", t);
+            memcpy(pwm_inhibit, drv.pwm_calls, sizeof(pwm_inhibit));
+            actuators_inhibit(ACT_PELTIER, true);
+            for (int i = 0; i < CHANNELS; i++) {
+                EXPECT(drv.pwm_calls[i] == pwm_inhibit[i] + 1 && drv.pulse_ns[i] == 0,
+                       "Peltier %d not written off on inhibit", i + 1);
+                pwm_inhibit[i] = drv.pwm_calls[i];
+            }
+        } else if (inhibited && t >= INHIBIT_TO_S) {
+            inhibited = false;
+            actuators_inhibit(ACT_PELTIER, false);
+        }
+
+        uint32_t pwm_before[CHANNELS];
+
+        memcpy(pwm_before, drv.pwm_calls, sizeof(pwm_before));
+        actuators_set(ACT_LED, cue ? ACT_DUTY_FULL : ACT_DUTY_OFF);
+        actuators_set(ACT_PELTIER, cue ? PELTIER_DUTY : ACT_DUTY_OFF);
+
+        if (actuators_inhibited(ACT_PELTIER)) {
+            inhibited_sets++;
+            for (int i = 0; i < CHANNELS; i++) {
+                inhibit_leaks += drv.pwm_calls[i] != pwm_before[i] || drv.pulse_ns[i] != 0;
+            }
+        } else if (pwm_inhibit[0] && !inhibited && drv.pwm_calls[0] == pwm_inhibit[0] + 1) {
+            /* First set after the release */
+            for (int i = 0; i < CHANNELS; i++) {
+                EXPECT(drv.pwm_calls[i] == pwm_inhibit[i] + 1 &&
+                       drv.pulse_ns[i] == 10000000u / 1000 * PELTIER_DUTY,
+                       "Peltier %d not restored with one write after the release", i + 1);
+            }
+            pwm_inhibit[0] = 0;
+        }
+
+        for (int i = 0; i < CHANNELS; i++) {
+            EXPECT(drv.level[i] == cue, "LED %d off the cue at %.1f s", i + 1, t);
+            if (!actuators_inhibited(ACT_PELTIER)) {
+                EXPECT(drv.pulse_ns[i] == (cue ? 10000000u / 1000 * PELTIER_DUTY : 0),
+                       "Peltier %d off the cue at %.1f s", i + 1, t);
+            }
+        }
+    }
+
+    /* One write at init and one per cue edge; the fault adds a failed
+     * call, the LED cleared before it and the retry; the inhibit adds the
+     * off write and the restore
+     */
+    printf("%-8s %7s %7s %7s %7s\n", "channel", "sets", "calls", "writes", "skipped");
+    for (int i = 0; i < CHANNELS; i++) {
+        struct act_channel_stats led = stats(ACT_LED, i), pel = stats(ACT_PELTIER, i);
+        uint32_t led_calls = 1 + edges + (i == 0 ? 3 : 2);
+        uint32_t pel_calls = 1 + edges + 2;
+
+        printf("led%d     %7u %7u %7u %7u\n", i + 1, batches, drv.gpio_calls[i], led.writes,
+               led.skipped);
+        printf("peltier%d %7u %7u %7u %7u\n", i + 1, batches, drv.pwm_calls[i], pel.writes,
+               pel.skipped);
+        EXPECT(drv.gpio_calls[i] == led_calls, "LED %d: %u driver calls, expected %u", i + 1,
+               drv.gpio_calls[i], led_calls);
+        EXPECT(drv.pwm_calls[i] == pel_calls, "Peltier %d: %u driver calls, expected %u", i + 1,
+               drv.pwm_calls[i], pel_calls);
+        EXPECT(led.writes + led.faults == drv.gpio_calls[i] && pel.writes == drv.pwm_calls[i],
+               "channel %d: stats do not match the driver", i + 1);
+        EXPECT(led.skipped + drv.gpio_calls[i] == batches + 2 + 1,
+               "LED %d: %u sets skipped of %u", i + 1, led.skipped, batches);
+    }
+    printf("%u batches, %u slouches, %u cue edges, %u sets while inhibited\n", batches, slouches,
+           edges, inhibited_sets);
+    EXPECT(slouches == 2 && edges == 4, "session: %u slouches, %u cue edges", slouches, edges);
+    EXPECT(inhibited_sets > 0 && inhibit_leaks == 0, "%u Peltier writes while inhibited",
+           inhibit_leaks);
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-v")) {
+            verbose = 1;
+            zephyr_host_log = 1;
+        } else {
+            fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (actuators_init() != 0) {
+        return 1;
+    }
+    run_session();
+    return failures != 0;
+}
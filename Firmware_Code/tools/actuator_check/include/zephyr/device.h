@@ -0,0 +1,20 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ACTUATOR_CHECK_DEVICE_H_
+#define ACTUATOR_CHECK_DEVICE_H_
+
+#include <zephyr/devicetree.h>
+
+struct device {
+    const char *name;
+};
+
+#define DEVICE_DT_GET(node)     (&DT_CAT(node, _DEVICE))
+
+/* Defined in actuator_check.c */
+extern const struct device DT_N_pwm0_DEVICE;
+extern const struct device DT_N_gpio0_DEVICE;
+
+#endif /* ACTUATOR_CHECK_DEVICE_H_ */
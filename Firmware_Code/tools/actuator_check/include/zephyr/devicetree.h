@@ -0,0 +1,66 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ACTUATOR_CHECK_DEVICETREE_H_
+#define ACTUATOR_CHECK_DEVICETREE_H_
+
+/* ===== The actuator nodes of app.overlay, for src/actuators.c =====
+ *   zephyr,user  peltiers = <&pwm_led0 &pwm_led2>; cue-leds = <&led1 &led2>;
+ *   pwm_led0     <&pwm0 0 PWM_MSEC(10)>, pwm_led2 <&pwm0 1 PWM_MSEC(10)>
+ *   led1         <&gpio0 22>, led2 <&gpio0 23>
+ */
+#define DT_CAT(a, b)                    a##b
+#define DT_CAT3(a, b, c)                a##b##c
+#define DT_CAT4(a, b, c, d)             a##b##c##d
+#define DT_CAT6(a, b, c, d, e, f)       a##b##c##d##e##f
+#define DT_DEBRACKET_INTERNAL(...)      __VA_ARGS__
+
+#define DT_PATH(node)                   DT_N_S_##node
+#define DT_NODELABEL(label)             DT_N_##label
+#define DT_DEP_ORD(node)                DT_CAT(node, _ORD)
+#define DT_NODE_HAS_PROP(node, prop)    DT_CAT4(node, _P_, prop, _EXISTS)
+#define DT_PHANDLE_BY_IDX(node, prop, idx) DT_CAT6(node, _P_, prop, _IDX_, idx, _PH)
+#define DT_FOREACH_STATUS_OKAY(compat, fn)  DT_CAT(DT_FOREACH_OKAY_, compat)(fn)
+#define DT_FOREACH_CHILD(node, fn)      DT_CAT(node, _FOREACH_CHILD)(fn)
+#define DT_FOREACH_PROP_ELEM_SEP(node, prop, fn, sep) \
+    DT_CAT4(node, _P_, prop, _FOREACH_PROP_ELEM_SEP)(fn, sep)
+
+#define DT_PWMS_CTLR(node)              DT_CAT(node, _PWMS_CTLR)
+#define DT_PWMS_CHANNEL(node)           DT_CAT(node, _PWMS_CHANNEL)
+#define DT_PWMS_PERIOD(node)            DT_CAT(node, _PWMS_PERIOD)
+#define DT_GPIO_CTLR(node, prop)        DT_CAT4(node, _P_, prop, _CTLR)
+#define DT_GPIO_PIN(node, prop)         DT_CAT4(node, _P_, prop, _PIN)
+
+#define DT_N_pwm0_ORD                   12
+#define DT_N_gpio0_ORD                  8
+
+#define DT_N_S_zephyr_user_P_peltiers_EXISTS    1
+#define DT_N_S_zephyr_user_P_cue_leds_EXISTS    1
+#define DT_N_S_zephyr_user_P_peltiers_IDX_0_PH  DT_N_pwm_led0
+#define DT_N_S_zephyr_user_P_peltiers_IDX_1_PH  DT_N_pwm_led2
+#define DT_N_S_zephyr_user_P_cue_leds_IDX_0_PH  DT_N_led1
+#define DT_N_S_zephyr_user_P_cue_leds_IDX_1_PH  DT_N_led2
+#define DT_N_S_zephyr_user_P_peltiers_FOREACH_PROP_ELEM_SEP(fn, sep) \
+    fn(DT_N_S_zephyr_user, peltiers, 0) DT_DEBRACKET_INTERNAL sep    \
+    fn(DT_N_S_zephyr_user, peltiers, 1)
+#define DT_N_S_zephyr_user_P_cue_leds_FOREACH_PROP_ELEM_SEP(fn, sep) \
+    fn(DT_N_S_zephyr_user, cue_leds, 0) DT_DEBRACKET_INTERNAL sep    \
+    fn(DT_N_S_zephyr_user, cue_leds, 1)
+
+#define DT_FOREACH_OKAY_pwm_leds(fn)    fn(DT_N_pwmleds)
+#define DT_N_pwmleds_FOREACH_CHILD(fn)  fn(DT_N_pwm_led0) fn(DT_N_pwm_led2)
+
+#define DT_N_pwm_led0_PWMS_CTLR         DT_N_pwm0
+#define DT_N_pwm_led0_PWMS_CHANNEL      0
+#define DT_N_pwm_led0_PWMS_PERIOD       10000000
+#define DT_N_pwm_led2_PWMS_CTLR         DT_N_pwm0
+#define DT_N_pwm_led2_PWMS_CHANNEL      1
+#define DT_N_pwm_led2_PWMS_PERIOD       10000000
+
+#define DT_N_led1_P_gpios_CTLR          DT_N_gpio0
+#define DT_N_led1_P_gpios_PIN           22
+#define DT_N_led2_P_gpios_CTLR          DT_N_gpio0
+#define DT_N_led2_P_gpios_PIN           23
+
+#endif /* ACTUATOR_CHECK_DEVICETREE_H_ */
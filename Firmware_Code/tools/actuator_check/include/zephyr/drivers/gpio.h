@@ -0,0 +1,36 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ACTUATOR_CHECK_GPIO_H_
+#define ACTUATOR_CHECK_GPIO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+
+typedef uint8_t gpio_pin_t;
+typedef uint16_t gpio_dt_flags_t;
+typedef uint32_t gpio_flags_t;
+
+#define GPIO_OUTPUT_INACTIVE    (1u << 17)
+
+struct gpio_dt_spec {
+    const struct device *port;
+    gpio_pin_t pin;
+    gpio_dt_flags_t dt_flags;
+};
+
+#define GPIO_DT_SPEC_GET(node, prop)                        \
+    {                                                       \
+        .port = DEVICE_DT_GET(DT_GPIO_CTLR(node, prop)),    \
+        .pin = DT_GPIO_PIN(node, prop),                     \
+        .dt_flags = 0,                                      \
+    }
+
+/* Modelled in actuator_check.c */
+int gpio_pin_set_dt(const struct gpio_dt_spec *spec, int value);
+int gpio_pin_configure_dt(const struct gpio_dt_spec *spec, gpio_flags_t extra_flags);
+bool gpio_is_ready_dt(const struct gpio_dt_spec *spec);
+
+#endif /* ACTUATOR_CHECK_GPIO_H_ */
@@ -0,0 +1,33 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ACTUATOR_CHECK_PWM_H_
+#define ACTUATOR_CHECK_PWM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+
+typedef uint16_t pwm_flags_t;
+
+struct pwm_dt_spec {
+    const struct device *dev;
+    uint32_t channel;
+    uint32_t period;            /* ns */
+    pwm_flags_t flags;
+};
+
+#define PWM_DT_SPEC_GET(node)                               \
+    {                                                       \
+        .dev = DEVICE_DT_GET(DT_PWMS_CTLR(node)),           \
+        .channel = DT_PWMS_CHANNEL(node),                   \
+        .period = DT_PWMS_PERIOD(node),                     \
+        .flags = 0,                                         \
+    }
+
+/* Modelled in actuator_check.c */
+int pwm_set_dt(const struct pwm_dt_spec *spec, uint32_t period, uint32_t pulse);
+bool pwm_is_ready_dt(const struct pwm_dt_spec *spec);
+
+#endif /* ACTUATOR_CHECK_PWM_H_ */
@@ -0,0 +1,284 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Run src/adc_stream.c on the emulated SAADC scan
+ * (src/emul/adc_scan_emul.c) on the host kernel in tools/zephyr_host.
+ *
+ *   adc_check [-v]
+ *
+ * The scan timer is stopped and scans are pushed through the emulator
+ * hooks, so every buffer boundary is known:
+ *   empty     nothing is published before the first buffer completes
+ *   swap      the buffers alternate once per CONFIG_NECK_ADC_SCANS_PER_BUFFER
+ *             scans, and each completed buffer is averaged exactly once
+ *   average   a steady input reads back as its code on both channels, after
+ *             oversampling and the per-buffer average
+ *   step      a step lands in the first buffer completed after it; a buffer
+ *             straddling the step averages to the rounded mean of its scans
+ *   noise     +-N codes of conversion noise average down to within a code
+ *   pause     a partly filled buffer survives a pause and completes after
+ *             the rest of its scans; nothing runs while paused
+ *   rate      on the scan timer, one buffer per scans-per-buffer periods
+ * Exit status is 1 if a case fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "zephyr_host.h"
+#include "emul/adc_emul.h"
+#include "adc_stream.h"
+
+#define SCANS           CONFIG_NECK_ADC_SCANS_PER_BUFFER
+#define SCAN_PERIOD_US  (1000000 / CONFIG_NECK_ADC_SCAN_RATE_HZ)
+
+static int verbose;
+
+/* Code of a pin voltage, as the emulator converts it */
+static int code_of(int mv)
+{
+    return (int)(((int64_t)mv << 12) / CONFIG_NECK_ADC_FULL_SCALE_MV);
+}
+
+/* Full-scale code -> voltage, the inverse of code_of() for round values */
+static int mv_of(int code)
+{
+    return (int)(((int64_t)code * CONFIG_NECK_ADC_FULL_SCALE_MV + 4095) >> 12);
+}
+
+static struct adc_stream_stats stats_now(void)
+{
+    struct adc_stream_stats st;
+
+    adc_stream_stats_get(&st);
+    return st;
+}
+
+/* Push scans until the buffer being filled is handed over */
+static void complete_buffer(void)
+{
+    uint32_t done = adc_emul_buffers_done();
+
+    while (adc_emul_buffers_done() == done) {
+        adc_emul_push_scans(1);
+    }
+}
+
+/* ===== Cases ===== */
+static const char *case_empty(void)
+{
+    int16_t code;
+
+    adc_emul_push_scans(SCANS - 1);
+    if (adc_stream_latest(ADC_CH_THERM, &code) != -EAGAIN ||
+        adc_stream_latest(ADC_CH_AUX, &code) != -EAGAIN) {
+        return "value published before a buffer completed";
+    }
+    if (stats_now().buffers != 0) {
+        return "buffer counted before it completed";
+    }
+    adc_emul_push_scans(1);
+    if (adc_stream_latest(ADC_CH_THERM, &code) != 0 || stats_now().buffers != 1) {
+        return "first buffer not published";
+    }
+    return NULL;
+}
+
+static const char *case_swap(void)
+{
+    struct adc_stream_stats before = stats_now();
+    uint32_t done = adc_emul_buffers_done();
+    int active = adc_emul_active_buffer();
+
+    for (int b = 0; b < 10; b++) {
+        for (int s = 0; s < SCANS; s++) {
+            if (adc_emul_active_buffer() != active) {
+                return "buffer swapped before it was full";
+            }
+            adc_emul_push_scans(1);
+        }
+        active ^= 1;
+        if (adc_emul_active_buffer() != active) {
+            return "buffer not swapped when full";
+        }
+        if (adc_emul_buffers_done() != done + b + 1) {
+            return "buffer count";
+        }
+    }
+
+    struct adc_stream_stats after = stats_now();
+
+    if (after.buffers - before.buffers != 10 || after.scans - before.scans != 10 * SCANS) {
+        return "completed buffers not averaged exactly once";
+    }
+    return NULL;
+}
+
+static const char *case_average(void)
+{
+    static const int mv[][2] = { { 1500, 400 }, { 0, 3599 }, { 2400, 1200 } };
+
+    for (size_t i = 0; i < ARRAY_SIZE(mv); i++) {
+        int16_t therm, aux;
+
+        adc_emul_set_input_mv(ADC_CH_THERM, mv[i][0]);
+        adc_emul_set_input_mv(ADC_CH_AUX, mv[i][1]);
+        complete_buffer();
+        /* The buffer filling when the input changed may mix both levels */
+        complete_buffer();
+        adc_stream_latest(ADC_CH_THERM, &therm);
+        adc_stream_latest(ADC_CH_AUX, &aux);
+        if (verbose) {
+            printf("  %4d/%4d mV -> %4d/%4d\n", mv[i][0], mv[i][1], therm, aux);
+        }
+        if (therm != code_of(mv[i][0]) || aux != code_of(mv[i][1])) {
+            return "steady input does not read back";
+        }
+    }
+    return NULL;
+}
+
+static const char *case_step(void)
+{
+    int lo = 1000, hi = 1000 + 100 * CONFIG_NECK_ADC_FULL_SCALE_MV / 4096;
+    int16_t code;
+
+    adc_emul_set_input_mv(ADC_CH_THERM, mv_of(lo));
+    complete_buffer();
+    complete_buffer();
+
+    /* Three scans low, the rest of the buffer high */
+    adc_emul_push_scans(3);
+    adc_emul_set_input_mv(ADC_CH_THERM, mv_of(hi));
+    complete_buffer();
+    adc_stream_latest(ADC_CH_THERM, &code);
+
+    int32_t want = (3 * code_of(mv_of(lo)) + (SCANS - 3) * code_of(mv_of(hi)) + SCANS / 2) / SCANS;
+
+    if (code != want) {
+        return "straddling buffer not the rounded mean of its scans";
+    }
+    complete_buffer();
+    adc_stream_latest(ADC_CH_THERM, &code);
+    if (code != code_of(mv_of(hi))) {
+        return "step not settled one buffer later";
+    }
+    return NULL;
+}
+
+static const char *case_noise(void)
+{
+    const int mv = 1700;
+    int worst = 0;
+
+    adc_emul_set_input_mv(ADC_CH_THERM, mv);
+    adc_emul_set_noise(16);
+    complete_buffer();
+    for (int b = 0; b < 200; b++) {
+        int16_t code;
+
+        complete_buffer();
+        adc_stream_latest(ADC_CH_THERM, &code);
+        worst = MAX(worst, abs(code - code_of(mv)));
+    }
+    adc_emul_set_noise(0);
+    if (verbose) {
+        printf("  +-16 codes of noise, %d conversions per value: worst %d\n",
+               SCANS << CONFIG_NECK_ADC_OVERSAMPLE_LOG2, worst);
+    }
+    /* +-16 uniform is 9.5 codes rms; 128 conversions bring it to 0.84 */
+    return worst > 4 ? "noise not averaged down" : NULL;
+}
+
+static const char *case_pause(void)
+{
+    uint32_t done = adc_emul_buffers_done();
+    int16_t code;
+
+    adc_emul_set_input_mv(ADC_CH_AUX, 900);
+    adc_emul_push_scans(SCANS - 3);
+    adc_emul_set_input_mv(ADC_CH_AUX, 1800);
+
+    /* Paused since main(): a second of nothing */
+    zephyr_host_advance_ms(1000);
+    if (adc_emul_buffers_done() != done) {
+        return "scans ran while paused";
+    }
+
+    /* Three more trigger periods complete the buffer kept over the pause */
+    adc_stream_pause(false);
+    zephyr_host_advance_us(3 * SCAN_PERIOD_US);
+    adc_stream_pause(true);
+    if (adc_emul_buffers_done() != done + 1) {
+        return "partial buffer not completed after resuming";
+    }
+    adc_stream_latest(ADC_CH_AUX, &code);
+
+    int32_t want = ((SCANS - 3) * code_of(900) + 3 * code_of(1800) + SCANS / 2) / SCANS;
+
+    return code != want ? "buffer kept over the pause lost scans" : NULL;
+}
+
+static const char *case_rate(void)
+{
+    struct adc_stream_stats before = stats_now();
+
+    adc_stream_pause(false);
+    zephyr_host_advance_ms(1000);
+    adc_stream_pause(true);
+
+    struct adc_stream_stats after = stats_now();
+    uint32_t scans = after.scans - before.scans;
+    uint32_t buffers = after.buffers - before.buffers;
+
+    if (verbose) {
+        printf("  1 s: %u buffers, %u scans\n", buffers, scans);
+    }
+    if (buffers != CONFIG_NECK_ADC_SCAN_RATE_HZ / SCANS || scans != buffers * SCANS) {
+        return "buffers per second";
+    }
+    return NULL;
+}
+
+static const struct {
+    const char *name;
+    const char *(*run)(void);
+} cases[] = {
+    { "empty", case_empty },
+    { "swap", case_swap },
+    { "average", case_average },
+    { "step", case_step },
+    { "noise", case_noise },
+    { "pause", case_pause },
+    { "rate", case_rate },
+};
+
+int main(int argc, char **argv)
+{
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-v")) {
+            verbose = 1;
+            zephyr_host_log = 1;
+        } else {
+            fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (adc_stream_init() != 0) {
+        return 1;
+    }
+    /* Scans by hand from here on */
+    adc_stream_pause(true);
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        const char *why = cases[i].run();
+
+        printf("%-8s %s%s\n", cases[i].name, why ? "FAIL: " : "ok", why ? why : "");
+        failed |= why != NULL;
+    }
+    return failed;
+}
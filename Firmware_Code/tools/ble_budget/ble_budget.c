@@ -0,0 +1,128 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Radio budget of the telemetry stream characteristic (src/ble_svc.c) for
+ * the link settings the patch negotiates, against the fallbacks a central
+ * may leave it with.
+ *
+ *   ble_budget [--rate N] [--event-us N]
+ *
+ * --rate is the telemetry record rate (default 10/s: 100 Hz ODR, watermark
+ * 10) and --event-us the controller's connection event length (default
+ * 7500 us). For every combination of ATT MTU, LL data length and PHY the
+ * tool prints how many records fit a notification, the LL PDUs and radio
+ * time per notification, the peak stream throughput at the stream-mode
+ * interval and the radio time per second the default record rate costs.
+ * Exit status is 1 if a combination the firmware asks for cannot carry the
+ * record rate.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ble_wire.h"
+
+/* ===== Kconfig defaults / ble_svc.c ===== */
+#define BATCH_MAX           8
+#define STREAM_INTERVAL_US  30000   /* worst case of the 15-30 ms range */
+#define T_IFS_US            150
+#define L2CAP_ATT_HDR       7       /* L2CAP 4 + ATT opcode/handle 3 */
+#define LL_MIC_NONE         0
+
+struct link {
+    const char *name;
+    uint16_t mtu;
+    uint16_t dle;           /* LL payload octets */
+    int phy_mbps;
+    int requested;          /* what ble_svc.c asks for */
+};
+
+static const struct link links[] = {
+    { "default 1M", 23, 27, 1, 0 },
+    { "mtu only", 247, 27, 1, 0 },
+    { "mtu+dle 1M", 247, 251, 1, 0 },
+    { "mtu+dle 2M", 247, 251, 2, 1 },
+    { "mtu 2M", 247, 27, 2, 0 },
+};
+
+/* Air time of one LL data PDU with len payload octets */
+static double pdu_us(int len, int phy_mbps)
+{
+    /* preamble (1 or 2) + access address 4 + header 2 + payload + CRC 3 */
+    int octets = (phy_mbps == 2 ? 2 : 1) + 4 + 2 + len + 3 + LL_MIC_NONE;
+
+    return octets * 8.0 / phy_mbps;
+}
+
+static int run(const struct link *l, double rate, double event_us)
+{
+    size_t recs = ble_stream_batch(l->mtu);
+    const char *why = NULL;
+
+    if (recs > BATCH_MAX) {
+        recs = BATCH_MAX;
+    }
+    if (recs == 0) {
+        printf("%-12s %4u %4u %3dM %5s %5s %9s %10s %10s%s\n", l->name, l->mtu, l->dle,
+               l->phy_mbps, "0", "-", "-", "-", "-",
+               l->requested ? "  FAIL: record does not fit the MTU" : "  (stream off)");
+        return l->requested;
+    }
+
+    int att_len = (int)(recs * sizeof(struct telem_wire)) + 3;
+    int l2cap_len = att_len + 4;
+    int pdus = (l2cap_len + l->dle - 1) / l->dle;
+    double one = 0;
+
+    /* Each data PDU is answered by an empty PDU from the central */
+    for (int i = 0, left = l2cap_len; i < pdus; i++, left -= l->dle) {
+        one += pdu_us(left < l->dle ? left : l->dle, l->phy_mbps) + 2 * T_IFS_US +
+               pdu_us(0, l->phy_mbps);
+    }
+
+    /* Notifications per connection event, bounded by the event length */
+    double per_event = floor(event_us / one);
+    double peak_bps = per_event * recs * sizeof(struct telem_wire) * 1e6 / STREAM_INTERVAL_US;
+    double need_bps = rate * sizeof(struct telem_wire);
+    double radio_ms_s = rate / recs * one / 1000.0;
+
+    if (per_event < 1) {
+        why = "notification longer than the connection event";
+    } else if (peak_bps < need_bps) {
+        why = "cannot carry the record rate";
+    }
+
+    printf("%-12s %4u %4u %3dM %5zu %5d %9.0f %10.0f %10.3f%s%s\n", l->name, l->mtu, l->dle,
+           l->phy_mbps, recs, pdus, one, peak_bps, radio_ms_s,
+           why ? "  FAIL: " : "", why ? why : "");
+    return why != NULL && l->requested;
+}
+
+int main(int argc, char **argv)
+{
+    double rate = 10, event_us = 7500;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && !strcmp(argv[i], "--rate")) {
+            rate = atof(argv[++i]);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--event-us")) {
+            event_us = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--rate N] [--event-us N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (rate <= 0 || event_us <= 0) {
+        return 2;
+    }
+
+    printf("%-12s %4s %4s %4s %5s %5s %9s %10s %10s\n", "link", "mtu", "dle", "phy", "recs",
+           "pdus", "notif us", "peak B/s", "radio ms/s");
+    for (size_t i = 0; i < sizeof(links) / sizeof(links[0]); i++) {
+        failed |= run(&links[i], rate, event_us);
+    }
+    return failed;
+}
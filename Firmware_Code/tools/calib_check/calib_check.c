@@ -0,0 +1,538 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Check the IMU calibration (src/calib.c) and the warm start through the
+ * firmware's decision code (src/ctrl_logic.c) on a synthetic sensor with a
+ * gyro bias and accel offset/gain errors.
+ *
+ *   calib_check [--seed N] [-v]
+ *
+ * Gyro bias: a wearer holding still with a little sway between head turns;
+ * the estimate must come within 0.03 dps of the true bias, and stay put
+ * while the head turns all the time or steadily faster than bias_max.
+ *
+ * 6-position accel: the patch tumbled into each position in turn and held
+ * 2.5 s, 2 deg off vertical; offsets within 2 mg, gains within 0.2 %. Five
+ * positions leave it running, a 200 mg offset fails it, both with the
+ * previous correction kept.
+ *
+ * Snapshot: range checks, and the write policy over a day of one offer a
+ * second (as control.c offers it): at most one routine write per 15 min
+ * while the head moves, next to none while nothing changes.
+ *
+ * Boots: a cold start takes the posture warm-up before the posture is
+ * valid; a warm start from the first boot's snapshot must be valid within
+ * 300 ms of the first sample with the stored neutral pitch. A patch put back
+ * 15 deg off must not take the stored pitch. Times are from the first
+ * sample, batches of 10 at 100 Hz as imu_acq.c delivers them. On the device
+ * the control thread logs the same measure ("Posture valid N ms after the
+ * first batch").
+ *
+ * Exit status is 1 if a check fails.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ctrl_logic.h"
+
+/* ===== Kconfig defaults ===== */
+#define FUSION_BETA         0.1f
+#define ODR_HZ              100
+#define WM_FRAMES           10
+#define SAVE_INTERVAL_MS    (900 * 1000u)
+#define OFFER_MS            1000
+
+static const struct posture_params posture_defaults = {
+    .enter_deg = 15.0f,
+    .exit_deg = 8.0f,
+    .enter_dwell_ms = 3000,
+    .exit_dwell_ms = 1500,
+    .alert_ms = 30000,
+    .baseline_tau_s = 300.0f,
+    .warmup_ms = 5000,
+    .baseline_limit_deg = 30.0f,
+};
+
+static const struct calib_params calib_defaults = {
+    .window_ms = 1000,
+    .gyr_still_dps = 0.3f,
+    .acc_still_mg = 8.0f,
+    .bias_max_dps = 3.0f,
+    .bias_windows = 32,
+};
+
+#define RAD_TO_DEG          57.29577951
+#define PERIOD_S            (1.0 / ODR_HZ)
+#define COUNTS_PER_MG       (IMU_ACC_LSB_PER_G / 1000.0)
+
+static int verbose;
+static int failures;
+
+#define EXPECT(cond, ...)                                           \
+    do {                                                            \
+        if (!(cond)) {                                              \
+            printf("FAIL: ");                                       \
+            printf(__VA_ARGS__);                                    \
+            printf("\n");                                           \
+            failures++;                                             \
+        }                                                           \
+    } while (0)
+
+static uint64_t rng;
+
+static double urand(void)
+{
+    rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (rng >> 40) / 16777216.0;
+}
+
+static double uniform(double lo, double hi)
+{
+    return lo + (hi - lo) * urand();
+}
+
+static double noise(double amp)
+{
+    return (urand() * 2.0 - 1.0) * amp;
+}
+
+/* ===== Sensor model =====
+ * Raw = true / gain + offset for the accel, true + bias for the gyro, so
+ * the calibration's (raw - offset) * gain and raw - bias undo it exactly.
+ * Noise as in odr_check (about 1.4 mg and 0.07 dps).
+ */
+struct sensor {
+    double gyr_bias_dps[3];
+    double acc_off_mg[3];
+    double acc_gain[3];
+};
+
+static const struct sensor sensor_ref = {
+    .gyr_bias_dps = { 0.8, -1.2, 0.5 },
+    .acc_off_mg = { 30.0, -20.0, 45.0 },
+    .acc_gain = { 1.02, 0.98, 1.01 },
+};
+
+static int16_t sat(double v)
+{
+    return v > 32767.0 ? 32767 : (v < -32768.0 ? -32768 : (int16_t)lround(v));
+}
+
+static void sense(const struct sensor *se, const double acc_g[3], const double gyr_dps[3],
+                  struct imu_sample *s)
+{
+    for (int ax = 0; ax < 3; ax++) {
+        s->acc[ax] = sat(acc_g[ax] * IMU_ACC_LSB_PER_G / se->acc_gain[ax] +
+                         se->acc_off_mg[ax] * COUNTS_PER_MG + noise(40));
+        s->gyr[ax] = sat((gyr_dps[ax] + se->gyr_bias_dps[ax]) * IMU_GYR_LSB_PER_DPS + noise(8));
+    }
+}
+
+/* ===== Wearer =====
+ * Holds of 5-20 s at upright_deg with a 0.1 deg sway, each followed by a
+ * raised-cosine head turn about the vertical (1-3 s, 30-150 dps peak).
+ * With hold_max_s 0 the head never stops turning.
+ */
+struct wearer {
+    double upright_deg;
+    double hold_max_s;
+    double turn_t0, turn_d, turn_peak;
+    double sway_phase;
+};
+
+static void wearer_init(struct wearer *w, double upright_deg, double hold_max_s)
+{
+    w->upright_deg = upright_deg;
+    w->hold_max_s = hold_max_s;
+    w->turn_t0 = hold_max_s ? uniform(5.0, hold_max_s) : 0.0;
+    w->turn_d = uniform(1.0, 3.0);
+    w->turn_peak = uniform(30.0, 150.0) * (urand() < 0.5 ? -1.0 : 1.0);
+    w->sway_phase = uniform(0.0, 6.283);
+}
+
+static void wearer_at(struct wearer *w, double t, double *pitch_deg, double *pitch_dps,
+                      double *yaw_dps)
+{
+    const double sway_w = 2.0 * M_PI * 0.25;
+
+    if (t >= w->turn_t0 + w->turn_d) {
+        w->turn_t0 += w->turn_d + (w->hold_max_s ? uniform(5.0, w->hold_max_s) : 0.0);
+        w->turn_d = uniform(1.0, 3.0);
+        w->turn_peak = uniform(30.0, 150.0) * (urand() < 0.5 ? -1.0 : 1.0);
+    }
+    *pitch_deg = w->upright_deg + 0.1 * sin(sway_w * t + w->sway_phase);
+    *pitch_dps = 0.1 * sway_w * cos(sway_w * t + w->sway_phase);
+    *yaw_dps = 0.0;
+    if (t >= w->turn_t0) {
+        double x = (t - w->turn_t0) / w->turn_d;
+
+        *yaw_dps = w->turn_peak * 0.5 * (1.0 - cos(2.0 * M_PI * x));
+    }
+}
+
+/* The patch's frame: x along the spine at upright, pitch about y */
+static void wearer_sample(struct wearer *w, const struct sensor *se, double t,
+                          struct imu_sample *s)
+{
+    double pitch, pitch_dps, yaw;
+
+    wearer_at(w, t, &pitch, &pitch_dps, &yaw);
+
+    double th = pitch / RAD_TO_DEG;
+    double acc[3] = { cos(th), 0.0, sin(th) };
+    double gyr[3] = { yaw * cos(th), pitch_dps, yaw * sin(th) };
+
+    sense(se, acc, gyr, s);
+    s->t_us = (uint32_t)llround(t * 1e6);
+}
+
+/* ===== Gyro bias ===== */
+static void run_bias(const struct sensor *se, double hold_max_s, double steady_dps,
+                     double len_s, struct calib *c)
+{
+    struct wearer w;
+
+    calib_init(c, &calib_defaults);
+    wearer_init(&w, 5.0, hold_max_s);
+    for (double t = 0.0; t < len_s; t += PERIOD_S) {
+        struct imu_sample s;
+
+        wearer_sample(&w, se, t, &s);
+        if (steady_dps) {
+            s.gyr[0] = sat(s.gyr[0] + steady_dps * IMU_GYR_LSB_PER_DPS);
+        }
+        calib_observe(c, &s, 1);
+    }
+}
+
+static void check_bias(void)
+{
+    struct calib c;
+    double err = 0.0;
+
+    run_bias(&sensor_ref, 20.0, 0.0, 300.0, &c);
+    for (int ax = 0; ax < 3; ax++) {
+        double e = fabs(c.gyr_bias[ax] / IMU_GYR_LSB_PER_DPS - sensor_ref.gyr_bias_dps[ax]);
+
+        err = e > err ? e : err;
+    }
+    printf("gyro bias: %u of %u windows still, estimate %+.3f %+.3f %+.3f dps, "
+           "true %+.3f %+.3f %+.3f, worst axis off by %.3f\n",
+           c.still_windows, c.windows, c.gyr_bias[0] / IMU_GYR_LSB_PER_DPS,
+           c.gyr_bias[1] / IMU_GYR_LSB_PER_DPS, c.gyr_bias[2] / IMU_GYR_LSB_PER_DPS,
+           sensor_ref.gyr_bias_dps[0], sensor_ref.gyr_bias_dps[1], sensor_ref.gyr_bias_dps[2],
+           err);
+    EXPECT((c.flags & CALIB_F_GYRO) && err < 0.03, "gyro bias off by %.3f dps", err);
+
+    run_bias(&sensor_ref, 0.0, 0.0, 300.0, &c);
+    printf("           head always turning: %u of %u windows still\n", c.still_windows,
+           c.windows);
+    EXPECT(c.still_windows == 0 && !(c.flags & CALIB_F_GYRO),
+           "%u still windows while the head turns", c.still_windows);
+
+    run_bias(&sensor_ref, 1e9, 5.0, 60.0, &c);
+    printf("           steady 5 dps turn: %u of %u windows still\n", c.still_windows,
+           c.windows);
+    EXPECT(c.still_windows == 0, "%u still windows in a steady turn", c.still_windows);
+}
+
+/* ===== 6-position accel ===== */
+
+/* Capture order: +Z, -X, +Y, -Z, +X, -Y up */
+static const int pos_order[CALIB_POSITIONS] = { 4, 1, 2, 5, 0, 3 };
+
+static void run_6pos(const struct sensor *se, int positions, struct calib *c)
+{
+    double t = 0.0;
+
+    calib_init(c, &calib_defaults);
+    calib_accel_start(c);
+    for (int i = 0; i < positions; i++) {
+        int ax = pos_order[i] / 2;
+        double sign = pos_order[i] % 2 ? -1.0 : 1.0;
+        double tilt = 2.0 / RAD_TO_DEG;
+        double phase = uniform(0.0, 6.283);
+
+        /* Tumbled over 1.5 s, then held for 2.5 s */
+        for (double end = t + 4.0; t < end; t += PERIOD_S) {
+            double acc[3] = { 0.0 }, gyr[3] = { 0.0 };
+            struct imu_sample s;
+
+            if (end - t > 2.5) {
+                double a = 2.0 * M_PI * 0.5 * t + phase;
+
+                acc[0] = cos(a) * 0.7;
+                acc[1] = sin(a) * 0.7;
+                acc[2] = 0.7;
+                gyr[ax] = 180.0;
+            } else {
+                acc[ax] = sign * cos(tilt);
+                acc[(ax + 1) % 3] = sin(tilt);
+            }
+            sense(se, acc, gyr, &s);
+            s.t_us = (uint32_t)llround(t * 1e6);
+            calib_observe(c, &s, 1);
+        }
+    }
+}
+
+static const char *const accel_state_names[] = { "idle", "running", "done", "failed" };
+
+static void check_6pos(void)
+{
+    struct sensor bad = sensor_ref;
+    struct calib c;
+    double off_err = 0.0, gain_err = 0.0;
+
+    run_6pos(&sensor_ref, CALIB_POSITIONS, &c);
+    for (int ax = 0; ax < 3; ax++) {
+        double oe = fabs(c.acc_off[ax] / COUNTS_PER_MG - sensor_ref.acc_off_mg[ax]);
+        double ge = fabs(c.acc_gain[ax] - sensor_ref.acc_gain[ax]);
+
+        off_err = oe > off_err ? oe : off_err;
+        gain_err = ge > gain_err ? ge : gain_err;
+    }
+    printf("6-position: %s, offsets %+.1f %+.1f %+.1f mg, gains %.4f %.4f %.4f, "
+           "off by up to %.2f mg and %.4f\n",
+           accel_state_names[c.accel_state], c.acc_off[0] / COUNTS_PER_MG,
+           c.acc_off[1] / COUNTS_PER_MG, c.acc_off[2] / COUNTS_PER_MG, c.acc_gain[0],
+           c.acc_gain[1], c.acc_gain[2], off_err, gain_err);
+    EXPECT(c.accel_state == CALIB_ACCEL_DONE && (c.flags & CALIB_F_ACCEL),
+           "6-position calibration %s", accel_state_names[c.accel_state]);
+    EXPECT(off_err < 2.0 && gain_err < 0.002, "6-position off by %.2f mg, gain %.4f", off_err,
+           gain_err);
+
+    run_6pos(&sensor_ref, CALIB_POSITIONS - 1, &c);
+    printf("            five positions: %s, mask 0x%02x\n", accel_state_names[c.accel_state],
+           c.accel_mask);
+    EXPECT(c.accel_state == CALIB_ACCEL_RUNNING && !(c.flags & CALIB_F_ACCEL) &&
+           c.acc_gain[0] == 1.0f, "five positions: %s", accel_state_names[c.accel_state]);
+
+    bad.acc_off_mg[1] = 200.0;
+    run_6pos(&bad, CALIB_POSITIONS, &c);
+    printf("            200 mg offset: %s\n", accel_state_names[c.accel_state]);
+    EXPECT(c.accel_state == CALIB_ACCEL_FAILED && !(c.flags & CALIB_F_ACCEL) &&
+           c.acc_off[1] == 0.0f, "200 mg offset: %s", accel_state_names[c.accel_state]);
+}
+
+/* ===== Snapshot ===== */
+static void snap_make(struct calib_snapshot *s, double bias_dps, double baseline_deg,
+                      double pitch_deg)
+{
+    double h = pitch_deg / RAD_TO_DEG / 2.0;
+
+    memset(s, 0, sizeof(*s));
+    s->version = CALIB_SNAPSHOT_VERSION;
+    s->flags = CALIB_F_GYRO | CALIB_F_BASELINE | CALIB_F_ATTITUDE;
+    for (int ax = 0; ax < 3; ax++) {
+        s->gyr_bias[ax] = (float)(bias_dps * IMU_GYR_LSB_PER_DPS);
+        s->acc_gain[ax] = 1.0f;
+    }
+    s->baseline_deg = (float)baseline_deg;
+
+    /* Only differences between snapshots matter here: a turn about y */
+    s->q[0] = (float)cos(h);
+    s->q[2] = (float)-sin(h);
+}
+
+/* One offer a second for a day; returns the writes calib_store.c would do */
+static unsigned run_day(int moving)
+{
+    struct calib_snapshot saved, s;
+    unsigned writes = 0;
+    uint32_t saved_ms = 0;
+    bool have = false;
+
+    for (uint32_t t_s = 0; t_s < 86400; t_s++) {
+        uint32_t t_ms = t_s * OFFER_MS;
+        double bias = 0.5, baseline = 5.0, pitch = 5.0;
+
+        if (moving) {
+            /* Bias drifts with temperature, the neutral pitch wanders, the
+             * head moves
+             */
+            bias += 0.3 * sin(2.0 * M_PI * t_s / 14400.0);
+            baseline += 2.0 * sin(2.0 * M_PI * t_s / 10800.0);
+            pitch = baseline + noise(10.0);
+        }
+        snap_make(&s, bias, baseline, pitch);
+        if (calib_save_due(have ? &saved : NULL, &s, t_ms - saved_ms, SAVE_INTERVAL_MS)) {
+            saved = s;
+            saved_ms = t_ms;
+            have = true;
+            writes++;
+        }
+    }
+    return writes;
+}
+
+static void check_snapshot(void)
+{
+    struct calib_snapshot good, s;
+    unsigned still, moving;
+
+    snap_make(&good, 0.5, 5.0, 5.0);
+    EXPECT(calib_snapshot_valid(&good), "good snapshot rejected");
+    s = good;
+    s.version++;
+    EXPECT(!calib_snapshot_valid(&s), "other version accepted");
+    s = good;
+    s.flags |= 0x80;
+    EXPECT(!calib_snapshot_valid(&s), "unknown flag accepted");
+    s = good;
+    s.gyr_bias[1] = NAN;
+    EXPECT(!calib_snapshot_valid(&s), "NaN bias accepted");
+    s = good;
+    s.acc_gain[2] = 1.5f;
+    EXPECT(!calib_snapshot_valid(&s), "gain 1.5 accepted");
+    s = good;
+    s.baseline_deg = 120.0f;
+    EXPECT(!calib_snapshot_valid(&s), "baseline 120 deg accepted");
+    s = good;
+    memset(s.q, 0, sizeof(s.q));
+    EXPECT(!calib_snapshot_valid(&s), "zero attitude accepted");
+
+    snap_make(&s, 0.52, 5.3, 6.5);
+    EXPECT(!calib_snapshot_differs(&good, &s), "small changes count as a difference");
+    snap_make(&s, 0.6, 5.0, 5.0);
+    EXPECT(calib_snapshot_differs(&good, &s), "0.1 dps bias change missed");
+    snap_make(&s, 0.5, 6.0, 5.0);
+    EXPECT(calib_snapshot_differs(&good, &s), "1 deg baseline change missed");
+    snap_make(&s, 0.5, 5.0, 8.0);
+    EXPECT(calib_snapshot_differs(&good, &s), "3 deg attitude change missed");
+
+    still = run_day(0);
+    moving = run_day(1);
+    printf("snapshot writes per day at one offer a second: %u still, %u moving "
+           "(interval %u s)\n", still, moving, SAVE_INTERVAL_MS / 1000);
+    EXPECT(still <= 1, "%u writes a day with nothing changing", still);
+    EXPECT(moving <= 1 + 86400000 / SAVE_INTERVAL_MS, "%u writes a day", moving);
+}
+
+/* ===== Boots ===== */
+struct boot {
+    const char *name;
+    const struct calib_snapshot *restore;   /* NULL: cold start */
+    double upright_deg;
+
+    /* Results */
+    bool restored, warm;
+    double valid_ms;            /* first sample to a valid posture, < 0: never */
+    double baseline_deg;        /* when it became valid */
+    struct calib_snapshot snap; /* at the end */
+};
+
+static void run_boot(struct boot *b, double len_s)
+{
+    static struct ctrl_logic cl;
+    struct imu_sample batch[WM_FRAMES];
+    struct ctrl_decision d;
+    struct wearer w;
+    size_t n = 0;
+    const double t0 = 0.35;     /* IMU running 350 ms after reset */
+
+    ctrl_logic_init(&cl, FUSION_BETA, 1.0f / ODR_HZ, &posture_defaults, &calib_defaults);
+    b->restored = b->restore && ctrl_logic_restore(&cl, b->restore);
+    b->valid_ms = -1.0;
+    wearer_init(&w, b->upright_deg, 20.0);
+
+    for (double t = t0; t < t0 + len_s; t += PERIOD_S) {
+        wearer_sample(&w, &sensor_ref, t, &batch[n++]);
+        if (n < WM_FRAMES) {
+            continue;
+        }
+        ctrl_logic_step(&cl, batch, n, &d);
+        n = 0;
+        if (cl.valid && b->valid_ms < 0.0) {
+            b->valid_ms = (t - t0) * 1000.0;
+            b->baseline_deg = cl.posture.baseline_deg;
+        }
+    }
+    b->warm = cl.warm_start;
+    ctrl_logic_snapshot(&cl, &b->snap);
+    if (verbose) {
+        printf("  %s: logic says valid %u ms after the first batch, pitch %.2f deg\n",
+               b->name, cl.valid_ms, d.angles.pitch_deg);
+    }
+}
+
+/* The neutral pitch against the wearer's, relative to the first boot's: the
+ * uncalibrated accel offsets tilt every fused pitch alike
+ */
+static void report_boot(const struct boot *b, const struct boot *first)
+{
+    printf("%-22s %8s %6s %9.0f ms %9.2f deg %9.2f deg\n", b->name,
+           b->restore ? (b->restored ? "restored" : "rejected") : "-", b->warm ? "warm" : "cold",
+           b->valid_ms, b->baseline_deg,
+           b->baseline_deg - first->baseline_deg - (b->upright_deg - first->upright_deg));
+}
+
+static void check_boots(void)
+{
+    struct boot first = { .name = "first boot", .upright_deg = 6.0 };
+    struct boot boots[] = {
+        { .name = "same fit", .restore = &first.snap, .upright_deg = 6.0 },
+        { .name = "3 deg off", .restore = &first.snap, .upright_deg = 9.0 },
+        { .name = "re-applied 15 deg off", .restore = &first.snap, .upright_deg = 21.0 },
+        { .name = "cold start", .upright_deg = 6.0 },
+    };
+    const double warmup_ms = posture_defaults.warmup_ms;
+
+    printf("\n%-22s %8s %6s %12s %13s %13s\n", "boot", "snapshot", "start", "to valid",
+           "neutral", "off");
+    run_boot(&first, 120.0);
+    report_boot(&first, &first);
+    EXPECT((first.snap.flags & (CALIB_F_GYRO | CALIB_F_BASELINE | CALIB_F_ATTITUDE)) ==
+           (CALIB_F_GYRO | CALIB_F_BASELINE | CALIB_F_ATTITUDE),
+           "first boot snapshot flags 0x%02x", first.snap.flags);
+
+    for (size_t i = 0; i < sizeof(boots) / sizeof(boots[0]); i++) {
+        run_boot(&boots[i], 20.0);
+        report_boot(&boots[i], &first);
+    }
+
+    const struct boot *same = &boots[0], *off3 = &boots[1], *moved = &boots[2];
+    const struct boot *cold = &boots[3];
+
+    EXPECT(same->warm && same->valid_ms >= 0.0 && same->valid_ms <= 300.0,
+           "warm start valid after %.0f ms", same->valid_ms);
+    EXPECT(fabs(same->baseline_deg - first.snap.baseline_deg) < 0.01,
+           "warm start neutral %.2f deg, stored %.2f", same->baseline_deg,
+           first.snap.baseline_deg);
+    EXPECT(off3->warm && off3->valid_ms <= 300.0, "3 deg off: %s start, valid after %.0f ms",
+           off3->warm ? "warm" : "cold", off3->valid_ms);
+    EXPECT(!moved->warm && moved->valid_ms >= warmup_ms &&
+           fabs(moved->baseline_deg - cold->baseline_deg - 15.0) < 1.0,
+           "re-applied patch: %s start, neutral %.2f deg", moved->warm ? "warm" : "cold",
+           moved->baseline_deg);
+    EXPECT(!cold->warm && cold->valid_ms >= warmup_ms && cold->valid_ms <= warmup_ms + 300.0,
+           "cold start valid after %.0f ms", cold->valid_ms);
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "-v")) {
+            verbose = 1;
+        } else {
+            fprintf(stderr, "usage: %s [--seed N] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    rng = seed;
+    check_bias();
+    check_6pos();
+    check_snapshot();
+    check_boots();
+
+    printf("\n%s\n", failures ? "FAILED" : "all checks passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,408 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Accuracy and cost of the three fusion paths in src/fusion.c against a
+ * double-precision Madgwick filter on the same raw samples.
+ *
+ *   fusion_bench [--seconds N] [--seed N] [--odr HZ] [--max-float DEG] [--max-q DEG]
+ *
+ * A synthetic head turns, nods and tilts (sums of sinusoids, up to about
+ * 150 dps) at --odr (default 100 Hz); its gyro and accel are quantised to
+ * BMI270 counts with a little noise. The reference runs the same equations
+ * as madgwick_step() in double on the same counts, so the differences are
+ * the rounding of each path, not the filter's own error against the true
+ * orientation (reported alongside for scale). The error is the angle
+ * between the gravity directions, the tilt posture is judged on; heading
+ * is unobservable and is left out.
+ *
+ * fusion_update() and fusion_update_batch() must stay within --max-float
+ * (default 0.01 deg) of the reference and the batch must match the
+ * per-sample float path exactly (the plain C conversion, not CMSIS-DSP);
+ * fusion_q_update() must stay within --max-q (default 0.5 deg). Each path
+ * is then timed over the whole trace, best of five runs, in ns per update
+ * on this host. Exit status is 1 if a bound is exceeded.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fusion.h"
+
+#define BETA        FUSION_BETA_DEFAULT
+#define RUNS        5
+
+/* ===== Double-precision reference (madgwick_step() in double) ===== */
+struct ref {
+    double q[4];
+};
+
+static void ref_step(struct ref *f, double gx, double gy, double gz,
+                     double ax, double ay, double az, double dt)
+{
+    double q0 = f->q[0], q1 = f->q[1], q2 = f->q[2], q3 = f->q[3];
+    double qd0 = 0.5 * (-q1 * gx - q2 * gy - q3 * gz);
+    double qd1 = 0.5 * (q0 * gx + q2 * gz - q3 * gy);
+    double qd2 = 0.5 * (q0 * gy - q1 * gz + q3 * gx);
+    double qd3 = 0.5 * (q0 * gz + q1 * gy - q2 * gx);
+    double an = ax * ax + ay * ay + az * az;
+
+    if (an > 0.0) {
+        double r = 1.0 / sqrt(an);
+
+        ax *= r;
+        ay *= r;
+        az *= r;
+
+        double s0 = 4 * q0 * q2 * q2 + 2 * q2 * ax + 4 * q0 * q1 * q1 - 2 * q1 * ay;
+        double s1 = 4 * q1 * q3 * q3 - 2 * q3 * ax + 4 * q0 * q0 * q1 - 2 * q0 * ay - 4 * q1 +
+                    8 * q1 * q1 * q1 + 8 * q1 * q2 * q2 + 4 * q1 * az;
+        double s2 = 4 * q0 * q0 * q2 + 2 * q0 * ax + 4 * q2 * q3 * q3 - 2 * q3 * ay - 4 * q2 +
+                    8 * q2 * q1 * q1 + 8 * q2 * q2 * q2 + 4 * q2 * az;
+        double s3 = 4 * q1 * q1 * q3 - 2 * q1 * ax + 4 * q2 * q2 * q3 - 2 * q2 * ay;
+        double sn = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+
+        if (sn > 0.0) {
+            r = BETA / sqrt(sn);
+            qd0 -= r * s0;
+            qd1 -= r * s1;
+            qd2 -= r * s2;
+            qd3 -= r * s3;
+        }
+    }
+
+    q0 += qd0 * dt;
+    q1 += qd1 * dt;
+    q2 += qd2 * dt;
+    q3 += qd3 * dt;
+
+    double r = 1.0 / sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+
+    f->q[0] = q0 * r;
+    f->q[1] = q1 * r;
+    f->q[2] = q2 * r;
+    f->q[3] = q3 * r;
+}
+
+/* ===== Synthetic head ===== */
+static double gauss(void)
+{
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+static int16_t to_counts(double v)
+{
+    v = round(v);
+    return (int16_t)(v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : v);
+}
+
+/* Gravity in the sensor frame, as fusion.c reads pitch and roll from it */
+static void gravity(const double q[4], double g[3])
+{
+    g[0] = 2.0 * (q[1] * q[3] - q[0] * q[2]);
+    g[1] = 2.0 * (q[0] * q[1] + q[2] * q[3]);
+    g[2] = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+}
+
+/* Angle between the gravity directions of two orientations, degrees. Only
+ * the tilt matters to posture; heading is not observable and drifts apart.
+ */
+static double tilt_err_deg(const double a[4], const double b[4])
+{
+    double ga[3], gb[3];
+
+    gravity(a, ga);
+    gravity(b, gb);
+
+    double cx = ga[1] * gb[2] - ga[2] * gb[1];
+    double cy = ga[2] * gb[0] - ga[0] * gb[2];
+    double cz = ga[0] * gb[1] - ga[1] * gb[0];
+    double dot = ga[0] * gb[0] + ga[1] * gb[1] + ga[2] * gb[2];
+
+    return atan2(sqrt(cx * cx + cy * cy + cz * cz), dot) * 180.0 / M_PI;
+}
+
+struct trace {
+    struct imu_sample *s;
+    double (*truth)[4];         /* true orientation at each sample */
+    size_t n;
+    uint32_t period_us;
+};
+
+static void make_trace(struct trace *tr, double seconds, int odr_hz)
+{
+    const int sub = 20;
+    double amp[3][3], hz[3][3], ph[3][3];
+    double q[4] = { M_SQRT1_2, 0.0, -M_SQRT1_2, 0.0 };
+
+    tr->period_us = 1000000u / (uint32_t)odr_hz;
+    tr->n = (size_t)(seconds * odr_hz);
+    tr->s = calloc(tr->n, sizeof(*tr->s));
+    tr->truth = calloc(tr->n, sizeof(*tr->truth));
+    if (!tr->s || !tr->truth) {
+        exit(2);
+    }
+
+    /* Three components per axis, 0.1-2 Hz, 60 dps at most each */
+    for (int ax = 0; ax < 3; ax++) {
+        for (int k = 0; k < 3; k++) {
+            amp[ax][k] = (10.0 + 50.0 * rand() / RAND_MAX) * M_PI / 180.0 / (k + 1);
+            hz[ax][k] = 0.1 + 1.9 * rand() / RAND_MAX;
+            ph[ax][k] = 2.0 * M_PI * rand() / RAND_MAX;
+        }
+    }
+
+    double dt = 1.0 / odr_hz / sub;
+    double t = 0.0;
+
+    for (size_t i = 0; i < tr->n; i++) {
+        double w[3] = { 0 };
+
+        for (int j = 0; j < sub; j++, t += dt) {
+            for (int ax = 0; ax < 3; ax++) {
+                w[ax] = 0.0;
+                for (int k = 0; k < 3; k++) {
+                    w[ax] += amp[ax][k] * sin(2.0 * M_PI * hz[ax][k] * t + ph[ax][k]);
+                }
+            }
+
+            double qd[4] = {
+                0.5 * (-q[1] * w[0] - q[2] * w[1] - q[3] * w[2]),
+                0.5 * (q[0] * w[0] + q[2] * w[2] - q[3] * w[1]),
+                0.5 * (q[0] * w[1] - q[1] * w[2] + q[3] * w[0]),
+                0.5 * (q[0] * w[2] + q[1] * w[1] - q[2] * w[0]),
+            };
+            double r = 0.0;
+
+            for (int k = 0; k < 4; k++) {
+                q[k] += qd[k] * dt;
+                r += q[k] * q[k];
+            }
+            r = 1.0 / sqrt(r);
+            for (int k = 0; k < 4; k++) {
+                q[k] *= r;
+            }
+        }
+
+        double g[3];
+        struct imu_sample *s = &tr->s[i];
+
+        gravity(q, g);
+
+        s->t_us = (uint32_t)(i + 1) * tr->period_us;
+        for (int ax = 0; ax < 3; ax++) {
+            s->gyr[ax] = to_counts((w[ax] * 180.0 / M_PI + 0.05 * gauss()) *
+                                   IMU_GYR_LSB_PER_DPS);
+            s->acc[ax] = to_counts((g[ax] + 0.01 * gauss()) * IMU_ACC_LSB_PER_G);
+        }
+        memcpy(tr->truth[i], q, sizeof(q));
+    }
+}
+
+/* ===== Paths ===== */
+static void run_ref(const struct trace *tr, double (*out)[4])
+{
+    struct ref f = { { M_SQRT1_2, 0.0, -M_SQRT1_2, 0.0 } };
+    double dt = tr->period_us * 1e-6;
+    double scale = M_PI / 180.0 / IMU_GYR_LSB_PER_DPS;
+
+    for (size_t i = 0; i < tr->n; i++) {
+        const struct imu_sample *s = &tr->s[i];
+
+        ref_step(&f, s->gyr[0] * scale, s->gyr[1] * scale, s->gyr[2] * scale,
+                 s->acc[0], s->acc[1], s->acc[2], dt);
+        if (out) {
+            memcpy(out[i], f.q, sizeof(f.q));
+        }
+    }
+}
+
+static void run_float(const struct trace *tr, double (*out)[4])
+{
+    struct fusion f;
+    float dt = tr->period_us * 1e-6f;
+
+    fusion_init(&f, BETA, FUSION_GYR_RAD_PER_LSB);
+    for (size_t i = 0; i < tr->n; i++) {
+        fusion_update(&f, tr->s[i].gyr, tr->s[i].acc, dt);
+        if (out) {
+            for (int k = 0; k < 4; k++) {
+                out[i][k] = f.q[k];
+            }
+        }
+    }
+}
+
+/* One watermark of samples per call, like control.c */
+static void run_batch(const struct trace *tr, double (*out)[4], size_t batch)
+{
+    struct fusion f;
+    uint32_t prev_us = 0;
+
+    fusion_init(&f, BETA, FUSION_GYR_RAD_PER_LSB);
+    for (size_t i = 0; i < tr->n; i += batch) {
+        size_t m = tr->n - i < batch ? tr->n - i : batch;
+
+        fusion_update_batch(&f, &tr->s[i], m, prev_us, 0.1f);
+        prev_us = tr->s[i + m - 1].t_us;
+        if (out) {
+            for (int k = 0; k < 4; k++) {
+                out[i + m - 1][k] = f.q[k];
+            }
+        }
+    }
+}
+
+static void run_q(const struct trace *tr, double (*out)[4])
+{
+    struct fusion_q f;
+    int32_t dt = (int32_t)lround(tr->period_us * 1e-6 * FUSION_Q_ONE);
+
+    fusion_q_init(&f, (int32_t)lround(BETA * FUSION_Q_ONE),
+                  (int32_t)lround(FUSION_GYR_RAD_PER_LSB * FUSION_Q_ONE));
+    for (size_t i = 0; i < tr->n; i++) {
+        fusion_q_update(&f, tr->s[i].gyr, tr->s[i].acc, dt);
+        if (out) {
+            for (int k = 0; k < 4; k++) {
+                out[i][k] = (double)f.q[k] / FUSION_Q_ONE;
+            }
+        }
+    }
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static size_t bench_batch = 10;
+
+static void run_batch_timed(const struct trace *tr, double (*out)[4])
+{
+    run_batch(tr, out, bench_batch);
+}
+
+static double time_path(void (*run)(const struct trace *, double (*)[4]),
+                        const struct trace *tr)
+{
+    double best = INFINITY;
+
+    for (int r = 0; r < RUNS; r++) {
+        double t0 = now_ns();
+
+        run(tr, NULL);
+        best = fmin(best, (now_ns() - t0) / tr->n);
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = 600.0;
+    unsigned int seed = 1;
+    int odr_hz = 100;
+    double max_float = 0.01;
+    double max_q = 0.5;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && !strcmp(argv[i], "--seconds")) {
+            seconds = atof(argv[++i]);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--seed")) {
+            seed = (unsigned int)atoi(argv[++i]);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--odr")) {
+            odr_hz = atoi(argv[++i]);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--max-float")) {
+            max_float = atof(argv[++i]);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--max-q")) {
+            max_q = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--seconds N] [--seed N] [--odr HZ] [--max-float DEG] "
+                    "[--max-q DEG]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (seconds <= 0.0 || odr_hz <= 0 || odr_hz > 1600) {
+        return 2;
+    }
+
+    struct trace tr;
+
+    srand(seed);
+    make_trace(&tr, seconds, odr_hz);
+
+    double (*ref)[4] = calloc(tr.n, sizeof(*ref));
+    double (*out)[4] = calloc(tr.n, sizeof(*out));
+    double (*flt)[4] = calloc(tr.n, sizeof(*flt));
+
+    if (!ref || !out || !flt) {
+        return 2;
+    }
+    run_ref(&tr, ref);
+    run_float(&tr, flt);
+
+    static const struct {
+        const char *name;
+        void (*run)(const struct trace *, double (*)[4]);
+        int q;
+    } paths[] = {
+        { "double", run_ref, 0 },
+        { "float", run_float, 0 },
+        { "batch", run_batch_timed, 0 },
+        { "q8.24", run_q, 1 },
+    };
+
+    printf("%zu samples at %d Hz, batches of %zu\n", tr.n, odr_hz, bench_batch);
+    printf("%-8s %12s %12s %12s %10s\n", "path", "max err deg", "rms err deg", "vs truth",
+           "ns/update");
+    for (size_t p = 0; p < sizeof(paths) / sizeof(paths[0]); p++) {
+        double max_err = 0.0, sum2 = 0.0, truth = 0.0;
+        size_t n_cmp = 0;
+        const char *why = NULL;
+
+        memset(out, 0, tr.n * sizeof(*out));
+        paths[p].run(&tr, out);
+        for (size_t i = 0; i < tr.n; i++) {
+            /* The batch path is compared at the end of every batch */
+            if (out[i][0] == 0.0 && out[i][1] == 0.0 && out[i][2] == 0.0 && out[i][3] == 0.0) {
+                continue;
+            }
+
+            double e = tilt_err_deg(out[i], ref[i]);
+
+            max_err = fmax(max_err, e);
+            sum2 += e * e;
+            truth = fmax(truth, tilt_err_deg(out[i], tr.truth[i]));
+            n_cmp++;
+            if (paths[p].run == run_batch_timed && !why &&
+                memcmp(out[i], flt[i], sizeof(out[i]))) {
+                why = "batch differs from the per-sample float path";
+            }
+        }
+        if (!why && max_err > (paths[p].q ? max_q : max_float)) {
+            why = "error bound";
+        }
+
+        double ns = time_path(paths[p].run, &tr);
+
+        printf("%-8s %12.5f %12.5f %12.3f %10.1f%s%s\n", paths[p].name, max_err,
+               sqrt(sum2 / (n_cmp ? n_cmp : 1)), truth, ns, why ? "  FAIL: " : "",
+               why ? why : "");
+        failed |= why != NULL;
+    }
+
+    free(ref);
+    free(out);
+    free(flt);
+    free(tr.s);
+    free(tr.truth);
+    return failed;
+}
@@ -0,0 +1,101 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Compile every waveform in src/haptic_wave.c and check the PWM sequence
+ * against its reference envelope.
+ *
+ *   haptic_check [--resonant-hz N] [--max-err PERMILLE] [--dump NAME]
+ *
+ * For each carrier period the vibration amplitude implied by the compare
+ * value, sin(pi * duty), is compared with the piecewise-linear envelope
+ * evaluated in double precision at the middle of the period. The sequence
+ * length, polarity bit and 50 % duty ceiling are checked as well. Exit
+ * status is 1 if any waveform fails.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "haptic_wave.h"
+
+#define SEQ_CAP     4096
+
+static double ref_envelope(const struct haptic_wave *w, double t_ms)
+{
+    for (int i = 0; i < w->nseg; i++) {
+        const struct haptic_seg *s = &w->seg[i];
+
+        if (t_ms < s->dur_ms) {
+            return s->from + (s->to - s->from) * (t_ms / s->dur_ms);
+        }
+        t_ms -= s->dur_ms;
+    }
+    return 0.0;
+}
+
+int main(int argc, char **argv)
+{
+    int resonant_hz = 175;
+    double max_err = 10.0;
+    const char *dump = NULL;
+    static uint16_t buf[SEQ_CAP];
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && !strcmp(argv[i], "--resonant-hz")) {
+            resonant_hz = atoi(argv[++i]);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--max-err")) {
+            max_err = atof(argv[++i]);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--dump")) {
+            dump = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--resonant-hz N] [--max-err PERMILLE] [--dump NAME]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    printf("%-16s %6s %6s %8s %10s\n", "waveform", "ms", "steps", "bytes", "max err");
+    for (int p = 0; p < HAPTIC_PATTERN_COUNT; p++) {
+        const struct haptic_wave *w = &haptic_waves[p];
+        struct haptic_seq seq = { .buf = buf, .cap = SEQ_CAP };
+        double period_ms = 1000.0 / resonant_hz;
+        double err = 0.0;
+        const char *why = NULL;
+
+        if (haptic_compile(w, (uint16_t)resonant_hz, &seq) != 0) {
+            why = "compile failed";
+        } else if (seq.len != (unsigned)floor(haptic_wave_duration_ms(w) / period_ms)) {
+            why = "wrong length";
+        }
+
+        for (int i = 0; !why && i < seq.len; i++) {
+            uint16_t cmp = seq.buf[i] & ~HAPTIC_SEQ_POLARITY;
+            double duty = (double)cmp / seq.countertop;
+            double amp = sin(M_PI * duty) * HAPTIC_AMP_FULL;
+            double ref = ref_envelope(w, (i + 0.5) * period_ms);
+
+            if (!(seq.buf[i] & HAPTIC_SEQ_POLARITY)) {
+                why = "polarity bit missing";
+            } else if (cmp > seq.countertop / 2) {
+                why = "duty above 50 %";
+            }
+            if (fabs(amp - ref) > err) {
+                err = fabs(amp - ref);
+            }
+            if (dump && !strcmp(dump, w->name)) {
+                fprintf(stderr, "%d,%u,%.1f,%.1f\n", i, cmp, amp, ref);
+            }
+        }
+        if (!why && err > max_err) {
+            why = "envelope error";
+        }
+
+        printf("%-16s %6u %6u %8zu %10.1f%s%s\n", w->name, (unsigned)haptic_wave_duration_ms(w),
+               seq.len, seq.len * sizeof(uint16_t), err, why ? "  FAIL: " : "", why ? why : "");
+        failed |= why != NULL;
+    }
+    return failed;
+}
@@ -0,0 +1,475 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Drive src/imu_acq.c against the emulated BMI270 FIFO
+ * (src/emul/imu_fifo_emul.c) on the host kernel in tools/zephyr_host.
+ *
+ *   imu_check [-v]
+ *
+ * The first cases stop the emulated ODR timer, push frames through the
+ * emulator hooks and call drain_fifo()/parse_burst() directly: one
+ * watermark, a backlog larger than one burst (the frame that does not fit
+ * stays in the FIFO for the next burst), a FIFO that ran full (skip frame
+ * and overrun count), a full sample ring, and hand-built bursts with a cut
+ * frame, trailing sensortime/config frames and a corrupt header. Every
+ * sample must decode to the frame pushed, stamped one period apart, and
+ * every lost frame must be counted once in the acquisition stats and the
+ * STAGE_ACQ overruns. At the highest adaptive rate, late drains of two
+ * watermarks each, two per control pass (the batch semaphore merges their
+ * gives), must still leave the ring empty after every pass of
+ * control_thread(). The last case runs the acquisition thread on the ODR
+ * timer for a while and checks that it delivers every frame it parses.
+ * Exit status is 1 if a case fails.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "zephyr_host.h"
+#include "emul/imu_emul.h"
+
+/* The parser and the drain are static: check them in place */
+#include "imu_acq.c"
+
+#define EMUL_FIFO_FRAMES    (IMU_FIFO_SIZE_BYTES / IMU_FIFO_FRAME_BYTES)
+
+/* control.c's batch (IMU_BATCH_MAX) */
+#define CONTROL_BATCH       (2 * CONFIG_NECK_IMU_FIFO_WATERMARK)
+
+static int verbose;
+
+/* Frame k carries these counts, so every sample tells where it came from */
+static void frame_counts(uint32_t k, int16_t acc[3], int16_t gyr[3])
+{
+    for (int ax = 0; ax < 3; ax++) {
+        acc[ax] = (int16_t)(1000 * ax + (int32_t)(k % 1000));
+        gyr[ax] = (int16_t)(-1000 * ax - (int32_t)(k % 1000));
+    }
+}
+
+static void push_numbered(uint32_t first, uint32_t n)
+{
+    int16_t acc[3], gyr[3];
+
+    for (uint32_t k = first; k < first + n; k++) {
+        frame_counts(k, acc, gyr);
+        imu_emul_set_sample(acc, gyr);
+        imu_emul_push_frames(1);
+    }
+}
+
+static void put_frame(uint8_t *p, uint32_t k)
+{
+    int16_t acc[3], gyr[3];
+
+    frame_counts(k, acc, gyr);
+    p[0] = IMU_FIFO_HDR_ACC_GYR;
+    for (int ax = 0; ax < 3; ax++) {
+        sys_put_le16(gyr[ax], &p[1 + 2 * ax]);
+        sys_put_le16(acc[ax], &p[7 + 2 * ax]);
+    }
+}
+
+struct collect {
+    uint32_t next_k;            /* frame number expected next */
+    bool same;                  /* every frame is frame next_k */
+    uint32_t last_t_us;
+    bool have_t;
+    const char *why;
+};
+
+/* Pop up to max samples, checking values and stamps; returns the count */
+static uint32_t collect(struct collect *c, uint32_t max)
+{
+    struct imu_sample s;
+    uint32_t n = 0;
+
+    while (n < max && imu_acq_get(&s)) {
+        int16_t acc[3], gyr[3];
+
+        frame_counts(c->next_k, acc, gyr);
+        if (!c->why && (memcmp(s.acc, acc, sizeof(acc)) || memcmp(s.gyr, gyr, sizeof(gyr)))) {
+            c->why = "sample does not match the frame pushed";
+        }
+        if (!c->why && c->have_t && (int32_t)(s.t_us - c->last_t_us) <= 0) {
+            c->why = "stamps not increasing";
+        }
+        c->last_t_us = s.t_us;
+        c->have_t = true;
+        c->next_k += !c->same;
+        n++;
+    }
+    return n;
+}
+
+static void drain_all(struct collect *c, uint32_t *got)
+{
+    int more;
+
+    do {
+        more = drain_fifo();
+        *got += collect(c, UINT32_MAX);
+    } while (more > 0);
+}
+
+static void reset(void)
+{
+    struct imu_sample s;
+
+    while (imu_acq_get(&s)) {
+    }
+    atomic_clear(&sample_ring.drops);
+    stats = (struct imu_acq_stats){ 0 };
+    imu_clock_restart(&clock);
+    imu_fifo_flush();
+    pipeline_stage_init(STAGE_ACQ, WM_FRAMES * PERIOD_US);
+    /* Space the cases out so no stamp repeats */
+    zephyr_host_advance_ms(100);
+}
+
+static uint32_t acq_overruns(void)
+{
+    struct stage_stats st;
+
+    pipeline_stats_get(STAGE_ACQ, &st);
+    return st.overruns;
+}
+
+/* ===== Cases ===== */
+static const char *case_watermark(void)
+{
+    struct collect c = { 0 };
+    uint32_t got;
+
+    push_numbered(0, WM_FRAMES);
+    uint32_t t_drain = pipeline_now_us();
+
+    if (drain_fifo() != 0) {
+        return "one watermark needed more than one burst";
+    }
+    got = collect(&c, UINT32_MAX);
+    if (c.why) {
+        return c.why;
+    }
+    if (got != WM_FRAMES || stats.frames != WM_FRAMES || stats.bursts != 1) {
+        return "frame or burst count";
+    }
+    /* First burst: the newest frame is stamped with the drain time */
+    if (c.last_t_us != t_drain) {
+        return "newest frame not stamped at the drain";
+    }
+    return NULL;
+}
+
+static const char *case_backlog(void)
+{
+    struct collect c = { 0 };
+    uint32_t per_burst = (sizeof(burst_buf) - 4) / IMU_FIFO_FRAME_BYTES;
+    uint32_t n = per_burst + 5;
+    uint32_t got = 0;
+
+    push_numbered(0, n);
+    uint32_t t_drain = pipeline_now_us();
+
+    if (drain_fifo() != 1) {
+        return "backlog drained in one burst";
+    }
+    got += collect(&c, UINT32_MAX);
+    if (got != per_burst) {
+        return "first burst did not hold the whole frames that fit";
+    }
+    /* The five frames left behind are the newest */
+    if (c.last_t_us != t_drain - 5 * PERIOD_US) {
+        return "first burst not stamped behind the frames left in the FIFO";
+    }
+    drain_all(&c, &got);
+    if (c.why) {
+        return c.why;
+    }
+    if (got != n || stats.bursts != 2 || stats.parse_errors != 0) {
+        return "frames lost or split between bursts";
+    }
+    if (c.last_t_us != t_drain) {
+        return "newest frame not stamped at the drain";
+    }
+    return NULL;
+}
+
+static const char *case_full(void)
+{
+    struct collect c = { 0 };
+    uint32_t lost = 7;
+    uint32_t before = imu_emul_overrun_frames();
+    uint32_t acq_before = acq_overruns();
+    uint32_t got = 0;
+
+    push_numbered(0, EMUL_FIFO_FRAMES + lost);
+    if (imu_emul_overrun_frames() - before != lost) {
+        return "emulator did not overrun";
+    }
+    /* The oldest frames went; the survivors start at frame `lost` */
+    c.next_k = lost;
+    drain_all(&c, &got);
+    if (c.why) {
+        return c.why;
+    }
+    if (got != EMUL_FIFO_FRAMES) {
+        return "surviving frames not all delivered";
+    }
+    if (stats.fifo_overruns != lost || acq_overruns() - acq_before != lost) {
+        return "skip frame not counted once";
+    }
+    if (stats.ring_drops != 0 || stats.parse_errors != 0) {
+        return "unexpected drops or parse errors";
+    }
+    return NULL;
+}
+
+static const char *case_ring_full(void)
+{
+    struct collect c = { 0 };
+    uint32_t n = CONFIG_NECK_IMU_RING_SIZE + 44;
+    uint32_t acq_before = acq_overruns();
+    int more;
+
+    push_numbered(0, n);
+    /* Nobody consumes meanwhile */
+    do {
+        more = drain_fifo();
+    } while (more > 0);
+    uint32_t got = collect(&c, UINT32_MAX);
+
+    if (c.why) {
+        return c.why;
+    }
+    if (got != CONFIG_NECK_IMU_RING_SIZE || stats.frames != n) {
+        return "ring did not keep the oldest frames";
+    }
+    if (stats.ring_drops != n - got || acq_overruns() - acq_before != n - got) {
+        return "ring drops not counted once";
+    }
+    return NULL;
+}
+
+static const char *case_cut(void)
+{
+    struct collect c = { 0 };
+    uint8_t buf[6 * IMU_FIFO_FRAME_BYTES];
+    size_t i = 0;
+
+    put_frame(&buf[i], 0);
+    i += IMU_FIFO_FRAME_BYTES;
+    put_frame(&buf[i], 1);
+    i += IMU_FIFO_FRAME_BYTES;
+    buf[i++] = IMU_FIFO_HDR_SKIP;
+    buf[i++] = 3;
+    put_frame(&buf[i], 2);
+    i += IMU_FIFO_FRAME_BYTES;
+    /* The burst ends six bytes into the next frame */
+    put_frame(&buf[i], 3);
+    i += 6;
+
+    uint32_t t_drain = pipeline_now_us();
+
+    parse_burst(buf, i, i, t_drain);
+    uint32_t got = collect(&c, UINT32_MAX);
+
+    if (c.why) {
+        return c.why;
+    }
+    if (got != 3 || stats.frames != 3) {
+        return "cut frame parsed or whole frames lost";
+    }
+    if (stats.fifo_overruns != 3 || stats.parse_errors != 0) {
+        return "skip count or parse error";
+    }
+    /* A skip frame means frames are missing: stamp from the drain time */
+    if (c.last_t_us != t_drain) {
+        return "newest frame not stamped at the drain after a skip";
+    }
+    return NULL;
+}
+
+static const char *case_trailer(void)
+{
+    struct collect c = { 0 };
+    uint8_t buf[4 * IMU_FIFO_FRAME_BYTES + 16];
+    size_t i = 0;
+
+    put_frame(&buf[i], 0);
+    i += IMU_FIFO_FRAME_BYTES;
+    buf[i++] = IMU_FIFO_HDR_CONFIG;
+    memset(&buf[i], 0, 4);
+    i += 4;
+    put_frame(&buf[i], 1);
+    i += IMU_FIFO_FRAME_BYTES;
+    buf[i++] = IMU_FIFO_HDR_SENSORTIME;
+    memset(&buf[i], 0x5a, 3);
+    i += 3;
+    memset(&buf[i], IMU_FIFO_HDR_EMPTY, sizeof(buf) - i);
+
+    parse_burst(buf, sizeof(buf), i, pipeline_now_us());
+    if (collect(&c, UINT32_MAX) != 2 || c.why || stats.parse_errors != 0) {
+        return "config/sensortime frames or padding not skipped";
+    }
+
+    /* A corrupt header ends the burst and is counted */
+    i = 0;
+    put_frame(&buf[i], 2);
+    i += IMU_FIFO_FRAME_BYTES;
+    buf[i++] = 0x13;
+    put_frame(&buf[i], 3);
+    parse_burst(buf, i + IMU_FIFO_FRAME_BYTES, i + IMU_FIFO_FRAME_BYTES, pipeline_now_us());
+    if (collect(&c, UINT32_MAX) != 1 || c.why || stats.parse_errors != 1) {
+        return "corrupt header not counted or frames after it parsed";
+    }
+    return NULL;
+}
+
+/* One pass of control_thread() after a wait: batches until the ring is
+ * empty. Returns the frames taken.
+ */
+static uint32_t control_pass(uint32_t *steps)
+{
+    static struct imu_sample batch[CONTROL_BATCH];
+    uint32_t got = 0;
+    size_t n;
+
+    do {
+        n = imu_acq_read(batch, CONTROL_BATCH);
+        got += n;
+        *steps += n > 0;
+    } while (n == CONTROL_BATCH);
+    return got;
+}
+
+static const char *case_burst200(void)
+{
+    struct imu_sample s;
+    uint32_t wm, pushed = 0, got = 0, steps = 0;
+
+    odr.p.hz[IMU_ODR_MID] = CONFIG_NECK_IMU_ODR_HZ;
+    odr.p.hz[IMU_ODR_HIGH] = CONFIG_NECK_IMU_ODR_HIGH_HZ;
+    if (apply_rate(IMU_ODR_HIGH) < 0) {
+        return "could not switch to the high rate";
+    }
+    wm = wm_frames;
+    while (k_sem_take(&batch_sem, K_NO_WAIT) == 0) {
+    }
+
+    const char *why = NULL;
+
+    for (int cycle = 0; cycle < 100 && !why; cycle++) {
+        /* Two late wakeups of two watermarks each before control runs */
+        for (int d = 0; d < 2; d++) {
+            push_numbered(pushed, 2 * wm);
+            pushed += 2 * wm;
+            zephyr_host_advance_us(2 * wm * period_us);
+            while (drain_fifo() > 0) {
+            }
+        }
+        if (k_sem_take(&batch_sem, K_NO_WAIT) != 0) {
+            why = "no batch signalled";
+        } else if (k_sem_take(&batch_sem, K_NO_WAIT) == 0) {
+            why = "gives did not merge";
+        } else {
+            got += control_pass(&steps);
+            if (imu_acq_get(&s)) {
+                why = "ring not empty after the control pass";
+            }
+        }
+    }
+    if (verbose) {
+        printf("  %u Hz, watermark %u: %u frames pushed, %u taken in %u steps\n",
+               stats.odr_hz, wm, pushed, got, steps);
+    }
+    apply_rate(IMU_ODR_MID);
+    if (why) {
+        return why;
+    }
+    if (wm != WM_FOR(CONFIG_NECK_IMU_ODR_HIGH_HZ) || wm != CONTROL_BATCH) {
+        return "not at the high rate's watermark";
+    }
+    if (got != pushed || stats.ring_drops || stats.fifo_overruns) {
+        return "frames lost";
+    }
+    return NULL;
+}
+
+/* The acquisition thread on the ODR timer, still wearer */
+static const char *case_thread(void)
+{
+    struct imu_acq_stats st;
+    struct collect c = { .same = true };
+    uint32_t got = 0;
+    int16_t acc[3], gyr[3];
+
+    frame_counts(0, acc, gyr);
+    imu_emul_set_sample(acc, gyr);
+    if (imu_acq_init() < 0) {
+        return "imu_acq_init failed";
+    }
+    for (int t = 0; t < 50; t++) {
+        zephyr_host_advance_ms(100);
+        while (imu_acq_wait(K_NO_WAIT) == 0) {
+        }
+        got += collect(&c, UINT32_MAX);
+    }
+    imu_acq_stats_get(&st);
+    if (verbose) {
+        printf("  wakeups %u bursts %u frames %u at %u Hz\n", st.wakeups, st.bursts,
+               st.frames, st.odr_hz);
+    }
+    if (c.why) {
+        return c.why;
+    }
+    if (st.frames == 0 || got != st.frames) {
+        return "frames parsed but not delivered";
+    }
+    if (st.fifo_overruns || st.ring_drops || st.parse_errors || st.bus_errors) {
+        return "frames lost while running";
+    }
+    return NULL;
+}
+
+static const struct {
+    const char *name;
+    const char *(*run)(void);
+} cases[] = {
+    { "watermark", case_watermark },
+    { "backlog", case_backlog },
+    { "full", case_full },
+    { "ring-full", case_ring_full },
+    { "cut", case_cut },
+    { "trailer", case_trailer },
+    { "burst200", case_burst200 },
+    { "thread", case_thread },
+};
+
+int main(int argc, char **argv)
+{
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-v")) {
+            verbose = 1;
+            zephyr_host_log = 1;
+        } else {
+            fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    /* Hand-driven cases: the FIFO is configured but nothing runs */
+    imu_fifo_init(CONFIG_NECK_IMU_ODR_HZ, WM_BYTES, fifo_irq_handler);
+    imu_emul_set_running(false);
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        reset();
+        const char *why = cases[i].run();
+
+        printf("%-10s %s%s\n", cases[i].name, why ? "FAIL: " : "ok", why ? why : "");
+        failed |= why != NULL;
+    }
+    return failed;
+}
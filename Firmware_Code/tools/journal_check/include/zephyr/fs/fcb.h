@@ -0,0 +1,45 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef JOURNAL_CHECK_FCB_H_
+#define JOURNAL_CHECK_FCB_H_
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include <zephyr/storage/flash_map.h>
+
+/* ===== Zephyr's flash circular buffer (subsys/fs/fcb) ===== */
+struct fcb_entry {
+    struct flash_sector *fe_sector;
+    uint32_t fe_elem_off;       /* 0: before the first in the sector */
+    uint32_t fe_data_off;
+    uint16_t fe_data_len;
+};
+
+#define FCB_ENTRY_FA_DATA_OFF(entry) ((entry).fe_sector->fs_off + (entry).fe_data_off)
+
+struct fcb {
+    uint32_t f_magic;
+    uint8_t f_version;
+    uint8_t f_sector_cnt;
+    uint8_t f_scratch_cnt;
+    struct flash_sector *f_sectors;
+
+    struct k_mutex f_mtx;
+    struct flash_sector *f_oldest;
+    struct fcb_entry f_active;
+    uint16_t f_active_id;
+    uint8_t f_align;
+    const struct flash_area *fap;
+    uint8_t f_erase_value;
+};
+
+/* Modelled in journal_check.c */
+int fcb_init(int f_area_id, struct fcb *fcb);
+int fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *loc);
+int fcb_append_finish(struct fcb *fcb, struct fcb_entry *append_loc);
+int fcb_getnext(struct fcb *fcb, struct fcb_entry *loc);
+int fcb_rotate(struct fcb *fcb);
+
+#endif /* JOURNAL_CHECK_FCB_H_ */
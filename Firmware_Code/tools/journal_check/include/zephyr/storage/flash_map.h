@@ -0,0 +1,37 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef JOURNAL_CHECK_FLASH_MAP_H_
+#define JOURNAL_CHECK_FLASH_MAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* ===== The journal_partition of app.overlay, on a NOR flash model ===== */
+#define FIXED_PARTITION_ID(label)   0
+
+struct flash_area {
+    uint8_t fa_id;
+    uint8_t fa_device_id;
+    uint16_t pad16;
+    off_t fa_off;
+    size_t fa_size;
+};
+
+struct flash_sector {
+    uint32_t fs_off;            /* off_t, 32 bits on the target */
+    size_t fs_size;
+};
+
+/* Modelled in journal_check.c */
+int flash_area_open(uint8_t id, const struct flash_area **fa);
+void flash_area_close(const struct flash_area *fa);
+int flash_area_read(const struct flash_area *fa, off_t off, void *dst, size_t len);
+int flash_area_write(const struct flash_area *fa, off_t off, const void *src, size_t len);
+int flash_area_erase(const struct flash_area *fa, off_t off, size_t len);
+uint32_t flash_area_align(const struct flash_area *fa);
+int flash_area_get_sectors(int fa_id, uint32_t *count, struct flash_sector *sectors);
+
+#endif /* JOURNAL_CHECK_FLASH_MAP_H_ */
@@ -0,0 +1,1045 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Host checks for the event journal (src/journal.c, shared/journal_wire.h),
+ * built against a model of flash_area and the FCB on the host kernel in
+ * tools/zephyr_host.
+ *
+ *   journal_check [--trials N] [--seed N] [-v]
+ *
+ * codec     round trip of every record type at its limits, truncated and
+ *           malformed entries
+ * powercut  journal.c's commit, rotation and recovery on a NOR flash model
+ *           (4 KiB sectors, 4-byte write blocks, erase to 0xff,
+ *           programming only clears bits), the partition as in
+ *           app.overlay. Every trial fills and rotates the buffer, cuts the
+ *           power at a random write or erase (a torn write programs part
+ *           of its bytes, a torn erase leaves any mix of old and erased
+ *           bits), boots journal.c again and then writes on. Every entry
+ *           committed and not rotated out must read back intact, nothing
+ *           else may, and seq must never go back. N trials (default 1000).
+ * density   records per 4 KiB sector and sector erases per day for a
+ *           synthetic day of posture cues, against one fixed-size struct
+ *           per record, at the entry size and commit interval built in
+ *
+ * The FCB model follows Zephyr's subsys/fs/fcb: sector header (magic,
+ * version, id; fcb_init() only looks at the magic), then elements of
+ * length (1 or 2 bytes), data and CRC-8, each padded to the write block,
+ * the CRC written last. Exit status is 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "zephyr_host.h"
+
+/* Commit, recovery and the repairs are static: check them in place */
+#include "journal.c"
+
+/* ===== app.overlay ===== */
+#define SECT_SIZE       4096
+#define SECT_CNT        6
+#define WBLK            4
+
+#define ALIGN(x)        (((x) + WBLK - 1) / WBLK * WBLK)
+#define HDR_LEN         ALIGN(8)
+
+static int verbose;
+static uint32_t rng = 1;
+
+static uint32_t rnd(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static uint8_t crc8(uint8_t crc, const uint8_t *p, size_t len)
+{
+    while (len--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint32_t fnv(const uint8_t *p, size_t len)
+{
+    uint32_t h = 2166136261u;
+
+    while (len--) {
+        h = (h ^ *p++) * 16777619u;
+    }
+    return h;
+}
+
+/* ===== What was committed ===== */
+
+#define LOG_MAX     4096
+
+struct committed {
+    uint32_t seq;
+    uint32_t hash;
+    int sector;
+    int gone;               /* rotated out */
+};
+
+static struct {
+    struct committed log[LOG_MAX];
+    size_t n_log;
+    uint32_t inflight_seq;  /* entry the cut interrupted, UINT32_MAX none */
+    uint32_t inflight_hash;
+    uint32_t true_synced;   /* newest committed JRNL_SYNCED */
+    uint32_t pending_synced;
+} ledger;
+
+static void log_rotated(int sector)
+{
+    for (size_t i = 0; i < ledger.n_log; i++) {
+        if (ledger.log[i].sector == sector) {
+            ledger.log[i].gone = 1;
+        }
+    }
+}
+
+/* An element whose CRC made it to flash */
+static void log_committed(int sector, const uint8_t *data, size_t len)
+{
+    struct jrnl_entry_hdr h;
+    struct jrnl_state st;
+
+    if (len < sizeof(h)) {
+        return;
+    }
+    memcpy(&h, data, sizeof(h));
+    if (ledger.n_log == LOG_MAX) {
+        memmove(ledger.log, ledger.log + 1, sizeof(ledger.log) - sizeof(ledger.log[0]));
+        ledger.n_log--;
+    }
+    ledger.log[ledger.n_log++] = (struct committed){ h.seq, fnv(data, len), sector, 0 };
+
+    jrnl_state_init(&st);
+    jrnl_scan_entry(&st, data, len);
+    ledger.true_synced = MAX(ledger.true_synced, st.synced);
+}
+
+/* ===== NOR flash ===== */
+
+enum cut_kind { CUT_NONE, CUT_HEADER, CUT_LEN, CUT_DATA, CUT_CRC, CUT_ERASE, CUT_KINDS };
+
+static const char *const cut_names[CUT_KINDS] = {
+    "none", "header", "length", "data", "crc", "erase",
+};
+
+static struct {
+    uint8_t mem[SECT_CNT * SECT_SIZE];
+    long ops;
+    long cut_at;            /* op that loses power, -1 never */
+    int dead;
+    enum cut_kind cut;
+    uint32_t erases;
+    uint32_t bad_crc;       /* elements fcb_getnext() skipped */
+
+    /* Element of the last fcb_append() and its data, once written; a cut
+     * leaves them as they were
+     */
+    uint16_t elem_len;
+    uint8_t data[ENTRY_BUF];
+    size_t data_len;
+} fl;
+
+static int fl_write(uint32_t off, const void *src, size_t len, enum cut_kind kind)
+{
+    uint8_t *d = fl.mem + off;
+    const uint8_t *s = src;
+    size_t n = len;
+
+    if (fl.dead) {
+        return -EIO;
+    }
+    if (fl.ops++ == fl.cut_at) {
+        /* Whole blocks up to the cut, then a partly programmed one */
+        n = rnd() % len / WBLK * WBLK;
+        for (size_t i = n; i < MIN(n + WBLK, len); i++) {
+            d[i] &= s[i] | (uint8_t)rnd();
+        }
+        fl.dead = 1;
+        fl.cut = kind;
+    }
+    for (size_t i = 0; i < n; i++) {
+        d[i] &= s[i];
+    }
+    return fl.dead ? -EIO : 0;
+}
+
+static int fl_erase(int sector)
+{
+    uint8_t *d = fl.mem + sector * SECT_SIZE;
+
+    if (fl.dead) {
+        return -EIO;
+    }
+    fl.erases++;
+    if (fl.ops++ == fl.cut_at) {
+        for (size_t i = 0; i < SECT_SIZE; i++) {
+            d[i] |= (uint8_t)rnd();
+        }
+        fl.dead = 1;
+        fl.cut = CUT_ERASE;
+        return -EIO;
+    }
+    memset(d, 0xff, SECT_SIZE);
+    return 0;
+}
+
+/* ===== flash_area ===== */
+static const struct flash_area area = {
+    .fa_id = FIXED_PARTITION_ID(journal_partition),
+    .fa_off = 0xfa000,
+    .fa_size = sizeof(fl.mem),
+};
+
+static bool in_area(off_t off, size_t len)
+{
+    return off >= 0 && (size_t)off + len <= sizeof(fl.mem);
+}
+
+int flash_area_open(uint8_t id, const struct flash_area **fa)
+{
+    if (id != area.fa_id) {
+        return -ENOENT;
+    }
+    *fa = &area;
+    return 0;
+}
+
+void flash_area_close(const struct flash_area *fa)
+{
+    ARG_UNUSED(fa);
+}
+
+int flash_area_read(const struct flash_area *fa, off_t off, void *dst, size_t len)
+{
+    ARG_UNUSED(fa);
+    if (!in_area(off, len)) {
+        return -EINVAL;
+    }
+    memcpy(dst, fl.mem + off, len);
+    return 0;
+}
+
+/* The FCB writes its headers, lengths and CRCs itself: this is data */
+int flash_area_write(const struct flash_area *fa, off_t off, const void *src, size_t len)
+{
+    ARG_UNUSED(fa);
+    if (!in_area(off, len) || off % WBLK || len % WBLK) {
+        return -EINVAL;
+    }
+    if (!fl.dead) {
+        fl.data_len = MIN(len, sizeof(fl.data));
+        memcpy(fl.data, src, fl.data_len);
+    }
+    return fl_write((uint32_t)off, src, len, CUT_DATA);
+}
+
+int flash_area_erase(const struct flash_area *fa, off_t off, size_t len)
+{
+    int rc = 0;
+
+    ARG_UNUSED(fa);
+    if (!in_area(off, len) || off % SECT_SIZE || len % SECT_SIZE) {
+        return -EINVAL;
+    }
+    for (size_t s = off / SECT_SIZE; s < (off + len) / SECT_SIZE && rc == 0; s++) {
+        rc = fl_erase((int)s);
+    }
+    return rc;
+}
+
+uint32_t flash_area_align(const struct flash_area *fa)
+{
+    ARG_UNUSED(fa);
+    return WBLK;
+}
+
+int flash_area_get_sectors(int fa_id, uint32_t *count, struct flash_sector *sectors)
+{
+    if (fa_id != area.fa_id) {
+        return -EINVAL;
+    }
+    if (*count < SECT_CNT) {
+        return -ENOMEM;
+    }
+    for (int i = 0; i < SECT_CNT; i++) {
+        sectors[i] = (struct flash_sector){ .fs_off = i * SECT_SIZE, .fs_size = SECT_SIZE };
+    }
+    *count = SECT_CNT;
+    return 0;
+}
+
+/* ===== FCB ===== */
+
+struct fcb_disk_area {
+    uint32_t fd_magic;
+    uint8_t fd_ver;
+    uint8_t _pad;
+    uint16_t fd_id;
+} __packed;
+
+static int sector_of(const struct flash_sector *s)
+{
+    return (int)(s->fs_off / SECT_SIZE);
+}
+
+static struct flash_sector *next_sector(struct fcb *f, struct flash_sector *s)
+{
+    return s + 1 < f->f_sectors + f->f_sector_cnt ? s + 1 : f->f_sectors;
+}
+
+static const uint8_t *at(const struct flash_sector *s, uint32_t off)
+{
+    return fl.mem + s->fs_off + off;
+}
+
+static int hdr_write(struct fcb *f, struct flash_sector *s, uint16_t id)
+{
+    const struct fcb_disk_area h = {
+        .fd_magic = f->f_magic,
+        .fd_ver = f->f_version,
+        ._pad = 0xff,
+        .fd_id = id,
+    };
+
+    return fl_write(s->fs_off, &h, sizeof(h), CUT_HEADER) ? -EIO : 0;
+}
+
+/* 1 ours, 0 erased, -ENOMSG neither */
+static int hdr_read(const struct fcb *f, const struct flash_sector *s, struct fcb_disk_area *h)
+{
+    memcpy(h, at(s, 0), sizeof(*h));
+    if (h->fd_magic == UINT32_MAX) {
+        return 0;
+    }
+    return h->fd_magic == f->f_magic ? 1 : -ENOMSG;
+}
+
+/* 0, -ENOTSUP at the end of the sector, -EBADMSG on a CRC mismatch */
+static int elem_info(struct fcb_entry *l)
+{
+    const uint8_t *p = at(l->fe_sector, l->fe_elem_off);
+    size_t cnt;
+
+    if (l->fe_elem_off + 2 > l->fe_sector->fs_size) {
+        return -ENOTSUP;
+    }
+    if (p[0] & 0x80) {
+        if (p[0] == 0xff && p[1] == 0xff) {
+            return -ENOTSUP;
+        }
+        l->fe_data_len = (uint16_t)((p[0] & 0x7f) | (p[1] << 7));
+        cnt = 2;
+    } else {
+        l->fe_data_len = p[0];
+        cnt = 1;
+    }
+    l->fe_data_off = l->fe_elem_off + ALIGN(cnt);
+    if (l->fe_data_off + ALIGN(l->fe_data_len) + ALIGN(1) > l->fe_sector->fs_size) {
+        return -ENOTSUP;
+    }
+
+    uint8_t crc = crc8(crc8(0xff, p, cnt), at(l->fe_sector, l->fe_data_off), l->fe_data_len);
+
+    return crc == *at(l->fe_sector, l->fe_data_off + ALIGN(l->fe_data_len)) ? 0 : -EBADMSG;
+}
+
+static int getnext_in_sector(struct fcb_entry *l)
+{
+    int rc;
+
+    do {
+        l->fe_elem_off = l->fe_elem_off ?
+                         l->fe_data_off + ALIGN(l->fe_data_len) + ALIGN(1) : HDR_LEN;
+        rc = elem_info(l);
+        fl.bad_crc += rc == -EBADMSG;
+    } while (rc == -EBADMSG);
+    return rc;
+}
+
+int fcb_getnext(struct fcb *f, struct fcb_entry *l)
+{
+    if (!l->fe_sector) {
+        l->fe_sector = f->f_oldest;
+        l->fe_elem_off = 0;
+    }
+    while (getnext_in_sector(l) != 0) {
+        if (l->fe_sector == f->f_active.fe_sector) {
+            return -ENOTSUP;
+        }
+        l->fe_sector = next_sector(f, l->fe_sector);
+        l->fe_elem_off = 0;
+    }
+    return 0;
+}
+
+int fcb_init(int f_area_id, struct fcb *f)
+{
+    struct flash_sector *oldest = NULL, *newest = NULL;
+    uint16_t oldest_id = 0, newest_id = 0;
+    struct fcb_disk_area h;
+
+    if (!f->f_sectors || f->f_sector_cnt - f->f_scratch_cnt < 1 ||
+        flash_area_open((uint8_t)f_area_id, &f->fap)) {
+        return -EINVAL;
+    }
+    f->f_erase_value = 0xff;
+    f->f_align = (uint8_t)flash_area_align(f->fap);
+
+    for (int i = 0; i < f->f_sector_cnt; i++) {
+        struct flash_sector *s = &f->f_sectors[i];
+        int rc = hdr_read(f, s, &h);
+
+        if (rc < 0) {
+            return rc;
+        }
+        if (rc == 0) {
+            continue;
+        }
+        if (!newest) {
+            oldest = newest = s;
+            oldest_id = newest_id = h.fd_id;
+            continue;
+        }
+        if ((int16_t)(h.fd_id - newest_id) > 0) {
+            newest = s;
+            newest_id = h.fd_id;
+        } else if ((int16_t)(oldest_id - h.fd_id) > 0) {
+            oldest = s;
+            oldest_id = h.fd_id;
+        }
+    }
+    if (!newest) {
+        oldest = newest = &f->f_sectors[0];
+        if (hdr_write(f, newest, 0)) {
+            return -EIO;
+        }
+    }
+    f->f_oldest = oldest;
+    f->f_active = (struct fcb_entry){ .fe_sector = newest };
+    f->f_active_id = newest_id;
+    while (getnext_in_sector(&f->f_active) == 0) {
+    }
+    k_mutex_init(&f->f_mtx);
+    return 0;
+}
+
+int fcb_append(struct fcb *f, uint16_t len, struct fcb_entry *loc)
+{
+    struct fcb_entry *a = &f->f_active;
+    size_t cnt = len < 0x80 ? 1 : 2;
+    size_t need = ALIGN(cnt) + ALIGN(len) + ALIGN(1);
+    uint8_t lb[WBLK];
+
+    if (!fl.dead) {
+        fl.elem_len = len;
+        fl.data_len = 0;
+    }
+    if (a->fe_elem_off + need > a->fe_sector->fs_size) {
+        struct flash_sector *next = next_sector(f, a->fe_sector);
+
+        if (next == f->f_oldest) {
+            return -ENOSPC;
+        }
+        if (hdr_write(f, next, f->f_active_id + 1)) {
+            return -EIO;
+        }
+        a->fe_sector = next;
+        a->fe_elem_off = HDR_LEN;
+        f->f_active_id++;
+    }
+    memset(lb, 0xff, sizeof(lb));
+    if (cnt == 1) {
+        lb[0] = (uint8_t)len;
+    } else {
+        lb[0] = (uint8_t)((len & 0x7f) | 0x80);
+        lb[1] = (uint8_t)(len >> 7);
+    }
+    if (fl_write(a->fe_sector->fs_off + a->fe_elem_off, lb, ALIGN(cnt), CUT_LEN)) {
+        return -EIO;
+    }
+    *loc = (struct fcb_entry){
+        .fe_sector = a->fe_sector,
+        .fe_elem_off = a->fe_elem_off,
+        .fe_data_off = a->fe_elem_off + ALIGN(cnt),
+        .fe_data_len = len,
+    };
+    a->fe_elem_off += need;
+    return 0;
+}
+
+int fcb_append_finish(struct fcb *f, struct fcb_entry *loc)
+{
+    const uint8_t *p = at(loc->fe_sector, loc->fe_elem_off);
+    const uint8_t *data = at(loc->fe_sector, loc->fe_data_off);
+    uint8_t cb[WBLK];
+
+    ARG_UNUSED(f);
+    memset(cb, 0xff, sizeof(cb));
+    cb[0] = crc8(crc8(0xff, p, loc->fe_data_len < 0x80 ? 1 : 2), data, loc->fe_data_len);
+    if (fl_write(loc->fe_sector->fs_off + loc->fe_data_off + ALIGN(loc->fe_data_len), cb,
+                 ALIGN(1), CUT_CRC)) {
+        return -EIO;
+    }
+    log_committed(sector_of(loc->fe_sector), data, loc->fe_data_len);
+    return 0;
+}
+
+int fcb_rotate(struct fcb *f)
+{
+    /* Forfeit from the moment the erase starts */
+    log_rotated(sector_of(f->f_oldest));
+    if (flash_area_erase(f->fap, f->f_oldest->fs_off, f->f_oldest->fs_size)) {
+        return -EIO;
+    }
+    if (f->f_oldest == f->f_active.fe_sector) {
+        struct flash_sector *next = next_sector(f, f->f_active.fe_sector);
+
+        if (hdr_write(f, next, f->f_active_id + 1)) {
+            return -EIO;
+        }
+        f->f_active.fe_sector = next;
+        f->f_active.fe_elem_off = HDR_LEN;
+        f->f_active_id++;
+    }
+    f->f_oldest = next_sector(f, f->f_oldest);
+    return 0;
+}
+
+/* ===== Journal ===== */
+
+/* A power-on: RAM gone, nothing queued, journal_open() from flash */
+static int boot(uint32_t *repairs, uint32_t *wipes, uint32_t *skips)
+{
+    uint32_t erases0 = fl.erases;
+
+    k_msgq_purge(&journal_q);
+    memset(&fcb, 0, sizeof(fcb));
+    memset(&stats, 0, sizeof(stats));
+    jrnl_state_init(&state);
+    entry_len = 0;
+    journal_open();
+    if (!ready) {
+        return -EIO;
+    }
+
+    uint32_t erased = fl.erases - erases0;
+
+    if (erased >= SECT_CNT) {
+        (*wipes)++;
+        erased -= SECT_CNT;
+    }
+    *repairs += erased;
+    *skips += fcb.f_active.fe_elem_off >= fcb.f_active.fe_sector->fs_size;
+    return 0;
+}
+
+/* What journal_thread() does with the queue: its wait for the next message
+ * times out at the commit deadline
+ */
+static void run_queue(void)
+{
+    struct journal_msg m;
+
+    while (k_msgq_get(&journal_q, &m, K_NO_WAIT) == 0) {
+        if (entry_len && k_uptime_get() >= entry_deadline) {
+            commit();
+        }
+        handle(&m);
+    }
+}
+
+/* One random record; every so often the gateway acknowledges */
+static void random_step(void)
+{
+    struct jrnl_rec r = { 0 };
+
+    zephyr_host_advance_ms(rnd() % 20000);
+    switch (rnd() % 8) {
+    case 0:
+    case 1:
+        r.type = JRNL_POSTURE;
+        r.a = 1 + rnd() % 3;
+        r.b = (int32_t)(rnd() % 6000) - 3000;
+        break;
+    case 2:
+        r.type = JRNL_DWELL;
+        r.a = rnd() % 600000;
+        break;
+    case 3:
+    case 4:
+        r.type = JRNL_ACTUATOR;
+        r.a = rnd() % 3;
+        r.b = (int32_t)(rnd() % 1001);
+        break;
+    case 5:
+        r.type = JRNL_THERMAL;
+        r.a = rnd() & 7;
+        r.b = (int32_t)(rnd() % 5000);
+        break;
+    case 6:
+        r.type = JRNL_CLOCK;
+        r.a = 1760000000000ll + rnd();
+        break;
+    default:
+        /* Everything up to the entry being filled */
+        if (state.next_seq > state.synced) {
+            ledger.pending_synced = state.next_seq;
+            journal_ack(state.next_seq);
+            run_queue();
+        }
+        return;
+    }
+    journal_add(r.type, r.a, r.b);
+    run_queue();
+}
+
+/* ===== Codec ===== */
+
+#define CHECK(cond)                                 \
+    do {                                            \
+        if (!(cond) && !why) {                      \
+            why = #cond;                            \
+        }                                           \
+    } while (0)
+
+static int check_codec(void)
+{
+    static const struct jrnl_rec recs[] = {
+        { JRNL_POSTURE, 0, 1, -3000 },
+        { JRNL_POSTURE, 1, 3, INT32_MIN },
+        { JRNL_DWELL, 250, 0, 0 },
+        { JRNL_DWELL, 4000000, UINT32_MAX, 0 },
+        { JRNL_ACTUATOR, 4000000, JRNL_ACT_PELTIER, 800 },
+        { JRNL_ACTUATOR, UINT32_MAX, JRNL_ACT_LRA, UINT16_MAX },
+        { JRNL_THERMAL, UINT32_MAX, JRNL_TF_OVER_TEMP | JRNL_TF_FOLDBACK, 4650 },
+        { JRNL_THERMAL, UINT32_MAX, JRNL_TF_NO_SENSOR, INT16_MIN },
+        { JRNL_TRIP, UINT32_MAX, 6, 12500 },
+        { JRNL_TRIP, UINT32_MAX, 0, -4000 },
+        { JRNL_CLOCK, UINT32_MAX, INT64_MAX, 0 },
+        { JRNL_SYNCED, UINT32_MAX, UINT32_MAX, 0 },
+    };
+    uint8_t e[sizeof(struct jrnl_entry_hdr) + ARRAY_SIZE(recs) * JRNL_REC_MAX];
+    struct jrnl_entry_hdr h = { .version = JRNL_VERSION, .boot = 3, .seq = 77, .t0_ms = 0 };
+    struct jrnl_state st;
+    struct jrnl_rec r;
+    const char *why = NULL;
+    size_t len = sizeof(h), pos;
+    uint32_t prev = 0, t;
+
+    memcpy(e, &h, sizeof(h));
+    for (size_t i = 0; i < ARRAY_SIZE(recs); i++) {
+        size_t n = jrnl_rec_encode(e + len, &recs[i], prev);
+
+        CHECK(n <= JRNL_REC_MAX);
+        len += n;
+        prev = recs[i].t_ms;
+    }
+
+    pos = sizeof(h);
+    t = h.t0_ms;
+    for (size_t i = 0; i < ARRAY_SIZE(recs); i++) {
+        CHECK(jrnl_rec_decode(e, len, &pos, &t, &r) == 1);
+        CHECK(r.type == recs[i].type && r.t_ms == recs[i].t_ms);
+        CHECK(r.a == recs[i].a && r.b == recs[i].b);
+    }
+    CHECK(jrnl_rec_decode(e, len, &pos, &t, &r) == 0);
+
+    /* Recovery state */
+    jrnl_state_init(&st);
+    CHECK(jrnl_scan_entry(&st, e, len) == 0);
+    CHECK(st.next_seq == 78 && st.boot == 3 && st.synced == UINT32_MAX && st.bad == 0);
+
+    /* Every truncation fails cleanly, past the last whole record */
+    for (size_t cut = sizeof(h); cut < len; cut++) {
+        int rc;
+
+        pos = sizeof(h);
+        t = 0;
+        while ((rc = jrnl_rec_decode(e, cut, &pos, &t, &r)) > 0) {
+        }
+        CHECK(rc == -EBADMSG || pos == cut);
+        CHECK(pos <= cut);
+    }
+
+    /* Unknown type, foreign version, varint over 64 bits */
+    e[sizeof(h)] = 0x7f;
+    jrnl_state_init(&st);
+    CHECK(jrnl_scan_entry(&st, e, len) == -EBADMSG && st.bad == 1);
+    e[0] = JRNL_VERSION + 1;
+    CHECK(jrnl_scan_entry(&st, e, len) == -EBADMSG && st.bad == 2 && st.entries == 1);
+
+    uint8_t v[11];
+    uint64_t x;
+
+    memset(v, 0xff, sizeof(v));
+    pos = 0;
+    CHECK(jrnl_get_varint(v, sizeof(v), &pos, &x) == -EBADMSG);
+    CHECK(jrnl_unzigzag(jrnl_zigzag(INT32_MIN)) == INT32_MIN);
+    CHECK(jrnl_unzigzag(jrnl_zigzag(-1)) == -1 && jrnl_zigzag(-1) == 1);
+
+    printf("%-10s %s%s\n", "codec", why ? "FAIL: " : "ok", why ? why : "");
+    return why != NULL;
+}
+
+/* ===== Power cuts ===== */
+
+struct pc_stats {
+    uint32_t cuts[CUT_KINDS];
+    uint32_t committed;     /* entries expected back, over all trials */
+    uint32_t inflight_kept; /* the cut entry came back whole anyway */
+    uint32_t bad_crc;       /* torn elements skipped by the CRC */
+    uint32_t synced_behind; /* mark rotated out with its sector */
+    uint32_t repairs;       /* damaged sectors erased alone */
+    uint32_t skips;         /* torn length, appends moved to the next sector */
+    uint32_t rejected;      /* elements past the CRC that do not decode */
+    uint32_t torn_accepted; /* the cut entry, torn, read back as valid */
+    uint32_t wipes;
+    uint32_t rotations;
+};
+
+/* The element a cut interrupted, if its data went out */
+static void note_inflight(void)
+{
+    struct jrnl_entry_hdr h;
+
+    ledger.inflight_seq = UINT32_MAX;
+    if (fl.cut != CUT_NONE && fl.data_len >= sizeof(h)) {
+        memcpy(&h, fl.data, sizeof(h));
+        ledger.inflight_seq = h.seq;
+        ledger.inflight_hash = fnv(fl.data, MIN(fl.elem_len, fl.data_len));
+    }
+}
+
+/* Reads everything back and compares with what was committed */
+static const char *verify(struct pc_stats *ps, int after_cut)
+{
+    static uint8_t seen[LOG_MAX];
+    struct fcb_entry loc = { 0 };
+    uint32_t max_seq = 0, kept_hash = 0;
+    int any = 0, kept = -1;
+
+    memset(seen, 0, ledger.n_log);
+    while (fcb_getnext(&fcb, &loc) == 0) {
+        const uint8_t *p = fl.mem + FCB_ENTRY_FA_DATA_OFF(loc);
+        uint32_t hash = fnv(p, loc.fe_data_len);
+        struct jrnl_entry_hdr h;
+        struct jrnl_state tmp;
+        size_t i;
+
+        /* What journal.c recovers from and sends, like the gateway, only
+         * takes entries that decode
+         */
+        jrnl_state_init(&tmp);
+        if (jrnl_scan_entry(&tmp, p, loc.fe_data_len) < 0) {
+            ps->rejected += after_cut;
+            continue;
+        }
+        memcpy(&h, p, sizeof(h));
+        for (i = 0; i < ledger.n_log; i++) {
+            if (ledger.log[i].seq == h.seq && ledger.log[i].hash == hash && !ledger.log[i].gone) {
+                break;
+            }
+        }
+        if (i < ledger.n_log) {
+            if (seen[i]++) {
+                return "entry read twice";
+            }
+        } else if (after_cut && h.seq == ledger.inflight_seq) {
+            /* The cut entry whole, or torn and past CRC-8 and the decoder */
+            if (hash == ledger.inflight_hash) {
+                ps->inflight_kept++;
+            } else {
+                ps->torn_accepted++;
+            }
+            kept = sector_of(loc.fe_sector);
+            kept_hash = hash;
+        } else {
+            return "entry that was never committed read back";
+        }
+        max_seq = any ? MAX(max_seq, h.seq) : h.seq;
+        any = 1;
+    }
+    for (size_t i = 0; i < ledger.n_log; i++) {
+        if (!ledger.log[i].gone && !seen[i]) {
+            return "committed entry lost";
+        }
+    }
+    if (kept >= 0 && ledger.n_log < LOG_MAX) {
+        ledger.log[ledger.n_log++] = (struct committed){ ledger.inflight_seq, kept_hash, kept, 0 };
+    }
+    if (any && state.next_seq <= max_seq) {
+        return "seq goes back after the restart";
+    }
+    if (state.synced > ledger.true_synced &&
+        !(after_cut && state.synced == ledger.pending_synced)) {
+        return "sync mark ahead of what was committed";
+    }
+    if (state.synced < ledger.true_synced) {
+        ps->synced_behind++;
+    }
+    return NULL;
+}
+
+static const char *trial(struct pc_stats *ps)
+{
+    const char *why;
+    uint32_t erases0 = fl.erases;
+
+    memset(fl.mem, 0xff, sizeof(fl.mem));
+    fl.ops = 0;
+    fl.cut_at = -1;
+    fl.dead = 0;
+    fl.cut = CUT_NONE;
+    memset(&ledger, 0, sizeof(ledger));
+
+    if (boot(&ps->repairs, &ps->wipes, &ps->skips)) {
+        return "fresh partition does not open";
+    }
+
+    /* Up to twice round the buffer, so the cut may land on a rotation */
+    for (uint32_t n = rnd() % 3000; n; n--) {
+        random_step();
+    }
+    if (stats.write_errors) {
+        return "write failed without a power cut";
+    }
+    fl.cut_at = fl.ops + rnd() % 400;
+    for (int guard = 0; !fl.dead && guard < 100000; guard++) {
+        random_step();
+    }
+    ps->cuts[fl.cut]++;
+    note_inflight();
+
+    /* Restart */
+    fl.dead = 0;
+    fl.cut_at = -1;
+    if (boot(&ps->repairs, &ps->wipes, &ps->skips)) {
+        return "journal does not open after the cut";
+    }
+    fl.bad_crc = 0;
+    why = verify(ps, 1);
+    ps->bad_crc += fl.bad_crc;
+    if (why) {
+        return why;
+    }
+
+    /* Writing on from where recovery left must keep all of it */
+    for (size_t i = 0; i < ledger.n_log; i++) {
+        ps->committed += !ledger.log[i].gone;
+    }
+    ledger.inflight_seq = UINT32_MAX;
+    ledger.true_synced = ledger.pending_synced = state.synced;
+    for (uint32_t n = 200 + rnd() % 800; n; n--) {
+        random_step();
+    }
+    commit();
+    if (stats.write_errors) {
+        return "write failed after recovery";
+    }
+    ps->rotations += fl.erases - erases0;
+
+    struct jrnl_state before = state;
+
+    if (boot(&ps->repairs, &ps->wipes, &ps->skips)) {
+        return "journal does not open the second time";
+    }
+    if (state.boot != before.boot + 1) {
+        return "boot count did not advance";
+    }
+    return verify(ps, 0);
+}
+
+static int powercut(uint32_t trials)
+{
+    struct pc_stats ps = { 0 };
+    const char *why = NULL;
+    uint32_t i;
+
+    for (i = 0; i < trials && !why; i++) {
+        why = trial(&ps);
+    }
+    if (why && verbose) {
+        printf("           trial %u, cut in %s\n", i - 1, cut_names[fl.cut]);
+    }
+
+    printf("%-10s %u trials, %u committed entries checked, %u erases %s%s\n", "powercut",
+           i, ps.committed, ps.rotations, why ? "FAIL: " : "ok", why ? why : "");
+    printf("           cut in:");
+    for (int k = 0; k < CUT_KINDS; k++) {
+        printf(" %s %u", cut_names[k], ps.cuts[k]);
+    }
+    printf("\n           torn elements: %u failed the CRC, %u the decoder, %u passed both;"
+           " torn lengths stepped over %u\n"
+           "           cut entry kept whole %u, damaged sectors erased %u, full wipes %u,"
+           " sync mark rotated out %u\n",
+           ps.bad_crc, ps.rejected, ps.torn_accepted, ps.skips, ps.inflight_kept, ps.repairs,
+           ps.wipes, ps.synced_behind);
+    if (!why && ps.wipes) {
+        why = "journal wiped";
+        printf("           FAIL: %s\n", why);
+    }
+    return why != NULL;
+}
+
+/* ===== Density ===== */
+
+/* What one record per element would take, without the entry framing */
+struct fixed_rec {
+    uint32_t t_ms;
+    uint8_t type;
+    int64_t a;
+    int32_t b;
+} __attribute__((packed));
+
+#define DAY_MS          (16u * 3600 * 1000)   /* worn 16 h */
+
+/* A worn day: a slouch episode every 8 min on average, a cue with LEDs,
+ * LRA and Peltier, half of them outlasting the alert time
+ */
+static uint32_t day(int (*rec)(const struct jrnl_rec *r))
+{
+    uint32_t t = 0, n = 0;
+
+#define REC(ty, aa, bb)                                                 \
+    do {                                                                \
+        const struct jrnl_rec r_ = { (ty), t, (aa), (bb) };             \
+        rec(&r_);                                                       \
+        n++;                                                            \
+    } while (0)
+
+    while (1) {
+        t += 60000 + rnd() % 840000;
+        if (t > DAY_MS) {
+            break;
+        }
+        uint32_t t0 = t;
+
+        REC(JRNL_POSTURE, 1, 1500 + (int32_t)(rnd() % 1500));
+        REC(JRNL_ACTUATOR, JRNL_ACT_LED, 1);
+        REC(JRNL_ACTUATOR, JRNL_ACT_LRA, 2);
+        t += 100 + rnd() % 200;
+        REC(JRNL_ACTUATOR, JRNL_ACT_PELTIER, 300 + (int32_t)(rnd() % 500));
+        if (rnd() % 2) {
+            t += 30000;
+            REC(JRNL_POSTURE, 2, 2000 + (int32_t)(rnd() % 1500));
+            REC(JRNL_ACTUATOR, JRNL_ACT_LRA, 4);
+        }
+        if (rnd() % 10 == 0) {
+            t += 5000;
+            REC(JRNL_THERMAL, JRNL_TF_FOLDBACK, 3700 + (int32_t)(rnd() % 300));
+            t += 2000;
+            REC(JRNL_THERMAL, 0, 3750);
+        }
+        t += 2000 + rnd() % 60000;
+        REC(JRNL_POSTURE, 3, 500 + (int32_t)(rnd() % 300));
+        REC(JRNL_DWELL, t - t0, 0);
+        REC(JRNL_ACTUATOR, JRNL_ACT_LED, 0);
+        REC(JRNL_ACTUATOR, JRNL_ACT_LRA, 3);
+        REC(JRNL_ACTUATOR, JRNL_ACT_PELTIER, 0);
+        t += 400;
+        REC(JRNL_ACTUATOR, JRNL_ACT_LRA, 0);
+    }
+#undef REC
+    return n;
+}
+
+static int64_t day_start;
+
+static int density_rec(const struct jrnl_rec *r)
+{
+    zephyr_host_advance_ms(day_start + r->t_ms - k_uptime_get());
+    journal_add(r->type, r->a, r->b);
+    run_queue();
+    return 0;
+}
+
+static uint32_t fixed_bytes;
+
+static int fixed_rec(const struct jrnl_rec *r)
+{
+    (void)r;
+    fixed_bytes += ALIGN(1) + ALIGN(sizeof(struct fixed_rec)) + ALIGN(1);
+    return 0;
+}
+
+static void density(void)
+{
+    const double usable = SECT_SIZE - HDR_LEN;
+    uint32_t seed = rng;
+    uint32_t repairs = 0, wipes = 0, skips = 0;
+    uint32_t used0;
+    char name[32];
+
+    fixed_bytes = 0;
+    uint32_t n = day(fixed_rec);
+
+    printf("%-10s %u records a day; endurance 10k erases per sector, %d sectors\n",
+           "density", n, SECT_CNT);
+    printf("           %-22s %8s %8s %10s %10s\n", "layout", "B/rec", "rec/4K", "erases/d",
+           "years");
+    printf("           %-22s %8.1f %8.0f %10.2f %10.0f\n", "fixed struct per elem",
+           (double)fixed_bytes / n, usable * n / fixed_bytes, fixed_bytes / usable,
+           10000.0 * SECT_CNT / (fixed_bytes / usable) / 365);
+
+    rng = seed;
+    memset(fl.mem, 0xff, sizeof(fl.mem));
+    fl.cut_at = -1;
+    fl.dead = 0;
+    fl.erases = 0;
+    boot(&repairs, &wipes, &skips);
+    used0 = fcb.f_active.fe_elem_off;
+    day_start = k_uptime_get();
+
+    uint32_t recs = day(density_rec);
+
+    commit();
+
+    /* Bytes of flash written: full sectors plus the active one */
+    int active = sector_of(fcb.f_active.fe_sector);
+    double bytes = (double)fl.erases * usable +
+                   (active + SECT_CNT - sector_of(fcb.f_oldest)) % SECT_CNT * usable +
+                   (fcb.f_active.fe_elem_off - used0);
+
+    snprintf(name, sizeof(name), "entry %d B, %d s", ENTRY_MAX, CONFIG_NECK_JOURNAL_COMMIT_S);
+    printf("           %-22s %8.1f %8.0f %10.2f %10.0f   (%u entries)\n", name,
+           bytes / recs, usable * recs / bytes, bytes / usable,
+           10000.0 * SECT_CNT / (bytes / usable) / 365, stats.entries);
+    rng = seed;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = 1000;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--trials") && i + 1 < argc) {
+            trials = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            rng = (uint32_t)strtoul(argv[++i], NULL, 0) | 1;
+        } else if (!strcmp(argv[i], "-v")) {
+            verbose = 1;
+        } else {
+            fprintf(stderr, "usage: %s [--trials N] [--seed N] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    failed |= check_codec();
+    failed |= powercut(trials);
+    density();
+    return failed;
+}
@@ -0,0 +1,538 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Compare the adaptive IMU rate (src/imu_odr.c) against fixed rates on the
+ * same synthetic wearer, through the firmware's decision code
+ * (src/ctrl_logic.c: fusion on sample timestamps, then posture).
+ *
+ *   odr_check [--seed N] [--minutes N] [--clock-ppm N] [-v]
+ *
+ * The wearer holds postures with a little sway, glances down and back,
+ * nods, turns the head (60-180 dps about the vertical) and slouches, with
+ * minimum-jerk movements. A model of the BMI270 FIFO samples that motion
+ * at the active rate on a sensor clock --clock-ppm off nominal (default
+ * 3000), raises the watermark interrupt and is drained after 0.2-3 ms of
+ * wakeup latency, as imu_acq.c does: frames stamped by the sample clock
+ * (imu_clock_newest()), one burst per wakeup, and in the adaptive run a
+ * rate decision per burst. A rate change drains the FIFO, rewrites the
+ * sensor configuration (bus time below) and flushes; the first frame at
+ * the new rate comes one new period later.
+ *
+ * For each configuration: fused pitch error against the true pitch at the
+ * newest frame of every burst (all, while the head moves, while it is
+ * held; the first 10 s of convergence excluded), frames fused, bursts,
+ * I2C bytes, stamp error and posture events. The adaptive run must track
+ * pitch as well as fixed 100 Hz, see the same posture events and keep its
+ * stamps within a quarter of the lowest period; at the desk it must fuse
+ * and move fewer than 60 % of the frames and bytes. The sample clock
+ * settles about eight bursts of drift off, so a sensor clock much beyond
+ * +-5000 ppm fails the stamp check. Exit status is 1 if a check fails.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ctrl_logic.h"
+#include "imu_odr.h"
+
+/* ===== Kconfig defaults ===== */
+#define FUSION_BETA         0.1f
+#define ODR_HZ              100
+#define WM_FRAMES           10
+
+static const struct imu_odr_params odr_defaults = {
+    .hz = { 25, ODR_HZ, 200 },
+    .up_dps = { 0, 8, 40 },
+    .hold_ms = 1500,
+};
+
+static const struct posture_params posture_defaults = {
+    .enter_deg = 15.0f,
+    .exit_deg = 8.0f,
+    .enter_dwell_ms = 3000,
+    .exit_dwell_ms = 1500,
+    .alert_ms = 30000,
+    .baseline_tau_s = 300.0f,
+    .warmup_ms = 5000,
+    .baseline_limit_deg = 30.0f,
+};
+
+static const struct calib_params calib_defaults = {
+    .window_ms = 1000,
+    .gyr_still_dps = 0.3f,
+    .acc_still_mg = 8.0f,
+    .bias_max_dps = 3.0f,
+    .bias_windows = 32,
+};
+
+/* ===== Bus model =====
+ * Bytes on the wire including address and register bytes: a level read
+ * is 5, a burst read 3 plus the data, a rate change is six read-modify-write
+ * sensor_attr_set() calls (7 each) plus the interrupt mask, watermark,
+ * flush and unmask writes. 400 kHz, 9 bits per byte.
+ */
+#define I2C_LEVEL_BYTES     5
+#define I2C_BURST_BYTES     3
+#define I2C_SWITCH_BYTES    (6 * 7 + 3 + 4 + 3 + 3)
+#define I2C_US_PER_BYTE     22.5
+#define SENSORTIME_BYTES    4
+
+#define WARMUP_US           10000000u
+#define MOVING_DPS          10.0
+#define BATCH_MAX           64
+#define RAD_TO_DEG          57.29577951
+#define EV_COUNT            (POSTURE_EV_RECOVERED + 1)
+
+/* ===== Scene ===== */
+static uint64_t rng;
+
+static double urand(void)
+{
+    rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (rng >> 40) / 16777216.0;
+}
+
+static double uniform(double lo, double hi)
+{
+    return lo + (hi - lo) * urand();
+}
+
+static double noise(double amp)
+{
+    return (urand() * 2.0 - 1.0) * amp;
+}
+
+/* Pitch moves from a to b over [t0, t0 + d] along a minimum-jerk profile */
+struct move {
+    double t0, d, a, b;
+};
+
+/* Head turn about the vertical: raised-cosine rate over [t0, t0 + d] */
+struct turn {
+    double t0, d, peak_dps;
+};
+
+#define MOVES_MAX   4096
+#define TURNS_MAX   4096
+
+static struct move moves[MOVES_MAX];
+static struct turn turns[TURNS_MAX];
+static size_t n_moves, n_turns;
+static double upright_deg;
+
+/* Nominal head position the scene returns to */
+static void add_move(double *t, double d, double to, double *at)
+{
+    if (n_moves < MOVES_MAX) {
+        moves[n_moves++] = (struct move){ *t, d, *at, to };
+    }
+    *t += d;
+    *at = to;
+}
+
+/* Hold for len_s, maybe looking to one side and back meanwhile */
+static void add_hold(double *t, double len_s)
+{
+    double end = *t + len_s;
+
+    if (len_s > 4.0 && urand() < 0.5 && n_turns + 2 <= TURNS_MAX) {
+        double peak = uniform(60, 180) * (urand() < 0.5 ? -1 : 1);
+        double d = uniform(0.5, 1.0);
+        double t0 = *t + uniform(0.5, len_s - 3.5);
+
+        turns[n_turns++] = (struct turn){ t0, d, peak };
+        turns[n_turns++] = (struct turn){ t0 + d + uniform(0.5, 1.5), d, -peak };
+    }
+    *t = end;
+}
+
+static void make_scene(double len_s, double hold_max_s)
+{
+    double t = 0.0;
+    double at;
+
+    n_moves = n_turns = 0;
+    upright_deg = uniform(-5, 10);
+    at = upright_deg;
+
+    while (t < len_s) {
+        double r = urand();
+
+        add_hold(&t, uniform(4, hold_max_s));
+        if (r < 0.45) {
+            /* Glance down at something and back */
+            add_move(&t, uniform(0.25, 0.6), upright_deg + uniform(10, 30), &at);
+            add_hold(&t, uniform(0.5, 2.0));
+            add_move(&t, uniform(0.3, 0.7), upright_deg, &at);
+        } else if (r < 0.65) {
+            /* Nod twice */
+            for (int k = 0; k < 2; k++) {
+                add_move(&t, 0.2, upright_deg + 15, &at);
+                add_move(&t, 0.2, upright_deg, &at);
+            }
+        } else if (r < 0.8) {
+            /* Slouch for a while */
+            add_move(&t, uniform(2, 4), upright_deg + uniform(20, 35), &at);
+            add_hold(&t, uniform(10, 60));
+            add_move(&t, uniform(1, 2), upright_deg, &at);
+        }
+    }
+}
+
+struct truth {
+    double pitch_deg;
+    double pitch_dps;
+    double yaw_dps;
+};
+
+static void truth_at(double t, struct truth *out)
+{
+    double sway = 2.0 * M_PI * 0.25;
+    size_t lo = 0, hi = n_moves;
+
+    /* Last move started at or before t */
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+
+        if (moves[mid].t0 <= t) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    out->pitch_deg = upright_deg;
+    out->pitch_dps = 0.0;
+    if (n_moves && moves[lo].t0 <= t) {
+        const struct move *m = &moves[lo];
+        double u = (t - m->t0) / m->d;
+
+        if (u >= 1.0) {
+            out->pitch_deg = m->b;
+        } else {
+            double s = u * u * u * (10.0 - 15.0 * u + 6.0 * u * u);
+            double ds = 30.0 * u * u * (1.0 - 2.0 * u + u * u);
+
+            out->pitch_deg = m->a + (m->b - m->a) * s;
+            out->pitch_dps = (m->b - m->a) * ds / m->d;
+        }
+    }
+    out->pitch_deg += 0.4 * sin(sway * t);
+    out->pitch_dps += 0.4 * sway * cos(sway * t);
+
+    out->yaw_dps = 0.0;
+    for (size_t i = 0; i < n_turns; i++) {
+        const struct turn *tn = &turns[i];
+
+        if (t >= tn->t0 && t < tn->t0 + tn->d) {
+            out->yaw_dps = tn->peak_dps * 0.5 * (1.0 - cos(2.0 * M_PI * (t - tn->t0) / tn->d));
+            break;
+        }
+    }
+}
+
+/* Frame at t for a sensor running at period_s. Pure rotation about the
+ * sensor: gravity along (cos p, 0, sin p), the turn rate about gravity,
+ * the pitch rate about +Y (src/fusion.c). The gyro reports the mean rate
+ * over the period, as the BMI270's decimation filter does.
+ */
+static void sample_at(double t, double period_s, struct imu_sample *s)
+{
+    struct truth tr, prev;
+    double yaw = 0.0;
+
+    truth_at(t - period_s, &prev);
+    for (int k = 0; k < 8; k++) {
+        struct truth sub;
+
+        truth_at(t - period_s * (k + 0.5) / 8, &sub);
+        yaw += sub.yaw_dps / 8;
+    }
+    truth_at(t, &tr);
+
+    double th = tr.pitch_deg / RAD_TO_DEG;
+    double pitch_dps = (tr.pitch_deg - prev.pitch_deg) / period_s;
+
+    s->acc[0] = (int16_t)(IMU_ACC_LSB_PER_G * cos(th) + noise(40));
+    s->acc[1] = (int16_t)noise(40);
+    s->acc[2] = (int16_t)(IMU_ACC_LSB_PER_G * sin(th) + noise(40));
+    s->gyr[0] = (int16_t)(yaw * cos(th) * IMU_GYR_LSB_PER_DPS + noise(8));
+    s->gyr[1] = (int16_t)(pitch_dps * IMU_GYR_LSB_PER_DPS + noise(8));
+    s->gyr[2] = (int16_t)(yaw * sin(th) * IMU_GYR_LSB_PER_DPS + noise(8));
+}
+
+/* ===== Acquisition model ===== */
+struct run {
+    const char *name;
+    int adaptive;
+    uint16_t fixed_hz;
+
+    /* Results */
+    uint64_t frames, bursts, i2c_bytes;
+    uint32_t changes;
+    double err_sq[3], err_max[3];       /* all, moving, held */
+    uint64_t err_n[3];
+    double stamp_err_max_us;
+    uint32_t events[EV_COUNT];
+    double cpu_ns;
+    struct imu_odr_stats odr;
+};
+
+static int verbose;
+static double clock_ppm = 3000.0;
+
+static uint32_t wm_for(uint16_t hz)
+{
+    uint32_t wm = (WM_FRAMES * hz + ODR_HZ / 2) / ODR_HZ;
+
+    return wm ? wm : 1;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void record_err(struct run *r, int k, double e)
+{
+    r->err_sq[k] += e * e;
+    r->err_max[k] = fmax(r->err_max[k], fabs(e));
+    r->err_n[k]++;
+}
+
+static void run_scene(struct run *r, double len_s, uint64_t noise_seed)
+{
+    struct ctrl_logic cl;
+    struct imu_odr odr;
+    struct imu_clock clk = { 0 };
+    struct imu_sample batch[BATCH_MAX];
+    double true_t[BATCH_MAX];
+    uint16_t hz = r->adaptive ? odr_defaults.hz[IMU_ODR_MID] : r->fixed_hz;
+    double scale = 1.0 + clock_ppm * 1e-6;
+    double period_s = scale / hz;
+    double next_s = period_s;           /* next frame, true time */
+    size_t queued = 0;
+
+    rng = noise_seed;
+    ctrl_logic_init(&cl, FUSION_BETA, 1.0f / hz, &posture_defaults, &calib_defaults);
+    imu_odr_init(&odr, &odr_defaults, 0);
+
+    while (next_s < len_s) {
+        /* Fill to the watermark; the interrupt fires with the last frame */
+        uint32_t wm = wm_for(hz);
+
+        while (queued < wm) {
+            true_t[queued] = next_s;
+            sample_at(next_s, period_s, &batch[queued]);
+            queued++;
+            next_s += period_s;
+        }
+
+        /* Wakeup latency; frames that land meanwhile come along */
+        double drain_s = true_t[queued - 1] + uniform(0.2e-3, 3e-3);
+
+        while (next_s <= drain_s && queued < BATCH_MAX) {
+            true_t[queued] = next_s;
+            sample_at(next_s, period_s, &batch[queued]);
+            queued++;
+            next_s += period_s;
+        }
+
+        /* Stamp as imu_acq.c does, with the firmware's nominal period */
+        uint32_t period_us = 1000000u / hz;
+        uint32_t t_drain_us = (uint32_t)(drain_s * 1e6);
+        uint32_t newest = imu_clock_newest(&clk, queued, period_us, t_drain_us, false);
+
+        for (size_t k = 0; k < queued; k++) {
+            batch[k].t_us = newest - (uint32_t)(queued - 1 - k) * period_us;
+            double se = fabs((double)(int32_t)(batch[k].t_us - (uint32_t)(true_t[k] * 1e6)));
+
+            if (drain_s * 1e6 > WARMUP_US) {
+                r->stamp_err_max_us = fmax(r->stamp_err_max_us, se);
+            }
+        }
+
+        struct ctrl_decision d;
+        double c0 = now_ns();
+
+        ctrl_logic_step(&cl, batch, queued, &d);
+        r->cpu_ns += now_ns() - c0;
+        r->frames += queued;
+        r->bursts++;
+        r->i2c_bytes += I2C_LEVEL_BYTES + I2C_BURST_BYTES + queued * 13 + SENSORTIME_BYTES;
+        if (d.ev != POSTURE_EV_NONE) {
+            r->events[d.ev]++;
+            if (verbose) {
+                printf("    %-9s %8.1f s  %s\n", r->name, drain_s, posture_event_name(d.ev));
+            }
+        }
+
+        /* Error at the newest frame's true time */
+        struct truth tr;
+
+        truth_at(true_t[queued - 1], &tr);
+        if (drain_s * 1e6 > WARMUP_US) {
+            double e = d.angles.pitch_deg - tr.pitch_deg;
+            int moving = fabs(tr.pitch_dps) > MOVING_DPS || fabs(tr.yaw_dps) > MOVING_DPS;
+
+            record_err(r, 0, e);
+            record_err(r, moving ? 1 : 2, e);
+        }
+
+        uint32_t energy = imu_odr_energy(batch, queued);
+
+        queued = 0;
+        if (!r->adaptive) {
+            continue;
+        }
+
+        enum imu_odr_level was = odr.level;
+        enum imu_odr_level lvl = imu_odr_step(&odr, energy, t_drain_us / 1000);
+
+        if (lvl != was) {
+            /* Drained above; reconfigure, flush, restart one period on */
+            double bus_s = I2C_SWITCH_BYTES * I2C_US_PER_BYTE * 1e-6;
+
+            hz = odr_defaults.hz[lvl];
+            period_s = scale / hz;
+            next_s = drain_s + bus_s + period_s;
+            imu_clock_restart(&clk);
+            r->i2c_bytes += I2C_SWITCH_BYTES;
+            r->changes++;
+        }
+    }
+    if (r->adaptive) {
+        imu_odr_stats(&odr, (uint32_t)(len_s * 1000), &r->odr);
+    }
+}
+
+/* ===== Report ===== */
+static double rms(const struct run *r, int k)
+{
+    return r->err_n[k] ? sqrt(r->err_sq[k] / r->err_n[k]) : 0.0;
+}
+
+static void report(const struct run *r, double len_s)
+{
+    printf("%-9s %8llu %6.0f Hz %7llu %9.0f B/s %5.2f/%5.2f %5.2f/%5.2f %5.2f/%5.2f %6.0f us"
+           " %6.2f ms/s\n",
+           r->name, (unsigned long long)r->frames, r->frames / len_s,
+           (unsigned long long)r->bursts, r->i2c_bytes / len_s, rms(r, 0), r->err_max[0],
+           rms(r, 1), r->err_max[1], rms(r, 2), r->err_max[2], r->stamp_err_max_us,
+           r->cpu_ns / len_s * 1e-6);
+}
+
+static int failures;
+
+#define EXPECT(cond, ...)                                           \
+    do {                                                            \
+        if (!(cond)) {                                              \
+            printf("FAIL: ");                                       \
+            printf(__VA_ARGS__);                                    \
+            printf("\n");                                           \
+            failures++;                                             \
+        }                                                           \
+    } while (0)
+
+/* ===== Scenes =====
+ * At the desk the head is held for up to a minute between movements; an
+ * active wearer moves every few seconds and may cost more than fixed
+ * 100 Hz, as the head moves at 200 Hz. Accuracy must hold in both.
+ */
+struct scene {
+    const char *name;
+    double hold_max_s;
+    double max_load;            /* frames and bytes against fixed 100 Hz, 0: any */
+};
+
+static const struct scene scenes[] = {
+    { "desk", 60.0, 0.6 },
+    { "active", 8.0, 0.0 },
+};
+
+static void check_scene(const struct scene *sc, double len_s, uint64_t seed)
+{
+    struct run runs[] = {
+        { .name = "fixed 25", .fixed_hz = 25 },
+        { .name = "fixed 100", .fixed_hz = 100 },
+        { .name = "fixed 200", .fixed_hz = 200 },
+        { .name = "adaptive", .adaptive = 1 },
+    };
+    const struct run *ref = &runs[1];
+    const struct run *ad = &runs[3];
+
+    rng = seed;
+    make_scene(len_s, sc->hold_max_s);
+    printf("%s: %.0f min, %zu moves, %zu turns, sensor clock %+.0f ppm\n\n", sc->name,
+           len_s / 60.0, n_moves, n_turns, clock_ppm);
+    printf("%-9s %8s %9s %7s %11s %11s %11s %11s %9s %9s\n", "", "frames", "rate", "bursts",
+           "I2C", "rms/max", "moving", "held", "stamp", "fusion");
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        /* Same sensor noise sequence for every run */
+        run_scene(&runs[i], len_s, seed * 7919 + 1);
+        report(&runs[i], len_s);
+    }
+
+    printf("\nadaptive: %u rate changes, %.0f/%.0f/%.0f s at %u/%u/%u Hz, %u Hz on average\n",
+           ad->changes, ad->odr.level_ms[0] / 1000.0, ad->odr.level_ms[1] / 1000.0,
+           ad->odr.level_ms[2] / 1000.0, odr_defaults.hz[0], odr_defaults.hz[1],
+           odr_defaults.hz[2], ad->odr.avg_hz);
+    printf("events (slouch/dwell/recovered): fixed 100 %u/%u/%u, adaptive %u/%u/%u\n",
+           ref->events[POSTURE_EV_SLOUCH_START], ref->events[POSTURE_EV_DWELL_EXCEEDED],
+           ref->events[POSTURE_EV_RECOVERED], ad->events[POSTURE_EV_SLOUCH_START],
+           ad->events[POSTURE_EV_DWELL_EXCEEDED], ad->events[POSTURE_EV_RECOVERED]);
+
+    EXPECT(!sc->max_load || ad->frames < sc->max_load * ref->frames, "%s: %llu frames fused, fixed 100 Hz %llu",
+           sc->name, (unsigned long long)ad->frames, (unsigned long long)ref->frames);
+    EXPECT(!sc->max_load || ad->i2c_bytes < sc->max_load * ref->i2c_bytes,
+           "%s: %llu I2C bytes, fixed 100 Hz %llu", sc->name,
+           (unsigned long long)ad->i2c_bytes, (unsigned long long)ref->i2c_bytes);
+    EXPECT(rms(ad, 1) <= rms(ref, 1) + 0.1, "%s: moving rms %.2f deg, fixed 100 Hz %.2f",
+           sc->name, rms(ad, 1), rms(ref, 1));
+    EXPECT(ad->err_max[1] <= ref->err_max[1] + 0.5, "%s: moving max %.2f deg, fixed 100 Hz %.2f",
+           sc->name, ad->err_max[1], ref->err_max[1]);
+    EXPECT(rms(ad, 2) <= rms(ref, 2) + 0.1, "%s: held rms %.2f deg, fixed 100 Hz %.2f",
+           sc->name, rms(ad, 2), rms(ref, 2));
+    EXPECT(ad->stamp_err_max_us < 0.25e6 / odr_defaults.hz[IMU_ODR_LOW],
+           "%s: stamps off by up to %.0f us", sc->name, ad->stamp_err_max_us);
+    for (int e = POSTURE_EV_NONE + 1; e < EV_COUNT; e++) {
+        EXPECT(ad->events[e] == ref->events[e], "%s: %u %s events, fixed 100 Hz %u", sc->name,
+               ad->events[e], posture_event_name(e), ref->events[e]);
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t seed = 1;
+    double minutes = 20.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--minutes") && i + 1 < argc) {
+            minutes = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--clock-ppm") && i + 1 < argc) {
+            clock_ppm = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "-v")) {
+            verbose = 1;
+        } else {
+            fprintf(stderr, "usage: %s [--seed N] [--minutes N] [--clock-ppm N] [-v]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); i++) {
+        check_scene(&scenes[i], minutes * 60.0, seed);
+    }
+
+    printf("\n%s\n", failures ? "FAILED" : "all checks passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,189 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Run the Peltier PI controller (src/peltier_pi.c) against a lumped thermal
+ * model of the patch and report settling time, overshoot and CPU cost per
+ * tick.
+ *
+ *   peltier_sim [--kp K] [--ki K] [--tick-hz N] [--setpoint C]
+ *               [--imax A] [--ilimit A] [--csv]
+ *
+ * Plant: one thermal mass (Peltier hot face + skin contact) heated by
+ * duty * P_MAX and leaking to skin/ambient through R_TH, seen by the NTC
+ * through a first-order lag. Supply current is duty * imax.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "peltier_pi.h"
+
+/* Defaults match the Kconfig defaults (NECK_PELTIER_*) */
+#define DEF_KP              0.25f
+#define DEF_KI              0.02f
+#define DEF_TICK_HZ         10
+#define DEF_SETPOINT_C      38.0f
+#define DEF_OUT_MAX         0.8f
+#define DEF_SLEW_PER_S      0.2f
+#define DEF_ILIMIT_A        0.6f
+
+#define T_AMB_C             32.0    /* skin under the patch */
+#define C_TH_J_PER_K        3.0     /* thermal mass */
+#define R_TH_K_PER_W        8.0     /* to skin/ambient */
+#define P_MAX_W             2.0     /* heating at 100 % duty */
+#define TAU_NTC_S           1.5     /* sensor lag */
+#define PLANT_DT_S          0.001
+#define RUN_S               180.0
+#define SETTLE_BAND_C       0.25
+
+struct sim_cfg {
+    struct peltier_pi_params pi;
+    int tick_hz;
+    float setpoint_c;
+    float imax_a;
+    int csv;
+};
+
+struct sim_result {
+    double rise_s;          /* 10 -> 90 % of the step */
+    double settle_s;        /* last entry into +-SETTLE_BAND_C */
+    double overshoot_c;
+    double final_err_c;
+    double peak_a;
+    unsigned long foldback_ticks;
+};
+
+static void simulate(const struct sim_cfg *cfg, struct sim_result *r)
+{
+    struct peltier_pi pi;
+    double t_plant = T_AMB_C, t_ntc = T_AMB_C;
+    double span = cfg->setpoint_c - T_AMB_C;
+    double t10 = -1, t90 = -1;
+    int ticks_per = (int)lround(1.0 / (cfg->tick_hz * PLANT_DT_S));
+    float duty = 0.0f;
+    float current = 0.0f;
+
+    memset(r, 0, sizeof(*r));
+    r->settle_s = -1;
+    peltier_pi_init(&pi, &cfg->pi);
+
+    for (long k = 0; k * PLANT_DT_S < RUN_S; k++) {
+        double t = k * PLANT_DT_S;
+
+        if (k % ticks_per == 0) {
+            duty = peltier_pi_step(&pi, cfg->setpoint_c, (float)t_ntc, current);
+            if (pi.folded_back) {
+                r->foldback_ticks++;
+            }
+            if (cfg->csv) {
+                printf("%.2f,%.3f,%.3f,%.3f,%.3f\n", t, t_plant, t_ntc, duty, current);
+            }
+        }
+        current = duty * cfg->imax_a;
+        if (current > r->peak_a) {
+            r->peak_a = current;
+        }
+
+        t_plant += PLANT_DT_S * (duty * P_MAX_W - (t_plant - T_AMB_C) / R_TH_K_PER_W) / C_TH_J_PER_K;
+        t_ntc += PLANT_DT_S * (t_plant - t_ntc) / TAU_NTC_S;
+
+        if (t10 < 0 && t_plant >= T_AMB_C + 0.1 * span) t10 = t;
+        if (t90 < 0 && t_plant >= T_AMB_C + 0.9 * span) t90 = t;
+        if (t_plant - cfg->setpoint_c > r->overshoot_c) {
+            r->overshoot_c = t_plant - cfg->setpoint_c;
+        }
+        if (fabs(t_plant - cfg->setpoint_c) > SETTLE_BAND_C) {
+            r->settle_s = -1;
+        } else if (r->settle_s < 0) {
+            r->settle_s = t;
+        }
+        r->final_err_c = t_plant - cfg->setpoint_c;
+    }
+    r->rise_s = (t10 >= 0 && t90 >= 0) ? t90 - t10 : -1;
+}
+
+static double tick_cost_ns(const struct sim_cfg *cfg)
+{
+    struct peltier_pi pi;
+    struct timespec a, b;
+    volatile float sink = 0;
+    const int n = 10000000;
+
+    peltier_pi_init(&pi, &cfg->pi);
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (int i = 0; i < n; i++) {
+        sink += peltier_pi_step(&pi, cfg->setpoint_c, 30.0f + (float)(i & 15), 0.3f);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    (void)sink;
+    return ((b.tv_sec - a.tv_sec) * 1e9 + (b.tv_nsec - a.tv_nsec)) / n;
+}
+
+int main(int argc, char **argv)
+{
+    struct sim_cfg cfg = {
+        .pi = {
+            .kp = DEF_KP,
+            .ki = DEF_KI,
+            .out_max = DEF_OUT_MAX,
+            .slew_per_s = DEF_SLEW_PER_S,
+            .current_limit_a = DEF_ILIMIT_A,
+        },
+        .tick_hz = DEF_TICK_HZ,
+        .setpoint_c = DEF_SETPOINT_C,
+        .imax_a = 0.6f,
+    };
+    struct sim_result r;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--csv")) {
+            cfg.csv = 1;
+        } else if (i + 1 < argc && !strcmp(argv[i], "--kp")) {
+            cfg.pi.kp = strtof(argv[++i], NULL);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--ki")) {
+            cfg.pi.ki = strtof(argv[++i], NULL);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--tick-hz")) {
+            cfg.tick_hz = atoi(argv[++i]);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--setpoint")) {
+            cfg.setpoint_c = strtof(argv[++i], NULL);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--imax")) {
+            cfg.imax_a = strtof(argv[++i], NULL);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--ilimit")) {
+            cfg.pi.current_limit_a = strtof(argv[++i], NULL);
+        } else {
+            fprintf(stderr, "usage: %s [--kp K] [--ki K] [--tick-hz N] [--setpoint C] "
+                    "[--imax A] [--ilimit A] [--csv]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (cfg.tick_hz <= 0) {
+        return 2;
+    }
+    cfg.pi.dt_s = 1.0f / cfg.tick_hz;
+
+    if (cfg.csv) {
+        printf("t_s,t_plant_c,t_ntc_c,duty,current_a\n");
+    }
+    simulate(&cfg, &r);
+    if (cfg.csv) {
+        return 0;
+    }
+
+    printf("step %.1f -> %.1f C, kp %.3f ki %.3f @ %d Hz\n",
+           T_AMB_C, cfg.setpoint_c, cfg.pi.kp, cfg.pi.ki, cfg.tick_hz);
+    printf("rise 10-90%%:    %.1f s\n", r.rise_s);
+    if (r.settle_s >= 0) {
+        printf("settled +-%.2f: %.1f s\n", SETTLE_BAND_C, r.settle_s);
+    } else {
+        printf("settled +-%.2f: never\n", SETTLE_BAND_C);
+    }
+    printf("overshoot:      %.2f C\n", r.overshoot_c);
+    printf("final error:    %+.3f C\n", r.final_err_c);
+    printf("peak current:   %.2f A (limit %.2f, %lu fold-back ticks)\n",
+           r.peak_a, cfg.pi.current_limit_a, r.foldback_ticks);
+    printf("host cost:      %.1f ns/tick\n", tick_cost_ns(&cfg));
+    return 0;
+}
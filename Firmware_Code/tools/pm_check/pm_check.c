@@ -0,0 +1,167 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Run src/imu_pm.c against scripted motion/stillness sequences and check
+ * when the IMU enters and leaves low power.
+ *
+ *   pm_check [--still-s N] [-v]
+ *
+ * Each scenario is a list of segments (moving or still, cue on or off).
+ * A model of the BMI270 motion features runs at their 50 Hz rate:
+ * any-motion fires on every sample while moving, no-motion once the wearer
+ * has been still for --still-s (default 30 s, the Kconfig default). The
+ * number of sleeps and wakeups, the time spent in low power and the
+ * estimated average current must match the scenario. Exit status is 1 if
+ * any scenario fails.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "imu_pm.h"
+
+#define MAX_SEGS    8
+#define STEP_MS     20          /* BMI270 feature engine rate */
+
+struct seg {
+    double len_s;
+    int moving;
+    int cue;
+};
+
+struct scenario {
+    const char *name;
+    struct seg s[MAX_SEGS];
+    uint32_t sleeps;
+    uint32_t wakeups;
+    double lp_s;                /* expected time in low power */
+};
+
+/* Kconfig defaults */
+static const struct imu_pm_params params = {
+    .mode_ua = { [IMU_PM_ACTIVE] = 1200, [IMU_PM_LOW_POWER] = 35 },
+};
+
+/* Expectations assume --still-s 30 */
+static const struct scenario scenarios[] = {
+    {
+        /* Put down on the desk for ten minutes */
+        "desk",
+        { { 10, 1, 0 }, { 600, 0, 0 }, { 10, 1, 0 } },
+        1, 1, 570,
+    },
+    {
+        /* Never still long enough */
+        "fidget",
+        { { 20, 0, 0 }, { 1, 1, 0 }, { 25, 0, 0 }, { 1, 1, 0 }, { 29, 0, 0 } },
+        0, 0, 0,
+    },
+    {
+        /* A cue runs while still: low power waits for its end */
+        "cue_hold",
+        { { 5, 1, 0 }, { 60, 0, 1 }, { 40, 0, 0 }, { 5, 1, 0 } },
+        1, 1, 40,
+    },
+    {
+        /* The cue starts in low power: wake at once, sleep again after */
+        "cue_wake",
+        { { 5, 1, 0 }, { 40, 0, 0 }, { 10, 0, 1 }, { 20, 0, 0 } },
+        2, 1, 30,
+    },
+    {
+        "naps",
+        { { 5, 1, 0 }, { 60, 0, 0 }, { 5, 1, 0 }, { 60, 0, 0 }, { 5, 1, 0 }, { 60, 0, 0 } },
+        3, 2, 90,
+    },
+};
+
+static int run(const struct scenario *sc, uint32_t still_ms, int verbose)
+{
+    struct imu_pm pm;
+    struct imu_pm_stats st;
+    const char *why = NULL;
+    enum imu_pm_mode mode = IMU_PM_ACTIVE;
+    /* Start near the wrap point: timestamps are free-running uint32 ms */
+    uint32_t t0 = 0xFFFFFFFFu - 5000;
+    uint32_t t = 0, still_for = 0;
+    int held = 0;
+
+    imu_pm_init(&pm, &params, t0);
+
+    for (int i = 0; i < MAX_SEGS && sc->s[i].len_s > 0; i++) {
+        const struct seg *sg = &sc->s[i];
+        uint32_t end = t + (uint32_t)(sg->len_s * 1000);
+
+        for (; t < end; t += STEP_MS) {
+            enum imu_pm_mode prev = mode;
+
+            if (sg->cue != held) {
+                held = sg->cue;
+                mode = imu_pm_event(&pm, held ? IMU_PM_EV_HOLD : IMU_PM_EV_RELEASE, t0 + t);
+            }
+            if (sg->moving) {
+                still_for = 0;
+                mode = imu_pm_event(&pm, IMU_PM_EV_ANY_MOTION, t0 + t);
+            } else if ((still_for += STEP_MS) == still_ms) {
+                mode = imu_pm_event(&pm, IMU_PM_EV_NO_MOTION, t0 + t);
+            }
+            if (verbose && mode != prev) {
+                printf("  %8.2f s  %s\n", t / 1000.0,
+                       mode == IMU_PM_LOW_POWER ? "low power" : "active");
+            }
+        }
+    }
+
+    imu_pm_stats(&pm, t0 + t, &st);
+
+    double lp_s = st.mode_ms[IMU_PM_LOW_POWER] / 1000.0;
+    double total_s = t / 1000.0;
+    double avg = (lp_s * params.mode_ua[IMU_PM_LOW_POWER] +
+                  (total_s - lp_s) * params.mode_ua[IMU_PM_ACTIVE]) / total_s;
+
+    if (st.sleeps != sc->sleeps) {
+        why = "sleep count";
+    } else if (st.wakeups != sc->wakeups) {
+        why = "wakeup count";
+    } else if (fabs(lp_s - sc->lp_s) > 0.1) {
+        why = "low-power time";
+    } else if (st.mode_ms[IMU_PM_ACTIVE] + st.mode_ms[IMU_PM_LOW_POWER] != t) {
+        why = "mode times do not add up";
+    } else if (fabs(st.avg_ua - avg) > 1.0) {
+        why = "average current";
+    }
+
+    printf("%-10s %6u %7u %8.1f %8.1f %7u%s%s\n", sc->name, st.sleeps, st.wakeups, total_s,
+           lp_s, st.avg_ua, why ? "  FAIL: " : "", why ? why : "");
+    return why != NULL;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t still_s = 30;
+    int verbose = 0;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && !strcmp(argv[i], "--still-s")) {
+            still_s = (uint32_t)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-v")) {
+            verbose = 1;
+        } else {
+            fprintf(stderr, "usage: %s [--still-s N] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (still_s == 0) {
+        return 2;
+    }
+
+    printf("%-10s %6s %7s %8s %8s %7s\n", "scenario", "sleeps", "wakeups", "total s",
+           "lp s", "avg uA");
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        failed |= run(&scenarios[i], still_s * 1000, verbose);
+    }
+    return failed;
+}
@@ -0,0 +1,241 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Run src/posture.c over scripted pitch traces and check which events it
+ * raises and when.
+ *
+ *   posture_check [--period-ms N] [-v]
+ *
+ * Each trace is a piecewise-linear pitch profile, optionally with a
+ * triangle wobble on top, sampled every --period-ms (default 100 ms, one
+ * FIFO batch at the default ODR and watermark). The parameters are the
+ * Kconfig defaults. Expected events must arrive in order within their
+ * tolerance, no other event may be raised and the baseline must end where
+ * the trace expects it. A trace may hold the posture (posture_hold(), as
+ * the activity gate does) over an interval. Exit status is 1 if any trace
+ * fails.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "posture.h"
+
+#define MAX_KNOTS   8
+#define MAX_EVENTS  4
+
+struct knot {
+    double t_s;
+    double pitch_deg;
+};
+
+struct expect {
+    enum posture_event ev;
+    double t_s;
+    double tol_s;
+};
+
+struct trace {
+    const char *name;
+    double len_s;
+    struct knot k[MAX_KNOTS];
+    double wobble_deg;          /* triangle amplitude, 1 s period */
+    struct expect e[MAX_EVENTS];
+    double baseline_deg;        /* expected baseline at the end, NAN = skip */
+    double baseline_tol;
+    double hold_from_s, hold_to_s;
+};
+
+static const struct posture_params params = {
+    .enter_deg = 15.0f,
+    .exit_deg = 8.0f,
+    .enter_dwell_ms = 3000,
+    .exit_dwell_ms = 1500,
+    .alert_ms = 30000,
+    .baseline_tau_s = 300.0f,
+    .warmup_ms = 5000,
+    .baseline_limit_deg = 30.0f,
+};
+
+/* Neutral at 5 deg unless stated; warm-up ends at 5 s */
+static const struct trace traces[] = {
+    {
+        .name = "glance", .len_s = 60,
+        .k = { { 0, 5 }, { 20, 5 }, { 20.3, 35 }, { 22, 35 }, { 22.3, 5 }, { 60, 5 } },
+        .baseline_deg = 5, .baseline_tol = 0.5,
+    },
+    {
+        .name = "slouch", .len_s = 120,
+        .k = { { 0, 5 }, { 20, 5 }, { 20.1, 30 }, { 80, 30 }, { 80.1, 5 }, { 120, 5 } },
+        .e = {
+            { POSTURE_EV_SLOUCH_START, 23.1, 0.15 },
+            { POSTURE_EV_DWELL_EXCEEDED, 53.1, 0.15 },
+            { POSTURE_EV_RECOVERED, 81.6, 0.15 },
+        },
+        .baseline_deg = 5, .baseline_tol = 0.5,
+    },
+    {
+        /* Hovers around the enter band: one episode, no chatter */
+        .name = "chatter", .len_s = 90,
+        .k = { { 0, 5 }, { 20, 5 }, { 20.1, 23 }, { 60, 23 }, { 60.1, 5 }, { 90, 5 } },
+        .wobble_deg = 5,
+        .e = {
+            { POSTURE_EV_SLOUCH_START, 23.1, 0.5 },
+            { POSTURE_EV_DWELL_EXCEEDED, 53.1, 0.5 },
+            { POSTURE_EV_RECOVERED, 61.6, 0.5 },
+        },
+        .baseline_deg = NAN,
+    },
+    {
+        /* Neutral moves from 12 to 16 deg over ten minutes, then a slouch
+         * relative to the new neutral. The average trails a ramp by
+         * rate * tau = 2 deg.
+         */
+        .name = "drift", .len_s = 700,
+        .k = { { 0, 12 }, { 600, 16 }, { 650, 16 }, { 650.1, 33 }, { 700, 33 } },
+        .e = { { POSTURE_EV_SLOUCH_START, 653.1, 0.15 }, { POSTURE_EV_DWELL_EXCEEDED, 683.1, 0.15 } },
+        .baseline_deg = 16, .baseline_tol = 2.0,
+    },
+    {
+        /* Slow slouch over a minute must not be absorbed by the baseline */
+        .name = "creep", .len_s = 120,
+        .k = { { 0, 5 }, { 20, 5 }, { 80, 35 }, { 120, 35 } },
+        .e = { { POSTURE_EV_SLOUCH_START, 53.1, 1.0 }, { POSTURE_EV_DWELL_EXCEEDED, 83.1, 1.0 } },
+        .baseline_deg = NAN,
+    },
+    {
+        /* Head forward while walking: no slouch until the walk ends, and
+         * the baseline has not learned the forward pitch
+         */
+        .name = "walk", .len_s = 60,
+        .k = { { 0, 5 }, { 15, 5 }, { 15.1, 25 }, { 30, 25 }, { 30.1, 5 }, { 60, 5 } },
+        .baseline_deg = 5, .baseline_tol = 0.5,
+        .hold_from_s = 10, .hold_to_s = 30.1,
+    },
+    {
+        /* Slouched, then walking: recovery as usual, the dwell alert only
+         * after the walk
+         */
+        .name = "walk-dwell", .len_s = 120,
+        .k = { { 0, 5 }, { 20, 5 }, { 20.1, 30 }, { 80, 30 }, { 80.1, 5 }, { 120, 5 } },
+        .e = {
+            { POSTURE_EV_SLOUCH_START, 23.1, 0.15 },
+            { POSTURE_EV_DWELL_EXCEEDED, 70.0, 0.15 },
+            { POSTURE_EV_RECOVERED, 81.6, 0.15 },
+        },
+        .baseline_deg = 5, .baseline_tol = 0.5,
+        .hold_from_s = 30, .hold_to_s = 70,
+    },
+    {
+        /* Still slouched when the walk ends: the dwell starts over */
+        .name = "walk-end", .len_s = 60,
+        .k = { { 0, 5 }, { 15, 5 }, { 15.1, 25 }, { 60, 25 } },
+        .e = { { POSTURE_EV_SLOUCH_START, 33.0, 0.15 } },
+        .baseline_deg = NAN,
+        .hold_from_s = 10, .hold_to_s = 30,
+    },
+};
+
+static double pitch_at(const struct trace *tr, double t)
+{
+    double p = tr->k[0].pitch_deg;
+
+    for (int i = 1; i < MAX_KNOTS && (tr->k[i].t_s > 0); i++) {
+        const struct knot *a = &tr->k[i - 1], *b = &tr->k[i];
+
+        if (t <= b->t_s) {
+            p = a->pitch_deg + (b->pitch_deg - a->pitch_deg) * (t - a->t_s) / (b->t_s - a->t_s);
+            break;
+        }
+        p = b->pitch_deg;
+    }
+    if (tr->wobble_deg > 0) {
+        double ph = fmod(t, 1.0);
+
+        p += tr->wobble_deg * (ph < 0.5 ? 4 * ph - 1 : 3 - 4 * ph);
+    }
+    return p;
+}
+
+static int run(const struct trace *tr, uint32_t period_ms, int verbose)
+{
+    struct posture ps;
+    const char *why = NULL;
+    int next = 0, nexp = 0;
+    double worst = 0;
+
+    while (nexp < MAX_EVENTS && tr->e[nexp].ev != POSTURE_EV_NONE) {
+        nexp++;
+    }
+
+    posture_init(&ps, &params);
+    /* Start near the wrap point: timestamps are free-running uint32 ms */
+    uint32_t t0 = 0xFFFFFFFFu - 2000;
+
+    for (uint32_t t = 0; t <= (uint32_t)(tr->len_s * 1000); t += period_ms) {
+        double t_s = t / 1000.0;
+        posture_hold(&ps, t_s >= tr->hold_from_s && t_s < tr->hold_to_s);
+
+        enum posture_event ev = posture_step(&ps, (float)pitch_at(tr, t_s), t0 + t);
+
+        if (ev == POSTURE_EV_NONE) {
+            continue;
+        }
+        if (verbose) {
+            printf("  %8.2f s  %-15s baseline %.2f\n", t_s, posture_event_name(ev),
+                   ps.baseline_deg);
+        }
+        if (!why && next >= nexp) {
+            why = "unexpected event";
+        } else if (!why && ev != tr->e[next].ev) {
+            why = "wrong event";
+        } else if (!why) {
+            double off = fabs(t_s - tr->e[next].t_s);
+
+            worst = off > worst ? off : worst;
+            if (off > tr->e[next].tol_s) {
+                why = "event late/early";
+            }
+            next++;
+        }
+    }
+    if (!why && next < nexp) {
+        why = "missing event";
+    }
+    if (!why && !isnan(tr->baseline_deg) && fabs(ps.baseline_deg - tr->baseline_deg) > tr->baseline_tol) {
+        why = "baseline off";
+    }
+
+    printf("%-10s %6d %10.2f %10.2f%s%s\n", tr->name, next, worst, ps.baseline_deg,
+           why ? "  FAIL: " : "", why ? why : "");
+    return why != NULL;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t period_ms = 100;
+    int verbose = 0;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && !strcmp(argv[i], "--period-ms")) {
+            period_ms = (uint32_t)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-v")) {
+            verbose = 1;
+        } else {
+            fprintf(stderr, "usage: %s [--period-ms N] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (period_ms == 0) {
+        return 2;
+    }
+
+    printf("%-10s %6s %10s %10s\n", "trace", "events", "max off s", "baseline");
+    for (size_t i = 0; i < sizeof(traces) / sizeof(traces[0]); i++) {
+        failed |= run(&traces[i], period_ms, verbose);
+    }
+    return failed;
+}
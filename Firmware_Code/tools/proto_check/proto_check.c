@@ -0,0 +1,459 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Host checks for the framed command protocol (shared/cmd_proto.h).
+ *
+ *   proto_check [--mtu N] [--fuzz N] [--seed N] [--bench] [-v]
+ *
+ * codec     round trip of every command type, frame limits, truncated and
+ *           foreign-version frames
+ * loopback  the gateway sender and the patch receiver over a link that
+ *           loses command frames and ACKs (0, 5, 20, 50 %), in virtual time:
+ *           every command must be applied exactly once and in order, across
+ *           several wraps of the 8-bit sequence
+ * fuzz      random and mutated frames into both ends (N iterations,
+ *           default 200000); the state must stay consistent. Build with
+ *           -DCMAKE_C_FLAGS=-fsanitize=address,undefined to also catch
+ *           out-of-bounds reads.
+ * bench     (--bench) encode and decode throughput
+ *
+ * --mtu is the ATT MTU (default 247). Exit status is 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cmd_proto.h"
+
+#define LOOP_CMDS       3000
+#define TICK_MS         10
+#define FRAMES_PER_TICK 4       /* writes without response per connection event */
+
+static size_t payload = 244;
+static int verbose;
+static uint32_t rng = 1;
+
+static uint32_t rnd(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Random valid command; returns its value length */
+static uint8_t random_cmd(uint8_t *type, uint8_t *val)
+{
+    static const uint8_t types[] = {
+        CMDP_T_LED, CMDP_T_POSTURE, CMDP_T_HAPTIC_PLAY,
+        CMDP_T_HAPTIC_STOP, CMDP_T_HAPTIC_CUE, CMDP_T_SETPOINT,
+    };
+
+    *type = types[rnd() % sizeof(types)];
+    uint8_t len = (uint8_t)cmdp_type_len(*type);
+
+    for (uint8_t i = 0; i < len; i++) {
+        val[i] = (uint8_t)rnd();
+    }
+    return len;
+}
+
+/* ===== Codec ===== */
+
+#define CHECK(cond)                                 \
+    do {                                            \
+        if (!(cond) && !why) {                      \
+            why = #cond;                            \
+        }                                           \
+    } while (0)
+
+static int check_codec(void)
+{
+    const char *why = NULL;
+    uint8_t buf[64];
+    uint8_t val[CMDP_VAL_MAX];
+    struct cmdp_writer w;
+    struct cmdp_reader r;
+    struct cmdp_msg m;
+
+    /* Every type round trips */
+    for (int t = 0; t < 256; t++) {
+        int len = cmdp_type_len((uint8_t)t);
+
+        if (len < 0) {
+            continue;
+        }
+        for (int i = 0; i < len; i++) {
+            val[i] = (uint8_t)(t * 7 + i);
+        }
+        CHECK(cmdp_writer_init(&w, buf, sizeof(buf)) == 0);
+        CHECK(cmdp_put(&w, (uint8_t)(t + 1), (uint8_t)t, val, (uint8_t)len) == 0);
+        CHECK(w.len == CMDP_HDR_LEN + CMDP_MSG_HDR_LEN + (size_t)len);
+        CHECK(cmdp_reader_init(&r, buf, w.len) == 0);
+        CHECK(cmdp_next(&r, &m) == 1);
+        CHECK(m.seq == (uint8_t)(t + 1) && m.type == t && m.len == len);
+        CHECK(memcmp(m.val, val, len) == 0);
+        CHECK(cmdp_next(&r, &m) == 0);
+    }
+
+    /* Posture parameters, little-endian on the wire */
+    struct cmdp_posture pp = { 1500, 800, 2000, 1000, 300 }, pq;
+
+    cmdp_posture_encode(val, &pp);
+    CHECK(val[0] == 0xdc && val[1] == 0x05);
+    cmdp_posture_decode(&pq, val);
+    CHECK(memcmp(&pp, &pq, sizeof(pp)) == 0);
+
+    /* A message that does not fit leaves the frame as it was */
+    CHECK(cmdp_writer_init(&w, buf, 13) == 0);
+    CHECK(cmdp_put(&w, 0, CMDP_T_POSTURE, val, CMDP_POSTURE_LEN) == -ENOSPC);
+    CHECK(w.len == 1);
+    CHECK(cmdp_put(&w, 0, CMDP_T_LED, val, 1) == 0);
+    CHECK(cmdp_put(&w, 1, CMDP_T_POSTURE, val, CMDP_POSTURE_LEN) == -ENOSPC);
+    CHECK(w.len == 5);
+
+    /* Truncation: the complete messages before it are still returned */
+    CHECK(cmdp_writer_init(&w, buf, sizeof(buf)) == 0);
+    cmdp_put(&w, 0, CMDP_T_LED, val, 1);
+    cmdp_put(&w, 1, CMDP_T_POSTURE, val, CMDP_POSTURE_LEN);
+    CHECK(cmdp_reader_init(&r, buf, w.len - 1) == 0);
+    CHECK(cmdp_next(&r, &m) == 1 && m.type == CMDP_T_LED);
+    CHECK(cmdp_next(&r, &m) == -EINVAL);
+    CHECK(cmdp_next(&r, &m) == 0);
+    CHECK(cmdp_reader_init(&r, buf, 3) == -EINVAL);
+    buf[0] = CMDP_VERSION + 1;
+    CHECK(cmdp_reader_init(&r, buf, w.len) == -ENOTSUP);
+
+    /* Sequence order across the wrap */
+    CHECK(cmdp_seq_before(250, 3) && !cmdp_seq_before(3, 250));
+    CHECK(!cmdp_seq_before(7, 7));
+
+    /* Sender rejects values that do not match their type */
+    struct cmdp_tx tx;
+
+    cmdp_tx_init(&tx);
+    CHECK(cmdp_tx_queue(&tx, CMDP_T_LED, val, 2) == -EINVAL);
+    CHECK(cmdp_tx_queue(&tx, CMDP_T_ACK, val, 2) == -EINVAL);
+    for (int i = 0; i < CMDP_WINDOW; i++) {
+        CHECK(cmdp_tx_queue(&tx, CMDP_T_HAPTIC_STOP, NULL, 0) == i);
+    }
+    CHECK(cmdp_tx_queue(&tx, CMDP_T_HAPTIC_STOP, NULL, 0) == -ENOSPC);
+
+    printf("%-10s %s%s\n", "codec", why ? "FAIL: " : "ok", why ? why : "");
+    return why != NULL;
+}
+
+/* ===== Loopback over a lossy link ===== */
+
+struct sink {
+    uint32_t n;             /* commands applied */
+    uint32_t seed;          /* regenerates the expected stream */
+    const char *why;
+};
+
+/* The gateway queues the commands from the same generator, so the receiver
+ * can regenerate what it should see next
+ */
+static int sink_apply(uint8_t type, const uint8_t *val, uint8_t len, void *ctx)
+{
+    struct sink *s = ctx;
+    uint32_t keep = rng;
+    uint8_t et, ev[CMDP_VAL_MAX];
+
+    rng = s->seed;
+    uint8_t el = random_cmd(&et, ev);
+
+    s->seed = rng;
+    rng = keep;
+
+    if (!s->why && (type != et || len != el || memcmp(val, ev, len) != 0)) {
+        s->why = "command applied out of order or twice";
+    }
+    s->n++;
+    /* Some rejections, to carry NAKs */
+    return s->n % 97 == 0 ? -EINVAL : 0;
+}
+
+static int loopback(unsigned int loss_pct)
+{
+    struct cmdp_tx tx;
+    struct cmdp_rx rx;
+    struct sink sink = { .seed = 0x1234567 };
+    uint32_t gen = sink.seed;
+    uint8_t frame[256], ack[64];
+    uint32_t queued = 0, t = 0, lost = 0, acks_lost = 0, naks = 0;
+    const char *why = NULL;
+
+    cmdp_tx_init(&tx);
+    cmdp_rx_init(&rx);
+
+    while ((sink.n < LOOP_CMDS || cmdp_tx_pending(&tx)) && t < 600000) {
+        /* Keep the window full, as a burst of parameter updates would */
+        while (queued < LOOP_CMDS && cmdp_tx_pending(&tx) < CMDP_WINDOW) {
+            uint8_t type, val[CMDP_VAL_MAX];
+            uint32_t keep = rng;
+
+            rng = gen;
+            uint8_t len = random_cmd(&type, val);
+
+            gen = rng;
+            rng = keep;
+            if (cmdp_tx_queue(&tx, type, val, len) < 0) {
+                why = "queue failed with room in the window";
+                break;
+            }
+            queued++;
+        }
+
+        for (int i = 0; i < FRAMES_PER_TICK; i++) {
+            uint8_t n;
+            size_t len = cmdp_tx_frame(&tx, t, frame, payload, &n);
+
+            if (len == 0) {
+                break;
+            }
+            cmdp_tx_sent(&tx, n, t);
+            if (rnd() % 100 < loss_pct) {
+                lost++;
+                continue;
+            }
+            cmdp_rx_frame(&rx, frame, len, sink_apply, &sink);
+        }
+
+        /* One ACK per connection event, for everything received in it */
+        size_t alen = cmdp_rx_ack(&rx, ack, sizeof(ack));
+
+        if (alen) {
+            if (rnd() % 100 < loss_pct) {
+                acks_lost++;
+            } else if (cmdp_tx_ack(&tx, ack, alen, t) < 0) {
+                why = "valid ACK rejected";
+            }
+        }
+        t += TICK_MS;
+    }
+    naks = tx.naks;
+
+    if (!why) {
+        why = sink.why;
+    }
+    if (!why && sink.n != LOOP_CMDS) {
+        why = "not every command applied";
+    }
+    if (!why && cmdp_tx_pending(&tx) != 0) {
+        why = "commands left unacknowledged";
+    }
+    /* NAKs ride on ACKs and are not resent */
+    if (!why && loss_pct == 0 && naks != LOOP_CMDS / 97) {
+        why = "NAKs lost";
+    }
+
+    printf("loss %2u%%   %5u cmds  %5u frames (%4u lost)  %4u resends  %3u/%u dup/gap"
+           "  %5u ms  %5.1f cmds/frame %s%s\n",
+           loss_pct, sink.n, tx.frames, lost, tx.resends, rx.dups, rx.gaps, t,
+           (double)sink.n / tx.frames, why ? " FAIL: " : "", why ? why : "");
+    if (verbose) {
+        printf("           %u ACKs lost, %u NAKs\n", acks_lost, naks);
+    }
+    return why != NULL;
+}
+
+/* ===== Fuzz ===== */
+
+static int fuzz_apply(uint8_t type, const uint8_t *val, uint8_t len, void *ctx)
+{
+    const char **why = ctx;
+
+    if (cmdp_type_len(type) != len && !*why) {
+        *why = "command applied with the wrong length";
+    }
+    /* Touch every byte of the value */
+    volatile uint8_t sum = 0;
+
+    for (uint8_t i = 0; i < len; i++) {
+        sum += val[i];
+    }
+    return 0;
+}
+
+static int fuzz(uint32_t iters)
+{
+    struct cmdp_rx rx;
+    struct cmdp_tx tx;
+    const char *why = NULL;
+    uint8_t valid[256];
+    size_t valid_len;
+
+    cmdp_rx_init(&rx);
+    cmdp_tx_init(&tx);
+
+    /* A valid frame to mutate */
+    {
+        struct cmdp_writer w;
+        uint8_t type, val[CMDP_VAL_MAX];
+
+        cmdp_writer_init(&w, valid, payload);
+        for (uint8_t seq = 0;; seq++) {
+            uint8_t len = random_cmd(&type, val);
+
+            if (cmdp_put(&w, seq, type, val, len) < 0) {
+                break;
+            }
+        }
+        valid_len = w.len;
+    }
+
+    for (uint32_t i = 0; i < iters && !why; i++) {
+        size_t len = rnd() % (payload + 1);
+        uint8_t *f = malloc(len ? len : 1);     /* exact size for the sanitizers */
+
+        if (i & 1) {
+            for (size_t k = 0; k < len; k++) {
+                f[k] = (uint8_t)rnd();
+            }
+            if (len) {
+                f[0] = CMDP_VERSION;
+            }
+        } else {
+            len = len < valid_len ? len : valid_len;
+            memcpy(f, valid, len);
+            for (int k = rnd() % 4; k >= 0 && len; k--) {
+                f[rnd() % len] = (uint8_t)rnd();
+            }
+        }
+
+        /* Keep commands in flight, so random ACKs have a window to hit */
+        uint8_t frame[256], n;
+
+        while (cmdp_tx_queue(&tx, CMDP_T_HAPTIC_STOP, NULL, 0) >= 0) {
+        }
+        if (cmdp_tx_frame(&tx, i, frame, payload, &n)) {
+            cmdp_tx_sent(&tx, n, i);
+        }
+
+        cmdp_rx_frame(&rx, f, len, fuzz_apply, &why);
+
+        uint8_t ack[64];
+        size_t alen = cmdp_rx_ack(&rx, ack, sizeof(ack));
+
+        cmdp_tx_ack(&tx, ack, alen, i);
+        cmdp_tx_ack(&tx, f, len, i);
+        free(f);
+
+        /* Sender state stays ordered: base <= send <= high <= end */
+        if (cmdp_seq_before(tx.send, tx.base) || cmdp_seq_before(tx.high, tx.send) ||
+            cmdp_seq_before(tx.end, tx.high)) {
+            why = "sender state out of order";
+        }
+    }
+
+    printf("%-10s %u frames, %u applied, %u errors %s%s\n", "fuzz", iters, rx.applied,
+           rx.errors, why ? "FAIL: " : "ok", why ? why : "");
+    return why != NULL;
+}
+
+/* ===== Throughput ===== */
+
+static int nop_apply(uint8_t type, const uint8_t *val, uint8_t len, void *ctx)
+{
+    (void)val;
+    *(uint32_t *)ctx += type + len;
+    return 0;
+}
+
+static void bench(void)
+{
+    const uint32_t frames = 200000;
+    struct cmdp_tx tx;
+    struct cmdp_rx rx;
+    uint8_t frame[256];
+    uint32_t cmds = 0, sink = 0;
+    uint64_t bytes = 0;
+    double t0, t_enc = 0, t_dec = 0;
+
+    cmdp_tx_init(&tx);
+    cmdp_rx_init(&rx);
+    for (uint32_t i = 0; i < frames; i++) {
+        uint8_t type, val[CMDP_VAL_MAX], n;
+
+        t0 = now_s();
+        while (cmdp_tx_pending(&tx) < CMDP_WINDOW) {
+            uint8_t len = random_cmd(&type, val);
+
+            cmdp_tx_queue(&tx, type, val, len);
+        }
+        size_t len = cmdp_tx_frame(&tx, i, frame, payload, &n);
+
+        cmdp_tx_sent(&tx, n, i);
+        t_enc += now_s() - t0;
+
+        t0 = now_s();
+        cmdp_rx_frame(&rx, frame, len, nop_apply, &sink);
+
+        uint8_t ack[64];
+        size_t alen = cmdp_rx_ack(&rx, ack, sizeof(ack));
+
+        cmdp_tx_ack(&tx, ack, alen, i);
+        t_dec += now_s() - t0;
+
+        cmds += n;
+        bytes += len;
+    }
+    printf("%-10s %u frames of %zu B max, %.1f cmds/frame\n", "bench", frames, payload,
+           (double)cmds / frames);
+    printf("           encode %7.1f MB/s %6.2f Mcmd/s\n", bytes / t_enc / 1e6, cmds / t_enc / 1e6);
+    printf("           decode %7.1f MB/s %6.2f Mcmd/s (incl. ACK)  [%u]\n",
+           bytes / t_dec / 1e6, cmds / t_dec / 1e6, sink & 1);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t fuzz_iters = 200000;
+    int do_bench = 0;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--mtu") && i + 1 < argc) {
+            long mtu = strtol(argv[++i], NULL, 0);
+
+            if (mtu < 23 || mtu > 247) {
+                fprintf(stderr, "--mtu must be 23..247\n");
+                return 2;
+            }
+            payload = (size_t)mtu - 3;
+        } else if (!strcmp(argv[i], "--fuzz") && i + 1 < argc) {
+            fuzz_iters = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            rng = (uint32_t)strtoul(argv[++i], NULL, 0) | 1;
+        } else if (!strcmp(argv[i], "--bench")) {
+            do_bench = 1;
+        } else if (!strcmp(argv[i], "-v")) {
+            verbose = 1;
+        } else {
+            fprintf(stderr, "usage: %s [--mtu N] [--fuzz N] [--seed N] [--bench] [-v]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    failed |= check_codec();
+    failed |= loopback(0);
+    failed |= loopback(5);
+    failed |= loopback(20);
+    failed |= loopback(50);
+    failed |= fuzz(fuzz_iters);
+    if (do_bench) {
+        bench();
+    }
+    return failed;
+}
@@ -0,0 +1,393 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Replay a recorded sensor trace (src/trace_wire.h) through the firmware's
+ * decision code as fast as the host allows.
+ *
+ *   JLinkRTTLogger -Device NRF5340_XXAA_APP -RTTChannel 2 wear.trc
+ *   replay [--out decisions.txt] [--golden decisions.txt] [--prof] wear.trc
+ *
+ * Each recorded FIFO batch goes through ctrl_logic (fusion + posture, as in
+ * control.c), and the Peltier tick (peltier_pi_tick, as in peltier_ctrl.c)
+ * runs on the trace clock at the default rate with the latest ADC values.
+ * Parameters are the Kconfig defaults.
+ *
+ * Every change in the actuator decisions is written as one line:
+ *
+ *   <t_s> posture SLOUCH_START|DWELL_EXCEEDED|RECOVERED
+ *   <t_s> cue 0|1
+ *   <t_s> activity still|walking|nodding|vehicle
+ *   <t_s> peltier <duty permille>
+ *
+ * --golden compares those lines with an earlier run and reports the first
+ * differences; exit status is 1 if any line differs. Throughput and the
+ * time spent per stage are printed to stderr; --prof adds the latency
+ * histograms of the firmware probes (src/prof.h) that ran on the host.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ctrl_logic.h"
+#include "peltier_pi.h"
+#include "prof.h"
+#include "thermistor.h"
+#include "trace_wire.h"
+
+/* ===== Kconfig defaults ===== */
+#define FUSION_BETA             0.1f
+#define PELTIER_TICK_HZ         10
+#define PELTIER_SETPOINT_CDEG   3800
+#define PELTIER_CUTOFF_CDEG     4500
+#define SENSE_MA_PER_V          1000
+
+#define BATCH_MAX               256
+#define LINE_MAX                64
+#define DIFF_SHOW               5
+
+static const struct posture_params posture_defaults = {
+    .enter_deg = 15.0f,
+    .exit_deg = 8.0f,
+    .enter_dwell_ms = 3000,
+    .exit_dwell_ms = 1500,
+    .alert_ms = 30000,
+    .baseline_tau_s = 300.0f,
+    .warmup_ms = 5000,
+    .baseline_limit_deg = 30.0f,
+};
+
+static const struct calib_params calib_defaults = {
+    .window_ms = 1000,
+    .gyr_still_dps = 0.3f,
+    .acc_still_mg = 8.0f,
+    .bias_max_dps = 3.0f,
+    .bias_windows = 32,
+};
+
+static const struct peltier_pi_params peltier_defaults = {
+    .kp = 0.25f,
+    .ki = 0.02f,
+    .dt_s = 1.0f / PELTIER_TICK_HZ,
+    .out_max = 0.8f,
+    .slew_per_s = 0.2f,
+    .current_limit_a = 0.6f,
+    .min_cdeg = 500,
+    .max_cdeg = 10000,
+};
+
+/* ===== Stage timing ===== */
+enum stage { ST_DECODE, ST_CONTROL, ST_THERMAL, ST_COUNT };
+
+static const char *const stage_names[ST_COUNT] = { "decode", "control", "thermal" };
+
+struct stage_time {
+    unsigned long long total_ns;
+    unsigned long long max_ns;
+    unsigned long calls;
+};
+
+static struct stage_time stage[ST_COUNT];
+
+static unsigned long long now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void stage_add(enum stage st, unsigned long long ns)
+{
+    stage[st].total_ns += ns;
+    stage[st].calls++;
+    if (ns > stage[st].max_ns) {
+        stage[st].max_ns = ns;
+    }
+}
+
+/* ===== Decision log and golden comparison ===== */
+struct out_log {
+    FILE *out;
+    FILE *golden;
+    unsigned long lines;
+    unsigned long diffs;
+};
+
+static void emit(struct out_log *log, uint64_t t_us, const char *what, const char *val)
+{
+    char line[LINE_MAX];
+    char ref[LINE_MAX];
+
+    snprintf(line, sizeof(line), "%llu.%03llu %s %s\n", (unsigned long long)(t_us / 1000000),
+             (unsigned long long)(t_us / 1000 % 1000), what, val);
+    log->lines++;
+    if (log->out) {
+        fputs(line, log->out);
+    }
+    if (!log->golden) {
+        return;
+    }
+    if (!fgets(ref, sizeof(ref), log->golden)) {
+        strcpy(ref, "<end of golden>\n");
+    }
+    if (strcmp(line, ref) != 0) {
+        if (log->diffs++ < DIFF_SHOW) {
+            fprintf(stderr, "line %lu:\n  golden: %s  replay: %s", log->lines, ref, line);
+        }
+    }
+}
+
+/* ===== Replay ===== */
+static uint8_t *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    uint8_t *buf;
+    long n;
+
+    if (!f || fseek(f, 0, SEEK_END) != 0 || (n = ftell(f)) < 0) {
+        perror(path);
+        return NULL;
+    }
+    rewind(f);
+    buf = malloc(n > 0 ? (size_t)n : 1);
+    if (!buf || fread(buf, 1, (size_t)n, f) != (size_t)n) {
+        perror(path);
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *len = (size_t)n;
+    return buf;
+}
+
+int main(int argc, char **argv)
+{
+    const char *trace_path = NULL;
+    struct out_log log = { 0 };
+    struct trace_hdr hdr;
+    bool show_prof = false;
+    size_t len;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && !strcmp(argv[i], "--out")) {
+            log.out = fopen(argv[++i], "w");
+            if (!log.out) {
+                perror(argv[i]);
+                return 2;
+            }
+        } else if (i + 1 < argc && !strcmp(argv[i], "--golden")) {
+            log.golden = fopen(argv[++i], "r");
+            if (!log.golden) {
+                perror(argv[i]);
+                return 2;
+            }
+        } else if (!strcmp(argv[i], "--prof")) {
+            show_prof = true;
+        } else if (argv[i][0] != '-' && !trace_path) {
+            trace_path = argv[i];
+        } else {
+            trace_path = NULL;
+            break;
+        }
+    }
+    if (!trace_path) {
+        fprintf(stderr, "usage: %s [--out FILE] [--golden FILE] [--prof] trace.trc\n", argv[0]);
+        return 2;
+    }
+
+    uint8_t *buf = read_file(trace_path, &len);
+
+    if (!buf) {
+        return 2;
+    }
+    if (len < sizeof(hdr) || memcmp(buf, TRACE_MAGIC, 4) != 0 ||
+        (memcpy(&hdr, buf, sizeof(hdr)), hdr.version != TRACE_VERSION) || hdr.odr_hz == 0) {
+        fprintf(stderr, "%s: not a version %d sensor trace\n", trace_path, TRACE_VERSION);
+        return 2;
+    }
+
+    static struct imu_sample batch[BATCH_MAX];
+    struct ctrl_logic logic;
+    struct peltier_pi pi;
+    struct trace_dec dec = { 0 };
+    struct trace_item it;
+    size_t n = 0, pos = sizeof(hdr);
+    unsigned long samples = 0, batches = 0, records = 0, bad = 0;
+    int16_t therm = -1, aux = -1;
+    bool cue = false;
+    enum activity_class activity = ACTIVITY_STILL;
+    uint16_t duty = 0;
+    uint64_t t_us = 0, t_first = 0, next_tick = 0;
+    uint32_t last_raw = 0;
+    bool started = false;
+    const uint64_t tick_us = 1000000 / PELTIER_TICK_HZ;
+
+    prof_init();
+    ctrl_logic_init(&logic, FUSION_BETA, 1.0f / hdr.odr_hz, &posture_defaults,
+                    &calib_defaults);
+    peltier_pi_init(&pi, &peltier_defaults);
+
+    unsigned long long wall0 = now_ns();
+
+    while (pos < len) {
+        bool have;
+        unsigned long long t0;
+        int used = trace_dec_next(&dec, buf + pos, len - pos, &it, &have);
+
+        if (used == 0) {
+            break;          /* truncated last record */
+        }
+        if (used < 0) {
+            bad++;          /* skip a byte and look for the next tag */
+            pos++;
+            continue;
+        }
+        pos += (size_t)used;
+        if (!have) {
+            continue;
+        }
+
+        /* 64-bit trace clock, so hours of trace survive the t_us wrap */
+        if (!started) {
+            started = true;
+            last_raw = it.t_us;
+            t_first = t_us = it.t_us;
+            next_tick = t_us + tick_us;
+        }
+        t_us += (uint32_t)(it.t_us - last_raw);
+        last_raw = it.t_us;
+        records++;
+
+        /* Peltier ticks that fell due before this record */
+        while (next_tick <= t_us) {
+            int16_t temp = INT16_MIN, cur_ma = -1;
+
+            t0 = now_ns();
+            PROF_START(PROF_PELTIER_TICK);
+            if (therm >= 0) {
+                PROF_START(PROF_THERMISTOR);
+                temp = thermistor_cdeg_from_code(therm);
+                PROF_STOP(PROF_THERMISTOR);
+            }
+            if (aux >= 0) {
+                cur_ma = (int16_t)((int32_t)aux * hdr.adc_full_scale_mv / 4096 *
+                                   SENSE_MA_PER_V / 1000);
+            }
+            float d = peltier_pi_tick(&pi, cue, PELTIER_SETPOINT_CDEG, PELTIER_CUTOFF_CDEG,
+                                      temp, cur_ma);
+            uint16_t permille = (uint16_t)(d * 1000.0f + 0.5f);
+
+            PROF_STOP(PROF_PELTIER_TICK);
+            stage_add(ST_THERMAL, now_ns() - t0);
+            if (permille != duty) {
+                char val[8];
+
+                duty = permille;
+                snprintf(val, sizeof(val), "%u", duty);
+                emit(&log, next_tick - t_first, "peltier", val);
+            }
+            next_tick += tick_us;
+        }
+
+        if (it.tag == TRACE_TAG_IMU) {
+            if (n < BATCH_MAX) {
+                batch[n++] = it.imu;
+            }
+            samples++;
+            continue;
+        }
+
+        /* An ADC record closes each recorded batch */
+        therm = it.therm;
+        aux = it.aux;
+        if (n == 0) {
+            continue;
+        }
+
+        struct ctrl_decision dcs;
+
+        t0 = now_ns();
+        PROF_START(PROF_CONTROL_STEP);
+        ctrl_logic_step(&logic, batch, n, &dcs);
+        PROF_STOP(PROF_CONTROL_STEP);
+        stage_add(ST_CONTROL, now_ns() - t0);
+        batches++;
+        n = 0;
+
+        if (dcs.ev != POSTURE_EV_NONE) {
+            emit(&log, t_us - t_first, "posture", posture_event_name(dcs.ev));
+        }
+        if (dcs.activity != activity) {
+            activity = dcs.activity;
+            emit(&log, t_us - t_first, "activity", activity_class_name(activity));
+        }
+        if (dcs.cue != cue) {
+            cue = dcs.cue;
+            emit(&log, t_us - t_first, "cue", cue ? "1" : "0");
+        }
+    }
+
+    unsigned long long wall_ns = now_ns() - wall0;
+    double wall_s = wall_ns / 1e9;
+
+    /* Decoding is too cheap to time per record; it gets what is left */
+    stage[ST_DECODE].calls = records;
+    stage[ST_DECODE].total_ns = wall_ns - stage[ST_CONTROL].total_ns - stage[ST_THERMAL].total_ns;
+    double trace_s = (t_us - t_first) / 1e6;
+
+    if (log.golden) {
+        char ref[LINE_MAX];
+
+        while (fgets(ref, sizeof(ref), log.golden)) {
+            if (log.diffs++ < DIFF_SHOW) {
+                fprintf(stderr, "golden has more lines: %s", ref);
+            }
+        }
+    }
+
+    fprintf(stderr, "trace     %.1f s, %lu samples in %lu batches, %lu bad bytes\n",
+            trace_s, samples, batches, bad);
+    fprintf(stderr, "replay    %.3f s wall, %.0f samples/s, %.0fx real time\n",
+            wall_s, wall_s > 0 ? samples / wall_s : 0.0, wall_s > 0 ? trace_s / wall_s : 0.0);
+    fprintf(stderr, "%-9s %10s %10s %10s %10s\n", "stage", "calls", "total ms", "mean ns", "max ns");
+    for (int s = 0; s < ST_COUNT; s++) {
+        fprintf(stderr, "%-9s %10lu %10.1f %10.0f", stage_names[s], stage[s].calls,
+                stage[s].total_ns / 1e6,
+                stage[s].calls ? (double)stage[s].total_ns / stage[s].calls : 0.0);
+        if (s == ST_DECODE) {
+            fprintf(stderr, " %10s\n", "-");
+        } else {
+            fprintf(stderr, " %10llu\n", stage[s].max_ns);
+        }
+    }
+    fprintf(stderr, "decisions %lu lines", log.lines);
+    if (log.golden) {
+        fprintf(stderr, ", %lu differ from golden", log.diffs);
+    }
+    fprintf(stderr, "\n");
+
+    if (show_prof) {
+        fprintf(stderr, "%-11s %10s %8s %8s %8s %8s %8s %8s\n", "probe", "count", "min ns",
+                "mean ns", "p50 ns", "p90 ns", "p99 ns", "max ns");
+        for (int p = 0; p < PROF_COUNT; p++) {
+            struct prof_summary s;
+
+            prof_summary_get(p, &s);
+            if (s.count) {
+                fprintf(stderr, "%-11s %10u %8u %8u %8u %8u %8u %8u\n", prof_probe_name(p),
+                        s.count, s.min_ns, s.mean_ns, s.p50_ns, s.p90_ns, s.p99_ns, s.max_ns);
+            }
+        }
+    }
+
+    free(buf);
+    if (log.out) {
+        fclose(log.out);
+    }
+    if (log.golden) {
+        fclose(log.golden);
+    }
+    return log.diffs ? 1 : 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Write a synthetic sensor trace (src/trace_wire.h) for tools/replay, so the
+ * replay path can be exercised and timed without a recorded wear session.
+ *
+ *   trace_synth [--hours H] [--seed N] out.trc
+ *
+ * The wearer sits at a neutral pitch of 5 deg with small sway, glances down
+ * now and then, and slouches to 20-35 deg for 10 s - 3 min every few
+ * minutes. Accel and gyro counts follow the pitch with sensor noise; the
+ * thermistor reads skin temperature around 33 C. 100 Hz, 10-frame batches,
+ * default NTC divider.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "imu_sample.h"
+#include "trace_wire.h"
+
+#define ODR_HZ          100
+#define WATERMARK       10
+#define FULL_SCALE_MV   3600
+#define VREF_MV         3000.0
+#define R_FIXED         10000.0
+#define R0              10000.0
+#define T0_K            298.15
+#define BETA            3950.0
+
+static uint32_t rng = 0x12345678;
+
+static double urand(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (rng >> 8) / 16777216.0;
+}
+
+static double noise(double amp)
+{
+    return (urand() * 2.0 - 1.0) * amp;
+}
+
+static int16_t therm_code(double temp_c)
+{
+    double r = R0 * exp(BETA * (1.0 / (temp_c + 273.15) - 1.0 / T0_K));
+    double mv = VREF_MV * r / (r + R_FIXED);
+
+    return (int16_t)(mv * 4096.0 / FULL_SCALE_MV + 0.5);
+}
+
+/* Pitch target over time: neutral with glances and slouch episodes */
+struct scene {
+    double until_s;
+    double target_deg;
+    double next_event_s;
+};
+
+static double next_target(struct scene *sc, double t)
+{
+    if (t >= sc->until_s) {
+        sc->target_deg = 5.0;
+        if (t >= sc->next_event_s) {
+            if (urand() < 0.4) {
+                /* Glance down at a phone */
+                sc->target_deg = 30.0 + noise(8.0);
+                sc->until_s = t + 0.5 + urand() * 2.0;
+            } else {
+                sc->target_deg = 27.5 + noise(7.5);
+                sc->until_s = t + 10.0 + urand() * 170.0;
+            }
+            sc->next_event_s = sc->until_s + 30.0 + urand() * 240.0;
+        }
+    }
+    return sc->target_deg;
+}
+
+int main(int argc, char **argv)
+{
+    double hours = 1.0;
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && !strcmp(argv[i], "--hours")) {
+            hours = atof(argv[++i]);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--seed")) {
+            rng = (uint32_t)strtoul(argv[++i], NULL, 0) | 1;
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            path = NULL;
+            break;
+        }
+    }
+    if (!path || hours <= 0) {
+        fprintf(stderr, "usage: %s [--hours H] [--seed N] out.trc\n", argv[0]);
+        return 2;
+    }
+
+    FILE *f = fopen(path, "wb");
+
+    if (!f) {
+        perror(path);
+        return 2;
+    }
+
+    const struct trace_hdr hdr = {
+        .magic = TRACE_MAGIC,
+        .version = TRACE_VERSION,
+        .odr_hz = ODR_HZ,
+        .watermark = WATERMARK,
+        .adc_full_scale_mv = FULL_SCALE_MV,
+    };
+    struct trace_enc enc = { 0 };
+    struct scene sc = { 0, 5.0, 20.0 };
+    uint8_t rec[TRACE_REC_MAX];
+    unsigned long total = (unsigned long)(hours * 3600.0 * ODR_HZ);
+    double pitch = 5.0, dt = 1.0 / ODR_HZ;
+    /* Start close to the 32-bit microsecond wrap, as a long session would */
+    uint32_t t_us = 0xF0000000u;
+
+    fwrite(&hdr, sizeof(hdr), 1, f);
+    for (unsigned long i = 0; i < total; i++) {
+        double t = i * dt;
+        double target = next_target(&sc, t) + 1.5 * sin(t * 0.7);
+        /* First-order head movement, ~0.3 s */
+        double rate = (target - pitch) / 0.3;
+        double th = (pitch += rate * dt) * M_PI / 180.0;
+        struct imu_sample s = { .t_us = t_us };
+
+        /* +X up the neck, flexion tilts it towards +Z */
+        s.acc[0] = (int16_t)(IMU_ACC_LSB_PER_G * cos(th) + noise(40));
+        s.acc[1] = (int16_t)noise(40);
+        s.acc[2] = (int16_t)(IMU_ACC_LSB_PER_G * sin(th) + noise(40));
+        s.gyr[0] = (int16_t)noise(8);
+        s.gyr[1] = (int16_t)(-rate * IMU_GYR_LSB_PER_DPS + noise(8));
+        s.gyr[2] = (int16_t)noise(8);
+        fwrite(rec, 1, trace_enc_imu(&enc, &s, rec), f);
+
+        if ((i + 1) % WATERMARK == 0) {
+            double skin_c = 33.0 + 0.5 * sin(t / 600.0) + noise(0.05);
+
+            fwrite(rec, 1, trace_enc_adc(&enc, t_us, therm_code(skin_c), (int16_t)(40 + noise(4)),
+                                         rec), f);
+        }
+        t_us += 1000000 / ODR_HZ;
+    }
+    fclose(f);
+    printf("%s: %lu samples, %.1f h\n", path, total, hours);
+    return 0;
+}
@@ -0,0 +1,14 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SAADC_CHECK_NRFX_GPPI_H_
+#define SAADC_CHECK_NRFX_GPPI_H_
+
+#include "../nrfx.h"
+
+nrfx_err_t nrfx_gppi_channel_alloc(uint8_t *channel);
+void nrfx_gppi_channel_endpoints_setup(uint8_t channel, uint32_t eep, uint32_t tep);
+void nrfx_gppi_channels_enable(uint32_t mask);
+
+#endif /* SAADC_CHECK_NRFX_GPPI_H_ */
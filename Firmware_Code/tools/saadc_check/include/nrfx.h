@@ -0,0 +1,26 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SAADC_CHECK_NRFX_H_
+#define SAADC_CHECK_NRFX_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== nrfx stand-in for tools/saadc_check =====
+ * Only what src/hw/adc_scan_saadc.c uses; the peripherals behind it are
+ * modelled in saadc_check.c.
+ */
+typedef enum {
+    NRFX_SUCCESS,
+    NRFX_ERROR_INTERNAL,
+    NRFX_ERROR_NO_MEM,
+    NRFX_ERROR_INVALID_STATE,
+    NRFX_ERROR_ALREADY,
+    NRFX_ERROR_INVALID_PARAM,
+} nrfx_err_t;
+
+void nrfx_isr(const void *irq_handler);
+
+#endif /* SAADC_CHECK_NRFX_H_ */
@@ -0,0 +1,130 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SAADC_CHECK_NRFX_SAADC_H_
+#define SAADC_CHECK_NRFX_SAADC_H_
+
+#include "nrfx.h"
+
+typedef int16_t nrf_saadc_value_t;
+
+typedef enum {
+    NRF_SAADC_INPUT_DISABLED,
+    NRF_SAADC_INPUT_AIN0,
+    NRF_SAADC_INPUT_AIN1,
+    NRF_SAADC_INPUT_AIN2,
+    NRF_SAADC_INPUT_AIN3,
+    NRF_SAADC_INPUT_AIN4,
+    NRF_SAADC_INPUT_AIN5,
+    NRF_SAADC_INPUT_AIN6,
+    NRF_SAADC_INPUT_AIN7,
+} nrf_saadc_input_t;
+
+typedef enum {
+    NRF_SAADC_GAIN1_6,
+    NRF_SAADC_GAIN1_5,
+    NRF_SAADC_GAIN1_4,
+    NRF_SAADC_GAIN1_3,
+    NRF_SAADC_GAIN1_2,
+    NRF_SAADC_GAIN1,
+} nrf_saadc_gain_t;
+
+typedef enum {
+    NRF_SAADC_REFERENCE_INTERNAL,
+    NRF_SAADC_REFERENCE_VDD4,
+} nrf_saadc_reference_t;
+
+typedef enum {
+    NRF_SAADC_BURST_DISABLED,
+    NRF_SAADC_BURST_ENABLED,
+} nrf_saadc_burst_t;
+
+typedef enum {
+    NRF_SAADC_RESOLUTION_8BIT,
+    NRF_SAADC_RESOLUTION_10BIT,
+    NRF_SAADC_RESOLUTION_12BIT,
+    NRF_SAADC_RESOLUTION_14BIT,
+} nrf_saadc_resolution_t;
+
+/* log2 of the conversions averaged per result */
+typedef uint8_t nrf_saadc_oversample_t;
+
+typedef enum {
+    NRF_SAADC_TASK_START,
+    NRF_SAADC_TASK_SAMPLE,
+    NRF_SAADC_TASK_STOP,
+} nrf_saadc_task_t;
+
+#define NRF_SAADC       ((void *)0x40007000)
+
+uint32_t nrf_saadc_task_address_get(void *reg, nrf_saadc_task_t task);
+
+typedef struct {
+    nrf_saadc_gain_t gain;
+    nrf_saadc_reference_t reference;
+    nrf_saadc_burst_t burst;
+} nrf_saadc_channel_config_t;
+
+typedef struct {
+    nrf_saadc_channel_config_t channel_config;
+    nrf_saadc_input_t pin_p;
+    nrf_saadc_input_t pin_n;
+    uint8_t channel_index;
+} nrfx_saadc_channel_t;
+
+#define NRFX_SAADC_DEFAULT_CHANNEL_SE(pin, index)                               \
+    {                                                                           \
+        .channel_config = { .gain = NRF_SAADC_GAIN1_6,                          \
+                            .reference = NRF_SAADC_REFERENCE_INTERNAL,          \
+                            .burst = NRF_SAADC_BURST_DISABLED },                \
+        .pin_p = (nrf_saadc_input_t)(pin),                                      \
+        .pin_n = NRF_SAADC_INPUT_DISABLED,                                      \
+        .channel_index = (index),                                               \
+    }
+
+typedef struct {
+    nrf_saadc_oversample_t oversampling;
+    uint16_t internal_timer_cc;
+    bool start_on_end;
+} nrfx_saadc_adv_config_t;
+
+#define NRFX_SAADC_DEFAULT_ADV_CONFIG                                           \
+    {                                                                           \
+        .oversampling = 0,                                                      \
+        .internal_timer_cc = 0,                                                 \
+        .start_on_end = false,                                                  \
+    }
+
+typedef enum {
+    NRFX_SAADC_EVT_DONE,
+    NRFX_SAADC_EVT_LIMIT,
+    NRFX_SAADC_EVT_CALIBRATEDONE,
+    NRFX_SAADC_EVT_BUF_REQ,
+    NRFX_SAADC_EVT_READY,
+    NRFX_SAADC_EVT_FINISHED,
+} nrfx_saadc_evt_type_t;
+
+typedef struct {
+    nrfx_saadc_evt_type_t type;
+    union {
+        struct {
+            nrf_saadc_value_t *p_buffer;
+            uint16_t size;
+        } done;
+    } data;
+} nrfx_saadc_evt_t;
+
+typedef void (*nrfx_saadc_event_handler_t)(const nrfx_saadc_evt_t *evt);
+
+nrfx_err_t nrfx_saadc_init(uint8_t interrupt_priority);
+nrfx_err_t nrfx_saadc_offset_calibrate(nrfx_saadc_event_handler_t handler);
+nrfx_err_t nrfx_saadc_channels_config(const nrfx_saadc_channel_t *channels, uint32_t count);
+nrfx_err_t nrfx_saadc_advanced_mode_set(uint32_t channel_mask, nrf_saadc_resolution_t resolution,
+                                        const nrfx_saadc_adv_config_t *config,
+                                        nrfx_saadc_event_handler_t handler);
+nrfx_err_t nrfx_saadc_buffer_set(nrf_saadc_value_t *buffer, uint16_t size);
+nrfx_err_t nrfx_saadc_mode_trigger(void);
+void nrfx_saadc_irq_handler(void);
+
+#endif /* SAADC_CHECK_NRFX_SAADC_H_ */
@@ -0,0 +1,54 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SAADC_CHECK_NRFX_TIMER_H_
+#define SAADC_CHECK_NRFX_TIMER_H_
+
+#include "nrfx.h"
+
+typedef struct {
+    uint8_t instance_id;
+} nrfx_timer_t;
+
+#define NRFX_TIMER_INSTANCE(id)     { .instance_id = (id) }
+
+typedef enum {
+    NRF_TIMER_BIT_WIDTH_16,
+    NRF_TIMER_BIT_WIDTH_8,
+    NRF_TIMER_BIT_WIDTH_24,
+    NRF_TIMER_BIT_WIDTH_32,
+} nrf_timer_bit_width_t;
+
+typedef enum {
+    NRF_TIMER_CC_CHANNEL0,
+    NRF_TIMER_CC_CHANNEL1,
+} nrf_timer_cc_channel_t;
+
+typedef enum {
+    NRF_TIMER_EVENT_COMPARE0,
+} nrf_timer_event_t;
+
+#define NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK     (1u << 0)
+
+typedef struct {
+    uint32_t frequency;
+    nrf_timer_bit_width_t bit_width;
+} nrfx_timer_config_t;
+
+#define NRFX_TIMER_DEFAULT_CONFIG(freq)                                         \
+    { .frequency = (freq), .bit_width = NRF_TIMER_BIT_WIDTH_16 }
+
+typedef void (*nrfx_timer_event_handler_t)(nrf_timer_event_t event, void *context);
+
+nrfx_err_t nrfx_timer_init(const nrfx_timer_t *timer, const nrfx_timer_config_t *config,
+                           nrfx_timer_event_handler_t handler);
+void nrfx_timer_extended_compare(const nrfx_timer_t *timer, nrf_timer_cc_channel_t channel,
+                                 uint32_t cc_value, uint32_t timer_short_mask, bool enable_int);
+uint32_t nrfx_timer_us_to_ticks(const nrfx_timer_t *timer, uint32_t time_us);
+uint32_t nrfx_timer_compare_event_address_get(const nrfx_timer_t *timer,
+                                              nrf_timer_cc_channel_t channel);
+void nrfx_timer_enable(const nrfx_timer_t *timer);
+void nrfx_timer_disable(const nrfx_timer_t *timer);
+
+#endif /* SAADC_CHECK_NRFX_TIMER_H_ */
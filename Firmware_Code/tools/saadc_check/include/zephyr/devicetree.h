@@ -0,0 +1,24 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SAADC_CHECK_DEVICETREE_H_
+#define SAADC_CHECK_DEVICETREE_H_
+
+#include <nrfx_saadc.h>
+
+/* ===== The &adc node of app.overlay, for src/hw/adc_scan_saadc.c ===== */
+#define DT_CAT(a, b)                    a##b
+#define DT_CAT3(a, b, c)                a##b##c
+#define DT_NODELABEL(label)             DT_N_##label
+#define DT_CHILD(node, child)           DT_CAT3(node, _, child)
+#define DT_PROP(node, prop)             DT_CAT3(node, _P_, prop)
+#define DT_IRQN(node)                   DT_CAT(node, _IRQN)
+#define DT_IRQ(node, cell)              DT_CAT3(node, _IRQ_, cell)
+
+#define DT_N_adc_IRQN                   7
+#define DT_N_adc_IRQ_priority           1
+#define DT_N_adc_channel_0_P_zephyr_input_positive  NRF_SAADC_INPUT_AIN0
+#define DT_N_adc_channel_1_P_zephyr_input_positive  NRF_SAADC_INPUT_AIN4
+
+#endif /* SAADC_CHECK_DEVICETREE_H_ */
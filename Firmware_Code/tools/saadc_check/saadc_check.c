@@ -0,0 +1,577 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Run the nRF SAADC scan backend (src/hw/adc_scan_saadc.c) and
+ * src/adc_stream.c against a model of the SAADC, TIMER2 and (D)PPI, on the
+ * host kernel in tools/zephyr_host.
+ *
+ *   saadc_check [-v]
+ *
+ * The model follows nrfx_saadc in advanced mode with start_on_end: two
+ * buffers are set before the trigger, a full buffer raises END, is handed
+ * to the driver as DONE and the hardware goes on in the buffer latched
+ * before; the next START raises BUF_REQ, answered with nrfx_saadc_buffer_set().
+ * A SAMPLE task stores one result per channel; with burst on it is the
+ * average of 2^oversampling conversions, without burst it takes that many
+ * SAMPLE tasks. TIMER2 compares fire SAMPLE only through an enabled PPI
+ * channel wired from the compare event to the SAMPLE task.
+ *
+ *   setup     both buffers set before the trigger, burst on every channel
+ *             with oversampling, the AIN inputs of app.overlay, 12 bit,
+ *             start_on_end, no internal timer, TIMER2 -> SAMPLE over PPI at
+ *             CONFIG_NECK_ADC_SCAN_RATE_HZ
+ *   swap      the buffers alternate; every BUF_REQ re-arms the buffer just
+ *             handed back, never the one filling, and the hardware never
+ *             runs out of a latched buffer
+ *   average   a steady input reads back as its code, a step straddling a
+ *             buffer as the rounded mean of its scans, conversion noise
+ *             averaged down to within a few codes
+ *   pause     the timer stops, no sample runs; after resuming the partly
+ *             filled buffer completes with the scans it kept
+ * Exit status is 1 if a case fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nrfx_saadc.h>
+#include <nrfx_timer.h>
+#include <helpers/nrfx_gppi.h>
+
+#include "zephyr_host.h"
+#include "adc_scan.h"
+#include "adc_stream.h"
+
+#define SCANS           CONFIG_NECK_ADC_SCANS_PER_BUFFER
+#define BUF_SAMPLES     (SCANS * ADC_SCAN_CHANNELS)
+#define CODE_MAX        4095
+
+#define TIMER2_CC0_EVENT    0x4000B140u
+#define SAADC_SAMPLE_TASK   0x40007004u
+
+static int verbose;
+
+/* ===== SAADC model ===== */
+static struct {
+    bool initialised;
+    bool triggered;
+    uint32_t channel_mask;
+    nrfx_saadc_channel_t ch[ADC_SCAN_CHANNELS];
+    nrf_saadc_resolution_t resolution;
+    nrfx_saadc_adv_config_t adv;
+    nrfx_saadc_event_handler_t handler;
+
+    nrf_saadc_value_t *filling;     /* RESULT.PTR of the running conversion */
+    nrf_saadc_value_t *latched;     /* RESULT.PTR for the next START */
+    uint16_t size;
+    uint16_t fill;
+    uint16_t bursts;                /* conversions summed without burst */
+    int32_t sum[ADC_SCAN_CHANNELS];
+
+    /* Inputs, as codes */
+    int code[ADC_SCAN_CHANNELS];
+    uint16_t noise;
+    uint32_t rng;
+
+    /* What the driver did */
+    uint32_t samples;
+    uint32_t done;
+    uint32_t buf_req;
+    uint32_t rearm_filling;         /* buffer_set() of the buffer being filled */
+    uint32_t rearm_other;           /* buffer_set() of a buffer not just handed back */
+    uint32_t starved;               /* START without a latched buffer */
+    nrf_saadc_value_t *last_done;
+    nrf_saadc_value_t *first[2];
+} adc = { .rng = 0x2545F491 };
+
+static int convert(int ch)
+{
+    int code = adc.code[ch];
+
+    if (adc.noise) {
+        adc.rng ^= adc.rng << 13;
+        adc.rng ^= adc.rng >> 17;
+        adc.rng ^= adc.rng << 5;
+        code += (int)(adc.rng % (2u * adc.noise + 1)) - adc.noise;
+    }
+    return CLAMP(code, 0, CODE_MAX);
+}
+
+static void event(nrfx_saadc_evt_type_t type, nrf_saadc_value_t *buf, uint16_t size)
+{
+    nrfx_saadc_evt_t evt = { .type = type };
+
+    evt.data.done.p_buffer = buf;
+    evt.data.done.size = size;
+    adc.handler(&evt);
+}
+
+/* START: RESULT.PTR latched before goes live, the driver is asked for the
+ * one after it
+ */
+static void start(void)
+{
+    if (!adc.latched) {
+        adc.starved++;
+        return;
+    }
+    adc.filling = adc.latched;
+    adc.latched = NULL;
+    adc.fill = 0;
+    adc.buf_req++;
+    event(NRFX_SAADC_EVT_BUF_REQ, NULL, 0);
+}
+
+/* SAMPLE task */
+static void sample(void)
+{
+    int os = adc.adv.oversampling;
+
+    if (!adc.triggered || !adc.filling) {
+        return;
+    }
+    adc.samples++;
+
+    /* Burst runs all 2^os conversions on one SAMPLE, otherwise it takes
+     * that many SAMPLE tasks per result
+     */
+    int per_task = adc.ch[0].channel_config.burst == NRF_SAADC_BURST_ENABLED ? 1 << os : 1;
+
+    for (int ch = 0; ch < ADC_SCAN_CHANNELS; ch++) {
+        for (int i = 0; i < per_task; i++) {
+            adc.sum[ch] += convert(ch);
+        }
+    }
+    adc.bursts += per_task;
+    if (adc.bursts < (1u << os)) {
+        return;
+    }
+    for (int ch = 0; ch < ADC_SCAN_CHANNELS; ch++) {
+        adc.filling[adc.fill++] = (nrf_saadc_value_t)(adc.sum[ch] >> os);
+        adc.sum[ch] = 0;
+    }
+    adc.bursts = 0;
+
+    if (adc.fill == adc.size) {
+        /* END, then START through the short when start_on_end is set */
+        nrf_saadc_value_t *done = adc.filling;
+
+        adc.filling = NULL;
+        adc.done++;
+        adc.last_done = done;
+        event(NRFX_SAADC_EVT_DONE, done, adc.size);
+        if (adc.adv.start_on_end) {
+            start();
+        }
+    }
+}
+
+uint32_t nrf_saadc_task_address_get(void *reg, nrf_saadc_task_t task)
+{
+    ARG_UNUSED(reg);
+    return task == NRF_SAADC_TASK_SAMPLE ? SAADC_SAMPLE_TASK : 0;
+}
+
+nrfx_err_t nrfx_saadc_init(uint8_t interrupt_priority)
+{
+    ARG_UNUSED(interrupt_priority);
+    adc.initialised = true;
+    return NRFX_SUCCESS;
+}
+
+nrfx_err_t nrfx_saadc_offset_calibrate(nrfx_saadc_event_handler_t handler)
+{
+    ARG_UNUSED(handler);
+    return adc.initialised ? NRFX_SUCCESS : NRFX_ERROR_INVALID_STATE;
+}
+
+nrfx_err_t nrfx_saadc_channels_config(const nrfx_saadc_channel_t *channels, uint32_t count)
+{
+    if (count != ADC_SCAN_CHANNELS) {
+        return NRFX_ERROR_INVALID_PARAM;
+    }
+    memcpy(adc.ch, channels, sizeof(adc.ch));
+    return NRFX_SUCCESS;
+}
+
+nrfx_err_t nrfx_saadc_advanced_mode_set(uint32_t channel_mask, nrf_saadc_resolution_t resolution,
+                                        const nrfx_saadc_adv_config_t *config,
+                                        nrfx_saadc_event_handler_t handler)
+{
+    adc.channel_mask = channel_mask;
+    adc.resolution = resolution;
+    adc.adv = *config;
+    adc.handler = handler;
+    return NRFX_SUCCESS;
+}
+
+nrfx_err_t nrfx_saadc_buffer_set(nrf_saadc_value_t *buffer, uint16_t size)
+{
+    if (adc.triggered) {
+        if (buffer == adc.filling) {
+            adc.rearm_filling++;
+        } else if (buffer != adc.last_done) {
+            adc.rearm_other++;
+        }
+    }
+    if (!adc.first[0]) {
+        adc.first[0] = buffer;
+    } else if (!adc.first[1]) {
+        adc.first[1] = buffer;
+    }
+    /* Before the trigger: primary, then secondary */
+    if (!adc.triggered && !adc.filling) {
+        adc.filling = buffer;
+    } else if (!adc.latched) {
+        adc.latched = buffer;
+    } else {
+        return NRFX_ERROR_ALREADY;
+    }
+    adc.size = size;
+    return NRFX_SUCCESS;
+}
+
+nrfx_err_t nrfx_saadc_mode_trigger(void)
+{
+    if (!adc.handler || !adc.filling) {
+        return NRFX_ERROR_INVALID_STATE;
+    }
+    adc.triggered = true;
+    adc.fill = 0;
+    return NRFX_SUCCESS;
+}
+
+void nrfx_saadc_irq_handler(void)
+{
+}
+
+void nrfx_isr(const void *irq_handler)
+{
+    ARG_UNUSED(irq_handler);
+}
+
+/* ===== TIMER2 and PPI model ===== */
+static void timer_fn(struct k_timer *t);
+static K_TIMER_DEFINE(timer2, timer_fn, NULL);
+
+static struct {
+    uint32_t frequency;
+    nrf_timer_bit_width_t bit_width;
+    uint32_t cc0_ticks;
+    uint32_t shorts;
+    bool enabled;
+    bool enabled_triggered;         /* enabled once the SAADC was triggered */
+    uint32_t ppi_eep;
+    uint32_t ppi_tep;
+    bool ppi_enabled;
+    bool ppi_allocated;
+} hw;
+
+static void timer_fn(struct k_timer *t)
+{
+    ARG_UNUSED(t);
+    if (hw.ppi_enabled && hw.ppi_eep == TIMER2_CC0_EVENT && hw.ppi_tep == SAADC_SAMPLE_TASK) {
+        sample();
+    }
+}
+
+nrfx_err_t nrfx_timer_init(const nrfx_timer_t *timer, const nrfx_timer_config_t *config,
+                           nrfx_timer_event_handler_t handler)
+{
+    ARG_UNUSED(handler);
+    if (timer->instance_id != 2) {
+        return NRFX_ERROR_INVALID_PARAM;
+    }
+    hw.frequency = config->frequency;
+    hw.bit_width = config->bit_width;
+    return NRFX_SUCCESS;
+}
+
+void nrfx_timer_extended_compare(const nrfx_timer_t *timer, nrf_timer_cc_channel_t channel,
+                                 uint32_t cc_value, uint32_t timer_short_mask, bool enable_int)
+{
+    ARG_UNUSED(timer);
+    ARG_UNUSED(enable_int);
+    if (channel == NRF_TIMER_CC_CHANNEL0) {
+        hw.cc0_ticks = cc_value;
+        hw.shorts = timer_short_mask;
+    }
+}
+
+uint32_t nrfx_timer_us_to_ticks(const nrfx_timer_t *timer, uint32_t time_us)
+{
+    ARG_UNUSED(timer);
+    return (uint32_t)((uint64_t)time_us * hw.frequency / 1000000u);
+}
+
+uint32_t nrfx_timer_compare_event_address_get(const nrfx_timer_t *timer,
+                                              nrf_timer_cc_channel_t channel)
+{
+    return timer->instance_id == 2 && channel == NRF_TIMER_CC_CHANNEL0 ? TIMER2_CC0_EVENT : 0;
+}
+
+void nrfx_timer_enable(const nrfx_timer_t *timer)
+{
+    ARG_UNUSED(timer);
+    /* Compare-and-clear: one event every cc0 ticks */
+    uint32_t period_us = (uint32_t)((uint64_t)hw.cc0_ticks * 1000000u / hw.frequency);
+
+    if (!hw.enabled && (hw.shorts & NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK)) {
+        k_timer_start(&timer2, K_USEC(period_us), K_USEC(period_us));
+    }
+    hw.enabled = true;
+    hw.enabled_triggered |= adc.triggered;
+}
+
+void nrfx_timer_disable(const nrfx_timer_t *timer)
+{
+    ARG_UNUSED(timer);
+    k_timer_stop(&timer2);
+    hw.enabled = false;
+}
+
+nrfx_err_t nrfx_gppi_channel_alloc(uint8_t *channel)
+{
+    if (hw.ppi_allocated) {
+        return NRFX_ERROR_NO_MEM;
+    }
+    hw.ppi_allocated = true;
+    *channel = 3;
+    return NRFX_SUCCESS;
+}
+
+void nrfx_gppi_channel_endpoints_setup(uint8_t channel, uint32_t eep, uint32_t tep)
+{
+    if (channel == 3) {
+        hw.ppi_eep = eep;
+        hw.ppi_tep = tep;
+    }
+}
+
+void nrfx_gppi_channels_enable(uint32_t mask)
+{
+    hw.ppi_enabled = (mask & BIT(3)) != 0;
+}
+
+/* ===== Cases ===== */
+static int code_of(int mv)
+{
+    return (int)(((int64_t)mv << 12) / CONFIG_NECK_ADC_FULL_SCALE_MV);
+}
+
+static uint32_t buffers(void)
+{
+    struct adc_stream_stats st;
+
+    adc_stream_stats_get(&st);
+    return st.buffers;
+}
+
+/* Let the timer run until the buffer being filled is handed over */
+static void complete_buffer(void)
+{
+    uint32_t done = adc.done;
+
+    adc_stream_pause(false);
+    while (adc.done == done) {
+        zephyr_host_advance_us(1000000 / CONFIG_NECK_ADC_SCAN_RATE_HZ);
+    }
+    adc_stream_pause(true);
+}
+
+static const char *case_setup(void)
+{
+    if (!adc.first[0] || !adc.first[1] || adc.first[0] == adc.first[1] ||
+        adc.size != BUF_SAMPLES) {
+        return "two distinct buffers not set before the trigger";
+    }
+    if (!adc.triggered) {
+        return "not triggered";
+    }
+    for (int ch = 0; ch < ADC_SCAN_CHANNELS; ch++) {
+        const nrf_saadc_channel_config_t *c = &adc.ch[ch].channel_config;
+
+        if (c->gain != NRF_SAADC_GAIN1_6 || c->reference != NRF_SAADC_REFERENCE_INTERNAL) {
+            return "front end not gain 1/6, internal reference";
+        }
+        if ((c->burst == NRF_SAADC_BURST_ENABLED) != (CONFIG_NECK_ADC_OVERSAMPLE_LOG2 > 0)) {
+            return "burst does not follow oversampling";
+        }
+    }
+    if (adc.ch[0].pin_p != NRF_SAADC_INPUT_AIN0 || adc.ch[1].pin_p != NRF_SAADC_INPUT_AIN4) {
+        return "inputs not those of app.overlay";
+    }
+    if (adc.channel_mask != 0x3 || adc.resolution != NRF_SAADC_RESOLUTION_12BIT ||
+        adc.adv.oversampling != CONFIG_NECK_ADC_OVERSAMPLE_LOG2 || !adc.adv.start_on_end ||
+        adc.adv.internal_timer_cc != 0) {
+        return "advanced mode settings";
+    }
+    if (!hw.enabled_triggered || !hw.ppi_enabled || hw.ppi_eep != TIMER2_CC0_EVENT ||
+        hw.ppi_tep != SAADC_SAMPLE_TASK) {
+        return "TIMER2 compare not wired to SAMPLE";
+    }
+    if (hw.cc0_ticks * (uint64_t)CONFIG_NECK_ADC_SCAN_RATE_HZ != hw.frequency ||
+        hw.bit_width != NRF_TIMER_BIT_WIDTH_32) {
+        return "trigger rate";
+    }
+    return NULL;
+}
+
+static const char *case_swap(void)
+{
+    uint32_t done = adc.done, published = buffers();
+    nrf_saadc_value_t *expect = adc.first[0];
+
+    adc_stream_pause(false);
+    for (int b = 0; b < 100; b++) {
+        uint32_t d = adc.done;
+
+        while (adc.done == d) {
+            zephyr_host_advance_us(1000000 / CONFIG_NECK_ADC_SCAN_RATE_HZ);
+        }
+        if (adc.last_done != expect) {
+            adc_stream_pause(true);
+            return "buffers handed back out of turn";
+        }
+        expect = expect == adc.first[0] ? adc.first[1] : adc.first[0];
+    }
+    adc_stream_pause(true);
+
+    if (verbose) {
+        printf("  %u samples, %u DONE, %u BUF_REQ\n", adc.samples, adc.done, adc.buf_req);
+    }
+    if (adc.rearm_filling) {
+        return "BUF_REQ re-armed the buffer being filled";
+    }
+    if (adc.rearm_other) {
+        return "BUF_REQ re-armed a buffer not just handed back";
+    }
+    if (adc.starved) {
+        return "hardware ran out of latched buffers";
+    }
+    if (adc.buf_req != adc.done) {
+        return "one BUF_REQ per buffer";
+    }
+    if (buffers() - published != adc.done - done) {
+        return "DONE buffers not averaged exactly once";
+    }
+    return NULL;
+}
+
+static const char *case_average(void)
+{
+    int16_t therm, aux;
+
+    adc.code[0] = code_of(1500);
+    adc.code[1] = code_of(400);
+    complete_buffer();
+    complete_buffer();
+    adc_stream_latest(ADC_CH_THERM, &therm);
+    adc_stream_latest(ADC_CH_AUX, &aux);
+    if (therm != adc.code[0] || aux != adc.code[1]) {
+        return "steady input does not read back";
+    }
+
+    /* Step after three scans of a buffer */
+    int lo = adc.code[0], hi = lo + 100;
+
+    adc_stream_pause(false);
+    zephyr_host_advance_us(3 * 1000000 / CONFIG_NECK_ADC_SCAN_RATE_HZ);
+    adc_stream_pause(true);
+    adc.code[0] = hi;
+    complete_buffer();
+    adc_stream_latest(ADC_CH_THERM, &therm);
+    if (therm != (3 * lo + (SCANS - 3) * hi + SCANS / 2) / SCANS) {
+        return "straddling buffer not the rounded mean of its scans";
+    }
+
+    int worst = 0;
+
+    adc.noise = 16;
+    complete_buffer();
+    for (int b = 0; b < 200; b++) {
+        complete_buffer();
+        adc_stream_latest(ADC_CH_THERM, &therm);
+        worst = MAX(worst, abs(therm - hi));
+    }
+    adc.noise = 0;
+    if (verbose) {
+        printf("  +-16 codes of noise: worst %d\n", worst);
+    }
+    return worst > 4 ? "noise not averaged down" : NULL;
+}
+
+static const char *case_pause(void)
+{
+    uint32_t samples, done;
+    int16_t aux;
+    int lo = code_of(900), hi = code_of(1800);
+
+    adc.code[1] = lo;
+    complete_buffer();
+    adc_stream_pause(false);
+    zephyr_host_advance_us((SCANS - 3) * 1000000 / CONFIG_NECK_ADC_SCAN_RATE_HZ);
+    adc_stream_pause(true);
+    adc.code[1] = hi;
+
+    samples = adc.samples;
+    done = adc.done;
+    zephyr_host_advance_ms(1000);
+    if (adc.samples != samples || hw.enabled) {
+        return "sampled while paused";
+    }
+
+    adc_stream_pause(false);
+    zephyr_host_advance_us(3 * 1000000 / CONFIG_NECK_ADC_SCAN_RATE_HZ);
+    adc_stream_pause(true);
+    if (adc.done != done + 1) {
+        return "partial buffer not completed after resuming";
+    }
+    adc_stream_latest(ADC_CH_AUX, &aux);
+    if (aux != ((SCANS - 3) * lo + 3 * hi + SCANS / 2) / SCANS) {
+        return "buffer kept over the pause lost scans";
+    }
+    return NULL;
+}
+
+static const struct {
+    const char *name;
+    const char *(*run)(void);
+} cases[] = {
+    { "setup", case_setup },
+    { "swap", case_swap },
+    { "average", case_average },
+    { "pause", case_pause },
+};
+
+int main(int argc, char **argv)
+{
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-v")) {
+            verbose = 1;
+            zephyr_host_log = 1;
+        } else {
+            fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    adc.code[0] = code_of(CONFIG_NECK_THERM_VREF_MV / 2);
+    adc.code[1] = code_of(1000);
+    if (adc_stream_init() != 0) {
+        return 1;
+    }
+    /* Scans under the cases' control from here on */
+    adc_stream_pause(true);
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        const char *why = cases[i].run();
+
+        printf("%-8s %s%s\n", cases[i].name, why ? "FAIL: " : "ok", why ? why : "");
+        failed |= why != NULL;
+    }
+    return failed;
+}
@@ -0,0 +1,152 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Decode the binary telemetry stream (shared/telem_wire.h) into CSV.
+ *
+ *   JLinkRTTLogger -Device NRF5340_XXAA_APP -RTTChannel 1 telem.bin
+ *   telem_decode [--stats] [telem.bin] > telem.csv
+ *
+ * --stats prints record/resync/gap counts to stderr, together with the size
+ * the same records would have had in the old text console format.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "telem_wire.h"
+
+#define ACC_UMS2_PER_LSB    (9806650LL)     /* / 16384 */
+#define GYR_URADS_PER_LSB   (8726646LL)     /* / 32768 */
+
+struct decode_stats {
+    unsigned long records;
+    unsigned long skipped_bytes;
+    unsigned long seq_gaps;
+    unsigned long long text_bytes;
+};
+
+/* Length of the line the firmware used to printf for this record */
+static int text_len(const struct telem_wire *w)
+{
+    char line[256];
+    long long a[3], g[3];
+    int n;
+
+    for (int i = 0; i < 3; i++) {
+        a[i] = w->acc[i] * ACC_UMS2_PER_LSB / 16384;
+        g[i] = w->gyr[i] * GYR_URADS_PER_LSB / 32768;
+    }
+    n = snprintf(line, sizeof(line),
+                 "AX: %d.%06d AY: %d.%06d AZ: %d.%06d  "
+                 "GX: %d.%06d GY: %d.%06d GZ: %d.%06d  ",
+                 (int)(a[0] / 1000000), (int)(a[0] % 1000000),
+                 (int)(a[1] / 1000000), (int)(a[1] % 1000000),
+                 (int)(a[2] / 1000000), (int)(a[2] % 1000000),
+                 (int)(g[0] / 1000000), (int)(g[0] % 1000000),
+                 (int)(g[1] / 1000000), (int)(g[1] % 1000000),
+                 (int)(g[2] / 1000000), (int)(g[2] % 1000000));
+    if (w->therm_mv >= 0) {
+        n += snprintf(line, sizeof(line), "[Therm=%dmV, %.1fC] ",
+                      w->therm_mv, w->temp_cdeg / 100.0);
+    }
+    n += snprintf(line, sizeof(line), "[LED=%s, Peltier=%s, LRA=%s]\n",
+                  (w->flags & TELEM_F_LED) ? "ON" : "OFF",
+                  (w->flags & TELEM_F_PELTIER) ? "ON(50%)" : "OFF",
+                  (w->flags & TELEM_F_LRA) ? "ON(50%)" : "OFF");
+    return n;
+}
+
+static void print_csv(const struct telem_wire *w)
+{
+    printf("%u,%lu,%d,%d,%d,%d,%d,%d,%.2f,%.2f,%d,",
+           w->seq, (unsigned long)w->t_us,
+           w->acc[0], w->acc[1], w->acc[2],
+           w->gyr[0], w->gyr[1], w->gyr[2],
+           w->pitch_cdeg / 100.0, w->roll_cdeg / 100.0, w->therm_mv);
+    if (w->temp_cdeg != TELEM_NO_TEMP) {
+        printf("%.2f,", w->temp_cdeg / 100.0);
+    } else {
+        printf(",");
+    }
+    printf("%d,%d,%d\n",
+           !!(w->flags & TELEM_F_LED),
+           !!(w->flags & TELEM_F_PELTIER),
+           !!(w->flags & TELEM_F_LRA));
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in = stdin;
+    int want_stats = 0;
+    unsigned char buf[4096];
+    size_t fill = 0;
+    struct decode_stats st = { 0 };
+    int have_seq = 0;
+    uint16_t last_seq = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stats") == 0) {
+            want_stats = 1;
+        } else if ((in = fopen(argv[i], "rb")) == NULL) {
+            perror(argv[i]);
+            return 1;
+        }
+    }
+
+    printf("seq,t_us,ax,ay,az,gx,gy,gz,pitch_deg,roll_deg,therm_mv,temp_c,led,peltier,lra\n");
+
+    for (;;) {
+        size_t got = fread(&buf[fill], 1, sizeof(buf) - fill, in);
+        size_t pos = 0;
+
+        fill += got;
+
+        /* Resync on sync byte + CRC; skip one byte at a time otherwise */
+        while (fill - pos >= sizeof(struct telem_wire)) {
+            struct telem_wire w;
+
+            memcpy(&w, &buf[pos], sizeof(w));
+            if (!telem_wire_valid(&w)) {
+                pos++;
+                st.skipped_bytes++;
+                continue;
+            }
+            if (have_seq && (uint16_t)(last_seq + 1) != w.seq) {
+                st.seq_gaps++;
+            }
+            have_seq = 1;
+            last_seq = w.seq;
+
+            print_csv(&w);
+            st.records++;
+            st.text_bytes += text_len(&w);
+            pos += sizeof(w);
+        }
+
+        memmove(buf, &buf[pos], fill - pos);
+        fill -= pos;
+
+        if (got == 0) {
+            break;
+        }
+    }
+    st.skipped_bytes += fill;
+
+    if (want_stats) {
+        fprintf(stderr, "records:        %lu\n", st.records);
+        fprintf(stderr, "skipped bytes:  %lu\n", st.skipped_bytes);
+        fprintf(stderr, "sequence gaps:  %lu\n", st.seq_gaps);
+        if (st.records) {
+            fprintf(stderr, "binary:         %zu bytes/sample\n", sizeof(struct telem_wire));
+            fprintf(stderr, "text equivalent: %.1f bytes/sample (%.1fx)\n",
+                    (double)st.text_bytes / st.records,
+                    (double)st.text_bytes / st.records / sizeof(struct telem_wire));
+        }
+    }
+
+    if (in != stdin) {
+        fclose(in);
+    }
+    return 0;
+}
@@ -0,0 +1,328 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Run src/telemetry.c behind a control loop fed by src/imu_acq.c on the
+ * emulated BMI270 FIFO, on the host kernel in tools/zephyr_host, with
+ * sinks that cannot keep up.
+ *
+ *   telemetry_check [-v]
+ *
+ * The control thread here is control_thread() without the decision code:
+ * one pass per FIFO batch, the batch pulled from the sample ring, the
+ * sample-to-step latency recorded in STAGE_CONTROL and one record handed
+ * to telemetry_push(), as control_step() does. The wearer turns the head
+ * slowly, so the rate stays at CONFIG_NECK_IMU_ODR_HZ and a batch is due
+ * every watermark.
+ *
+ * Phases, one after the other on the same threads:
+ *   fast      the sink returns at once: nothing is dropped
+ *   blocked   the sink blocks on the first record until released; the
+ *             ring fills and every later record is dropped
+ *   released  the blocked sink lets go: the ring drains in order
+ *   slow      the sink sleeps 2.5 batch periods per record, for long
+ *             enough that the ring fills and drops again
+ *
+ * In every phase the control loop must run once per batch period (one ODR
+ * period of slack), handle every acquired frame and stay within
+ * CONFIG_NECK_CONTROL_DEADLINE_US; every record pushed is either delivered
+ * once and in order, still queued, or counted exactly once as a
+ * STAGE_CONTROL overrun. Exit status is 1 if a phase fails.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "zephyr_host.h"
+#include "emul/imu_emul.h"
+#include "imu_acq.h"
+#include "pipeline.h"
+#include "telemetry.h"
+
+#define BATCH_MAX       (2 * CONFIG_NECK_IMU_FIFO_WATERMARK)
+#define ODR_PERIOD_US   (1000000 / CONFIG_NECK_IMU_ODR_HZ)
+#define BATCH_US        (CONFIG_NECK_IMU_FIFO_WATERMARK * ODR_PERIOD_US)
+#define SLOW_SINK_US    (5 * BATCH_US / 2)
+
+static int verbose;
+
+/* ===== Control loop ===== */
+static struct {
+    uint32_t steps;
+    uint32_t frames;
+    uint32_t pushed;
+    uint32_t rejected;
+    uint32_t last_step_us;
+    uint32_t min_gap_us;
+    uint32_t max_gap_us;
+} ctl;
+
+static void control_thread(void *p1, void *p2, void *p3);
+
+K_THREAD_DEFINE(control_tid, 2048, control_thread, NULL, NULL, NULL, 5, 0, K_TICKS_FOREVER);
+
+static void control_thread(void *p1, void *p2, void *p3)
+{
+    static struct imu_sample batch[BATCH_MAX];
+
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    while (1) {
+        if (imu_acq_wait(K_MSEC(1000)) != 0) {
+            continue;
+        }
+
+        size_t n = 0;
+
+        while (n < BATCH_MAX && imu_acq_get(&batch[n])) {
+            n++;
+        }
+        if (n == 0) {
+            continue;
+        }
+
+        uint32_t now = pipeline_now_us();
+
+        if (ctl.steps++ > 0) {
+            uint32_t gap = now - ctl.last_step_us;
+
+            ctl.min_gap_us = MIN(ctl.min_gap_us, gap);
+            ctl.max_gap_us = MAX(ctl.max_gap_us, gap);
+        }
+        ctl.last_step_us = now;
+        ctl.frames += n;
+
+        struct ctrl_record rec = { .t_us = batch[n - 1].t_us };
+
+        memcpy(rec.acc, batch[n - 1].acc, sizeof(rec.acc));
+        memcpy(rec.gyr, batch[n - 1].gyr, sizeof(rec.gyr));
+        rec.latency_us = pipeline_now_us() - rec.t_us;
+        pipeline_stage_record(STAGE_CONTROL, rec.latency_us);
+
+        ctl.pushed++;
+        if (!telemetry_push(&rec)) {
+            ctl.rejected++;
+        }
+    }
+}
+
+/* ===== Sinks ===== */
+static struct {
+    uint32_t delivered;
+    uint32_t last_t_us;
+    bool out_of_order;
+} out;
+
+static K_SEM_DEFINE(release_sem, 0, 1);
+static bool blocking;
+
+static void deliver(const struct ctrl_record *rec)
+{
+    if (out.delivered++ > 0 && (int32_t)(rec->t_us - out.last_t_us) <= 0) {
+        out.out_of_order = true;
+    }
+    out.last_t_us = rec->t_us;
+}
+
+static void sink_fast(const struct ctrl_record *rec)
+{
+    deliver(rec);
+}
+
+/* Stuck on the first record, e.g. a console UART with flow control held */
+static void sink_blocking(const struct ctrl_record *rec)
+{
+    if (blocking) {
+        k_sem_take(&release_sem, K_FOREVER);
+    }
+    deliver(rec);
+}
+
+static void sink_slow(const struct ctrl_record *rec)
+{
+    k_sleep(K_USEC(SLOW_SINK_US));
+    deliver(rec);
+}
+
+/* ===== Phases ===== */
+struct snap {
+    struct imu_acq_stats acq;
+    struct stage_stats control;
+    uint32_t steps, frames, pushed, rejected, delivered;
+};
+
+static void snap(struct snap *s)
+{
+    imu_acq_stats_get(&s->acq);
+    pipeline_stats_get(STAGE_CONTROL, &s->control);
+    s->steps = ctl.steps;
+    s->frames = ctl.frames;
+    s->pushed = ctl.pushed;
+    s->rejected = ctl.rejected;
+    s->delivered = out.delivered;
+}
+
+/* Checks common to every phase; NULL if they pass */
+static const char *check_control(const struct snap *a, const struct snap *b, uint32_t ms)
+{
+    uint32_t batches = ms * 1000 / BATCH_US;
+
+    if (b->steps - a->steps + 1 < batches) {
+        return "control steps missing";
+    }
+    if (ctl.min_gap_us + ODR_PERIOD_US < BATCH_US || ctl.max_gap_us > BATCH_US + ODR_PERIOD_US) {
+        return "control cadence off the batch period";
+    }
+    /* Up to one batch may still wait in the sample ring */
+    if (b->acq.frames - b->frames > BATCH_MAX) {
+        return "frames acquired but not handled";
+    }
+    if (b->acq.ring_drops || b->acq.fifo_overruns) {
+        return "IMU frames lost";
+    }
+    if (b->control.deadline_misses != 0) {
+        return "control deadline missed";
+    }
+    if (b->control.overruns - a->control.overruns != b->rejected - a->rejected) {
+        return "dropped records not counted once as STAGE_CONTROL overruns";
+    }
+    if (out.out_of_order) {
+        return "records delivered out of order or twice";
+    }
+    return NULL;
+}
+
+static int report(const char *name, const struct snap *a, const struct snap *b,
+                  const char *why)
+{
+    printf("%-9s %6u %7u %8u %9u %9u %9u%s%s\n", name, b->steps - a->steps,
+           ctl.max_gap_us / 1000, b->pushed - a->pushed, b->delivered - a->delivered,
+           b->rejected - a->rejected, b->control.max_us, why ? "  FAIL: " : "", why ? why : "");
+    return why != NULL;
+}
+
+static void phase_start(struct snap *s)
+{
+    snap(s);
+    ctl.min_gap_us = UINT32_MAX;
+    ctl.max_gap_us = 0;
+}
+
+static int run_phases(void)
+{
+    struct snap a, b;
+    const char *why;
+    int failed = 0;
+    const uint32_t ms = 5000;
+
+    /* fast */
+    telemetry_set_sink(sink_fast);
+    phase_start(&a);
+    zephyr_host_advance_ms(ms);
+    snap(&b);
+    why = check_control(&a, &b, ms);
+    if (!why && (b.rejected != a.rejected || b.delivered - a.delivered + 1 < b.pushed - a.pushed)) {
+        why = "fast sink lost records";
+    }
+    failed |= report("fast", &a, &b, why);
+
+    /* blocked: the sink holds one record, the ring fills behind it */
+    blocking = true;
+    telemetry_set_sink(sink_blocking);
+    phase_start(&a);
+    zephyr_host_advance_ms(ms);
+    snap(&b);
+    why = check_control(&a, &b, ms);
+    uint32_t pushed = b.pushed - a.pushed;
+    uint32_t held = MIN(pushed, CONFIG_NECK_TELEMETRY_RING_SIZE + 1);
+
+    if (!why && b.delivered != a.delivered) {
+        why = "blocked sink delivered";
+    } else if (!why && b.rejected - a.rejected != pushed - held) {
+        why = "ring did not hold exactly its capacity";
+    }
+    failed |= report("blocked", &a, &b, why);
+
+    /* released: everything queued comes out in order, nothing new drops */
+    blocking = false;
+    k_sem_give(&release_sem);
+    phase_start(&a);
+    zephyr_host_advance_ms(ms);
+    snap(&b);
+    why = check_control(&a, &b, ms);
+    if (!why && b.rejected != a.rejected) {
+        why = "drops after release";
+    } else if (!why && b.delivered - a.delivered + 1 < held + b.pushed - a.pushed) {
+        why = "queued records lost";
+    }
+    failed |= report("released", &a, &b, why);
+
+    /* slow: the sink takes 2.5 batch periods per record, long enough for
+     * the ring to fill again
+     */
+    const uint32_t slow_ms = 4 * ms;
+
+    telemetry_set_sink(sink_slow);
+    phase_start(&a);
+    zephyr_host_advance_ms(slow_ms);
+    snap(&b);
+    why = check_control(&a, &b, slow_ms);
+    uint32_t expect = slow_ms * 1000 / SLOW_SINK_US;
+    uint32_t delivered = b.delivered - a.delivered;
+    uint32_t queued = (b.pushed - a.pushed) - delivered - (b.rejected - a.rejected);
+
+    if (!why && (delivered + 1 < expect || delivered > expect + 1)) {
+        why = "slow sink rate";
+    } else if (!why && b.rejected == a.rejected) {
+        why = "slow sink never filled the ring";
+    } else if (!why && (queued < CONFIG_NECK_TELEMETRY_RING_SIZE ||
+                        queued > CONFIG_NECK_TELEMETRY_RING_SIZE + 1)) {
+        why = "records unaccounted for";
+    }
+    failed |= report("slow", &a, &b, why);
+
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    /* A slow head turn keeps the rate at CONFIG_NECK_IMU_ODR_HZ */
+    const int16_t acc[3] = { 16384, 0, 0 };
+    const int16_t gyr[3] = { 0, 0, (int16_t)(20 * IMU_GYR_LSB_PER_DPS) };
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-v")) {
+            verbose = 1;
+            zephyr_host_log = 1;
+        } else {
+            fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    imu_emul_set_sample(acc, gyr);
+    pipeline_stage_init(STAGE_CONTROL, CONFIG_NECK_CONTROL_DEADLINE_US);
+    telemetry_set_sink(sink_fast);
+    telemetry_start();
+    if (imu_acq_init() < 0) {
+        return 1;
+    }
+    /* As if a cue ran throughout: no low power */
+    imu_acq_hold_active(true);
+    k_thread_start(control_tid);
+    /* Let the rate and the sample clock settle */
+    zephyr_host_advance_ms(3000);
+
+    printf("%-9s %6s %7s %8s %9s %9s %9s\n", "phase", "steps", "gap ms", "pushed",
+           "delivered", "dropped", "lat us");
+    int failed = run_phases();
+
+    if (verbose) {
+        struct imu_acq_stats st;
+
+        imu_acq_stats_get(&st);
+        printf("IMU: %u frames at %u Hz, %u bursts\n", st.frames, st.odr_hz, st.bursts);
+    }
+    return failed;
+}
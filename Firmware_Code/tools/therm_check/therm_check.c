@@ -0,0 +1,155 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Check the generated thermistor table (src/thermistor.c) against the
+ * analytic NTC curve over every 12-bit ADC code, and time it against the
+ * double-precision conversion the firmware used before.
+ *
+ *   therm_check [--max-err-cdeg N] [--band LO HI]
+ *
+ * Errors are reported over the whole table range and over the band (degC)
+ * the control loop cares about. Exit status is 1 if the in-band error
+ * exceeds --max-err-cdeg (default 10, i.e. 0.1 degC).
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "thermistor.h"
+#include "therm_lut.h"
+
+#define CODES       (1 << THERM_LUT_ADC_BITS)
+#define REPEAT      2000
+
+struct err_stats {
+    double max_cdeg;
+    int worst_code;
+};
+
+/* Analytic curve at the exact input voltage of an ADC code */
+static double analytic_temp_c(double v_mv)
+{
+    if (v_mv < 1.0) v_mv = 1.0;
+    if (v_mv > THERM_LUT_VREF_MV - 1.0) v_mv = THERM_LUT_VREF_MV - 1.0;
+
+    double r = THERM_LUT_R_FIXED_OHM * v_mv / (THERM_LUT_VREF_MV - v_mv);
+#if defined(THERM_LUT_MODEL_BETA)
+    double inv_t = 1.0 / THERM_LUT_T0_K + log(r / THERM_LUT_R0_OHM) / THERM_LUT_BETA;
+#else
+    double ln_r = log(r);
+    double inv_t = THERM_LUT_SH_A + THERM_LUT_SH_B * ln_r + THERM_LUT_SH_C * ln_r * ln_r * ln_r;
+#endif
+    return 1.0 / inv_t - 273.15;
+}
+
+/* The pre-table firmware path: integer mV from the ADC driver, then the
+ * double-precision beta equation (thermistor_temp_c_from_mv() in control.c)
+ */
+static int code_to_mv(int code)
+{
+    return (int)(((long long)code * (long long)THERM_LUT_ADC_FULL_SCALE_MV) >> THERM_LUT_ADC_BITS);
+}
+
+static double legacy_temp_c_from_mv(int vout_mv)
+{
+    if (vout_mv <= 1) vout_mv = 1;
+    if (vout_mv >= (int)THERM_LUT_VREF_MV - 1) vout_mv = (int)THERM_LUT_VREF_MV - 1;
+
+    double v = (double)vout_mv;
+    return analytic_temp_c(v);
+}
+
+static double code_voltage_mv(int code)
+{
+    return code * (double)THERM_LUT_ADC_FULL_SCALE_MV / CODES;
+}
+
+static void track(struct err_stats *e, int code, double err_cdeg)
+{
+    if (fabs(err_cdeg) > e->max_cdeg) {
+        e->max_cdeg = fabs(err_cdeg);
+        e->worst_code = code;
+    }
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+    double max_err_cdeg = 10.0;
+    double band_lo = 0.0, band_hi = 80.0;
+    struct err_stats all = { 0 }, band = { 0 }, legacy = { 0 };
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--max-err-cdeg") && i + 1 < argc) {
+            max_err_cdeg = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--band") && i + 2 < argc) {
+            band_lo = atof(argv[++i]);
+            band_hi = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--max-err-cdeg N] [--band LO HI]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    for (int code = 0; code < CODES; code++) {
+        double ref_c = analytic_temp_c(code_voltage_mv(code));
+        double lut_cdeg = thermistor_cdeg_from_code(code);
+
+        /* Outside the table range the LUT saturates on purpose */
+        if (ref_c * 100.0 < THERM_LUT_CDEG_MIN || ref_c * 100.0 > THERM_LUT_CDEG_MAX) {
+            continue;
+        }
+        track(&all, code, lut_cdeg - ref_c * 100.0);
+        if (ref_c >= band_lo && ref_c <= band_hi) {
+            track(&band, code, lut_cdeg - ref_c * 100.0);
+            track(&legacy, code, legacy_temp_c_from_mv(code_to_mv(code)) * 100.0 - ref_c * 100.0);
+        }
+    }
+
+    printf("table: %d entries, %d codes/step, %zu bytes\n",
+           THERM_LUT_LEN, 1 << THERM_LUT_SHIFT, sizeof(therm_lut_cdeg));
+    printf("max error, table range:     %.2f cdeg (code %d)\n", all.max_cdeg, all.worst_code);
+    printf("max error, %.0f..%.0f degC:     %.2f cdeg (code %d)\n",
+           band_lo, band_hi, band.max_cdeg, band.worst_code);
+    printf("old mV path, %.0f..%.0f degC:   %.2f cdeg (code %d, integer-mV quantisation)\n",
+           band_lo, band_hi, legacy.max_cdeg, legacy.worst_code);
+
+    /* Timing: same sweep through both conversions */
+    volatile double sink_d = 0;
+    volatile int32_t sink_i = 0;
+    double t0 = now_ns();
+    for (int r = 0; r < REPEAT; r++) {
+        for (int code = 0; code < CODES; code++) {
+            sink_d += legacy_temp_c_from_mv(code_to_mv(code));
+        }
+    }
+    double t1 = now_ns();
+    for (int r = 0; r < REPEAT; r++) {
+        for (int code = 0; code < CODES; code++) {
+            sink_i += thermistor_cdeg_from_code(code);
+        }
+    }
+    double t2 = now_ns();
+    double calls = (double)REPEAT * CODES;
+
+    printf("host time/call: double log() %.1f ns, table %.1f ns (%.1fx)\n",
+           (t1 - t0) / calls, (t2 - t1) / calls, (t1 - t0) / (t2 - t1));
+    (void)sink_d;
+    (void)sink_i;
+
+    if (band.max_cdeg > max_err_cdeg) {
+        printf("FAIL: in-band error above %.2f cdeg\n", max_err_cdeg);
+        return 1;
+    }
+    return 0;
+}
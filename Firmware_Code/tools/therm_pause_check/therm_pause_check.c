@@ -0,0 +1,311 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Run the thermal supervisor thread (src/therm_sup.c, with the checks of
+ * src/therm_guard.c) on the host kernel in tools/zephyr_host through an
+ * IMU low-power spell, as control.c's imu_mode_changed() drives it.
+ *
+ *   therm_pause_check [-v]
+ *
+ * Around it, the firmware's timing: the ADC publishes a buffer every 8 ms
+ * and the control thread renews the cue every 50 ms, both stopped in low
+ * power with the Peltiers off. The thermistor reads in cdeg directly.
+ *   active    one check per CONFIG_NECK_THERM_SUP_PERIOD_MS, no trip
+ *   paused    a minute of low power: no check runs and no timer fires,
+ *             so nothing wakes the SoC
+ *   resume    cue and heat from the moment the IMU is back: no staleness
+ *             trip from the minute without ADC buffers or cue renewals
+ *   rise      a 2 degC/s rise shortly after resuming: RISE as soon as
+ *             without the pause, give or take a period (no slope taken
+ *             across the gap)
+ *   hold      a trip latched before a pause re-arms hold_ms of
+ *             observed, fault-free time after the resume, not earlier
+ * Exit status is 1 if a case fails.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "zephyr_host.h"
+#include "actuators.h"
+#include "adc_stream.h"
+#include "journal.h"
+#include "peltier_ctrl.h"
+#include "therm_sup.h"
+#include "thermistor.h"
+
+#define ADC_EVERY_MS    8
+#define CTRL_EVERY_MS   50
+#define PERIOD_MS       CONFIG_NECK_THERM_SUP_PERIOD_MS
+
+static int verbose;
+
+/* ===== The supervisor's surroundings ===== */
+static struct {
+    uint32_t buffers;
+    int16_t temp_cdeg;
+    int16_t rise_cdeg_per_s;    /* applied every ADC buffer */
+    bool cue;
+    uint32_t ctrl_ms;
+    uint16_t duty;
+    bool inhibited;
+    uint32_t trips;
+    uint8_t last_trip;
+} env;
+
+static void adc_fn(struct k_timer *t)
+{
+    ARG_UNUSED(t);
+    env.buffers++;
+    env.temp_cdeg += env.rise_cdeg_per_s * ADC_EVERY_MS / 1000;
+}
+
+static void ctrl_fn(struct k_timer *t)
+{
+    ARG_UNUSED(t);
+    env.ctrl_ms = k_uptime_get_32();
+}
+
+static K_TIMER_DEFINE(adc_timer, adc_fn, NULL);
+static K_TIMER_DEFINE(ctrl_timer, ctrl_fn, NULL);
+
+size_t actuators_count(enum act_group g)
+{
+    return g == ACT_PELTIER ? 2 : 0;
+}
+
+int actuators_stats_get(enum act_group g, size_t idx, struct act_channel_stats *out)
+{
+    ARG_UNUSED(g);
+    ARG_UNUSED(idx);
+    memset(out, 0, sizeof(*out));
+    out->duty_permille = env.inhibited ? 0 : env.duty;
+    return 0;
+}
+
+int actuators_inhibit(enum act_group g, bool on)
+{
+    ARG_UNUSED(g);
+    env.inhibited = on;
+    return 0;
+}
+
+void adc_stream_stats_get(struct adc_stream_stats *out)
+{
+    out->buffers = env.buffers;
+    out->scans = env.buffers * 8;
+}
+
+int adc_stream_latest(enum adc_stream_ch ch, int16_t *code)
+{
+    ARG_UNUSED(ch);
+    *code = env.temp_cdeg;
+    return 0;
+}
+
+int16_t thermistor_cdeg_from_code(int32_t code)
+{
+    return (int16_t)code;
+}
+
+bool peltier_ctrl_request_get(uint32_t *t_ms)
+{
+    *t_ms = env.ctrl_ms;
+    return env.cue;
+}
+
+void journal_add(uint8_t type, int64_t a, int32_t b)
+{
+    ARG_UNUSED(b);
+    if (type == JRNL_TRIP && a != THERM_TRIP_NONE) {
+        env.trips++;
+        env.last_trip = (uint8_t)a;
+        if (verbose) {
+            printf("  %8.3f s trip %s\n", k_uptime_get_32() / 1000.0,
+                   therm_trip_name((enum therm_trip)a));
+        }
+    }
+}
+
+/* imu_mode_changed(), with the ADC and the control thread's renewals */
+static void low_power(bool on)
+{
+    if (on) {
+        k_timer_stop(&adc_timer);
+        k_timer_stop(&ctrl_timer);
+        env.duty = 0;
+        therm_sup_pause(true);
+    } else {
+        k_timer_start(&adc_timer, K_MSEC(ADC_EVERY_MS), K_MSEC(ADC_EVERY_MS));
+        k_timer_start(&ctrl_timer, K_MSEC(CTRL_EVERY_MS), K_MSEC(CTRL_EVERY_MS));
+        therm_sup_pause(false);
+    }
+}
+
+static struct therm_sup_stats stats(void)
+{
+    struct therm_sup_stats s;
+
+    therm_sup_stats_get(&s);
+    return s;
+}
+
+/* ===== Cases ===== */
+static const char *case_active(void)
+{
+    uint32_t checks = stats().checks;
+
+    zephyr_host_advance_ms(2000);
+    if (stats().checks - checks != 2000 / PERIOD_MS) {
+        return "checks per second";
+    }
+    return env.trips ? "tripped" : NULL;
+}
+
+static const char *case_paused(void)
+{
+    low_power(true);
+    zephyr_host_settle();
+
+    uint32_t checks = stats().checks, fires = zephyr_host_timer_fires();
+
+    zephyr_host_advance_ms(60000);
+    if (verbose) {
+        printf("  60 s paused: %u checks, %u timer fires\n", stats().checks - checks,
+               zephyr_host_timer_fires() - fires);
+    }
+    if (stats().checks != checks) {
+        return "checks ran while paused";
+    }
+    if (zephyr_host_timer_fires() != fires) {
+        return "timers fired while paused";
+    }
+    return stats().pauses != 1 ? "pause not counted" : NULL;
+}
+
+static const char *case_resume(void)
+{
+    uint32_t checks = stats().checks;
+
+    low_power(false);
+    env.cue = true;
+    env.ctrl_ms = k_uptime_get_32();
+    env.duty = 400;
+    zephyr_host_advance_ms(5000);
+    if (env.trips) {
+        return "tripped after resuming";
+    }
+    return stats().checks - checks != 5000 / PERIOD_MS ? "checks per second after resuming" : NULL;
+}
+
+/* Cue and heat, then a 2 degC/s rise 300 ms later: ms to the trip, 0 if
+ * none within twice the rise window. The trip stays latched.
+ */
+static uint32_t rise_latency(void)
+{
+    uint32_t trips = env.trips, from;
+
+    env.cue = true;
+    env.ctrl_ms = k_uptime_get_32();
+    env.duty = 400;
+    zephyr_host_advance_ms(300);
+    from = k_uptime_get_32();
+    env.rise_cdeg_per_s = 200;
+    while (env.trips == trips && k_uptime_get_32() - from <= 2u * CONFIG_NECK_THERM_SUP_RISE_WINDOW_MS) {
+        zephyr_host_advance_ms(1);
+    }
+    env.rise_cdeg_per_s = 0;
+    return env.trips != trips && env.last_trip == THERM_TRIP_RISE ? k_uptime_get_32() - from : 0;
+}
+
+static const char *case_rise(void)
+{
+    const uint32_t hold_ms = CONFIG_NECK_THERM_SUP_HOLD_S * 1000u;
+    uint32_t plain = rise_latency(), paused;
+
+    /* Cool, off and re-armed */
+    env.cue = false;
+    env.duty = 0;
+    env.temp_cdeg = 3300;
+    zephyr_host_advance_ms(hold_ms + 1000);
+    if (therm_sup_tripped() != THERM_TRIP_NONE) {
+        return "not re-armed after the first rise";
+    }
+
+    low_power(true);
+    zephyr_host_advance_ms(60000);
+    low_power(false);
+    paused = rise_latency();
+    if (verbose) {
+        printf("  RISE %u ms after the rise began, %u ms without the pause\n", paused, plain);
+    }
+    if (!plain || !paused) {
+        return "rise not cut";
+    }
+    return paused > plain + PERIOD_MS + ADC_EVERY_MS ? "rise cut later after the pause" : NULL;
+}
+
+static const char *case_hold(void)
+{
+    const uint32_t hold_ms = CONFIG_NECK_THERM_SUP_HOLD_S * 1000u;
+
+    /* Cool down under the re-arm level, still latched from the rise */
+    env.cue = false;
+    env.duty = 0;
+    env.temp_cdeg = 3300;
+    zephyr_host_advance_ms(hold_ms / 2);
+    if (therm_sup_tripped() == THERM_TRIP_NONE) {
+        return "re-armed too early";
+    }
+
+    /* Half the hold in low power counts for nothing */
+    low_power(true);
+    zephyr_host_advance_ms(hold_ms);
+    low_power(false);
+    zephyr_host_advance_ms(hold_ms - PERIOD_MS);
+    if (therm_sup_tripped() == THERM_TRIP_NONE) {
+        return "re-armed with time spent paused";
+    }
+    zephyr_host_advance_ms(2 * PERIOD_MS);
+    return therm_sup_tripped() != THERM_TRIP_NONE ? "not re-armed after the hold" : NULL;
+}
+
+static const struct {
+    const char *name;
+    const char *(*run)(void);
+} cases[] = {
+    { "active", case_active },
+    { "paused", case_paused },
+    { "resume", case_resume },
+    { "rise", case_rise },
+    { "hold", case_hold },
+};
+
+int main(int argc, char **argv)
+{
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-v")) {
+            verbose = 1;
+            zephyr_host_log = 1;
+        } else {
+            fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    env.temp_cdeg = 3300;
+    k_timer_start(&adc_timer, K_MSEC(ADC_EVERY_MS), K_MSEC(ADC_EVERY_MS));
+    k_timer_start(&ctrl_timer, K_MSEC(CTRL_EVERY_MS), K_MSEC(CTRL_EVERY_MS));
+    therm_sup_init();
+    zephyr_host_advance_ms(100);
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        const char *why = cases[i].run();
+
+        printf("%-8s %s%s\n", cases[i].name, why ? "FAIL: " : "ok", why ? why : "");
+        failed |= why != NULL;
+    }
+    return failed;
+}
@@ -0,0 +1,485 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Run the thermal supervisor's checks (src/therm_guard.c) and the Peltier
+ * PI (src/peltier_pi.c) against the patch's thermal model with faults
+ * injected, and check every fault is cut within its latency bound and a
+ * normal session never trips.
+ *
+ *   therm_sup_check [--period MS] [--seed N] [-v]
+ *
+ * Plant as tools/peltier_sim (one thermal mass leaking to skin, the NTC
+ * behind a first-order lag), stepped every 1 ms. Around it, the firmware's
+ * timing: the ADC publishes a new average every 8 ms, the control thread
+ * renews the cue every 50 ms, the PI ticks at 10 Hz and the supervisor
+ * every --period ms (default 20, CONFIG_NECK_THERM_SUP_PERIOD_MS), out of
+ * phase with all of them. A trip inhibits the Peltier output at once, as
+ * actuators_inhibit() does.
+ *
+ * normal        40 min of cue cycles at several setpoints, starting from a
+ *               patch put on cool, with ADC noise: no trip allowed
+ * open          thermistor open (reads -40 degC, the PI would go to full
+ *               duty): SENSOR within ADC interval + period, and the PI
+ *               itself off from the first implausible reading
+ * short         thermistor shorted (reads 125 degC): same
+ * adc_stop      ADC stops publishing: ADC_STALE within stale + ADC
+ *               interval + period
+ * imu_fail      control thread stops renewing a running cue (I2C bus
+ *               failure): CTRL_STALE within ctrl_stale + 50 ms + period
+ * sw_runaway    Peltier loop commands full duty: cut within one period of
+ *               the reading crossing the cut-off (or earlier on the rise)
+ * loop_hang     Peltier loop stuck at 80 %, cue dropped 10 s later:
+ *               LOOP_STALE within ctrl_stale + 50 ms + period of the drop
+ * hw_stuck      Peltier driver stuck on with the cue off: RUNAWAY, before
+ *               the reading reaches the cut-off
+ * rearm         open thermistor repaired after 10 s: re-armed hold_ms
+ *               (+ one period) later, heating again
+ * pi_sensor     the PI alone (as without the supervisor) on missing,
+ *               open, shorted and out-of-range readings: duty 0 at once
+ *
+ * Exit status is 1 if any scenario fails.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "peltier_pi.h"
+#include "therm_guard.h"
+
+/* Plant, as tools/peltier_sim */
+#define T_SKIN_C            32.0
+#define C_TH_J_PER_K        3.0
+#define R_TH_K_PER_W        8.0
+#define P_MAX_W             2.0
+#define TAU_NTC_S           1.5
+
+/* Firmware timing (Kconfig defaults) */
+#define ADC_EVERY_MS        8       /* 1000 scans/s, 8 per buffer */
+#define CTRL_EVERY_MS       50
+#define PI_EVERY_MS         100     /* NECK_PELTIER_TICK_HZ */
+#define CUTOFF_CDEG         4500
+
+#define NOISE_CDEG          5
+
+enum fault {
+    F_NONE,
+    F_OPEN,
+    F_SHORT,
+    F_ADC_STOP,
+    F_IMU_FAIL,
+    F_SW_RUNAWAY,
+    F_LOOP_HANG,
+    F_HW_STUCK,
+    F_REARM,
+};
+
+struct scenario {
+    const char *name;
+    enum fault fault;
+    double start_c;
+    int cue_always;             /* else the normal cue cycle */
+    uint32_t fault_ms;
+    uint32_t run_ms;
+    enum therm_trip expect;
+};
+
+struct run {
+    /* Plant */
+    double t_plant, t_ntc;
+    /* Firmware state as the supervisor sees it */
+    int16_t latest;
+    uint32_t adc_ms;
+    uint32_t ctrl_ms;
+    bool cue;
+    float duty;                 /* commanded */
+    bool inhibited;
+    /* Results */
+    enum therm_trip first;
+    uint32_t trip_ms;
+    uint32_t visible_ms;        /* fault first observable, 0 if not yet */
+    uint32_t rearm_ms;
+    uint32_t trips;
+    double peak_c;
+    bool heated_after_rearm;
+    bool drove_implausible;     /* PI output on an implausible reading */
+    double rise_max, rise_off_max;  /* 0.01 degC/s over 1 s of readings */
+};
+
+static int verbose;
+static uint32_t rng = 1;
+static uint32_t sup_period = 20;
+
+static uint32_t rnd(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static struct therm_guard_params guard_params(void)
+{
+    const struct therm_guard_params p = {
+        .cutoff_cdeg = CUTOFF_CDEG,
+        .rearm_cdeg = CUTOFF_CDEG - 300,
+        .min_cdeg = 500,
+        .max_cdeg = 10000,
+        .runaway_min_cdeg = 3700,
+        .rise_cdeg_per_s = 100,
+        .runaway_cdeg_per_s = 20,
+        .rise_window_ms = 2000,
+        .stale_ms = 500,
+        .ctrl_stale_ms = 2000,
+        .hold_ms = 30000,
+    };
+
+    return p;
+}
+
+static struct peltier_pi_params pi_params(void)
+{
+    const struct therm_guard_params gp = guard_params();
+    const struct peltier_pi_params p = {
+        .kp = 0.25f,
+        .ki = 0.02f,
+        .dt_s = PI_EVERY_MS / 1000.0f,
+        .out_max = 0.8f,
+        .slew_per_s = 0.2f,
+        .min_cdeg = gp.min_cdeg,
+        .max_cdeg = gp.max_cdeg,
+    };
+
+    return p;
+}
+
+/* On 60 s, off 30 s, through the setpoints in turn */
+static bool cue_at(uint32_t t_ms, int16_t *setpoint)
+{
+    static const int16_t sp[] = { 3800, 3600, 4200, 3900 };
+    uint32_t cycle = t_ms / 90000;
+
+    *setpoint = sp[cycle % (sizeof(sp) / sizeof(sp[0]))];
+    return t_ms % 90000 >= 30000;
+}
+
+static int16_t reading(const struct scenario *sc, const struct run *r, uint32_t t)
+{
+    bool faulty = t >= sc->fault_ms && (sc->fault != F_REARM || t < sc->fault_ms + 10000);
+
+    if (faulty && (sc->fault == F_OPEN || sc->fault == F_REARM)) {
+        return -4000;
+    }
+    if (faulty && sc->fault == F_SHORT) {
+        return 12500;
+    }
+    return (int16_t)lround(r->t_ntc * 100.0) + (int16_t)(rnd() % (2 * NOISE_CDEG + 1)) - NOISE_CDEG;
+}
+
+static void simulate(const struct scenario *sc, struct run *r)
+{
+    const struct therm_guard_params gp = guard_params();
+    const struct peltier_pi_params pp = pi_params();
+    struct therm_guard g;
+    struct peltier_pi pi;
+    int16_t setpoint = 3800;
+    int16_t hist[1000 / ADC_EVERY_MS];
+    unsigned nhist = 0;
+    uint32_t cue_off_ms = 0;
+
+    memset(r, 0, sizeof(*r));
+    r->t_plant = r->t_ntc = sc->start_c;
+    r->latest = INT16_MIN;
+    therm_guard_init(&g, &gp);
+    peltier_pi_init(&pi, &pp);
+
+    for (uint32_t t = 1; t <= sc->run_ms; t++) {
+        bool fault = t >= sc->fault_ms;
+
+        /* ADC */
+        if (t % ADC_EVERY_MS == 0 && !(fault && sc->fault == F_ADC_STOP)) {
+            r->latest = reading(sc, r, t);
+            r->adc_ms = t;
+
+            /* Slope over the last second, for the margins */
+            if (nhist == sizeof(hist) / sizeof(hist[0])) {
+                double rise = r->latest - hist[0];
+
+                if (r->latest > 0 && hist[0] > 0) {
+                    r->rise_max = fmax(r->rise_max, rise);
+                    if (r->duty == 0 && t - cue_off_ms > (uint32_t)gp.rise_window_ms &&
+                        r->latest > gp.runaway_min_cdeg) {
+                        r->rise_off_max = fmax(r->rise_off_max, rise);
+                    }
+                }
+                memmove(hist, hist + 1, sizeof(hist) - sizeof(hist[0]));
+                nhist--;
+            }
+            hist[nhist++] = r->latest;
+
+            if (!r->visible_ms && fault) {
+                bool seen = false;
+
+                switch (sc->fault) {
+                case F_OPEN:
+                case F_SHORT:
+                case F_REARM:
+                    seen = true;
+                    break;
+                case F_SW_RUNAWAY:
+                    seen = r->latest > CUTOFF_CDEG;
+                    break;
+                default:
+                    break;
+                }
+                if (seen) {
+                    r->visible_ms = t;
+                }
+            }
+        }
+
+        /* Control thread */
+        if (t % CTRL_EVERY_MS == 0 && !(fault && sc->fault == F_IMU_FAIL)) {
+            bool cue = sc->cue_always || cue_at(t, &setpoint);
+
+            if (sc->fault == F_HW_STUCK) {
+                cue = false;
+            }
+            if (sc->fault == F_LOOP_HANG && t >= sc->fault_ms + 10000) {
+                cue = false;
+            }
+            if (r->cue && !cue) {
+                cue_off_ms = t;
+            }
+            r->cue = cue;
+            r->ctrl_ms = t;
+        }
+        if (sc->fault == F_LOOP_HANG && !r->visible_ms && fault && !r->cue) {
+            r->visible_ms = t;
+        }
+        if (sc->fault == F_ADC_STOP && !r->visible_ms && fault) {
+            r->visible_ms = t;
+        }
+        if (sc->fault == F_IMU_FAIL && !r->visible_ms && fault) {
+            r->visible_ms = t;
+        }
+        if (sc->fault == F_HW_STUCK && !r->visible_ms && fault) {
+            r->visible_ms = t;
+        }
+
+        /* Peltier loop */
+        if (t % PI_EVERY_MS == 0 && !(fault && sc->fault == F_LOOP_HANG)) {
+            bool tripped = g.trip != THERM_TRIP_NONE;
+
+            r->duty = peltier_pi_tick(&pi, r->cue && !tripped, setpoint, CUTOFF_CDEG, r->latest, -1);
+            if (r->duty > 0 && !peltier_pi_plausible(&pi, r->latest)) {
+                r->drove_implausible = true;
+            }
+            if (fault && sc->fault == F_SW_RUNAWAY) {
+                r->duty = 1.0f;
+            }
+            if (r->inhibited) {
+                r->duty = 0;
+            }
+        }
+        if (fault && sc->fault == F_LOOP_HANG && t == sc->fault_ms) {
+            r->duty = r->inhibited ? 0.0f : 0.8f;
+        }
+
+        /* Supervisor, 3 ms out of phase with the rest */
+        if (t % sup_period == 3 % sup_period) {
+            const struct therm_guard_in in = {
+                .t_ms = t,
+                .temp_cdeg = r->latest,
+                .adc_ms = r->adc_ms,
+                .ctrl_ms = r->ctrl_ms,
+                .cue = r->cue,
+                .heating = r->duty != 0,
+            };
+            bool was = r->inhibited;
+            enum therm_trip trip = therm_guard_step(&g, &in);
+
+            r->inhibited = trip != THERM_TRIP_NONE;
+            if (r->inhibited) {
+                r->duty = 0;
+            }
+            if (r->inhibited && !was) {
+                r->trips++;
+                if (r->first == THERM_TRIP_NONE) {
+                    r->first = trip;
+                    r->trip_ms = t;
+                }
+                if (verbose) {
+                    printf("    %8.3f s  trip %s at %d cdeg (plant %.2f C)\n", t / 1000.0,
+                           therm_trip_name(trip), r->latest, r->t_plant);
+                }
+            } else if (!r->inhibited && was) {
+                r->rearm_ms = t;
+                if (verbose) {
+                    printf("    %8.3f s  re-armed\n", t / 1000.0);
+                }
+            }
+        }
+        if (r->rearm_ms && r->duty > 0) {
+            r->heated_after_rearm = true;
+        }
+
+        /* Plant */
+        double p = (fault && sc->fault == F_HW_STUCK ? 1.0 : r->duty) * P_MAX_W;
+
+        r->t_plant += 0.001 * (p - (r->t_plant - T_SKIN_C) / R_TH_K_PER_W) / C_TH_J_PER_K;
+        r->t_ntc += 0.001 * (r->t_plant - r->t_ntc) / TAU_NTC_S;
+        r->peak_c = fmax(r->peak_c, r->t_plant);
+    }
+}
+
+/* Latency bound from the fault becoming visible, 0 for none */
+static uint32_t bound_ms(const struct scenario *sc)
+{
+    const struct therm_guard_params gp = guard_params();
+
+    switch (sc->fault) {
+    case F_OPEN:
+    case F_SHORT:
+    case F_SW_RUNAWAY:
+        return sup_period;
+    case F_ADC_STOP:
+        return gp.stale_ms + ADC_EVERY_MS + sup_period;
+    case F_IMU_FAIL:
+    case F_LOOP_HANG:
+        return gp.ctrl_stale_ms + CTRL_EVERY_MS + sup_period;
+    default:
+        return 0;
+    }
+}
+
+static int run(const struct scenario *sc)
+{
+    const struct therm_guard_params gp = guard_params();
+    struct run r;
+    const char *why = NULL;
+    uint32_t bound = bound_ms(sc);
+    uint32_t lat;
+
+    simulate(sc, &r);
+    lat = r.trip_ms - (r.visible_ms ? r.visible_ms : r.trip_ms);
+
+    if (sc->fault == F_NONE) {
+        if (r.trips) {
+            why = "tripped";
+        }
+    } else if (r.first == THERM_TRIP_NONE) {
+        why = "never tripped";
+    } else if (r.drove_implausible) {
+        why = "PI on an implausible reading";
+    } else if (sc->fault == F_SW_RUNAWAY) {
+        if (r.first != THERM_TRIP_OVER_TEMP && r.first != THERM_TRIP_RISE) {
+            why = "wrong trip";
+        } else if (r.visible_ms && r.trip_ms > r.visible_ms + bound) {
+            why = "late";
+        }
+    } else if (r.first != sc->expect) {
+        why = "wrong trip";
+    } else if (bound && lat > bound) {
+        why = "late";
+    } else if (sc->fault == F_REARM) {
+        uint32_t repaired = sc->fault_ms + 10000;
+
+        if (!r.rearm_ms || r.rearm_ms < repaired + gp.hold_ms ||
+            r.rearm_ms > repaired + gp.hold_ms + ADC_EVERY_MS + 2 * sup_period) {
+            why = "re-arm time";
+        } else if (!r.heated_after_rearm) {
+            why = "no heat after re-arm";
+        }
+    }
+
+    printf("%-11s ", sc->name);
+    if (sc->fault == F_NONE) {
+        printf("%-10s %3u trips  rise max %4.0f/%d, off %3.0f/%d cdeg/s  peak %.2f C",
+               "-", r.trips, r.rise_max, gp.rise_cdeg_per_s, r.rise_off_max,
+               gp.runaway_cdeg_per_s, r.peak_c);
+    } else if (r.first == THERM_TRIP_NONE) {
+        printf("%-10s", "none");
+    } else {
+        printf("%-10s %6u ms", therm_trip_name(r.first), lat);
+        if (bound) {
+            printf(" (bound %4u)", bound);
+        } else {
+            printf("             ");
+        }
+        printf("  at %6.1f s, peak %.2f C", r.trip_ms / 1000.0, r.peak_c);
+        if (sc->fault == F_REARM && r.rearm_ms) {
+            printf(", re-armed %.1f s after the repair", (r.rearm_ms - sc->fault_ms - 10000) / 1000.0);
+        }
+    }
+    printf("%s%s\n", why ? "  FAIL: " : "", why ? why : "");
+    return why != NULL;
+}
+
+/* The PI on its own, as without the supervisor: off from the first
+ * implausible reading, and slewing up from zero after it
+ */
+static int check_pi_sensor(void)
+{
+    static const int16_t bad[] = { INT16_MIN, -4000, 12500, 499, 10001 };
+    const struct peltier_pi_params pp = pi_params();
+    const char *why = NULL;
+    struct peltier_pi pi;
+
+    peltier_pi_init(&pi, &pp);
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]) && !why; i++) {
+        for (int k = 0; k < 50; k++) {
+            peltier_pi_tick(&pi, true, 3800, CUTOFF_CDEG, 3000, -1);
+        }
+        if (peltier_pi_tick(&pi, true, 3800, CUTOFF_CDEG, bad[i], -1) != 0.0f || pi.integ != 0.0f) {
+            why = "duty on an implausible reading";
+        } else if (peltier_pi_tick(&pi, true, 3800, CUTOFF_CDEG, 3000, -1) >
+                   pp.slew_per_s * pp.dt_s + 1e-6f) {
+            why = "no slew from zero after it";
+        }
+    }
+    printf("%-11s %s%s\n", "pi_sensor", why ? "FAIL: " : "ok", why ? why : "");
+    return why != NULL;
+}
+
+int main(int argc, char **argv)
+{
+    static const struct scenario scenarios[] = {
+        { "normal", F_NONE, 24.0, 0, 0, 2400000, THERM_TRIP_NONE },
+        { "open", F_OPEN, T_SKIN_C, 1, 60000, 90000, THERM_TRIP_SENSOR },
+        { "short", F_SHORT, T_SKIN_C, 1, 60000, 90000, THERM_TRIP_SENSOR },
+        { "adc_stop", F_ADC_STOP, T_SKIN_C, 1, 60000, 90000, THERM_TRIP_ADC_STALE },
+        { "imu_fail", F_IMU_FAIL, T_SKIN_C, 1, 60000, 90000, THERM_TRIP_CTRL_STALE },
+        { "sw_runaway", F_SW_RUNAWAY, T_SKIN_C, 1, 60000, 240000, THERM_TRIP_OVER_TEMP },
+        { "loop_hang", F_LOOP_HANG, T_SKIN_C, 1, 60000, 90000, THERM_TRIP_LOOP_STALE },
+        { "hw_stuck", F_HW_STUCK, T_SKIN_C, 0, 60000, 240000, THERM_TRIP_RUNAWAY },
+        { "rearm", F_REARM, T_SKIN_C, 1, 60000, 150000, THERM_TRIP_SENSOR },
+    };
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--period") && i + 1 < argc) {
+            sup_period = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            rng = (uint32_t)strtoul(argv[++i], NULL, 0) | 1;
+        } else if (!strcmp(argv[i], "-v")) {
+            verbose = 1;
+        } else {
+            fprintf(stderr, "usage: %s [--period MS] [--seed N] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (sup_period == 0) {
+        sup_period = 1;
+    }
+
+    printf("supervisor every %u ms, ADC every %d ms, cue every %d ms, PI every %d ms\n\n",
+           sup_period, ADC_EVERY_MS, CTRL_EVERY_MS, PI_EVERY_MS);
+    printf("scenario    trip       latency               when\n");
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        failed |= run(&scenarios[i]);
+    }
+    failed |= check_pi_sensor();
+    return failed;
+}
@@ -0,0 +1,15 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_HOST_DRIVERS_SENSOR_H_
+#define ZEPHYR_HOST_DRIVERS_SENSOR_H_
+
+#include <stdint.h>
+
+struct sensor_value {
+    int32_t val1;
+    int32_t val2;
+};
+
+#endif /* ZEPHYR_HOST_DRIVERS_SENSOR_H_ */
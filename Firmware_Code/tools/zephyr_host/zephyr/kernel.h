@@ -0,0 +1,225 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_HOST_KERNEL_H_
+#define ZEPHYR_HOST_KERNEL_H_
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+/* ===== Host kernel =====
+ *
+ * Just enough of the Zephyr kernel API to run firmware modules unchanged
+ * in the host checks; see zephyr_host.h for how time and threads behave.
+ * One tick is one microsecond, and so is one cycle.
+ */
+
+#define CONFIG_SYS_CLOCK_TICKS_PER_SEC  1000000
+
+/* ===== Timeouts ===== */
+typedef struct {
+    int64_t us;                 /* -1 forever */
+} k_timeout_t;
+
+#define K_FOREVER           ((k_timeout_t){ -1 })
+#define K_NO_WAIT           ((k_timeout_t){ 0 })
+#define K_USEC(t)           ((k_timeout_t){ (int64_t)(t) })
+#define K_MSEC(t)           ((k_timeout_t){ (int64_t)(t) * 1000 })
+#define K_SECONDS(t)        K_MSEC((int64_t)(t) * 1000)
+#define K_TICKS_FOREVER     (-1)
+
+/* ===== Time ===== */
+int64_t k_uptime_ticks(void);
+
+static inline int64_t k_uptime_get(void)
+{
+    return k_uptime_ticks() / 1000;
+}
+
+static inline uint32_t k_uptime_get_32(void)
+{
+    return (uint32_t)k_uptime_get();
+}
+
+/* An absolute deadline as the time left to it, taken when the wait starts */
+#define K_TIMEOUT_ABS_MS(t) K_USEC(MAX((int64_t)(t) * 1000 - k_uptime_ticks(), 0))
+
+static inline uint64_t k_ticks_to_us_floor64(int64_t ticks)
+{
+    return (uint64_t)ticks;
+}
+
+static inline uint32_t k_cycle_get_32(void)
+{
+    return (uint32_t)k_uptime_ticks();
+}
+
+static inline uint32_t sys_clock_hw_cycles_per_sec(void)
+{
+    return 1000000u;
+}
+
+static inline uint32_t k_cyc_to_us_floor32(uint32_t cyc)
+{
+    return cyc;
+}
+
+static inline uint64_t k_cyc_to_ns_floor64(uint64_t cyc)
+{
+    return cyc * 1000u;
+}
+
+int32_t k_sleep(k_timeout_t timeout);
+
+static inline int32_t k_msleep(int32_t ms)
+{
+    return k_sleep(K_MSEC(ms));
+}
+
+/* Spins take no simulated time */
+static inline void k_busy_wait(uint32_t us)
+{
+    ARG_UNUSED(us);
+}
+
+void k_yield(void);
+
+/* ===== Threads ===== */
+struct zephyr_host_thread {
+    void (*entry)(void *p1, void *p2, void *p3);
+    void *p1, *p2, *p3;
+    const char *name;
+    bool started;
+};
+
+typedef struct zephyr_host_thread *k_tid_t;
+
+/* Stack size, priority and options are ignored; every thread here is
+ * created with K_TICKS_FOREVER and started by k_thread_start()
+ */
+#define K_THREAD_DEFINE(name, stack_size, fn, a1, a2, a3, prio, options, delay) \
+    static struct zephyr_host_thread name##_host = {                            \
+        (fn), (a1), (a2), (a3), #name, false                                    \
+    };                                                                          \
+    const k_tid_t name = &name##_host
+
+void k_thread_start(k_tid_t thread);
+
+static inline int k_thread_name_set(k_tid_t thread, const char *name)
+{
+    thread->name = name;
+    return 0;
+}
+
+/* ===== Spinlocks =====
+ * Only one thread runs at a time and nothing preempts it, so there is
+ * nothing to lock out
+ */
+struct k_spinlock {
+    int unused;
+};
+
+typedef int k_spinlock_key_t;
+
+static inline k_spinlock_key_t k_spin_lock(struct k_spinlock *l)
+{
+    ARG_UNUSED(l);
+    return 0;
+}
+
+static inline void k_spin_unlock(struct k_spinlock *l, k_spinlock_key_t key)
+{
+    ARG_UNUSED(l);
+    ARG_UNUSED(key);
+}
+
+/* ===== Semaphores ===== */
+struct k_sem {
+    unsigned int count;
+    unsigned int limit;
+};
+
+#define K_SEM_DEFINE(name, initial, max) struct k_sem name = { (initial), (max) }
+
+int k_sem_init(struct k_sem *sem, unsigned int initial, unsigned int limit);
+void k_sem_give(struct k_sem *sem);
+int k_sem_take(struct k_sem *sem, k_timeout_t timeout);
+
+static inline unsigned int k_sem_count_get(struct k_sem *sem)
+{
+    return sem->count;
+}
+
+static inline void k_sem_reset(struct k_sem *sem)
+{
+    sem->count = 0;
+}
+
+/* ===== Mutexes ===== */
+struct k_mutex {
+    void *owner;
+    unsigned int lock_count;
+};
+
+#define K_MUTEX_DEFINE(name) struct k_mutex name
+
+int k_mutex_init(struct k_mutex *mutex);
+int k_mutex_lock(struct k_mutex *mutex, k_timeout_t timeout);
+int k_mutex_unlock(struct k_mutex *mutex);
+
+/* ===== Message queues ===== */
+struct k_msgq {
+    size_t msg_size;
+    uint32_t max_msgs;
+    char *buffer_start;
+    uint32_t read_idx;
+    uint32_t used_msgs;
+};
+
+/* Alignment is ignored */
+#define K_MSGQ_DEFINE(name, size, max, align)                   \
+    static char name##_buf[(size) * (max)];                     \
+    struct k_msgq name = { (size), (max), name##_buf, 0, 0 }
+
+int k_msgq_put(struct k_msgq *msgq, const void *data, k_timeout_t timeout);
+int k_msgq_get(struct k_msgq *msgq, void *data, k_timeout_t timeout);
+void k_msgq_purge(struct k_msgq *msgq);
+
+static inline uint32_t k_msgq_num_used_get(struct k_msgq *msgq)
+{
+    return msgq->used_msgs;
+}
+
+/* ===== Timers =====
+ * Expiry functions run on the thread that advances time, as they would in
+ * the system clock ISR
+ */
+struct k_timer {
+    void (*expiry_fn)(struct k_timer *timer);
+    void (*stop_fn)(struct k_timer *timer);
+    uint64_t expiry_us;
+    uint64_t period_us;
+    uint32_t status;
+    bool running;
+    bool listed;
+    struct k_timer *next;
+    void *user_data;
+};
+
+#define K_TIMER_DEFINE(name, expiry, stop) \
+    struct k_timer name = { .expiry_fn = (expiry), .stop_fn = (stop) }
+
+void k_timer_init(struct k_timer *timer, void (*expiry_fn)(struct k_timer *),
+                  void (*stop_fn)(struct k_timer *));
+void k_timer_start(struct k_timer *timer, k_timeout_t duration, k_timeout_t period);
+void k_timer_stop(struct k_timer *timer);
+uint32_t k_timer_status_get(struct k_timer *timer);
+uint32_t k_timer_status_sync(struct k_timer *timer);
+
+#endif /* ZEPHYR_HOST_KERNEL_H_ */
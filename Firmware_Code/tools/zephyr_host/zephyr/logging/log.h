@@ -0,0 +1,33 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_HOST_LOGGING_LOG_H_
+#define ZEPHYR_HOST_LOGGING_LOG_H_
+
+/* Messages go to stderr when zephyr_host_log is set (zephyr_host.h) */
+extern int zephyr_host_log;
+void zephyr_host_log_msg(const char *lvl, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+#define LOG_LEVEL_ERR   1
+#define LOG_LEVEL_WRN   2
+#define LOG_LEVEL_INF   3
+#define LOG_LEVEL_DBG   4
+
+#define LOG_MODULE_REGISTER(...)
+#define LOG_MODULE_DECLARE(...)
+
+#define Z_HOST_LOG(lvl, ...)                                \
+    do {                                                    \
+        if (zephyr_host_log) {                              \
+            zephyr_host_log_msg(lvl, __VA_ARGS__);          \
+        }                                                   \
+    } while (0)
+
+#define LOG_ERR(...)    Z_HOST_LOG("err", __VA_ARGS__)
+#define LOG_WRN(...)    Z_HOST_LOG("wrn", __VA_ARGS__)
+#define LOG_INF(...)    Z_HOST_LOG("inf", __VA_ARGS__)
+#define LOG_DBG(...)    Z_HOST_LOG("dbg", __VA_ARGS__)
+
+#endif /* ZEPHYR_HOST_LOGGING_LOG_H_ */
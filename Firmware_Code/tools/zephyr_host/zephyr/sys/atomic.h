@@ -0,0 +1,81 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_HOST_SYS_ATOMIC_H_
+#define ZEPHYR_HOST_SYS_ATOMIC_H_
+
+#include <stdbool.h>
+
+typedef long atomic_t;
+typedef long atomic_val_t;
+
+#define ATOMIC_INIT(v)  (v)
+#define ATOMIC_BITS     (sizeof(atomic_val_t) * 8)
+
+static inline atomic_val_t atomic_get(const atomic_t *t)
+{
+    return __atomic_load_n(t, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_set(atomic_t *t, atomic_val_t v)
+{
+    return __atomic_exchange_n(t, v, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_clear(atomic_t *t)
+{
+    return atomic_set(t, 0);
+}
+
+static inline atomic_val_t atomic_add(atomic_t *t, atomic_val_t v)
+{
+    return __atomic_fetch_add(t, v, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_sub(atomic_t *t, atomic_val_t v)
+{
+    return __atomic_fetch_sub(t, v, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_inc(atomic_t *t)
+{
+    return atomic_add(t, 1);
+}
+
+static inline atomic_val_t atomic_dec(atomic_t *t)
+{
+    return atomic_sub(t, 1);
+}
+
+static inline atomic_val_t atomic_or(atomic_t *t, atomic_val_t v)
+{
+    return __atomic_fetch_or(t, v, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_and(atomic_t *t, atomic_val_t v)
+{
+    return __atomic_fetch_and(t, v, __ATOMIC_SEQ_CST);
+}
+
+static inline bool atomic_cas(atomic_t *t, atomic_val_t old, atomic_val_t v)
+{
+    return __atomic_compare_exchange_n(t, &old, v, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline bool atomic_test_bit(const atomic_t *t, int bit)
+{
+    return (atomic_get(t) >> bit) & 1;
+}
+
+static inline void atomic_set_bit(atomic_t *t, int bit)
+{
+    atomic_or(t, 1L << bit);
+}
+
+static inline void atomic_clear_bit(atomic_t *t, int bit)
+{
+    atomic_and(t, ~(1L << bit));
+}
+
+#endif /* ZEPHYR_HOST_SYS_ATOMIC_H_ */
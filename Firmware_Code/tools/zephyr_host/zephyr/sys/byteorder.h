@@ -0,0 +1,32 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_HOST_SYS_BYTEORDER_H_
+#define ZEPHYR_HOST_SYS_BYTEORDER_H_
+
+#include <stdint.h>
+
+static inline uint16_t sys_get_le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline void sys_put_le16(uint16_t v, uint8_t *p)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline uint32_t sys_get_le32(const uint8_t *p)
+{
+    return sys_get_le16(p) | ((uint32_t)sys_get_le16(p + 2) << 16);
+}
+
+static inline void sys_put_le32(uint32_t v, uint8_t *p)
+{
+    sys_put_le16((uint16_t)v, p);
+    sys_put_le16((uint16_t)(v >> 16), p + 2);
+}
+
+#endif /* ZEPHYR_HOST_SYS_BYTEORDER_H_ */
@@ -0,0 +1,38 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_HOST_SYS_UTIL_H_
+#define ZEPHYR_HOST_SYS_UTIL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* The subset of Zephyr's sys/util.h the firmware modules use */
+
+#define MIN(a, b)               ((a) < (b) ? (a) : (b))
+#define MAX(a, b)               ((a) > (b) ? (a) : (b))
+#define CLAMP(v, lo, hi)        MIN(MAX(v, lo), hi)
+#define BIT(n)                  (1UL << (n))
+#define BIT_MASK(n)             (BIT(n) - 1UL)
+#define ARRAY_SIZE(a)           (sizeof(a) / sizeof((a)[0]))
+#define ARG_UNUSED(x)           (void)(x)
+#define IS_POWER_OF_TWO(x)      (((x) != 0) && (((x) & ((x) - 1)) == 0))
+#define DIV_ROUND_UP(n, d)      (((n) + (d) - 1) / (d))
+#define ROUND_UP(x, a)          (DIV_ROUND_UP(x, a) * (a))
+#define CONTAINER_OF(p, t, f)   ((t *)((char *)(p) - offsetof(t, f)))
+#define BUILD_ASSERT(cond, ...) _Static_assert(cond, "" __VA_ARGS__)
+
+#define UTIL_PRIMITIVE_CAT(a, ...)  a##__VA_ARGS__
+#define UTIL_CAT(a, ...)            UTIL_PRIMITIVE_CAT(a, __VA_ARGS__)
+
+/* IS_ENABLED(CONFIG_X): 1 when CONFIG_X is defined to 1, 0 otherwise */
+#define Z_IS_ENABLED1(config)       Z_IS_ENABLED2(_XXXX##config)
+#define _XXXX1                      _YYYY,
+#define Z_IS_ENABLED2(one_or_two)   Z_IS_ENABLED3(one_or_two 1, 0)
+#define Z_IS_ENABLED3(ignore, val, ...) val
+#define IS_ENABLED(config)          Z_IS_ENABLED1(config)
+
+#define __packed                __attribute__((__packed__))
+
+#endif /* ZEPHYR_HOST_SYS_UTIL_H_ */
@@ -0,0 +1,436 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "zephyr_host.h"
+
+/* ===== Scheduler =====
+ * Every thread runs holding big and gives it up only to wait. A waiting
+ * thread sleeps on changed, which is broadcast whenever kernel state
+ * changes; main() waits on main_cond while it lets the others run.
+ */
+#define THREADS_MAX     16
+#define NEVER           UINT64_MAX
+
+struct slot {
+    k_tid_t tid;                /* NULL: the check's main() */
+    bool waiting;
+    bool (*ready)(const void *arg);
+    const void *arg;
+    uint64_t deadline_us;
+};
+
+int zephyr_host_log;
+
+static pthread_mutex_t big = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t main_cond = PTHREAD_COND_INITIALIZER;
+static struct slot slots[THREADS_MAX];
+static size_t n_slots;
+static __thread struct slot *self;
+
+static uint64_t now_us;
+static struct k_timer *timers;
+static uint32_t timer_fires;
+
+__attribute__((constructor)) static void host_init(void)
+{
+    pthread_mutex_lock(&big);
+    self = &slots[n_slots++];
+}
+
+static bool always(const void *arg)
+{
+    ARG_UNUSED(arg);
+    return true;
+}
+
+static bool slot_ready(const struct slot *s)
+{
+    return s->waiting && ((s->ready && s->ready(s->arg)) || now_us >= s->deadline_us);
+}
+
+static bool others_ready(void)
+{
+    for (size_t i = 1; i < n_slots; i++) {
+        if (slot_ready(&slots[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void zephyr_host_settle(void)
+{
+    if (self != &slots[0]) {
+        return;
+    }
+    while (others_ready()) {
+        pthread_cond_broadcast(&changed);
+        pthread_cond_wait(&main_cond, &big);
+    }
+}
+
+/* ===== Time ===== */
+static uint64_t next_event(void)
+{
+    uint64_t next = NEVER;
+
+    for (struct k_timer *t = timers; t; t = t->next) {
+        if (t->running) {
+            next = MIN(next, t->expiry_us);
+        }
+    }
+    for (size_t i = 1; i < n_slots; i++) {
+        if (slots[i].waiting) {
+            next = MIN(next, slots[i].deadline_us);
+        }
+    }
+    return next;
+}
+
+static void step_to(uint64_t t_us)
+{
+    now_us = MAX(now_us, t_us);
+    for (struct k_timer *t = timers; t; t = t->next) {
+        while (t->running && t->expiry_us <= now_us) {
+            t->status++;
+            timer_fires++;
+            if (t->period_us) {
+                t->expiry_us += t->period_us;
+            } else {
+                t->running = false;
+            }
+            if (t->expiry_fn) {
+                t->expiry_fn(t);
+            }
+        }
+    }
+}
+
+void zephyr_host_advance_us(uint64_t us)
+{
+    uint64_t end = now_us + us;
+
+    zephyr_host_settle();
+    for (uint64_t next = next_event(); next <= end; next = next_event()) {
+        step_to(next);
+        zephyr_host_settle();
+    }
+    now_us = end;
+    zephyr_host_settle();
+}
+
+uint32_t zephyr_host_timer_fires(void)
+{
+    return timer_fires;
+}
+
+int64_t k_uptime_ticks(void)
+{
+    return (int64_t)now_us;
+}
+
+/* ===== Waiting ===== */
+static uint64_t deadline(k_timeout_t timeout)
+{
+    return timeout.us < 0 ? NEVER : now_us + (uint64_t)timeout.us;
+}
+
+/* main() waiting runs the others and, when they are all stuck, time */
+static bool main_wait(bool (*ready)(const void *), const void *arg, uint64_t until)
+{
+    for (;;) {
+        zephyr_host_settle();
+        if (ready && ready(arg)) {
+            return true;
+        }
+        if (now_us >= until) {
+            return false;
+        }
+
+        uint64_t next = MIN(next_event(), until);
+
+        if (next == NEVER) {
+            fprintf(stderr, "zephyr_host: main() would wait forever\n");
+            abort();
+        }
+        step_to(next);
+    }
+}
+
+/* True once ready(arg), false at the deadline */
+static bool wait_until(bool (*ready)(const void *), const void *arg, uint64_t until)
+{
+    struct slot *s = self;
+
+    if (ready && ready(arg)) {
+        return true;
+    }
+    if (now_us >= until) {
+        return false;
+    }
+    if (s == &slots[0]) {
+        return main_wait(ready, arg, until);
+    }
+    s->ready = ready;
+    s->arg = arg;
+    s->deadline_us = until;
+    s->waiting = true;
+    do {
+        pthread_cond_signal(&main_cond);
+        pthread_cond_wait(&changed, &big);
+    } while (!slot_ready(s));
+    s->waiting = false;
+    return ready && ready(arg);
+}
+
+int32_t k_sleep(k_timeout_t timeout)
+{
+    wait_until(NULL, NULL, deadline(timeout));
+    return 0;
+}
+
+void k_yield(void)
+{
+}
+
+/* ===== Threads ===== */
+static void *thread_main(void *arg)
+{
+    struct slot *s = arg;
+
+    pthread_mutex_lock(&big);
+    self = s;
+    while (!slot_ready(s)) {
+        pthread_cond_signal(&main_cond);
+        pthread_cond_wait(&changed, &big);
+    }
+    s->waiting = false;
+    s->tid->entry(s->tid->p1, s->tid->p2, s->tid->p3);
+
+    /* Returned: never runs again */
+    s->ready = NULL;
+    s->deadline_us = NEVER;
+    s->waiting = true;
+    pthread_cond_signal(&main_cond);
+    pthread_mutex_unlock(&big);
+    return NULL;
+}
+
+void k_thread_start(k_tid_t thread)
+{
+    pthread_t pt;
+
+    if (thread->started) {
+        return;
+    }
+    if (n_slots == THREADS_MAX) {
+        fprintf(stderr, "zephyr_host: more than %d threads\n", THREADS_MAX);
+        abort();
+    }
+
+    struct slot *s = &slots[n_slots++];
+
+    *s = (struct slot){ .tid = thread, .waiting = true, .ready = always, .deadline_us = NEVER };
+    thread->started = true;
+    if (pthread_create(&pt, NULL, thread_main, s) != 0) {
+        abort();
+    }
+    pthread_detach(pt);
+}
+
+/* ===== Semaphores ===== */
+static bool sem_ready(const void *arg)
+{
+    const struct k_sem *sem = arg;
+
+    return sem->count > 0;
+}
+
+int k_sem_init(struct k_sem *sem, unsigned int initial, unsigned int limit)
+{
+    sem->count = initial;
+    sem->limit = limit;
+    return 0;
+}
+
+void k_sem_give(struct k_sem *sem)
+{
+    if (sem->count < sem->limit) {
+        sem->count++;
+    }
+    pthread_cond_broadcast(&changed);
+}
+
+int k_sem_take(struct k_sem *sem, k_timeout_t timeout)
+{
+    if (!wait_until(sem_ready, sem, deadline(timeout))) {
+        return timeout.us == 0 ? -EBUSY : -EAGAIN;
+    }
+    sem->count--;
+    return 0;
+}
+
+/* ===== Mutexes ===== */
+static bool mutex_free(const void *arg)
+{
+    const struct k_mutex *m = arg;
+
+    return m->owner == NULL;
+}
+
+int k_mutex_init(struct k_mutex *mutex)
+{
+    mutex->owner = NULL;
+    mutex->lock_count = 0;
+    return 0;
+}
+
+int k_mutex_lock(struct k_mutex *mutex, k_timeout_t timeout)
+{
+    if (mutex->owner != self && !wait_until(mutex_free, mutex, deadline(timeout))) {
+        return timeout.us == 0 ? -EBUSY : -EAGAIN;
+    }
+    mutex->owner = self;
+    mutex->lock_count++;
+    return 0;
+}
+
+int k_mutex_unlock(struct k_mutex *mutex)
+{
+    if (mutex->owner != self) {
+        return -EPERM;
+    }
+    if (--mutex->lock_count == 0) {
+        mutex->owner = NULL;
+        pthread_cond_broadcast(&changed);
+    }
+    return 0;
+}
+
+/* ===== Message queues ===== */
+static bool msgq_room(const void *arg)
+{
+    const struct k_msgq *q = arg;
+
+    return q->used_msgs < q->max_msgs;
+}
+
+static bool msgq_any(const void *arg)
+{
+    const struct k_msgq *q = arg;
+
+    return q->used_msgs > 0;
+}
+
+int k_msgq_put(struct k_msgq *msgq, const void *data, k_timeout_t timeout)
+{
+    if (!wait_until(msgq_room, msgq, deadline(timeout))) {
+        return timeout.us == 0 ? -ENOMSG : -EAGAIN;
+    }
+
+    uint32_t i = (msgq->read_idx + msgq->used_msgs) % msgq->max_msgs;
+
+    memcpy(msgq->buffer_start + i * msgq->msg_size, data, msgq->msg_size);
+    msgq->used_msgs++;
+    pthread_cond_broadcast(&changed);
+    return 0;
+}
+
+int k_msgq_get(struct k_msgq *msgq, void *data, k_timeout_t timeout)
+{
+    if (!wait_until(msgq_any, msgq, deadline(timeout))) {
+        return timeout.us == 0 ? -ENOMSG : -EAGAIN;
+    }
+    memcpy(data, msgq->buffer_start + msgq->read_idx * msgq->msg_size, msgq->msg_size);
+    msgq->read_idx = (msgq->read_idx + 1) % msgq->max_msgs;
+    msgq->used_msgs--;
+    pthread_cond_broadcast(&changed);
+    return 0;
+}
+
+void k_msgq_purge(struct k_msgq *msgq)
+{
+    msgq->read_idx = 0;
+    msgq->used_msgs = 0;
+    pthread_cond_broadcast(&changed);
+}
+
+/* ===== Timers ===== */
+static bool timer_done(const void *arg)
+{
+    const struct k_timer *t = arg;
+
+    return t->status > 0 || !t->running;
+}
+
+void k_timer_init(struct k_timer *timer, void (*expiry_fn)(struct k_timer *),
+                  void (*stop_fn)(struct k_timer *))
+{
+    timer->expiry_fn = expiry_fn;
+    timer->stop_fn = stop_fn;
+    timer->running = false;
+    timer->status = 0;
+}
+
+void k_timer_start(struct k_timer *timer, k_timeout_t duration, k_timeout_t period)
+{
+    if (duration.us < 0) {
+        return;
+    }
+    if (!timer->listed) {
+        timer->next = timers;
+        timers = timer;
+        timer->listed = true;
+    }
+    timer->expiry_us = now_us + (uint64_t)duration.us;
+    timer->period_us = period.us > 0 ? (uint64_t)period.us : 0;
+    timer->status = 0;
+    timer->running = true;
+    pthread_cond_broadcast(&changed);
+}
+
+void k_timer_stop(struct k_timer *timer)
+{
+    if (!timer->running) {
+        return;
+    }
+    timer->running = false;
+    if (timer->stop_fn) {
+        timer->stop_fn(timer);
+    }
+    pthread_cond_broadcast(&changed);
+}
+
+uint32_t k_timer_status_get(struct k_timer *timer)
+{
+    uint32_t status = timer->status;
+
+    timer->status = 0;
+    return status;
+}
+
+uint32_t k_timer_status_sync(struct k_timer *timer)
+{
+    wait_until(timer_done, timer, NEVER);
+    return k_timer_status_get(timer);
+}
+
+/* ===== Logging ===== */
+void zephyr_host_log_msg(const char *lvl, const char *fmt, ...)
+{
+    va_list ap;
+
+    fprintf(stderr, "[%10.3f ms] <%s> ", now_us / 1000.0, lvl);
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+}
@@ -0,0 +1,43 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_HOST_H_
+#define ZEPHYR_HOST_H_
+
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+
+/* ===== Host kernel for the checks =====
+ *
+ * The firmware's Zephyr modules (imu_acq.c, the emul backends, ...) build
+ * against the headers next to this one and run on the host unchanged.
+ *
+ * Time is simulated and only moves when the check's main() advances it:
+ * k_timer expiries fire in order on the way, and a thread sleeping or
+ * waiting with a timeout wakes at its deadline. Threads are pthreads, but
+ * only one runs at a time and only until it blocks, like a single core
+ * without preemption: the check's main() keeps running until it advances
+ * time or calls zephyr_host_settle(). Priorities are ignored. If main()
+ * itself blocks (k_sleep, a semaphore), time advances until it can go on.
+ */
+
+/* Log messages from the modules to stderr */
+extern int zephyr_host_log;
+
+/* Let every thread that can run do so, until all of them wait */
+void zephyr_host_settle(void);
+
+/* Advance simulated time, firing timers and waking threads on the way */
+void zephyr_host_advance_us(uint64_t us);
+
+static inline void zephyr_host_advance_ms(uint64_t ms)
+{
+    zephyr_host_advance_us(ms * 1000u);
+}
+
+/* k_timer expiries so far, all timers: each one a wakeup on the device */
+uint32_t zephyr_host_timer_fires(void);
+
+#endif /* ZEPHYR_HOST_H_ */
@@ -0,0 +1,239 @@
+#include "ble_link.h"
+
+const char* linkStateName(LinkState s) {
+  switch (s) {
+    case LinkState::Idle:        return "idle";
+    case LinkState::Scanning:    return "scanning";
+    case LinkState::Connecting:  return "connecting";
+    case LinkState::Discovering: return "discovering";
+    case LinkState::Ready:       return "ready";
+    case LinkState::Backoff:     return "backoff";
+  }
+  return "?";
+}
+
+/************** Callbacks (NimBLE host task) **************/
+void BleLink::onScanHit(const char* addr, uint8_t addrType) {
+  Event e = {Event::ScanHit, addrType, 0, {}};
+  strncpy(e.addr, addr, sizeof(e.addr) - 1);
+  events_.push(e);
+}
+
+void BleLink::onScanDone() {
+  Event e = {Event::ScanDone, 0, 0, {}};
+  events_.push(e);
+}
+
+void BleLink::onDisconnected() {
+  Event e = {Event::Disconnected, 0, 0, {}};
+  events_.push(e);
+}
+
+void BleLink::onFrame(const uint8_t* buf, size_t len) {
+  Event e = {Event::Frame, 0, 0, {}};
+  // A longer one only loses NAKs at the end
+  e.len = (uint8_t)(len < sizeof(e.data) ? len : sizeof(e.data));
+  memcpy(e.data, buf, e.len);
+  events_.push(e);
+}
+
+/************** State machine (BLE task) **************/
+void BleLink::enter(LinkState s) {
+  state_.store(s, std::memory_order_relaxed);
+}
+
+void BleLink::scan(uint32_t now) {
+  st_.scans++;
+  if (be_.startScan(SCAN_MS)) {
+    enter(LinkState::Scanning);
+  } else {
+    fail(now);
+  }
+}
+
+// Wait, then scan again; each failure in a row doubles the wait
+void BleLink::fail(uint32_t now) {
+  until_ = now + backoff_;
+  backoff_ = backoff_ * 2 > BACKOFF_MAX_MS ? BACKOFF_MAX_MS : backoff_ * 2;
+  enter(LinkState::Backoff);
+}
+
+void BleLink::start(uint32_t now) {
+  if (state() == LinkState::Idle) scan(now);
+}
+
+void BleLink::handle(const Event& e, uint32_t now) {
+  switch (e.kind) {
+    case Event::ScanHit:
+      // Later hits of the same window are stale once we moved on
+      if (state() != LinkState::Scanning) return;
+      be_.stopScan();
+      memcpy(hitAddr_, e.addr, sizeof(hitAddr_));
+      hitType_ = e.addrType;
+      enter(LinkState::Connecting);
+      return;
+
+    case Event::ScanDone:
+      if (state() == LinkState::Scanning) fail(now);
+      return;
+
+    case Event::Disconnected:
+      // Also reported for our own disconnect() after a failed discovery;
+      // only a drop out of Ready counts
+      if (state() != LinkState::Ready) return;
+      st_.disconnects++;
+      backoff_ = BACKOFF_MIN_MS;
+      fail(now);
+      return;
+
+    case Event::Frame:
+      if (state() == LinkState::Ready && framed_) cmdp_tx_ack(&tx_, e.data, e.len, now);
+      return;
+  }
+}
+
+// Connecting -> Discovering -> Ready, or Backoff
+void BleLink::attach(uint32_t now) {
+  st_.connects++;
+  if (!be_.connect(hitAddr_, hitType_)) {
+    st_.failures++;
+    fail(now);
+    return;
+  }
+  enter(LinkState::Discovering);
+  if (!be_.discover()) {
+    st_.failures++;
+    be_.disconnect();
+    fail(now);
+    return;
+  }
+  backoff_ = BACKOFF_MIN_MS;
+  // The patch numbers from 0 again on every connection
+  cmdp_tx_init(&tx_);
+  framed_ = be_.framed();
+  if (wantStream_) be_.stream(true);
+  enter(LinkState::Ready);
+}
+
+void BleLink::scanHit(const char* addr, uint8_t addrType, uint32_t now) {
+  Event e = {Event::ScanHit, addrType, 0, {}};
+  strncpy(e.addr, addr, sizeof(e.addr) - 1);
+  handle(e, now);
+}
+
+void BleLink::scanDone(uint32_t now) {
+  Event e = {Event::ScanDone, 0, 0, {}};
+  handle(e, now);
+}
+
+void BleLink::halt() {
+  LinkCommand c;
+  Event e;
+
+  if (state() == LinkState::Scanning) be_.stopScan();
+  if (state() == LinkState::Ready) be_.disconnect();
+  while (cmds_.pop(c)) {
+  }
+  while (events_.pop(e)) {
+  }
+  cmdp_tx_init(&tx_);
+  st_ = LinkStats();
+  backoff_ = BACKOFF_MIN_MS;
+  framed_ = false;
+  wantStream_ = false;
+  enter(LinkState::Idle);
+}
+
+void BleLink::handle(const LinkCommand& c, uint32_t now) {
+  switch (c.kind) {
+    case LinkCommand::Send: {
+      bool ok = false;
+      if (state() != LinkState::Ready) {
+        // not connected: fails
+      } else if (framed_) {
+        // Sent by pump() at the end of this step, batched with the others
+        ok = cmdp_tx_queue(&tx_, c.type, c.val, c.len) >= 0;
+      } else if (c.type == CMDP_T_LED && c.len == 1) {
+        static const uint8_t legacy[] = {'0', '1', 'T'};
+        ok = c.val[0] < sizeof(legacy) && be_.write(legacy[c.val[0]]);
+      }
+      if (ok) {
+        st_.writes++;
+      } else {
+        st_.writeFails++;
+      }
+      return;
+    }
+
+    case LinkCommand::Stream:
+      // The patch only streams (and keeps the fast link parameters) while
+      // someone watches
+      wantStream_ = c.val[0] != 0;
+      if (state() == LinkState::Ready) be_.stream(wantStream_);
+      return;
+
+    case LinkCommand::Journal:
+      if (state() == LinkState::Ready && be_.journal(c.val, c.len)) {
+        st_.writes++;
+      } else {
+        st_.writeFails++;
+      }
+      return;
+
+    case LinkCommand::Reconnect:
+      // New target settings: drop whatever we were doing and scan now
+      if (state() == LinkState::Scanning) be_.stopScan();
+      if (state() == LinkState::Ready) be_.disconnect();
+      backoff_ = BACKOFF_MIN_MS;
+      scan(now);
+      return;
+  }
+}
+
+// Put queued (or rewound) commands on the air, as many per write as the MTU
+// allows; a full NimBLE buffer leaves the rest for the next step
+void BleLink::pump(uint32_t now, int frames) {
+  uint8_t buf[256];
+  size_t cap = be_.payload();
+
+  if (cap > sizeof(buf)) cap = sizeof(buf);
+  for (int i = 0; i < frames; i++) {
+    uint8_t n;
+    size_t len = cmdp_tx_frame(&tx_, now, buf, cap, &n);
+    if (len == 0) break;
+    if (!be_.writeFrame(buf, len)) {
+      blocked_ = true;
+      break;
+    }
+    cmdp_tx_sent(&tx_, n, now);
+  }
+}
+
+void BleLink::step(uint32_t now, int frames) {
+  LinkCommand c;
+  Event e;
+
+  blocked_ = false;
+  if (state() == LinkState::Idle) return;
+  while (events_.pop(e)) handle(e, now);
+  if (state() == LinkState::Connecting && be_.mayConnect()) attach(now);
+  // With the protocol window full, commands wait in the queue; once that is
+  // full too, command() fails and the HTTP handler reports it
+  while (!(ready() && framed_ && cmdp_tx_pending(&tx_) >= CMDP_WINDOW) && cmds_.pop(c)) {
+    handle(c, now);
+  }
+  if (state() == LinkState::Ready && framed_) pump(now, frames);
+  if (state() == LinkState::Backoff && (int32_t)(now - until_) >= 0) scan(now);
+}
+
+LinkStats BleLink::stats() const {
+  LinkStats s = st_;
+  s.cmdDrops = cmds_.drops();
+  s.eventDrops = events_.drops();
+  s.frames = tx_.frames;
+  s.resends = tx_.resends;
+  s.inflight = cmdp_tx_pending(&tx_);
+  s.naks = tx_.naks;
+  s.lastNakErr = tx_.last_nak_err;
+  return s;
+}
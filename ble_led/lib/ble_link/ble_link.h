@@ -0,0 +1,167 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "cmd_proto.h"
+#include "spsc_queue.h"
+
+/************** BLE link state machine **************/
+// Connection management for the patch, independent of NimBLE and Arduino so
+// it also builds on the host (tools/link_check drives it with a mocked
+// backend). Runs on the BLE task only: step() drains the queues, advances
+// the state and returns; nothing here waits on the radio except the
+// backend's connect()/discover(), which block the BLE task, never loop().
+//
+//   Idle -start-> Scanning -hit-> Connecting -ok-> Discovering -ok-> Ready
+//                    |               |fail            |fail            |
+//                    +--scan done----+----------------+------> Backoff  |
+//                    ^                                            |     |
+//                    +------------- backoff elapsed --------------+     |
+//   Ready -disconnected-> Backoff (shortest delay)                      |
+//   any  -Reconnect command-> Scanning at once -------------------------+
+//
+// Backoff doubles from BACKOFF_MIN_MS to BACKOFF_MAX_MS on every failed
+// attempt and resets once Ready.
+//
+// A scan hit only moves to Connecting; the connect itself happens in the
+// next step() the backend allows it (mayConnect()), which is right away for
+// a single link. With several links (link_pool.h) the pool shares one
+// scanner between them, feeds them hits through scanHit()/scanDone() and
+// lets one connect at a time.
+//
+// Commands go out in the framed protocol (shared/cmd_proto.h) when the peer
+// has the protocol characteristic: queued in a cmdp_tx window, packed into
+// MTU-sized writes without response and released by the ACK notifications.
+// Peers without it only get LED commands, as the legacy '1'/'0'/'T' byte.
+
+enum class LinkState : uint8_t { Idle, Scanning, Connecting, Discovering, Ready, Backoff };
+
+const char* linkStateName(LinkState s);
+
+// Implemented with NimBLE in main.cpp and mocked in tools/link_check
+class LinkBackend {
+ public:
+  virtual ~LinkBackend() {}
+  // Asynchronous: matching devices arrive as onScanHit(), the end of the
+  // window as onScanDone()
+  virtual bool startScan(uint32_t ms) = 0;
+  virtual void stopScan() = 0;
+  // Synchronous on the BLE task
+  virtual bool connect(const char* addr, uint8_t addrType) = 0;
+  // Finds the command characteristic, and the protocol one if present
+  // (subscribed to its ACK notifications)
+  virtual bool discover() = 0;
+  virtual void disconnect() = 0;
+  // Legacy single-byte command
+  virtual bool write(uint8_t value) = 0;
+  // Telemetry stream notifications on/off; after a successful discover()
+  virtual bool stream(bool on) = 0;
+  // Protocol: after a successful discover()
+  virtual bool framed() = 0;
+  virtual size_t payload() = 0;                             // ATT MTU - 3
+  virtual bool writeFrame(const uint8_t* buf, size_t len) = 0;  // false: no buffer
+  // Journal request (shared/journal_wire.h); false without the journal
+  // characteristic or a buffer
+  virtual bool journal(const uint8_t* /*buf*/, size_t /*len*/) { return false; }
+  // Whether connect() may run in this step
+  virtual bool mayConnect() { return true; }
+};
+
+// Requests from other tasks (HTTP handlers, serial): one protocol command
+// (CMDP_T_*), a reconnect with new target settings, the telemetry stream
+// wanted (val[0] != 0) or not, or a journal request (struct jrnl_req in
+// val)
+struct LinkCommand {
+  enum Kind : uint8_t { Send, Reconnect, Stream, Journal } kind;
+  uint8_t type;
+  uint8_t len;
+  uint8_t val[CMDP_VAL_MAX];
+};
+
+struct LinkStats {
+  uint32_t scans;
+  uint32_t connects;        // attempts
+  uint32_t failures;        // connect or discovery failures
+  uint32_t disconnects;     // drops out of Ready
+  uint32_t writes;          // commands queued / legacy bytes written
+  uint32_t writeFails;      // failed, or not Ready
+  uint32_t cmdDrops;        // command queue full
+  uint32_t eventDrops;      // event queue full
+  uint32_t frames;          // protocol writes
+  uint32_t resends;         // go-back-N rewinds
+  uint32_t inflight;        // commands not acknowledged yet
+  uint32_t naks;            // commands the patch rejected
+  uint8_t lastNakErr;       // errno of the last one
+};
+
+class BleLink {
+ public:
+  static const uint32_t SCAN_MS = 3000;
+  static const uint32_t BACKOFF_MIN_MS = 1000;
+  static const uint32_t BACKOFF_MAX_MS = 30000;
+  static const int FRAMES_PER_STEP = 8;     // bounds the time in one step()
+
+  explicit BleLink(LinkBackend& be) : be_(be) { cmdp_tx_init(&tx_); }
+
+  // ---- Any task (one producer per queue) ----
+  bool command(const LinkCommand& c) { return cmds_.push(c); }
+
+  // ---- NimBLE host task callbacks ----
+  void onScanHit(const char* addr, uint8_t addrType);
+  void onScanDone();
+  void onDisconnected();
+  void onFrame(const uint8_t* buf, size_t len);   // ACK notification
+
+  // ---- BLE task ----
+  void start(uint32_t now);
+  void step(uint32_t now, int frames = FRAMES_PER_STEP);
+  // Scan results from a scanner shared with other links (LinkPool)
+  void scanHit(const char* addr, uint8_t addrType, uint32_t now);
+  void scanDone(uint32_t now);
+  // Back to Idle with fresh stats and no queued commands, before the
+  // slot is reused for another peer
+  void halt();
+
+  // ---- Readers on any task ----
+  LinkState state() const { return state_.load(std::memory_order_relaxed); }
+  bool ready() const { return state() == LinkState::Ready; }
+  // Torn reads are possible; fine for a status page
+  LinkStats stats() const;
+  uint32_t backoffMs() const { return backoff_; }
+  // The last step() ran out of NimBLE buffers with frames left to send
+  bool blocked() const { return blocked_; }
+
+ private:
+  struct Event {
+    enum Kind : uint8_t { ScanHit, ScanDone, Disconnected, Frame } kind;
+    uint8_t addrType;       // ScanHit
+    uint8_t len;            // Frame
+    union {
+      char addr[18];
+      uint8_t data[32];     // ACK + CMDP_NAK_MAX NAKs
+    };
+  };
+
+  void enter(LinkState s);
+  void scan(uint32_t now);
+  void fail(uint32_t now);
+  void handle(const Event& e, uint32_t now);
+  void handle(const LinkCommand& c, uint32_t now);
+  void attach(uint32_t now);
+  void pump(uint32_t now, int frames);
+
+  LinkBackend& be_;
+  std::atomic<LinkState> state_{LinkState::Idle};
+  SpscQueue<LinkCommand, 16> cmds_;
+  SpscQueue<Event, 16> events_;
+  char hitAddr_[18] = {0};   // Connecting: the peer to connect to
+  uint8_t hitType_ = 0;
+  uint32_t until_ = 0;
+  uint32_t backoff_ = BACKOFF_MIN_MS;
+  LinkStats st_ = {};
+  cmdp_tx tx_;
+  bool framed_ = false;
+  bool wantStream_ = false;   // kept across reconnects
+  bool blocked_ = false;
+};
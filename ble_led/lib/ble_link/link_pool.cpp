@@ -0,0 +1,262 @@
+#include "link_pool.h"
+
+#include <stdio.h>
+#include <strings.h>
+
+LinkPool::LinkPool(PoolRadio& radio, int slots)
+    : radio_(radio), n_(slots < 1 ? 1 : slots > MAX_SLOTS ? MAX_SLOTS : slots) {
+  for (int i = 0; i < MAX_SLOTS; i++) {
+    slot_[i].be.pool = this;
+    slot_[i].be.slot = i;
+  }
+}
+
+/************** Slot backends (BLE task) **************/
+// A link's scan is only a window on the shared scanner
+bool LinkPool::SlotBackend::startScan(uint32_t ms) {
+  Slot& s = pool->slot_[slot];
+  s.wantScan = true;
+  s.scanUntil = pool->now_ + ms;
+  return true;
+}
+
+void LinkPool::SlotBackend::stopScan() {
+  pool->slot_[slot].wantScan = false;
+}
+
+bool LinkPool::SlotBackend::connect(const char* addr, uint8_t addrType) {
+  LinkPool* p = pool;
+  uint16_t itvl = p->targetInterval(p->connected() + 1);
+  p->grant_ = -1;           // one connect per turn
+  p->slot_[slot].itvl = itvl;
+  return p->radio_.connect(slot, addr, addrType, itvl);
+}
+
+/************** Setup and requests **************/
+void LinkPool::load(const DeviceCfg* cfg, const bool* used, int n) {
+  std::lock_guard<std::mutex> g(tableLock_);
+  for (int i = 0; i < n && i < n_; i++) {
+    slot_[i].cfg = cfg[i];
+    slot_[i].cfg.addr[sizeof(slot_[i].cfg.addr) - 1] = 0;
+    slot_[i].cfg.label[sizeof(slot_[i].cfg.label) - 1] = 0;
+    slot_[i].used = used[i] && cfg[i].addr[0];
+  }
+}
+
+bool LinkPool::command(int slot, const LinkCommand& c) {
+  if (slot < 0 || slot >= n_ || !used(slot)) return false;
+  return slot_[slot].link.command(c);
+}
+
+bool LinkPool::broadcast(const LinkCommand& c) {
+  bool ok = true;
+  for (int i = 0; i < n_; i++) {
+    if (used(i)) ok &= slot_[i].link.command(c);
+  }
+  return ok;
+}
+
+bool LinkPool::forget(int slot) {
+  if (slot < 0 || slot >= n_ || !used(slot)) return false;
+  return forgets_.push((uint8_t)slot);
+}
+
+/************** Callbacks (NimBLE host task) **************/
+void LinkPool::onAdvert(const char* addr, uint8_t addrType) {
+  Advert a = {Advert::Hit, addrType, {0}};
+  strncpy(a.addr, addr, sizeof(a.addr) - 1);
+  adverts_.push(a);
+}
+
+void LinkPool::onScanDone() {
+  Advert a = {Advert::Done, 0, {0}};
+  adverts_.push(a);
+}
+
+/************** Readers **************/
+bool LinkPool::used(int slot) const {
+  std::lock_guard<std::mutex> g(tableLock_);
+  return slot_[slot].used;
+}
+
+bool LinkPool::device(int slot, DeviceCfg& out) const {
+  std::lock_guard<std::mutex> g(tableLock_);
+  out = slot_[slot].cfg;
+  return slot_[slot].used;
+}
+
+int LinkPool::find(const char* addr) const {
+  std::lock_guard<std::mutex> g(tableLock_);
+  for (int i = 0; i < n_; i++) {
+    if (slot_[i].used && !strcasecmp(slot_[i].cfg.addr, addr)) return i;
+  }
+  return -1;
+}
+
+uint32_t LinkPool::table(DeviceCfg* cfg, bool* used) const {
+  std::lock_guard<std::mutex> g(tableLock_);
+  for (int i = 0; i < n_; i++) {
+    cfg[i] = slot_[i].cfg;
+    used[i] = slot_[i].used;
+  }
+  return version_.load(std::memory_order_relaxed);
+}
+
+bool LinkPool::setLabel(int slot, const char* label) {
+  if (slot < 0 || slot >= n_) return false;
+  std::lock_guard<std::mutex> g(tableLock_);
+  if (!slot_[slot].used) return false;
+  strncpy(slot_[slot].cfg.label, label, sizeof(slot_[slot].cfg.label) - 1);
+  version_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+int LinkPool::connected() const {
+  int n = 0;
+  for (int i = 0; i < n_; i++) n += slot_[i].link.ready();
+  return n;
+}
+
+/************** Scheduling (BLE task) **************/
+uint16_t LinkPool::targetInterval(int links) const {
+  if (!spread_) return ITVL_MIN;
+  uint32_t itvl = (uint32_t)links * ITVL_PER_LINK;
+  return itvl < ITVL_MIN ? ITVL_MIN : itvl > ITVL_MAX ? ITVL_MAX : (uint16_t)itvl;
+}
+
+void LinkPool::start(uint32_t now) {
+  now_ = now;
+  nextDiscovery_ = now;
+  for (int i = 0; i < n_; i++) {
+    if (used(i)) slot_[i].link.start(now);
+  }
+}
+
+// A new advertiser takes the first free slot; it is connected like any
+// saved device from then on
+void LinkPool::admit(const Advert& a, uint32_t now) {
+  int free = -1;
+  {
+    std::lock_guard<std::mutex> g(tableLock_);
+    for (int i = 0; i < n_ && free < 0; i++) {
+      if (!slot_[i].used) free = i;
+    }
+    if (free < 0) {
+      st_.full++;
+      return;
+    }
+    Slot& s = slot_[free];
+    memset(&s.cfg, 0, sizeof(s.cfg));
+    memcpy(s.cfg.addr, a.addr, sizeof(s.cfg.addr));
+    s.cfg.addrType = a.addrType;
+    snprintf(s.cfg.label, sizeof(s.cfg.label), "patch %d", free + 1);
+    s.used = true;
+    version_.fetch_add(1, std::memory_order_relaxed);
+  }
+  st_.admitted++;
+  slot_[free].link.start(now);
+  slot_[free].link.scanHit(a.addr, a.addrType, now);
+}
+
+// One radio scan while any link looks for its peer, or for discovery while
+// slots are free; stopped while a link connects
+void LinkPool::radioScan(uint32_t now) {
+  bool want = false;
+  bool free = false;
+
+  for (int i = 0; i < n_; i++) {
+    want |= slot_[i].wantScan;
+    free |= !slot_[i].used;
+  }
+  if (autoAdmit_ && free && (int32_t)(now - nextDiscovery_) >= 0) {
+    nextDiscovery_ = now + DISCOVERY_MS;
+    scanEnd_ = now + BleLink::SCAN_MS;
+    want = true;
+  }
+  want |= scanning_ && (int32_t)(now - scanEnd_) < 0;
+
+  if (grant_ >= 0 || !want) {
+    if (scanning_) radio_.stopScan();
+    scanning_ = false;
+    return;
+  }
+  if (!scanning_ && radio_.startScan(BleLink::SCAN_MS)) {
+    scanning_ = true;
+    st_.scans++;
+  }
+}
+
+// Connected links follow the interval for the current count
+void LinkPool::retune() {
+  uint16_t itvl = targetInterval(connected());
+  for (int i = 0; i < n_; i++) {
+    Slot& s = slot_[i];
+    if (!s.link.ready() || s.itvl == itvl) continue;
+    if (radio_.retune(i, itvl)) {
+      s.itvl = itvl;
+      st_.retunes++;
+    }
+  }
+}
+
+void LinkPool::step(uint32_t now) {
+  Advert a;
+  uint8_t f;
+
+  now_ = now;
+  while (forgets_.pop(f)) {
+    slot_[f].link.halt();
+    slot_[f].itvl = 0;
+    std::lock_guard<std::mutex> g(tableLock_);
+    slot_[f].used = false;
+    version_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  while (adverts_.pop(a)) {
+    if (a.kind == Advert::Done) {
+      scanning_ = false;
+      continue;
+    }
+    st_.adverts++;
+    int s = find(a.addr);
+    if (s >= 0) {
+      slot_[s].link.scanHit(a.addr, a.addrType, now);
+    } else if (autoAdmit_) {
+      admit(a, now);
+    }
+  }
+
+  // Scan windows of links that did not see their peer
+  for (int i = 0; i < n_; i++) {
+    Slot& s = slot_[i];
+    if (s.wantScan && (int32_t)(now - s.scanUntil) >= 0) {
+      s.wantScan = false;
+      s.link.scanDone(now);
+    }
+  }
+
+  // Next connect turn, round robin among the links waiting for one
+  grant_ = -1;
+  for (int k = 0; k < n_ && grant_ < 0; k++) {
+    int i = (rr_ + k) % n_;
+    if (slot_[i].link.state() == LinkState::Connecting) grant_ = i;
+  }
+  radioScan(now);
+
+  // Equal shares of the frame budget. Buffers freed by a connection event
+  // go to whoever writes first, so a link left without one goes first next
+  // time; otherwise the start rotates.
+  int ready = connected();
+  int quantum = ready ? FRAMES_PER_STEP / ready : FRAMES_PER_STEP;
+  int first = -1;
+  if (quantum < 2) quantum = 2;
+  for (int k = 0; k < n_; k++) {
+    int i = (rr_ + k) % n_;
+    slot_[i].link.step(now, quantum);
+    if (first < 0 && slot_[i].link.blocked()) first = i;
+  }
+  rr_ = first >= 0 ? first : (rr_ + 1) % n_;
+  grant_ = -1;
+
+  retune();
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <mutex>
+
+#include "ble_link.h"
+
+/************** Several patches on one gateway **************/
+// A table of up to MAX_SLOTS devices keyed by address, each with its own
+// BleLink, sharing the one radio:
+//
+// - Scanning: one scanner for everybody. Links that look for their peer
+//   just register a window; every advertiser matching the target filter
+//   comes in through onAdvert() and goes to the slot with its address.
+//   An unknown address takes a free slot (admission) while autoAdmit is
+//   on. With free slots left, a discovery scan runs every DISCOVERY_MS.
+// - Connecting: connect() and discovery block the BLE task, so only one
+//   link gets to connect per step(), in round-robin order, and the scan is
+//   stopped for it. Ready links keep sending in the steps in between.
+// - Sending: every step() visits the links from a rotating start and
+//   gives each Ready one an equal share of FRAMES_PER_STEP, so one busy
+//   patch cannot take all of NimBLE's shared buffers.
+// - Connection intervals: each connection asks for ITVL_PER_LINK per
+//   connected link (ITVL_MIN..ITVL_MAX), so the controller has room for
+//   every link's event within one interval; links already connected are
+//   retuned when the count changes.
+//
+// Table changes (admission, forget) bump tableVersion(); the owner saves
+// table() to flash when it sees a new version. Same threading as BleLink:
+// step() on the BLE task, commands from one other task, callbacks from the
+// NimBLE host task.
+
+// Persisted per device, as is
+struct DeviceCfg {
+  char addr[18];
+  uint8_t addrType;
+  char label[24];
+};
+
+// Implemented with NimBLE in main.cpp and mocked in tools/pool_check; one
+// client per slot
+class PoolRadio {
+ public:
+  virtual ~PoolRadio() {}
+  // Asynchronous: advertisers matching the target arrive as
+  // LinkPool::onAdvert(), the end of the window as LinkPool::onScanDone()
+  virtual bool startScan(uint32_t ms) = 0;
+  virtual void stopScan() = 0;
+  // Intervals in units of 1.25 ms
+  virtual bool connect(int slot, const char* addr, uint8_t addrType, uint16_t itvl) = 0;
+  virtual bool retune(int slot, uint16_t itvl) = 0;
+  // The rest as in LinkBackend, per slot
+  virtual bool discover(int slot) = 0;
+  virtual void disconnect(int slot) = 0;
+  virtual bool write(int slot, uint8_t value) = 0;
+  virtual bool stream(int slot, bool on) = 0;
+  virtual bool framed(int slot) = 0;
+  virtual size_t payload(int slot) = 0;
+  virtual bool writeFrame(int slot, const uint8_t* buf, size_t len) = 0;
+  virtual bool journal(int /*slot*/, const uint8_t* /*buf*/, size_t /*len*/) { return false; }
+};
+
+struct PoolStats {
+  uint32_t adverts;         // matching advertisements seen
+  uint32_t admitted;        // new devices that got a slot
+  uint32_t full;            // new devices turned away, table full
+  uint32_t scans;           // radio scans started
+  uint32_t retunes;         // connection interval updates
+};
+
+class LinkPool {
+ public:
+  static const int MAX_SLOTS = 8;
+  static const int FRAMES_PER_STEP = 16;
+  static const uint32_t DISCOVERY_MS = 10000;
+  static const uint16_t ITVL_MIN = 12;        // 15 ms
+  static const uint16_t ITVL_MAX = 80;        // 100 ms
+  static const uint16_t ITVL_PER_LINK = 6;    // 7.5 ms of radio time each
+
+  LinkPool(PoolRadio& radio, int slots);
+
+  // ---- Before start() ----
+  // Devices saved earlier; they keep their slot numbers
+  void load(const DeviceCfg* cfg, const bool* used, int n);
+  void setAutoAdmit(bool on) { autoAdmit_ = on; }
+  // Off: every connection uses ITVL_MIN (for comparison in pool_check)
+  void setSpread(bool on) { spread_ = on; }
+
+  // ---- One other task (loop()) ----
+  bool command(int slot, const LinkCommand& c);
+  // Every used slot; false if any queue was full
+  bool broadcast(const LinkCommand& c);
+  bool forget(int slot);
+
+  // ---- NimBLE host task callbacks ----
+  void onAdvert(const char* addr, uint8_t addrType);
+  void onScanDone();
+  // Disconnects and ACK notifications go to the slot's link
+  BleLink& link(int slot) { return slot_[slot].link; }
+
+  // ---- BLE task ----
+  void start(uint32_t now);
+  void step(uint32_t now);
+
+  // ---- Readers on any task ----
+  int slots() const { return n_; }
+  bool used(int slot) const;
+  bool device(int slot, DeviceCfg& out) const;
+  int find(const char* addr) const;
+  uint16_t interval(int slot) const { return slot_[slot].itvl; }
+  // Saved table: cfg/used for every slot, returns the version copied
+  uint32_t table(DeviceCfg* cfg, bool* used) const;
+  uint32_t tableVersion() const { return version_.load(std::memory_order_relaxed); }
+  bool setLabel(int slot, const char* label);
+  PoolStats stats() const { return st_; }
+  int connected() const;
+
+ private:
+  // LinkBackend of one slot: the radio's per-slot calls, with scanning and
+  // connect turns handled by the pool
+  class SlotBackend : public LinkBackend {
+   public:
+    LinkPool* pool = nullptr;
+    int slot = 0;
+    bool startScan(uint32_t ms) override;
+    void stopScan() override;
+    bool connect(const char* addr, uint8_t addrType) override;
+    bool discover() override { return pool->radio_.discover(slot); }
+    void disconnect() override { pool->radio_.disconnect(slot); }
+    bool write(uint8_t v) override { return pool->radio_.write(slot, v); }
+    bool stream(bool on) override { return pool->radio_.stream(slot, on); }
+    bool framed() override { return pool->radio_.framed(slot); }
+    size_t payload() override { return pool->radio_.payload(slot); }
+    bool writeFrame(const uint8_t* buf, size_t len) override {
+      return pool->radio_.writeFrame(slot, buf, len);
+    }
+    bool journal(const uint8_t* buf, size_t len) override {
+      return pool->radio_.journal(slot, buf, len);
+    }
+    bool mayConnect() override { return pool->grant_ == slot; }
+  };
+
+  struct Slot {
+    SlotBackend be;
+    BleLink link{be};
+    DeviceCfg cfg = {};
+    bool used = false;
+    bool wantScan = false;
+    uint32_t scanUntil = 0;
+    uint16_t itvl = 0;      // asked for at connect / last retune
+  };
+
+  struct Advert {
+    enum Kind : uint8_t { Hit, Done } kind;
+    uint8_t addrType;
+    char addr[18];
+  };
+
+  uint16_t targetInterval(int links) const;
+  void admit(const Advert& a, uint32_t now);
+  void radioScan(uint32_t now);
+  void retune();
+
+  PoolRadio& radio_;
+  int n_;
+  Slot slot_[MAX_SLOTS];
+  SpscQueue<Advert, 32> adverts_;
+  SpscQueue<uint8_t, 8> forgets_;
+  mutable std::mutex tableLock_;      // cfg/used against readers
+  std::atomic<uint32_t> version_{0};
+  PoolStats st_ = {};
+  uint32_t now_ = 0;
+  uint32_t nextDiscovery_ = 0;
+  uint32_t scanEnd_ = 0;
+  bool scanning_ = false;
+  bool autoAdmit_ = true;
+  bool spread_ = true;
+  int grant_ = -1;          // slot that may connect in this step
+  int rr_ = 0;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/************** Lock-free single-producer / single-consumer queue **************/
+// One task pushes, one task pops; no locks, no allocation. N must be a power
+// of two. push() fails instead of blocking when the queue is full, so a
+// producer (HTTP handler, NimBLE host callback) never waits on the consumer.
+template <typename T, size_t N>
+class SpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+ public:
+  bool push(const T& v) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == N) {
+      drops_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    buf_[head & (N - 1)] = v;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T& out) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) return false;
+    out = buf_[tail & (N - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  uint32_t drops() const { return drops_.load(std::memory_order_relaxed); }
+
+ private:
+  T buf_[N];
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+  std::atomic<uint32_t> drops_{0};
+};
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/************** Streaming JSON writer **************/
+// Writes JSON into a caller-owned fixed buffer and hands it to a sink each
+// time it fills (and on finish()), so a response of any length is built
+// without the heap. Commas and nesting are tracked here; strings are
+// escaped on the way in.
+//
+//   JsonOut j(buf, sizeof(buf), sink, ctx);
+//   j.obj().key("ok").boolean(true).key("list").arr();
+//   for (...) j.str(name);
+//   j.end().end().finish();
+//
+// At most 32 levels of nesting. No Arduino dependencies: tools/http_bench
+// runs it on the host.
+
+class JsonOut {
+ public:
+  typedef void (*Sink)(void* ctx, const char* p, size_t n);
+
+  JsonOut(char* buf, size_t cap, Sink sink, void* ctx)
+      : buf_(buf), cap_(cap), sink_(sink), ctx_(ctx) {}
+
+  JsonOut& obj() { value(); put('{'); open(false); return *this; }
+  JsonOut& arr() { value(); put('['); open(true); return *this; }
+  JsonOut& end() {
+    if (depth_ == 0) return *this;
+    put((kind_ >> --depth_) & 1 ? ']' : '}');
+    afterKey_ = false;
+    return *this;
+  }
+
+  JsonOut& key(const char* k) {
+    value();
+    quoted(k);
+    put(':');
+    afterKey_ = true;
+    return *this;
+  }
+
+  JsonOut& str(const char* s) { value(); quoted(s ? s : ""); return *this; }
+  JsonOut& boolean(bool b) { value(); b ? put("true", 4) : put("false", 5); return *this; }
+  JsonOut& null() { value(); put("null", 4); return *this; }
+  // All of these, so that neither int32_t flavour (int or long) is ambiguous
+  JsonOut& num(long v) {
+    value();
+    if (v < 0) {
+      put('-');
+      digits(0ul - (unsigned long)v);
+    } else {
+      digits((unsigned long)v);
+    }
+    return *this;
+  }
+  JsonOut& num(unsigned long v) {
+    value();
+    digits(v);
+    return *this;
+  }
+  JsonOut& num(int v) { return num((long)v); }
+  JsonOut& num(unsigned v) { return num((unsigned long)v); }
+  // uint64_t: epoch milliseconds (32-bit digits stay the fast path)
+  JsonOut& num(unsigned long long v) {
+    value();
+    digits(v);
+    return *this;
+  }
+
+  // Shorthands for "key": value
+  JsonOut& kv(const char* k, const char* v) { return key(k).str(v); }
+  JsonOut& kv(const char* k, bool v) { return key(k).boolean(v); }
+  template <typename T>
+  JsonOut& kv(const char* k, T v) { return key(k).num(v); }
+
+  // Closes what is still open and hands over the rest of the buffer
+  JsonOut& finish() {
+    while (depth_) end();
+    flush();
+    return *this;
+  }
+
+  size_t bytes() const { return bytes_; }   // total handed to the sink
+  size_t chunks() const { return chunks_; }
+
+ private:
+  // Separator before a value or key at the current level
+  void value() {
+    if (afterKey_) {
+      afterKey_ = false;
+      return;
+    }
+    if (depth_ && !((first_ >> (depth_ - 1)) & 1)) put(',');
+    if (depth_) first_ &= ~(1u << (depth_ - 1));
+  }
+
+  void open(bool array) {
+    uint32_t bit = 1u << depth_;
+    first_ |= bit;
+    if (array) kind_ |= bit; else kind_ &= ~bit;
+    depth_++;
+  }
+
+  template <typename U>
+  void digits(U v) {
+    char t[20];
+    char* p = t + sizeof(t);
+    do {
+      *--p = (char)('0' + v % 10);
+      v /= 10;
+    } while (v);
+    put(p, t + sizeof(t) - p);
+  }
+
+  void quoted(const char* s) {
+    static const char hex[] = "0123456789abcdef";
+    put('"');
+    for (;;) {
+      // Plain runs in one go
+      const char* run = s;
+      while ((unsigned char)*s >= 0x20 && *s != '"' && *s != '\\') s++;
+      put(run, s - run);
+
+      unsigned char c = (unsigned char)*s++;
+      if (!c) break;
+      if (c == '"' || c == '\\') {
+        char e[2] = {'\\', (char)c};
+        put(e, sizeof(e));
+      } else {
+        char e[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+        put(e, sizeof(e));
+      }
+    }
+    put('"');
+  }
+
+  void put(char c) {
+    if (len_ == cap_) flush();
+    buf_[len_++] = c;
+  }
+  void put(const char* p, size_t n) {
+    while (n) {
+      if (len_ == cap_) flush();
+      size_t k = cap_ - len_ < n ? cap_ - len_ : n;
+      memcpy(buf_ + len_, p, k);
+      len_ += k;
+      p += k;
+      n -= k;
+    }
+  }
+
+  void flush() {
+    if (!len_) return;
+    sink_(ctx_, buf_, len_);
+    bytes_ += len_;
+    chunks_++;
+    len_ = 0;
+  }
+
+  char* buf_;
+  size_t cap_;
+  Sink sink_;
+  void* ctx_;
+  size_t len_ = 0;
+  size_t bytes_ = 0;
+  size_t chunks_ = 0;
+  uint32_t first_ = 0;      // bit d: nothing written yet at level d
+  uint32_t kind_ = 0;       // bit d: level d is an array
+  uint8_t depth_ = 0;
+  bool afterKey_ = false;
+};
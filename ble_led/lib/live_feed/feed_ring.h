@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/************** Overwriting record ring with per-consumer cursors **************/
+// One producer (the NimBLE notification callback) pushes fixed-size records
+// and never waits: when the ring is full the oldest record is overwritten.
+// Any number of consumers (one per browser connection, all polled from
+// loop()) read at their own pace through a FeedCursor; a consumer that
+// falls more than N records behind loses the oldest ones, counted in its
+// drops, and nobody else is slowed down.
+//
+// Every slot carries the index of the record it holds. A reader copies the
+// record and checks the index again afterwards (a per-slot seqlock), so a
+// record overwritten during the copy is discarded rather than returned torn.
+// No Arduino dependencies: tools/feed_check runs it on the host.
+
+struct FeedCursor {
+  uint32_t next = 0;        // index of the next record to deliver
+  uint32_t drops = 0;       // records overwritten before they were read
+  bool started = false;
+};
+
+template <typename T, size_t N>
+class FeedRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+ public:
+  // ---- Producer ----
+  void push(const T& v) {
+    uint32_t h = head_.load(std::memory_order_relaxed);
+    Slot& s = slots_[h & (N - 1)];
+
+    s.idx.store(EMPTY, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&s.rec, &v, sizeof(T));
+    s.idx.store(h, std::memory_order_release);
+    head_.store(h + 1, std::memory_order_release);
+  }
+
+  // ---- Any consumer ----
+  uint32_t head() const { return head_.load(std::memory_order_acquire); }
+
+  // Copies up to max records for this cursor and advances it. A new cursor
+  // starts with the last `history` records, so a fresh plot is not empty.
+  size_t collect(FeedCursor& c, T* out, size_t max, uint32_t history = N / 2) {
+    uint32_t h = head();
+    size_t n = 0;
+
+    if (!c.started) {
+      c.next = h - (h < history ? h : history);
+      c.started = true;
+    }
+    if (h - c.next > N) {
+      c.drops += h - c.next - N;
+      c.next = h - N;
+    }
+    while (n < max && c.next != h) {
+      if (read(c.next, out[n])) {
+        n++;
+      } else {
+        c.drops++;              // overwritten while we looked
+      }
+      c.next++;
+    }
+    return n;
+  }
+
+  size_t backlog(const FeedCursor& c) const {
+    uint32_t d = head() - c.next;
+    return d > N ? N : d;
+  }
+
+ private:
+  static const uint32_t EMPTY = 0xFFFFFFFFu;
+
+  struct Slot {
+    std::atomic<uint32_t> idx{EMPTY};
+    T rec;
+  };
+
+  bool read(uint32_t i, T& out) const {
+    const Slot& s = slots_[i & (N - 1)];
+
+    if (s.idx.load(std::memory_order_acquire) != i) return false;
+    memcpy(&out, &s.rec, sizeof(T));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return s.idx.load(std::memory_order_relaxed) == i;
+  }
+
+  Slot slots_[N];
+  std::atomic<uint32_t> head_{0};
+};
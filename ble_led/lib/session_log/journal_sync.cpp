@@ -0,0 +1,178 @@
+#include "journal_sync.h"
+
+#include <string.h>
+
+/************** Requests **************/
+jrnl_req JournalSync::begin(uint32_t now, uint64_t epoch_ms) { return sync(now, epoch_ms); }
+
+void JournalSync::reset() {
+  active_ = false;
+  broken_ = false;
+  done_ = false;
+  got_ = 0;
+  nAnchors_ = 0;
+}
+
+// From the first byte missing: inside the entry being reassembled, after
+// the newest one delivered, or wherever the patch's last SYNCED mark says
+jrnl_req JournalSync::sync(uint32_t now, uint64_t epoch_ms) {
+  jrnl_req r = {};
+
+  r.op = JRNL_OP_SYNC;
+  r.seq = JRNL_SEQ_UNSYNCED;
+  r.epoch_ms = epoch_ms;
+  if (got_ > 0) {
+    r.seq = seq_;
+    r.off = got_;
+  } else if (done_) {
+    r.seq = doneSeq_ + 1;
+  }
+  active_ = true;
+  broken_ = false;
+  fresh_ = true;
+  last_ = now;
+  return r;
+}
+
+bool JournalSync::poll(uint32_t now, jrnl_req& out) {
+  if (!active_ || now - last_ < TIMEOUT_MS) return false;
+  st_.timeouts++;
+  out = sync(now, 0);
+  return true;
+}
+
+/************** Chunks **************/
+bool JournalSync::onChunk(const uint8_t* p, size_t len, uint32_t now, jrnl_req& out) {
+  jrnl_chunk c;
+
+  if (len < sizeof(c)) return false;
+  memcpy(&c, p, sizeof(c));
+  p += sizeof(c);
+  len -= sizeof(c);
+  last_ = now;
+
+  if (c.len == JRNL_LEN_ANCHORS) {
+    for (size_t i = 0; i + sizeof(jrnl_anchor) <= len; i += sizeof(jrnl_anchor)) {
+      jrnl_anchor a;
+      memcpy(&a, p + i, sizeof(a));
+      anchor(a.boot, a.offset_ms);
+    }
+    return false;
+  }
+  if (c.len != JRNL_LEN_END) {
+    if (!broken_ && !piece(c, p, len)) broken_ = true;
+    return false;
+  }
+
+  finish(c.seq);
+  if (!active_) return false;
+  // An entry left half done means its last piece went missing too
+  if (broken_ || got_ > 0) {
+    st_.resumes++;
+    out = sync(now, 0);
+    return true;
+  }
+  out = {};
+  out.op = JRNL_OP_ACK;
+  out.seq = c.seq;
+  active_ = false;
+  return true;
+}
+
+// false: a piece before this one is missing
+bool JournalSync::piece(const jrnl_chunk& c, const uint8_t* p, size_t n) {
+  bool fresh = fresh_;
+
+  fresh_ = false;
+  if (done_ && (int32_t)(c.seq - doneSeq_) <= 0) {
+    if (c.off == 0) st_.dups++;
+    return true;
+  }
+  if (!(got_ > 0 && c.seq == seq_ && c.off == got_ && c.len == len_)) {
+    if (c.off != 0) return false;
+
+    uint32_t expect = got_ > 0 ? seq_ : done_ ? doneSeq_ + 1 : c.seq;
+
+    // Only the first entry of a transfer may start somewhere else: the
+    // patch no longer has the ones asked for
+    if (c.seq != expect) {
+      if (!fresh) return false;
+      if ((int32_t)(c.seq - expect) > 0) st_.gaps += c.seq - expect;
+    }
+    seq_ = c.seq;
+    len_ = c.len;
+    got_ = 0;
+    if (len_ > ENTRY_MAX || len_ < sizeof(jrnl_entry_hdr)) {
+      st_.bad++;
+      done_ = true;
+      doneSeq_ = seq_;
+      return true;
+    }
+  }
+  if (got_ + n > len_) return false;
+  memcpy(buf_ + got_, p, n);
+  got_ += n;
+  if (got_ == len_) {
+    deliver();
+    done_ = true;
+    doneSeq_ = seq_;
+    got_ = 0;
+  }
+  return true;
+}
+
+// END: seq is the patch's next entry. Behind what was delivered already,
+// its journal started over (flash erased) and so does the numbering.
+void JournalSync::finish(uint32_t seq) {
+  st_.transfers++;
+  if (done_ && (int32_t)(seq - doneSeq_) <= 0) {
+    done_ = false;
+    got_ = 0;
+    nAnchors_ = 0;
+  }
+}
+
+/************** Entries **************/
+void JournalSync::deliver() {
+  jrnl_entry_hdr h;
+  jrnl_rec r;
+  size_t pos = sizeof(h);
+  int rc;
+
+  memcpy(&h, buf_, sizeof(h));
+  if (h.version != JRNL_VERSION) {
+    st_.bad++;
+    return;
+  }
+  st_.entries++;
+  uint32_t t = h.t0_ms;
+  while ((rc = jrnl_rec_decode(buf_, len_, &pos, &t, &r)) > 0) {
+    if (r.type == JRNL_CLOCK) anchor(h.boot, r.a - (int64_t)r.t_ms);
+    st_.records++;
+    if (sink_) sink_(ctx_, r, h.boot, wallTime(h.boot, r.t_ms));
+  }
+  if (rc < 0) st_.bad++;
+}
+
+void JournalSync::anchor(uint16_t boot, int64_t offset_ms) {
+  for (int i = 0; i < nAnchors_; i++) {
+    if (anchors_[i].boot == boot) {
+      anchors_[i].offset_ms = offset_ms;
+      return;
+    }
+  }
+  if (nAnchors_ == ANCHORS_MAX) {
+    memmove(anchors_, anchors_ + 1, sizeof(anchors_) - sizeof(anchors_[0]));
+    nAnchors_--;
+  }
+  anchors_[nAnchors_].boot = boot;
+  anchors_[nAnchors_].offset_ms = offset_ms;
+  nAnchors_++;
+}
+
+uint64_t JournalSync::wallTime(uint16_t boot, uint32_t t_ms) const {
+  for (int i = 0; i < nAnchors_; i++) {
+    if (anchors_[i].boot == boot) return (uint64_t)(anchors_[i].offset_ms + (int64_t)t_ms);
+  }
+  return 0;
+}
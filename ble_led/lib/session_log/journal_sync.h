@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "journal_wire.h"
+
+/************** Journal sync, gateway end **************/
+// Pulls the event journal of one patch (shared/journal_wire.h) after every
+// connection and hands its records, with their wall time where the patch's
+// boot has one, to a sink (the session log in main.cpp). No radio and no
+// Arduino: loop() feeds it the notifications and writes the requests it
+// returns; tools/log_check drives it against a patch model over a lossy
+// link.
+//
+// A transfer is the anchors, the entry pieces in seq/offset order and END.
+// Pieces reassemble into entries; the first piece that does not continue
+// where the last one left off (a notification lost on the air or dropped
+// by the gateway's queue) breaks the transfer. Its END is then answered by
+// a SYNC from the first missing byte, which the patch resumes in the middle
+// of the entry. A clean transfer is acknowledged at END, so that the next
+// one starts after it. A transfer silent for TIMEOUT_MS is asked again from
+// the same point.
+//
+// The resume point survives a disconnect, so a transfer cut short by one
+// goes on where it stopped. Entries up to the newest one handed to the
+// sink are never handed over again.
+
+struct JournalStats {
+  uint32_t transfers;       // ENDs seen
+  uint32_t entries;
+  uint32_t records;
+  uint32_t resumes;         // transfers asked again, a piece missing
+  uint32_t timeouts;
+  uint32_t gaps;            // entries rotated out on the patch before they came
+  uint32_t dups;            // entries seen before, skipped
+  uint32_t bad;             // entries that do not decode
+};
+
+class JournalSync {
+ public:
+  static const uint32_t TIMEOUT_MS = 3000;
+  static const size_t ENTRY_MAX = 256;      // > CONFIG_NECK_JOURNAL_ENTRY_MAX
+  static const int ANCHORS_MAX = 16;
+
+  // One record; at_ms 0 if its boot has no wall time
+  typedef void (*Sink)(void* ctx, const jrnl_rec& r, uint16_t boot, uint64_t at_ms);
+
+  void attach(Sink sink, void* ctx) {
+    sink_ = sink;
+    ctx_ = ctx;
+  }
+
+  // Link up: the SYNC to write. epoch_ms is the gateway's clock, 0 if it
+  // has none
+  jrnl_req begin(uint32_t now, uint64_t epoch_ms);
+  void disconnected() { active_ = false; }
+  // Another patch in this slot: forget the resume point and the anchors
+  void reset();
+  // One notification; true with a request to write (ACK or SYNC)
+  bool onChunk(const uint8_t* p, size_t len, uint32_t now, jrnl_req& out);
+  // Periodically: true with a SYNC again if the transfer went silent
+  bool poll(uint32_t now, jrnl_req& out);
+
+  bool active() const { return active_; }
+  JournalStats stats() const { return st_; }
+
+ private:
+  jrnl_req sync(uint32_t now, uint64_t epoch_ms);
+  bool piece(const jrnl_chunk& c, const uint8_t* p, size_t n);
+  void anchor(uint16_t boot, int64_t offset_ms);
+  uint64_t wallTime(uint16_t boot, uint32_t t_ms) const;
+  void deliver();
+  void finish(uint32_t seq);
+
+  Sink sink_ = nullptr;
+  void* ctx_ = nullptr;
+  bool active_ = false;
+  bool broken_ = false;
+  bool fresh_ = false;      // no entry piece yet in this transfer
+  uint32_t last_ = 0;       // last chunk or request
+
+  // Newest entry handed to the sink
+  bool done_ = false;
+  uint32_t doneSeq_ = 0;
+  // Entry being reassembled, got_ > 0
+  uint32_t seq_ = 0;
+  uint16_t len_ = 0;
+  uint16_t got_ = 0;
+  uint8_t buf_[ENTRY_MAX];
+
+  jrnl_anchor anchors_[ANCHORS_MAX];
+  int nAnchors_ = 0;
+  JournalStats st_ = {};
+};
@@ -0,0 +1,587 @@
+#include "session_log.h"
+
+#include "journal_wire.h"
+
+#include <dirent.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/************** Encoding **************/
+uint32_t logCrc32(uint32_t crc, const void* buf, size_t len) {
+  static uint32_t table[256];
+  static bool ready = false;
+  const uint8_t* p = static_cast<const uint8_t*>(buf);
+
+  if (!ready) {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      table[i] = c;
+    }
+    ready = true;
+  }
+  crc = ~crc;
+  while (len--) crc = table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+static uint8_t* putVar(uint8_t* o, uint32_t v) {
+  while (v >= 0x80) {
+    *o++ = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  *o++ = (uint8_t)v;
+  return o;
+}
+
+static bool getVar(const uint8_t*& p, const uint8_t* end, uint32_t& v) {
+  v = 0;
+  for (int shift = 0; shift < 35 && p < end; shift += 7) {
+    uint8_t b = *p++;
+    v |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+static uint8_t* putVar64(uint8_t* o, uint64_t v) {
+  while (v >= 0x80) {
+    *o++ = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  *o++ = (uint8_t)v;
+  return o;
+}
+
+static bool getVar64(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+  v = 0;
+  for (int shift = 0; shift < 64 && p < end; shift += 7) {
+    uint8_t b = *p++;
+    v |= (uint64_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+static uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+static uint8_t* putDelta(uint8_t* o, int32_t now, int32_t prev) {
+  return putVar(o, zigzag(now - prev));
+}
+
+static bool blockValid(const LogBlockHeader& h, const uint8_t* payload) {
+  uint32_t crc = logCrc32(0, &h, offsetof(LogBlockHeader, crc));
+  return logCrc32(crc, payload, h.len) == h.crc;
+}
+
+static bool headerSane(const LogBlockHeader& h) {
+  return h.sync == LOG_SYNC && h.version == LOG_VERSION && h.len <= SessionLog::BLOCK_BYTES &&
+         h.count > 0;
+}
+
+/************** Writer **************/
+SessionLog::SessionLog(const char* dir) {
+  strncpy(dir_, dir, sizeof(dir_) - 1);
+  dir_[sizeof(dir_) - 1] = 0;
+}
+
+SessionLog::~SessionLog() {
+  flush();
+  closeFiles();
+}
+
+void SessionLog::path(char* out, size_t cap, uint32_t seq, const char* ext) const {
+  snprintf(out, cap, "%s/%08x.%s", dir_, (unsigned)seq, ext);
+}
+
+uint64_t SessionLog::bytes() const {
+  uint64_t n = 0;
+  for (int i = 0; i < nseg_; i++) n += seg_[i].size + seg_[i].blocks * sizeof(LogIndexEntry);
+  return n;
+}
+
+void SessionLog::closeFiles() {
+  if (segFile_) fclose(segFile_);
+  if (idxFile_) fclose(idxFile_);
+  segFile_ = idxFile_ = nullptr;
+}
+
+// Header byte and time of a new record; nullptr for a bad device
+uint8_t* SessionLog::start(uint8_t kind, uint64_t t, uint8_t dev) {
+  if (dev >= MAX_DEVS) return nullptr;
+  if (t < last_) t = last_;
+  if (count_ && (len_ + MAX_RECORD > BLOCK_BYTES || t - t0_ >= BLOCK_MS)) writeBlock();
+  if (count_ == 0) {
+    t0_ = tPrev_ = t;
+    memset(prev_, 0, sizeof(prev_));
+  }
+
+  uint8_t* o = blk_ + sizeof(LogBlockHeader) + len_;
+  *o++ = (uint8_t)(kind << 4 | dev);
+  o = putVar(o, (uint32_t)(t - tPrev_));
+  tPrev_ = last_ = t;
+  return o;
+}
+
+void SessionLog::end(const uint8_t* o, size_t rawBytes) {
+  len_ = o - (blk_ + sizeof(LogBlockHeader));
+  count_++;
+  st_.records++;
+  st_.rawBytes += rawBytes;
+}
+
+bool SessionLog::telem(uint64_t t, uint8_t dev, const telem_wire& w) {
+  uint8_t* o = start(LOG_TELEM, t, dev);
+  if (!o) return false;
+  telem_wire& p = prev_[dev].telem;
+
+  o = putDelta(o, (int16_t)(uint16_t)(w.seq - p.seq), 0);
+  o = putDelta(o, (int32_t)(w.t_us - p.t_us), 0);
+  for (int i = 0; i < 3; i++) o = putDelta(o, w.acc[i], p.acc[i]);
+  for (int i = 0; i < 3; i++) o = putDelta(o, w.gyr[i], p.gyr[i]);
+  o = putDelta(o, w.pitch_cdeg, p.pitch_cdeg);
+  o = putDelta(o, w.roll_cdeg, p.roll_cdeg);
+  o = putDelta(o, w.therm_mv, p.therm_mv);
+  o = putDelta(o, w.temp_cdeg, p.temp_cdeg);
+  *o++ = w.flags;
+  p = w;
+  // What it took as a timestamped record: time, device, the record
+  end(o, sizeof(uint64_t) + 1 + sizeof(w));
+  return true;
+}
+
+bool SessionLog::posture(uint64_t t, uint8_t dev, const ble_posture_wire& w) {
+  uint8_t* o = start(LOG_POSTURE, t, dev);
+  if (!o) return false;
+  ble_posture_wire& p = prev_[dev].posture;
+
+  *o++ = w.state;
+  *o++ = w.event;
+  *o++ = w.flags;
+  o = putDelta(o, w.pitch_cdeg, p.pitch_cdeg);
+  o = putDelta(o, w.dev_cdeg, p.dev_cdeg);
+  o = putDelta(o, (int32_t)(w.t_ms - p.t_ms), 0);
+  p = w;
+  end(o, sizeof(uint64_t) + 1 + sizeof(w));
+  return true;
+}
+
+bool SessionLog::event(uint64_t t, uint8_t dev, const LogEvent& e) {
+  uint8_t* o = start(LOG_EVENT, t, dev);
+  if (!o) return false;
+
+  // Against the record's own time: start() may have moved t up to last_
+  uint64_t logged = tPrev_;
+  *o++ = e.type;
+  o = putVar(o, zigzag(e.a));
+  o = putVar(o, zigzag(e.b));
+  o = putVar(o, e.boot);
+  o = putVar(o, e.up_ms);
+  o = putVar64(o, e.at_ms && e.at_ms <= logged ? logged - e.at_ms + 1 : 0);
+  end(o, sizeof(uint64_t) + 1 + sizeof(e));
+  return true;
+}
+
+void SessionLog::poll(uint64_t t) {
+  if (count_ && t >= t0_ + BLOCK_MS) writeBlock();
+}
+
+bool SessionLog::flush() { return writeBlock(); }
+
+// The block goes out in any case; a failed write loses it and appending
+// goes on in a new segment
+bool SessionLog::writeBlock() {
+  if (!count_) return true;
+
+  uint8_t* payload = blk_ + sizeof(LogBlockHeader);
+  LogBlockHeader h = {LOG_SYNC, LOG_VERSION, (uint16_t)len_, count_, t0_,
+                      (uint32_t)(tPrev_ - t0_), 0};
+  h.crc = logCrc32(logCrc32(0, &h, offsetof(LogBlockHeader, crc)), payload, len_);
+  memcpy(blk_, &h, sizeof(h));
+  size_t n = sizeof(h) + len_;
+  count_ = 0;
+  len_ = 0;
+
+  if ((!segFile_ || seg_[nseg_ - 1].size + n > SEGMENT_BYTES) && !roll()) {
+    st_.writeErrors++;
+    return false;
+  }
+  LogSegment& s = seg_[nseg_ - 1];
+  LogIndexEntry e = {s.size, h.span_ms, h.t0_ms};
+  if (fwrite(blk_, 1, n, segFile_) != n || fflush(segFile_) || fsync(fileno(segFile_)) ||
+      fwrite(&e, sizeof(e), 1, idxFile_) != 1 || fflush(idxFile_) || fsync(fileno(idxFile_))) {
+    // Whatever made it to flash is sorted out by the next begin()
+    st_.writeErrors++;
+    closeFiles();
+    return false;
+  }
+  if (s.blocks == 0) s.t0_ms = h.t0_ms;
+  s.t1_ms = h.t0_ms + h.span_ms;
+  s.size += n;
+  s.blocks++;
+  st_.blocks++;
+  st_.diskBytes += n;
+  retain();
+  return true;
+}
+
+// A new newest segment; an empty one is reused
+bool SessionLog::roll() {
+  char p[64];
+  uint32_t seq = nseg_ ? seg_[nseg_ - 1].seq + 1 : 1;
+
+  closeFiles();
+  if (nseg_ && seg_[nseg_ - 1].blocks == 0) seq = seg_[--nseg_].seq;
+  if (nseg_ == MAX_SEGMENTS) dropOldest();
+
+  path(p, sizeof(p), seq, "seg");
+  segFile_ = fopen(p, "wb");
+  path(p, sizeof(p), seq, "idx");
+  idxFile_ = fopen(p, "wb");
+  if (!segFile_ || !idxFile_) {
+    closeFiles();
+    return false;
+  }
+  LogSegment s = {seq, 0, 0, 0, 0};
+  seg_[nseg_++] = s;
+  return true;
+}
+
+void SessionLog::dropOldest() {
+  char p[64];
+  path(p, sizeof(p), seg_[0].seq, "seg");
+  remove(p);
+  path(p, sizeof(p), seg_[0].seq, "idx");
+  remove(p);
+  memmove(&seg_[0], &seg_[1], (nseg_ - 1) * sizeof(seg_[0]));
+  nseg_--;
+  st_.dropped++;
+}
+
+// Never the segment being written
+void SessionLog::retain() {
+  while (nseg_ > 1 && bytes() > maxBytes_) dropOldest();
+}
+
+/************** Recovery **************/
+// A sealed segment: its times from the first and last index entries
+bool SessionLog::loadIndex(LogSegment& s) {
+  char p[64];
+  struct stat st;
+  LogIndexEntry first, last;
+
+  path(p, sizeof(p), s.seq, "seg");
+  if (stat(p, &st) != 0) return false;
+  s.size = (uint32_t)st.st_size;
+  path(p, sizeof(p), s.seq, "idx");
+  FILE* f = fopen(p, "rb");
+  if (!f) return false;
+  bool ok = fseek(f, 0, SEEK_END) == 0;
+  long size = ftell(f);
+  ok = ok && size > 0 && size % sizeof(LogIndexEntry) == 0 && fseek(f, 0, SEEK_SET) == 0 &&
+       fread(&first, sizeof(first), 1, f) == 1 &&
+       fseek(f, size - (long)sizeof(last), SEEK_SET) == 0 && fread(&last, sizeof(last), 1, f) == 1;
+  fclose(f);
+  if (!ok || last.off >= s.size) return false;
+  s.blocks = (uint32_t)(size / sizeof(LogIndexEntry));
+  s.t0_ms = first.t0_ms;
+  s.t1_ms = last.t0_ms + last.span_ms;
+  return true;
+}
+
+// Walks the blocks of a segment, checking every CRC, and writes its index
+// anew. *torn: the file goes on past the last valid block.
+bool SessionLog::recover(LogSegment& s, bool* torn) {
+  char p[64], q[64];
+  LogBlockHeader h;
+  uint8_t* payload = blk_ + sizeof(LogBlockHeader);
+
+  path(p, sizeof(p), s.seq, "seg");
+  FILE* f = fopen(p, "rb");
+  path(q, sizeof(q), s.seq, "tmp");
+  FILE* idx = fopen(q, "wb");
+  if (!f || !idx) {
+    if (f) fclose(f);
+    if (idx) fclose(idx);
+    return false;
+  }
+
+  s.blocks = s.size = 0;
+  while (fread(&h, sizeof(h), 1, f) == 1 && headerSane(h) &&
+         fread(payload, 1, h.len, f) == h.len && blockValid(h, payload)) {
+    LogIndexEntry e = {s.size, h.span_ms, h.t0_ms};
+    fwrite(&e, sizeof(e), 1, idx);
+    if (s.blocks == 0) s.t0_ms = h.t0_ms;
+    s.t1_ms = h.t0_ms + h.span_ms;
+    s.size += sizeof(h) + h.len;
+    s.blocks++;
+  }
+  fseek(f, 0, SEEK_END);
+  *torn = ftell(f) > (long)s.size;
+  fclose(f);
+  bool ok = fflush(idx) == 0 && fsync(fileno(idx)) == 0;
+  fclose(idx);
+
+  path(p, sizeof(p), s.seq, "idx");
+  remove(p);
+  return ok && rename(q, p) == 0;
+}
+
+bool SessionLog::begin(uint64_t maxBytes) {
+  flush();
+  closeFiles();
+  maxBytes_ = maxBytes;
+  nseg_ = 0;
+  last_ = 0;
+
+  mkdir(dir_, 0775);
+  DIR* d = opendir(dir_);
+  if (!d) return false;
+  struct dirent* e;
+  while ((e = readdir(d)) != nullptr && nseg_ < MAX_SEGMENTS) {
+    char* end;
+    unsigned long seq = strtoul(e->d_name, &end, 16);
+    if (end != e->d_name + 8 || strcmp(end, ".seg") != 0 || seq == 0) continue;
+    LogSegment s = {(uint32_t)seq, 0, 0, 0, 0};
+    int i = nseg_++;
+    for (; i > 0 && seg_[i - 1].seq > s.seq; i--) seg_[i] = seg_[i - 1];
+    seg_[i] = s;
+  }
+  closedir(d);
+
+  // Sealed segments as their index says; the newest one is checked block
+  // by block, as is any with a missing or damaged index
+  bool torn = false;
+  for (int i = 0; i < nseg_; i++) {
+    bool newest = i == nseg_ - 1;
+    bool t = false;
+    if ((newest || !loadIndex(seg_[i])) && !recover(seg_[i], &t)) seg_[i].blocks = 0;
+    if (newest) torn = t;
+  }
+  for (int i = 0; i < nseg_;) {
+    if (seg_[i].blocks == 0 && i < nseg_ - 1) {
+      char p[64];
+      path(p, sizeof(p), seg_[i].seq, "seg");
+      remove(p);
+      path(p, sizeof(p), seg_[i].seq, "idx");
+      remove(p);
+      memmove(&seg_[i], &seg_[i + 1], (nseg_ - i - 1) * sizeof(seg_[0]));
+      nseg_--;
+    } else {
+      if (seg_[i].blocks && seg_[i].t1_ms > last_) last_ = seg_[i].t1_ms;
+      i++;
+    }
+  }
+
+  // Appends go on in the newest segment, unless a torn block ends it
+  if (torn) {
+    st_.torn++;
+  } else if (nseg_ && seg_[nseg_ - 1].blocks) {
+    char p[64];
+    path(p, sizeof(p), seg_[nseg_ - 1].seq, "seg");
+    segFile_ = fopen(p, "ab");
+    path(p, sizeof(p), seg_[nseg_ - 1].seq, "idx");
+    idxFile_ = fopen(p, "ab");
+    if (!segFile_ || !idxFile_) closeFiles();
+  }
+  retain();
+  return true;
+}
+
+/************** Reader **************/
+void LogReader::close() {
+  if (f_) fclose(f_);
+  f_ = nullptr;
+}
+
+// Positions at the last block starting at or before from_, found by a
+// binary search of the segment's index
+bool LogReader::open(int i) {
+  char p[64];
+  const LogSegment& s = log_.segment(i);
+  long off = 0;
+
+  close();
+  log_.path(p, sizeof(p), s.seq, "idx");
+  FILE* idx = fopen(p, "rb");
+  if (idx) {
+    long lo = 0, hi = (long)s.blocks - 1;
+    LogIndexEntry e;
+    while (lo <= hi) {
+      long mid = (lo + hi) / 2;
+      if (fseek(idx, mid * (long)sizeof(e), SEEK_SET) != 0 || fread(&e, sizeof(e), 1, idx) != 1) break;
+      if (e.t0_ms <= from_) {
+        off = e.off;
+        lo = mid + 1;
+      } else {
+        hi = mid - 1;
+      }
+    }
+    fclose(idx);
+  }
+  log_.path(p, sizeof(p), s.seq, "seg");
+  f_ = fopen(p, "rb");
+  return f_ && fseek(f_, off, SEEK_SET) == 0;
+}
+
+void LogReader::seek(uint64_t from, uint64_t to, int dev) {
+  from_ = from;
+  to_ = to;
+  dev_ = dev;
+  left_ = 0;
+  blocks_ = 0;
+  done_ = true;
+  close();
+  for (seg_ = 0; seg_ < log_.segments(); seg_++) {
+    const LogSegment& s = log_.segment(seg_);
+    if (s.blocks && s.t1_ms >= from) {
+      done_ = s.t0_ms >= to || !open(seg_);
+      return;
+    }
+  }
+}
+
+// Next block with records in the range; false at the end of it
+bool LogReader::readBlock() {
+  while (!done_) {
+    bool ok = f_ && fread(&hdr_, sizeof(hdr_), 1, f_) == 1 && headerSane(hdr_);
+    if (ok && hdr_.t0_ms >= to_) break;
+    if (ok && hdr_.t0_ms + hdr_.span_ms < from_) {
+      if (fseek(f_, hdr_.len, SEEK_CUR) == 0) continue;
+      ok = false;
+    }
+    if (ok && fread(buf_, 1, hdr_.len, f_) == hdr_.len && blockValid(hdr_, buf_)) {
+      blocks_++;
+      pos_ = 0;
+      left_ = hdr_.count;
+      t_ = hdr_.t0_ms;
+      memset(telem_, 0, sizeof(telem_));
+      memset(posture_, 0, sizeof(posture_));
+      return true;
+    }
+    // End of the segment, or the torn block that ends it
+    if (++seg_ >= log_.segments() || log_.segment(seg_).t0_ms >= to_ || !open(seg_)) break;
+  }
+  done_ = true;
+  close();
+  return false;
+}
+
+bool LogReader::decode(LogRecord& r) {
+  const uint8_t* p = buf_ + pos_;
+  const uint8_t* end = buf_ + hdr_.len;
+  uint32_t v;
+
+  if (p >= end) return false;
+  r.kind = *p >> 4;
+  r.dev = *p++ & 0x0F;
+  if (!getVar(p, end, v)) return false;
+  t_ += v;
+  r.t_ms = t_;
+
+  if (r.kind == LOG_TELEM) {
+    telem_wire& w = telem_[r.dev];
+    int32_t d[12];
+    for (int i = 0; i < 12; i++) {
+      if (!getVar(p, end, v)) return false;
+      d[i] = unzigzag(v);
+    }
+    if (p >= end) return false;
+    w.seq = (uint16_t)(w.seq + d[0]);
+    w.t_us += (uint32_t)d[1];
+    for (int i = 0; i < 3; i++) w.acc[i] = (int16_t)(w.acc[i] + d[2 + i]);
+    for (int i = 0; i < 3; i++) w.gyr[i] = (int16_t)(w.gyr[i] + d[5 + i]);
+    w.pitch_cdeg = (int16_t)(w.pitch_cdeg + d[8]);
+    w.roll_cdeg = (int16_t)(w.roll_cdeg + d[9]);
+    w.therm_mv = (int16_t)(w.therm_mv + d[10]);
+    w.temp_cdeg = (int16_t)(w.temp_cdeg + d[11]);
+    w.flags = *p++;
+    telem_wire_seal(&w);
+    r.telem = w;
+  } else if (r.kind == LOG_POSTURE) {
+    ble_posture_wire& w = posture_[r.dev];
+    int32_t d[3];
+    if (end - p < 3) return false;
+    w.state = *p++;
+    w.event = *p++;
+    w.flags = *p++;
+    for (int i = 0; i < 3; i++) {
+      if (!getVar(p, end, v)) return false;
+      d[i] = unzigzag(v);
+    }
+    w.pitch_cdeg = (int16_t)(w.pitch_cdeg + d[0]);
+    w.dev_cdeg = (int16_t)(w.dev_cdeg + d[1]);
+    w.t_ms += (uint32_t)d[2];
+    r.posture = w;
+  } else if (r.kind == LOG_EVENT) {
+    LogEvent& e = r.event;
+    uint32_t a, b, boot;
+    uint64_t age;
+    if (p >= end) return false;
+    e.type = *p++;
+    if (!getVar(p, end, a) || !getVar(p, end, b) || !getVar(p, end, boot) ||
+        !getVar(p, end, e.up_ms) || !getVar64(p, end, age)) {
+      return false;
+    }
+    e.a = unzigzag(a);
+    e.b = unzigzag(b);
+    e.boot = (uint16_t)boot;
+    e.at_ms = age ? r.t_ms - (age - 1) : 0;
+  } else {
+    return false;
+  }
+  pos_ = p - buf_;
+  return true;
+}
+
+bool LogReader::next(LogRecord& r) {
+  while (!done_) {
+    if (left_ == 0) {
+      if (!readBlock()) return false;
+      continue;
+    }
+    if (!decode(r)) {
+      left_ = 0;                // cannot happen with a valid CRC
+      continue;
+    }
+    left_--;
+    if (r.t_ms < from_ || (dev_ >= 0 && r.dev != dev_)) continue;
+    if (r.t_ms >= to_) break;
+    return true;
+  }
+  done_ = true;
+  close();
+  return false;
+}
+
+/************** CSV **************/
+const char LOG_CSV_HEADER[] =
+    "t_ms,dev,kind,state,event,flags,pitch_cdeg,roll_cdeg,dev_cdeg,"
+    "seq,t_dev_us,ax,ay,az,gx,gy,gz,therm_mv,temp_cdeg,"
+    "type,a,b,boot,up_ms,at_ms\n";
+
+size_t logCsv(const LogRecord& r, char* out, size_t cap) {
+  int n;
+  unsigned long long t = r.t_ms;
+
+  if (r.kind == LOG_TELEM) {
+    const telem_wire& w = r.telem;
+    n = snprintf(out, cap, "%llu,%u,telem,,,%u,%d,%d,,%u,%lu,%d,%d,%d,%d,%d,%d,%d,%d,,,,,,\n", t, r.dev,
+                 w.flags, w.pitch_cdeg, w.roll_cdeg, w.seq, (unsigned long)w.t_us, w.acc[0],
+                 w.acc[1], w.acc[2], w.gyr[0], w.gyr[1], w.gyr[2], w.therm_mv, w.temp_cdeg);
+  } else if (r.kind == LOG_EVENT) {
+    const LogEvent& e = r.event;
+    n = snprintf(out, cap, "%llu,%u,journal,,,,,,,,,,,,,,,,,%s,%ld,%ld,%u,%lu,%llu\n", t, r.dev,
+                 jrnl_type_name(e.type), (long)e.a, (long)e.b, e.boot, (unsigned long)e.up_ms,
+                 (unsigned long long)e.at_ms);
+  } else {
+    const ble_posture_wire& w = r.posture;
+    n = snprintf(out, cap, "%llu,%u,posture,%u,%u,%u,%d,,%d,,%llu,,,,,,,,,,,,,,\n", t, r.dev, w.state,
+                 w.event, w.flags, w.pitch_cdeg, w.dev_cdeg, (unsigned long long)w.t_ms * 1000);
+  }
+  return n > 0 && (size_t)n < cap ? (size_t)n : 0;
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ble_wire.h"
+#include "telem_wire.h"
+
+/************** Append-only session log **************/
+// Telemetry records and posture notifications of every patch, kept in
+// flash for later download. Plain stdio on a directory: on the gateway
+// that is LittleFS through its VFS mount, in tools/log_check a temporary
+// directory on the host. No Arduino dependencies.
+//
+// One log directory holds numbered segments, NNNNNNNN in hex from 1:
+//   NNNNNNNN.seg   blocks back to back, up to SEGMENT_BYTES
+//   NNNNNNNN.idx   time index of the segment, one LogIndexEntry per block
+//
+// A block is a LogBlockHeader and up to BLOCK_BYTES of records, each
+//   u8 kind << 4 | dev, varint ms since the previous record (the first:
+//   since t0), then
+//   LOG_TELEM    zigzag varint deltas of seq, t_us, acc, gyr, pitch, roll,
+//                therm_mv, temp_cdeg, and the flags byte
+//   LOG_POSTURE  state, event, flags bytes, zigzag varint deltas of
+//                pitch_cdeg, dev_cdeg, t_ms
+//   LOG_EVENT    journal record type byte, zigzag varints a and b, varints
+//                of the patch boot, ms since that boot and ms since the
+//                record happened + 1 (0: no wall time for that boot)
+// with the deltas taken against the previous record of the same kind and
+// device in the block, so that every block decodes on its own and the
+// index can point at any of them. A 30-byte telemetry record takes 15 to
+// 20 bytes, most of them sensor noise.
+//
+// Records collect in RAM and go to flash as one block when it is full or
+// its first record is BLOCK_MS old: one fwrite, fflush and fsync, then the
+// index entry. A block cut short by a reset fails its CRC; begin()
+// rebuilds the newest segment's index from its valid blocks and, past a
+// torn block, continues in a new segment. Readers stop at the first bad
+// block of a segment. The oldest segments are deleted while the log takes
+// more than maxBytes.
+//
+// Times are ms since the Unix epoch as the gateway knows it; the log never
+// goes backwards (a record older than the last one gets its time). Journal
+// records from the patch (shared/journal_wire.h) arrive long after the
+// fact, so they are logged when they arrive and carry their own time.
+// One task only: appends, reads and begin() from loop().
+
+enum LogKind : uint8_t { LOG_TELEM = 1, LOG_POSTURE = 2, LOG_EVENT = 3 };
+
+// One journal record as logged
+struct LogEvent {
+  uint8_t type;             // JRNL_*
+  int32_t a;
+  int32_t b;
+  uint16_t boot;            // patch restarts
+  uint32_t up_ms;           // since that boot
+  uint64_t at_ms;           // epoch ms, 0 if the boot has no wall time
+};
+
+struct LogBlockHeader {
+  uint8_t sync;             // LOG_SYNC
+  uint8_t version;          // LOG_VERSION
+  uint16_t len;             // payload bytes
+  uint16_t count;           // records
+  uint64_t t0_ms;           // first record
+  uint32_t span_ms;         // last record - t0_ms
+  uint32_t crc;             // CRC-32 of the header before it and the payload
+} __attribute__((packed));
+
+struct LogIndexEntry {
+  uint32_t off;             // of the block in the segment
+  uint32_t span_ms;
+  uint64_t t0_ms;
+} __attribute__((packed));
+
+static const uint8_t LOG_SYNC = 0xB5;
+static const uint8_t LOG_VERSION = 1;
+
+struct LogRecord {
+  uint64_t t_ms;
+  uint8_t kind;             // LogKind
+  uint8_t dev;              // gateway slot
+  union {
+    telem_wire telem;
+    ble_posture_wire posture;
+    LogEvent event;
+  };
+};
+
+struct LogSegment {
+  uint32_t seq;
+  uint32_t blocks;
+  uint32_t size;            // valid bytes of the segment file
+  uint64_t t0_ms;           // first record, valid with blocks
+  uint64_t t1_ms;           // last record
+};
+
+struct LogStats {
+  uint32_t records;         // appended since begin()
+  uint32_t blocks;
+  uint32_t rawBytes;        // the records as received
+  uint32_t diskBytes;       // the blocks written for them
+  uint32_t torn;            // torn appends found by begin()
+  uint32_t dropped;         // segments deleted for retention
+  uint32_t writeErrors;     // blocks lost to a failed write
+};
+
+class SessionLog {
+ public:
+  static const uint32_t SEGMENT_BYTES = 64 * 1024;
+  static const size_t BLOCK_BYTES = 1024;
+  static const uint32_t BLOCK_MS = 10000;
+  static const int MAX_SEGMENTS = 128;
+  static const int MAX_DEVS = 16;       // dev fits four bits
+  static const size_t MAX_RECORD = 64;  // encoded, with its header byte
+
+  explicit SessionLog(const char* dir);
+  ~SessionLog();
+
+  // Opens (creates) the directory and recovers the newest segment
+  bool begin(uint64_t maxBytes);
+
+  // ---- Appending ----
+  bool telem(uint64_t t_ms, uint8_t dev, const telem_wire& w);
+  bool posture(uint64_t t_ms, uint8_t dev, const ble_posture_wire& p);
+  bool event(uint64_t t_ms, uint8_t dev, const LogEvent& e);
+  // Writes the block once its first record is BLOCK_MS old
+  void poll(uint64_t t_ms);
+  // Writes the block now, if any; readers only see written blocks
+  bool flush();
+
+  // ---- Readers ----
+  uint64_t lastTime() const { return last_; }
+  int segments() const { return nseg_; }
+  const LogSegment& segment(int i) const { return seg_[i]; }
+  // Segments and indexes, what retention counts
+  uint64_t bytes() const;
+  LogStats stats() const { return st_; }
+  void path(char* out, size_t cap, uint32_t seq, const char* ext) const;
+
+ private:
+  struct Prev {
+    telem_wire telem;
+    ble_posture_wire posture;
+  };
+
+  uint8_t* start(uint8_t kind, uint64_t t_ms, uint8_t dev);
+  void end(const uint8_t* o, size_t rawBytes);
+  bool writeBlock();
+  bool roll();
+  void retain();
+  void dropOldest();
+  void closeFiles();
+  bool recover(LogSegment& s, bool* torn);
+  bool loadIndex(LogSegment& s);
+
+  char dir_[48];
+  uint64_t maxBytes_ = 0;
+  LogSegment seg_[MAX_SEGMENTS];
+  int nseg_ = 0;
+  FILE* segFile_ = nullptr;     // newest segment, appending
+  FILE* idxFile_ = nullptr;
+  uint64_t last_ = 0;
+  LogStats st_ = {};
+
+  // Block being filled: header and payload back to back
+  uint8_t blk_[sizeof(LogBlockHeader) + BLOCK_BYTES];
+  size_t len_ = 0;
+  uint16_t count_ = 0;
+  uint64_t t0_ = 0;
+  uint64_t tPrev_ = 0;
+  Prev prev_[MAX_DEVS];         // deltas start from zero in every block
+};
+
+// Records of a time range, block by block through one block buffer; nothing
+// else of the log is held in RAM
+class LogReader {
+ public:
+  explicit LogReader(const SessionLog& log) : log_(log) {}
+  ~LogReader() { close(); }
+
+  // Records with from <= t < to, of one device or every one (dev < 0)
+  void seek(uint64_t from, uint64_t to, int dev = -1);
+  bool next(LogRecord& r);
+  uint32_t blocksRead() const { return blocks_; }
+
+ private:
+  bool open(int i);
+  void close();
+  bool readBlock();
+  bool decode(LogRecord& r);
+
+  const SessionLog& log_;
+  FILE* f_ = nullptr;
+  int seg_ = 0;
+  uint64_t from_ = 0;
+  uint64_t to_ = 0;
+  int dev_ = -1;
+  bool done_ = true;
+  uint32_t blocks_ = 0;
+
+  uint8_t buf_[SessionLog::BLOCK_BYTES];
+  LogBlockHeader hdr_;
+  size_t pos_ = 0;
+  uint16_t left_ = 0;
+  uint64_t t_ = 0;
+  telem_wire telem_[SessionLog::MAX_DEVS];
+  ble_posture_wire posture_[SessionLog::MAX_DEVS];
+};
+
+// One CSV line (with '\n') for r; the length, 0 if cap is too small
+extern const char LOG_CSV_HEADER[];
+size_t logCsv(const LogRecord& r, char* out, size_t cap);
+
+uint32_t logCrc32(uint32_t crc, const void* buf, size_t len);
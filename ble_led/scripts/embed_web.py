@@ -0,0 +1,60 @@
+"""
+Gzip web/index.html into src/index_html_gz.h, so the page is served
+straight out of flash with Content-Encoding: gzip and an ETag.
+
+Runs as a PlatformIO pre-script (extra_scripts in platformio.ini) on every
+build, or by hand:  python3 scripts/embed_web.py
+The header is only rewritten when its content changes, and the gzip stream
+has no timestamp, so rebuilds are reproducible.
+"""
+
+import gzip
+import hashlib
+import os
+
+try:
+    Import("env")  # noqa: F821 (PlatformIO)
+    ROOT = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+SRC = os.path.join(ROOT, "web", "index.html")
+OUT = os.path.join(ROOT, "src", "index_html_gz.h")
+
+
+def render(raw):
+    gz = gzip.compress(raw, compresslevel=9, mtime=0)
+    etag = hashlib.sha1(raw).hexdigest()[:16]
+    lines = [
+        "#pragma once",
+        "",
+        "// Generated by scripts/embed_web.py from web/index.html, do not edit.",
+        "// const data stays in flash (DROM) and is sent from there.",
+        "#include <stddef.h>",
+        "#include <stdint.h>",
+        "",
+        '#define INDEX_HTML_ETAG "\\"%s\\""' % etag,
+        "static const size_t INDEX_HTML_RAW_LEN = %d;" % len(raw),
+        "static const size_t INDEX_HTML_GZ_LEN = %d;" % len(gz),
+        "static const uint8_t INDEX_HTML_GZ[] = {",
+    ]
+    for i in range(0, len(gz), 16):
+        lines.append("  " + ",".join("0x%02x" % b for b in gz[i:i + 16]) + ",")
+    lines.append("};")
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    with open(SRC, "rb") as f:
+        text = render(f.read())
+    old = None
+    if os.path.exists(OUT):
+        with open(OUT) as f:
+            old = f.read()
+    if text != old:
+        with open(OUT, "w") as f:
+            f.write(text)
+        print("embed_web: wrote %s" % os.path.relpath(OUT, ROOT))
+
+
+main()
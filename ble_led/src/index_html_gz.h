@@ -0,0 +1,233 @@
+#pragma once
+
+// Generated by scripts/embed_web.py from web/index.html, do not edit.
+// const data stays in flash (DROM) and is sent from there.
+#include <stddef.h>
+#include <stdint.h>
+
+#define INDEX_HTML_ETAG "\"5248405ffce8fb4d\""
+static const size_t INDEX_HTML_RAW_LEN = 9094;
+static const size_t INDEX_HTML_GZ_LEN = 3521;
+static const uint8_t INDEX_HTML_GZ[] = {
+  0x1f,0x8b,0x08,0x00,0x00,0x00,0x00,0x00,0x02,0x03,0xbd,0x5a,0xdd,0x76,0xdb,0x36,
+  0x12,0xbe,0xf7,0x53,0xa0,0x6a,0x36,0xa4,0x6a,0x89,0x92,0xec,0xc4,0xf1,0x4a,0xa2,
+  0x7c,0x12,0x27,0x69,0xb2,0x75,0x13,0x1f,0xdb,0x69,0x2f,0xb2,0x3d,0x0d,0x45,0x82,
+  0x12,0x63,0x8a,0x60,0x08,0xc8,0xb2,0xea,0xe8,0x76,0x1f,0x60,0x1f,0x71,0x9f,0x64,
+  0xbf,0x01,0x40,0x8a,0xf2,0x5f,0xdc,0x3d,0x3d,0x9b,0x36,0x0e,0x09,0x60,0x06,0x98,
+  0xbf,0x6f,0x66,0x40,0x0f,0xbf,0x8b,0x44,0xa8,0x96,0x39,0x67,0x53,0x35,0x4b,0x47,
+  0x43,0xfb,0x93,0x07,0xd1,0x68,0x6b,0x38,0xe3,0x2a,0x60,0xe1,0x34,0x28,0x24,0x57,
+  0x7e,0x63,0xae,0xe2,0xf6,0x7e,0xa3,0x33,0x32,0xc3,0x59,0x30,0xe3,0x7e,0xe3,0x22,
+  0xe1,0x8b,0x5c,0x14,0xaa,0xc1,0x42,0x91,0x29,0x9e,0x61,0xd9,0x22,0x89,0xd4,0xd4,
+  0x8f,0xf8,0x45,0x12,0xf2,0xb6,0x7e,0x69,0x25,0x59,0xa2,0x92,0x20,0x6d,0xcb,0x30,
+  0x48,0xb9,0xdf,0x03,0x8f,0xad,0xa1,0x4a,0x54,0xca,0x47,0xaf,0x4e,0x8f,0x77,0x77,
+  0xd8,0x8b,0xa3,0x57,0xec,0x50,0x64,0x71,0x32,0x19,0x76,0xcc,0xf8,0xd6,0x50,0xaa,
+  0x25,0xfd,0x3b,0x16,0xd1,0xf2,0x2a,0x06,0xef,0x76,0x1c,0xcc,0x92,0x74,0xd9,0x97,
+  0x4b,0xa9,0xf8,0xac,0x3d,0x4f,0x5a,0xed,0x20,0xcf,0x53,0xde,0x36,0x03,0xad,0x53,
+  0x3e,0x11,0x9c,0x7d,0x78,0xdb,0x3a,0x11,0x63,0xa1,0x44,0xeb,0x79,0x81,0x1d,0x5b,
+  0x32,0xc8,0x64,0x5b,0xf2,0x22,0x89,0x07,0xb3,0xa0,0x98,0x24,0x59,0x7f,0xe7,0x49,
+  0x7e,0x89,0xe7,0x4b,0x73,0xb4,0xfe,0xb3,0x9d,0x6e,0x7e,0xb9,0xda,0x9a,0xf6,0xcc,
+  0x26,0x32,0xf9,0x83,0xf7,0xf5,0x50,0x1a,0x8c,0x79,0x7a,0x15,0x25,0x32,0x4f,0x83,
+  0x65,0x7f,0x9c,0x8a,0xf0,0xbc,0x64,0xd1,0xdb,0xc9,0x2f,0x59,0x97,0xed,0x11,0x61,
+  0x92,0xe5,0x73,0x75,0x65,0x78,0xf5,0xba,0xdd,0xbf,0x0d,0xf2,0x20,0x8a,0x92,0x6c,
+  0x82,0x17,0xec,0xb3,0xe6,0xd9,0xc3,0xea,0xc1,0x58,0x5c,0xd2,0x1b,0x4d,0x8f,0x45,
+  0x11,0xf1,0xa2,0x8d,0x91,0xd5,0xd6,0x78,0xae,0x94,0xc8,0xae,0xea,0x94,0xac,0xf7,
+  0xe4,0x26,0xb9,0xdd,0x1e,0x8f,0xac,0xfc,0xdb,0x1d,0x84,0xf3,0x42,0x8a,0xa2,0x9f,
+  0x8b,0x04,0xfa,0x2f,0x56,0x5b,0x5e,0x18,0x14,0xd1,0x9a,0x97,0xd9,0x96,0xf6,0xea,
+  0xf7,0xb0,0x5e,0x8a,0x34,0x89,0xd8,0xf7,0x51,0x14,0xd9,0xd1,0x76,0x11,0x44,0xc9,
+  0x5c,0x6a,0x99,0xec,0x06,0x38,0x14,0xce,0x33,0xd3,0xb4,0xe0,0x57,0x88,0x45,0xa5,
+  0x86,0x38,0xe5,0x97,0x83,0x49,0x90,0xf7,0xf7,0xe9,0x74,0x78,0x69,0x2f,0x0a,0xbc,
+  0xd1,0x8f,0x95,0x27,0xce,0xaf,0x42,0x91,0xe2,0x2c,0xdf,0x77,0x83,0xee,0xca,0x1b,
+  0x07,0x51,0xf9,0x1e,0x74,0xbb,0xab,0xad,0x50,0x44,0xfc,0x6a,0x1c,0x84,0xe7,0x93,
+  0x42,0xcc,0xb3,0xa8,0xff,0x7d,0xfc,0x94,0xfe,0xab,0x14,0xb6,0x63,0x44,0xba,0x76,
+  0x2e,0x7d,0x86,0x61,0xc7,0x78,0xc3,0xb0,0xa3,0x1d,0x73,0x48,0x4e,0x01,0x17,0x99,
+  0xf6,0xac,0xff,0xfc,0xca,0xc7,0xd6,0x7f,0xd8,0x7f,0xfe,0xf5,0xef,0xd2,0x9d,0x54,
+  0x21,0x52,0x50,0xf4,0xb0,0x32,0x4a,0x2e,0x58,0x98,0x06,0x52,0xfa,0x0d,0x52,0x4f,
+  0x63,0xb4,0xc5,0xd8,0x30,0x16,0xc5,0x8c,0x25,0x11,0x86,0xe2,0x49,0x83,0xc1,0xa9,
+  0xa7,0x02,0x2f,0xc7,0xef,0x4f,0xcf,0x1a,0x2c,0x08,0x55,0x22,0x32,0xbf,0xd1,0x91,
+  0xc1,0x05,0xd7,0xcb,0x41,0xa0,0x5d,0x62,0x74,0x06,0x25,0x71,0xa5,0x37,0x79,0x87,
+  0x18,0x60,0x6e,0x76,0xf2,0xfa,0xe9,0xee,0x93,0xee,0xcb,0x9f,0x58,0x10,0x5d,0xf0,
+  0x42,0x25,0x12,0xe2,0xe8,0xf8,0x68,0x0e,0x3b,0x86,0xc6,0xd0,0x6b,0x5f,0xb1,0x81,
+  0x33,0x4e,0x39,0x51,0x37,0x58,0xc1,0xbf,0xcc,0x93,0x82,0x47,0x9d,0x8d,0x4d,0x4e,
+  0x79,0x41,0xf1,0xc3,0x3e,0x7c,0x78,0xfb,0xf2,0x6e,0x26,0xf2,0x22,0xa4,0x05,0x77,
+  0x31,0x39,0x44,0xe4,0x42,0x10,0x78,0xbf,0x54,0x49,0xa8,0x79,0x31,0x77,0x51,0x24,
+  0x2a,0xc0,0xee,0xf7,0x9c,0x2d,0x9c,0x16,0xb7,0xb3,0x35,0x8e,0xca,0x08,0x2e,0xb0,
+  0xf9,0x7c,0x3c,0x4b,0x54,0x63,0x74,0x0a,0x0d,0xb1,0xc7,0xec,0xac,0x58,0x92,0xd2,
+  0x33,0x1e,0xaa,0x61,0xc7,0x2c,0xd4,0x5a,0xee,0x90,0x9a,0x61,0x82,0x0e,0x6c,0x70,
+  0x97,0x25,0xa6,0xbb,0xa3,0x53,0x15,0xa8,0xb9,0x84,0xb9,0x76,0xf5,0x08,0x2d,0x23,
+  0xd3,0x48,0x3d,0xdc,0x18,0x1d,0x89,0x80,0x9c,0xc4,0xf3,0x3c,0xcb,0xa8,0xb6,0xc6,
+  0x40,0x0d,0x16,0x6d,0x4e,0xd9,0x5d,0xe0,0xbe,0x8d,0xcd,0xe3,0x8b,0x2c,0x4c,0x93,
+  0xf0,0x1c,0xcc,0x79,0x16,0xb9,0x4e,0x27,0xe5,0xd1,0x01,0xed,0xc3,0x7d,0x91,0x39,
+  0xcd,0xc6,0xe8,0x79,0x9a,0xb2,0xa3,0x57,0x2f,0x25,0x7b,0xff,0xae,0x2e,0xc9,0x83,
+  0x18,0xc4,0xf1,0x26,0x87,0xd7,0xaf,0xff,0x2c,0x0b,0x25,0x26,0x93,0x94,0x13,0x97,
+  0xb3,0xf7,0x3f,0xfe,0x08,0x27,0x0b,0xd2,0xf4,0x1b,0x3c,0x0a,0x1e,0x17,0x5c,0x4e,
+  0x5d,0xd0,0x9c,0x98,0xc7,0x4d,0x0b,0x94,0x5a,0x91,0x33,0xf0,0xb2,0x21,0x43,0xfb,
+  0x4a,0x16,0x17,0x30,0x78,0x04,0xec,0x9e,0xcd,0x02,0xbc,0xb7,0x98,0x28,0x98,0xd3,
+  0x73,0x58,0x87,0x39,0x5d,0xfd,0xf3,0xcc,0x61,0x4a,0xb0,0x9c,0xf3,0x42,0xb2,0x45,
+  0x82,0x08,0x81,0x93,0xa8,0x29,0x67,0x79,0x01,0x8c,0x45,0x74,0xc3,0x1c,0x86,0xeb,
+  0x37,0x0d,0x7c,0x94,0x5c,0xf0,0xca,0xbc,0x61,0x90,0x5d,0x04,0x52,0x5b,0x2f,0x4f,
+  0x05,0xb2,0x87,0x49,0x1a,0x8d,0xbd,0xfd,0x6e,0x83,0x4d,0x79,0x32,0x99,0x22,0x91,
+  0xec,0xec,0xe0,0x45,0x07,0xbe,0x4d,0x2a,0x06,0x60,0x6f,0xa2,0x19,0xe7,0x9c,0x8c,
+  0x6f,0x98,0xd6,0x24,0x1d,0xca,0x3c,0xc8,0x4a,0x0e,0x25,0x34,0xed,0x85,0x8d,0x51,
+  0x9e,0xa8,0x70,0xca,0xdc,0xc7,0x11,0x9f,0x0c,0x10,0x07,0xb4,0x6c,0xc4,0x3a,0x5a,
+  0xb9,0xfa,0xcf,0x6d,0x84,0xe1,0x6e,0xb7,0x31,0x42,0xa2,0xc9,0x79,0x01,0x97,0x2c,
+  0xb8,0x25,0x3f,0xac,0xe8,0x1f,0xcf,0x92,0x28,0x12,0x6a,0x60,0xa9,0x49,0xb6,0x34,
+  0x21,0xf0,0x08,0x4d,0x54,0x94,0xee,0xab,0x57,0x3f,0x58,0x6d,0x67,0xf3,0x0c,0x84,
+  0x95,0xe2,0x4c,0xc8,0x1e,0x07,0x38,0xff,0x50,0xf2,0x14,0x6c,0xf5,0x46,0x4a,0x63,
+  0x12,0x94,0x20,0x72,0xc2,0x2d,0x76,0x11,0xa4,0x73,0x1c,0x5d,0x7b,0xe2,0xb0,0x63,
+  0x06,0x69,0x4f,0x4d,0x31,0xaa,0x45,0xbe,0x01,0x41,0x91,0x99,0x60,0x26,0x57,0x82,
+  0x6c,0x19,0x0b,0x67,0x91,0xab,0xa6,0x89,0x6c,0x36,0x36,0xe0,0xc1,0x04,0xfe,0x14,
+  0x72,0xf2,0xac,0x61,0xc1,0x22,0xd3,0x28,0x66,0x37,0xcc,0x85,0x24,0xdd,0x34,0x4a,
+  0xc0,0xb8,0x35,0x0e,0x2b,0x31,0x5e,0x51,0xc6,0x62,0x6e,0xd7,0xeb,0xf6,0xac,0x29,
+  0xea,0x28,0xc4,0x69,0xb6,0xe2,0xdc,0x7b,0xda,0xed,0x52,0xed,0x51,0x07,0xad,0x35,
+  0xa3,0xcb,0x44,0xdd,0xcd,0x07,0x93,0x15,0x9b,0xfd,0xfb,0xb8,0xe8,0xe3,0x44,0x0b,
+  0x8e,0xe8,0x75,0x67,0xf2,0x96,0xd3,0xfc,0xae,0x27,0x2b,0x66,0x3b,0xdd,0x6f,0x9d,
+  0xe9,0x2e,0x66,0x98,0xbb,0xc6,0xab,0x77,0x1f,0xaf,0xe7,0x29,0xd2,0x0a,0x73,0xaf,
+  0x71,0x09,0x68,0xb4,0x62,0xb0,0x7b,0x93,0xbe,0x8a,0xfc,0x3b,0xa1,0x1b,0x79,0xcc,
+  0x9a,0xec,0x36,0xcc,0xfe,0xcb,0xdd,0x03,0x65,0xa4,0xae,0x53,0x1a,0x9b,0x79,0xea,
+  0x98,0xa7,0x2a,0x81,0xea,0xcb,0xe9,0x9a,0x29,0x0f,0x37,0x45,0x0e,0x31,0xb6,0x96,
+  0xf8,0x16,0x63,0xde,0x2d,0x67,0xc9,0xfc,0xff,0x22,0xe8,0x34,0x40,0xc8,0x85,0xd7,
+  0xc4,0x7c,0xa3,0x07,0x59,0x1e,0x28,0xb8,0x52,0x06,0x21,0xdb,0xcf,0x36,0xa5,0xb3,
+  0x33,0x15,0x97,0x07,0x4a,0x77,0x8c,0xca,0xec,0xf6,0x0c,0x61,0xd6,0x99,0x97,0xc6,
+  0xb5,0x9c,0x63,0x20,0xc3,0x75,0x20,0xa2,0xd3,0xdc,0x76,0x0e,0xf4,0x11,0xc2,0x39,
+  0x7f,0x6c,0x4f,0xe1,0x3b,0xdb,0x24,0xb9,0x47,0x8a,0xf1,0xec,0x98,0xa7,0x0f,0x06,
+  0x65,0x7c,0x90,0x9c,0x01,0xbf,0xb1,0xfc,0x2f,0xda,0xd8,0x28,0xec,0x77,0xa9,0x44,
+  0x4e,0xa9,0xef,0x14,0xff,0xfe,0x4f,0x55,0x04,0x97,0x92,0xf0,0x2f,0x15,0x93,0x1b,
+  0xa5,0x04,0xc6,0x6e,0xaf,0x23,0x6e,0x37,0x7d,0x24,0x16,0x59,0x8a,0xd5,0x9b,0xf6,
+  0xbf,0x1f,0xd0,0x8e,0x02,0xa9,0x4a,0x58,0xb6,0x15,0x1a,0xc0,0xbe,0x5a,0x85,0x75,
+  0x9b,0xf8,0xbc,0xbb,0xd7,0xa5,0x3f,0x8d,0x11,0xf2,0x6a,0xb1,0xc6,0xe9,0xcd,0x45,
+  0xfb,0x7b,0x4f,0xcc,0x2a,0x66,0x38,0xf3,0x68,0xb4,0xf3,0x84,0x11,0x85,0xac,0x48,
+  0xee,0xda,0x60,0xaf,0xfb,0x64,0xdf,0x6e,0xf1,0x8c,0x45,0xc1,0x52,0xde,0xb5,0x49,
+  0x63,0xc4,0x51,0xba,0x2e,0x21,0x2b,0x25,0x9b,0x7b,0x12,0x46,0x3d,0x6c,0xeb,0x59,
+  0xc8,0x88,0x8b,0x52,0xac,0x51,0x2a,0x9b,0x9e,0xff,0x7c,0x42,0x7a,0x00,0x6a,0xbd,
+  0xb4,0x96,0x61,0x87,0xa7,0xbf,0xdc,0x11,0xcd,0x26,0xb9,0x1e,0x1b,0x68,0x63,0x10,
+  0x2d,0x53,0x92,0x89,0x98,0x69,0x21,0x29,0x02,0xc3,0x69,0x8b,0x29,0x6c,0x8e,0xaa,
+  0x1f,0x03,0x8b,0x69,0x92,0x72,0x06,0xbc,0x96,0xaa,0xe0,0xc1,0x4c,0x32,0x4a,0xdc,
+  0x1e,0x3b,0x09,0x16,0xd0,0xf9,0x64,0x46,0xd4,0x7d,0x14,0x2d,0x68,0x60,0x46,0x1d,
+  0x48,0xd6,0x49,0xb2,0x88,0x5f,0xa2,0xe0,0xa0,0x81,0x56,0x7d,0x22,0x06,0x9f,0xce,
+  0xe3,0x54,0x0d,0x48,0x1d,0x8f,0x27,0x6a,0x60,0x17,0x31,0xf7,0x24,0xc8,0x26,0x5c,
+  0x17,0xd4,0x5c,0x2a,0xd9,0xbc,0x59,0x37,0xc9,0xb0,0x48,0x72,0x35,0xda,0x8a,0xe7,
+  0x99,0xee,0x3d,0x58,0x55,0xd5,0x5d,0x41,0xa2,0x98,0xe3,0xc8,0xa8,0x13,0x4d,0x3d,
+  0xec,0x34,0x3d,0x14,0x61,0x99,0x5b,0xf8,0xa3,0xc2,0xfb,0x2c,0x45,0xe6,0x36,0xed,
+  0xc8,0x67,0x7f,0x74,0xa5,0x55,0x87,0xa2,0x43,0x2a,0x26,0xce,0xfd,0xcf,0x9e,0xad,
+  0x3f,0x50,0x61,0x3a,0xe2,0xdc,0xe9,0x3b,0x68,0xcc,0x9c,0x81,0x5e,0x84,0xd6,0x7f,
+  0x4e,0xd2,0x79,0x08,0xc8,0x57,0xa4,0x8c,0x4c,0xbd,0x58,0xbe,0x45,0x3d,0x5a,0x6d,
+  0x93,0x80,0xb4,0x78,0x73,0xf6,0xf3,0x91,0x6f,0x6d,0xff,0x89,0x42,0xc0,0x98,0x9e,
+  0x4b,0x56,0xb1,0x86,0x7a,0xc6,0x65,0x60,0x3c,0xba,0x12,0xe7,0xab,0xc6,0xe8,0xd1,
+  0x55,0x6d,0xeb,0x15,0x0c,0x35,0x22,0x0b,0xd0,0xa8,0x2d,0xd8,0xbd,0x94,0x67,0x13,
+  0x35,0x5d,0xd5,0x0c,0x6e,0x43,0xcc,0xf6,0x58,0xa5,0xce,0x89,0xc6,0xf6,0x4b,0x2b,
+  0xab,0xd0,0x5b,0x68,0x6c,0xcb,0x54,0x27,0xb2,0xfd,0xd1,0x3d,0x44,0xd4,0x22,0xd5,
+  0x29,0x6c,0xeb,0x73,0x0f,0xc5,0x59,0xe9,0x35,0x7d,0x2d,0x8b,0x76,0xa2,0x15,0x8c,
+  0x15,0xa2,0x2c,0x45,0x01,0x5d,0x8d,0xbd,0x08,0xa2,0x15,0x83,0xaa,0xcd,0x10,0x39,
+  0xd4,0x61,0x9a,0x90,0x27,0xad,0x18,0x5d,0x9a,0x70,0x8a,0xde,0x1b,0xcc,0x7f,0x06,
+  0x7e,0x05,0x13,0x6e,0x58,0xcf,0xe4,0xe4,0xeb,0x57,0xc7,0xb1,0xfa,0xf9,0x64,0x4c,
+  0xd6,0xe9,0xb0,0xf7,0x19,0x1c,0x49,0x2c,0x50,0x95,0x17,0xa5,0x2b,0x53,0x69,0x0e,
+  0xff,0x85,0x8f,0x2f,0xe0,0x38,0x28,0xd2,0x61,0x1b,0xf4,0xd8,0x58,0xd0,0x81,0xb2,
+  0x3b,0xc3,0x6c,0xd4,0xb9,0xdf,0xe0,0xd6,0x24,0x1b,0x16,0x5f,0x1b,0x6a,0x16,0xe4,
+  0x6e,0x54,0x7a,0x56,0xe9,0x5b,0x73,0xdf,0xd1,0xcc,0x9d,0xed,0x88,0x16,0xb6,0x58,
+  0xe8,0x47,0x9e,0xe9,0x61,0x7c,0x07,0x61,0x14,0x2d,0x9d,0x1b,0x0e,0xc7,0x98,0x45,
+  0xd7,0x4f,0x37,0x21,0x7c,0x38,0x86,0x05,0x22,0x4f,0x23,0x81,0x71,0x97,0xd2,0x2c,
+  0x91,0x17,0x44,0x51,0x51,0xda,0x64,0x8d,0x75,0x35,0x8f,0x0b,0xb5,0xc3,0xd9,0xfd,
+  0x35,0x35,0xbd,0xe1,0x58,0xbe,0x6f,0x94,0xff,0x92,0x5f,0x1c,0x38,0xeb,0x1a,0x9d,
+  0x86,0x70,0x32,0x67,0xb5,0xe6,0x46,0x4a,0xb6,0xc0,0xf1,0xe8,0xca,0x8d,0xbc,0x44,
+  0x5d,0xa4,0x3f,0xf4,0xbc,0x9d,0xa7,0x08,0x2d,0xf1,0x3a,0xb9,0xe4,0x91,0xdb,0x6b,
+  0xae,0x18,0xd0,0x41,0xdf,0xb4,0x00,0xd1,0xc8,0xb4,0x91,0xa7,0x7b,0x28,0x58,0xd5,
+  0xfc,0xdb,0x5a,0x77,0x11,0x7a,0x36,0xc9,0xe2,0x94,0xda,0x99,0x15,0xa8,0x98,0x79,
+  0x34,0x64,0x88,0x6d,0x6a,0xc1,0xc8,0x75,0xf4,0x83,0x19,0xcd,0x82,0x73,0x3d,0xf4,
+  0x59,0x47,0x4d,0x09,0x12,0x9b,0x9e,0x72,0x67,0x16,0xba,0xa7,0xc1,0x7c,0x74,0x35,
+  0x5f,0xdd,0x68,0x74,0xaf,0xf7,0xb7,0x7f,0x8a,0x83,0xe9,0x74,0x6f,0x34,0xb8,0x7f,
+  0x86,0xc7,0xf5,0x56,0xf7,0x41,0x9c,0xa2,0x44,0x86,0x02,0x30,0x6e,0xb8,0x11,0xf1,
+  0x4b,0x3b,0xf2,0x20,0x72,0xdd,0xfa,0x59,0xe4,0xf1,0xa9,0x9d,0x2b,0x9f,0xbb,0x83,
+  0xfa,0x19,0xc9,0x3d,0xc0,0xda,0x34,0xad,0x0f,0x60,0x5b,0x70,0x42,0xfc,0xf5,0x99,
+  0x4e,0xf4,0xfb,0x83,0x48,0x43,0xba,0xb8,0x2a,0x66,0xae,0xf3,0x5a,0xe8,0x8b,0xa5,
+  0x75,0x10,0x1c,0x38,0xcd,0xc7,0x8f,0x6b,0xa7,0x8a,0xf5,0x02,0x62,0x6f,0x96,0xde,
+  0x64,0x6f,0x1c,0x65,0x03,0x30,0x56,0x4d,0xef,0x33,0xea,0x5e,0xd7,0x71,0x9a,0x83,
+  0x7a,0x66,0xc8,0x95,0xf4,0x9d,0x7b,0xd3,0xb3,0xb3,0x6d,0xf9,0xde,0x00,0x82,0x4f,
+  0xd7,0xe8,0x6c,0xac,0xd9,0x18,0x2c,0x23,0xd8,0xb2,0xf9,0x74,0xfd,0x00,0x10,0xc3,
+  0x35,0x87,0x40,0xf3,0x8e,0x94,0xf0,0xd1,0x31,0x25,0xa1,0xd3,0x72,0x4c,0xd9,0xe0,
+  0xfc,0xd6,0xdc,0x84,0x1a,0xe5,0xdf,0x05,0x5c,0x49,0xd4,0x6c,0xb1,0x0b,0x5f,0x99,
+  0xca,0xb4,0x04,0x19,0x55,0x43,0x31,0x12,0x74,0xc0,0xec,0x02,0xff,0xc2,0x2a,0x65,
+  0x4b,0x2b,0x26,0x24,0xf4,0x74,0x7f,0x07,0xb2,0x3d,0x30,0x13,0x9e,0xf1,0x4b,0xe5,
+  0x3b,0xaf,0x03,0xa4,0xf9,0x88,0x2e,0x46,0x74,0x5a,0x66,0x76,0xcd,0x60,0x05,0x01,
+  0x57,0xeb,0x04,0x5e,0x55,0x90,0xb1,0x16,0xc7,0x88,0xf2,0xc5,0xcf,0xf8,0x82,0x7d,
+  0x38,0x39,0x3a,0xe5,0x41,0x11,0x4e,0x8f,0x03,0xa0,0x86,0x74,0xb5,0x66,0x92,0xd8,
+  0x8d,0x3d,0x2a,0x18,0x6d,0x99,0xcd,0xbe,0x78,0x92,0x0a,0xe5,0xb8,0x10,0x33,0xa7,
+  0xf5,0x12,0x11,0xe3,0x65,0x62,0xe1,0x36,0xdb,0x1b,0xab,0x2a,0x4a,0x28,0xce,0x0c,
+  0x7d,0x07,0xfc,0x75,0x2a,0x6a,0xd2,0x67,0xab,0x36,0xab,0x09,0x52,0x01,0xd1,0x71,
+  0x46,0x6f,0x8a,0x2a,0x03,0x38,0x0e,0xbd,0x1f,0x38,0xdb,0x5f,0x00,0x74,0xa7,0xaa,
+  0x40,0x09,0x88,0x03,0x95,0x48,0x1d,0x07,0xa9,0xe4,0x1b,0x72,0x61,0xf1,0xdb,0x2c,
+  0x16,0x9b,0x85,0x49,0x55,0x16,0x3d,0xb8,0x36,0x91,0x40,0xe6,0xb2,0xba,0x6a,0xb1,
+  0xc8,0x57,0xfe,0x88,0x54,0x43,0x72,0xba,0x8a,0x30,0xf7,0x48,0xd0,0xe7,0x82,0xea,
+  0x40,0xf7,0x27,0x30,0xec,0xbf,0x61,0xa4,0xef,0x3e,0x7b,0xe2,0xfc,0xc0,0x79,0x27,
+  0xe8,0xb8,0xcc,0x8d,0x81,0x96,0x53,0x96,0x09,0xc5,0x66,0x62,0x0e,0xf8,0x8e,0x9a,
+  0x4e,0xbf,0xac,0x68,0x80,0xf6,0xa8,0x2f,0x96,0xc8,0x99,0x9d,0x5e,0x77,0xe7,0xc9,
+  0x1a,0xee,0xbb,0x80,0x7b,0x5d,0xb2,0x60,0x3e,0x0c,0xf2,0x5b,0x66,0x7f,0x4a,0x5e,
+  0x10,0x6e,0x57,0xa5,0x4c,0x55,0x2e,0x7e,0x2a,0x63,0xc7,0x2d,0xe7,0x10,0xc9,0x1f,
+  0xbb,0xbf,0x79,0xfa,0x43,0x82,0x3c,0xf8,0xa4,0xe1,0xde,0xd5,0x43,0x8a,0x38,0xc1,
+  0x99,0xcc,0x40,0xb9,0xbe,0xdd,0xc3,0x0c,0x12,0xce,0xa7,0xbe,0x0d,0x9c,0x6b,0xde,
+  0x65,0xdb,0xa8,0xa2,0xe6,0x5b,0x77,0x87,0x49,0x19,0x61,0xcd,0x75,0x9c,0x58,0xf3,
+  0x2a,0x9f,0xbc,0xe5,0xc0,0x41,0x1a,0x2f,0xfa,0x65,0x42,0x57,0xdb,0xfa,0x7d,0x63,
+  0x3f,0x8b,0x70,0xf3,0xda,0x7e,0xa9,0x9f,0xc3,0x35,0x73,0x38,0xd9,0x11,0x85,0xbc,
+  0x53,0xfa,0x62,0xda,0xd4,0xd7,0x8b,0xee,0x1c,0x6c,0x34,0x18,0x1c,0xe8,0x9f,0xe8,
+  0x28,0x79,0x46,0x29,0xfc,0xc3,0xc9,0xdb,0x43,0xd0,0x89,0x0c,0xc7,0xc3,0xe2,0x4d,
+  0xb9,0x0c,0x65,0x91,0xd6,0xbc,0x0b,0x6f,0xad,0x2b,0x73,0x3f,0xdf,0x77,0xe8,0x7e,
+  0xde,0x59,0x7d,0xdb,0xc9,0xf4,0xed,0x88,0x6b,0xab,0xa8,0x7f,0x9c,0xbe,0x7f,0x87,
+  0xda,0x80,0x3c,0x29,0x89,0x97,0xee,0xe7,0xa6,0xf6,0x6f,0x5b,0x5f,0x0f,0xae,0x81,
+  0x81,0xa1,0x74,0x4e,0x4c,0xad,0x8e,0x00,0xa0,0x68,0x77,0xae,0x1d,0x93,0x6e,0x06,
+  0x4c,0x5c,0xdf,0xda,0xd4,0x3a,0xdb,0xb7,0x85,0x39,0x8d,0x01,0xba,0x67,0xf0,0xf1,
+  0x00,0xd4,0xcd,0x5a,0xbc,0xdd,0x17,0x70,0x55,0xca,0x9b,0xd7,0x95,0x02,0xe5,0x96,
+  0x13,0x0f,0x8e,0xb9,0xd4,0x77,0xa9,0x1c,0x92,0xea,0xeb,0xd7,0x8f,0xbf,0x35,0x35,
+  0x9c,0x07,0x10,0xd8,0x83,0x1d,0x73,0x09,0x4f,0xa0,0x9a,0x31,0x4e,0x32,0x6a,0x15,
+  0x4e,0x7f,0x39,0x64,0xce,0x76,0xe0,0xcd,0xe7,0x09,0xb4,0xce,0xd8,0xe1,0x9b,0x93,
+  0xea,0x7d,0xdb,0x61,0x9a,0xa2,0x4f,0x03,0xfa,0xc9,0x86,0xa7,0x51,0x5d,0x6a,0x5d,
+  0xf8,0x20,0xb5,0xc8,0xff,0x4f,0x94,0x1b,0x7d,0x8a,0x45,0x69,0x6a,0x74,0xd9,0xd1,
+  0x1f,0x15,0x91,0x09,0xb0,0xa1,0xe7,0xdc,0x65,0x81,0x32,0xb1,0x6f,0x9a,0x00,0x15,
+  0x30,0xa5,0x65,0x46,0x17,0xc7,0x7d,0x36,0x4e,0xb2,0x00,0x1d,0xdc,0xcc,0x14,0xce,
+  0x74,0xa3,0x2d,0x66,0x6c,0x21,0xfb,0x9d,0xce,0x70,0x8a,0xf6,0x6f,0xd4,0xdf,0xef,
+  0x75,0x10,0x84,0x9c,0xeb,0x92,0xef,0xf7,0x85,0xf4,0xa6,0xcd,0x2d,0xa3,0x8c,0xe3,
+  0xb3,0x53,0x1f,0x0d,0x78,0x8b,0xe9,0x9a,0xc0,0xff,0xf8,0x1b,0xb5,0x84,0xb3,0x1c,
+  0x0f,0x83,0x1a,0xd8,0x81,0xca,0xad,0xf9,0xfc,0x42,0x6a,0x00,0xff,0x95,0x8f,0x4f,
+  0x11,0xc8,0x64,0x72,0xbd,0x99,0xb3,0xbd,0x86,0x54,0x6c,0x4b,0xa1,0xb2,0xed,0xd0,
+  0xde,0x46,0x38,0x6c,0x6b,0x0e,0x7a,0x46,0x9d,0xac,0x13,0x14,0x45,0xb0,0x1c,0xcf,
+  0xe3,0x18,0xa6,0xb3,0xd3,0x22,0xb3,0x22,0xf8,0x7c,0xd3,0x64,0x17,0xbe,0x45,0xc5,
+  0xe0,0x17,0xb4,0x0d,0x2e,0xf7,0x22,0x3c,0xd6,0x32,0x69,0x8a,0x92,0x41,0xf8,0xfb,
+  0x03,0xb1,0xbd,0xdb,0x1d,0xfa,0x17,0x1a,0xc8,0x8e,0xb4,0xfa,0x31,0xe4,0xef,0x76,
+  0xab,0x54,0x6a,0x2a,0x9f,0x7c,0x0e,0x97,0xbf,0x20,0x7c,0x78,0x9b,0xa9,0xde,0x9e,
+  0x2b,0xb6,0x77,0xba,0x2d,0x55,0x20,0x2f,0x00,0xde,0xba,0xcd,0xc1,0xb5,0xbc,0xbb,
+  0xb9,0x72,0xcf,0xac,0xac,0xd2,0x2c,0x95,0x4f,0x9a,0x21,0x50,0xa4,0xbd,0xbb,0xf3,
+  0x6c,0x6f,0xff,0x20,0x9b,0xa7,0x69,0x5f,0xd5,0x78,0x99,0x0a,0x5b,0x77,0xd8,0x6e,
+  0xbd,0xf8,0x1a,0x41,0xfd,0xcd,0x2b,0x33,0x22,0xa7,0x49,0xac,0x10,0x88,0x9a,0x61,
+  0xf9,0xb2,0xfa,0x06,0xe0,0xeb,0x12,0xad,0x86,0xf8,0x25,0x9c,0xa7,0xd0,0x3f,0xb0,
+  0x54,0x9f,0xfc,0x03,0x4a,0xf5,0xdd,0x1d,0xd7,0x4a,0xb8,0x6a,0x31,0x84,0xf4,0x1c,
+  0xa9,0x7b,0x73,0xfa,0x89,0x9d,0xd6,0x15,0xd3,0xaa,0x32,0x48,0x08,0x4e,0xdc,0x77,
+  0x9b,0xf7,0x95,0x07,0x37,0x4e,0xe1,0x50,0x27,0x58,0xbb,0xef,0x77,0x50,0x56,0xaa,
+  0xb3,0x64,0xc6,0xd1,0x94,0xb9,0xb4,0xba,0x45,0xb7,0xc6,0x90,0x6e,0x13,0xcc,0x8b,
+  0x20,0xe4,0x6e,0xd8,0x8a,0x5a,0xa9,0x68,0x4d,0x93,0x56,0x28,0xd2,0x9a,0xcf,0xfd,
+  0xea,0x87,0x9e,0xf9,0xb8,0xe1,0x99,0xef,0xe9,0x6f,0xd6,0x03,0xe6,0x63,0x09,0x9d,
+  0x39,0x24,0x80,0x13,0xe7,0x48,0x98,0xf4,0xd9,0x02,0x1c,0x06,0xa1,0x37,0xe6,0x93,
+  0x24,0x43,0xb3,0x4e,0x28,0x47,0x8e,0x92,0xf3,0xcc,0xb7,0xf8,0x02,0xd5,0xd2,0xdd,
+  0xde,0xab,0x00,0x21,0xe7,0x2e,0x5b,0x49,0xb3,0x74,0x3b,0x00,0xf8,0x12,0x50,0x40,
+  0x86,0x84,0x7d,0x2a,0x02,0x83,0x4e,0xd6,0x2a,0xe6,0x5c,0xf9,0xa5,0x9f,0xfc,0xf0,
+  0x6b,0x07,0x86,0x6c,0xe5,0x4b,0xff,0x4d,0xdb,0x5d,0xb6,0x53,0xd1,0xfc,0xe1,0x4d,
+  0xc7,0x9d,0x26,0xf4,0x64,0x1c,0x00,0x2c,0x0e,0x42,0x80,0x4e,0xc6,0xcf,0x84,0x9b,
+  0x5f,0x62,0x69,0xb3,0x1f,0x7a,0x33,0x04,0x76,0xf5,0x3e,0xa0,0x6d,0xc8,0x06,0x65,
+  0x9e,0x5b,0x4b,0xe3,0x5e,0xab,0xa9,0x8a,0x60,0x51,0x0f,0xc7,0xf0,0xee,0x94,0x47,
+  0xf8,0x00,0xd3,0x60,0x98,0xbe,0x05,0xc3,0x36,0xae,0xb3,0x13,0x39,0x96,0x79,0x98,
+  0x02,0x97,0x4f,0x60,0x25,0xf8,0x46,0xb7,0x75,0x4d,0xbd,0xd7,0x94,0xab,0x49,0x4a,
+  0x0b,0x69,0x87,0x6d,0xb5,0xff,0xde,0x6d,0xe1,0x7f,0x87,0x3e,0x27,0x39,0x1b,0xf3,
+  0xe4,0xc2,0xad,0xde,0xd3,0xd6,0x53,0x9a,0x0d,0x77,0xbb,0x66,0xd6,0xde,0xfb,0x3c,
+  0xcf,0x92,0x99,0x06,0x89,0xd7,0xd4,0x2b,0xba,0x24,0x4c,0x09,0x69,0x67,0xf4,0x51,
+  0x0d,0xe1,0x4f,0x5d,0x3c,0x4f,0x63,0x96,0x48,0x5d,0x56,0x26,0x21,0x73,0x27,0x7f,
+  0x24,0xb9,0xe9,0x1e,0x51,0xc3,0xa0,0xcd,0x86,0xc5,0xe0,0xc2,0xe3,0x25,0x7b,0x75,
+  0x16,0x4c,0x90,0x37,0xe8,0x7b,0x1c,0x7d,0xa6,0x8e,0x88,0x8f,0x49,0x44,0xf4,0x45,
+  0xaf,0x04,0xc3,0x8e,0x6e,0x30,0x26,0xb5,0xd4,0xa5,0xdf,0x37,0xcb,0x37,0x33,0xf6,
+  0xe0,0x3c,0x12,0xdf,0xad,0xf6,0x30,0x9e,0x54,0x85,0x7e,0x79,0x6b,0x63,0x8b,0xef,
+  0xea,0x16,0x67,0x10,0x97,0x57,0x33,0xd5,0x8c,0x7d,0xc7,0x8c,0xbd,0x82,0xa9,0x66,
+  0xec,0xfb,0xba,0x04,0xb2,0xda,0x9a,0xa0,0x50,0x5c,0x04,0x4b,0x36,0x0d,0x24,0x0a,
+  0x3b,0xf4,0xc3,0xc0,0x63,0x2a,0xd7,0xca,0x6b,0x10,0x68,0xec,0xf9,0x31,0xca,0xbd,
+  0x88,0x1b,0x15,0x51,0x1d,0x68,0xb4,0x3a,0xcb,0xa1,0x3f,0x7d,0x65,0x42,0x77,0xbb,
+  0xe8,0xc4,0xf8,0x56,0xa5,0x07,0xe2,0x72,0x30,0x43,0x6b,0xb4,0xbd,0x2e,0xb8,0x6f,
+  0x16,0x1f,0xc8,0x91,0xe8,0xcb,0x97,0xae,0x2d,0x85,0x71,0xac,0x52,0xa9,0xf5,0xba,
+  0xc2,0x26,0x8f,0x81,0xf5,0xda,0x01,0xfd,0x1e,0x83,0xbd,0xe5,0x43,0xeb,0x46,0xbf,
+  0xc3,0x30,0xec,0xe8,0xdf,0xb7,0xd9,0xfa,0x2f,0x61,0x0a,0x82,0xcd,0x86,0x23,0x00,
+  0x00,
+};
@@ -0,0 +1,146 @@
+#include "live_ws.h"
+
+#include <errno.h>
+#include <lwip/sockets.h>
+#include <mbedtls/base64.h>
+#include <mbedtls/sha1.h>
+
+static const char* WS_GUID = "258EAFA5-E9A4-47DA-95CA-C5AB0DC85B11";
+
+void LiveServer::begin() {
+  server_.begin();
+  server_.setNoDelay(true);
+  Serial.printf("[Live] WebSocket on port %u\n", PORT);
+}
+
+int LiveServer::clients() const {
+  int n = 0;
+  for (int i = 0; i < MAX_CLIENTS; i++) n += cl_[i].open;
+  return n;
+}
+
+void LiveServer::accept() {
+  WiFiClient s = server_.available();
+  if (!s) return;
+
+  for (int i = 0; i < MAX_CLIENTS; i++) {
+    Client& c = cl_[i];
+    if (c.used) continue;
+    c.sock = s;
+    c.sock.setNoDelay(true);
+    c.used = true;
+    c.open = false;
+    c.since = millis();
+    c.req = "";
+    c.cur = FeedCursor();
+    c.outLen = c.outOff = 0;
+    return;
+  }
+  s.stop(); // 已满
+}
+
+// Reads the upgrade request as it trickles in; true once answered
+bool LiveServer::handshake(Client& c) {
+  while (c.sock.available() && c.req.length() < 1024) c.req += (char)c.sock.read();
+  if (c.req.indexOf("\r\n\r\n") < 0) return false;
+
+  int k = c.req.indexOf("Sec-WebSocket-Key:");
+  if (k < 0) {
+    c.sock.print("HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n");
+    close(c);
+    return false;
+  }
+  int e = c.req.indexOf("\r\n", k);
+  String key = c.req.substring(k + 18, e);
+  key.trim();
+  key += WS_GUID;
+
+  uint8_t sha[20];
+  unsigned char acc[32];
+  size_t accLen = 0;
+  mbedtls_sha1((const unsigned char*)key.c_str(), key.length(), sha);
+  mbedtls_base64_encode(acc, sizeof(acc) - 1, &accLen, sha, sizeof(sha));
+  acc[accLen] = 0;
+
+  c.sock.printf("HTTP/1.1 101 Switching Protocols\r\n"
+                "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                "Sec-WebSocket-Accept: %s\r\n\r\n", acc);
+  c.req = "";
+  c.open = true;
+  Serial.printf("[Live] Client %s connected\n", c.sock.remoteIP().toString().c_str());
+  return true;
+}
+
+// The page never sends data, so whatever arrives starts with a frame
+// header; a close frame ends the connection, anything else is discarded
+bool LiveServer::readFrames(Client& c) {
+  if (!c.sock.available()) return true;
+  if ((c.sock.read() & 0x0F) == 0x8) return false;
+
+  uint8_t skip[64];
+  while (c.sock.available()) c.sock.read(skip, sizeof(skip));
+  return true;
+}
+
+// Next message from this client's cursor, if the previous one is out
+void LiveServer::fill(Client& c) {
+  telem_wire recs[RECS_PER_MSG];
+  size_t n = ring_.collect(c.cur, recs, RECS_PER_MSG);
+  if (n == 0) return;
+  uint32_t backlog = ring_.backlog(c.cur);
+
+  size_t len = 8 + n * sizeof(telem_wire);
+  uint8_t* p = c.out;
+  *p++ = 0x82; // FIN, binary
+  if (len < 126) {
+    *p++ = (uint8_t)len;
+  } else {
+    *p++ = 126;
+    *p++ = (uint8_t)(len >> 8);
+    *p++ = (uint8_t)len;
+  }
+  memcpy(p, &c.cur.drops, 4);
+  memcpy(p + 4, &backlog, 4);
+  memcpy(p + 8, recs, n * sizeof(telem_wire));
+  c.outLen = (p - c.out) + len;
+  c.outOff = 0;
+}
+
+// Non-blocking write of what is left of the current message
+bool LiveServer::flush(Client& c) {
+  while (c.outOff < c.outLen) {
+    ssize_t r = send(c.sock.fd(), c.out + c.outOff, c.outLen - c.outOff, MSG_DONTWAIT);
+    if (r < 0) return errno == EAGAIN || errno == EWOULDBLOCK; // 慢客户端: 下次再写
+    c.outOff += r;
+  }
+  return true;
+}
+
+void LiveServer::close(Client& c) {
+  if (c.open) {
+    Serial.printf("[Live] Client closed, %u records lost\n", (unsigned)c.cur.drops);
+  }
+  c.sock.stop();
+  c.used = false;
+  c.open = false;
+  c.req = "";
+}
+
+void LiveServer::poll() {
+  accept();
+  for (int i = 0; i < MAX_CLIENTS; i++) {
+    Client& c = cl_[i];
+    if (!c.used) continue;
+    if (!c.sock.connected()) { close(c); continue; }
+
+    if (!c.open) {
+      if (!handshake(c) && c.used && millis() - c.since > HANDSHAKE_MS) close(c);
+      continue;
+    }
+    if (!readFrames(c)) { close(c); continue; }
+
+    // Bounded work per client and loop(): at most one message
+    if (c.outOff >= c.outLen) fill(c);
+    if (!flush(c)) close(c);
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <feed_ring.h>
+#include <telem_wire.h>
+
+/************** 实时遥测 (WebSocket) **************/
+// Telemetry records from the patch's stream notifications land in
+// g_telem (written by the NimBLE callback only) and are pushed to every
+// browser on ws://<ap>:81/ as binary messages:
+//
+//   u32 records this client lost so far, u32 records still queued for it,
+//   then n struct telem_wire (30 bytes each, little-endian)
+//
+// poll() runs from loop(). Sockets are written without blocking: a client
+// whose TCP window is full keeps its half-sent message and falls behind in
+// the ring, where it loses the oldest records instead of holding up the
+// BLE side or the other clients.
+
+typedef FeedRing<telem_wire, 256> TelemRing;    // ~5 s at 50 records/s
+
+class LiveServer {
+ public:
+  static const uint16_t PORT = 81;
+  static const int MAX_CLIENTS = 4;
+  static const size_t RECS_PER_MSG = 16;
+
+  explicit LiveServer(TelemRing& ring) : ring_(ring), server_(PORT) {}
+
+  void begin();
+  void poll();
+  int clients() const;
+
+ private:
+  static const size_t HDR_MAX = 4;            // 0x82, 126, u16 length
+  static const size_t MSG_MAX = 8 + RECS_PER_MSG * sizeof(telem_wire);
+  static const uint32_t HANDSHAKE_MS = 2000;
+
+  struct Client {
+    WiFiClient sock;
+    bool used = false;
+    bool open = false;      // handshake done
+    uint32_t since = 0;
+    String req;
+    FeedCursor cur;
+    uint8_t out[HDR_MAX + MSG_MAX];
+    size_t outLen = 0;
+    size_t outOff = 0;
+  };
+
+  void accept();
+  bool handshake(Client& c);
+  bool readFrames(Client& c);
+  void fill(Client& c);
+  bool flush(Client& c);
+  void close(Client& c);
+
+  TelemRing& ring_;
+  WiFiServer server_;
+  Client cl_[MAX_CLIENTS];
+};
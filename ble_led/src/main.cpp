@@ -1,8 +1,16 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <WebServer.h>
+#include <uri/UriBraces.h>
 #include <Preferences.h>
+#include <LittleFS.h>
 #include <NimBLEDevice.h>
+#include <esp_timer.h>
+#include <link_pool.h>
+#include <json_out.h>
+#include <session_log.h>
+#include <journal_sync.h>
+#include "live_ws.h"
 
 /************** Wi-Fi AP **************/
 static const char* AP_SSID = "ESP32_Config";
@@ -14,221 +22,469 @@ static const char* NS = "cfg";
 static const char* KEY_BLE_NAME = "bleName";
 static const char* KEY_SVC_UUID  = "svcUUID";
 static const char* KEY_CHR_UUID  = "chrUUID";
+static const char* KEY_DEVICES   = "devices";   // SavedDevices blob
 
 /************** 缺省配置 **************/
 String g_targetName   = "nRF5340DK"; // 目标外设广播名
 String g_serviceUUID  = "0000ffff-0000-1000-8000-00805f9b34fb";
 String g_charUUID     = "0000ff01-0000-1000-8000-00805f9b34fb"; // 不确定可先保留，后用 /discover 查
+// Framed command protocol (shared/cmd_proto.h), used when the peer has it
+static const char* PROTO_UUID = "0000ff06-0000-1000-8000-00805f9b34fb";
+// Telemetry stream: notifications of 1..n struct telem_wire
+static const char* STREAM_UUID = "0000ff03-0000-1000-8000-00805f9b34fb";
+// Posture state and events: notifications of struct ble_posture_wire
+static const char* POSTURE_UUID = "0000ff02-0000-1000-8000-00805f9b34fb";
+// Event journal: struct jrnl_req written, sync chunks notified
+static const char* JOURNAL_UUID = "0000ff07-0000-1000-8000-00805f9b34fb";
 
 /************** Web Server **************/
 WebServer server(80);
 
 /************** BLE 全局 **************/
-NimBLEClient* g_client = nullptr;
-NimBLERemoteCharacteristic* g_remoteChr = nullptr;
-bool g_isConnecting = false;
-unsigned long g_lastScanAttemptMs = 0;
-const unsigned long RECONNECT_INTERVAL_MS = 5000;
+// Everything below is owned by the BLE task (core 0), except the config
+// strings above, which the HTTP handlers change under g_cfgLock. loop()
+// (core 1) only talks to the task through g_pool's lock-free queues.
+// Devices are slots of g_pool; each has its own client.
+static const int MAX_DEVICES = CONFIG_BT_NIMBLE_MAX_CONNECTIONS < LinkPool::MAX_SLOTS
+                                   ? CONFIG_BT_NIMBLE_MAX_CONNECTIONS : LinkPool::MAX_SLOTS;
+struct Peer {
+  NimBLEClient* client = nullptr;
+  NimBLERemoteCharacteristic* cmd = nullptr;
+  NimBLERemoteCharacteristic* proto = nullptr;
+  NimBLERemoteCharacteristic* stream = nullptr;
+  NimBLERemoteCharacteristic* posture = nullptr;
+  NimBLERemoteCharacteristic* journal = nullptr;
+};
+Peer g_peer[MAX_DEVICES];
+TelemRing g_telem;                       // written by the stream callback only
+volatile uint32_t g_telemBad = 0;        // records failing the CRC
+volatile int g_liveSlot = 0;             // device shown in the live plot
+LiveServer g_live(g_telem);
+SemaphoreHandle_t g_cfgLock = nullptr;
+TaskHandle_t g_bleTask = nullptr;
+// Attribute table of each connected peer, read once per connection in
+// discover(); under g_cfgLock
+struct GattAttr {
+  char uuid[37];
+  uint8_t props;            // GATT_P_*, 0 for a service
+  bool svc;
+};
+enum { GATT_P_R = 1, GATT_P_W = 2, GATT_P_WN = 4, GATT_P_N = 8, GATT_P_I = 16 };
+static const int GATT_MAX = 32;
+struct GattTable {
+  GattAttr attr[GATT_MAX];
+  int n;
+};
+GattTable g_gatt[MAX_DEVICES];
+static const BaseType_t BLE_TASK_CORE = 0; // loop() runs on core 1
+
+/************** 会话日志 **************/
+// Posture notifications of every patch, and the telemetry of the one
+// streaming, appended to LittleFS (lib/session_log) for later download.
+// loop() owns g_log; the NimBLE callback only queues.
+SessionLog g_log("/littlefs/log");
+bool g_logOk = false;
+uint64_t g_logCap = 0;
+struct PostureNote {
+  uint8_t dev;
+  int64_t up_ms;            // arrival, ms since boot
+  ble_posture_wire p;
+};
+SpscQueue<PostureNote, 32> g_postures;
+// Journal sync chunks of every patch, for the JournalSync of its slot
+struct JournalNote {
+  uint8_t dev;
+  uint8_t len;
+  uint8_t data[244];        // ATT MTU 247 - 3
+};
+SpscQueue<JournalNote, 24> g_journalNotes;
+volatile uint32_t g_journalDrops = 0;   // queue full; the sync asks again
+// Each slot's patch journal is pulled after every connect (JournalSync,
+// lib/session_log) and its records go into the session log, carrying the
+// time the patch saw them. loop() only.
+struct JournalPeer {
+  JournalSync sync;
+  char addr[18];            // the patch the resume point belongs to
+  bool wasReady;
+};
+JournalPeer g_jpeer[MAX_DEVICES];
+// No NTP in AP mode: the page sends the browser's clock (POST /clock), and
+// until then the log goes on from its last record. loop() only.
+int64_t g_clockOffset = 0;
+bool g_clockSet = false;                // by the browser, since boot
+
+static int64_t upMs() { return esp_timer_get_time() / 1000; }
+static uint64_t epochMs(int64_t up) { return (uint64_t)(up + g_clockOffset); }
 
 /************** 页面 **************/
-const char* HTML_PAGE = R"HTML(
-<!doctype html><html><head>
-<meta charset="utf-8"/><meta name="viewport" content="width=device-width,initial-scale=1"/>
-<title>ESP32 BLE Config</title>
-<style>
-body{font-family:system-ui,-apple-system,Segoe UI,Roboto,Arial,sans-serif;margin:24px;max-width:720px}
-h1{font-size:20px}label{display:block;margin:12px 0 6px}
-input{width:100%;padding:10px;font-size:16px;box-sizing:border-box}
-button{padding:10px 14px;font-size:16px;margin:6px 6px 6px 0;cursor:pointer}
-.card{padding:16px;border:1px solid #ddd;border-radius:12px;margin-bottom:16px}
-.row{display:flex;gap:8px;flex-wrap:wrap}.ok{color:#0a0}.bad{color:#a00}
-code{background:#f5f5f5;padding:2px 6px;border-radius:6px}
-</style></head><body>
-<h1>ESP32 Web Config → BLE Control</h1>
-<div class="card">
-  <form method="POST" action="/save">
-    <label>Target BLE Name (nRF5340DK advertising name)</label>
-    <input name="bleName" value="%BLE_NAME%" required/>
-    <label>Service UUID</label>
-    <input name="svcUUID" value="%SVC_UUID%" required/>
-    <label>Characteristic UUID (writable)</label>
-    <input name="chrUUID" value="%CHR_UUID%" required/>
-    <button type="submit">Save & Try Connect</button>
-  </form>
-</div>
-<div class="card">
-  <h3>Status</h3>
-  <div id="status">Loading...</div>
-  <div class="row">
-    <button onclick="send('/led?state=on')">LED ON</button>
-    <button onclick="send('/led?state=off')">LED OFF</button>
-    <button onclick="send('/led?state=toggle')">TOGGLE</button>
-    <button onclick="refresh()">Refresh</button>
-    <button onclick="discover()">Discover</button>
-  </div>
-  <small>ESP32 writes: '1' / '0' / 'T'.</small>
-</div>
-<script>
-function refresh(){
-  fetch('/status').then(r=>r.json()).then(j=>{
-    const ok=j.connected?'ok':'bad';
-    document.getElementById('status').innerHTML=
-      `<div>BLE Connected: <b class="${ok}">${j.connected}</b></div>
-       <div>Target: <code>${j.bleName}</code></div>
-       <div>Service: <code>${j.svcUUID}</code></div>
-       <div>Char: <code>${j.chrUUID}</code></div>
-       <div>Message: ${j.msg||''}</div>`;
-  }).catch(_=>{document.getElementById('status').innerText='Failed to fetch status';});
-}
-function send(url){
-  fetch(url,{method:'POST'}).then(r=>r.json()).then(j=>{
-    alert(j.msg||JSON.stringify(j)); refresh();
-  }).catch(_=>alert('Request failed'));
-}
-function discover(){
-  fetch('/discover').then(r=>r.json()).then(j=>{
-    alert((j.list&&j.list.length?j.list.join('\n'):'No services/chars found.'));
-  }).catch(_=>alert('Discover failed'));
-}
-refresh();
-</script>
-</body></html>
-)HTML";
+// web/index.html, gzipped into flash by scripts/embed_web.py
+#include "index_html_gz.h"
 
 /************** 小工具 **************/
-String renderIndex() {
-  String page = HTML_PAGE;
-  page.replace("%BLE_NAME%", g_targetName);
-  page.replace("%SVC_UUID%", g_serviceUUID);
-  page.replace("%CHR_UUID%", g_charUUID);
-  return page;
+// JSON responses are written through one fixed buffer in chunks
+// (Transfer-Encoding: chunked), so no handler builds a String. loop() only.
+static char g_jsonBuf[256];
+
+static void sendChunk(void*, const char* p, size_t n) { server.sendContent(p, n); }
+
+static JsonOut beginJson(int code) {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(code, "application/json", "");
+  return JsonOut(g_jsonBuf, sizeof(g_jsonBuf), sendChunk, nullptr);
 }
 
-/************** 扫描 + 连接（注意 1.4.3 的返回类型） **************/
-bool connectToTarget() {
-  if (g_isConnecting) return false;
-  g_isConnecting = true;
+static void endJson(JsonOut& j) {
+  j.finish();
+  server.sendContent("", 0); // last chunk
+}
 
-  if (g_client && g_client->isConnected()) { g_isConnecting = false; return true; }
-  if (!g_client) {
-    g_client = NimBLEDevice::createClient();
-    g_client->setConnectTimeout(10);
+static void sendResult(int code, bool ok, const char* msg) {
+  JsonOut j = beginJson(code);
+  j.obj().kv("ok", ok).kv("msg", msg);
+  endJson(j);
+}
+
+// Target config, copied out under the lock so that no socket write ever
+// happens with g_cfgLock held (the BLE task takes it). /save keeps the
+// values within these sizes.
+struct TargetCfg {
+  char name[32];
+  char svc[37];
+  char chr[37];
+};
+
+static void readTarget(TargetCfg& t) {
+  xSemaphoreTake(g_cfgLock, portMAX_DELAY);
+  strlcpy(t.name, g_targetName.c_str(), sizeof(t.name));
+  strlcpy(t.svc, g_serviceUUID.c_str(), sizeof(t.svc));
+  strlcpy(t.chr, g_charUUID.c_str(), sizeof(t.chr));
+  xSemaphoreGive(g_cfgLock);
+}
+
+/************** NimBLE radio shared by the device slots **************/
+// Runs on the BLE task; the scan and client callbacks run on the NimBLE host
+// task and only post events into g_pool.
+class NimbleRadio : public PoolRadio,
+                    public NimBLEAdvertisedDeviceCallbacks,
+                    public NimBLEClientCallbacks {
+ public:
+  bool startScan(uint32_t ms) override;
+  void stopScan() override { NimBLEDevice::getScan()->stop(); }
+  bool connect(int slot, const char* addr, uint8_t addrType, uint16_t itvl) override;
+  bool retune(int slot, uint16_t itvl) override;
+  bool discover(int slot) override;
+  void disconnect(int slot) override {
+    NimBLEClient* c = g_peer[slot].client;
+    if (c && c->isConnected()) c->disconnect();
+  }
+  bool write(int slot, uint8_t value) override;
+  bool stream(int slot, bool on) override;
+  bool framed(int slot) override { return g_peer[slot].proto != nullptr; }
+  size_t payload(int slot) override {
+    NimBLEClient* c = g_peer[slot].client;
+    uint16_t mtu = c ? c->getMTU() : 0;
+    return mtu > 23 ? mtu - 3 : 20;
+  }
+  bool writeFrame(int slot, const uint8_t* buf, size_t len) override {
+    return g_peer[slot].proto && g_peer[slot].proto->writeValue(buf, len, false);
+  }
+  bool journal(int slot, const uint8_t* buf, size_t len) override {
+    return g_peer[slot].journal && g_peer[slot].journal->writeValue(buf, len, false);
   }
 
-  NimBLEScan* scan = NimBLEDevice::getScan();
-  scan->stop();
-  scan->clearResults();
-  scan->setActiveScan(true);
-  scan->setInterval(45);
-  scan->setWindow(30);
-  scan->setDuplicateFilter(true);
+  void onResult(NimBLEAdvertisedDevice* d) override;
+  void onDisconnect(NimBLEClient* c) override;
 
-  Serial.printf("[BLE] Scanning for: name='%s' or service=%s\n",
-                g_targetName.c_str(), g_serviceUUID.c_str());
+ private:
+  // Snapshot of the config for the current scan/connection
+  String name_;
+  String svc_;
+  String chr_;
+};
 
-  // v1.4.3: start() 返回 NimBLEScanResults（不是 bool）
-  NimBLEScanResults results = scan->start(7 /*seconds*/, false /*is_continue*/);
-  Serial.printf("[DBG] 扫描完成, 发现 %d 个设备.\n", results.getCount());
+static NimbleRadio g_radio;
+LinkPool g_pool(g_radio, MAX_DEVICES);
 
-  NimBLEUUID svcUUID(g_serviceUUID.c_str());
-  bool found = false;
-  NimBLEAddress candidateAddr;
+static int slotOf(NimBLEClient* c) {
+  for (int i = 0; i < MAX_DEVICES; i++) {
+    if (g_peer[i].client == c) return i;
+  }
+  return -1;
+}
 
-  for (int i = 0; i < results.getCount(); ++i) {
-    // v1.4.3: getDevice(i) 返回对象（不是指针），所以用 '.'
-    NimBLEAdvertisedDevice d = results.getDevice(i);
-    std::string nm = d.getName();
+static int slotOf(NimBLERemoteCharacteristic* chr) {
+  return slotOf(chr->getRemoteService()->getClient());
+}
 
-    Serial.printf("[DBG] Dev: %s RSSI=%d Name='%s'\n",
-                  d.getAddress().toString().c_str(), d.getRSSI(), nm.c_str());
+static void onScanEnded(NimBLEScanResults) { g_pool.onScanDone(); xTaskNotifyGive(g_bleTask); }
 
-    bool nameHit = (!nm.empty() && String(nm.c_str()).equalsIgnoreCase(g_targetName));
-    bool svcHit  = d.isAdvertisingService(svcUUID);
+// NimBLE host task: the only writer of g_telem; never waits
+static void onStreamNotify(NimBLERemoteCharacteristic* chr, uint8_t* data, size_t len, bool) {
+  // Left over from the previously watched patch
+  if (slotOf(chr) != g_liveSlot) return;
 
-    if (nameHit || svcHit) {
-      candidateAddr = d.getAddress();
-      Serial.printf("[BLE] Candidate: %s (name='%s' svcHit=%c)\n",
-                    candidateAddr.toString().c_str(), nm.c_str(), svcHit?'Y':'N');
-      found = true;
-      break;
+  telem_wire w;
+  for (size_t off = 0; off + sizeof(w) <= len; off += sizeof(w)) {
+    memcpy(&w, data + off, sizeof(w));
+    if (telem_wire_valid(&w)) {
+      g_telem.push(w);
+    } else {
+      g_telemBad = g_telemBad + 1;
     }
   }
+}
+
+// NimBLE host task: queued with its arrival time, logged by loop()
+static void onPostureNotify(NimBLERemoteCharacteristic* chr, uint8_t* data, size_t len, bool) {
+  int slot = slotOf(chr);
+  if (slot < 0 || len < sizeof(ble_posture_wire)) return;
+  PostureNote n;
+  n.dev = (uint8_t)slot;
+  n.up_ms = upMs();
+  memcpy(&n.p, data, sizeof(n.p));
+  g_postures.push(n);
+}
 
+// NimBLE host task: a whole transfer is a burst of these, queued for loop()
+static void onJournalNotify(NimBLERemoteCharacteristic* chr, uint8_t* data, size_t len, bool) {
+  int slot = slotOf(chr);
+  JournalNote n;
+  if (slot < 0) return;
+  // Longer than the patch's MTU allows: lost like a dropped one
+  bool ok = len <= sizeof(n.data);
+  if (ok) {
+    n.dev = (uint8_t)slot;
+    n.len = (uint8_t)len;
+    memcpy(n.data, data, len);
+    ok = g_journalNotes.push(n);
+  }
+  if (!ok) g_journalDrops = g_journalDrops + 1;
+}
+
+static void onProtoNotify(NimBLERemoteCharacteristic* chr, uint8_t* data, size_t len, bool) {
+  int slot = slotOf(chr);
+  if (slot < 0) return;
+  g_pool.link(slot).onFrame(data, len);
+  xTaskNotifyGive(g_bleTask);
+}
+
+bool NimbleRadio::startScan(uint32_t ms) {
+  xSemaphoreTake(g_cfgLock, portMAX_DELAY);
+  name_ = g_targetName;
+  svc_ = g_serviceUUID;
+  chr_ = g_charUUID;
+  xSemaphoreGive(g_cfgLock);
+
+  NimBLEScan* scan = NimBLEDevice::getScan();
+  scan->setAdvertisedDeviceCallbacks(this, false);
+  scan->setActiveScan(true);
+  scan->setInterval(45);
+  scan->setWindow(30);
+  scan->setDuplicateFilter(true);
   scan->clearResults();
+  Serial.printf("[BLE] Scanning for: name='%s' or service=%s\n", name_.c_str(), svc_.c_str());
+  // Non-blocking: results arrive in onResult(), the end in onScanEnded()
+  return scan->start((ms + 999) / 1000, onScanEnded, false);
+}
 
-  if (!found) {
-    Serial.println("[BLE] Target not found.");
-    g_isConnecting = false;
-    return false;
+// Every matching advertiser, not only the first: the pool routes it to its
+// slot or admits it
+void NimbleRadio::onResult(NimBLEAdvertisedDevice* d) {
+  std::string nm = d->getName();
+  bool nameHit = (!nm.empty() && String(nm.c_str()).equalsIgnoreCase(name_));
+  bool svcHit  = d->isAdvertisingService(NimBLEUUID(svc_.c_str()));
+
+  if (nameHit || svcHit) {
+    g_pool.onAdvert(d->getAddress().toString().c_str(), d->getAddress().getType());
+    xTaskNotifyGive(g_bleTask);
   }
+}
+
+void NimbleRadio::onDisconnect(NimBLEClient* c) {
+  int slot = slotOf(c);
+  if (slot < 0) return;
+  Peer& p = g_peer[slot];
+  p.cmd = p.proto = p.stream = p.posture = p.journal = nullptr;
+  g_pool.link(slot).onDisconnected();
+  xTaskNotifyGive(g_bleTask);
+}
 
-  Serial.printf("[BLE] Connecting to %s ...\n", candidateAddr.toString().c_str());
-  if (!g_client->connect(candidateAddr)) {
-    Serial.println("[BLE] Connect() failed.");
-    g_isConnecting = false; return false;
+// Connection parameters in 1.25 ms units; 4 s supervision timeout covers
+// the longest interval the pool asks for
+static const uint16_t CONN_TIMEOUT = 400;
+
+bool NimbleRadio::connect(int slot, const char* addr, uint8_t addrType, uint16_t itvl) {
+  Peer& p = g_peer[slot];
+  if (!p.client) {
+    p.client = NimBLEDevice::createClient();
+    p.client->setClientCallbacks(this, false);
+    // Blocks the BLE task, and with it every other patch's traffic
+    p.client->setConnectTimeout(5);
+  }
+  p.client->setConnectionParams(itvl, itvl, 0, CONN_TIMEOUT);
+  Serial.printf("[BLE] #%d connecting to %s (interval %u x 1.25 ms) ...\n", slot, addr, itvl);
+  // Blocks the BLE task only; the web server keeps running on the other core
+  if (!p.client->connect(NimBLEAddress(std::string(addr), addrType))) {
+    Serial.printf("[BLE] #%d connect() failed.\n", slot);
+    return false;
   }
-  Serial.println("[BLE] Connected.");
+  Serial.printf("[BLE] #%d connected.\n", slot);
+  return true;
+}
 
-  // 找服务
-  NimBLERemoteService* svc = g_client->getService(g_serviceUUID.c_str());
+bool NimbleRadio::retune(int slot, uint16_t itvl) {
+  NimBLEClient* c = g_peer[slot].client;
+  if (!c || !c->isConnected()) return false;
+  c->updateConnParams(itvl, itvl, 0, CONN_TIMEOUT);
+  return true;
+}
+
+bool NimbleRadio::discover(int slot) {
+  Peer& p = g_peer[slot];
+  NimBLERemoteService* svc = p.client->getService(svc_.c_str());
   if (!svc) {
-    Serial.println("[BLE] Service NOT found on peer.");
-    g_client->disconnect(); g_isConnecting = false; return false;
+    Serial.printf("[BLE] #%d service NOT found on peer.\n", slot);
+    return false;
   }
 
-  // 优先用配置的特征；找不到则自动挑一个“可写”的
-  g_remoteChr = svc->getCharacteristic(g_charUUID.c_str());
-  if (!g_remoteChr) {
+  // Prefer the configured characteristic, otherwise any writable one
+  p.cmd = svc->getCharacteristic(chr_.c_str());
+  if (!p.cmd) {
     Serial.println("[BLE] Configured characteristic not found, try picking a writable one...");
     std::vector<NimBLERemoteCharacteristic*>* chs = svc->getCharacteristics(true);
     if (chs) {
       for (auto* c : *chs) {
-        if (c->canWrite() || c->canWriteNoResponse()) { g_remoteChr = c; break; }
+        if (c->canWrite() || c->canWriteNoResponse()) { p.cmd = c; break; }
       }
     }
   }
+  if (!p.cmd || (!p.cmd->canWrite() && !p.cmd->canWriteNoResponse())) {
+    Serial.printf("[BLE] #%d no writable characteristic under the service.\n", slot);
+    p.cmd = nullptr;
+    return false;
+  }
 
-  if (!g_remoteChr) {
-    Serial.println("[BLE] No writable characteristic under the service.");
-    g_client->disconnect(); g_isConnecting = false; return false;
+  // ACK notifications go straight into the link's event queue
+  p.proto = svc->getCharacteristic(PROTO_UUID);
+  if (p.proto && !(p.proto->canWriteNoResponse() && p.proto->canNotify() &&
+                   p.proto->subscribe(true, onProtoNotify))) {
+    p.proto = nullptr;
   }
+  Serial.printf("[BLE] #%d commands: %s\n", slot, p.proto ? "framed protocol" : "legacy bytes (LED only)");
 
-  if (!g_remoteChr->canWrite() && !g_remoteChr->canWriteNoResponse()) {
-    Serial.println("[BLE] Selected characteristic is not writable.");
-    g_client->disconnect(); g_isConnecting = false; return false;
+  // Always subscribed: every posture change goes into the session log
+  p.posture = svc->getCharacteristic(POSTURE_UUID);
+  if (p.posture && !(p.posture->canNotify() && p.posture->subscribe(true, onPostureNotify))) {
+    p.posture = nullptr;
   }
 
-  Serial.printf("[BLE] Using characteristic %s (props: %s%s)\n",
-                g_remoteChr->getUUID().toString().c_str(),
-                g_remoteChr->canWrite() ? "W" : "",
-                g_remoteChr->canWriteNoResponse() ? "/WN" : "");
-  g_isConnecting = false;
+  // Always subscribed: loop() pulls the patch's journal after every connect
+  p.journal = svc->getCharacteristic(JOURNAL_UUID);
+  if (p.journal && !(p.journal->canWriteNoResponse() && p.journal->canNotify() &&
+                     p.journal->subscribe(true, onJournalNotify))) {
+    p.journal = nullptr;
+  }
+
+  // Subscribed only while a browser shows this patch live (stream())
+  p.stream = svc->getCharacteristic(STREAM_UUID);
+  if (p.stream && !p.stream->canNotify()) p.stream = nullptr;
+
+  // Cache the attribute table for /discover, so HTTP never touches the
+  // client; this is the only GATT discovery per connection
+  static GattAttr table[GATT_MAX];   // BLE task only
+  int n = 0;
+  auto* svcs = p.client->getServices(false);
+  if (svcs) {
+    for (auto* s : *svcs) {
+      if (n == GATT_MAX) break;
+      GattAttr& a = table[n++];
+      strlcpy(a.uuid, s->getUUID().toString().c_str(), sizeof(a.uuid));
+      a.props = 0;
+      a.svc = true;
+      auto* chs = s->getCharacteristics(true);
+      if (!chs) continue;
+      for (auto* c : *chs) {
+        if (n == GATT_MAX) break;
+        GattAttr& e = table[n++];
+        strlcpy(e.uuid, c->getUUID().toString().c_str(), sizeof(e.uuid));
+        e.props = (c->canRead() ? GATT_P_R : 0) | (c->canWrite() ? GATT_P_W : 0) |
+                  (c->canWriteNoResponse() ? GATT_P_WN : 0) | (c->canNotify() ? GATT_P_N : 0) |
+                  (c->canIndicate() ? GATT_P_I : 0);
+        e.svc = false;
+      }
+    }
+  }
+  xSemaphoreTake(g_cfgLock, portMAX_DELAY);
+  memcpy(g_gatt[slot].attr, table, n * sizeof(GattAttr));
+  g_gatt[slot].n = n;
+  xSemaphoreGive(g_cfgLock);
   return true;
 }
 
-void ensureConnectedLoop() {
-  if (g_client && g_client->isConnected()) return;
-  unsigned long now = millis();
-  if (now - g_lastScanAttemptMs < RECONNECT_INTERVAL_MS) return;
-  g_lastScanAttemptMs = now;
-  connectToTarget();
+bool NimbleRadio::stream(int slot, bool on) {
+  NimBLERemoteCharacteristic* chr = g_peer[slot].stream;
+  if (!chr) return false;
+  bool ok = on ? chr->subscribe(true, onStreamNotify) : chr->unsubscribe();
+  Serial.printf("[BLE] #%d telemetry stream %s -> %s\n", slot, on ? "on" : "off", ok ? "OK" : "FAIL");
+  return ok;
 }
 
 /************** 写入 '1'/'0'/'T' **************/
-bool writeCommand(char c) {
-  if (!g_client || !g_client->isConnected() || !g_remoteChr) {
-    Serial.println("[BLE] Not connected."); return false;
-  }
-  const bool noRsp = g_remoteChr->canWriteNoResponse();
-  const uint8_t b = static_cast<uint8_t>(c);
-  bool ok = g_remoteChr->writeValue(&b, 1, !noRsp /*withResponse?*/);
-  Serial.printf("[BLE] Write '%c' -> %s\n", c, ok ? "OK" : "FAIL");
+bool NimbleRadio::write(int slot, uint8_t value) {
+  NimBLERemoteCharacteristic* chr = g_peer[slot].cmd;
+  if (!chr) return false;
+  const bool noRsp = chr->canWriteNoResponse();
+  bool ok = chr->writeValue(&value, 1, !noRsp /*withResponse?*/);
+  Serial.printf("[BLE] #%d write '%c' -> %s\n", slot, value, ok ? "OK" : "FAIL");
   return ok;
 }
 
+/************** BLE 任务 **************/
+// Wakes on every queued command/event, and at least every 50 ms for the
+// backoff and scan timers
+void bleTask(void*) {
+  g_pool.start(millis());
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
+    g_pool.step(millis());
+  }
+}
+
+// From loop() only (single producer); never waits. slot < 0: every device
+bool postCommand(int slot, LinkCommand::Kind kind, uint8_t type = 0, const void* val = nullptr,
+                 uint8_t len = 0) {
+  LinkCommand c = {kind, type, len, {0}};
+  if (len > sizeof(c.val)) return false;
+  if (len) memcpy(c.val, val, len);
+  if (!(slot < 0 ? g_pool.broadcast(c) : g_pool.command(slot, c))) return false;
+  xTaskNotifyGive(g_bleTask);
+  return true;
+}
+
+bool postLed(int slot, char c) {
+  uint8_t mode = (c == '1') ? CMDP_LED_ON : (c == 'T') ? CMDP_LED_TOGGLE : CMDP_LED_RELEASE;
+  return postCommand(slot, LinkCommand::Send, CMDP_T_LED, &mode, 1);
+}
+
 /************** Web 处理 **************/
+// Static page straight from flash; the browser revalidates with the ETag
 void handleRoot() {
-  server.send(200, "text/html; charset=utf-8", renderIndex());
+  server.sendHeader("ETag", INDEX_HTML_ETAG);
+  server.sendHeader("Cache-Control", "no-cache");
+  if (server.header("If-None-Match") == INDEX_HTML_ETAG) {
+    server.send(304);
+    return;
+  }
+  server.sendHeader("Content-Encoding", "gzip");
+  server.send_P(200, "text/html; charset=utf-8", (PGM_P)INDEX_HTML_GZ, INDEX_HTML_GZ_LEN);
+}
+
+void handleConfig() {
+  TargetCfg t;
+  readTarget(t);
+  JsonOut j = beginJson(200);
+  j.obj().kv("bleName", t.name).kv("svcUUID", t.svc).kv("chrUUID", t.chr);
+  endJson(j);
 }
 
 void handleSave() {
@@ -241,10 +497,16 @@ void handleSave() {
   if (bleName.isEmpty() || svcUUID.isEmpty() || chrUUID.isEmpty()) {
     server.send(400, "text/plain", "Missing parameters"); return;
   }
+  if (bleName.length() >= sizeof(TargetCfg::name) || svcUUID.length() >= sizeof(TargetCfg::svc) ||
+      chrUUID.length() >= sizeof(TargetCfg::chr)) {
+    server.send(400, "text/plain", "Parameter too long"); return;
+  }
 
+  xSemaphoreTake(g_cfgLock, portMAX_DELAY);
   g_targetName  = bleName;
   g_serviceUUID = svcUUID;
   g_charUUID    = chrUUID;
+  xSemaphoreGive(g_cfgLock);
 
   prefs.begin(NS, false);
   prefs.putString(KEY_BLE_NAME, g_targetName);
@@ -252,75 +514,343 @@ void handleSave() {
   prefs.putString(KEY_CHR_UUID,  g_charUUID);
   prefs.end();
 
-  if (g_client && g_client->isConnected()) g_client->disconnect();
-  g_lastScanAttemptMs = 0;
+  // The BLE task drops every link and scans for the new target
+  postCommand(-1, LinkCommand::Reconnect);
 
   server.sendHeader("Location", "/");
   server.send(302, "text/plain", "Saved.");
 }
 
+// The slot in /dev/{n}/..., or -1 after answering 404
+static int devArg() {
+  String a = server.pathArg(0);
+  int slot = a.toInt();
+  if (a.isEmpty() || a.length() > 2 || !isDigit(a[0]) || slot >= g_pool.slots() || !g_pool.used(slot)) {
+    sendResult(404, false, "No such device");
+    return -1;
+  }
+  return slot;
+}
+
+static void deviceJson(JsonOut& j, int slot) {
+  DeviceCfg d;
+  g_pool.device(slot, d);
+  BleLink& l = g_pool.link(slot);
+  LinkStats st = l.stats();
+  JournalStats js = g_jpeer[slot].sync.stats();
+  j.obj()
+   .kv("dev", slot).kv("addr", d.addr).kv("label", d.label)
+   .kv("state", linkStateName(l.state()))
+   .kv("itvl", (unsigned)g_pool.interval(slot))
+   .kv("scans", st.scans).kv("failures", st.failures).kv("disconnects", st.disconnects)
+   .kv("writeFails", st.writeFails).kv("cmdDrops", st.cmdDrops)
+   .kv("frames", st.frames).kv("inflight", st.inflight)
+   .kv("resends", st.resends).kv("naks", st.naks).kv("lastNakErr", st.lastNakErr)
+   .kv("journalEntries", js.entries).kv("journalRecords", js.records)
+   .kv("journalResumes", js.resumes).kv("journalGaps", js.gaps)
+   .end();
+}
+
 void handleStatus() {
-  bool connected = (g_client && g_client->isConnected() && g_remoteChr);
-  String msg = connected ? "BLE is connected, ready to write."
-                         : "Not connected. ESP32 is trying to reconnect.";
-  String json = String("{\"connected\":") + (connected ? "true":"false") +
-                ",\"bleName\":\"" + g_targetName + "\"" +
-                ",\"svcUUID\":\"" + g_serviceUUID + "\"" +
-                ",\"chrUUID\":\"" + g_charUUID + "\"" +
-                ",\"msg\":\"" + msg + "\"}";
-  server.send(200, "application/json", json);
-}
-
-void handleLED() {
-  if (server.method() != HTTP_POST) {
-    server.send(405, "application/json", "{\"msg\":\"Method Not Allowed\"}"); return;
+  int connected = g_pool.connected();
+  PoolStats ps = g_pool.stats();
+  TargetCfg t;
+  readTarget(t);
+
+  JsonOut j = beginJson(200);
+  j.obj()
+   .kv("connected", connected)
+   .kv("bleName", t.name).kv("svcUUID", t.svc).kv("chrUUID", t.chr)
+   .kv("adverts", ps.adverts).kv("admitted", ps.admitted).kv("full", ps.full)
+   .kv("telem", g_telem.head()).kv("telemBad", (uint32_t)g_telemBad)
+   .kv("liveClients", g_live.clients()).kv("liveDev", (int)g_liveSlot)
+   .kv("log", g_logOk).kv("logBytes", g_log.bytes())
+   .kv("journalDrops", (uint32_t)g_journalDrops)
+   .kv("msg", connected ? "Connected, ready to write."
+                        : "Not connected. ESP32 is scanning for patches.");
+  j.key("devices").arr();
+  for (int i = 0; i < g_pool.slots(); i++) {
+    if (g_pool.used(i)) deviceJson(j, i);
   }
+  endJson(j);
+}
+
+void handleDevice() {
+  int slot = devArg();
+  if (slot < 0) return;
+  JsonOut j = beginJson(200);
+  deviceJson(j, slot);
+  endJson(j);
+}
+
+// /led: every connected patch; /dev/{n}/led: that one
+static void led(int slot) {
   String state = server.arg("state");
   char cmd = 0;
   if (state == "on") cmd = '1';
   else if (state == "off") cmd = '0';
   else if (state == "toggle") cmd = 'T';
-  else { server.send(400, "application/json", "{\"msg\":\"Use state=on/off/toggle\"}"); return; }
+  else { sendResult(400, false, "Use state=on/off/toggle"); return; }
 
-  bool ok = writeCommand(cmd);
-  server.send(200, "application/json",
-              String("{\"ok\":") + (ok?"true":"false") +
-              ",\"msg\":\"" + (ok?"Write succeeded.":"Write failed (not connected?).") + "\"}");
+  // Queued for the BLE task; the result shows up in /status writeFails
+  bool ready = slot < 0 ? g_pool.connected() > 0 : g_pool.link(slot).ready();
+  bool ok = ready && postLed(slot, cmd);
+  sendResult(200, ok, ok ? "Write queued." : "Not connected.");
+}
+
+void handleLED() { led(-1); }
+
+void handleDevLED() {
+  int slot = devArg();
+  if (slot >= 0) led(slot);
+}
+
+/* Parameter tuning through the framed protocol:
+ *   name=posture&enter=&exit=&enter_dwell=&exit_dwell=&alert=
+ *   name=setpoint&cdeg=   name=haptic&pattern=&repeat=   name=cue&pattern=
+ *   name=haptic_stop
+ * Queued like /led; rejections by the patch show up in its naks.
+ */
+static void cmd(int slot) {
+  String name = server.arg("name");
+  uint8_t val[CMDP_VAL_MAX];
+  uint8_t type, len;
+
+  if (name == "posture") {
+    cmdp_posture pp;
+    pp.enter_cdeg = server.arg("enter").toInt();
+    pp.exit_cdeg = server.arg("exit").toInt();
+    pp.enter_dwell_ms = server.arg("enter_dwell").toInt();
+    pp.exit_dwell_ms = server.arg("exit_dwell").toInt();
+    pp.alert_s = server.arg("alert").toInt();
+    cmdp_posture_encode(val, &pp);
+    type = CMDP_T_POSTURE; len = CMDP_POSTURE_LEN;
+  } else if (name == "setpoint") {
+    cmdp_put_u16(val, (uint16_t)server.arg("cdeg").toInt());
+    type = CMDP_T_SETPOINT; len = 2;
+  } else if (name == "haptic") {
+    val[0] = server.arg("pattern").toInt();
+    val[1] = server.arg("repeat").toInt() != 0;
+    type = CMDP_T_HAPTIC_PLAY; len = 2;
+  } else if (name == "cue") {
+    val[0] = server.arg("pattern").toInt();
+    type = CMDP_T_HAPTIC_CUE; len = 1;
+  } else if (name == "haptic_stop") {
+    type = CMDP_T_HAPTIC_STOP; len = 0;
+  } else {
+    sendResult(400, false, "Unknown command"); return;
+  }
+
+  bool ready = slot < 0 ? g_pool.connected() > 0 : g_pool.link(slot).ready();
+  bool ok = ready && postCommand(slot, LinkCommand::Send, type, val, len);
+  sendResult(200, ok, ok ? "Command queued." : "Not connected.");
+}
+
+void handleCmd() { cmd(-1); }
+
+void handleDevCmd() {
+  int slot = devArg();
+  if (slot >= 0) cmd(slot);
 }
 
 /* 列出服务/特征与属性，方便确认 UUID 与可写性 */
-void handleDiscover() {
-  String out = "{\"list\":[";
-  bool first = true;
-
-  if (g_client && g_client->isConnected()) {
-    auto *svcs = g_client->getServices(true);
-    if (svcs) {
-      for (auto *s : *svcs) {
-        if (!first) out += ",";
-        first = false;
-        out += "\"SVC ";
-        out += s->getUUID().toString().c_str();
-        out += "\"";
-        auto *chs = s->getCharacteristics(true);
-        if (chs) {
-          for (auto *c : *chs) {
-            out += ",\"  CHR ";
-            out += c->getUUID().toString().c_str();
-            out += " props:";
-            if (c->canRead()) out += "R";
-            if (c->canWrite()) out += "W";
-            if (c->canWriteNoResponse()) out += "WN";
-            if (c->canNotify()) out += "N";
-            if (c->canIndicate()) out += "I";
-            out += "\"";
-          }
-        }
-      }
+// Served from the table cached at the last discovery; one entry at a time
+// is copied out under the lock
+static void discoverJson(int slot) {
+  JsonOut j = beginJson(200);
+  j.obj().key("list").arr();
+  for (int i = 0; slot >= 0 && g_pool.link(slot).ready(); i++) {
+    GattAttr a;
+    xSemaphoreTake(g_cfgLock, portMAX_DELAY);
+    bool more = i < g_gatt[slot].n;
+    if (more) a = g_gatt[slot].attr[i];
+    xSemaphoreGive(g_cfgLock);
+    if (!more) break;
+
+    j.obj().kv("uuid", a.uuid);
+    if (!a.svc) {
+      char p[8], *q = p;
+      if (a.props & GATT_P_R) *q++ = 'R';
+      if (a.props & GATT_P_W) *q++ = 'W';
+      if (a.props & GATT_P_WN) { *q++ = 'W'; *q++ = 'N'; }
+      if (a.props & GATT_P_N) *q++ = 'N';
+      if (a.props & GATT_P_I) *q++ = 'I';
+      *q = 0;
+      j.kv("props", p);
+    }
+    j.end();
+  }
+  endJson(j);
+}
+
+// The patch shown live
+void handleDiscover() { discoverJson(g_liveSlot); }
+
+void handleDevDiscover() {
+  int slot = devArg();
+  if (slot >= 0) discoverJson(slot);
+}
+
+void handleDevLive() {
+  int slot = devArg();
+  if (slot < 0) return;
+  g_liveSlot = slot;
+  sendResult(200, true, "Live plot follows this patch.");
+}
+
+void handleDevLabel() {
+  int slot = devArg();
+  if (slot < 0) return;
+  String label = server.arg("label");
+  if (label.isEmpty() || label.length() >= sizeof(DeviceCfg::label)) {
+    sendResult(400, false, "Label must be 1-23 characters"); return;
+  }
+  g_pool.setLabel(slot, label.c_str());
+  sendResult(200, true, "Saved.");
+}
+
+// Drops the link and frees the slot; the patch is admitted again (maybe in
+// another slot) the next time it is seen
+void handleDevForget() {
+  int slot = devArg();
+  if (slot < 0) return;
+  bool ok = g_pool.forget(slot);
+  if (ok) xTaskNotifyGive(g_bleTask);
+  sendResult(200, ok, ok ? "Forgotten." : "Busy, try again.");
+}
+
+/************** 会话日志下载 **************/
+// Shared by the streaming handlers below; loop() only
+static char g_sendBuf[1024];
+
+static uint64_t argU64(const char* name, uint64_t def) {
+  return server.hasArg(name) ? strtoull(server.arg(name).c_str(), nullptr, 10) : def;
+}
+
+// The browser's clock, ms since the epoch
+void handleClock() {
+  uint64_t ms = argU64("ms", 0);
+  if (ms < 1500000000000ull) {
+    sendResult(400, false, "Missing ms");
+    return;
+  }
+  g_clockOffset = (int64_t)ms - upMs();
+  g_clockSet = true;
+  sendResult(200, true, "Clock set");
+}
+
+// GET /log?from=&to=&dev=  records with from <= t_ms < to (ms since the
+// epoch, default everything) as CSV, chunked. The reader holds one block;
+// the response goes out 1 KiB at a time.
+void handleLog() {
+  if (!g_logOk) {
+    sendResult(503, false, "No session log");
+    return;
+  }
+  g_log.flush();                    // the block still in RAM as well
+  LogReader rd(g_log);              // closes its file when done
+  rd.seek(argU64("from", 0), argU64("to", UINT64_MAX), server.hasArg("dev") ? server.arg("dev").toInt() : -1);
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.sendHeader("Content-Disposition", "attachment; filename=\"session.csv\"");
+  server.send(200, "text/csv", "");
+  server.sendContent(LOG_CSV_HEADER, strlen(LOG_CSV_HEADER));
+  LogRecord r;
+  size_t n = 0;
+  while (rd.next(r) && server.client().connected()) {
+    size_t m = logCsv(r, g_sendBuf + n, sizeof(g_sendBuf) - n);
+    if (!m) {
+      server.sendContent(g_sendBuf, n);
+      n = 0;
+      m = logCsv(r, g_sendBuf, sizeof(g_sendBuf));
+    }
+    n += m;
+  }
+  if (n) server.sendContent(g_sendBuf, n);
+  server.sendContent("", 0);
+}
+
+// Segments and their time spans, for /log/file/
+void handleLogIndex() {
+  LogStats st = g_log.stats();
+  JsonOut j = beginJson(200);
+  j.obj()
+   .kv("ok", g_logOk).kv("now", epochMs(upMs()))
+   .kv("bytes", g_log.bytes()).kv("cap", g_logCap)
+   .kv("records", st.records).kv("rawBytes", st.rawBytes).kv("diskBytes", st.diskBytes)
+   .kv("torn", st.torn).kv("dropped", st.dropped).kv("writeErrors", st.writeErrors);
+  j.key("segments").arr();
+  for (int i = 0; i < g_log.segments(); i++) {
+    const LogSegment& s = g_log.segment(i);
+    char name[16];
+    snprintf(name, sizeof(name), "%08x", (unsigned)s.seq);
+    j.obj()
+     .kv("seg", name).kv("blocks", s.blocks).kv("size", s.size)
+     .kv("t0", s.t0_ms).kv("t1", s.t1_ms)
+     .end();
+  }
+  endJson(j);
+}
+
+// GET /log/file/NNNNNNNN.seg|idx  one file as it is on flash, with
+// single-range requests (Range: bytes=a-b, a- or -n), so an interrupted
+// download resumes where it stopped
+void handleLogFile() {
+  unsigned seq;
+  char ext[4];
+  char path[64];
+  String name = server.pathArg(0);
+  if (name.length() != 12 || sscanf(name.c_str(), "%8x.%3s", &seq, ext) != 2 ||
+      (strcmp(ext, "seg") && strcmp(ext, "idx"))) {
+    sendResult(404, false, "No such file");
+    return;
+  }
+  g_log.flush();
+  g_log.path(path, sizeof(path), seq, ext);
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    sendResult(404, false, "No such file");
+    return;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  long from = 0, to = size - 1;
+  int code = 200;
+
+  String range = server.header("Range");
+  if (range.startsWith("bytes=")) {
+    const char* p = range.c_str() + 6;
+    char* e;
+    if (*p == '-') {
+      long n = strtol(p + 1, &e, 10);
+      from = n < size ? size - n : 0;
+    } else {
+      from = strtol(p, &e, 10);
+      if (*e == '-' && e[1]) to = strtol(e + 1, &e, 10);
+    }
+    if (to >= size) to = size - 1;
+    if (*e != '\0' || from > to) {
+      snprintf(g_sendBuf, sizeof(g_sendBuf), "bytes */%ld", size);
+      server.sendHeader("Content-Range", g_sendBuf);
+      server.send(416);
+      fclose(f);
+      return;
     }
+    snprintf(g_sendBuf, sizeof(g_sendBuf), "bytes %ld-%ld/%ld", from, to, size);
+    server.sendHeader("Content-Range", g_sendBuf);
+    code = 206;
+  }
+  server.sendHeader("Accept-Ranges", "bytes");
+  server.setContentLength(to - from + 1);
+  server.send(code, "application/octet-stream", "");
+  fseek(f, from, SEEK_SET);
+  for (long left = to - from + 1; left > 0 && server.client().connected();) {
+    size_t n = fread(g_sendBuf, 1, left < (long)sizeof(g_sendBuf) ? left : sizeof(g_sendBuf), f);
+    if (!n) break;
+    server.sendContent(g_sendBuf, n);
+    left -= n;
   }
-  out += "]}";
-  server.send(200, "application/json", out);
+  fclose(f);
 }
 
 /************** Wi-Fi + Web 初始化 **************/
@@ -335,11 +865,26 @@ void setupWiFiAP() {
 }
 
 void setupWeb() {
+  static const char* headers[] = {"If-None-Match", "Range"};
+  server.collectHeaders(headers, 2);
   server.on("/", HTTP_GET, handleRoot);
+  server.on("/config", HTTP_GET, handleConfig);
   server.on("/save", HTTP_POST, handleSave);
   server.on("/status", HTTP_GET, handleStatus);
   server.on("/led", HTTP_POST, handleLED);
+  server.on("/cmd", HTTP_POST, handleCmd);
   server.on("/discover", HTTP_GET, handleDiscover);
+  server.on(UriBraces("/dev/{}"), HTTP_GET, handleDevice);
+  server.on(UriBraces("/dev/{}/led"), HTTP_POST, handleDevLED);
+  server.on(UriBraces("/dev/{}/cmd"), HTTP_POST, handleDevCmd);
+  server.on(UriBraces("/dev/{}/discover"), HTTP_GET, handleDevDiscover);
+  server.on(UriBraces("/dev/{}/live"), HTTP_POST, handleDevLive);
+  server.on(UriBraces("/dev/{}/label"), HTTP_POST, handleDevLabel);
+  server.on(UriBraces("/dev/{}/forget"), HTTP_POST, handleDevForget);
+  server.on("/clock", HTTP_POST, handleClock);
+  server.on("/log", HTTP_GET, handleLog);
+  server.on("/log/index", HTTP_GET, handleLogIndex);
+  server.on(UriBraces("/log/file/{}"), HTTP_GET, handleLogFile);
   server.begin();
   Serial.println("[Web] HTTP server started.");
 }
@@ -357,6 +902,125 @@ void setupBLE() {
   #endif
   */
   NimBLEDevice::setSecurityAuth(false, false, true); // 无需配对
+
+  // Connection management runs beside the NimBLE host on core 0
+  xTaskCreatePinnedToCore(bleTask, "ble_link", 6144, nullptr, 2, &g_bleTask, BLE_TASK_CORE);
+}
+
+/************** 会话日志初始化 **************/
+// A quarter of the partition stays free for LittleFS's metadata and
+// copy-on-write blocks
+void setupLog() {
+  if (!LittleFS.begin(true)) {
+    Serial.println("[LOG] LittleFS mount failed, no session log.");
+    return;
+  }
+  g_logCap = LittleFS.totalBytes() / 4 * 3;
+  g_logOk = g_log.begin(g_logCap);
+  g_clockOffset = (int64_t)g_log.lastTime() + 1 - upMs();
+  LogStats st = g_log.stats();
+  Serial.printf("[LOG] %s: %d segments, %u of %u KiB%s\n", g_logOk ? "OK" : "FAIL", g_log.segments(),
+                (unsigned)(g_log.bytes() / 1024), (unsigned)(g_logCap / 1024),
+                st.torn ? ", torn append skipped" : "");
+}
+
+// Posture notes queued by the NimBLE task, the streaming patch's telemetry
+// from g_telem, and the block timer
+void pollLog() {
+  static FeedCursor cursor;
+  PostureNote n;
+  telem_wire w[16];
+  size_t k;
+  while (g_postures.pop(n)) {
+    if (g_logOk) g_log.posture(epochMs(n.up_ms), n.dev, n.p);
+  }
+  uint64_t now = epochMs(upMs());
+  while ((k = g_telem.collect(cursor, w, 16, 0)) > 0) {
+    for (size_t i = 0; g_logOk && i < k; i++) g_log.telem(now, (uint8_t)g_liveSlot, w[i]);
+  }
+  if (g_logOk) g_log.poll(now);
+}
+
+/************** 事件日志同步 **************/
+// Drives g_jpeer: chunks in, requests out through the slot's link
+static void onJournalRecord(void* ctx, const jrnl_rec& r, uint16_t boot, uint64_t at_ms) {
+  // The sync's own bookkeeping
+  if (r.type == JRNL_CLOCK || r.type == JRNL_SYNCED || !g_logOk) return;
+  LogEvent e = {r.type, (int32_t)r.a, r.b, boot, r.t_ms, at_ms};
+  g_log.event(epochMs(upMs()), (uint8_t)(intptr_t)ctx, e);
+}
+
+static void postJournal(int slot, const jrnl_req& r) {
+  postCommand(slot, LinkCommand::Journal, 0, &r, sizeof(r));
+}
+
+void setupJournal() {
+  for (int i = 0; i < MAX_DEVICES; i++) g_jpeer[i].sync.attach(onJournalRecord, (void*)(intptr_t)i);
+}
+
+// Chunks queued by the NimBLE task, a SYNC on every link-up (with the
+// browser's clock once there is one) and the transfer timeouts
+void pollJournal() {
+  uint32_t now = millis();
+  JournalNote n;
+  jrnl_req req;
+  while (g_journalNotes.pop(n)) {
+    if (n.dev < MAX_DEVICES && g_jpeer[n.dev].sync.onChunk(n.data, n.len, now, req)) {
+      postJournal(n.dev, req);
+    }
+  }
+  for (int i = 0; i < g_pool.slots(); i++) {
+    JournalPeer& jp = g_jpeer[i];
+    // Peer::journal is set in discover(), before the link turns Ready;
+    // patches without a journal are left alone
+    bool ready = g_pool.used(i) && g_pool.link(i).ready() && g_peer[i].journal != nullptr;
+    if (ready && !jp.wasReady) {
+      DeviceCfg d;
+      g_pool.device(i, d);
+      if (strcmp(d.addr, jp.addr) != 0) {
+        jp.sync.reset();
+        strlcpy(jp.addr, d.addr, sizeof(jp.addr));
+      }
+      postJournal(i, jp.sync.begin(now, g_clockSet ? epochMs(upMs()) : 0));
+    } else if (!ready && jp.wasReady) {
+      jp.sync.disconnected();
+    } else if (ready && jp.sync.poll(now, req)) {
+      postJournal(i, req);
+    }
+    jp.wasReady = ready;
+  }
+}
+
+/************** 设备表 **************/
+// The pool's table as one Preferences blob; a blob of another size (older
+// firmware, other MAX_DEVICES) is ignored and the table starts empty
+struct SavedDevices {
+  DeviceCfg cfg[MAX_DEVICES];
+  bool used[MAX_DEVICES];
+};
+static uint32_t g_savedVersion = 0;
+
+void loadDevices() {
+  SavedDevices d;
+  prefs.begin(NS, true);
+  bool ok = prefs.getBytesLength(KEY_DEVICES) == sizeof(d) &&
+            prefs.getBytes(KEY_DEVICES, &d, sizeof(d)) == sizeof(d);
+  prefs.end();
+  if (!ok) return;
+  g_pool.load(d.cfg, d.used, MAX_DEVICES);
+  for (int i = 0; i < MAX_DEVICES; i++) {
+    if (d.used[i]) Serial.printf("[CFG] Device #%d: %s '%s'\n", i, d.cfg[i].addr, d.cfg[i].label);
+  }
+}
+
+// From loop(), after admissions, labels and forgets; rare enough for flash
+void saveDevices() {
+  static SavedDevices d;
+  uint32_t v = g_pool.table(d.cfg, d.used);
+  prefs.begin(NS, false);
+  prefs.putBytes(KEY_DEVICES, &d, sizeof(d));
+  prefs.end();
+  g_savedVersion = v;
 }
 
 /************** 载入配置 **************/
@@ -370,6 +1034,7 @@ void loadConfig() {
   Serial.println("[CFG] Target: " + g_targetName);
   Serial.println("[CFG] Service: " + g_serviceUUID);
   Serial.println("[CFG] Char   : " + g_charUUID);
+  loadDevices();
 }
 
 /************** Arduino 入口 **************/
@@ -378,23 +1043,44 @@ void setup() {
   delay(500);
   Serial.println("\n=== ESP32 Web Config + BLE Central (PIO-ready, NimBLE 1.4.3) ===");
 
+  g_cfgLock = xSemaphoreCreateMutex();
   loadConfig();
+  setupLog();
+  setupJournal();
   setupWiFiAP();
   setupWeb();
-  setupBLE();
-
-  g_lastScanAttemptMs = 0; // 立即尝试连接
+  g_live.begin();
+  setupBLE(); // 立即开始扫描
 }
 
 void loop() {
+  // Nothing in here waits on BLE: scans, connects and writes run on the
+  // BLE task
   server.handleClient();
-  ensureConnectedLoop();
+  g_live.poll();
+  pollLog();
+  pollJournal();
+
+  // Only the patch in the live plot streams, and only while someone is
+  // watching
+  static int watched = -1;
+  if (watched >= 0 && !g_pool.used(watched)) watched = -1;
+  int want = g_live.clients() > 0 && g_pool.used(g_liveSlot) ? g_liveSlot : -1;
+  if (want != watched) {
+    uint8_t off = 0, on = 1;
+    if ((watched < 0 || postCommand(watched, LinkCommand::Stream, 0, &off, 1)) &&
+        (want < 0 || postCommand(want, LinkCommand::Stream, 0, &on, 1))) {
+      watched = want;
+    }
+  }
+
+  if (g_pool.tableVersion() != g_savedVersion) saveDevices();
 
-  // 串口直接输入 '1'/'0'/'T' 也可控制
+  // 串口直接输入 '1'/'0'/'T' 也可控制 (all patches)
   if (Serial.available()) {
     char c = (char)Serial.read();
-    if (c=='1' || c=='0' || c=='T') writeCommand(c);
+    if (c=='1' || c=='0' || c=='T') postLed(-1, c);
   }
 
-  delay(10);
+  delay(2);
 }
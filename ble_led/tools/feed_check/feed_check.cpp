@@ -0,0 +1,206 @@
+/*
+ * Run lib/live_feed's FeedRing with simulated consumers and check that the
+ * producer never waits and that every consumer sees an ordered stream.
+ *
+ *   feed_check [-v]
+ *
+ * The paced scenarios run in virtual ticks: the producer pushes a batch of
+ * records per tick (like one stream notification) and each consumer
+ * collects at its own rate, the way LiveServer drains one message per
+ * client and loop() when that client's socket has room. Fast consumers must
+ * lose nothing; slow and stalled ones lose the oldest records, and for
+ * everyone delivered + lost == produced with the index strictly increasing.
+ * The threaded scenario pushes from one thread while consumer threads read
+ * concurrently with different sleeps: no record may come back torn (CRC)
+ * or out of order, and the producer's worst push() time is reported.
+ * Exit status is 1 if any scenario fails.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "feed_ring.h"
+#include "telem_wire.h"
+
+typedef FeedRing<telem_wire, 256> Ring;   // as TelemRing in src/live_ws.h
+static const size_t RECS_PER_MSG = 16;    // LiveServer::RECS_PER_MSG
+
+static bool verbose;
+
+static telem_wire record(uint32_t i) {
+  telem_wire w;
+  memset(&w, 0, sizeof(w));
+  w.seq = (uint16_t)i;
+  w.t_us = i;               // full index, seq wraps at 64k
+  w.pitch_cdeg = (int16_t)(i % 9000);
+  w.temp_cdeg = TELEM_NO_TEMP;
+  telem_wire_seal(&w);
+  return w;
+}
+
+struct Consumer {
+  const char* name;
+  unsigned every;           // collects on every n-th tick, 0 = never
+  unsigned msgs;            // messages per collecting tick
+  FeedCursor cur;
+  uint64_t got = 0;
+  uint32_t last = 0;
+  bool any = false;
+  const char* why = nullptr;
+
+  Consumer(const char* n = "", unsigned e = 1, unsigned m = 1) : name(n), every(e), msgs(m) {}
+
+  void take(const telem_wire* r, size_t n) {
+    for (size_t i = 0; i < n && !why; i++) {
+      if (!telem_wire_valid(&r[i])) why = "bad record";
+      else if (any && r[i].t_us <= last) why = "index went backwards";
+      last = r[i].t_us;
+      any = true;
+    }
+    got += n;
+  }
+};
+
+/* ===== Paced consumers, virtual time ===== */
+
+struct Paced {
+  const char* name;
+  unsigned ticks;
+  unsigned perTick;         // records pushed per tick
+  std::vector<Consumer> cons;
+  std::vector<uint64_t> maxLoss;   // per consumer, ~0 = any
+};
+
+static bool runPaced(Paced& s) {
+  std::unique_ptr<Ring> rp(new Ring());
+  Ring& ring = *rp;
+  uint32_t produced = 0;
+  bool ok = true;
+
+  // Everyone joins before the first record (history 0), so that delivered
+  // + lost has to account for exactly what was produced
+  for (Consumer& c : s.cons) ring.collect(c.cur, nullptr, 0, 0);
+
+  for (unsigned t = 1; t <= s.ticks; t++) {
+    for (unsigned k = 0; k < s.perTick; k++) ring.push(record(produced++));
+
+    for (Consumer& c : s.cons) {
+      if (c.every == 0 || t % c.every) continue;
+      telem_wire buf[RECS_PER_MSG];
+      for (unsigned m = 0; m < c.msgs; m++) c.take(buf, ring.collect(c.cur, buf, RECS_PER_MSG, 0));
+    }
+  }
+
+  // Drain what is left so that delivered + lost covers everything
+  for (Consumer& c : s.cons) {
+    telem_wire buf[RECS_PER_MSG];
+    size_t n;
+    while ((n = ring.collect(c.cur, buf, RECS_PER_MSG, 0)) > 0) c.take(buf, n);
+  }
+
+  for (size_t i = 0; i < s.cons.size(); i++) {
+    Consumer& c = s.cons[i];
+    if (!c.why && c.got + c.cur.drops != produced) c.why = "delivered + lost != produced";
+    if (!c.why && c.cur.drops > s.maxLoss[i]) c.why = "lost records";
+    printf("%-14s %-9s %7u %7llu %7u %s%s\n", s.name, c.name, produced,
+           (unsigned long long)c.got, (unsigned)c.cur.drops, c.why ? "FAIL: " : "",
+           c.why ? c.why : "");
+    if (verbose) printf("    last index %u, backlog %u\n", (unsigned)c.last, (unsigned)ring.backlog(c.cur));
+    ok &= !c.why;
+  }
+  return ok;
+}
+
+/* ===== Concurrent producer and consumers ===== */
+
+static bool runThreads(unsigned total, const unsigned* sleepUs, int nCons) {
+  std::unique_ptr<Ring> rp(new Ring());
+  Ring& ring = *rp;
+  std::atomic<bool> done{false};
+  std::vector<Consumer> cons(nCons);
+  double worstPushUs = 0, sumPushUs = 0;
+  bool ok = true;
+
+  std::vector<std::thread> th;
+  for (int i = 0; i < nCons; i++) {
+    th.emplace_back([&, i] {
+      Consumer& c = cons[i];
+      telem_wire buf[RECS_PER_MSG];
+      ring.collect(c.cur, buf, 0, 0);
+      for (;;) {
+        bool last = done.load();
+        size_t n;
+        while ((n = ring.collect(c.cur, buf, RECS_PER_MSG, 0)) > 0) {
+          c.take(buf, n);
+          if (sleepUs[i]) std::this_thread::sleep_for(std::chrono::microseconds(sleepUs[i]));
+        }
+        if (last) break;
+        std::this_thread::yield();
+      }
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  for (uint32_t i = 0; i < total; i++) {
+    telem_wire w = record(i);
+    auto t0 = std::chrono::steady_clock::now();
+    ring.push(w);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    if (us > worstPushUs) worstPushUs = us;
+    sumPushUs += us;
+    if ((i & 63) == 63) std::this_thread::yield();
+  }
+  done = true;
+  for (std::thread& t : th) t.join();
+
+  for (int i = 0; i < nCons; i++) {
+    Consumer& c = cons[i];
+    char name[16];
+    snprintf(name, sizeof(name), "sleep %uus", sleepUs[i]);
+    // A consumer only starts counting at the head it first saw
+    if (!c.why && c.got + c.cur.drops > total) c.why = "delivered + lost > produced";
+    if (!c.why && c.any && c.last != total - 1) c.why = "did not reach the head";
+    printf("%-14s %-9s %7u %7llu %7u %s%s\n", "threads", name, total, (unsigned long long)c.got,
+           (unsigned)c.cur.drops, c.why ? "FAIL: " : "", c.why ? c.why : "");
+    ok &= !c.why;
+  }
+  // The worst case includes host preemption; the mean is push()'s own cost
+  printf("push(): mean %.3f us, worst %.1f us\n", sumPushUs / total, worstPushUs);
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-v")) verbose = true;
+    else { fprintf(stderr, "usage: %s [-v]\n", argv[0]); return 2; }
+  }
+
+  const uint64_t ANY = ~0ull;
+  std::vector<Paced> sc;
+  // A notification's worth of records per tick; slow keeps up exactly
+  sc.push_back({"steady", 2000, 4,
+                {{"fast", 1, 1}, {"slow", 4, 1}, {"stalled", 0, 1}},
+                {0, 0, ANY}});
+  // Bursts well above one message per tick
+  sc.push_back({"burst", 2000, 40,
+                {{"fast", 1, 4}, {"slow", 1, 1}, {"trickle", 20, 1}},
+                {0, ANY, ANY}});
+  // Consumer that wakes rarely but drains a lot
+  sc.push_back({"bursty-reader", 1000, 8,
+                {{"fast", 1, 1}, {"every25", 25, 64}, {"every200", 200, 1000}},
+                {0, 0, ANY}});
+
+  printf("%-14s %-9s %7s %7s %7s\n", "scenario", "consumer", "pushed", "got", "lost");
+  bool ok = true;
+  for (Paced& s : sc) ok &= runPaced(s);
+
+  static const unsigned sleeps[] = {0, 50, 2000};
+  ok &= runThreads(500000, sleeps, 3);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,318 @@
+/*
+ * Measure what the gateway's HTTP handlers cost per request in heap
+ * allocations and bytes copied, before and after the move to a static
+ * gzip page and lib/json_out.
+ *
+ *   http_bench [-v] [iterations]
+ *
+ * "before" replays the old handlers with std::string standing in for
+ * Arduino String: GET / copies HTML_PAGE and runs three replace() passes,
+ * /status and /discover are built by concatenation. "after" serves the
+ * embedded gzip page by pointer and writes JSON through JsonOut's 256-byte
+ * chunk buffer into a sink that only counts (the socket). Allocations are
+ * counted by replacing operator new; "copied" is every byte written into
+ * a heap or staging buffer before the socket. The WebServer's own header
+ * and request handling is the same on both sides and is not included.
+ *
+ * It also checks JsonOut: /status must come out byte-identical to the old
+ * concatenation, for every chunk size from 1 byte up, and strings must be
+ * escaped. Exit status is 1 if a check fails.
+ */
+
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "index_html_gz.h"
+#include "json_out.h"
+
+static bool verbose;
+
+/* ===== Allocation counting ===== */
+
+static size_t g_allocs, g_allocBytes;
+
+void* operator new(size_t n) {
+  g_allocs++;
+  g_allocBytes += n;
+  void* p = malloc(n ? n : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+struct Cost {
+  size_t allocs = 0;
+  size_t copied = 0;
+  size_t wire = 0;          // response body bytes
+  double ns = 0;
+};
+
+/* ===== Gateway state as the handlers see it ===== */
+
+static const char* NAME = "nRF5340DK";
+static const char* SVC = "0000ffff-0000-1000-8000-00805f9b34fb";
+static const char* CHR = "0000ff01-0000-1000-8000-00805f9b34fb";
+static const uint32_t STATS[13] = {12, 3, 1, 0, 4211, 310, 27, 2, 17, 1, 88213, 0, 1};
+static const char* MSG = "BLE is connected, ready to write.";
+
+struct Attr {
+  const char* uuid;
+  const char* props;        // nullptr for a service
+};
+static const Attr GATT[] = {
+    {"00001800-0000-1000-8000-00805f9b34fb", nullptr},
+    {"00002a00-0000-1000-8000-00805f9b34fb", "R"},
+    {"00002a01-0000-1000-8000-00805f9b34fb", "R"},
+    {"00001801-0000-1000-8000-00805f9b34fb", nullptr},
+    {"00002a05-0000-1000-8000-00805f9b34fb", "I"},
+    {"0000ffff-0000-1000-8000-00805f9b34fb", nullptr},
+    {"0000ff01-0000-1000-8000-00805f9b34fb", "WWN"},
+    {"0000ff02-0000-1000-8000-00805f9b34fb", "RN"},
+    {"0000ff03-0000-1000-8000-00805f9b34fb", "N"},
+    {"0000ff04-0000-1000-8000-00805f9b34fb", "RW"},
+    {"0000ff05-0000-1000-8000-00805f9b34fb", "R"},
+    {"0000ff06-0000-1000-8000-00805f9b34fb", "WNN"},
+};
+static const int GATT_N = sizeof(GATT) / sizeof(GATT[0]);
+
+// The old template: web/index.html with the three placeholders back in
+static std::string g_template;
+static std::string g_discovered;    // the old per-connection JSON list
+
+static bool loadTemplate() {
+  FILE* f = fopen(WEB_INDEX, "rb");
+  if (!f) {
+    fprintf(stderr, "cannot open %s\n", WEB_INDEX);
+    return false;
+  }
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) g_template.append(buf, n);
+  fclose(f);
+
+  static const char* in[][2] = {{"name=\"bleName\"", "%BLE_NAME%"},
+                                {"name=\"svcUUID\"", "%SVC_UUID%"},
+                                {"name=\"chrUUID\"", "%CHR_UUID%"}};
+  for (auto& p : in) {
+    size_t at = g_template.find(p[0]);
+    if (at == std::string::npos) return false;
+    g_template.insert(at + strlen(p[0]), std::string(" value=\"") + p[1] + "\"");
+  }
+
+  g_discovered = "[";
+  for (int i = 0; i < GATT_N; i++) {
+    if (i) g_discovered += ",";
+    g_discovered += GATT[i].props ? std::string("\"  CHR ") + GATT[i].uuid + " props:" + GATT[i].props + "\""
+                                  : std::string("\"SVC ") + GATT[i].uuid + "\"";
+  }
+  g_discovered += "]";
+  return true;
+}
+
+/* ===== Before ===== */
+
+static void replaceAll(std::string& s, const char* from, const char* to) {
+  std::string out;
+  size_t fl = strlen(from), at = 0, hit;
+  while ((hit = s.find(from, at)) != std::string::npos) {
+    out.append(s, at, hit - at);
+    out += to;
+    at = hit + fl;
+  }
+  out.append(s, at, std::string::npos);
+  s = out;
+}
+
+static size_t oldRoot() {
+  std::string page = g_template;
+  replaceAll(page, "%BLE_NAME%", NAME);
+  replaceAll(page, "%SVC_UUID%", SVC);
+  replaceAll(page, "%CHR_UUID%", CHR);
+  return page.size();
+}
+
+static std::string oldStatusJson() {
+  const uint32_t* s = STATS;
+  return std::string("{\"connected\":") + "true" + ",\"state\":\"" + "ready" + "\"" +
+         ",\"bleName\":\"" + NAME + "\"" + ",\"svcUUID\":\"" + SVC + "\"" +
+         ",\"chrUUID\":\"" + CHR + "\"" + ",\"scans\":" + std::to_string(s[0]) +
+         ",\"failures\":" + std::to_string(s[1]) + ",\"writeFails\":" + std::to_string(s[2]) +
+         ",\"frames\":" + std::to_string(s[4]) + ",\"inflight\":" + std::to_string(s[3]) +
+         ",\"resends\":" + std::to_string(s[5]) + ",\"naks\":" + std::to_string(s[6]) +
+         ",\"lastNakErr\":" + std::to_string(s[7]) + ",\"telem\":" + std::to_string(s[10]) +
+         ",\"telemBad\":" + std::to_string(s[11]) + ",\"liveClients\":" + std::to_string(s[12]) +
+         ",\"msg\":\"" + MSG + "\"}";
+}
+
+static size_t oldStatus() { return oldStatusJson().size(); }
+
+static size_t oldDiscover() {
+  std::string out = std::string("{\"list\":") + g_discovered + "}";
+  return out.size();
+}
+
+/* ===== After ===== */
+
+struct Socket {
+  size_t bytes = 0;
+  std::string* keep = nullptr;      // checks only
+};
+
+static void sockWrite(void* ctx, const char* p, size_t n) {
+  Socket* s = (Socket*)ctx;
+  s->bytes += n;
+  if (s->keep) s->keep->append(p, n);
+}
+
+static char g_buf[256];
+
+static void newStatusJson(JsonOut& j) {
+  const uint32_t* s = STATS;
+  j.obj()
+   .kv("connected", true)
+   .kv("state", "ready")
+   .kv("bleName", NAME).kv("svcUUID", SVC).kv("chrUUID", CHR)
+   .kv("scans", s[0]).kv("failures", s[1]).kv("writeFails", s[2])
+   .kv("frames", s[4]).kv("inflight", s[3])
+   .kv("resends", s[5]).kv("naks", s[6]).kv("lastNakErr", s[7])
+   .kv("telem", s[10]).kv("telemBad", s[11])
+   .kv("liveClients", s[12])
+   .kv("msg", MSG);
+  j.finish();
+}
+
+// Straight from flash: nothing is copied before the socket
+static size_t newRoot(size_t&) {
+  Socket sock;
+  sockWrite(&sock, (const char*)INDEX_HTML_GZ, INDEX_HTML_GZ_LEN);
+  return sock.bytes;
+}
+
+static size_t newStatus(size_t& copied) {
+  Socket sock;
+  JsonOut j(g_buf, sizeof(g_buf), sockWrite, &sock);
+  newStatusJson(j);
+  copied += j.bytes();
+  return sock.bytes;
+}
+
+static size_t newDiscover(size_t& copied) {
+  Socket sock;
+  JsonOut j(g_buf, sizeof(g_buf), sockWrite, &sock);
+  j.obj().key("list").arr();
+  for (int i = 0; i < GATT_N; i++) {
+    Attr a = GATT[i];       // the handler copies one entry out under the lock
+    copied += 39;           // sizeof(GattAttr) in src/main.cpp
+    j.obj().kv("uuid", a.uuid);
+    if (a.props) j.kv("props", a.props);
+    j.end();
+  }
+  j.finish();
+  copied += j.bytes();
+  return sock.bytes;
+}
+
+/* ===== Measurement ===== */
+
+template <typename F>
+static Cost measure(int iters, F f) {
+  Cost c;
+  size_t a0 = g_allocs, b0 = g_allocBytes, copied = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < iters; i++) c.wire = f(copied);
+  c.ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / iters;
+  c.allocs = (g_allocs - a0) / iters;
+  // Heap bytes are filled by copying: for the String version they are
+  // what it copied
+  c.copied = (g_allocBytes - b0 + copied) / iters;
+  return c;
+}
+
+static void row(const char* name, const Cost& b, const Cost& a) {
+  printf("%-10s %7zu %9zu %7zu %8.0f | %7zu %9zu %7zu %8.0f\n", name, b.allocs, b.copied, b.wire,
+         b.ns, a.allocs, a.copied, a.wire, a.ns);
+}
+
+/* ===== Checks ===== */
+
+static const char* checkJson() {
+  // Same bytes as the old concatenation, whatever the chunk size
+  std::string want = oldStatusJson();
+  for (size_t cap = 1; cap <= want.size() + 1; cap++) {
+    std::string got;
+    Socket sock;
+    sock.keep = &got;
+    char buf[512];
+    JsonOut j(buf, cap, sockWrite, &sock);
+    newStatusJson(j);
+    if (got != want) {
+      if (verbose) printf("cap %zu:\n  %s\n  %s\n", cap, want.c_str(), got.c_str());
+      return "status differs from the old handler";
+    }
+    if (j.chunks() != (want.size() + cap - 1) / cap) return "unexpected chunk count";
+  }
+
+  // Escaping, nesting, empty containers, numbers at the edges
+  std::string got;
+  Socket sock;
+  sock.keep = &got;
+  JsonOut j(g_buf, 7, sockWrite, &sock);
+  j.obj().kv("s", "a\"b\\c\n\x01").key("a").arr().num(-2147483647L - 1).num(4294967295UL).null()
+   .obj().end().arr().end().end().kv("t", false);
+  j.finish();
+  const char* want2 = "{\"s\":\"a\\\"b\\\\c\\u000a\\u0001\",\"a\":[-2147483648,4294967295,null,{},[]],\"t\":false}";
+  if (got != want2) {
+    if (verbose) printf("  %s\n  %s\n", want2, got.c_str());
+    return "escaping or nesting";
+  }
+
+  // finish() closes what is still open
+  got.clear();
+  JsonOut k(g_buf, sizeof(g_buf), sockWrite, &sock);
+  k.obj().key("l").arr().str("x");
+  k.finish();
+  if (got != "{\"l\":[\"x\"]}") return "finish() did not close";
+  return nullptr;
+}
+
+int main(int argc, char** argv) {
+  int iters = 20000;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-v")) verbose = true;
+    else if (atoi(argv[i]) > 0) iters = atoi(argv[i]);
+    else { fprintf(stderr, "usage: %s [-v] [iterations]\n", argv[0]); return 2; }
+  }
+  if (!loadTemplate()) return 1;
+
+  bool ok = true;
+  const char* why = checkJson();
+  printf("json_out checks: %s%s\n", why ? "FAIL: " : "ok", why ? why : "");
+  ok &= !why;
+
+  printf("\n%-10s %34s | %34s\n", "", "before (String)", "after (flash + JsonOut)");
+  printf("%-10s %7s %9s %7s %8s | %7s %9s %7s %8s\n", "request", "allocs", "copied B", "body B",
+         "ns", "allocs", "copied B", "body B", "ns");
+  Cost b, a;
+  b = measure(iters, [](size_t&) { return oldRoot(); });
+  a = measure(iters, newRoot);
+  row("GET /", b, a);
+  ok &= a.allocs == 0;
+  b = measure(iters, [](size_t&) { return oldStatus(); });
+  a = measure(iters, newStatus);
+  row("/status", b, a);
+  ok &= a.allocs == 0;
+  b = measure(iters, [](size_t&) { return oldDiscover(); });
+  a = measure(iters, newDiscover);
+  row("/discover", b, a);
+  ok &= a.allocs == 0;
+
+  printf("\npage: %zu B raw, %zu B gzip, ETag %s (304 on a match, no body)\n", INDEX_HTML_RAW_LEN,
+         INDEX_HTML_GZ_LEN, INDEX_HTML_ETAG);
+  if (!ok) printf("FAIL: the new handlers must not allocate\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,522 @@
+/*
+ * Run lib/ble_link against a mocked NimBLE backend in virtual time and
+ * check the connection state machine.
+ *
+ *   link_check [-v]
+ *
+ * The mock answers a scan with a hit 200 ms in (patch present) or a scan
+ * end after the window (patch absent); connect and discovery outcomes are
+ * scripted per attempt. Each scenario checks the states reached, the scan
+ * times (backoff), the backend calls and the stats. With the command
+ * protocol enabled, the mock runs the patch's receiver from
+ * shared/cmd_proto.h behind a link that loses frames and ACKs; every
+ * command must arrive exactly once and in order. The wall-clock time of
+ * every step() is also measured: with an instant backend it is the state
+ * machine's own cost, which has to stay below a tenth of the 50 ms task
+ * period (host scheduling noise included).
+ * Exit status is 1 if any scenario fails.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "ble_link.h"
+
+static const uint32_t TICK_MS = 10;
+static const uint32_t HIT_MS = 200;     // advertising found this far into a scan
+
+static bool verbose;
+static double worstStepUs;
+
+class MockBackend : public LinkBackend {
+ public:
+  explicit MockBackend(BleLink*& link) : link_(link) {}
+
+  // ---- Script ----
+  bool present = true;
+  std::vector<bool> connectOk;          // per attempt, missing = ok
+  std::vector<bool> discoverOk;
+  bool proto = false;                   // peer has the protocol characteristic
+  size_t mtuPayload = 244;
+  unsigned lossPct = 0;                 // frames and ACKs lost on the air
+  int txPerTick = 4;                    // NimBLE buffers per connection event
+
+  // ---- Observed ----
+  std::vector<uint32_t> scanTimes;
+  uint32_t connects = 0;
+  uint32_t discovers = 0;
+  uint32_t disconnects = 0;
+  uint32_t stops = 0;
+  std::vector<uint8_t> written;
+  bool connected = false;
+  bool streaming = false;
+  // Patch side of the protocol
+  cmdp_rx rx;
+  std::vector<std::vector<uint8_t>> applied;  // type, value...
+  uint32_t lost = 0;
+
+  uint32_t now = 0;
+
+  bool startScan(uint32_t ms) override {
+    scanning_ = true;
+    scanAt_ = now;
+    window_ = ms;
+    scanTimes.push_back(now);
+    if (verbose) printf("    %7u ms  scan\n", now);
+    return true;
+  }
+  void stopScan() override {
+    scanning_ = false;
+    stops++;
+  }
+  bool connect(const char* addr, uint8_t addrType) override {
+    bool ok = connects >= connectOk.size() || connectOk[connects];
+    connects++;
+    connected = ok;
+    if (ok) {
+      cmdp_rx_init(&rx);
+      air_.clear();
+    }
+    if (verbose) printf("    %7u ms  connect %s/%u -> %s\n", now, addr, addrType, ok ? "ok" : "fail");
+    return ok;
+  }
+  bool discover() override {
+    bool ok = discovers >= discoverOk.size() || discoverOk[discovers];
+    discovers++;
+    if (verbose) printf("    %7u ms  discover -> %s\n", now, ok ? "ok" : "fail");
+    return ok;
+  }
+  void disconnect() override {
+    disconnects++;
+    if (connected) {
+      connected = false;
+      link_->onDisconnected();          // NimBLE reports our own disconnects too
+    }
+  }
+  bool write(uint8_t value) override {
+    if (!connected) return false;
+    written.push_back(value);
+    return true;
+  }
+  bool stream(bool on) override {
+    streaming = on;
+    return true;
+  }
+  bool framed() override { return proto; }
+  size_t payload() override { return mtuPayload; }
+  bool writeFrame(const uint8_t* buf, size_t len) override {
+    if (!connected || budget_ == 0 || len > mtuPayload) return false;
+    budget_--;
+    air_.push_back(std::vector<uint8_t>(buf, buf + len));
+    return true;
+  }
+
+  // The patch: a setpoint at or above the cut-off is rejected
+  static int apply(uint8_t type, const uint8_t* val, uint8_t len, void* ctx) {
+    MockBackend* m = static_cast<MockBackend*>(ctx);
+    std::vector<uint8_t> c(1, type);
+    c.insert(c.end(), val, val + len);
+    m->applied.push_back(c);
+    return type == CMDP_T_SETPOINT && (int16_t)cmdp_get_u16(val) >= 4500 ? -EINVAL : 0;
+  }
+
+  // Peer drops the link
+  void drop() {
+    connected = false;
+    link_->onDisconnected();
+  }
+
+  // NimBLE host task side of one tick
+  void tick() {
+    budget_ = txPerTick;
+    if (connected) {
+      for (size_t i = 0; i < air_.size(); i++) {
+        if (chance(lossPct)) {
+          lost++;
+        } else {
+          cmdp_rx_frame(&rx, air_[i].data(), air_[i].size(), apply, this);
+        }
+      }
+      air_.clear();
+
+      uint8_t ack[64];
+      size_t n = cmdp_rx_ack(&rx, ack, mtuPayload < sizeof(ack) ? mtuPayload : sizeof(ack));
+      if (n && !chance(lossPct)) link_->onFrame(ack, n);
+    }
+    if (!scanning_) return;
+    if (present && now - scanAt_ >= HIT_MS) {
+      // NimBLE keeps scanning until stopScan(); one hit per window
+      link_->onScanHit("c0:ff:ee:00:00:01", 1);
+      scanAt_ = now + window_;
+    } else if (now - scanAt_ >= window_) {
+      scanning_ = false;
+      link_->onScanDone();
+    }
+  }
+
+ private:
+  bool chance(unsigned pct) {
+    rng_ = rng_ * 1103515245u + 12345u;
+    return (rng_ >> 16) % 100 < pct;
+  }
+
+  BleLink*& link_;
+  std::vector<std::vector<uint8_t>> air_;
+  int budget_ = 0;
+  uint32_t rng_ = 1;
+  bool scanning_ = false;
+  uint32_t scanAt_ = 0;
+  uint32_t window_ = 0;
+};
+
+struct Rig {
+  BleLink* linkp;
+  MockBackend be;
+  BleLink link;
+
+  Rig() : linkp(nullptr), be(linkp), link(be) { linkp = &link; }
+
+  void step() {
+    timespec a, b;
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    link.step(be.now);
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    double us = (b.tv_sec - a.tv_sec) * 1e6 + (b.tv_nsec - a.tv_nsec) / 1e3;
+    if (us > worstStepUs) worstStepUs = us;
+  }
+
+  void start() { link.start(be.now); }
+
+  void run(uint32_t ms) {
+    for (uint32_t t = 0; t < ms; t += TICK_MS) {
+      be.now += TICK_MS;
+      be.tick();
+      step();
+    }
+  }
+
+  // Runs until the state is reached; false after limit ms
+  bool runUntil(LinkState s, uint32_t limit) {
+    for (uint32_t t = 0; t < limit; t += TICK_MS) {
+      if (link.state() == s) return true;
+      run(TICK_MS);
+    }
+    return link.state() == s;
+  }
+
+  // LED command as the web page sends it: '1', '0' or 'T'
+  void write(uint8_t v) {
+    uint8_t mode = v == '1' ? CMDP_LED_ON : v == 'T' ? CMDP_LED_TOGGLE : CMDP_LED_RELEASE;
+    send(CMDP_T_LED, &mode, 1);
+  }
+  bool send(uint8_t type, const uint8_t* val, uint8_t len) {
+    LinkCommand c = {LinkCommand::Send, type, len, {0}};
+    memcpy(c.val, val, len);
+    return link.command(c);
+  }
+  void reconnect() {
+    LinkCommand c = {LinkCommand::Reconnect, 0, 0, {0}};
+    link.command(c);
+  }
+  void stream(bool on) {
+    LinkCommand c = {LinkCommand::Stream, 0, 1, {(uint8_t)on}};
+    link.command(c);
+  }
+};
+
+#define EXPECT(cond)                                \
+  do {                                              \
+    if (!(cond) && !why) why = #cond;               \
+  } while (0)
+
+static int report(const char* name, Rig& r, const char* why) {
+  LinkStats st = r.link.stats();
+  printf("%-18s %-11s %5u %6u %5u %5u %6u/%-4u %s%s\n", name, linkStateName(r.link.state()),
+         st.scans, st.connects, st.failures, st.disconnects, st.writes, st.writeFails,
+         why ? "FAIL: " : "", why ? why : "");
+  return why != nullptr;
+}
+
+/* ===== Scenarios ===== */
+
+// Patch switched off: scans are spaced by a doubling backoff capped at
+// BACKOFF_MAX_MS, and nothing else is attempted
+static int absent() {
+  Rig r;
+  const char* why = nullptr;
+  r.be.present = false;
+  r.start();
+  r.run(150000);
+
+  const std::vector<uint32_t>& s = r.be.scanTimes;
+  uint32_t backoff = BleLink::BACKOFF_MIN_MS;
+  EXPECT(s.size() >= 6);
+  for (size_t i = 1; i < s.size() && !why; i++) {
+    uint32_t gap = s[i] - s[i - 1] - BleLink::SCAN_MS;
+    // Off by at most one tick
+    EXPECT(gap >= backoff && gap <= backoff + TICK_MS);
+    backoff = backoff * 2 > BleLink::BACKOFF_MAX_MS ? BleLink::BACKOFF_MAX_MS : backoff * 2;
+  }
+  EXPECT(r.link.backoffMs() == BleLink::BACKOFF_MAX_MS);
+  EXPECT(r.be.connects == 0);
+  return report("patch absent", r, why);
+}
+
+// Found on the first scan, connected and discovered, writes go through
+static int connectOk() {
+  Rig r;
+  const char* why = nullptr;
+  r.start();
+  EXPECT(r.runUntil(LinkState::Ready, 1000));
+  EXPECT(r.be.stops == 1);
+  r.write('1');
+  r.write('T');
+  r.run(TICK_MS);
+  EXPECT(r.be.written.size() == 2 && r.be.written[0] == '1' && r.be.written[1] == 'T');
+  EXPECT(r.link.backoffMs() == BleLink::BACKOFF_MIN_MS);
+  return report("connect", r, why);
+}
+
+// Connect fails twice, then succeeds after the backoff
+static int connectRetry() {
+  Rig r;
+  const char* why = nullptr;
+  r.be.connectOk = {false, false};
+  r.start();
+  r.run(HIT_MS + TICK_MS);
+  EXPECT(r.link.state() == LinkState::Backoff);
+  EXPECT(r.runUntil(LinkState::Ready, 10000));
+  EXPECT(r.be.connects == 3 && r.link.stats().failures == 2);
+  // 1 s after the first failure, 2 s after the second
+  EXPECT(r.be.scanTimes.size() == 3);
+  EXPECT(r.be.scanTimes.size() == 3 && r.be.scanTimes[2] - r.be.scanTimes[1] <= HIT_MS + 2000 + 2 * TICK_MS);
+  EXPECT(r.link.backoffMs() == BleLink::BACKOFF_MIN_MS);
+  return report("connect retry", r, why);
+}
+
+// Wrong service on the peer: disconnect, back off, and the own disconnect
+// is not counted as a drop
+static int discoverFail() {
+  Rig r;
+  const char* why = nullptr;
+  r.be.discoverOk = {false};
+  r.start();
+  r.run(HIT_MS + TICK_MS);
+  EXPECT(r.link.state() == LinkState::Backoff);
+  EXPECT(r.be.disconnects == 1 && !r.be.connected);
+  r.run(TICK_MS);
+  EXPECT(r.link.stats().disconnects == 0);
+  EXPECT(r.runUntil(LinkState::Ready, 5000));
+  return report("discovery fail", r, why);
+}
+
+// Peer drops the link: rescan after the shortest backoff, whatever the
+// backoff was before
+static int dropped() {
+  Rig r;
+  const char* why = nullptr;
+  r.be.connectOk = {false, false, false};
+  r.start();
+  EXPECT(r.runUntil(LinkState::Ready, 20000));
+  r.be.drop();
+  uint32_t at = r.be.now;
+  r.run(TICK_MS);
+  EXPECT(r.link.state() == LinkState::Backoff);
+  EXPECT(r.runUntil(LinkState::Scanning, 5000));
+  EXPECT(r.be.now - at <= BleLink::BACKOFF_MIN_MS + 2 * TICK_MS);
+  EXPECT(r.runUntil(LinkState::Ready, 1000));
+  EXPECT(r.link.stats().disconnects == 1);
+  return report("dropped", r, why);
+}
+
+// New settings from /save: scan again at once, from Ready, Scanning and
+// Backoff alike
+static int reconnect() {
+  Rig r;
+  const char* why = nullptr;
+  r.start();
+  EXPECT(r.runUntil(LinkState::Ready, 1000));
+  r.reconnect();
+  r.run(TICK_MS);
+  EXPECT(r.link.state() == LinkState::Scanning);
+  EXPECT(r.be.disconnects == 1 && r.be.scanTimes.size() == 2);
+  // The disconnect event of the old link must not turn into a drop
+  r.run(TICK_MS);
+  EXPECT(r.link.state() == LinkState::Scanning && r.link.stats().disconnects == 0);
+
+  r.be.present = false;
+  r.run(BleLink::SCAN_MS + TICK_MS);
+  EXPECT(r.link.state() == LinkState::Backoff);
+  r.reconnect();
+  r.run(TICK_MS);
+  EXPECT(r.link.state() == LinkState::Scanning && r.be.scanTimes.size() == 3);
+
+  r.reconnect();
+  r.run(TICK_MS);
+  EXPECT(r.be.stops >= 2 && r.be.scanTimes.size() == 4);
+  r.be.present = true;
+  EXPECT(r.runUntil(LinkState::Ready, 1000));
+  return report("reconnect", r, why);
+}
+
+// Writes while not Ready fail without touching the backend; a burst larger
+// than the queue is dropped, not waited for
+static int writes() {
+  Rig r;
+  const char* why = nullptr;
+  r.be.present = false;
+  r.start();
+  r.write('1');
+  r.run(TICK_MS);
+  EXPECT(r.link.stats().writeFails == 1 && r.be.written.empty());
+
+  r.be.present = true;
+  EXPECT(r.runUntil(LinkState::Ready, 10000));
+  for (int i = 0; i < 20; i++) r.write('T');
+  EXPECT(r.link.stats().cmdDrops == 4);
+  r.run(TICK_MS);
+  EXPECT(r.be.written.size() == 16);
+  EXPECT(r.link.stats().writes == 16);
+  return report("writes", r, why);
+}
+
+// Parameter burst over the framed protocol on a lossy link: all commands
+// applied once and in order, several per write, rejections reported back
+static int protocol(size_t mtuPayload, unsigned lossPct) {
+  Rig r;
+  const char* why = nullptr;
+  std::vector<std::vector<uint8_t>> sent;
+  uint32_t rejected = 0;
+  char name[32];
+
+  r.be.proto = true;
+  r.be.mtuPayload = mtuPayload;
+  r.be.lossPct = lossPct;
+  r.start();
+  EXPECT(r.runUntil(LinkState::Ready, 1000));
+
+  // What the tuning page sends: posture sets, setpoints, haptic patterns
+  for (int i = 0; i < 400; i++) {
+    uint8_t val[CMDP_VAL_MAX];
+    uint8_t type, len;
+    if (i % 3 == 0) {
+      cmdp_posture pp = {(uint16_t)(1000 + i), 800, 2000, 1000, 300};
+      cmdp_posture_encode(val, &pp);
+      type = CMDP_T_POSTURE;
+      len = CMDP_POSTURE_LEN;
+    } else if (i % 3 == 1) {
+      // Now and then one above the cut-off
+      uint16_t cdeg = (uint16_t)(i % 30 == 1 ? 5000 : 3000 + i);
+      cmdp_put_u16(val, cdeg);
+      rejected += cdeg >= 4500;
+      type = CMDP_T_SETPOINT;
+      len = 2;
+    } else {
+      val[0] = (uint8_t)(i % 8);
+      val[1] = 0;
+      type = CMDP_T_HAPTIC_PLAY;
+      len = 2;
+    }
+    // The HTTP side posts up to the queue depth per BLE task wake-up
+    while (!r.send(type, val, len)) r.run(TICK_MS);
+    std::vector<uint8_t> c(1, type);
+    c.insert(c.end(), val, val + len);
+    sent.push_back(c);
+  }
+  for (int t = 0; t < 100000 && r.link.stats().inflight; t += TICK_MS) r.run(TICK_MS);
+  r.run(10 * TICK_MS);
+
+  LinkStats st = r.link.stats();
+  EXPECT(r.be.applied == sent);
+  EXPECT(st.inflight == 0);
+  EXPECT(st.writeFails == 0 && st.writes == sent.size());
+  // Batched: at the full MTU several commands per write
+  EXPECT(lossPct > 0 || mtuPayload < 100 || st.frames * 4 < sent.size());
+  // NAKs ride on ACKs, which may be lost
+  EXPECT(lossPct > 0 ? st.naks <= rejected : st.naks == rejected);
+  EXPECT(r.be.written.empty());
+  snprintf(name, sizeof(name), "proto %zu B %u%%", mtuPayload, lossPct);
+  if (verbose) {
+    printf("    %u frames, %u lost, %u resends, %u NAKs\n", st.frames, r.be.lost, st.resends,
+           st.naks);
+  }
+  return report(name, r, why);
+}
+
+// A browser opened the live view before the patch was found, closed it and
+// opened it again: the subscription follows, across a reconnect too
+static int stream() {
+  Rig r;
+  const char* why = nullptr;
+  r.be.present = false;
+  r.start();
+  r.stream(true);
+  r.run(TICK_MS);
+  EXPECT(!r.be.streaming);
+  r.be.present = true;
+  EXPECT(r.runUntil(LinkState::Ready, 10000));
+  EXPECT(r.be.streaming);
+  r.stream(false);
+  r.run(TICK_MS);
+  EXPECT(!r.be.streaming);
+  r.stream(true);
+  r.run(TICK_MS);
+  r.be.drop();
+  r.be.streaming = false;
+  EXPECT(r.runUntil(LinkState::Backoff, 100));
+  EXPECT(r.runUntil(LinkState::Ready, 5000));
+  EXPECT(r.be.streaming);
+  return report("stream", r, why);
+}
+
+// Peer without the protocol: LED commands as bytes, others fail
+static int legacy() {
+  Rig r;
+  const char* why = nullptr;
+  uint8_t v[2] = {0, 0};
+  r.start();
+  EXPECT(r.runUntil(LinkState::Ready, 1000));
+  r.write('0');
+  r.send(CMDP_T_SETPOINT, v, 2);
+  r.run(TICK_MS);
+  EXPECT(r.be.written.size() == 1 && r.be.written[0] == '0');
+  EXPECT(r.link.stats().writeFails == 1);
+  return report("legacy peer", r, why);
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-v")) {
+      verbose = true;
+    } else {
+      fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  printf("%-18s %-11s %5s %6s %5s %5s %11s\n", "scenario", "state", "scans", "conns", "fails",
+         "drops", "writes/fail");
+  int failed = 0;
+  failed |= absent();
+  failed |= connectOk();
+  failed |= connectRetry();
+  failed |= discoverFail();
+  failed |= dropped();
+  failed |= reconnect();
+  failed |= writes();
+  failed |= legacy();
+  failed |= stream();
+  failed |= protocol(244, 0);
+  failed |= protocol(20, 0);
+  failed |= protocol(244, 10);
+  failed |= protocol(20, 30);
+
+  printf("worst step(): %.1f us\n", worstStepUs);
+  if (worstStepUs > 5000) {
+    printf("FAIL: step() should return within 5 ms\n");
+    failed = 1;
+  }
+  return failed;
+}
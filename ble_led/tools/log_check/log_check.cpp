@@ -0,0 +1,807 @@
+/*
+ * Write lib/session_log through a temporary directory on the host and
+ * check the segment format, recovery from torn appends, retention and
+ * time-range reads.
+ *
+ *   log_check [-v] [-k]      -k keeps the directory
+ *
+ * The input is synthetic but shaped like the real thing: one patch
+ * streaming telemetry at 20 Hz (slow posture drift plus sensor noise),
+ * and posture notifications from three patches every few seconds. Each
+ * scenario compares what a LogReader returns with what went in:
+ *   format      everything back, bit for bit; the bytes per record
+ *   seek        random ranges and devices against a plain filter, and the
+ *               blocks read for each against the blocks in the range
+ *   recovery    the newest segment cut or damaged at random points, as a
+ *               reset in the middle of an append would; begin() must keep
+ *               every complete block, drop the rest and append after them
+ *   retention   far more than the cap written: the log stays under it and
+ *               keeps the newest records, without gaps
+ *   journal     JournalSync pulling a modelled patch journal over a link
+ *               that loses notifications and writes, and drops the
+ *               connection mid-transfer: every record once, in order, with
+ *               its wall time, except those the patch rotated out first;
+ *               then the records through the log and its CSV
+ *   throughput  records per second written, read, and read as CSV
+ * Exit status is 1 if any scenario fails.
+ */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "journal_sync.h"
+#include "session_log.h"
+
+static const uint64_t T0 = 1760000000000ull;      // an October 2025 epoch, ms
+static bool verbose;
+static bool keep;
+
+/* ===== Input ===== */
+
+struct Gen {
+  uint32_t rng = 7;
+  uint64_t t = T0;
+  telem_wire w = {};
+  ble_posture_wire p[3] = {};
+  uint64_t nextPosture[3] = {T0 + 1000, T0 + 2300, T0 + 3700};
+
+  uint32_t random(uint32_t n) {
+    rng = rng * 1103515245u + 12345u;
+    return (rng >> 16) % n;
+  }
+  int noise(int a) { return (int)random(2 * a + 1) - a; }
+
+  // The next record, 50 ms of telemetry or a posture notification
+  LogRecord next() {
+    LogRecord r;
+    memset(&r, 0, sizeof(r));
+    for (int d = 0; d < 3; d++) {
+      if (nextPosture[d] <= t) {
+        ble_posture_wire& q = p[d];
+        q.state = (uint8_t)random(3);
+        q.event = (uint8_t)random(5);
+        q.flags = (uint8_t)random(16);
+        q.pitch_cdeg = (int16_t)(q.pitch_cdeg + noise(800));
+        q.dev_cdeg = (int16_t)(q.pitch_cdeg - 1500);
+        q.t_ms = (uint32_t)(t - T0) + 12345;
+        nextPosture[d] = t + 2000 + random(6000);
+        r.t_ms = t;
+        r.kind = LOG_POSTURE;
+        r.dev = (uint8_t)d;
+        r.posture = q;
+        return r;
+      }
+    }
+    t += 50;
+    double s = (double)(t - T0) / 60000.0;
+    w.seq = (uint16_t)(w.seq + 1 + (random(500) == 0));
+    w.t_us += 50000 + noise(100);
+    int pitch = (int)(1500 + 900 * ((s - (int)s) < 0.5 ? 1 : -1)) + noise(30);
+    w.acc[0] = (int16_t)(pitch / 2 + noise(40));
+    w.acc[1] = (int16_t)noise(40);
+    w.acc[2] = (int16_t)(16384 - pitch / 8 + noise(40));
+    for (int i = 0; i < 3; i++) w.gyr[i] = (int16_t)noise(30);
+    w.pitch_cdeg = (int16_t)pitch;
+    w.roll_cdeg = (int16_t)(noise(50) - 200);
+    w.therm_mv = (int16_t)(1200 + noise(2));
+    w.temp_cdeg = (int16_t)(3300 + noise(5));
+    if (random(200) == 0) w.flags ^= (uint8_t)(1 << random(3));
+    telem_wire_seal(&w);
+    r.t_ms = t;
+    r.kind = LOG_TELEM;
+    r.dev = 0;
+    r.telem = w;
+    return r;
+  }
+};
+
+static bool append(SessionLog& log, const LogRecord& r) {
+  return r.kind == LOG_TELEM ? log.telem(r.t_ms, r.dev, r.telem) : log.posture(r.t_ms, r.dev, r.posture);
+}
+
+static bool same(const LogEvent& a, const LogEvent& b) {
+  return a.type == b.type && a.a == b.a && a.b == b.b && a.boot == b.boot && a.up_ms == b.up_ms &&
+         a.at_ms == b.at_ms;
+}
+
+static bool same(const LogRecord& a, const LogRecord& b) {
+  if (a.t_ms != b.t_ms || a.kind != b.kind || a.dev != b.dev) return false;
+  if (a.kind == LOG_EVENT) return same(a.event, b.event);
+  return a.kind == LOG_TELEM ? !memcmp(&a.telem, &b.telem, sizeof(a.telem))
+                             : !memcmp(&a.posture, &b.posture, sizeof(a.posture));
+}
+
+// Writes n records into a fresh log and returns them
+static std::vector<LogRecord> fill(SessionLog& log, Gen& g, size_t n) {
+  std::vector<LogRecord> in;
+  for (size_t i = 0; i < n; i++) {
+    LogRecord r = g.next();
+    append(log, r);
+    log.poll(r.t_ms);
+    in.push_back(r);
+  }
+  return in;
+}
+
+static std::vector<LogRecord> readAll(const SessionLog& log, uint64_t from = 0, uint64_t to = UINT64_MAX,
+                                      int dev = -1, uint32_t* blocks = nullptr) {
+  std::vector<LogRecord> out;
+  LogRecord r;
+  LogReader reader(log);
+  reader.seek(from, to, dev);
+  while (reader.next(r)) out.push_back(r);
+  if (blocks) *blocks = reader.blocksRead();
+  return out;
+}
+
+/* ===== Scratch directories ===== */
+
+static std::string base;
+
+static std::string scratch(const char* name) {
+  std::string d = base + "/" + name;
+  mkdir(d.c_str(), 0775);
+  return d;
+}
+
+static void clear(const std::string& dir) {
+  DIR* d = opendir(dir.c_str());
+  if (!d) return;
+  struct dirent* e;
+  while ((e = readdir(d)) != nullptr) {
+    if (e->d_name[0] != '.') remove((dir + "/" + e->d_name).c_str());
+  }
+  closedir(d);
+}
+
+static void copyDir(const std::string& from, const std::string& to) {
+  clear(to);
+  DIR* d = opendir(from.c_str());
+  struct dirent* e;
+  char buf[4096];
+  while ((e = readdir(d)) != nullptr) {
+    if (e->d_name[0] == '.') continue;
+    FILE* a = fopen((from + "/" + e->d_name).c_str(), "rb");
+    FILE* b = fopen((to + "/" + e->d_name).c_str(), "wb");
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), a)) > 0) fwrite(buf, 1, n, b);
+    fclose(a);
+    fclose(b);
+  }
+  closedir(d);
+}
+
+static uint64_t dirBytes(const std::string& dir) {
+  uint64_t n = 0;
+  DIR* d = opendir(dir.c_str());
+  struct dirent* e;
+  struct stat st;
+  while ((e = readdir(d)) != nullptr) {
+    if (e->d_name[0] != '.' && stat((dir + "/" + e->d_name).c_str(), &st) == 0) n += st.st_size;
+  }
+  closedir(d);
+  return n;
+}
+
+static long fileSize(const char* p) {
+  struct stat st;
+  return stat(p, &st) == 0 ? (long)st.st_size : -1;
+}
+
+// Blocks of a segment as its index lists them, with their record counts
+struct BlockInfo {
+  uint32_t off;
+  uint32_t end;
+  uint16_t count;
+  uint64_t t0, t1;
+};
+
+static std::vector<BlockInfo> blocksOf(const SessionLog& log, int i) {
+  std::vector<BlockInfo> v;
+  char p[64], q[64];
+  log.path(p, sizeof(p), log.segment(i).seq, "idx");
+  log.path(q, sizeof(q), log.segment(i).seq, "seg");
+  FILE* idx = fopen(p, "rb");
+  FILE* seg = fopen(q, "rb");
+  LogIndexEntry e;
+  LogBlockHeader h;
+  while (idx && seg && fread(&e, sizeof(e), 1, idx) == 1) {
+    fseek(seg, e.off, SEEK_SET);
+    if (fread(&h, sizeof(h), 1, seg) != 1) break;
+    BlockInfo b = {e.off, (uint32_t)(e.off + sizeof(h) + h.len), h.count, e.t0_ms, e.t0_ms + e.span_ms};
+    v.push_back(b);
+  }
+  if (idx) fclose(idx);
+  if (seg) fclose(seg);
+  return v;
+}
+
+static double now() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#define EXPECT(cond)                                \
+  do {                                              \
+    if (!(cond) && !why) why = #cond;               \
+  } while (0)
+
+static int report(const char* name, const char* result, const char* why) {
+  printf("%-12s %-52s %s%s\n", name, result, why ? "FAIL: " : "", why ? why : "");
+  return why != nullptr;
+}
+
+/* ===== Scenarios ===== */
+
+// Two hours: every record back as written, and the size on flash
+static int format() {
+  const char* why = nullptr;
+  char res[96];
+  std::string dir = scratch("format");
+  SessionLog log(dir.c_str());
+  Gen g;
+
+  EXPECT(log.begin(8u << 20));
+  std::vector<LogRecord> in = fill(log, g, 2 * 3600 * 20);
+  EXPECT(log.flush());
+  std::vector<LogRecord> out = readAll(log);
+  EXPECT(out.size() == in.size());
+  for (size_t i = 0; i < in.size() && i < out.size() && !why; i++) EXPECT(same(in[i], out[i]));
+
+  LogStats st = log.stats();
+  uint64_t disk = dirBytes(dir);
+  EXPECT(st.writeErrors == 0 && st.dropped == 0);
+  EXPECT(disk == log.bytes());
+  // Delta coding: well under half of the raw records, index included
+  EXPECT(disk * 2 < st.rawBytes);
+  for (int i = 0; i < log.segments(); i++) {
+    EXPECT(log.segment(i).size <= SessionLog::SEGMENT_BYTES);
+  }
+  snprintf(res, sizeof(res), "%zu records, %.2f B each, %.1f%% of raw, %d segments", in.size(),
+           (double)disk / in.size(), 100.0 * disk / st.rawBytes, log.segments());
+  return report("format", res, why);
+}
+
+// Random ranges: the records of a plain filter, from the blocks in range
+static int seek() {
+  const char* why = nullptr;
+  char res[96];
+  std::string dir = scratch("seek");
+  SessionLog log(dir.c_str());
+  Gen g;
+
+  log.begin(8u << 20);
+  std::vector<LogRecord> in = fill(log, g, 3600 * 20);
+  log.flush();
+
+  std::vector<BlockInfo> blocks;
+  for (int i = 0; i < log.segments(); i++) {
+    std::vector<BlockInfo> b = blocksOf(log, i);
+    blocks.insert(blocks.end(), b.begin(), b.end());
+  }
+  uint64_t span = in.back().t_ms - in.front().t_ms;
+  uint32_t readSum = 0, worst = 0;
+  const int QUERIES = 300;
+  for (int q = 0; q < QUERIES && !why; q++) {
+    uint64_t from = in.front().t_ms - 5000 + g.random((uint32_t)span + 10000);
+    uint64_t to = from + 1 + g.random(q % 3 ? 60000 : 1800000);
+    int dev = (int)g.random(4) - 1;
+    uint32_t read;
+    std::vector<LogRecord> got = readAll(log, from, to, dev, &read);
+
+    std::vector<LogRecord> want;
+    for (size_t i = 0; i < in.size(); i++) {
+      if (in[i].t_ms >= from && in[i].t_ms < to && (dev < 0 || in[i].dev == dev)) want.push_back(in[i]);
+    }
+    EXPECT(got.size() == want.size());
+    for (size_t i = 0; i < got.size() && i < want.size() && !why; i++) EXPECT(same(got[i], want[i]));
+
+    uint32_t overlap = 0;
+    for (size_t i = 0; i < blocks.size(); i++) overlap += blocks[i].t0 < to && blocks[i].t1 >= from;
+    EXPECT(read <= overlap);
+    readSum += read;
+    if (read > worst) worst = read;
+  }
+  // Nothing before the first record, after the last, or in an empty range
+  EXPECT(readAll(log, 0, in.front().t_ms).empty());
+  EXPECT(readAll(log, in.back().t_ms + 1).empty());
+  EXPECT(readAll(log, in[100].t_ms, in[100].t_ms).empty());
+
+  snprintf(res, sizeof(res), "%d ranges, %.1f of %zu blocks read on average, %u at most", QUERIES,
+           (double)readSum / QUERIES, blocks.size(), worst);
+  return report("seek", res, why);
+}
+
+// Damage the newest segment like an interrupted append and reopen
+static int recovery() {
+  const char* why = nullptr;
+  char res[96];
+  std::string clean = scratch("recovery");
+  std::string dir = scratch("recovery.cut");
+  std::vector<LogRecord> in;
+  std::vector<BlockInfo> blocks;
+  uint32_t seq;
+  Gen g;
+  {
+    SessionLog log(clean.c_str());
+    log.begin(8u << 20);
+    in = fill(log, g, 20 * 60 * 20);
+    log.flush();
+    blocks = blocksOf(log, log.segments() - 1);
+    seq = log.segment(log.segments() - 1).seq;
+  }
+  // Records before the newest segment
+  size_t before = in.size();
+  for (size_t i = 0; i < blocks.size(); i++) before -= blocks[i].count;
+
+  const int TRIALS = 200;
+  int torn = 0;
+  for (int trial = 0; trial < TRIALS && !why; trial++) {
+    copyDir(clean, dir);
+    char seg[256], idx[256];
+    snprintf(seg, sizeof(seg), "%s/%08x.seg", dir.c_str(), seq);
+    snprintf(idx, sizeof(idx), "%s/%08x.idx", dir.c_str(), seq);
+    long size = fileSize(seg);
+    long cut = size;
+    int mode = trial % 4;
+
+    if (mode == 0) {
+      // Power lost during the write: the segment ends anywhere
+      cut = g.random((uint32_t)size);
+      truncate(seg, cut);
+    } else if (mode == 1) {
+      // A flipped byte somewhere
+      cut = g.random((uint32_t)size);
+      FILE* f = fopen(seg, "r+b");
+      fseek(f, cut, SEEK_SET);
+      int c = fgetc(f);
+      fseek(f, cut, SEEK_SET);
+      fputc(c ^ (1 << g.random(8)), f);
+      fclose(f);
+    } else if (mode == 2) {
+      // Half an index entry, or none for the last block
+      truncate(idx, fileSize(idx) - 1 - g.random(sizeof(LogIndexEntry) + 4));
+    } else {
+      // Garbage after the last block
+      FILE* f = fopen(seg, "ab");
+      for (uint32_t i = 0, n = 1 + g.random(200); i < n; i++) fputc((int)g.random(256), f);
+      fclose(f);
+    }
+
+    // Every block ending at or before the damage survives
+    size_t keep = before;
+    for (size_t i = 0; i < blocks.size() && (long)blocks[i].end <= cut; i++) keep += blocks[i].count;
+
+    std::vector<LogRecord> more;
+    {
+      SessionLog log(dir.c_str());
+      EXPECT(log.begin(8u << 20));
+      torn += log.stats().torn;
+      std::vector<LogRecord> got = readAll(log);
+      EXPECT(got.size() == keep);
+      for (size_t i = 0; i < got.size() && !why; i++) EXPECT(same(got[i], in[i]));
+      EXPECT(got.empty() || log.lastTime() == got.back().t_ms);
+
+      // Appending goes on after what survived
+      Gen h = g;
+      h.t = in.back().t_ms + 1000;
+      more = fill(log, h, 200);
+    }
+    SessionLog log(dir.c_str());
+    EXPECT(log.begin(8u << 20));
+    EXPECT(log.stats().torn == 0);
+    std::vector<LogRecord> got = readAll(log);
+    EXPECT(got.size() == keep + more.size());
+    for (size_t i = 0; i < more.size() && keep + i < got.size() && !why; i++) {
+      EXPECT(same(got[keep + i], more[i]));
+    }
+  }
+  snprintf(res, sizeof(res), "%d damaged copies, %d torn tails skipped", TRIALS, torn);
+  return report("recovery", res, why);
+}
+
+// Six hours into 256 KiB: under the cap, the newest records, no gaps
+static int retention() {
+  const char* why = nullptr;
+  char res[96];
+  const uint64_t CAP = 256 * 1024;
+  std::string dir = scratch("retention");
+  SessionLog log(dir.c_str());
+  Gen g;
+
+  log.begin(CAP);
+  std::vector<LogRecord> in = fill(log, g, 6 * 3600 * 20);
+  log.flush();
+  uint64_t disk = dirBytes(dir);
+  EXPECT(log.bytes() <= CAP && disk <= CAP);
+  EXPECT(log.stats().dropped > 0);
+
+  std::vector<LogRecord> got = readAll(log);
+  size_t skip = in.size() - got.size();
+  EXPECT(!got.empty() && got.size() < in.size());
+  for (size_t i = 0; i < got.size() && !why; i++) EXPECT(same(got[i], in[skip + i]));
+  EXPECT(log.segment(0).t0_ms == got.front().t_ms);
+
+  // The same after a restart, with the cap lowered
+  SessionLog again(dir.c_str());
+  EXPECT(again.begin(CAP / 2));
+  EXPECT(again.bytes() <= CAP / 2 && dirBytes(dir) <= CAP / 2);
+
+  snprintf(res, sizeof(res), "%llu bytes kept, newest %.1f of %.1f h, %u segments dropped",
+           (unsigned long long)disk, (got.back().t_ms - got.front().t_ms) / 3.6e6,
+           (in.back().t_ms - in.front().t_ms) / 3.6e6, log.stats().dropped);
+  return report("retention", res, why);
+}
+
+/* ===== Patch journal ===== */
+
+// The patch end of a journal sync (Firmware_Code/src/journal.c) without
+// the flash: records packed into entries, the oldest entries rotated out
+// past CAPACITY. Every event record carries a serial number (id) in a
+// field the decoder gives back as is.
+struct PatchModel {
+  static const size_t ENTRY = 224;      // CONFIG_NECK_JOURNAL_ENTRY_MAX
+  static const size_t CAPACITY = 40;    // entries in flash
+  struct Entry {
+    uint32_t seq;
+    std::vector<uint8_t> data;
+  };
+  std::vector<Entry> entries;
+  std::vector<uint8_t> cur;             // entry in RAM
+  uint32_t prev = 0;
+  uint32_t nextSeq = 0;
+  uint32_t synced = 0;
+  uint16_t boot = 1;
+  uint32_t up = 0;                      // ms since boot
+  uint64_t wall = T0;                   // true time of the patch
+  std::map<uint16_t, uint64_t> bootWall;
+  int32_t id = 0;
+  std::set<int32_t> gone;               // ids rotated out, or in RAM at a reset
+
+  PatchModel() { bootWall[boot] = wall; }
+
+  static int32_t idOf(const jrnl_rec& r) { return r.type == JRNL_DWELL ? (int32_t)r.a : r.b; }
+
+  void add(const jrnl_rec& r) {
+    uint8_t b[JRNL_REC_MAX];
+    size_t n;
+    if (!cur.empty() && cur.size() + jrnl_rec_encode(b, &r, prev) > ENTRY) commit();
+    if (cur.empty()) {
+      jrnl_entry_hdr h = {JRNL_VERSION, 0, boot, 0, r.t_ms};
+      cur.assign((uint8_t*)&h, (uint8_t*)&h + sizeof(h));
+      prev = r.t_ms;
+    }
+    n = jrnl_rec_encode(b, &r, prev);
+    cur.insert(cur.end(), b, b + n);
+    prev = r.t_ms;
+  }
+
+  void forget(const std::vector<uint8_t>& e) {
+    jrnl_rec r;
+    size_t pos = sizeof(jrnl_entry_hdr);
+    uint32_t t = 0;
+    while (jrnl_rec_decode(e.data(), e.size(), &pos, &t, &r) > 0) {
+      if (r.type != JRNL_CLOCK && r.type != JRNL_SYNCED) gone.insert(idOf(r));
+    }
+  }
+
+  void commit() {
+    if (cur.empty()) return;
+    jrnl_entry_hdr h;
+    memcpy(&h, cur.data(), sizeof(h));
+    h.seq = nextSeq++;
+    memcpy(cur.data(), &h, sizeof(h));
+    entries.push_back(Entry{h.seq, cur});
+    cur.clear();
+    while (entries.size() > CAPACITY) {
+      forget(entries.front().data);
+      entries.erase(entries.begin());
+    }
+  }
+
+  void event(Gen& g) {
+    uint32_t dt = 1 + g.random(g.random(4) ? 20000 : 600000);
+    up += dt;
+    wall += dt;
+    jrnl_rec r = {(uint8_t)(JRNL_POSTURE + g.random(4)), up, 0, 0};
+    r.a = r.type == JRNL_DWELL ? 0 : g.random(5);
+    if (r.type == JRNL_DWELL) {
+      r.a = ++id;
+    } else {
+      r.b = ++id;
+    }
+    add(r);
+  }
+
+  void reboot() {
+    if (!cur.empty()) forget(cur);      // lost with the RAM
+    cur.clear();
+    boot++;
+    up = 0;
+    wall += 5000;
+    bootWall[boot] = wall;
+  }
+
+  // One SYNC: the notifications it sends, as journal.c's sync_run()
+  void sync(const jrnl_req& q, size_t mtu, std::vector<std::vector<uint8_t> >& air) {
+    if (q.epoch_ms) add(jrnl_rec{JRNL_CLOCK, up, (int64_t)q.epoch_ms, 0});
+    commit();
+    size_t room = mtu - 3 - sizeof(jrnl_chunk);
+    uint32_t first = q.seq == JRNL_SEQ_UNSYNCED ? synced : q.seq;
+    uint16_t off = q.seq == JRNL_SEQ_UNSYNCED ? 0 : q.off;
+
+    uint16_t firstBoot = boot;
+    std::vector<jrnl_anchor> a;
+    for (size_t i = 0; i < entries.size(); i++) {
+      const std::vector<uint8_t>& e = entries[i].data;
+      jrnl_entry_hdr h;
+      jrnl_rec r;
+      memcpy(&h, e.data(), sizeof(h));
+      if (h.seq >= first && h.boot < firstBoot) firstBoot = h.boot;
+      size_t pos = sizeof(h);
+      uint32_t t = h.t0_ms;
+      while (jrnl_rec_decode(e.data(), e.size(), &pos, &t, &r) > 0) {
+        if (r.type == JRNL_CLOCK && (a.empty() || a.back().boot != h.boot)) {
+          a.push_back(jrnl_anchor{h.boot, r.a - (int64_t)r.t_ms});
+        }
+      }
+    }
+    size_t per = room / sizeof(jrnl_anchor);
+    std::vector<jrnl_anchor> send;
+    for (size_t i = 0; i < a.size(); i++) {
+      if (a[i].boot >= firstBoot) send.push_back(a[i]);
+    }
+    for (size_t i = 0; i < send.size(); i += per) {
+      size_t k = send.size() - i < per ? send.size() - i : per;
+      chunk(air, 0, 0, JRNL_LEN_ANCHORS, &send[i], k * sizeof(jrnl_anchor));
+    }
+    for (size_t i = 0; i < entries.size(); i++) {
+      const Entry& e = entries[i];
+      if (e.seq < first) continue;
+      size_t o = e.seq == first && off < e.data.size() ? off : 0;
+      while (o < e.data.size()) {
+        size_t n = e.data.size() - o < room ? e.data.size() - o : room;
+        chunk(air, e.seq, (uint16_t)o, (uint16_t)e.data.size(), &e.data[o], n);
+        o += n;
+      }
+    }
+    chunk(air, nextSeq, 0, JRNL_LEN_END, nullptr, 0);
+  }
+
+  void ack(uint32_t seq) {
+    if (seq <= synced || seq > nextSeq) return;
+    synced = seq;
+    add(jrnl_rec{JRNL_SYNCED, up, seq, 0});
+    commit();
+  }
+
+  static void chunk(std::vector<std::vector<uint8_t> >& air, uint32_t seq, uint16_t off, uint16_t len,
+                    const void* data, size_t n) {
+    jrnl_chunk c = {seq, off, len};
+    std::vector<uint8_t> v((uint8_t*)&c, (uint8_t*)&c + sizeof(c));
+    v.insert(v.end(), (const uint8_t*)data, (const uint8_t*)data + n);
+    air.push_back(v);
+  }
+};
+
+struct Delivered {
+  std::vector<LogEvent> events;
+};
+
+static void onJournalRecord(void* ctx, const jrnl_rec& r, uint16_t boot, uint64_t at_ms) {
+  if (r.type == JRNL_CLOCK || r.type == JRNL_SYNCED) return;
+  LogEvent e = {r.type, (int32_t)r.a, r.b, boot, r.t_ms, at_ms};
+  static_cast<Delivered*>(ctx)->events.push_back(e);
+}
+
+// Connections of a few seconds between hours offline, over a link losing
+// LOSS percent of the notifications and of the writes; the last ones
+// lossless, to drain the journal
+static int journal() {
+  const char* why = nullptr;
+  char res[96];
+  const int SESSIONS = 400;
+  const uint32_t LOSS = 4;
+  const size_t MTUS[] = {23, 65, 185, 247};
+  Gen g;
+  PatchModel pm;
+  JournalSync js;
+  Delivered got;
+  uint32_t now = 0, notes = 0, cuts = 0;
+
+  js.attach(onJournalRecord, &got);
+  for (int s = 0; s < SESSIONS + 3 && !why; s++) {
+    bool last = s >= SESSIONS;
+    int offline = last ? 0 : (int)g.random(g.random(8) ? 60 : 400);
+    for (int i = 0; i < offline; i++) {
+      if (g.random(300) == 0) pm.reboot();
+      pm.event(g);
+    }
+    size_t mtu = MTUS[g.random(4)];
+    // The gateway's clock, when the browser has set it
+    uint64_t epoch = g.random(10) < 7 ? pm.wall : 0;
+    uint32_t loss = last ? 0 : LOSS;
+    std::vector<std::vector<uint8_t> > air;
+    std::vector<jrnl_req> reqs;
+    size_t next = 0;
+    jrnl_req q = js.begin(now, epoch);
+    if (g.random(100) >= loss) reqs.push_back(q);
+
+    for (int steps = 0; steps < 100000; steps++) {
+      if (next == air.size() && !reqs.empty()) {
+        q = reqs.front();
+        reqs.erase(reqs.begin());
+        air.clear();
+        next = 0;
+        if (q.op == JRNL_OP_SYNC) {
+          pm.sync(q, mtu, air);
+        } else {
+          pm.ack(q.seq);
+        }
+        continue;
+      }
+      if (next == air.size()) {
+        if (!js.active()) break;
+        now += JournalSync::TIMEOUT_MS;
+        if (js.poll(now, q) && g.random(100) >= loss) reqs.push_back(q);
+        continue;
+      }
+      const std::vector<uint8_t>& c = air[next++];
+      now += 8;
+      if (!last && g.random(400) == 0) {
+        js.disconnected();
+        cuts++;
+        break;
+      }
+      if (g.random(100) < loss) continue;
+      notes++;
+      if (js.onChunk(c.data(), c.size(), now, q) && g.random(100) >= loss) reqs.push_back(q);
+    }
+    EXPECT(last ? !js.active() : true);
+    now += 60000;
+  }
+
+  // Once each, in order; the missing ones gone from the patch before they
+  // came
+  std::set<int32_t> seen;
+  int32_t prevId = 0;
+  uint32_t walled = 0;
+  for (size_t i = 0; i < got.events.size() && !why; i++) {
+    const LogEvent& e = got.events[i];
+    int32_t id = e.type == JRNL_DWELL ? e.a : e.b;
+    EXPECT(id > prevId);
+    prevId = id;
+    seen.insert(id);
+    if (e.at_ms) {
+      EXPECT(e.at_ms == pm.bootWall[e.boot] + e.up_ms);
+      walled++;
+    }
+  }
+  uint32_t lost = 0;
+  for (int32_t id = 1; id <= pm.id && !why; id++) {
+    if (seen.count(id)) continue;
+    EXPECT(pm.gone.count(id));
+    lost++;
+  }
+  JournalStats st = js.stats();
+  EXPECT(st.bad == 0);
+  EXPECT(!got.events.empty() && walled > 0);
+
+  // Through the log: logged on arrival, each with its own time
+  std::string dir = scratch("journal");
+  SessionLog log(dir.c_str());
+  uint64_t t = pm.wall;
+  char line[160];
+  size_t csv = 0;
+  EXPECT(log.begin(8u << 20));
+  for (size_t i = 0; i < got.events.size(); i++) {
+    log.event(t + i * 10, (uint8_t)(i % 3), got.events[i]);
+    log.poll(t + i * 10);
+  }
+  EXPECT(log.flush());
+  std::vector<LogRecord> out = readAll(log);
+  EXPECT(out.size() == got.events.size());
+  for (size_t i = 0; i < out.size() && i < got.events.size() && !why; i++) {
+    EXPECT(out[i].kind == LOG_EVENT && out[i].t_ms == t + i * 10 && same(out[i].event, got.events[i]));
+    size_t n = logCsv(out[i], line, sizeof(line));
+    EXPECT(n > 0 && strstr(line, ",journal,") != nullptr);
+    csv += n;
+  }
+  if (verbose) {
+    printf("    %u notifications in, %u cuts, %u transfers, %u resumes, %u timeouts, %u dups\n", notes, cuts,
+           st.transfers, st.resumes, st.timeouts, st.dups);
+    printf("    %d records made, %zu delivered, %u gone first (%u entries skipped), %u with wall time\n",
+           pm.id, got.events.size(), lost, st.gaps, walled);
+    printf("    %.2f B per record in the log, %.1f B of CSV\n", (double)log.bytes() / out.size(),
+           (double)csv / out.size());
+  }
+
+  snprintf(res, sizeof(res), "%zu records once each, %u gone first, %u resumes, %u timeouts",
+           got.events.size(), lost, st.resumes, st.timeouts);
+  return report("journal", res, why);
+}
+
+static int throughput() {
+  const char* why = nullptr;
+  char res[96];
+  char line[160];
+  std::string dir = scratch("throughput");
+  SessionLog log(dir.c_str());
+  Gen g;
+  const size_t N = 4 * 3600 * 20;
+  std::vector<LogRecord> in;
+
+  for (size_t i = 0; i < N; i++) in.push_back(g.next());
+  log.begin(64u << 20);
+  double a = now();
+  for (size_t i = 0; i < N; i++) append(log, in[i]);
+  log.flush();
+  double b = now();
+
+  LogReader rd(log);
+  LogRecord r;
+  size_t n = 0, csv = 0;
+  rd.seek(0, UINT64_MAX);
+  while (rd.next(r)) n++;
+  double c = now();
+  rd.seek(0, UINT64_MAX);
+  while (rd.next(r)) csv += logCsv(r, line, sizeof(line));
+  double d = now();
+
+  EXPECT(n == N);
+  // One block buffer and the delta state, no segment in RAM
+  EXPECT(sizeof(LogReader) < 2048);
+  snprintf(res, sizeof(res), "write %.0fk/s, read %.0fk/s, csv %.1f MB/s, reader %zu B",
+           N / (b - a) / 1e3, N / (c - b) / 1e3, csv / (d - c) / 1e6, sizeof(LogReader));
+  if (verbose) printf("    %zu bytes of CSV for %zu records\n", csv, n);
+  return report("throughput", res, why);
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-v")) {
+      verbose = true;
+    } else if (!strcmp(argv[i], "-k")) {
+      keep = true;
+    } else {
+      fprintf(stderr, "usage: %s [-v] [-k]\n", argv[0]);
+      return 2;
+    }
+  }
+  char tmpl[] = "/tmp/log_check.XXXXXX";
+  if (!mkdtemp(tmpl)) {
+    perror("mkdtemp");
+    return 2;
+  }
+  base = tmpl;
+
+  int failed = 0;
+  failed |= format();
+  failed |= seek();
+  failed |= recovery();
+  failed |= retention();
+  failed |= journal();
+  failed |= throughput();
+
+  if (keep) {
+    printf("kept %s\n", base.c_str());
+  } else {
+    const char* dirs[] = {"format", "seek", "recovery", "recovery.cut", "retention", "journal", "throughput"};
+    for (size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+      clear(base + "/" + dirs[i]);
+      rmdir((base + "/" + dirs[i]).c_str());
+    }
+    rmdir(base.c_str());
+  }
+  return failed;
+}
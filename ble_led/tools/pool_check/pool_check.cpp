@@ -0,0 +1,619 @@
+/*
+ * Run lib/ble_link/link_pool.cpp against a mocked radio with several
+ * patches in virtual time and measure command latency as their number
+ * grows.
+ *
+ *   pool_check [-v]
+ *
+ * The mock radio keeps one connection per slot and gives each a connection
+ * event every interval, in 1.25 ms units. An event carries up to
+ * FRAMES_PER_EVENT queued writes and the patch's ACK notification: one
+ * in any case, more as their air time (1M PHY) allows before the next
+ * connection's anchor. An event that falls into another one is skipped,
+ * and of two due at once the one that skipped more goes first. Writes
+ * hold one of ACL_BUFFERS buffers shared by all connections until their
+ * event. New connections are anchored back to back after the ones
+ * already scheduled. Each patch runs the receiver from
+ * shared/cmd_proto.h. Connect and discovery take no time. The BLE task
+ * steps the pool when the radio has news for it and every 50 ms
+ * otherwise.
+ *
+ * The sweep connects N = 1..8 patches, with and without the interval
+ * spreading, posts a command to every patch about every 50 ms and reports
+ * the post-to-apply latency and the events skipped; then, with every
+ * command queue kept full, the Jain fairness index of the commands applied
+ * per patch. The other scenarios cover admission up to the slot count,
+ * forgetting and reusing a slot, reconnecting a saved table, and one
+ * patch flooded with commands next to quiet ones. Every command has to be
+ * applied exactly once and in order.
+ * Exit status is 1 if any scenario fails.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "link_pool.h"
+
+static const uint32_t TICK_US = 1250;
+static const int FRAMES_PER_EVENT = 4;
+static const int ACL_BUFFERS = 12;
+// Radio time the controller reserves per connection when anchoring a new
+// one; the pool's interval share is sized to match
+static const uint32_t ANCHOR_TICKS = LinkPool::ITVL_PER_LINK;
+static const uint32_t WAKE_TICKS = 40;           // BLE task timeout, 50 ms
+static const uint32_t ADV_TICKS = 80;            // advertising interval, 100 ms
+static const uint32_t SUPERVISION_TICKS = 3200;  // 4 s, CONN_TIMEOUT in main.cpp
+static const uint32_t POST_TICKS = 40;           // mean gap between commands per patch
+static const size_t PAYLOAD = 244;
+
+static bool verbose;
+
+struct Patch {
+  char addr[18];
+  bool present = true;
+  int slot = -1;            // connected in this slot
+  uint16_t itvl = 0;
+  uint32_t next = 0;        // tick of the next connection event
+  uint32_t missed = 0;      // events skipped in a row
+  uint32_t advAt = 0;
+  cmdp_rx rx;
+  std::vector<std::vector<uint8_t>> air;    // written, waiting for an event
+};
+
+class MockRadio : public PoolRadio {
+ public:
+  LinkPool* pool = nullptr;
+  std::vector<Patch> patches;
+  uint32_t tick = 0;
+  bool woken = false;
+
+  // ---- Observed, per slot ----
+  std::vector<uint32_t> postedAt[LinkPool::MAX_SLOTS];  // by command id
+  std::vector<uint32_t> applied[LinkPool::MAX_SLOTS];   // command ids, in order
+  std::vector<double> latMs[LinkPool::MAX_SLOTS];
+  bool measure = false;
+  uint32_t events = 0;
+  uint32_t skipped = 0;
+  uint32_t timeouts = 0;
+  uint32_t noBuffer = 0;
+
+  MockRadio() {
+    for (int i = 0; i < LinkPool::MAX_SLOTS; i++) peer_[i] = -1;
+  }
+
+  void add(int n) {
+    for (int i = 0; i < n; i++) {
+      Patch p;
+      snprintf(p.addr, sizeof(p.addr), "c0:ff:ee:00:00:%02x", (unsigned)patches.size() + 1);
+      p.advAt = (uint32_t)patches.size() * 7;
+      patches.push_back(p);
+    }
+  }
+
+  Patch* at(int slot) { return peer_[slot] < 0 ? nullptr : &patches[peer_[slot]]; }
+
+  bool startScan(uint32_t ms) override {
+    scanning_ = true;
+    scanEnd_ = tick + ms * 1000 / TICK_US;
+    return true;
+  }
+  void stopScan() override { scanning_ = false; }
+
+  bool connect(int slot, const char* addr, uint8_t /*addrType*/, uint16_t itvl) override {
+    int i = find(addr);
+    if (i < 0 || !patches[i].present || patches[i].slot >= 0) return false;
+
+    // Back to back with the last connection scheduled
+    uint32_t anchor = tick + 1;
+    for (size_t k = 0; k < patches.size(); k++) {
+      const Patch& q = patches[k];
+      if (q.slot >= 0 && q.next + ANCHOR_TICKS > anchor) anchor = q.next + ANCHOR_TICKS;
+    }
+    Patch& p = patches[i];
+    p.slot = slot;
+    p.itvl = itvl;
+    p.next = anchor;
+    p.missed = 0;
+    cmdp_rx_init(&p.rx);
+    peer_[slot] = i;
+    if (verbose) printf("    %7.1f ms  slot %d: %s at %.2f ms\n", ms(), slot, addr, itvl * 1.25);
+    return true;
+  }
+  bool retune(int slot, uint16_t itvl) override {
+    Patch* p = at(slot);
+    if (!p) return false;
+    p->itvl = itvl;
+    return true;
+  }
+  bool discover(int slot) override { return at(slot) != nullptr; }
+  void disconnect(int slot) override {
+    if (at(slot)) drop(slot);       // NimBLE reports our own disconnects too
+  }
+  bool write(int /*slot*/, uint8_t /*value*/) override { return false; }
+  bool stream(int /*slot*/, bool /*on*/) override { return true; }
+  bool framed(int slot) override { return at(slot) != nullptr; }
+  size_t payload(int /*slot*/) override { return PAYLOAD; }
+  bool writeFrame(int slot, const uint8_t* buf, size_t len) override {
+    Patch* p = at(slot);
+    if (!p || len > PAYLOAD) return false;
+    if (buffers_ == 0) {
+      noBuffer++;
+      return false;
+    }
+    buffers_--;
+    p->air.push_back(std::vector<uint8_t>(buf, buf + len));
+    return true;
+  }
+
+  // The patch switches off
+  void leave(int i) {
+    patches[i].present = false;
+    if (patches[i].slot >= 0) drop(patches[i].slot);
+  }
+
+  // Controller and NimBLE host task side of one tick
+  void run() {
+    tick++;
+
+    // Due connection events; a busy radio skips them
+    int win = -1;
+    for (size_t i = 0; i < patches.size(); i++) {
+      Patch& p = patches[i];
+      if (p.slot < 0 || p.next > tick) continue;
+      if (tick < busyUntil_) {
+        skip((int)i);
+      } else if (win < 0 || p.missed > patches[win].missed) {
+        if (win >= 0) skip(win);
+        win = (int)i;
+      } else {
+        skip((int)i);
+      }
+    }
+    if (win >= 0) event(win);
+
+    if (!scanning_) return;
+    for (size_t i = 0; i < patches.size(); i++) {
+      Patch& p = patches[i];
+      if (p.present && p.slot < 0 && tick >= p.advAt) {
+        p.advAt = tick + ADV_TICKS;
+        pool->onAdvert(p.addr, 1);
+        woken = true;
+      }
+    }
+    if (tick >= scanEnd_) {
+      scanning_ = false;
+      pool->onScanDone();
+      woken = true;
+    }
+  }
+
+  double ms() const { return tick * (TICK_US / 1000.0); }
+
+ private:
+  struct Apply {
+    MockRadio* radio;
+    int slot;
+  };
+
+  // The patch applies a command: its id is in the first four bytes
+  static int apply(uint8_t /*type*/, const uint8_t* val, uint8_t /*len*/, void* ctx) {
+    Apply* a = static_cast<Apply*>(ctx);
+    MockRadio* r = a->radio;
+    uint32_t id = val[0] | val[1] << 8 | val[2] << 16 | (uint32_t)val[3] << 24;
+    r->applied[a->slot].push_back(id);
+    if (r->measure && id < r->postedAt[a->slot].size()) {
+      r->latMs[a->slot].push_back((r->tick - r->postedAt[a->slot][id]) * (TICK_US / 1000.0));
+    }
+    return 0;
+  }
+
+  int find(const char* addr) const {
+    for (size_t i = 0; i < patches.size(); i++) {
+      if (!strcmp(patches[i].addr, addr)) return (int)i;
+    }
+    return -1;
+  }
+
+  void drop(int slot) {
+    Patch& p = patches[peer_[slot]];
+    buffers_ += (int)p.air.size();
+    p.air.clear();
+    p.slot = -1;
+    peer_[slot] = -1;
+    pool->link(slot).onDisconnected();
+    woken = true;
+  }
+
+  void skip(int i) {
+    Patch& p = patches[i];
+    p.next += p.itvl;
+    p.missed++;
+    skipped++;
+    if (p.missed * p.itvl >= SUPERVISION_TICKS) {
+      timeouts++;
+      drop(p.slot);
+    }
+  }
+
+  static uint32_t airUs(size_t len) { return (uint32_t)(len + 14) * 8 + 150 + 80 + 150; }
+
+  void event(int i) {
+    Patch& p = patches[i];
+    Apply a = {this, p.slot};
+    uint32_t room = UINT32_MAX;
+    uint32_t us = airUs(8);     // the patch's answer, with the ACK
+    size_t n = 0;
+
+    // The controller ends the event before the next connection's anchor
+    for (size_t k = 0; k < patches.size(); k++) {
+      const Patch& q = patches[k];
+      if (&q != &p && q.slot >= 0 && q.next > tick && (q.next - tick) * TICK_US < room) {
+        room = (q.next - tick) * TICK_US;
+      }
+    }
+    // The first one goes out at the anchor in any case
+    while (n < p.air.size() && n < (size_t)FRAMES_PER_EVENT &&
+           (n == 0 || us + airUs(p.air[n].size()) <= room)) {
+      us += airUs(p.air[n].size());
+      n++;
+    }
+
+    events++;
+    p.missed = 0;
+    for (size_t k = 0; k < n; k++) {
+      cmdp_rx_frame(&p.rx, p.air[k].data(), p.air[k].size(), apply, &a);
+    }
+    p.air.erase(p.air.begin(), p.air.begin() + n);
+    buffers_ += (int)n;
+
+    uint8_t ack[64];
+    size_t len = cmdp_rx_ack(&p.rx, ack, sizeof(ack));
+    if (len) {
+      pool->link(p.slot).onFrame(ack, len);
+      woken = true;
+    }
+    busyUntil_ = tick + (us + TICK_US - 1) / TICK_US;
+    p.next += p.itvl;
+  }
+
+  int peer_[LinkPool::MAX_SLOTS];
+  int buffers_ = ACL_BUFFERS;
+  uint32_t busyUntil_ = 0;
+  bool scanning_ = false;
+  uint32_t scanEnd_ = 0;
+};
+
+struct Rig {
+  MockRadio radio;
+  LinkPool pool;
+  uint32_t lastStep = 0;
+  uint32_t rng = 1;
+
+  Rig(int slots, int patches, bool spread = true) : pool(radio, slots) {
+    radio.pool = &pool;
+    radio.add(patches);
+    pool.setSpread(spread);
+  }
+
+  uint32_t now() const { return (uint32_t)((uint64_t)radio.tick * TICK_US / 1000); }
+  void start() { pool.start(now()); }
+
+  void run(uint32_t ticks) {
+    for (uint32_t t = 0; t < ticks; t++) {
+      radio.run();
+      if (radio.woken || radio.tick - lastStep >= WAKE_TICKS) {
+        radio.woken = false;
+        lastStep = radio.tick;
+        pool.step(now());
+      }
+    }
+  }
+
+  // Runs until n links are Ready; false after limit ms
+  bool runUntil(int n, uint32_t limitMs) {
+    uint32_t end = radio.tick + limitMs * 1000 / TICK_US;
+    while (pool.connected() != n && radio.tick < end) run(1);
+    return pool.connected() == n;
+  }
+
+  // Runs until every command posted was acknowledged
+  bool drain(uint32_t limitMs) {
+    uint32_t end = radio.tick + limitMs * 1000 / TICK_US;
+    for (;;) {
+      bool idle = true;
+      for (int s = 0; s < pool.slots(); s++) {
+        idle &= pool.link(s).stats().inflight == 0 &&
+                radio.applied[s].size() == radio.postedAt[s].size();
+      }
+      if (idle || radio.tick >= end) return idle;
+      run(1);
+    }
+  }
+
+  // A command with its id as the value, as the tuning page would post it
+  bool post(int slot) {
+    LinkCommand c = {LinkCommand::Send, CMDP_T_POSTURE, CMDP_POSTURE_LEN, {0}};
+    uint32_t id = (uint32_t)radio.postedAt[slot].size();
+    for (int i = 0; i < 4; i++) c.val[i] = (uint8_t)(id >> (8 * i));
+    if (!pool.command(slot, c)) return false;
+    radio.postedAt[slot].push_back(radio.tick);
+    radio.woken = true;
+    return true;
+  }
+
+  uint32_t random(uint32_t n) {
+    rng = rng * 1103515245u + 12345u;
+    return (rng >> 16) % n;
+  }
+
+  // Every patch gets a command about every POST_TICKS; slots in flood get
+  // as many as their queue takes. Returns the commands refused.
+  uint32_t load(uint32_t ticks, uint32_t flood) {
+    uint32_t next[LinkPool::MAX_SLOTS];
+    uint32_t refused = 0;
+    for (int s = 0; s < pool.slots(); s++) next[s] = radio.tick + random(POST_TICKS);
+    for (uint32_t t = 0; t < ticks; t++) {
+      for (int s = 0; s < pool.slots(); s++) {
+        if (!pool.link(s).ready()) continue;
+        if (flood >> s & 1) {
+          while (post(s)) {
+          }
+        } else if (radio.tick >= next[s]) {
+          refused += !post(s);
+          next[s] = radio.tick + POST_TICKS / 2 + random(POST_TICKS);
+        }
+      }
+      run(1);
+    }
+    return refused;
+  }
+
+  // Every command applied exactly once and in order, per slot
+  bool inOrder() const {
+    for (int s = 0; s < pool.slots(); s++) {
+      const std::vector<uint32_t>& a = radio.applied[s];
+      if (a.size() != radio.postedAt[s].size()) return false;
+      for (size_t i = 0; i < a.size(); i++) {
+        if (a[i] != i) return false;
+      }
+    }
+    return true;
+  }
+
+  // Latencies of the slots in mask, then cleared
+  std::vector<double> latencies(uint32_t mask) {
+    std::vector<double> all;
+    for (int s = 0; s < pool.slots(); s++) {
+      if (mask >> s & 1) all.insert(all.end(), radio.latMs[s].begin(), radio.latMs[s].end());
+      radio.latMs[s].clear();
+    }
+    std::sort(all.begin(), all.end());
+    return all;
+  }
+};
+
+static double pct(const std::vector<double>& v, double p) {
+  return v.empty() ? 0 : v[(size_t)(p * (v.size() - 1) + 0.5)];
+}
+
+static double jain(const std::vector<double>& x) {
+  double sum = 0, sq = 0;
+  for (size_t i = 0; i < x.size(); i++) {
+    sum += x[i];
+    sq += x[i] * x[i];
+  }
+  return sq > 0 ? sum * sum / (x.size() * sq) : 0;
+}
+
+#define EXPECT(cond)                                \
+  do {                                              \
+    if (!(cond) && !why) why = #cond;               \
+  } while (0)
+
+static int report(const char* name, Rig& r, const char* why) {
+  PoolStats st = r.pool.stats();
+  printf("%-18s %5d %8u %6u %5u %5u %7u %s%s\n", name, r.pool.connected(), st.admitted, st.full,
+         st.scans, st.retunes, r.radio.timeouts, why ? "FAIL: " : "", why ? why : "");
+  return why != nullptr;
+}
+
+/* ===== Sweep ===== */
+
+static int sweep(int n, bool spread) {
+  Rig r(LinkPool::MAX_SLOTS, n, spread);
+  const char* why = nullptr;
+  uint32_t all = (1u << n) - 1;
+
+  r.start();
+  EXPECT(r.runUntil(n, 30000));
+  r.run(400);
+
+  // Latency at a steady rate
+  r.radio.measure = true;
+  r.radio.skipped = 0;
+  r.radio.events = 0;
+  EXPECT(r.load(8000, 0) == 0);
+  EXPECT(r.drain(5000));
+  r.radio.measure = false;
+  std::vector<double> lat = r.latencies(all);
+  uint32_t skipped = r.radio.skipped;
+  uint32_t events = r.radio.events;
+
+  // Fair shares with every queue full
+  std::vector<size_t> before(n);
+  std::vector<double> got(n);
+  for (int s = 0; s < n; s++) before[s] = r.radio.applied[s].size();
+  r.load(1600, all);
+  for (int s = 0; s < n; s++) got[s] = (double)(r.radio.applied[s].size() - before[s]);
+  EXPECT(r.drain(10000));
+  double fair = jain(got);
+  double total = 0;
+  for (int s = 0; s < n; s++) total += got[s];
+
+  EXPECT(r.inOrder());
+  EXPECT(r.radio.timeouts == 0);
+  EXPECT(!spread || skipped == 0);
+  EXPECT(!spread || fair >= 0.95);
+  // Every command out within about one interval
+  EXPECT(!spread || pct(lat, 0.99) <= r.pool.interval(0) * 1.25 + 5);
+  // Without the spread and with events longer than the interval allows,
+  // the controller has to skip
+  EXPECT(spread || n < 6 || skipped > 0);
+
+  printf("%2d %-6s %7.2f %7.1f %7.1f %7.1f %6.1f%% %8.0f %6.3f %s%s\n", n, spread ? "on" : "off",
+         r.pool.interval(0) * 1.25, pct(lat, 0.5), pct(lat, 0.99), lat.empty() ? 0 : lat.back(),
+         events + skipped ? 100.0 * skipped / (events + skipped) : 0, total / 2, fair,
+         why ? "FAIL: " : "", why ? why : "");
+  return why != nullptr;
+}
+
+/* ===== Scenarios ===== */
+
+// Seven patches around, five slots: the first five get one each, in the
+// order seen, the rest are counted as turned away
+static int admission() {
+  Rig r(5, 7);
+  const char* why = nullptr;
+
+  r.start();
+  EXPECT(r.runUntil(5, 20000));
+  EXPECT(r.pool.stats().admitted == 5 && r.pool.stats().full > 0);
+  EXPECT(r.pool.tableVersion() == 5);
+  for (int s = 0; s < 5; s++) {
+    DeviceCfg d;
+    char label[24];
+    snprintf(label, sizeof(label), "patch %d", s + 1);
+    EXPECT(r.pool.device(s, d) && !strcmp(d.label, label));
+    EXPECT(r.radio.at(s) && !strcmp(r.radio.at(s)->addr, d.addr));
+    EXPECT(r.pool.find(d.addr) == s);
+  }
+  // Each gets its interval share
+  EXPECT(r.pool.interval(0) == 5 * LinkPool::ITVL_PER_LINK);
+  return report("admission", r, why);
+}
+
+// A patch goes away and is forgotten: its slot goes to the next newcomer
+// at the following discovery scan, and commands to it reach the new patch
+static int forgetReuse() {
+  Rig r(5, 7);
+  const char* why = nullptr;
+  DeviceCfg gone, now;
+
+  r.start();
+  EXPECT(r.runUntil(5, 20000));
+  r.pool.device(2, gone);
+  uint32_t v = r.pool.tableVersion();
+  for (size_t i = 0; i < r.radio.patches.size(); i++) {
+    if (r.radio.patches[i].slot == 2) r.radio.leave((int)i);
+  }
+  r.run(10);
+  EXPECT(r.pool.connected() == 4);
+  EXPECT(r.pool.forget(2));
+  r.radio.woken = true;     // as handleDevForget() does
+  r.run(1);
+  EXPECT(r.pool.find(gone.addr) < 0);
+  EXPECT(r.runUntil(5, LinkPool::DISCOVERY_MS + 2 * BleLink::SCAN_MS));
+  EXPECT(r.pool.device(2, now) && strcmp(now.addr, gone.addr) && !strcmp(now.label, "patch 3"));
+  EXPECT(r.pool.tableVersion() == v + 2 && r.pool.stats().admitted == 6);
+  EXPECT(r.pool.link(2).stats().connects == 1);
+
+  for (int i = 0; i < 20; i++) {
+    EXPECT(r.post(2));
+    r.run(1);
+  }
+  EXPECT(r.drain(2000));
+  EXPECT(r.inOrder());
+  return report("forget + reuse", r, why);
+}
+
+// A saved table on the next boot: every device back in its slot, nobody
+// new admitted
+static int saved() {
+  DeviceCfg cfg[LinkPool::MAX_SLOTS];
+  bool used[LinkPool::MAX_SLOTS];
+  const char* why = nullptr;
+  {
+    Rig first(5, 7);
+    first.start();
+    first.runUntil(5, 20000);
+    first.pool.setLabel(4, "left shoulder");
+    first.pool.table(cfg, used);
+  }
+  Rig r(5, 7);
+  r.pool.load(cfg, used, 5);
+  r.pool.setAutoAdmit(false);
+  r.start();
+  EXPECT(r.runUntil(5, 20000));
+  for (int s = 0; s < 5; s++) {
+    DeviceCfg d;
+    EXPECT(r.pool.device(s, d) && !strcmp(d.addr, cfg[s].addr));
+    EXPECT(r.radio.at(s) && !strcmp(r.radio.at(s)->addr, cfg[s].addr));
+  }
+  DeviceCfg d;
+  r.pool.device(4, d);
+  EXPECT(!strcmp(d.label, "left shoulder"));
+  EXPECT(r.pool.stats().admitted == 0 && r.pool.tableVersion() == 0);
+  return report("saved table", r, why);
+}
+
+// One patch flooded with commands (a slider dragged on the tuning page):
+// the others keep their latency, the flooded one still gets its share
+static int flood() {
+  Rig r(5, 5);
+  const char* why = nullptr;
+  uint32_t quiet = 0x1e;
+
+  r.start();
+  EXPECT(r.runUntil(5, 20000));
+  r.radio.measure = true;
+  r.load(4000, 0);
+  EXPECT(r.drain(5000));
+  std::vector<double> base = r.latencies(quiet);
+
+  size_t before = r.radio.applied[0].size();
+  r.load(4000, 1);
+  EXPECT(r.drain(10000));
+  std::vector<double> busy = r.latencies(quiet);
+  size_t flooded = r.radio.applied[0].size() - before;
+
+  // Within one connection interval of the quiet run
+  double itvlMs = r.pool.interval(1) * 1.25;
+  EXPECT(pct(busy, 0.99) <= pct(base, 0.99) + itvlMs);
+  EXPECT(flooded > 10 * busy.size() / 4);
+  EXPECT(r.inOrder());
+  if (verbose) {
+    printf("    p99 %.1f -> %.1f ms, %zu commands to the flooded patch\n", pct(base, 0.99),
+           pct(busy, 0.99), flooded);
+  }
+  return report("one flooded", r, why);
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-v")) {
+      verbose = true;
+    } else {
+      fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  int failed = 0;
+  printf("%2s %-6s %7s %7s %7s %7s %7s %8s %6s\n", "N", "spread", "itvl ms", "p50 ms", "p99 ms",
+         "max ms", "skipped", "cmds/s", "jain");
+  for (int n = 1; n <= LinkPool::MAX_SLOTS; n++) {
+    failed |= sweep(n, true);
+    failed |= sweep(n, false);
+  }
+
+  printf("\n%-18s %5s %8s %6s %5s %5s %7s\n", "scenario", "ready", "admitted", "full", "scans",
+         "tunes", "timeout");
+  failed |= admission();
+  failed |= forgetReuse();
+  failed |= saved();
+  failed |= flood();
+  return failed;
+}
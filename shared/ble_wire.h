@@ -0,0 +1,94 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BLE_WIRE_H_
+#define BLE_WIRE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "telem_wire.h"
+
+/* ===== Posture GATT service layout =====
+ *
+ * Little-endian, packed, no Zephyr headers: shared with host tools and the
+ * ESP32 gateway. The service and the command characteristic keep the UUIDs
+ * the gateway (ble_led) already looks for.
+ *
+ *   0000ffff  service
+ *   0000ff01  command      write / write w/o response: '1' '0' 'T'
+ *   0000ff02  posture      read / notify: struct ble_posture_wire
+ *   0000ff03  stream       notify: 1..n struct telem_wire per notification
+ *   0000ff04  params       read / write: struct ble_params_wire
+ *   0000ff05  profiler     read: struct ble_prof_wire per probe
+ *   0000ff06  protocol     write w/o response: command frames
+ *                          notify: ACK/NAK frames (shared/cmd_proto.h)
+ *   0000ff07  journal      write: struct jrnl_req
+ *                          notify: journal sync chunks (shared/journal_wire.h)
+ */
+#define BLE_UUID_SVC            0xFFFF
+#define BLE_UUID_CMD            0xFF01
+#define BLE_UUID_POSTURE        0xFF02
+#define BLE_UUID_STREAM         0xFF03
+#define BLE_UUID_PARAMS         0xFF04
+#define BLE_UUID_PROF           0xFF05
+#define BLE_UUID_PROTO          0xFF06
+#define BLE_UUID_JOURNAL        0xFF07
+
+/* Command bytes: force the cue LEDs on / release them / toggle */
+#define BLE_CMD_LED_ON          '1'
+#define BLE_CMD_LED_OFF         '0'
+#define BLE_CMD_LED_TOGGLE      'T'
+
+#define BLE_POSTURE_F_CUE       0x01    /* slouched, cue running */
+#define BLE_POSTURE_F_LRA       0x02
+#define BLE_POSTURE_F_PELTIER   0x04
+#define BLE_POSTURE_F_IMU_LP    0x08    /* IMU in low power, values stale */
+
+struct ble_posture_wire {
+    uint8_t state;          /* enum posture_state */
+    uint8_t event;          /* last enum posture_event raised */
+    uint8_t flags;          /* BLE_POSTURE_F_* */
+    int16_t pitch_cdeg;
+    int16_t dev_cdeg;       /* pitch - baseline */
+    uint32_t t_ms;          /* posture time base */
+} __attribute__((packed));
+
+_Static_assert(sizeof(struct ble_posture_wire) == 11, "posture wire size changed");
+
+#define BLE_PARAMS_VERSION      1
+
+/* Runtime-tunable posture parameters; the others stay at their Kconfig
+ * values. A write must carry the whole struct.
+ */
+struct ble_params_wire {
+    uint8_t version;        /* BLE_PARAMS_VERSION */
+    uint16_t enter_cdeg;
+    uint16_t exit_cdeg;     /* < enter_cdeg */
+    uint16_t enter_dwell_ms;
+    uint16_t exit_dwell_ms;
+    uint16_t alert_s;
+} __attribute__((packed));
+
+_Static_assert(sizeof(struct ble_params_wire) == 11, "params wire size changed");
+
+/* One profiler probe (src/prof.h), times in ns */
+struct ble_prof_wire {
+    uint8_t probe;
+    uint32_t count;
+    uint32_t min_ns;
+    uint32_t p50_ns;
+    uint32_t p99_ns;
+    uint32_t max_ns;
+} __attribute__((packed));
+
+_Static_assert(sizeof(struct ble_prof_wire) == 21, "profiler wire size changed");
+
+/* Stream records that fit one notification at the given ATT MTU */
+static inline size_t ble_stream_batch(uint16_t mtu)
+{
+    return mtu > 3 ? (size_t)(mtu - 3) / sizeof(struct telem_wire) : 0;
+}
+
+#endif /* BLE_WIRE_H_ */
@@ -0,0 +1,494 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CMD_PROTO_H_
+#define CMD_PROTO_H_
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* ===== Framed command protocol (gateway <-> patch) =====
+ *
+ * Header-only C, no platform headers: compiled into the patch firmware
+ * (Firmware_Code), the ESP32 gateway (ble_led, as C++) and the host tools.
+ *
+ * One frame is one GATT write without response (gateway -> patch) or one
+ * notification (patch -> gateway) on the protocol characteristic:
+ *
+ *   frame    version (CMDP_VERSION), then 1..n messages
+ *   message  seq, type, len, value[len]       little-endian values
+ *
+ * The gateway numbers its commands with an 8-bit sequence and packs as
+ * many as fit the ATT payload into one write. The patch applies them in
+ * sequence order, exactly once, and answers with one ACK for everything it
+ * received since the last one (cumulative: "next expected seq"), plus a NAK
+ * per command it rejected. A frame lost on the way shows up as a sequence
+ * gap: the patch drops what follows the gap and flags it in the ACK, and
+ * the gateway goes back to the first unacknowledged command (go-back-N).
+ * Without any ACK the gateway resends after CMDP_RTO_MS. Duplicates from
+ * resends are recognised by their sequence and acknowledged again, not
+ * applied. Both ends start again from seq 0 on every connection.
+ */
+
+#define CMDP_VERSION        1
+#define CMDP_HDR_LEN        1       /* version */
+#define CMDP_MSG_HDR_LEN    3       /* seq, type, len */
+#define CMDP_VAL_MAX        16      /* longest value of any command */
+
+/* Commands, gateway -> patch */
+#define CMDP_T_LED          0x01    /* u8 CMDP_LED_* */
+#define CMDP_T_POSTURE      0x02    /* struct cmdp_posture */
+#define CMDP_T_HAPTIC_PLAY  0x03    /* u8 pattern, u8 repeat */
+#define CMDP_T_HAPTIC_STOP  0x04    /* empty */
+#define CMDP_T_HAPTIC_CUE   0x05    /* u8 pattern */
+#define CMDP_T_SETPOINT     0x06    /* i16 Peltier setpoint, 0.01 degC */
+
+/* Replies, patch -> gateway (seq unused, 0) */
+#define CMDP_T_ACK          0x80    /* u8 next expected seq, u8 CMDP_ACK_F_* */
+#define CMDP_T_NAK          0x81    /* u8 seq, u8 errno of the rejected command */
+
+#define CMDP_LED_RELEASE    0       /* follow the posture again */
+#define CMDP_LED_ON         1
+#define CMDP_LED_TOGGLE     2
+
+#define CMDP_ACK_F_GAP      0x01    /* messages after a gap were dropped */
+
+struct cmdp_posture {
+    uint16_t enter_cdeg;
+    uint16_t exit_cdeg;     /* < enter_cdeg */
+    uint16_t enter_dwell_ms;
+    uint16_t exit_dwell_ms;
+    uint16_t alert_s;
+};
+
+#define CMDP_POSTURE_LEN    10
+
+/* Value length of a known type, -1 for an unknown one */
+static inline int cmdp_type_len(uint8_t type)
+{
+    switch (type) {
+    case CMDP_T_LED:
+    case CMDP_T_HAPTIC_CUE:
+        return 1;
+    case CMDP_T_HAPTIC_PLAY:
+    case CMDP_T_SETPOINT:
+    case CMDP_T_ACK:
+    case CMDP_T_NAK:
+        return 2;
+    case CMDP_T_HAPTIC_STOP:
+        return 0;
+    case CMDP_T_POSTURE:
+        return CMDP_POSTURE_LEN;
+    default:
+        return -1;
+    }
+}
+
+/* a comes before b in sequence space (window < 128) */
+static inline bool cmdp_seq_before(uint8_t a, uint8_t b)
+{
+    return (int8_t)(uint8_t)(a - b) < 0;
+}
+
+static inline uint16_t cmdp_get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline void cmdp_put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void cmdp_posture_encode(uint8_t *out, const struct cmdp_posture *pp)
+{
+    cmdp_put_u16(out + 0, pp->enter_cdeg);
+    cmdp_put_u16(out + 2, pp->exit_cdeg);
+    cmdp_put_u16(out + 4, pp->enter_dwell_ms);
+    cmdp_put_u16(out + 6, pp->exit_dwell_ms);
+    cmdp_put_u16(out + 8, pp->alert_s);
+}
+
+static inline void cmdp_posture_decode(struct cmdp_posture *pp, const uint8_t *in)
+{
+    pp->enter_cdeg = cmdp_get_u16(in + 0);
+    pp->exit_cdeg = cmdp_get_u16(in + 2);
+    pp->enter_dwell_ms = cmdp_get_u16(in + 4);
+    pp->exit_dwell_ms = cmdp_get_u16(in + 6);
+    pp->alert_s = cmdp_get_u16(in + 8);
+}
+
+/* ===== Codec ===== */
+
+struct cmdp_msg {
+    uint8_t seq;
+    uint8_t type;
+    uint8_t len;
+    const uint8_t *val;     /* into the frame */
+};
+
+struct cmdp_writer {
+    uint8_t *buf;
+    size_t cap;
+    size_t len;
+};
+
+struct cmdp_reader {
+    const uint8_t *buf;
+    size_t len;
+    size_t pos;
+};
+
+/* -ENOSPC if not even the header fits */
+static inline int cmdp_writer_init(struct cmdp_writer *w, uint8_t *buf, size_t cap)
+{
+    w->buf = buf;
+    w->cap = cap;
+    w->len = 0;
+    if (cap < CMDP_HDR_LEN) {
+        return -ENOSPC;
+    }
+    buf[w->len++] = CMDP_VERSION;
+    return 0;
+}
+
+/* Append one message; -ENOSPC (frame unchanged) if it does not fit */
+static inline int cmdp_put(struct cmdp_writer *w, uint8_t seq, uint8_t type,
+                           const void *val, uint8_t len)
+{
+    if (w->cap - w->len < (size_t)CMDP_MSG_HDR_LEN + len) {
+        return -ENOSPC;
+    }
+    w->buf[w->len++] = seq;
+    w->buf[w->len++] = type;
+    w->buf[w->len++] = len;
+    if (len) {
+        memcpy(w->buf + w->len, val, len);
+        w->len += len;
+    }
+    return 0;
+}
+
+/* -EINVAL for a frame too short to hold a message, -ENOTSUP for another
+ * protocol version
+ */
+static inline int cmdp_reader_init(struct cmdp_reader *r, const void *buf, size_t len)
+{
+    r->buf = (const uint8_t *)buf;
+    r->len = len;
+    r->pos = CMDP_HDR_LEN;
+    if (len < CMDP_HDR_LEN + CMDP_MSG_HDR_LEN) {
+        return -EINVAL;
+    }
+    if (r->buf[0] != CMDP_VERSION) {
+        return -ENOTSUP;
+    }
+    return 0;
+}
+
+/* 1 with the next message in *m, 0 at the end of the frame, -EINVAL when
+ * the rest of the frame is truncated (everything before it stays valid)
+ */
+static inline int cmdp_next(struct cmdp_reader *r, struct cmdp_msg *m)
+{
+    size_t left = r->len - r->pos;
+
+    if (left == 0) {
+        return 0;
+    }
+    if (left < CMDP_MSG_HDR_LEN || left - CMDP_MSG_HDR_LEN < r->buf[r->pos + 2]) {
+        r->pos = r->len;
+        return -EINVAL;
+    }
+    m->seq = r->buf[r->pos];
+    m->type = r->buf[r->pos + 1];
+    m->len = r->buf[r->pos + 2];
+    m->val = r->buf + r->pos + CMDP_MSG_HDR_LEN;
+    r->pos += CMDP_MSG_HDR_LEN + m->len;
+    return 1;
+}
+
+/* ===== Receiver (patch) ===== */
+
+/* Rejections reported per ACK; with two the ACK still fits the default
+ * 23-byte MTU. A frame with more is processed up to there and the rest
+ * resent, so every rejection is reported as long as its ACK arrives.
+ */
+#define CMDP_NAK_MAX        2
+
+/* Applies one in-order command; 0 or a negative errno, reported as NAK */
+typedef int (*cmdp_apply_fn)(uint8_t type, const uint8_t *val, uint8_t len, void *ctx);
+
+struct cmdp_rx {
+    uint8_t next;           /* next expected seq */
+    bool gap;               /* to report in the next ACK */
+    bool in_gap;            /* until the missing seq arrives */
+    bool ack_due;
+    uint8_t n_nak;
+    uint8_t nak[CMDP_NAK_MAX][2];   /* seq, errno */
+    uint32_t applied;
+    uint32_t dups;
+    uint32_t gaps;          /* frames cut short by a sequence gap */
+    uint32_t errors;        /* malformed frames / messages */
+};
+
+static inline void cmdp_rx_init(struct cmdp_rx *rx)
+{
+    memset(rx, 0, sizeof(*rx));
+}
+
+static inline void cmdp_rx_nak(struct cmdp_rx *rx, uint8_t seq, int err)
+{
+    if (rx->n_nak < CMDP_NAK_MAX) {
+        rx->nak[rx->n_nak][0] = seq;
+        rx->nak[rx->n_nak][1] = (uint8_t)(err < 0 ? -err : err);
+        rx->n_nak++;
+    }
+}
+
+/* Process one received frame; an ACK is due afterwards (cmdp_rx_ack) */
+static inline void cmdp_rx_frame(struct cmdp_rx *rx, const void *buf, size_t len,
+                                 cmdp_apply_fn apply, void *ctx)
+{
+    struct cmdp_reader r;
+    struct cmdp_msg m;
+    int ret;
+
+    rx->ack_due = true;
+    if (cmdp_reader_init(&r, buf, len) < 0) {
+        rx->errors++;
+        return;
+    }
+    while ((ret = cmdp_next(&r, &m)) > 0) {
+        if (m.seq != rx->next) {
+            if (cmdp_seq_before(m.seq, rx->next)) {
+                rx->dups++;             /* resent, already applied */
+                continue;
+            }
+            /* Lost frame in between: drop the rest, the gateway resends.
+             * Frames already on the way are dropped the same, but only the
+             * first one asks for the resend.
+             */
+            rx->gap |= !rx->in_gap;
+            rx->in_gap = true;
+            rx->gaps++;
+            return;
+        }
+        if (rx->n_nak == CMDP_NAK_MAX) {
+            /* No room to report another rejection: have the rest resent */
+            rx->gap = true;
+            rx->in_gap = true;
+            return;
+        }
+        rx->next++;
+        rx->in_gap = false;
+
+        int tl = cmdp_type_len(m.type);
+
+        if (tl < 0 || m.type >= CMDP_T_ACK) {
+            cmdp_rx_nak(rx, m.seq, -ENOTSUP);
+        } else if (tl != m.len) {
+            rx->errors++;
+            cmdp_rx_nak(rx, m.seq, -EINVAL);
+        } else {
+            int err = apply(m.type, m.val, m.len, ctx);
+
+            rx->applied++;
+            if (err) {
+                cmdp_rx_nak(rx, m.seq, err);
+            }
+        }
+    }
+    if (ret < 0) {
+        rx->errors++;
+    }
+}
+
+/* Build the ACK (and NAKs) for everything processed so far into buf;
+ * returns its length, 0 if none is due
+ */
+static inline size_t cmdp_rx_ack(struct cmdp_rx *rx, uint8_t *buf, size_t cap)
+{
+    struct cmdp_writer w;
+    uint8_t v[2];
+
+    if (!rx->ack_due || cmdp_writer_init(&w, buf, cap) < 0) {
+        return 0;
+    }
+    v[0] = rx->next;
+    v[1] = rx->gap ? CMDP_ACK_F_GAP : 0;
+    if (cmdp_put(&w, 0, CMDP_T_ACK, v, 2) < 0) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < rx->n_nak; i++) {
+        if (cmdp_put(&w, 0, CMDP_T_NAK, rx->nak[i], 2) < 0) {
+            break;
+        }
+    }
+    rx->ack_due = false;
+    rx->gap = false;
+    rx->n_nak = 0;
+    return w.len;
+}
+
+/* ===== Sender (gateway) ===== */
+
+#define CMDP_WINDOW         64      /* unacknowledged commands, < 128 */
+#define CMDP_RTO_MS         400     /* resend when nothing was acked for this long */
+
+struct cmdp_slot {
+    uint8_t type;
+    uint8_t len;
+    uint8_t val[CMDP_VAL_MAX];
+};
+
+struct cmdp_tx {
+    struct cmdp_slot slot[CMDP_WINDOW];
+    uint8_t base;           /* oldest unacknowledged seq */
+    uint8_t send;           /* next seq to put on the air */
+    uint8_t high;           /* next seq never sent yet */
+    uint8_t end;            /* next seq to queue */
+    uint32_t progress_ms;   /* last send from base or ACK progress */
+    uint32_t queued;
+    uint32_t frames;
+    uint32_t resends;       /* go-back-N rewinds */
+    uint32_t naks;
+    uint8_t last_nak_seq;
+    uint8_t last_nak_err;
+};
+
+static inline void cmdp_tx_init(struct cmdp_tx *tx)
+{
+    memset(tx, 0, sizeof(*tx));
+}
+
+static inline uint8_t cmdp_tx_pending(const struct cmdp_tx *tx)
+{
+    return (uint8_t)(tx->end - tx->base);
+}
+
+/* Queue one command and return its seq (>= 0); -ENOSPC when the window is
+ * full, -EINVAL for a value that does not match the type
+ */
+static inline int cmdp_tx_queue(struct cmdp_tx *tx, uint8_t type, const void *val, uint8_t len)
+{
+    if (cmdp_type_len(type) != (int)len || type >= CMDP_T_ACK) {
+        return -EINVAL;
+    }
+    if (cmdp_tx_pending(tx) >= CMDP_WINDOW) {
+        return -ENOSPC;
+    }
+
+    struct cmdp_slot *s = &tx->slot[tx->end % CMDP_WINDOW];
+
+    s->type = type;
+    s->len = len;
+    if (len) {
+        memcpy(s->val, val, len);
+    }
+    tx->queued++;
+    return tx->end++;
+}
+
+/* Pack the next frame from the unsent commands into buf (cap = ATT payload,
+ * MTU - 3). Returns its length, or 0 with nothing to send. *n receives the
+ * number of commands in it; pass that to cmdp_tx_sent() once the write was
+ * accepted, or drop it to try again later.
+ */
+static inline size_t cmdp_tx_frame(struct cmdp_tx *tx, uint32_t now_ms, uint8_t *buf,
+                                   size_t cap, uint8_t *n)
+{
+    struct cmdp_writer w;
+
+    *n = 0;
+    /* Nothing acknowledged for a while: the last frames or their ACK were
+     * lost, go back to the oldest
+     */
+    if (tx->send != tx->base && (uint32_t)(now_ms - tx->progress_ms) >= CMDP_RTO_MS) {
+        tx->send = tx->base;
+        tx->resends++;
+    }
+    if (tx->send == tx->end || cmdp_writer_init(&w, buf, cap) < 0) {
+        return 0;
+    }
+    for (uint8_t seq = tx->send; seq != tx->end; seq++) {
+        const struct cmdp_slot *s = &tx->slot[seq % CMDP_WINDOW];
+
+        if (cmdp_put(&w, seq, s->type, s->val, s->len) < 0) {
+            break;
+        }
+        (*n)++;
+    }
+    return *n ? w.len : 0;
+}
+
+static inline void cmdp_tx_sent(struct cmdp_tx *tx, uint8_t n, uint32_t now_ms)
+{
+    if (n == 0) {
+        return;
+    }
+    if (tx->send == tx->base) {
+        tx->progress_ms = now_ms;   /* RTO runs from the oldest one sent */
+    }
+    tx->send = (uint8_t)(tx->send + n);
+    if (cmdp_seq_before(tx->high, tx->send)) {
+        tx->high = tx->send;
+    }
+    tx->frames++;
+}
+
+/* Process an ACK/NAK frame from the patch. -EINVAL for a malformed frame or
+ * an ACK outside the window (ignored).
+ */
+static inline int cmdp_tx_ack(struct cmdp_tx *tx, const void *buf, size_t len, uint32_t now_ms)
+{
+    struct cmdp_reader r;
+    struct cmdp_msg m;
+    int ret = cmdp_reader_init(&r, buf, len);
+
+    if (ret < 0) {
+        return ret;
+    }
+    while ((ret = cmdp_next(&r, &m)) > 0) {
+        if (m.len != 2) {
+            return -EINVAL;
+        }
+        if (m.type == CMDP_T_NAK) {
+            tx->naks++;
+            tx->last_nak_seq = m.val[0];
+            tx->last_nak_err = m.val[1];
+            continue;
+        }
+        if (m.type != CMDP_T_ACK) {
+            continue;
+        }
+
+        uint8_t next = m.val[0];
+
+        /* Only base..high can be acknowledged; after a rewind that may be
+         * past send
+         */
+        if (cmdp_seq_before(next, tx->base) || cmdp_seq_before(tx->high, next)) {
+            return -EINVAL;
+        }
+        if (next != tx->base) {
+            tx->base = next;
+            tx->progress_ms = now_ms;
+        }
+        if (cmdp_seq_before(tx->send, tx->base)) {
+            tx->send = tx->base;
+        }
+        if ((m.val[1] & CMDP_ACK_F_GAP) && tx->send != tx->base) {
+            tx->send = tx->base;
+            tx->resends++;
+        }
+    }
+    return ret;
+}
+
+#endif /* CMD_PROTO_H_ */
@@ -0,0 +1,342 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef JOURNAL_WIRE_H_
+#define JOURNAL_WIRE_H_
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__cplusplus) && !defined(_Static_assert)
+#define _Static_assert static_assert
+#endif
+
+/* ===== Event journal: entries, records and the sync transfer =====
+ *
+ * Header-only C, no platform headers: the patch writes the journal
+ * (Firmware_Code/src/journal.c), the gateway receives it (ble_led,
+ * lib/session_log/journal_sync.cpp) and the host tools check both ends.
+ *
+ * The patch keeps what happened while nobody was listening in a flash
+ * circular buffer; one FCB element is one entry:
+ *
+ *   entry    struct jrnl_entry_hdr, then records back to back
+ *   record   u8 type, varint ms since the previous record of the entry
+ *            (the first: since t0_ms), then by type
+ *     JRNL_POSTURE   u8 enum posture_event, zigzag varint dev_cdeg
+ *     JRNL_DWELL     varint ms spent slouched, at RECOVERED
+ *     JRNL_ACTUATOR  u8 JRNL_ACT_*, varint value (0: off; LED 1, LRA the
+ *                    haptic pattern + 1, Peltier the duty in
+ *                    permille when it came on)
+ *     JRNL_THERMAL   u8 JRNL_TF_* now set, zigzag varint temp_cdeg
+ *     JRNL_CLOCK     varint ms since the Unix epoch, as the gateway said
+ *     JRNL_SYNCED    varint seq: the entries before it reached the gateway
+ *     JRNL_TRIP      u8 enum therm_trip (Firmware_Code/src/therm_guard.h)
+ *                    the thermal supervisor cut the Peltiers for, 0 when
+ *                    it re-armed them; zigzag varint temp_cdeg
+ *
+ * Entries are numbered by seq, one up per entry and never reused; boot
+ * counts restarts, and t0_ms / the record times are ms since that boot.
+ * JRNL_CLOCK ties a boot to wall time; a boot without one (the patch never
+ * connected) has no wall time.
+ *
+ * Sync, on the journal characteristic (ble_wire.h):
+ *
+ *   write   struct jrnl_req
+ *           JRNL_OP_SYNC  send the entries from seq, the first from byte
+ *                         off; seq JRNL_SEQ_UNSYNCED starts after the last
+ *                         JRNL_SYNCED mark. epoch_ms is the gateway's
+ *                         clock, journalled as JRNL_CLOCK
+ *           JRNL_OP_ACK   the entries before seq arrived: a JRNL_SYNCED
+ *                         mark, so that the next SYNC starts after them
+ *   notify  struct jrnl_chunk, then up to MTU - 3 - 8 bytes
+ *           len JRNL_LEN_ANCHORS  first: n struct jrnl_anchor, the wall
+ *                                 time of every boot in the transfer
+ *                                 that has one
+ *           len 1..               the piece of entry seq at byte off; an
+ *                                 entry of len bytes ends when off + piece
+ *                                 reaches len
+ *           len JRNL_LEN_END      last: seq is the next entry to be written
+ *
+ * A transfer cut short resumes with SYNC from the first missing byte; one
+ * whose entries were rotated out of flash meanwhile restarts at the oldest
+ * entry left, and the gateway sees the gap in seq.
+ */
+
+#define JRNL_VERSION        1
+
+/* Record types */
+#define JRNL_POSTURE        0x01
+#define JRNL_DWELL          0x02
+#define JRNL_ACTUATOR       0x03
+#define JRNL_THERMAL        0x04
+#define JRNL_CLOCK          0x05
+#define JRNL_SYNCED         0x06
+#define JRNL_TRIP           0x07
+
+#define JRNL_ACT_LED        0
+#define JRNL_ACT_LRA        1
+#define JRNL_ACT_PELTIER    2
+
+#define JRNL_TF_OVER_TEMP   0x01    /* above the hard cut-off */
+#define JRNL_TF_NO_SENSOR   0x02    /* no plausible thermistor reading */
+#define JRNL_TF_FOLDBACK    0x04    /* duty limited by the current fold-back */
+
+/* Longest encoded record: type, dt, u64 varint */
+#define JRNL_REC_MAX        (1 + 5 + 10)
+
+struct jrnl_entry_hdr {
+    uint8_t version;        /* JRNL_VERSION */
+    uint8_t _pad;
+    uint16_t boot;
+    uint32_t seq;
+    uint32_t t0_ms;         /* since boot */
+} __attribute__((packed));
+
+_Static_assert(sizeof(struct jrnl_entry_hdr) == 12, "journal entry header size changed");
+
+/* One decoded record */
+struct jrnl_rec {
+    uint8_t type;
+    uint32_t t_ms;          /* since boot */
+    int64_t a;              /* event, ms, actuator, faults, epoch ms, seq */
+    int32_t b;              /* dev_cdeg, value, temp_cdeg */
+};
+
+/* ===== Sync transfer ===== */
+
+#define JRNL_OP_SYNC        0x01
+#define JRNL_OP_ACK         0x02
+
+#define JRNL_SEQ_UNSYNCED   0xFFFFFFFFu
+
+#define JRNL_LEN_END        0
+#define JRNL_LEN_ANCHORS    0xFFFF
+
+struct jrnl_req {
+    uint8_t op;             /* JRNL_OP_* */
+    uint32_t seq;
+    uint16_t off;           /* SYNC: into the first entry */
+    uint64_t epoch_ms;      /* SYNC: gateway clock, 0 if unknown */
+} __attribute__((packed));
+
+_Static_assert(sizeof(struct jrnl_req) == 15, "journal request size changed");
+
+struct jrnl_chunk {
+    uint32_t seq;
+    uint16_t off;
+    uint16_t len;           /* of the whole entry, or JRNL_LEN_* */
+} __attribute__((packed));
+
+_Static_assert(sizeof(struct jrnl_chunk) == 8, "journal chunk header size changed");
+
+/* Wall time of a boot: epoch ms = ms since boot + offset_ms */
+struct jrnl_anchor {
+    uint16_t boot;
+    int64_t offset_ms;
+} __attribute__((packed));
+
+_Static_assert(sizeof(struct jrnl_anchor) == 10, "journal anchor size changed");
+
+/* ===== Varints ===== */
+
+static inline size_t jrnl_put_varint(uint8_t *p, uint64_t v)
+{
+    size_t n = 0;
+
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+/* -EBADMSG if the varint runs past len or over 64 bits */
+static inline int jrnl_get_varint(const uint8_t *p, size_t len, size_t *pos, uint64_t *v)
+{
+    uint64_t r = 0;
+
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (*pos >= len) {
+            return -EBADMSG;
+        }
+        uint8_t c = p[(*pos)++];
+
+        r |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            *v = r;
+            return 0;
+        }
+    }
+    return -EBADMSG;
+}
+
+static inline uint32_t jrnl_zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t jrnl_unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/* ===== Records ===== */
+
+/* Encodes r after a record at prev_ms (or the entry's t0_ms) into out,
+ * JRNL_REC_MAX bytes at most; returns the length
+ */
+static inline size_t jrnl_rec_encode(uint8_t *out, const struct jrnl_rec *r, uint32_t prev_ms)
+{
+    size_t n = 0;
+
+    out[n++] = r->type;
+    n += jrnl_put_varint(out + n, r->t_ms - prev_ms);
+    switch (r->type) {
+    case JRNL_POSTURE:
+    case JRNL_ACTUATOR:
+    case JRNL_THERMAL:
+    case JRNL_TRIP:
+        out[n++] = (uint8_t)r->a;
+        n += jrnl_put_varint(out + n, r->type == JRNL_ACTUATOR ? (uint32_t)r->b
+                                                               : jrnl_zigzag(r->b));
+        break;
+    case JRNL_DWELL:
+    case JRNL_CLOCK:
+    case JRNL_SYNCED:
+        n += jrnl_put_varint(out + n, (uint64_t)r->a);
+        break;
+    default:
+        break;
+    }
+    return n;
+}
+
+/* Decodes the record at *pos of an entry body; *t_ms runs from the entry's
+ * t0_ms. 1 with a record, 0 at the end, -EBADMSG if malformed.
+ */
+static inline int jrnl_rec_decode(const uint8_t *p, size_t len, size_t *pos, uint32_t *t_ms,
+                                  struct jrnl_rec *r)
+{
+    uint64_t v;
+
+    if (*pos >= len) {
+        return 0;
+    }
+    r->type = p[(*pos)++];
+    r->a = 0;
+    r->b = 0;
+    if (jrnl_get_varint(p, len, pos, &v) || v > UINT32_MAX) {
+        return -EBADMSG;
+    }
+    *t_ms += (uint32_t)v;
+    r->t_ms = *t_ms;
+
+    switch (r->type) {
+    case JRNL_POSTURE:
+    case JRNL_ACTUATOR:
+    case JRNL_THERMAL:
+    case JRNL_TRIP:
+        if (*pos >= len) {
+            return -EBADMSG;
+        }
+        r->a = p[(*pos)++];
+        if (jrnl_get_varint(p, len, pos, &v) || v > UINT32_MAX) {
+            return -EBADMSG;
+        }
+        r->b = r->type == JRNL_ACTUATOR ? (int32_t)(uint32_t)v : jrnl_unzigzag((uint32_t)v);
+        return 1;
+    case JRNL_DWELL:
+    case JRNL_CLOCK:
+    case JRNL_SYNCED:
+        if (jrnl_get_varint(p, len, pos, &v)) {
+            return -EBADMSG;
+        }
+        r->a = (int64_t)v;
+        return 1;
+    default:
+        return -EBADMSG;
+    }
+}
+
+static inline const char *jrnl_type_name(uint8_t type)
+{
+    switch (type) {
+    case JRNL_POSTURE:
+        return "posture";
+    case JRNL_DWELL:
+        return "dwell";
+    case JRNL_ACTUATOR:
+        return "actuator";
+    case JRNL_THERMAL:
+        return "thermal";
+    case JRNL_CLOCK:
+        return "clock";
+    case JRNL_SYNCED:
+        return "synced";
+    case JRNL_TRIP:
+        return "trip";
+    default:
+        return "?";
+    }
+}
+
+/* ===== Recovery =====
+ * Where the journal goes on after a restart, from the entries that
+ * survived it in flash order: the next seq, the boot number and the last
+ * JRNL_SYNCED mark.
+ */
+struct jrnl_state {
+    uint32_t next_seq;
+    uint16_t boot;          /* of the newest entry */
+    uint32_t synced;        /* first entry not acknowledged */
+    uint32_t entries;
+    uint32_t bad;           /* entries that do not decode */
+};
+
+static inline void jrnl_state_init(struct jrnl_state *s)
+{
+    memset(s, 0, sizeof(*s));
+}
+
+/* -EBADMSG for an entry that does not decode; the state keeps its seq */
+static inline int jrnl_scan_entry(struct jrnl_state *s, const uint8_t *e, size_t len)
+{
+    struct jrnl_entry_hdr h;
+    struct jrnl_rec r;
+    size_t pos = sizeof(h);
+    uint32_t t;
+    int rc;
+
+    if (len < sizeof(h)) {
+        s->bad++;
+        return -EBADMSG;
+    }
+    memcpy(&h, e, sizeof(h));
+    if (h.version != JRNL_VERSION) {
+        s->bad++;
+        return -EBADMSG;
+    }
+    s->entries++;
+    if (s->entries == 1 || h.seq >= s->next_seq) {
+        s->next_seq = h.seq + 1;
+        s->boot = h.boot;
+    }
+    t = h.t0_ms;
+    while ((rc = jrnl_rec_decode(e, len, &pos, &t, &r)) > 0) {
+        if (r.type == JRNL_SYNCED && (uint32_t)r.a > s->synced) {
+            s->synced = (uint32_t)r.a;
+        }
+    }
+    if (rc < 0) {
+        s->bad++;
+    }
+    return rc;
+}
+
+#endif /* JOURNAL_WIRE_H_ */
@@ -0,0 +1,78 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TELEM_WIRE_H_
+#define TELEM_WIRE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus) && !defined(_Static_assert)
+#define _Static_assert static_assert
+#endif
+
+/* ===== Binary telemetry record =====
+ *
+ * Fixed-size, little-endian, no formatting on the device. Shared with the
+ * host decoder in tools/telem_decode and the ESP32 gateway (C++), so keep
+ * it free of Zephyr headers.
+ * A stream is a plain concatenation of records; the decoder resynchronises
+ * on TELEM_SYNC + a valid CRC.
+ *
+ * 30 bytes per record, against ~140 bytes for the old text line (measured
+ * with tools/telem_decode --stats).
+ */
+#define TELEM_SYNC          0xA5
+#define TELEM_VERSION       1
+
+#define TELEM_F_LED         0x01
+#define TELEM_F_PELTIER     0x02
+#define TELEM_F_LRA         0x04
+
+#define TELEM_NO_TEMP       INT16_MIN
+
+struct telem_wire {
+    uint8_t sync;
+    uint8_t version;
+    uint16_t seq;           /* increments per record, gaps = dropped records */
+    uint32_t t_us;          /* newest IMU sample of the batch */
+    int16_t acc[3];         /* raw counts, 16384 LSB/g */
+    int16_t gyr[3];         /* raw counts, 65.536 LSB/dps */
+    int16_t pitch_cdeg;
+    int16_t roll_cdeg;
+    int16_t therm_mv;       /* -1 when the ADC read failed */
+    int16_t temp_cdeg;      /* TELEM_NO_TEMP when unknown */
+    uint8_t flags;          /* TELEM_F_* actuator state */
+    uint8_t crc;            /* CRC-8 (0x07) over all preceding bytes */
+} __attribute__((packed));
+
+_Static_assert(sizeof(struct telem_wire) == 30, "telemetry wire record size changed");
+
+static inline uint8_t telem_crc8(const uint8_t *p, size_t len)
+{
+    uint8_t crc = 0;
+
+    while (len--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static inline void telem_wire_seal(struct telem_wire *w)
+{
+    w->sync = TELEM_SYNC;
+    w->version = TELEM_VERSION;
+    w->crc = telem_crc8((const uint8_t *)w, sizeof(*w) - 1);
+}
+
+static inline int telem_wire_valid(const struct telem_wire *w)
+{
+    return w->sync == TELEM_SYNC && w->version == TELEM_VERSION &&
+           w->crc == telem_crc8((const uint8_t *)w, sizeof(*w) - 1);
+}
+
+#endif /* TELEM_WIRE_H_ */